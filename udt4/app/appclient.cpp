@@ -51,6 +51,7 @@ int main(int argc, char* argv[])
 
    // UDT Options
    //UDT::setsockopt(client, 0, UDT_CC, new CCCFactory<CUDPBlast>, sizeof(CCCFactory<CUDPBlast>));
+   //UDT::setsockopt(client, 0, UDT_CC, new CCCFactory<CVRFrameCC>, sizeof(CCCFactory<CVRFrameCC>));
    //UDT::setsockopt(client, 0, UDT_MSS, new int(9000), sizeof(int));
    //UDT::setsockopt(client, 0, UDT_SNDBUF, new int(10000000), sizeof(int));
    //UDT::setsockopt(client, 0, UDP_SNDBUF, new int(10000000), sizeof(int));
@@ -96,15 +97,16 @@ int main(int argc, char* argv[])
    //if (NULL != cchandle)
    //   cchandle->setRate(500);
 
-   // VR Frame Awareness Test: Send 100 frames × 100 chunks
+   // VR Frame Awareness Test: Send 10 frames × 100 chunks, one sendframe() call per frame
    const int TOTAL_FRAMES = 10;
    const int CHUNKS_PER_FRAME = 100;
    const int CHUNK_SIZE = 1400;
-   char* data = new char[CHUNK_SIZE];
+   const int FRAME_SIZE = CHUNKS_PER_FRAME * CHUNK_SIZE;
+   char* data = new char[FRAME_SIZE];
 
    // Fill data with pattern for testing
-   for (int i = 0; i < CHUNK_SIZE; i++)
-      data[i] = i % 256;
+   for (int i = 0; i < FRAME_SIZE; i++)
+      data[i] = (i % CHUNK_SIZE) % 256;
 
    #ifndef WIN32
       pthread_create(new pthread_t, NULL, monitor, &client);
@@ -120,30 +122,11 @@ int main(int argc, char* argv[])
       // Calculate frame deadline (example: 16ms per frame = 16000 us)
       int64_t deadline = (frame + 1) * 16000;
 
-      for (int chunk = 0; chunk < CHUNKS_PER_FRAME; chunk++)
+      // The library splits the frame into chunks and stamps chunk_id/total_chunks itself
+      if (UDT::ERROR == UDT::sendframe(client, data, FRAME_SIZE, frame, deadline))
       {
-         // Set frame metadata before sending each chunk
-         if (UDT::ERROR == UDT::set_next_frame_metadata(client, frame, chunk, CHUNKS_PER_FRAME, deadline))
-         {
-            cout << "set_next_frame_metadata: " << UDT::getlasterror().getErrorMessage() << endl;
-            break;
-         }
-
-         // Send the chunk
-         int ssize = 0;
-         int ss;
-         while (ssize < CHUNK_SIZE)
-         {
-            if (UDT::ERROR == (ss = UDT::send(client, data + ssize, CHUNK_SIZE - ssize, 0)))
-            {
-               cout << "send:" << UDT::getlasterror().getErrorMessage() << endl;
-               break;
-            }
-            ssize += ss;
-         }
-
-         if (ssize < CHUNK_SIZE)
-            break;
+         cout << "sendframe: " << UDT::getlasterror().getErrorMessage() << endl;
+         break;
       }
 
       // Print progress every 10 frames
@@ -168,7 +151,7 @@ DWORD WINAPI monitor(LPVOID s)
 
    UDT::TRACEINFO perf;
 
-   cout << "SendRate(Mb/s)\tRTT(ms)\tCWnd\tPktSndPeriod(us)\tRecvACK\tRecvNAK" << endl;
+   cout << "SendRate(Mb/s)\tRTT(ms)\tCWnd\tPktSndPeriod(us)\tRecvACK\tRecvNAK\tFrameAcked\tFrameMiss\tFrameP99(us)" << endl;
 
    while (true)
    {
@@ -189,7 +172,10 @@ DWORD WINAPI monitor(LPVOID s)
            << perf.pktCongestionWindow << "\t" 
            << perf.usPktSndPeriod << "\t\t\t" 
            << perf.pktRecvACK << "\t" 
-           << perf.pktRecvNAK << endl;
+           << perf.pktRecvNAK << "\t"
+           << perf.frameSndAcked << "\t\t"
+           << perf.frameSndMiss << "\t\t"
+           << perf.usFrameSndLatency99 << endl;
    }
 
    #ifndef WIN32
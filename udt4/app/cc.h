@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <udt.h>
 #include <ccc.h>
 
@@ -98,3 +99,210 @@ public:
       m_dPktSndPeriod = (m_iMSS * 8.0) / mbps;
    }
 };
+
+
+// VR Frame Awareness: rate based control for frame streams. The congestion rate backs off when the
+// RTT grows above its minimum by more than a target queueing delay, and only mildly on loss seen
+// without queueing. When a frame cannot finish within its deadline budget at that rate while the
+// path shows no queueing, the frame is sent at the rate it needs instead.
+class CVRFrameCC: public CCC
+{
+public:
+   CVRFrameCC():
+   m_iTargetDelay(5000),
+   m_dBudgetShare(0.8)
+   {
+   }
+
+public:
+   void init()
+   {
+      setACKTimer(m_iSYNInterval);
+
+      m_bSlowStart = true;
+      m_iLastAck = m_iSndCurrSeqNo;
+      m_iLastDecSeq = m_iSndCurrSeqNo;
+
+      m_iMinRTT = m_iWindowMinRTT = m_iRTT;
+      m_iWindowACKs = 0;
+      m_iQueuing = 0;
+
+      m_iFrameID = -1;
+      m_dFramePeriod = 0.0;
+      m_bFrameLate = false;
+
+      m_dCongPeriod = 1.0;
+      m_dCWndSize = 16.0;
+      m_dPktSndPeriod = 1.0;
+   }
+
+   virtual void onACK(int32_t ack)
+   {
+      // the base RTT is the minimum of the current and the previous window of 1000 ACKs (10s)
+      if (m_iRTT < m_iWindowMinRTT)
+         m_iWindowMinRTT = m_iRTT;
+      if (m_iWindowMinRTT < m_iMinRTT)
+         m_iMinRTT = m_iWindowMinRTT;
+      if (++ m_iWindowACKs >= 1000)
+      {
+         m_iMinRTT = m_iWindowMinRTT;
+         m_iWindowMinRTT = m_iRTT;
+         m_iWindowACKs = 0;
+      }
+
+      int queuing = m_iQueuing = m_iRTT - m_iMinRTT;
+
+      if (m_bSlowStart)
+      {
+         m_dCWndSize += seqlen(m_iLastAck, ack);
+         m_iLastAck = ack;
+
+         if ((m_dCWndSize <= m_dMaxCWndSize) && (queuing <= m_iTargetDelay))
+            return;
+
+         m_bSlowStart = false;
+         if (m_iRcvRate > 0)
+            m_dCongPeriod = 1000000.0 / m_iRcvRate;
+         else
+            m_dCongPeriod = (m_iRTT + m_iSYNInterval) / m_dCWndSize;
+         m_iLastDecSeq = m_iSndCurrSeqNo;
+      }
+      else if (queuing > m_iTargetDelay)
+      {
+         // the queue is growing: back off at most once per RTT
+         if (seqcmp(ack, m_iLastDecSeq) > 0)
+         {
+            m_dCongPeriod /= 0.875;
+            m_iLastDecSeq = m_iSndCurrSeqNo;
+         }
+      }
+      else
+      {
+         // probe in proportion to the unused delay budget, faster while frames miss their deadlines
+         double gain = 0.05 * (m_iTargetDelay - queuing) / m_iTargetDelay;
+         if (m_bFrameLate && (queuing < m_iTargetDelay / 2))
+            gain *= 2;
+
+         m_dCongPeriod /= 1.0 + gain;
+         if (m_dCongPeriod < 1.0)
+            m_dCongPeriod = 1.0;
+      }
+
+      m_dCWndSize = (m_iRTT + m_iSYNInterval) / m_dCongPeriod + 16;
+      updatePeriod();
+   }
+
+   virtual void onLoss(const int32_t* losslist, int)
+   {
+      if (m_bSlowStart)
+      {
+         m_bSlowStart = false;
+         if (m_iRcvRate > 0)
+            m_dCongPeriod = 1000000.0 / m_iRcvRate;
+         else
+            m_dCongPeriod = (m_iRTT + m_iSYNInterval) / m_dCWndSize;
+         m_iLastDecSeq = m_iSndCurrSeqNo;
+         updatePeriod();
+         return;
+      }
+
+      if (seqcmp(losslist[0] & 0x7FFFFFFF, m_iLastDecSeq) <= 0)
+         return;
+
+      // loss without queueing is more likely random than congestion
+      if (m_iRTT - m_iMinRTT > m_iTargetDelay / 2)
+         m_dCongPeriod *= 1.125;
+      else
+         m_dCongPeriod *= 1.03;
+
+      m_iLastDecSeq = m_iSndCurrSeqNo;
+      updatePeriod();
+   }
+
+   virtual void onTimeout()
+   {
+      m_bSlowStart = false;
+      m_dCongPeriod *= 2;
+      m_iLastDecSeq = m_iSndCurrSeqNo;
+      updatePeriod();
+   }
+
+   virtual void onPktSent(const CPacket* pkt)
+   {
+      int64_t deadline = pkt->getFrameDeadline();
+      int remaining = pkt->getTotalChunks() - pkt->getChunkID() - 1;
+
+      if ((0 == deadline) || (remaining <= 0))
+      {
+         m_dFramePeriod = 0.0;
+         updatePeriod();
+         return;
+      }
+
+      // time left until the frame must be at the receiver
+      double budget = (double(deadline - uint32_t(pkt->m_iTimeStamp)) - m_iRTT / 2) * m_dBudgetShare;
+      double needed = budget / remaining;
+
+      if (pkt->getFrameID() != m_iFrameID)
+      {
+         m_iFrameID = pkt->getFrameID();
+         m_bFrameLate = (needed < m_dCongPeriod);
+      }
+
+      // a frame that is late anyway, or a congested path, gets no boost
+      if ((needed <= 0) || (needed >= m_dCongPeriod) || (m_iQueuing > m_iTargetDelay / 2))
+         m_dFramePeriod = 0.0;
+      else if ((m_iBandwidth > 0) && (needed < 1000000.0 / m_iBandwidth))
+         m_dFramePeriod = 1000000.0 / m_iBandwidth;
+      else
+         m_dFramePeriod = needed;
+
+      updatePeriod();
+   }
+
+public:
+   void setTargetDelay(int us)
+   {
+      m_iTargetDelay = us;
+   }
+
+   void setBudgetShare(double share)
+   {
+      m_dBudgetShare = share;
+   }
+
+protected:
+   void updatePeriod()
+   {
+      m_dPktSndPeriod = ((m_dFramePeriod > 0) && (m_dFramePeriod < m_dCongPeriod)) ? m_dFramePeriod : m_dCongPeriod;
+   }
+
+   static int seqcmp(int32_t seq1, int32_t seq2)
+   {
+      return (abs(seq1 - seq2) < 0x3FFFFFFF) ? (seq1 - seq2) : (seq2 - seq1);
+   }
+
+   static int seqlen(int32_t seq1, int32_t seq2)
+   {
+      return (seq1 <= seq2) ? (seq2 - seq1 + 1) : (seq2 - seq1 + 0x7FFFFFFF + 2);
+   }
+
+protected:
+   int m_iTargetDelay;                  // queueing delay tolerated above the base RTT, microseconds
+   double m_dBudgetShare;               // share of the time left to a deadline a frame should finish in
+
+   bool m_bSlowStart;
+   int32_t m_iLastAck;
+   int32_t m_iLastDecSeq;               // max seq. no. sent at the last decrease
+
+   int m_iMinRTT;                       // base RTT
+   int m_iWindowMinRTT;                 // minimum RTT in the current window
+   int m_iWindowACKs;                   // ACKs in the current window
+   int m_iQueuing;                      // RTT above the base RTT at the last ACK
+
+   int32_t m_iFrameID;                  // frame being sent
+   double m_dFramePeriod;               // period that finishes it in time, 0 if no boost
+   bool m_bFrameLate;                   // if it cannot finish in time at the congestion rate
+
+   double m_dCongPeriod;                // congestion limited period, microseconds
+};
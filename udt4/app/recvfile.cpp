@@ -79,12 +79,11 @@ int main(int argc, char* argv[])
       return -1;
    }
 
-   // receive the file
-   fstream ofs(argv[4], ios::out | ios::binary | ios::trunc);
+   // receive the file, recvfile2 writes it straight from the receiver buffer
    int64_t recvsize; 
    int64_t offset = 0;
 
-   if (UDT::ERROR == (recvsize = UDT::recvfile(fhandle, ofs, offset, size)))
+   if (UDT::ERROR == (recvsize = UDT::recvfile2(fhandle, argv[4], &offset, size)))
    {
       cout << "recvfile: " << UDT::getlasterror().getErrorMessage() << endl;
       return -1;
@@ -92,8 +91,6 @@ int main(int argc, char* argv[])
 
    UDT::close(fhandle);
 
-   ofs.close();
-
    // use this function to release the UDT library
    UDT::cleanup();
 
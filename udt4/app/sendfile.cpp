@@ -135,7 +135,7 @@ DWORD WINAPI sendfile(LPVOID usocket)
 
    ifs.seekg(0, ios::end);
    int64_t size = ifs.tellg();
-   ifs.seekg(0, ios::beg);
+   ifs.close();
 
    // send file size information
    if (UDT::ERROR == UDT::send(fhandle, (char*)&size, sizeof(int64_t), 0))
@@ -147,9 +147,9 @@ DWORD WINAPI sendfile(LPVOID usocket)
    UDT::TRACEINFO trace;
    UDT::perfmon(fhandle, &trace);
 
-   // send the file
+   // send the file, sendfile2 maps it instead of reading it through the stream
    int64_t offset = 0;
-   if (UDT::ERROR == UDT::sendfile(fhandle, ifs, offset, size))
+   if (UDT::ERROR == UDT::sendfile2(fhandle, file, &offset, size))
    {
       cout << "sendfile: " << UDT::getlasterror().getErrorMessage() << endl;
       return 0;
@@ -160,8 +160,6 @@ DWORD WINAPI sendfile(LPVOID usocket)
 
    UDT::close(fhandle);
 
-   ifs.close();
-
    #ifndef WIN32
       return NULL;
    #else
@@ -22,6 +22,9 @@ const int g_Socket_Type = SOCK_STREAM;
 const char g_Localhost[] = "127.0.0.1";
 const int g_Server_Port = 9000;
 
+// set by a test that finds a wrong result, the program then exits with 1
+bool g_Failed = false;
+
 
 int createUDTSocket(UDTSOCKET& usock, int port = 0, bool rendezvous = false)
 {
@@ -203,13 +206,26 @@ DWORD WINAPI Test_1_Srv(LPVOID param)
    }
    */
 
+   // the event array reports the socket once the client has closed it, which it does right after sending
+   UDT_EPOLL_EVENT events[4];
+   if ((UDT::epoll_wait2(eid, events, 4, 5000) != 1) || (events[0].fd != new_sock))
+   {
+      cout << "epoll_wait2: wrong event" << endl;
+      g_Failed = true;
+   }
+
    UDTSOCKET readfds[1];
    int num = 1;
-   if (UDT::epoll_wait2(eid, readfds, &num, NULL, NULL, -1) > 0)
+   if ((UDT::epoll_wait2(eid, readfds, &num, NULL, NULL, 5000) != 1) || (readfds[0] != new_sock))
    {
-      UDT::close(new_sock);
+      cout << "epoll_wait2: wrong socket" << endl;
+      g_Failed = true;
    }
 
+   UDT::close(new_sock);
+
+   UDT::epoll_release(eid);
+
    return NULL;
 }
 
@@ -276,6 +292,13 @@ DWORD WINAPI Test_2_Srv(LPVOID param)
 
    UDT::listen(serv, 1024);
 
+   // the TCP clients connect as soon as the UDT ones are accepted, the TCP socket listens before that
+   SYSSOCKET tcp_serv;
+   if (createTCPSocket(tcp_serv, g_Server_Port) < 0)
+      return NULL;
+
+   listen(tcp_serv, 1024);
+
    vector<UDTSOCKET> new_socks;
    new_socks.resize(g_UDTNum);
 
@@ -297,12 +320,6 @@ DWORD WINAPI Test_2_Srv(LPVOID param)
 
 
    // create TCP sockets
-   SYSSOCKET tcp_serv;
-   if (createTCPSocket(tcp_serv, g_Server_Port) < 0)
-      return NULL;
-
-   listen(tcp_serv, 1024);
-
    vector<SYSSOCKET> tcp_socks;
    tcp_socks.resize(g_TCPNum);
 
@@ -734,5 +751,5 @@ int main()
       cout << "Test # " << i + 1 << " completed." << endl;
    }
 
-   return 0;
+   return g_Failed ? 1 : 0;
 }
@@ -0,0 +1,401 @@
+/*
+ * End-to-end benchmark of UDT over the loopback interface.
+ * A sender and a receiver run in this process; with loss, delay or jitter the packets go through a
+ * relay process that impairs them the way netem would (random loss, fixed delay plus uniform jitter,
+ * in both directions), so that no root privilege or tc setup is needed.
+ * It reports the throughput, the CPU time of both ends per Gbit received, and, in frame mode,
+ * the latency percentiles of the frames from sendframe to recvframe.
+ *
+ * usage: bench_e2e [-t seconds] [-s frame_bytes] [-f fps] [-l loss_%] [-d delay_ms] [-j jitter_ms]
+ *                  [-D deadline_ms] [-S] [-p port]
+ *    -f 0 sends frames back to back; -S sends a byte stream instead of frames (no latency figures).
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <udt.h>
+
+using namespace std;
+
+struct Config {
+    int seconds;
+    int frame_size;
+    int fps;
+    double loss;
+    int delay_ms;
+    int jitter_ms;
+    int deadline_ms;
+    bool stream;
+    int port;
+};
+
+static Config g_cfg = {5, 100000, 0, 0.0, 0, 0, 0, false, 9500};
+
+static volatile bool g_sending = true;
+
+// what the receiver measured
+static int64_t g_rcv_bytes = 0;
+static uint64_t g_last_rcv_us = 0;
+static long g_rcv_frames = 0;
+static long g_dropped_frames = 0;
+static vector<int64_t> g_latency;
+
+struct FrameHeader {
+    uint64_t send_us;
+    uint32_t seq;
+};
+
+static uint64_t now_us() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static double cpu_seconds() {
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+static sockaddr_in loopback(int port) {
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// the impairment relay: client <-> front socket (port + 1) ... back socket <-> server (port)
+
+struct Delayed {
+    uint64_t due;
+    uint64_t order;
+    int dir;
+    int len;
+    char* data;
+
+    bool operator>(const Delayed& other) const {
+        return (due != other.due) ? (due > other.due) : (order > other.order);
+    }
+};
+
+static void run_relay() {
+    int front = socket(AF_INET, SOCK_DGRAM, 0);
+    int back = socket(AF_INET, SOCK_DGRAM, 0);
+    int bufsize = 8 << 20;
+    setsockopt(front, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(int));
+    setsockopt(back, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(int));
+    setsockopt(front, SOL_SOCKET, SO_SNDBUF, &bufsize, sizeof(int));
+    setsockopt(back, SOL_SOCKET, SO_SNDBUF, &bufsize, sizeof(int));
+
+    sockaddr_in front_addr = loopback(g_cfg.port + 1);
+    sockaddr_in back_addr = loopback(0);
+    if ((0 != bind(front, (sockaddr*)&front_addr, sizeof(front_addr))) || (0 != bind(back, (sockaddr*)&back_addr, sizeof(back_addr)))) {
+        perror("relay bind");
+        _exit(1);
+    }
+
+    sockaddr_in server = loopback(g_cfg.port);
+    sockaddr_in client;
+    bool has_client = false;
+
+    priority_queue<Delayed, vector<Delayed>, greater<Delayed> > pending;
+    uint64_t order = 0;
+    unsigned int seed = 12345;
+    int fds[2] = {front, back};
+
+    for (;;) {
+        pollfd pfd[2];
+        for (int i = 0; i < 2; ++i) {
+            pfd[i].fd = fds[i];
+            pfd[i].events = POLLIN;
+            pfd[i].revents = 0;
+        }
+
+        uint64_t now = now_us();
+        timespec wait = {0, 100000000};
+        if (!pending.empty()) {
+            uint64_t us = (pending.top().due > now) ? pending.top().due - now : 0;
+            wait.tv_sec = us / 1000000;
+            wait.tv_nsec = (us % 1000000) * 1000;
+        }
+        ppoll(pfd, 2, &wait, NULL);
+
+        for (int dir = 0; dir < 2; ++dir) {
+            if (0 == (pfd[dir].revents & POLLIN))
+                continue;
+
+            for (;;) {
+                char buf[65536];
+                sockaddr_in from;
+                socklen_t fromlen = sizeof(from);
+                int len = recvfrom(fds[dir], buf, sizeof(buf), MSG_DONTWAIT, (sockaddr*)&from, &fromlen);
+                if (len < 0)
+                    break;
+
+                if (0 == dir) {
+                    client = from;
+                    has_client = true;
+                }
+
+                if (rand_r(&seed) < g_cfg.loss / 100.0 * RAND_MAX)
+                    continue;
+
+                Delayed d;
+                d.due = now_us() + g_cfg.delay_ms * 1000ULL;
+                if (g_cfg.jitter_ms > 0)
+                    d.due += rand_r(&seed) % (2 * g_cfg.jitter_ms * 1000) - g_cfg.jitter_ms * 1000;
+                d.order = order ++;
+                d.dir = dir;
+                d.len = len;
+                d.data = new char[len];
+                memcpy(d.data, buf, len);
+                pending.push(d);
+            }
+        }
+
+        now = now_us();
+        while (!pending.empty() && (pending.top().due <= now)) {
+            Delayed d = pending.top();
+            pending.pop();
+
+            if (0 == d.dir)
+                sendto(back, d.data, d.len, 0, (sockaddr*)&server, sizeof(server));
+            else if (has_client)
+                sendto(front, d.data, d.len, 0, (sockaddr*)&client, sizeof(client));
+
+            delete [] d.data;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void* receiver(void* param) {
+    UDTSOCKET serv = *(UDTSOCKET*)param;
+
+    sockaddr_in addr;
+    int addrlen = sizeof(addr);
+    UDTSOCKET recver = UDT::accept(serv, (sockaddr*)&addr, &addrlen);
+    if (UDT::INVALID_SOCK == recver) {
+        printf("accept: %s\n", UDT::getlasterror().getErrorMessage());
+        return NULL;
+    }
+
+    int timeout = 1000;
+    UDT::setsockopt(recver, 0, UDT_RCVTIMEO, &timeout, sizeof(int));
+
+    vector<char> buf(max(g_cfg.frame_size, 1000000));
+    for (;;) {
+        int res;
+        if (g_cfg.stream) {
+            res = UDT::recv(recver, &buf[0], buf.size(), 0);
+        } else {
+            uint16_t frame_id;
+            bool complete;
+            res = UDT::recvframe(recver, &buf[0], buf.size(), frame_id, complete);
+            if ((res >= 0) && !complete) {
+                ++g_dropped_frames;
+                continue;
+            }
+            if (res >= (int)sizeof(FrameHeader)) {
+                FrameHeader hdr;
+                memcpy(&hdr, &buf[0], sizeof(hdr));
+                g_latency.push_back(now_us() - hdr.send_us);
+                ++g_rcv_frames;
+            }
+        }
+
+        if (UDT::ERROR == res) {
+            // the sender is done once nothing has arrived for a whole timeout
+            if (!g_sending)
+                break;
+            if (CUDTException::ETIMEOUT == UDT::getlasterror().getErrorCode())
+                continue;
+            printf("recv: %s\n", UDT::getlasterror().getErrorMessage());
+            break;
+        }
+
+        g_rcv_bytes += res;
+        g_last_rcv_us = now_us();
+    }
+
+    UDT::close(recver);
+    return NULL;
+}
+
+static double percentile(const vector<int64_t>& sorted, double p) {
+    if (sorted.empty())
+        return 0;
+    size_t i = min(sorted.size() - 1, size_t(p / 100.0 * sorted.size()));
+    return sorted[i] / 1000.0;
+}
+
+static void usage(const char* name) {
+    printf("usage: %s [-t seconds] [-s frame_bytes] [-f fps] [-l loss_%%] [-d delay_ms] [-j jitter_ms] [-D deadline_ms] [-S] [-p port]\n", name);
+}
+
+int main(int argc, char** argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "t:s:f:l:d:j:D:Sp:h")) != -1) {
+        switch (opt) {
+        case 't': g_cfg.seconds = atoi(optarg); break;
+        case 's': g_cfg.frame_size = max((int)sizeof(FrameHeader), atoi(optarg)); break;
+        case 'f': g_cfg.fps = atoi(optarg); break;
+        case 'l': g_cfg.loss = atof(optarg); break;
+        case 'd': g_cfg.delay_ms = atoi(optarg); break;
+        case 'j': g_cfg.jitter_ms = atoi(optarg); break;
+        case 'D': g_cfg.deadline_ms = atoi(optarg); break;
+        case 'S': g_cfg.stream = true; break;
+        case 'p': g_cfg.port = atoi(optarg); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    bool relay = (g_cfg.loss > 0) || (g_cfg.delay_ms > 0) || (g_cfg.jitter_ms > 0);
+    pid_t relay_pid = -1;
+    if (relay) {
+        relay_pid = fork();
+        if (0 == relay_pid) {
+            run_relay();
+            _exit(0);
+        }
+    }
+
+    UDT::startup();
+
+    int type = g_cfg.stream ? SOCK_STREAM : SOCK_DGRAM;
+    UDTSOCKET serv = UDT::socket(AF_INET, type, 0);
+    if (g_cfg.deadline_ms > 0) {
+        bool drop = true;
+        UDT::setsockopt(serv, 0, UDT_FRAMEDROP, &drop, sizeof(bool));
+    }
+    sockaddr_in serv_addr = loopback(g_cfg.port);
+    if ((UDT::ERROR == UDT::bind(serv, (sockaddr*)&serv_addr, sizeof(serv_addr))) || (UDT::ERROR == UDT::listen(serv, 1))) {
+        printf("bind: %s\n", UDT::getlasterror().getErrorMessage());
+        return 1;
+    }
+
+    pthread_t rcv_thread;
+    pthread_create(&rcv_thread, NULL, receiver, &serv);
+
+    UDTSOCKET client = UDT::socket(AF_INET, type, 0);
+    if (g_cfg.deadline_ms > 0) {
+        bool drop = true;
+        UDT::setsockopt(client, 0, UDT_FRAMEDROP, &drop, sizeof(bool));
+    }
+
+    // give the relay time to bind its ports
+    if (relay)
+        usleep(200000);
+
+    // frame deadlines count from the time the socket is opened, which connect does
+    sockaddr_in peer = loopback(relay ? g_cfg.port + 1 : g_cfg.port);
+    uint64_t sock_start = now_us();
+    if (UDT::ERROR == UDT::connect(client, (sockaddr*)&peer, sizeof(peer))) {
+        printf("connect: %s\n", UDT::getlasterror().getErrorMessage());
+        return 1;
+    }
+
+    vector<char> buf(g_cfg.stream ? 1000000 : g_cfg.frame_size);
+    for (size_t i = 0; i < buf.size(); ++i)
+        buf[i] = char(i);
+
+    double cpu_start = cpu_seconds();
+    uint64_t start = now_us();
+    uint64_t end = start + g_cfg.seconds * 1000000ULL;
+    uint64_t next = start;
+    long frames = 0;
+
+    while (now_us() < end) {
+        if (g_cfg.stream) {
+            if (UDT::ERROR == UDT::send(client, &buf[0], buf.size(), 0)) {
+                printf("send: %s\n", UDT::getlasterror().getErrorMessage());
+                break;
+            }
+            continue;
+        }
+
+        if (g_cfg.fps > 0) {
+            uint64_t now = now_us();
+            if (next > now)
+                usleep(next - now);
+            next += 1000000 / g_cfg.fps;
+        }
+
+        FrameHeader hdr;
+        hdr.send_us = now_us();
+        hdr.seq = frames;
+        memcpy(&buf[0], &hdr, sizeof(hdr));
+
+        int64_t deadline = (g_cfg.deadline_ms > 0) ? int64_t(hdr.send_us - sock_start) + g_cfg.deadline_ms * 1000LL : 0;
+        if (UDT::ERROR == UDT::sendframe(client, &buf[0], buf.size(), uint16_t(frames), deadline)) {
+            printf("sendframe: %s\n", UDT::getlasterror().getErrorMessage());
+            break;
+        }
+        ++frames;
+    }
+
+    UDT::TRACEINFO perf;
+    memset(&perf, 0, sizeof(perf));
+    UDT::perfmon(client, &perf);
+
+    g_sending = false;
+    pthread_join(rcv_thread, NULL);
+
+    // the time the receiver spent waiting for more data after the end is not counted
+    double elapsed = (g_last_rcv_us > start) ? (g_last_rcv_us - start) / 1e6 : g_cfg.seconds;
+    double cpu = cpu_seconds() - cpu_start;
+
+    UDT::close(client);
+    UDT::close(serv);
+    UDT::cleanup();
+
+    if (relay_pid > 0) {
+        kill(relay_pid, SIGKILL);
+        waitpid(relay_pid, NULL, 0);
+    }
+
+    double gbit = g_rcv_bytes * 8 / 1e9;
+    printf("%s, %d s, loss %.2f%%, delay %d ms, jitter %d ms", g_cfg.stream ? "stream" : "frames", g_cfg.seconds, g_cfg.loss, g_cfg.delay_ms, g_cfg.jitter_ms);
+    if (!g_cfg.stream)
+    {
+        printf(", %d-byte frames ", g_cfg.frame_size);
+        if (g_cfg.fps > 0)
+            printf("at %d fps", g_cfg.fps);
+        else
+            printf("back to back");
+        printf(", deadline %d ms", g_cfg.deadline_ms);
+    }
+    printf("\n");
+    printf("throughput:   %.1f Mbit/s (%.1f MB received)\n", gbit * 1000 / elapsed, g_rcv_bytes / 1e6);
+    printf("CPU:          %.2f s for both ends, %.3f CPU s per Gbit\n", cpu, (gbit > 0) ? cpu / gbit : 0.0);
+    printf("sender:       %lld packets, %lld retransmitted, %d losses reported, RTT %.2f ms\n",
+           (long long)perf.pktSentTotal, (long long)perf.pktRetransTotal, perf.pktSndLossTotal, perf.msRTT);
+
+    if (!g_cfg.stream) {
+        sort(g_latency.begin(), g_latency.end());
+        printf("frames:       %ld sent, %ld received, %ld dropped\n", frames, g_rcv_frames, g_dropped_frames);
+        printf("latency (ms): p50 %.2f  p90 %.2f  p99 %.2f  p99.9 %.2f  max %.2f\n",
+               percentile(g_latency, 50), percentile(g_latency, 90), percentile(g_latency, 99),
+               percentile(g_latency, 99.9), g_latency.empty() ? 0.0 : g_latency.back() / 1000.0);
+    }
+
+    return 0;
+}
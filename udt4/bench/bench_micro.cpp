@@ -0,0 +1,393 @@
+/*
+ * Microbenchmarks for the hot components of the UDT data path:
+ * CPacket header packing, CChannel send/receive over loopback, CSndBuffer, CRcvBuffer,
+ * the sender and receiver loss lists, the CSndUList heap and CPktTimeWindow.
+ *
+ * usage: bench_micro [scale]
+ *    scale multiplies the number of iterations of every benchmark (default 1).
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#include <string>
+#include <map>
+#include <list>
+#include <set>
+#include <queue>
+#include <fstream>
+#include <algorithm>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+// the benchmarks drive internal classes through members that only the library itself may use
+#define private public
+#define protected public
+#include "../src/core.h"
+#include "../src/queue.h"
+#undef protected
+#undef private
+
+using namespace std;
+
+static const int PAYLOAD = 1456;
+
+static long g_scale = 1;
+static volatile int64_t g_sink = 0;
+
+static uint64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void report(const char* name, uint64_t ns, long ops) {
+    printf("%-44s %10.1f ns/op %14.0f ops/s\n", name, double(ns) / ops, ops * 1e9 / double(ns));
+}
+
+static void bench_packet() {
+    long n = 10000000 * g_scale;
+    CPacket pkt;
+    char data[PAYLOAD];
+    pkt.m_pcData = data;
+    pkt.setLength(PAYLOAD);
+
+    uint64_t t = now_ns();
+    for (long i = 0; i < n; ++i) {
+        pkt.m_iSeqNo = int32_t(i & 0x7FFFFFFF);
+        pkt.m_iMsgNo = int32_t(0xC0000000 | (i & 0x1FFFFFFF));
+        pkt.m_iTimeStamp = int32_t(i);
+        pkt.m_iID = 12345;
+        pkt.setFrameID(int32_t(i & 0xFFFF));
+        pkt.setChunkID(int32_t(i & 0xFF));
+        pkt.setTotalChunks(200);
+        pkt.setFrameDeadline(int64_t(i) + 16000);
+    }
+    report("CPacket data header pack", now_ns() - t, n);
+
+    t = now_ns();
+    int64_t sum = 0;
+    for (long i = 0; i < n; ++i) {
+        pkt.m_iSeqNo = int32_t(i);
+        sum += pkt.getFlag() + pkt.getMsgBoundary() + pkt.getMsgSeq() + pkt.getFrameID()
+             + pkt.getChunkID() + pkt.getTotalChunks() + pkt.getFrameDeadline() + pkt.m_iSeqNo;
+    }
+    g_sink += sum;
+    report("CPacket data header unpack", now_ns() - t, n);
+
+    CPacket ctrl;
+    int32_t ack[6] = {1, 2, 3, 4, 5, 6};
+    t = now_ns();
+    for (long i = 0; i < n; ++i) {
+        int32_t ackno = int32_t(i);
+        ack[0] = int32_t(i);
+        ctrl.pack(2, &ackno, ack, sizeof(ack));
+        sum += ctrl.getType() + ctrl.getAckSeqNo();
+    }
+    g_sink += sum;
+    report("CPacket ACK pack + unpack", now_ns() - t, n);
+}
+
+static void bench_channel() {
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    CChannel snd(AF_INET), rcv(AF_INET);
+    snd.setSndBufSize(4 << 20);
+    rcv.setRcvBufSize(4 << 20);
+    snd.open((sockaddr*)&addr);
+    rcv.open((sockaddr*)&addr);
+
+    sockaddr_in dst;
+    rcv.getSockAddr((sockaddr*)&dst);
+
+    static const int BATCH = 32;
+    char sdata[BATCH][PAYLOAD];
+    char rdata[BATCH][PAYLOAD];
+    CPacket spkt[BATCH], rpkt[BATCH];
+    CPacket* sp[BATCH];
+    CPacket* rp[BATCH];
+    sockaddr* sa[BATCH];
+    sockaddr* ra[BATCH];
+    sockaddr_in raddr[BATCH];
+    for (int i = 0; i < BATCH; ++i) {
+        memset(sdata[i], i, PAYLOAD);
+        spkt[i].m_pcData = sdata[i];
+        spkt[i].setLength(PAYLOAD);
+        rpkt[i].m_pcData = rdata[i];
+        sp[i] = spkt + i;
+        rp[i] = rpkt + i;
+        sa[i] = (sockaddr*)&dst;
+        ra[i] = (sockaddr*)(raddr + i);
+    }
+
+    long n = 200000 * g_scale;
+    long lost = 0;
+    uint64_t t = now_ns();
+    for (long i = 0; i < n; ++i) {
+        spkt[0].m_iSeqNo = int32_t(i);
+        spkt[0].setLength(PAYLOAD);
+        snd.sendto((sockaddr*)&dst, spkt[0]);
+        rpkt[0].setLength(PAYLOAD);
+        if (rcv.recvfrom(ra[0], rpkt[0]) <= 0)
+            ++lost;
+    }
+    report("CChannel sendto + recvfrom (1 packet)", now_ns() - t, n);
+
+    long batches = n / BATCH;
+    t = now_ns();
+    for (long i = 0; i < batches; ++i) {
+        for (int k = 0; k < BATCH; ++k) {
+            spkt[k].m_iSeqNo = int32_t(i * BATCH + k);
+            spkt[k].setLength(PAYLOAD);
+        }
+        int sent = snd.sendto(sa, sp, BATCH);
+        for (int got = 0; got < sent;) {
+            for (int k = 0; k < BATCH; ++k)
+                rpkt[k].setLength(PAYLOAD);
+            int r = rcv.recvfrom(ra, rp, BATCH - got);
+            if (r <= 0) {
+                lost += sent - got;
+                break;
+            }
+            got += r;
+        }
+    }
+    report("CChannel batch sendto + recvfrom (per packet)", now_ns() - t, batches * BATCH);
+
+    if (lost > 0)
+        printf("   (%ld packets lost on loopback)\n", lost);
+
+    snd.close();
+    rcv.close();
+}
+
+static void bench_sndbuffer() {
+    static const int BATCH = 64;
+    long n = 2000000 * g_scale / BATCH * BATCH;
+    CSndBuffer buf(BATCH * 2, PAYLOAD);
+    char data[PAYLOAD];
+    memset(data, 1, PAYLOAD);
+
+    uint64_t add = 0, read = 0, ack = 0;
+    for (long i = 0; i < n; i += BATCH) {
+        uint64_t t0 = now_ns();
+        for (int k = 0; k < BATCH; ++k)
+            buf.addBuffer(data, PAYLOAD);
+        uint64_t t1 = now_ns();
+        for (int k = 0; k < BATCH; ++k) {
+            char* p;
+            int32_t msgno;
+            g_sink += buf.readData(&p, msgno);
+        }
+        uint64_t t2 = now_ns();
+        buf.ackData(BATCH);
+        uint64_t t3 = now_ns();
+        add += t1 - t0;
+        read += t2 - t1;
+        ack += t3 - t2;
+    }
+    report("CSndBuffer::addBuffer (1 packet)", add, n);
+    report("CSndBuffer::readData", read, n);
+    report("CSndBuffer::ackData (per packet)", ack, n);
+}
+
+static void bench_rcvbuffer() {
+    static const int BATCH = 64;
+    long n = 2000000 * g_scale / BATCH * BATCH;
+
+    CUnitQueue queue;
+    queue.init(1024, PAYLOAD + CPacket::m_iPktHdrSize, AF_INET);
+    CRcvBuffer buf(&queue, 8192);
+    vector<char> data(BATCH * PAYLOAD);
+
+    for (int mode = 0; mode < 2; ++mode) {
+        uint64_t add = 0, read = 0;
+        for (long i = 0; i < n; i += BATCH) {
+            uint64_t t0 = now_ns();
+            for (int k = 0; k < BATCH; ++k) {
+                CUnit* u = queue.getNextAvailUnit();
+                u->m_Packet.setLength(PAYLOAD);
+                u->m_Packet.m_iSeqNo = int32_t(i + k);
+                u->m_Packet.m_iMsgNo = int32_t(0xC0000000 | ((i + k) & 0x1FFFFFFF));
+                buf.addData(u, k);
+            }
+            buf.ackData(BATCH);
+            uint64_t t1 = now_ns();
+            if (0 == mode)
+                g_sink += buf.readBuffer(&data[0], BATCH * PAYLOAD);
+            else {
+                for (int k = 0; k < BATCH; ++k)
+                    g_sink += buf.readMsg(&data[0], PAYLOAD);
+            }
+            uint64_t t2 = now_ns();
+            add += t1 - t0;
+            read += t2 - t1;
+        }
+        report(0 == mode ? "CRcvBuffer::addData + ackData (stream)" : "CRcvBuffer::addData + ackData (message)", add, n);
+        report(0 == mode ? "CRcvBuffer::readBuffer (per packet)" : "CRcvBuffer::readMsg (1-packet message)", read, n);
+    }
+}
+
+static void bench_losslist() {
+    long n = 1000000 * g_scale;
+
+    // the sender: every 4th packet of a window is reported lost, then retransmitted in order
+    {
+        CSndLossList list(8192 * 2);
+        int32_t seq = 0;
+        long ins = 0, rem = 0;
+        uint64_t tins = 0, trem = 0;
+        while (ins < n) {
+            uint64_t t0 = now_ns();
+            for (int k = 0; k < 1024; ++k, seq = CSeqNo::incseq(seq, 4))
+                list.insert(seq, seq);
+            uint64_t t1 = now_ns();
+            while (list.getLostSeq() >= 0)
+                ++rem;
+            uint64_t t2 = now_ns();
+            ins += 1024;
+            tins += t1 - t0;
+            trem += t2 - t1;
+        }
+        report("CSndLossList::insert (sparse)", tins, ins);
+        report("CSndLossList::getLostSeq", trem, rem);
+
+        uint64_t t = now_ns();
+        for (long i = 0; i < n; i += 1024) {
+            for (int k = 0; k < 1024; ++k)
+                list.insert(CSeqNo::incseq(seq, k * 4), CSeqNo::incseq(seq, k * 4 + 1));
+            seq = CSeqNo::incseq(seq, 4096);
+            list.remove(CSeqNo::decseq(seq));
+        }
+        report("CSndLossList::insert + remove(ack)", now_ns() - t, n);
+    }
+
+    // the receiver: a gap per 4 packets, each filled by a retransmission
+    {
+        CRcvLossList list(8192 * 2);
+        int32_t seq = 0;
+        uint64_t tins = 0, trem = 0;
+        long ops = 0;
+        while (ops < n) {
+            uint64_t t0 = now_ns();
+            for (int k = 0; k < 1024; ++k)
+                list.insert(CSeqNo::incseq(seq, k * 4), CSeqNo::incseq(seq, k * 4 + 1));
+            uint64_t t1 = now_ns();
+            for (int k = 0; k < 1024; ++k) {
+                list.remove(CSeqNo::incseq(seq, k * 4 + 1));
+                list.remove(CSeqNo::incseq(seq, k * 4));
+            }
+            uint64_t t2 = now_ns();
+            seq = CSeqNo::incseq(seq, 4096);
+            ops += 1024;
+            tins += t1 - t0;
+            trem += t2 - t1;
+        }
+        report("CRcvLossList::insert (2-packet gap)", tins, ops);
+        report("CRcvLossList::remove (per packet)", trem, ops * 2);
+    }
+}
+
+static void bench_snduList() {
+    static const int SOCKETS = 1000;
+    long n = 2000000 * g_scale;
+
+    CTimer timer;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&cond, NULL);
+
+    CSndUList list;
+    list.m_pTimer = &timer;
+    list.m_pWindowLock = &lock;
+    list.m_pWindowCond = &cond;
+
+    vector<CUDT*> sockets(SOCKETS);
+    for (int i = 0; i < SOCKETS; ++i) {
+        sockets[i] = new CUDT;
+        sockets[i]->m_pSNode = new CSNode;
+        sockets[i]->m_pSNode->m_pUDT = sockets[i];
+        sockets[i]->m_pSNode->m_iHeapLoc = -1;
+    }
+
+    srand(1);
+    int64_t now = 1000000;
+    for (int i = 0; i < SOCKETS; ++i)
+        list.insert(now + rand() % 10000, sockets[i]);
+
+    // the send thread takes the earliest socket and schedules its next packet
+    uint64_t t = now_ns();
+    for (long i = 0; i < n; ++i) {
+        CSNode* top = list.m_pHeap[0];
+        now = top->m_llTimeStamp;
+        list.remove(top->m_pUDT);
+        list.insert(now + 1 + rand() % 10000, top->m_pUDT);
+    }
+    report("CSndUList pop + insert (1000 sockets)", now_ns() - t, n);
+
+    t = now_ns();
+    for (long i = 0; i < n; ++i)
+        list.update(sockets[rand() % SOCKETS], true);
+    report("CSndUList::update (reschedule)", now_ns() - t, n);
+
+    for (int i = 0; i < SOCKETS; ++i) {
+        list.remove(sockets[i]);
+        delete sockets[i];
+    }
+
+    pthread_mutex_destroy(&lock);
+    pthread_cond_destroy(&cond);
+}
+
+static void bench_timewindow() {
+    long n = 5000000 * g_scale;
+    CPktTimeWindow window(16, 64);
+
+    uint64_t t = now_ns();
+    for (long i = 0; i < n; ++i)
+        window.onPktArrival();
+    report("CPktTimeWindow::onPktArrival", now_ns() - t, n);
+
+    t = now_ns();
+    for (long i = 0; i < n; i += 16) {
+        window.probe1Arrival();
+        window.probe2Arrival();
+    }
+    report("CPktTimeWindow::probe1 + probe2Arrival", now_ns() - t, n / 16);
+
+    t = now_ns();
+    for (long i = 0; i < n; ++i)
+        g_sink += window.getPktRcvSpeed();
+    report("CPktTimeWindow::getPktRcvSpeed", now_ns() - t, n);
+
+    t = now_ns();
+    for (long i = 0; i < n; ++i)
+        g_sink += window.getBandwidth();
+    report("CPktTimeWindow::getBandwidth", now_ns() - t, n);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1)
+        g_scale = max(1L, atol(argv[1]));
+
+    UDT::startup();
+
+    bench_packet();
+    bench_channel();
+    bench_sndbuffer();
+    bench_rcvbuffer();
+    bench_losslist();
+    bench_snduList();
+    bench_timewindow();
+
+    UDT::cleanup();
+    return 0;
+}
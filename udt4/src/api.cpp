@@ -46,6 +46,8 @@ written by
    #endif
 #else
    #include <unistd.h>
+   #include <fcntl.h>
+   #include <cerrno>
 #endif
 #include <cstring>
 #include "api.h"
@@ -123,6 +125,7 @@ m_TLSError(),
 m_mMultiplexer(),
 m_MultiplexerLock(),
 m_pCache(NULL),
+m_pSharedCache(NULL),
 m_bClosing(false),
 m_GCStopLock(),
 m_GCStopCond(),
@@ -176,6 +179,7 @@ CUDTUnited::~CUDTUnited()
    #endif
 
    delete m_pCache;
+   delete m_pSharedCache;
 }
 
 int CUDTUnited::startup()
@@ -217,6 +221,25 @@ int CUDTUnited::startup()
    return 0;
 }
 
+int CUDTUnited::setCacheFile(const char* path, int maxage)
+{
+   CGuard gcinit(m_InitLock);
+
+   // the sockets keep a pointer to the cache, so it is set once and for all
+   if ((NULL != m_pSharedCache) || (NULL == path) || (maxage <= 0))
+      throw CUDTException(5, 3, 0);
+
+   CSharedInfoCache* cache = new CSharedInfoCache;
+   if (cache->open(path, maxage) < 0)
+   {
+      delete cache;
+      throw CUDTException(4, 0, 0);
+   }
+
+   m_pSharedCache = cache;
+   return 0;
+}
+
 int CUDTUnited::cleanup()
 {
    CGuard gcinit(m_InitLock);
@@ -291,12 +314,13 @@ UDTSOCKET CUDTUnited::newSocket(int af, int type)
    ns->m_pUDT->m_iSockType = (SOCK_STREAM == type) ? UDT_STREAM : UDT_DGRAM;
    ns->m_pUDT->m_iIPversion = ns->m_iIPversion = af;
    ns->m_pUDT->m_pCache = m_pCache;
+   ns->m_pUDT->m_pSharedCache = m_pSharedCache;
 
    // protect the m_Sockets structure.
    CGuard::enterCS(m_ControlLock);
    try
    {
-      m_Sockets[ns->m_SocketID] = ns;
+      m_Sockets.set(ns->m_SocketID, ns);
    }
    catch (...)
    {
@@ -345,6 +369,7 @@ int CUDTUnited::newConnection(const UDTSOCKET listen, const sockaddr* peer, CHan
          hs->m_iFlightFlagSize = ns->m_pUDT->m_iFlightFlagSize;
          hs->m_iReqType = -1;
          hs->m_iID = ns->m_SocketID;
+         hs->m_iExtension = ns->m_pUDT->m_iHSExtension;
 
          return 0;
 
@@ -416,8 +441,12 @@ int CUDTUnited::newConnection(const UDTSOCKET listen, const sockaddr* peer, CHan
    CGuard::enterCS(m_ControlLock);
    try
    {
-      m_Sockets[ns->m_SocketID] = ns;
-      m_PeerRec[(ns->m_PeerID << 30) + ns->m_iISN].insert(ns->m_SocketID);
+      m_Sockets.set(ns->m_SocketID, ns);
+
+      const int64_t key = (ns->m_PeerID << 30) + ns->m_iISN;
+      const int ps = m_PeerRec.stripe(key);
+      CGuard peer_cg(m_PeerRec.lock(ps));
+      m_PeerRec.bucket(ps)[key].insert(ns->m_SocketID);
    }
    catch (...)
    {
@@ -465,36 +494,32 @@ int CUDTUnited::newConnection(const UDTSOCKET listen, const sockaddr* peer, CHan
 
 CUDT* CUDTUnited::lookup(const UDTSOCKET u)
 {
-   // protects the m_Sockets structure
-   CGuard cg(m_ControlLock);
-
-   map<UDTSOCKET, CUDTSocket*>::iterator i = m_Sockets.find(u);
+   CUDTSocket* s = locate(u);
 
-   if ((i == m_Sockets.end()) || (i->second->m_Status == CLOSED))
+   if (NULL == s)
       throw CUDTException(5, 4, 0);
 
-   return i->second->m_pUDT;
+   return s->m_pUDT;
 }
 
 UDTSTATUS CUDTUnited::getStatus(const UDTSOCKET u)
 {
-   // protects the m_Sockets structure
-   CGuard cg(m_ControlLock);
-
-   map<UDTSOCKET, CUDTSocket*>::iterator i = m_Sockets.find(u);
+   // a closing socket is added to m_ClosedSockets before it is removed from m_Sockets,
+   // so checking the two tables in this order never misses it
+   CUDTSocket* s;
 
-   if (i == m_Sockets.end())
+   if (!m_Sockets.find(u, s))
    {
-      if (m_ClosedSockets.find(u) != m_ClosedSockets.end())
+      if (m_ClosedSockets.find(u, s))
          return CLOSED;
 
       return NONEXIST;
    }
 
-   if (i->second->m_pUDT->m_bBroken)
+   if (s->m_pUDT->m_bBroken)
       return BROKEN;
 
-   return i->second->m_Status;   
+   return s->m_Status;   
 }
 
 int CUDTUnited::bind(const UDTSOCKET u, const sockaddr* name, int namelen)
@@ -597,6 +622,9 @@ int CUDTUnited::listen(const UDTSOCKET u, int backlog)
 
    s->m_uiBackLog = backlog;
 
+   // connection requests carry no socket ID, and are steered to the first worker
+   setWorker(s, 0);
+
    try
    {
       s->m_pQueuedSockets = new set<UDTSOCKET>;
@@ -760,6 +788,10 @@ int CUDTUnited::connect(const UDTSOCKET u, const sockaddr* name, int namelen)
    else if (OPENED != s->m_Status)
       throw CUDTException(5, 2, 0);
 
+   // the socket may have been set to rendezvous mode after it joined a port with several workers
+   if (s->m_pUDT->m_bRendezvous && (getWorkers(s) > 1))
+      throw CUDTException(5, 14, 0);
+
    // connect_complete() may be called before connect() returns.
    // So we need to update the status before connect() is called,
    // otherwise the status may be overwritten with wrong value (CONNECTED vs. CONNECTING).
@@ -830,6 +862,10 @@ int CUDTUnited::close(const UDTSOCKET u)
          SetEvent(s->m_AcceptCond);
       #endif
 
+      // new connection requests are rejected from now on; the socket itself is closed by the garbage collector,
+      // which holds m_ControlLock and so cannot wait for a request being answered
+      s->m_pUDT->stopListening();
+
       return 0;
    }
 
@@ -839,10 +875,8 @@ int CUDTUnited::close(const UDTSOCKET u)
    CGuard manager_cg(m_ControlLock);
 
    // since "s" is located before m_ControlLock, locate it again in case it became invalid
-   map<UDTSOCKET, CUDTSocket*>::iterator i = m_Sockets.find(u);
-   if ((i == m_Sockets.end()) || (i->second->m_Status == CLOSED))
+   if (!m_Sockets.find(u, s) || (s->m_Status == CLOSED))
       return 0;
-   s = i->second;
 
    s->m_Status = CLOSED;
 
@@ -851,8 +885,8 @@ int CUDTUnited::close(const UDTSOCKET u)
    // a timer is started and the socket will be removed after approximately 1 second
    s->m_TimeStamp = CTimer::getTime();
 
+   m_ClosedSockets.set(s->m_SocketID, s);
    m_Sockets.erase(s->m_SocketID);
-   m_ClosedSockets.insert(pair<UDTSOCKET, CUDTSocket*>(s->m_SocketID, s));
 
    CTimer::triggerEvent();
 
@@ -1136,40 +1170,462 @@ int CUDTUnited::epoll_wait(const int eid, set<UDTSOCKET>* readfds, set<UDTSOCKET
    return m_EPoll.wait(eid, readfds, writefds, msTimeOut, lrfds, lwfds);
 }
 
+int CUDTUnited::epoll_wait2(const int eid, UDT_EPOLL_EVENT* events, int max, int64_t msTimeOut)
+{
+   return m_EPoll.wait2(eid, events, max, msTimeOut);
+}
+
 int CUDTUnited::epoll_release(const int eid)
 {
    return m_EPoll.release(eid);
 }
 
-CUDTSocket* CUDTUnited::locate(const UDTSOCKET u)
+int CUDTUnited::fanout_create()
 {
-   CGuard cg(m_ControlLock);
+   return m_Fanout.create();
+}
+
+int CUDTUnited::fanout_add(const int gid, const UDTSOCKET u)
+{
+   CUDTSocket* s = locate(u);
+   if (NULL == s)
+      throw CUDTException(5, 4, 0);
+   if (CONNECTED != s->m_Status)
+      throw CUDTException(2, 2, 0);
+
+   m_Fanout.add(gid, u);
+
+   return 0;
+}
+
+int CUDTUnited::fanout_remove(const int gid, const UDTSOCKET u)
+{
+   m_Fanout.remove(gid, u);
+
+   return 0;
+}
+
+int CUDTUnited::fanout_sendframe(const int gid, const char* data, int len, uint16_t frame_id, int64_t deadline_us)
+{
+   vector<UDTSOCKET> subscribers;
+   uint64_t start;
+   m_Fanout.getSubscribers(gid, subscribers, start);
+
+   if ((len <= 0) || subscribers.empty())
+      return 0;
+
+   // one copy for all the subscribers; the buffer of each holds a reference as long as it has the frame
+   CSharedFrame* frame = CFanout::newFrame(data, len);
+
+   int sent = 0;
+   for (vector<UDTSOCKET>::iterator i = subscribers.begin(); i != subscribers.end(); ++ i)
+   {
+      CUDTSocket* s = locate(*i);
+      if (NULL == s)
+      {
+         // a closed subscriber leaves the group
+         try
+         {
+            m_Fanout.remove(gid, *i);
+         }
+         catch (CUDTException&)
+         {
+         }
+         continue;
+      }
+
+      // the deadline moves from the time base of the group to that of the socket; one already passed stays so
+      int64_t deadline = 0;
+      if (deadline_us > 0)
+      {
+         deadline = deadline_us + int64_t(start) - int64_t(s->m_pUDT->m_StartTime);
+         if (deadline <= 0)
+            deadline = 1;
+      }
+
+      CFanout::addRef(frame);
+      try
+      {
+         // a subscriber that cannot take the frame at once misses it, rather than holding up the others
+         if (s->m_pUDT->sendframe(frame->m_pcData, len, frame_id, deadline, CFanout::releaseFrame, frame, false) > 0)
+         {
+            ++ sent;
+            continue;
+         }
+      }
+      catch (CUDTException& e)
+      {
+         if ((CUDTException::ECONNLOST == e.getErrorCode()) || (CUDTException::ENOCONN == e.getErrorCode()))
+         {
+            try
+            {
+               m_Fanout.remove(gid, *i);
+            }
+            catch (CUDTException&)
+            {
+            }
+         }
+      }
+
+      // the callback is not called for a frame that has not been taken
+      CFanout::releaseFrame(*i, frame->m_pcData, len, frame);
+   }
+
+   CFanout::releaseFrame(UDT::INVALID_SOCK, frame->m_pcData, len, frame);
+
+   return sent;
+}
+
+int CUDTUnited::fanout_release(const int gid)
+{
+   m_Fanout.release(gid);
+
+   return 0;
+}
+
+int CUDTUnited::mpath_create()
+{
+   int eid = m_EPoll.create();
+
+   try
+   {
+      return m_Multipath.create(eid);
+   }
+   catch (...)
+   {
+      m_EPoll.release(eid);
+      throw;
+   }
+}
+
+int CUDTUnited::mpath_add(const int mid, const UDTSOCKET u)
+{
+   CUDTSocket* s = locate(u);
+   if (NULL == s)
+      throw CUDTException(5, 4, 0);
+   if (UDT_STREAM == s->m_pUDT->m_iSockType)
+      throw CUDTException(5, 9, 0);
+   if (CONNECTED != s->m_Status)
+      throw CUDTException(2, 2, 0);
+
+   vector<UDTSOCKET> subflows;
+   uint64_t start;
+   int eid;
+   m_Multipath.getSubFlows(mid, subflows, start, eid);
+
+   // the receiver waits for data, or a failure, on any of the sub-flows
+   int events = UDT_EPOLL_IN | UDT_EPOLL_ERR;
+   m_EPoll.add_usock(eid, u, &events);
+   s->m_pUDT->addEPoll(eid);
+
+   m_Multipath.add(mid, u);
+
+   return 0;
+}
+
+int CUDTUnited::mpath_remove(const int mid, const UDTSOCKET u)
+{
+   vector<UDTSOCKET> subflows;
+   uint64_t start;
+   int eid;
+   m_Multipath.getSubFlows(mid, subflows, start, eid);
+
+   m_Multipath.remove(mid, u);
+   epoll_remove_usock(eid, u);
+
+   return 0;
+}
+
+int CUDTUnited::mpath_sendframe(const int mid, const char* data, int len, uint16_t frame_id, int64_t deadline_us)
+{
+   vector<UDTSOCKET> subflows;
+   uint64_t start;
+   int eid;
+   m_Multipath.getSubFlows(mid, subflows, start, eid);
+
+   if (len <= 0)
+      return 0;
+
+   // the sub-flows that are up; chunks are as large as the smallest payload among them
+   vector<CSlicePlan> plans;
+   int chunksize = 0;
+   for (vector<UDTSOCKET>::iterator i = subflows.begin(); i != subflows.end(); ++ i)
+   {
+      CUDTSocket* s = locate(*i);
+      if ((NULL == s) || (CONNECTED != s->m_Status))
+      {
+         // a broken or closed sub-flow leaves the session
+         try
+         {
+            mpath_remove(mid, *i);
+         }
+         catch (CUDTException&)
+         {
+         }
+         continue;
+      }
+
+      CSlicePlan plan;
+      plan.m_iSocket = *i;
+      plan.m_pUDT = s->m_pUDT;
+      plan.m_iBytes = CMultipath::m_iSliceHdrSize;
+      plan.m_bBlock = false;
+
+      // the deadline moves from the time base of the session to that of the sub-flow; one already passed stays so
+      plan.m_llDeadline = 0;
+      if (deadline_us > 0)
+      {
+         plan.m_llDeadline = deadline_us + int64_t(start) - int64_t(s->m_pUDT->m_StartTime);
+         if (plan.m_llDeadline <= 0)
+            plan.m_llDeadline = 1;
+      }
+
+      if ((0 == chunksize) || (s->m_pUDT->m_iPayloadSize < chunksize))
+         chunksize = s->m_pUDT->m_iPayloadSize;
+
+      plans.push_back(plan);
+   }
+
+   if (plans.empty())
+      throw CUDTException(2, 2, 0);
+
+   int total = (len + chunksize - 1) / chunksize;
+   if (total > 0xFFFF)
+      throw CUDTException(5, 12, 0);
+
+   int64_t now = CTimer::getTime() - start;
+
+   for (int c = 0; c < total; ++ c)
+   {
+      int size = (len - c * chunksize < chunksize) ? len - c * chunksize : chunksize;
+
+      // rank the sub-flows: the chunk makes the deadline even if it has to be repaired (2), makes it only if it is
+      // not lost (1), or misses it (0); within a rank the earliest expected delivery wins. A lossy or congested
+      // sub-flow expects later deliveries, so it gets chunks only when it does not hold the frame back.
+      int best = -1;
+      int bestrank = -1;
+      int64_t besttime = 0;
+      for (int p = 0, n = plans.size(); p < n; ++ p)
+      {
+         CSlicePlan& plan = plans[p];
+
+         // a slice goes as one frame of the sub-flow, which has to take it whole
+         int bytes = plan.m_iBytes + 2 + size;
+         if (((int)plan.m_vChunks.size() >= CMultipath::m_iMaxSliceChunks) || (bytes > 255 * plan.m_pUDT->m_iPayloadSize))
+            continue;
+
+         int64_t t = plan.m_pUDT->estimateDelivery(bytes);
+         if (t < 0)
+            continue;
+
+         int rank = 2;
+         if (deadline_us > 0)
+         {
+            if (now + t > deadline_us)
+               rank = 0;
+            else if (now + t + plan.m_pUDT->m_iRTT > deadline_us)
+               rank = 1;
+         }
+
+         if ((rank > bestrank) || ((rank == bestrank) && (t < besttime)))
+         {
+            best = p;
+            bestrank = rank;
+            besttime = t;
+         }
+      }
+
+      if (best < 0)
+      {
+         // no sub-flow has room for the chunk now: it waits on the one with the shortest slice
+         for (int p = 0, n = plans.size(); p < n; ++ p)
+         {
+            int bytes = plans[p].m_iBytes + 2 + size;
+            if (((int)plans[p].m_vChunks.size() >= CMultipath::m_iMaxSliceChunks) || (bytes > 255 * plans[p].m_pUDT->m_iPayloadSize))
+               continue;
+            if ((best < 0) || (plans[p].m_iBytes < plans[best].m_iBytes))
+               best = p;
+         }
+
+         if (best < 0)
+            throw CUDTException(5, 12, 0);
+
+         plans[best].m_bBlock = true;
+      }
+
+      plans[best].m_vChunks.push_back(c);
+      plans[best].m_iBytes += 2 + size;
+   }
+
+   char* slice = new char[len + CMultipath::m_iSliceHdrSize + total * 2];
+
+   int sent = 0;
+   int error = CUDTException::ECONNLOST;
+   for (vector<CSlicePlan>::iterator i = plans.begin(); i != plans.end(); ++ i)
+   {
+      if (i->m_vChunks.empty())
+         continue;
+
+      int size = CMultipath::packSlice(slice, data, len, chunksize, i->m_vChunks);
+      try
+      {
+         // the sender buffer has been seen to have room, except over shared memory
+         int res = 0;
+         try
+         {
+            res = i->m_pUDT->sendframe(slice, size, frame_id, i->m_llDeadline, NULL, NULL, i->m_bBlock);
+         }
+         catch (CUDTException& e)
+         {
+            if (CUDTException::EASYNCSND != e.getErrorCode())
+               throw;
+         }
+         if (res <= 0)
+            res = i->m_pUDT->sendframe(slice, size, frame_id, i->m_llDeadline, NULL, NULL, true);
+
+         if (res > 0)
+            sent += size - CMultipath::m_iSliceHdrSize - i->m_vChunks.size() * 2;
+      }
+      catch (CUDTException& e)
+      {
+         // the chunks of a failed sub-flow are lost, and the receiver gives up the frame
+         error = e.getErrorCode();
+         if ((CUDTException::ECONNLOST == e.getErrorCode()) || (CUDTException::ENOCONN == e.getErrorCode()))
+         {
+            try
+            {
+               mpath_remove(mid, i->m_iSocket);
+            }
+            catch (CUDTException&)
+            {
+            }
+         }
+      }
+   }
+
+   delete [] slice;
+
+   if (0 == sent)
+      throw CUDTException(error / 1000, error % 1000, 0);
+
+   return sent;
+}
+
+int CUDTUnited::mpath_recvframe(const int mid, char* data, int len, uint16_t& frame_id, bool& complete)
+{
+   if (len <= 0)
+      return 0;
+
+   int size = 0;
+   if (m_Multipath.readFrame(mid, data, len, size, frame_id, complete))
+      return size;
+
+   // a slice of a frame that fits into the buffer fits into this one
+   int slicelen = len + CMultipath::m_iSliceHdrSize + CMultipath::m_iMaxSliceChunks * 2;
+   char* slice = new char[slicelen];
 
-   map<UDTSOCKET, CUDTSocket*>::iterator i = m_Sockets.find(u);
+   try
+   {
+      while (!m_Multipath.readFrame(mid, data, len, size, frame_id, complete))
+      {
+         vector<UDTSOCKET> subflows;
+         uint64_t start;
+         int eid;
+         m_Multipath.getSubFlows(mid, subflows, start, eid);
+
+         if (subflows.empty())
+            throw CUDTException(2, 2, 0);
+
+         set<UDTSOCKET> readfds;
+         m_EPoll.wait(eid, &readfds, NULL, -1, NULL, NULL);
+
+         for (set<UDTSOCKET>::iterator i = readfds.begin(); i != readfds.end(); ++ i)
+         {
+            CUDTSocket* s = locate(*i);
+            if (NULL == s)
+            {
+               mpath_remove(mid, *i);
+               m_Multipath.giveUp(mid);
+               continue;
+            }
+
+            // take all that the sub-flow has ready
+            try
+            {
+               while (true)
+               {
+                  uint16_t id;
+                  bool whole;
+                  int res = s->m_pUDT->recvframe(slice, slicelen, id, whole, false);
+                  if (whole)
+                     m_Multipath.merge(mid, id, slice, res);
+                  else
+                     m_Multipath.abandon(mid, id);
+               }
+            }
+            catch (CUDTException& e)
+            {
+               // a broken or closed sub-flow leaves the session, and the frames it may have been carrying are given up
+               if (CUDTException::EASYNCRCV != e.getErrorCode())
+               {
+                  mpath_remove(mid, *i);
+                  m_Multipath.giveUp(mid);
+               }
+            }
+         }
+      }
+   }
+   catch (...)
+   {
+      delete [] slice;
+      throw;
+   }
+
+   delete [] slice;
+
+   return size;
+}
+
+int CUDTUnited::mpath_release(const int mid)
+{
+   int eid = m_Multipath.release(mid);
+   m_EPoll.release(eid);
+
+   return 0;
+}
+
+CUDTSocket* CUDTUnited::locate(const UDTSOCKET u)
+{
+   // only the stripe holding "u" is locked; m_ControlLock is left to the writers
+   CUDTSocket* s;
 
-   if ((i == m_Sockets.end()) || (i->second->m_Status == CLOSED))
+   if (!m_Sockets.find(u, s) || (s->m_Status == CLOSED))
       return NULL;
 
-   return i->second;
+   return s;
 }
 
 CUDTSocket* CUDTUnited::locate(const sockaddr* peer, const UDTSOCKET id, int32_t isn)
 {
-   CGuard cg(m_ControlLock);
+   const int64_t key = (id << 30) + isn;
+   const int ps = m_PeerRec.stripe(key);
 
-   map<int64_t, set<UDTSOCKET> >::iterator i = m_PeerRec.find((id << 30) + isn);
-   if (i == m_PeerRec.end())
+   // lock order: a m_PeerRec stripe before a m_Sockets stripe, never the reverse
+   CGuard cg(m_PeerRec.lock(ps));
+
+   map<int64_t, set<UDTSOCKET> >::iterator i = m_PeerRec.bucket(ps).find(key);
+   if (i == m_PeerRec.bucket(ps).end())
       return NULL;
 
    for (set<UDTSOCKET>::iterator j = i->second.begin(); j != i->second.end(); ++ j)
    {
-      map<UDTSOCKET, CUDTSocket*>::iterator k = m_Sockets.find(*j);
+      CUDTSocket* s;
       // this socket might have been closed and moved m_ClosedSockets
-      if (k == m_Sockets.end())
+      if (!m_Sockets.find(*j, s))
          continue;
 
-      if (CIPAddress::ipcmp(peer, k->second->m_pPeerAddr, k->second->m_iIPversion))
-         return k->second;
+      if (CIPAddress::ipcmp(peer, s->m_pPeerAddr, s->m_iIPversion))
+         return s;
    }
 
    return NULL;
@@ -1183,7 +1639,9 @@ void CUDTUnited::checkBrokenSockets()
    vector<UDTSOCKET> tbc;
    vector<UDTSOCKET> tbr;
 
-   for (map<UDTSOCKET, CUDTSocket*>::iterator i = m_Sockets.begin(); i != m_Sockets.end(); ++ i)
+   // writers hold m_ControlLock, so the stripes can be walked without their own locks
+   for (int b = 0; b < m_Sockets.stripes(); ++ b)
+   for (map<UDTSOCKET, CUDTSocket*>::iterator i = m_Sockets.bucket(b).begin(); i != m_Sockets.bucket(b).end(); ++ i)
    {
       // check broken connection
       if (i->second->m_pUDT->m_bBroken)
@@ -1194,7 +1652,8 @@ void CUDTUnited::checkBrokenSockets()
             if (CTimer::getTime() - i->second->m_TimeStamp < 3000000)
                continue;
          }
-         else if ((i->second->m_pUDT->m_pRcvBuffer != NULL) && (i->second->m_pUDT->m_pRcvBuffer->getRcvDataSize() > 0) && (i->second->m_pUDT->m_iBrokenCounter -- > 0))
+         else if ((i->second->m_pUDT->m_pRcvBuffer != NULL) && ((i->second->m_pUDT->m_pRcvBuffer->getRcvDataSize() > 0) || ((NULL != i->second->m_pUDT->m_pShm) && i->second->m_pUDT->m_pShm->canRead()))
+            && (i->second->m_pUDT->m_iBrokenCounter -- > 0))
          {
             // if there is still data in the receiver buffer, wait longer
             continue;
@@ -1204,25 +1663,22 @@ void CUDTUnited::checkBrokenSockets()
          i->second->m_Status = CLOSED;
          i->second->m_TimeStamp = CTimer::getTime();
          tbc.push_back(i->first);
-         m_ClosedSockets[i->first] = i->second;
+         m_ClosedSockets.set(i->first, i->second);
 
          // remove from listener's queue
-         map<UDTSOCKET, CUDTSocket*>::iterator ls = m_Sockets.find(i->second->m_ListenSocket);
-         if (ls == m_Sockets.end())
-         {
-            ls = m_ClosedSockets.find(i->second->m_ListenSocket);
-            if (ls == m_ClosedSockets.end())
-               continue;
-         }
+         CUDTSocket* ls;
+         if (!m_Sockets.find(i->second->m_ListenSocket, ls) && !m_ClosedSockets.find(i->second->m_ListenSocket, ls))
+            continue;
 
-         CGuard::enterCS(ls->second->m_AcceptLock);
-         ls->second->m_pQueuedSockets->erase(i->second->m_SocketID);
-         ls->second->m_pAcceptSockets->erase(i->second->m_SocketID);
-         CGuard::leaveCS(ls->second->m_AcceptLock);
+         CGuard::enterCS(ls->m_AcceptLock);
+         ls->m_pQueuedSockets->erase(i->second->m_SocketID);
+         ls->m_pAcceptSockets->erase(i->second->m_SocketID);
+         CGuard::leaveCS(ls->m_AcceptLock);
       }
    }
 
-   for (map<UDTSOCKET, CUDTSocket*>::iterator j = m_ClosedSockets.begin(); j != m_ClosedSockets.end(); ++ j)
+   for (int b = 0; b < m_ClosedSockets.stripes(); ++ b)
+   for (map<UDTSOCKET, CUDTSocket*>::iterator j = m_ClosedSockets.bucket(b).begin(); j != m_ClosedSockets.bucket(b).end(); ++ j)
    {
       if (j->second->m_pUDT->m_ullLingerExpiration > 0)
       {
@@ -1253,46 +1709,54 @@ void CUDTUnited::checkBrokenSockets()
 
 void CUDTUnited::removeSocket(const UDTSOCKET u)
 {
-   map<UDTSOCKET, CUDTSocket*>::iterator i = m_ClosedSockets.find(u);
+   CUDTSocket* s;
 
    // invalid socket ID
-   if (i == m_ClosedSockets.end())
+   if (!m_ClosedSockets.find(u, s))
       return;
 
    // decrease multiplexer reference count, and remove it if necessary
-   const int mid = i->second->m_iMuxID;
+   const int mid = s->m_iMuxID;
 
-   if (NULL != i->second->m_pQueuedSockets)
+   if (NULL != s->m_pQueuedSockets)
    {
-      CGuard::enterCS(i->second->m_AcceptLock);
+      CGuard::enterCS(s->m_AcceptLock);
 
       // if it is a listener, close all un-accepted sockets in its queue and remove them later
-      for (set<UDTSOCKET>::iterator q = i->second->m_pQueuedSockets->begin(); q != i->second->m_pQueuedSockets->end(); ++ q)
+      for (set<UDTSOCKET>::iterator q = s->m_pQueuedSockets->begin(); q != s->m_pQueuedSockets->end(); ++ q)
       {
-         m_Sockets[*q]->m_pUDT->m_bBroken = true;
-         m_Sockets[*q]->m_pUDT->close();
-         m_Sockets[*q]->m_TimeStamp = CTimer::getTime();
-         m_Sockets[*q]->m_Status = CLOSED;
-         m_ClosedSockets[*q] = m_Sockets[*q];
+         CUDTSocket* qs;
+         if (!m_Sockets.find(*q, qs))
+            continue;
+
+         qs->m_pUDT->m_bBroken = true;
+         qs->m_pUDT->close();
+         qs->m_TimeStamp = CTimer::getTime();
+         qs->m_Status = CLOSED;
+         m_ClosedSockets.set(*q, qs);
          m_Sockets.erase(*q);
       }
 
-      CGuard::leaveCS(i->second->m_AcceptLock);
+      CGuard::leaveCS(s->m_AcceptLock);
    }
 
    // remove from peer rec
-   map<int64_t, set<UDTSOCKET> >::iterator j = m_PeerRec.find((i->second->m_PeerID << 30) + i->second->m_iISN);
-   if (j != m_PeerRec.end())
+   const int64_t key = (s->m_PeerID << 30) + s->m_iISN;
+   const int ps = m_PeerRec.stripe(key);
+   CGuard::enterCS(m_PeerRec.lock(ps));
+   map<int64_t, set<UDTSOCKET> >::iterator j = m_PeerRec.bucket(ps).find(key);
+   if (j != m_PeerRec.bucket(ps).end())
    {
       j->second.erase(u);
       if (j->second.empty())
-         m_PeerRec.erase(j);
+         m_PeerRec.bucket(ps).erase(j);
    }
+   CGuard::leaveCS(m_PeerRec.lock(ps));
 
-   // delete this one
-   i->second->m_pUDT->close();
-   delete i->second;
-   m_ClosedSockets.erase(i);
+   // delete this one, unpublishing it before the memory goes away
+   m_ClosedSockets.erase(u);
+   s->m_pUDT->close();
+   delete s;
 
    map<int, CMultiplexer>::iterator m;
    m = m_mMultiplexer.find(mid);
@@ -1305,11 +1769,7 @@ void CUDTUnited::removeSocket(const UDTSOCKET u)
    m->second.m_iRefCount --;
    if (0 == m->second.m_iRefCount)
    {
-      m->second.m_pChannel->close();
-      delete m->second.m_pSndQueue;
-      delete m->second.m_pRcvQueue;
-      delete m->second.m_pTimer;
-      delete m->second.m_pChannel;
+      releaseMux(m->second);
       m_mMultiplexer.erase(m);
    }
 }
@@ -1388,8 +1848,7 @@ void CUDTUnited::updateMux(CUDTSocket* s, const sockaddr* addr, const UDPSOCKET*
             {
                // reuse the existing multiplexer
                ++ i->second.m_iRefCount;
-               s->m_pUDT->m_pSndQueue = i->second.m_pSndQueue;
-               s->m_pUDT->m_pRcvQueue = i->second.m_pRcvQueue;
+               setWorker(s, i->second, CChannel::getSteering(s->m_SocketID, i->second.m_iWorkers));
                s->m_iMuxID = i->second.m_iID;
                return;
             }
@@ -1405,46 +1864,102 @@ void CUDTUnited::updateMux(CUDTSocket* s, const sockaddr* addr, const UDPSOCKET*
    m.m_bReusable = s->m_pUDT->m_bReuseAddr;
    m.m_iID = s->m_SocketID;
 
-   m.m_pChannel = new CChannel(s->m_pUDT->m_iIPversion);
-   m.m_pChannel->setSndBufSize(s->m_pUDT->m_iUDPSndBufSize);
-   m.m_pChannel->setRcvBufSize(s->m_pUDT->m_iUDPRcvBufSize);
+   // each worker has its own UDP socket on the port; a socket given by the application cannot be shared this way,
+   // and rendezvous requests, which carry no socket ID, could not reach a socket served by another worker than the first
+   m.m_iWorkers = ((NULL == udpsock) && !s->m_pUDT->m_bRendezvous) ? s->m_pUDT->m_iWorkers : 1;
+
+   m.m_pChannel = new CChannel* [m.m_iWorkers];
+   m.m_pChannel[0] = new CChannel(s->m_pUDT->m_iIPversion);
+   m.m_pChannel[0]->setSndBufSize(s->m_pUDT->m_iUDPSndBufSize);
+   m.m_pChannel[0]->setRcvBufSize(s->m_pUDT->m_iUDPRcvBufSize);
+   m.m_pChannel[0]->setOffload(s->m_pUDT->m_bUDPOffload);
+   m.m_pChannel[0]->setURing(s->m_pUDT->m_bURing);
+   m.m_pChannel[0]->setReusePort(m.m_iWorkers > 1);
 
    try
    {
       if (NULL != udpsock)
-         m.m_pChannel->open(*udpsock);
+         m.m_pChannel[0]->open(*udpsock);
       else
-         m.m_pChannel->open(addr);
+         m.m_pChannel[0]->open(addr);
    }
    catch (CUDTException& e)
    {
-      m.m_pChannel->close();
-      delete m.m_pChannel;
+      m.m_pChannel[0]->close();
+      delete m.m_pChannel[0];
+      delete [] m.m_pChannel;
       throw e;
    }
 
    sockaddr* sa = (AF_INET == s->m_pUDT->m_iIPversion) ? (sockaddr*) new sockaddr_in : (sockaddr*) new sockaddr_in6;
-   m.m_pChannel->getSockAddr(sa);
+   m.m_pChannel[0]->getSockAddr(sa);
    m.m_iPort = (AF_INET == s->m_pUDT->m_iIPversion) ? ntohs(((sockaddr_in*)sa)->sin_port) : ntohs(((sockaddr_in6*)sa)->sin6_port);
-   if (AF_INET == s->m_pUDT->m_iIPversion) delete (sockaddr_in*)sa; else delete (sockaddr_in6*)sa;
 
-   m.m_pTimer = new CTimer;
+   // the other workers join the port the first channel is bound to
+   int opened = 1;
+   for (; opened < m.m_iWorkers; ++ opened)
+   {
+      m.m_pChannel[opened] = new CChannel(s->m_pUDT->m_iIPversion);
+      m.m_pChannel[opened]->setSndBufSize(s->m_pUDT->m_iUDPSndBufSize);
+      m.m_pChannel[opened]->setRcvBufSize(s->m_pUDT->m_iUDPRcvBufSize);
+      m.m_pChannel[opened]->setOffload(s->m_pUDT->m_bUDPOffload);
+      m.m_pChannel[opened]->setURing(s->m_pUDT->m_bURing);
+      m.m_pChannel[opened]->setReusePort(true);
 
-   m.m_pSndQueue = new CSndQueue;
-   m.m_pSndQueue->init(m.m_pChannel, m.m_pTimer);
-   m.m_pRcvQueue = new CRcvQueue;
-   m.m_pRcvQueue->init(32, s->m_pUDT->m_iPayloadSize, m.m_iIPversion, 1024, m.m_pChannel, m.m_pTimer);
+      try
+      {
+         m.m_pChannel[opened]->open(sa);
+      }
+      catch (CUDTException& e)
+      {
+         m.m_pChannel[opened]->close();
+         delete m.m_pChannel[opened];
+         break;
+      }
 
-   m_mMultiplexer[m.m_iID] = m;
+      if (!m.m_pChannel[opened]->setSteering(m.m_iWorkers))
+      {
+         m.m_pChannel[opened]->close();
+         delete m.m_pChannel[opened];
+         break;
+      }
+   }
 
-   s->m_pUDT->m_pSndQueue = m.m_pSndQueue;
-   s->m_pUDT->m_pRcvQueue = m.m_pRcvQueue;
-   s->m_iMuxID = m.m_iID;
-}
+   if (AF_INET == s->m_pUDT->m_iIPversion) delete (sockaddr_in*)sa; else delete (sockaddr_in6*)sa;
 
-void CUDTUnited::updateMux(CUDTSocket* s, const CUDTSocket* ls)
-{
-   CGuard cg(m_ControlLock);
+   // without packet steering by socket ID the port cannot be shared, and a single worker serves it
+   if ((opened < m.m_iWorkers) || ((m.m_iWorkers > 1) && !m.m_pChannel[0]->setSteering(m.m_iWorkers)))
+   {
+      for (int i = 1; i < opened; ++ i)
+      {
+         m.m_pChannel[i]->close();
+         delete m.m_pChannel[i];
+      }
+      m.m_iWorkers = 1;
+   }
+
+   m.m_pTimer = new CTimer* [m.m_iWorkers];
+   m.m_pSndQueue = new CSndQueue* [m.m_iWorkers];
+   m.m_pRcvQueue = new CRcvQueue* [m.m_iWorkers];
+   for (int i = 0; i < m.m_iWorkers; ++ i)
+   {
+      m.m_pTimer[i] = new CTimer;
+
+      m.m_pSndQueue[i] = new CSndQueue;
+      m.m_pSndQueue[i]->init(m.m_pChannel[i], m.m_pTimer[i], s->m_pUDT->m_iPacingSlack);
+      m.m_pRcvQueue[i] = new CRcvQueue;
+      m.m_pRcvQueue[i]->init(32, s->m_pUDT->m_iPayloadSize, m.m_iIPversion, 1024, m.m_pChannel[i], m.m_pTimer[i]);
+   }
+
+   m_mMultiplexer[m.m_iID] = m;
+
+   setWorker(s, m, CChannel::getSteering(s->m_SocketID, m.m_iWorkers));
+   s->m_iMuxID = m.m_iID;
+}
+
+void CUDTUnited::updateMux(CUDTSocket* s, const CUDTSocket* ls)
+{
+   CGuard cg(m_ControlLock);
 
    int port = (AF_INET == ls->m_iIPversion) ? ntohs(((sockaddr_in*)ls->m_pSelfAddr)->sin_port) : ntohs(((sockaddr_in6*)ls->m_pSelfAddr)->sin6_port);
 
@@ -1455,14 +1970,56 @@ void CUDTUnited::updateMux(CUDTSocket* s, const CUDTSocket* ls)
       {
          // reuse the existing multiplexer
          ++ i->second.m_iRefCount;
-         s->m_pUDT->m_pSndQueue = i->second.m_pSndQueue;
-         s->m_pUDT->m_pRcvQueue = i->second.m_pRcvQueue;
+         setWorker(s, i->second, CChannel::getSteering(s->m_SocketID, i->second.m_iWorkers));
          s->m_iMuxID = i->second.m_iID;
          return;
       }
    }
 }
 
+void CUDTUnited::setWorker(CUDTSocket* s, const CMultiplexer& m, int worker)
+{
+   s->m_pUDT->m_pSndQueue = m.m_pSndQueue[worker];
+   s->m_pUDT->m_pRcvQueue = m.m_pRcvQueue[worker];
+}
+
+void CUDTUnited::setWorker(CUDTSocket* s, int worker)
+{
+   CGuard cg(m_ControlLock);
+
+   map<int, CMultiplexer>::iterator i = m_mMultiplexer.find(s->m_iMuxID);
+   if (i != m_mMultiplexer.end())
+      setWorker(s, i->second, worker);
+}
+
+int CUDTUnited::getWorkers(const CUDTSocket* s)
+{
+   CGuard cg(m_ControlLock);
+
+   map<int, CMultiplexer>::iterator i = m_mMultiplexer.find(s->m_iMuxID);
+   if (i == m_mMultiplexer.end())
+      return 0;
+
+   return i->second.m_iWorkers;
+}
+
+void CUDTUnited::releaseMux(CMultiplexer& m)
+{
+   for (int i = 0; i < m.m_iWorkers; ++ i)
+   {
+      m.m_pChannel[i]->close();
+      delete m.m_pSndQueue[i];
+      delete m.m_pRcvQueue[i];
+      delete m.m_pTimer[i];
+      delete m.m_pChannel[i];
+   }
+
+   delete [] m.m_pSndQueue;
+   delete [] m.m_pRcvQueue;
+   delete [] m.m_pTimer;
+   delete [] m.m_pChannel;
+}
+
 #ifndef WIN32
    void* CUDTUnited::garbageCollect(void* p)
 #else
@@ -1494,33 +2051,44 @@ void CUDTUnited::updateMux(CUDTSocket* s, const CUDTSocket* ls)
       #endif
    }
 
+   // the listeners stop first, a request being answered needs m_ControlLock; only this thread frees sockets
+   vector<CUDTSocket*> listeners;
+   CGuard::enterCS(self->m_ControlLock);
+   for (int b = 0; b < self->m_Sockets.stripes(); ++ b)
+   for (map<UDTSOCKET, CUDTSocket*>::iterator i = self->m_Sockets.bucket(b).begin(); i != self->m_Sockets.bucket(b).end(); ++ i)
+   {
+      if (LISTENING == i->second->m_Status)
+         listeners.push_back(i->second);
+   }
+   CGuard::leaveCS(self->m_ControlLock);
+   for (vector<CUDTSocket*>::iterator l = listeners.begin(); l != listeners.end(); ++ l)
+      (*l)->m_pUDT->stopListening();
+
    // remove all sockets and multiplexers
    CGuard::enterCS(self->m_ControlLock);
-   for (map<UDTSOCKET, CUDTSocket*>::iterator i = self->m_Sockets.begin(); i != self->m_Sockets.end(); ++ i)
+   for (int b = 0; b < self->m_Sockets.stripes(); ++ b)
+   for (map<UDTSOCKET, CUDTSocket*>::iterator i = self->m_Sockets.bucket(b).begin(); i != self->m_Sockets.bucket(b).end(); ++ i)
    {
       i->second->m_pUDT->m_bBroken = true;
       i->second->m_pUDT->close();
       i->second->m_Status = CLOSED;
       i->second->m_TimeStamp = CTimer::getTime();
-      self->m_ClosedSockets[i->first] = i->second;
+      self->m_ClosedSockets.set(i->first, i->second);
 
       // remove from listener's queue
-      map<UDTSOCKET, CUDTSocket*>::iterator ls = self->m_Sockets.find(i->second->m_ListenSocket);
-      if (ls == self->m_Sockets.end())
-      {
-         ls = self->m_ClosedSockets.find(i->second->m_ListenSocket);
-         if (ls == self->m_ClosedSockets.end())
-            continue;
-      }
+      CUDTSocket* ls;
+      if (!self->m_Sockets.find(i->second->m_ListenSocket, ls) && !self->m_ClosedSockets.find(i->second->m_ListenSocket, ls))
+         continue;
 
-      CGuard::enterCS(ls->second->m_AcceptLock);
-      ls->second->m_pQueuedSockets->erase(i->second->m_SocketID);
-      ls->second->m_pAcceptSockets->erase(i->second->m_SocketID);
-      CGuard::leaveCS(ls->second->m_AcceptLock);
+      CGuard::enterCS(ls->m_AcceptLock);
+      ls->m_pQueuedSockets->erase(i->second->m_SocketID);
+      ls->m_pAcceptSockets->erase(i->second->m_SocketID);
+      CGuard::leaveCS(ls->m_AcceptLock);
    }
    self->m_Sockets.clear();
 
-   for (map<UDTSOCKET, CUDTSocket*>::iterator j = self->m_ClosedSockets.begin(); j != self->m_ClosedSockets.end(); ++ j)
+   for (int b = 0; b < self->m_ClosedSockets.stripes(); ++ b)
+   for (map<UDTSOCKET, CUDTSocket*>::iterator j = self->m_ClosedSockets.bucket(b).begin(); j != self->m_ClosedSockets.bucket(b).end(); ++ j)
    {
       j->second->m_TimeStamp = 0;
    }
@@ -1530,9 +2098,7 @@ void CUDTUnited::updateMux(CUDTSocket* s, const CUDTSocket* ls)
    {
       self->checkBrokenSockets();
 
-      CGuard::enterCS(self->m_ControlLock);
       bool empty = self->m_ClosedSockets.empty();
-      CGuard::leaveCS(self->m_ControlLock);
 
       if (empty)
          break;
@@ -1559,6 +2125,24 @@ int CUDT::cleanup()
    return s_UDTUnited.cleanup();
 }
 
+int CUDT::setcachefile(const char* path, int maxage)
+{
+   try
+   {
+      return s_UDTUnited.setCacheFile(path, maxage);
+   }
+   catch (CUDTException& e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
 UDTSOCKET CUDT::socket(int af, int type, int)
 {
    if (!s_UDTUnited.m_bGCStatus)
@@ -1576,22 +2160,348 @@ UDTSOCKET CUDT::socket(int af, int type, int)
    catch (bad_alloc&)
    {
       s_UDTUnited.setError(new CUDTException(3, 2, 0));
-      return INVALID_SOCK;
+      return INVALID_SOCK;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return INVALID_SOCK;
+   }
+}
+
+int CUDT::bind(UDTSOCKET u, const sockaddr* name, int namelen)
+{
+   try
+   {
+      return s_UDTUnited.bind(u, name, namelen);
+   }
+   catch (CUDTException& e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (bad_alloc&)
+   {
+      s_UDTUnited.setError(new CUDTException(3, 2, 0));
+      return ERROR;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
+int CUDT::bind(UDTSOCKET u, UDPSOCKET udpsock)
+{
+   try
+   {
+      return s_UDTUnited.bind(u, udpsock);
+   }
+   catch (CUDTException& e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (bad_alloc&)
+   {
+      s_UDTUnited.setError(new CUDTException(3, 2, 0));
+      return ERROR;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
+int CUDT::listen(UDTSOCKET u, int backlog)
+{
+   try
+   {
+      return s_UDTUnited.listen(u, backlog);
+   }
+   catch (CUDTException& e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (bad_alloc&)
+   {
+      s_UDTUnited.setError(new CUDTException(3, 2, 0));
+      return ERROR;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
+UDTSOCKET CUDT::accept(UDTSOCKET u, sockaddr* addr, int* addrlen)
+{
+   try
+   {
+      return s_UDTUnited.accept(u, addr, addrlen);
+   }
+   catch (CUDTException& e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return INVALID_SOCK;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return INVALID_SOCK;
+   }
+}
+
+int CUDT::connect(UDTSOCKET u, const sockaddr* name, int namelen)
+{
+   try
+   {
+      return s_UDTUnited.connect(u, name, namelen);
+   }
+   catch (CUDTException e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (bad_alloc&)
+   {
+      s_UDTUnited.setError(new CUDTException(3, 2, 0));
+      return ERROR;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
+int CUDT::close(UDTSOCKET u)
+{
+   try
+   {
+      return s_UDTUnited.close(u);
+   }
+   catch (CUDTException e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
+int CUDT::getpeername(UDTSOCKET u, sockaddr* name, int* namelen)
+{
+   try
+   {
+      return s_UDTUnited.getpeername(u, name, namelen);
+   }
+   catch (CUDTException e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
+int CUDT::getsockname(UDTSOCKET u, sockaddr* name, int* namelen)
+{
+   try
+   {
+      return s_UDTUnited.getsockname(u, name, namelen);;
+   }
+   catch (CUDTException e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
+int CUDT::getsockopt(UDTSOCKET u, int, UDTOpt optname, void* optval, int* optlen)
+{
+   try
+   {
+      CUDT* udt = s_UDTUnited.lookup(u);
+      udt->getOpt(optname, optval, *optlen);
+      return 0;
+   }
+   catch (CUDTException e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
+int CUDT::setsockopt(UDTSOCKET u, int, UDTOpt optname, const void* optval, int optlen)
+{
+   try
+   {
+      CUDT* udt = s_UDTUnited.lookup(u);
+      udt->setOpt(optname, optval, optlen);
+      return 0;
+   }
+   catch (CUDTException e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
+int CUDT::send(UDTSOCKET u, const char* buf, int len, int)
+{
+   try
+   {
+      CUDT* udt = s_UDTUnited.lookup(u);
+      return udt->send(buf, len);
+   }
+   catch (CUDTException e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (bad_alloc&)
+   {
+      s_UDTUnited.setError(new CUDTException(3, 2, 0));
+      return ERROR;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
+int CUDT::recv(UDTSOCKET u, char* buf, int len, int)
+{
+   try
+   {
+      CUDT* udt = s_UDTUnited.lookup(u);
+      return udt->recv(buf, len);
+   }
+   catch (CUDTException e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
+int CUDT::sendmsg(UDTSOCKET u, const char* buf, int len, int ttl, bool inorder)
+{
+   try
+   {
+      CUDT* udt = s_UDTUnited.lookup(u);
+      return udt->sendmsg(buf, len, ttl, inorder);
+   }
+   catch (CUDTException e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (bad_alloc&)
+   {
+      s_UDTUnited.setError(new CUDTException(3, 2, 0));
+      return ERROR;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
+int CUDT::recvmsg(UDTSOCKET u, char* buf, int len)
+{
+   try
+   {
+      CUDT* udt = s_UDTUnited.lookup(u);
+      return udt->recvmsg(buf, len);
+   }
+   catch (CUDTException e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
+int CUDT::sendframe(UDTSOCKET u, const char* buf, int len, uint16_t frame_id, int64_t deadline_us, UDTFRAMEDONE callback, void* context)
+{
+   try
+   {
+      CUDT* udt = s_UDTUnited.lookup(u);
+      return udt->sendframe(buf, len, frame_id, deadline_us, callback, context);
+   }
+   catch (CUDTException e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (bad_alloc&)
+   {
+      s_UDTUnited.setError(new CUDTException(3, 2, 0));
+      return ERROR;
    }
    catch (...)
    {
       s_UDTUnited.setError(new CUDTException(-1, 0, 0));
-      return INVALID_SOCK;
+      return ERROR;
    }
 }
 
-int CUDT::bind(UDTSOCKET u, const sockaddr* name, int namelen)
+int CUDT::sendframe_layered(UDTSOCKET u, const char* buf, const int* layers, int nlayers, int required, uint16_t frame_id, int64_t deadline_us)
 {
    try
    {
-      return s_UDTUnited.bind(u, name, namelen);
+      if ((NULL == layers) || (nlayers <= 0) || (nlayers > 255) || (required <= 0) || (required > nlayers))
+         throw CUDTException(5, 3, 0);
+
+      int len = 0;
+      for (int i = 0; i < nlayers; ++ i)
+      {
+         if (layers[i] <= 0)
+            throw CUDTException(5, 3, 0);
+         len += layers[i];
+      }
+
+      CUDT* udt = s_UDTUnited.lookup(u);
+      return udt->sendframe(buf, len, frame_id, deadline_us, NULL, NULL, true, layers, nlayers, required);
    }
-   catch (CUDTException& e)
+   catch (CUDTException e)
    {
       s_UDTUnited.setError(new CUDTException(e));
       return ERROR;
@@ -1608,22 +2518,18 @@ int CUDT::bind(UDTSOCKET u, const sockaddr* name, int namelen)
    }
 }
 
-int CUDT::bind(UDTSOCKET u, UDPSOCKET udpsock)
+int CUDT::recvframe(UDTSOCKET u, char* buf, int len, uint16_t& frame_id, bool& complete)
 {
    try
    {
-      return s_UDTUnited.bind(u, udpsock);
+      CUDT* udt = s_UDTUnited.lookup(u);
+      return udt->recvframe(buf, len, frame_id, complete);
    }
-   catch (CUDTException& e)
+   catch (CUDTException e)
    {
       s_UDTUnited.setError(new CUDTException(e));
       return ERROR;
    }
-   catch (bad_alloc&)
-   {
-      s_UDTUnited.setError(new CUDTException(3, 2, 0));
-      return ERROR;
-   }
    catch (...)
    {
       s_UDTUnited.setError(new CUDTException(-1, 0, 0));
@@ -1631,22 +2537,20 @@ int CUDT::bind(UDTSOCKET u, UDPSOCKET udpsock)
    }
 }
 
-int CUDT::listen(UDTSOCKET u, int backlog)
+int CUDT::recvmsg_zc(UDTSOCKET u, const UDT_IOVEC*& iov, int& iovcnt, int& handle)
 {
    try
    {
-      return s_UDTUnited.listen(u, backlog);
+      CUDT* udt = s_UDTUnited.lookup(u);
+      uint16_t frame_id;
+      bool complete;
+      return udt->recvzc(false, iov, iovcnt, frame_id, complete, handle);
    }
-   catch (CUDTException& e)
+   catch (CUDTException e)
    {
       s_UDTUnited.setError(new CUDTException(e));
       return ERROR;
    }
-   catch (bad_alloc&)
-   {
-      s_UDTUnited.setError(new CUDTException(3, 2, 0));
-      return ERROR;
-   }
    catch (...)
    {
       s_UDTUnited.setError(new CUDTException(-1, 0, 0));
@@ -1654,38 +2558,54 @@ int CUDT::listen(UDTSOCKET u, int backlog)
    }
 }
 
-UDTSOCKET CUDT::accept(UDTSOCKET u, sockaddr* addr, int* addrlen)
+int CUDT::recvframe_zc(UDTSOCKET u, const UDT_IOVEC*& iov, int& iovcnt, uint16_t& frame_id, bool& complete, int& handle)
 {
    try
    {
-      return s_UDTUnited.accept(u, addr, addrlen);
+      CUDT* udt = s_UDTUnited.lookup(u);
+      return udt->recvzc(true, iov, iovcnt, frame_id, complete, handle);
    }
-   catch (CUDTException& e)
+   catch (CUDTException e)
    {
       s_UDTUnited.setError(new CUDTException(e));
-      return INVALID_SOCK;
+      return ERROR;
    }
    catch (...)
    {
       s_UDTUnited.setError(new CUDTException(-1, 0, 0));
-      return INVALID_SOCK;
+      return ERROR;
    }
 }
 
-int CUDT::connect(UDTSOCKET u, const sockaddr* name, int namelen)
+int CUDT::release_zc(UDTSOCKET u, int handle)
 {
    try
    {
-      return s_UDTUnited.connect(u, name, namelen);
+      CUDT* udt = s_UDTUnited.lookup(u);
+      udt->release_zc(handle);
+      return 0;
    }
    catch (CUDTException e)
    {
       s_UDTUnited.setError(new CUDTException(e));
       return ERROR;
    }
-   catch (bad_alloc&)
+   catch (...)
    {
-      s_UDTUnited.setError(new CUDTException(3, 2, 0));
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
+int CUDT::fanout_create()
+{
+   try
+   {
+      return s_UDTUnited.fanout_create();
+   }
+   catch (CUDTException e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
       return ERROR;
    }
    catch (...)
@@ -1695,11 +2615,11 @@ int CUDT::connect(UDTSOCKET u, const sockaddr* name, int namelen)
    }
 }
 
-int CUDT::close(UDTSOCKET u)
+int CUDT::fanout_add(const int gid, UDTSOCKET u)
 {
    try
    {
-      return s_UDTUnited.close(u);
+      return s_UDTUnited.fanout_add(gid, u);
    }
    catch (CUDTException e)
    {
@@ -1713,11 +2633,11 @@ int CUDT::close(UDTSOCKET u)
    }
 }
 
-int CUDT::getpeername(UDTSOCKET u, sockaddr* name, int* namelen)
+int CUDT::fanout_remove(const int gid, UDTSOCKET u)
 {
    try
    {
-      return s_UDTUnited.getpeername(u, name, namelen);
+      return s_UDTUnited.fanout_remove(gid, u);
    }
    catch (CUDTException e)
    {
@@ -1731,17 +2651,22 @@ int CUDT::getpeername(UDTSOCKET u, sockaddr* name, int* namelen)
    }
 }
 
-int CUDT::getsockname(UDTSOCKET u, sockaddr* name, int* namelen)
+int CUDT::fanout_sendframe(const int gid, const char* buf, int len, uint16_t frame_id, int64_t deadline_us)
 {
    try
    {
-      return s_UDTUnited.getsockname(u, name, namelen);;
+      return s_UDTUnited.fanout_sendframe(gid, buf, len, frame_id, deadline_us);
    }
    catch (CUDTException e)
    {
       s_UDTUnited.setError(new CUDTException(e));
       return ERROR;
    }
+   catch (bad_alloc&)
+   {
+      s_UDTUnited.setError(new CUDTException(3, 2, 0));
+      return ERROR;
+   }
    catch (...)
    {
       s_UDTUnited.setError(new CUDTException(-1, 0, 0));
@@ -1749,13 +2674,11 @@ int CUDT::getsockname(UDTSOCKET u, sockaddr* name, int* namelen)
    }
 }
 
-int CUDT::getsockopt(UDTSOCKET u, int, UDTOpt optname, void* optval, int* optlen)
+int CUDT::fanout_release(const int gid)
 {
    try
    {
-      CUDT* udt = s_UDTUnited.lookup(u);
-      udt->getOpt(optname, optval, *optlen);
-      return 0;
+      return s_UDTUnited.fanout_release(gid);
    }
    catch (CUDTException e)
    {
@@ -1769,13 +2692,11 @@ int CUDT::getsockopt(UDTSOCKET u, int, UDTOpt optname, void* optval, int* optlen
    }
 }
 
-int CUDT::setsockopt(UDTSOCKET u, int, UDTOpt optname, const void* optval, int optlen)
+int CUDT::mpath_create()
 {
    try
    {
-      CUDT* udt = s_UDTUnited.lookup(u);
-      udt->setOpt(optname, optval, optlen);
-      return 0;
+      return s_UDTUnited.mpath_create();
    }
    catch (CUDTException e)
    {
@@ -1789,21 +2710,33 @@ int CUDT::setsockopt(UDTSOCKET u, int, UDTOpt optname, const void* optval, int o
    }
 }
 
-int CUDT::send(UDTSOCKET u, const char* buf, int len, int)
+int CUDT::mpath_add(const int mid, UDTSOCKET u)
 {
    try
    {
-      CUDT* udt = s_UDTUnited.lookup(u);
-      return udt->send(buf, len);
+      return s_UDTUnited.mpath_add(mid, u);
    }
    catch (CUDTException e)
    {
       s_UDTUnited.setError(new CUDTException(e));
       return ERROR;
    }
-   catch (bad_alloc&)
+   catch (...)
    {
-      s_UDTUnited.setError(new CUDTException(3, 2, 0));
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
+int CUDT::mpath_remove(const int mid, UDTSOCKET u)
+{
+   try
+   {
+      return s_UDTUnited.mpath_remove(mid, u);
+   }
+   catch (CUDTException e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
       return ERROR;
    }
    catch (...)
@@ -1813,18 +2746,22 @@ int CUDT::send(UDTSOCKET u, const char* buf, int len, int)
    }
 }
 
-int CUDT::recv(UDTSOCKET u, char* buf, int len, int)
+int CUDT::mpath_sendframe(const int mid, const char* buf, int len, uint16_t frame_id, int64_t deadline_us)
 {
    try
    {
-      CUDT* udt = s_UDTUnited.lookup(u);
-      return udt->recv(buf, len);
+      return s_UDTUnited.mpath_sendframe(mid, buf, len, frame_id, deadline_us);
    }
    catch (CUDTException e)
    {
       s_UDTUnited.setError(new CUDTException(e));
       return ERROR;
    }
+   catch (bad_alloc&)
+   {
+      s_UDTUnited.setError(new CUDTException(3, 2, 0));
+      return ERROR;
+   }
    catch (...)
    {
       s_UDTUnited.setError(new CUDTException(-1, 0, 0));
@@ -1832,12 +2769,11 @@ int CUDT::recv(UDTSOCKET u, char* buf, int len, int)
    }
 }
 
-int CUDT::sendmsg(UDTSOCKET u, const char* buf, int len, int ttl, bool inorder)
+int CUDT::mpath_recvframe(const int mid, char* buf, int len, uint16_t& frame_id, bool& complete)
 {
    try
    {
-      CUDT* udt = s_UDTUnited.lookup(u);
-      return udt->sendmsg(buf, len, ttl, inorder);
+      return s_UDTUnited.mpath_recvframe(mid, buf, len, frame_id, complete);
    }
    catch (CUDTException e)
    {
@@ -1856,12 +2792,11 @@ int CUDT::sendmsg(UDTSOCKET u, const char* buf, int len, int ttl, bool inorder)
    }
 }
 
-int CUDT::recvmsg(UDTSOCKET u, char* buf, int len)
+int CUDT::mpath_release(const int mid)
 {
    try
    {
-      CUDT* udt = s_UDTUnited.lookup(u);
-      return udt->recvmsg(buf, len);
+      return s_UDTUnited.mpath_release(mid);
    }
    catch (CUDTException e)
    {
@@ -1918,6 +2853,85 @@ int64_t CUDT::recvfile(UDTSOCKET u, fstream& ofs, int64_t& offset, int64_t size,
    }
 }
 
+int64_t CUDT::sendfile2(UDTSOCKET u, const char* path, int64_t* offset, int64_t size, int block)
+{
+   #ifndef WIN32
+      // the fast path maps the file instead of reading it through a stream
+      int fd = -1;
+      try
+      {
+         CUDT* udt = s_UDTUnited.lookup(u);
+         fd = ::open(path, O_RDONLY);
+         if (fd < 0)
+            throw CUDTException(4, 2, errno);
+         int64_t ret = udt->sendfile(fd, *offset, size, block);
+         ::close(fd);
+         return ret;
+      }
+      catch (CUDTException e)
+      {
+         if (fd >= 0)
+            ::close(fd);
+         s_UDTUnited.setError(new CUDTException(e));
+         return ERROR;
+      }
+      catch (bad_alloc&)
+      {
+         if (fd >= 0)
+            ::close(fd);
+         s_UDTUnited.setError(new CUDTException(3, 2, 0));
+         return ERROR;
+      }
+      catch (...)
+      {
+         if (fd >= 0)
+            ::close(fd);
+         s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+         return ERROR;
+      }
+   #else
+      fstream ifs(path, ios::binary | ios::in);
+      int64_t ret = sendfile(u, ifs, *offset, size, block);
+      ifs.close();
+      return ret;
+   #endif
+}
+
+int64_t CUDT::recvfile2(UDTSOCKET u, const char* path, int64_t* offset, int64_t size, int block)
+{
+   #ifndef WIN32
+      // an unopened file fails on the first write, which also stops the sender
+      int fd = -1;
+      try
+      {
+         CUDT* udt = s_UDTUnited.lookup(u);
+         fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+         int64_t ret = udt->recvfile(fd, *offset, size, block);
+         ::close(fd);
+         return ret;
+      }
+      catch (CUDTException e)
+      {
+         if (fd >= 0)
+            ::close(fd);
+         s_UDTUnited.setError(new CUDTException(e));
+         return ERROR;
+      }
+      catch (...)
+      {
+         if (fd >= 0)
+            ::close(fd);
+         s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+         return ERROR;
+      }
+   #else
+      fstream ofs(path, ios::binary | ios::out);
+      int64_t ret = recvfile(u, ofs, *offset, size, block);
+      ofs.close();
+      return ret;
+   #endif
+}
+
 int CUDT::select(int, ud_set* readfds, ud_set* writefds, ud_set* exceptfds, const timeval* timeout)
 {
    if ((NULL == readfds) && (NULL == writefds) && (NULL == exceptfds))
@@ -2084,6 +3098,24 @@ int CUDT::epoll_wait(const int eid, set<UDTSOCKET>* readfds, set<UDTSOCKET>* wri
    }
 }
 
+int CUDT::epoll_wait2(const int eid, UDT_EPOLL_EVENT* events, int max, int64_t msTimeOut)
+{
+   try
+   {
+      return s_UDTUnited.epoll_wait2(eid, events, max, msTimeOut);
+   }
+   catch (CUDTException e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
 int CUDT::epoll_release(const int eid)
 {
    try
@@ -2127,6 +3159,49 @@ int CUDT::perfmon(UDTSOCKET u, CPerfMon* perf, bool clear)
    }
 }
 
+int CUDT::acceptstats(UDTSOCKET u, CAcceptStats* stats, bool clear)
+{
+   try
+   {
+      CUDT* udt = s_UDTUnited.lookup(u);
+      udt->sampleAccept(stats, clear);
+      return 0;
+   }
+   catch (CUDTException e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
+int CUDT::getframetrace(UDTSOCKET u, CFrameEvent* events, int num, int* overflow)
+{
+   try
+   {
+      CUDT* udt = s_UDTUnited.lookup(u);
+      int lost;
+      int ret = udt->getFrameTrace(events, num, lost);
+      if (NULL != overflow)
+         *overflow = lost;
+      return ret;
+   }
+   catch (CUDTException e)
+   {
+      s_UDTUnited.setError(new CUDTException(e));
+      return ERROR;
+   }
+   catch (...)
+   {
+      s_UDTUnited.setError(new CUDTException(-1, 0, 0));
+      return ERROR;
+   }
+}
+
 CUDT* CUDT::getUDTHandle(UDTSOCKET u)
 {
    try
@@ -2189,6 +3264,11 @@ int cleanup()
    return CUDT::cleanup();
 }
 
+int setcachefile(const char* path, int maxage)
+{
+   return CUDT::setcachefile(path, maxage);
+}
+
 UDTSOCKET socket(int af, int type, int protocol)
 {
    return CUDT::socket(af, type, protocol);
@@ -2276,18 +3356,12 @@ int64_t recvfile(UDTSOCKET u, fstream& ofs, int64_t& offset, int64_t size, int b
 
 int64_t sendfile2(UDTSOCKET u, const char* path, int64_t* offset, int64_t size, int block)
 {
-   fstream ifs(path, ios::binary | ios::in);
-   int64_t ret = CUDT::sendfile(u, ifs, *offset, size, block);
-   ifs.close();
-   return ret;
+   return CUDT::sendfile2(u, path, offset, size, block);
 }
 
 int64_t recvfile2(UDTSOCKET u, const char* path, int64_t* offset, int64_t size, int block)
 {
-   fstream ofs(path, ios::binary | ios::out);
-   int64_t ret = CUDT::recvfile(u, ofs, *offset, size, block);
-   ofs.close();
-   return ret;
+   return CUDT::recvfile2(u, path, offset, size, block);
 }
 
 int select(int nfds, UDSET* readfds, UDSET* writefds, UDSET* exceptfds, const struct timeval* timeout)
@@ -2380,6 +3454,11 @@ int epoll_wait2(int eid, UDTSOCKET* readfds, int* rnum, UDTSOCKET* writefds, int
    return ret;
 }
 
+int epoll_wait2(int eid, UDT_EPOLL_EVENT* events, int max, int64_t msTimeOut)
+{
+   return CUDT::epoll_wait2(eid, events, max, msTimeOut);
+}
+
 int epoll_release(int eid)
 {
    return CUDT::epoll_release(eid);
@@ -2405,6 +3484,11 @@ int perfmon(UDTSOCKET u, TRACEINFO* perf, bool clear)
    return CUDT::perfmon(u, perf, clear);
 }
 
+int acceptstats(UDTSOCKET u, ACCEPTINFO* stats, bool clear)
+{
+   return CUDT::acceptstats(u, stats, clear);
+}
+
 UDTSTATUS getsockstate(UDTSOCKET u)
 {
    return CUDT::getsockstate(u);
@@ -2417,4 +3501,94 @@ int set_next_frame_metadata(UDTSOCKET u, uint16_t frame_id, uint8_t chunk_id,
    return CUDT::set_next_frame_metadata(u, frame_id, chunk_id, total_chunks, deadline_us);
 }
 
+int sendframe(UDTSOCKET u, const char* buf, int len, uint16_t frame_id, int64_t deadline_us, FRAMEDONE callback, void* context)
+{
+   return CUDT::sendframe(u, buf, len, frame_id, deadline_us, callback, context);
+}
+
+int sendframe_layered(UDTSOCKET u, const char* buf, const int* layers, int nlayers, int required, uint16_t frame_id, int64_t deadline_us)
+{
+   return CUDT::sendframe_layered(u, buf, layers, nlayers, required, frame_id, deadline_us);
+}
+
+int recvframe(UDTSOCKET u, char* buf, int len, uint16_t& frame_id, bool& complete)
+{
+   return CUDT::recvframe(u, buf, len, frame_id, complete);
+}
+
+int recvmsg_zc(UDTSOCKET u, const UDT_IOVEC*& iov, int& iovcnt, int& handle)
+{
+   return CUDT::recvmsg_zc(u, iov, iovcnt, handle);
+}
+
+int recvframe_zc(UDTSOCKET u, const UDT_IOVEC*& iov, int& iovcnt, uint16_t& frame_id, bool& complete, int& handle)
+{
+   return CUDT::recvframe_zc(u, iov, iovcnt, frame_id, complete, handle);
+}
+
+int release_zc(UDTSOCKET u, int handle)
+{
+   return CUDT::release_zc(u, handle);
+}
+
+int fanout_create()
+{
+   return CUDT::fanout_create();
+}
+
+int fanout_add(int gid, UDTSOCKET u)
+{
+   return CUDT::fanout_add(gid, u);
+}
+
+int fanout_remove(int gid, UDTSOCKET u)
+{
+   return CUDT::fanout_remove(gid, u);
+}
+
+int fanout_sendframe(int gid, const char* buf, int len, uint16_t frame_id, int64_t deadline_us)
+{
+   return CUDT::fanout_sendframe(gid, buf, len, frame_id, deadline_us);
+}
+
+int fanout_release(int gid)
+{
+   return CUDT::fanout_release(gid);
+}
+
+int mpath_create()
+{
+   return CUDT::mpath_create();
+}
+
+int mpath_add(int mid, UDTSOCKET u)
+{
+   return CUDT::mpath_add(mid, u);
+}
+
+int mpath_remove(int mid, UDTSOCKET u)
+{
+   return CUDT::mpath_remove(mid, u);
+}
+
+int mpath_sendframe(int mid, const char* buf, int len, uint16_t frame_id, int64_t deadline_us)
+{
+   return CUDT::mpath_sendframe(mid, buf, len, frame_id, deadline_us);
+}
+
+int mpath_recvframe(int mid, char* buf, int len, uint16_t& frame_id, bool& complete)
+{
+   return CUDT::mpath_recvframe(mid, buf, len, frame_id, complete);
+}
+
+int mpath_release(int mid)
+{
+   return CUDT::mpath_release(mid);
+}
+
+int getframetrace(UDTSOCKET u, FRAMEEVENT* events, int num, int* overflow)
+{
+   return CUDT::getframetrace(u, events, num, overflow);
+}
+
 }  // namespace UDT
@@ -49,9 +49,133 @@ written by
 #include "queue.h"
 #include "cache.h"
 #include "epoll.h"
+#include "fanout.h"
+#include "multipath.h"
 
 class CUDT;
 
+// A map split into lock-striped buckets. Lookups only take the lock of the bucket the key
+// hashes to, so the receiving threads resolving socket IDs neither contend with each other
+// nor with the API threads. Structural changes are still serialized by the owner's control
+// lock, which also allows the owner to walk the buckets without taking the bucket locks.
+
+template <class K, class V>
+class CStripedMap
+{
+public:
+   typedef std::map<K, V> Bucket;
+
+public:
+   CStripedMap()
+   {
+      for (int i = 0; i < m_iStripes; ++ i)
+         CGuard::createMutex(m_pLock[i]);
+   }
+
+   ~CStripedMap()
+   {
+      for (int i = 0; i < m_iStripes; ++ i)
+         CGuard::releaseMutex(m_pLock[i]);
+   }
+
+public:
+
+      // Functionality:
+      //    Look up a key.
+      // Parameters:
+      //    0) [in] key: the key to be found.
+      //    1) [out] val: the value stored for the key.
+      // Returned value:
+      //    true if found, otherwise false.
+
+   bool find(const K& key, V& val)
+   {
+      const int s = stripe(key);
+      CGuard cg(m_pLock[s]);
+
+      typename Bucket::iterator i = m_pBucket[s].find(key);
+      if (i == m_pBucket[s].end())
+         return false;
+
+      val = i->second;
+      return true;
+   }
+
+      // Functionality:
+      //    Insert a key or overwrite its value. The caller must hold the owner's control lock.
+      // Parameters:
+      //    0) [in] key: the key.
+      //    1) [in] val: the value.
+      // Returned value:
+      //    None.
+
+   void set(const K& key, const V& val)
+   {
+      const int s = stripe(key);
+      CGuard cg(m_pLock[s]);
+      m_pBucket[s][key] = val;
+   }
+
+      // Functionality:
+      //    Remove a key. The caller must hold the owner's control lock.
+      // Parameters:
+      //    0) [in] key: the key.
+      // Returned value:
+      //    None.
+
+   void erase(const K& key)
+   {
+      const int s = stripe(key);
+      CGuard cg(m_pLock[s]);
+      m_pBucket[s].erase(key);
+   }
+
+   void clear()
+   {
+      for (int i = 0; i < m_iStripes; ++ i)
+      {
+         CGuard cg(m_pLock[i]);
+         m_pBucket[i].clear();
+      }
+   }
+
+   bool empty()
+   {
+      for (int i = 0; i < m_iStripes; ++ i)
+      {
+         CGuard cg(m_pLock[i]);
+         if (!m_pBucket[i].empty())
+            return false;
+      }
+      return true;
+   }
+
+public:
+   // Direct bucket access, for walking all entries under the owner's control lock or for
+   // compound updates of a value under the bucket lock.
+
+   static int stripes() {return m_iStripes;}
+   Bucket& bucket(int s) {return m_pBucket[s];}
+   pthread_mutex_t& lock(int s) {return m_pLock[s];}
+
+   static int stripe(const K& key)
+   {
+      // Fibonacci hashing: consecutive socket IDs land on different stripes
+      return (int)(((uint64_t)key * 0x9E3779B97F4A7C15ULL) >> (64 - m_iStripeBits));
+   }
+
+private:
+   static const int m_iStripeBits = 6;
+   static const int m_iStripes = 1 << m_iStripeBits;
+
+   Bucket m_pBucket[m_iStripes];
+   pthread_mutex_t m_pLock[m_iStripes];
+
+private:
+   CStripedMap(const CStripedMap&);
+   CStripedMap& operator=(const CStripedMap&);
+};
+
 class CUDTSocket
 {
 public:
@@ -122,6 +246,16 @@ public:
 
    int cleanup();
 
+      // Functionality:
+      //    Keep the path information in a file shared with the other processes of the host.
+      // Parameters:
+      //    0) [in] path: the file.
+      //    1) [in] maxage: age of the records that are not used any more, in seconds.
+      // Returned value:
+      //    0 if success, otherwise an exception is thrown.
+
+   int setCacheFile(const char* path, int maxage);
+
       // Functionality:
       //    Create a new UDT socket.
       // Parameters:
@@ -179,7 +313,19 @@ public:
    int epoll_remove_usock(const int eid, const UDTSOCKET u);
    int epoll_remove_ssock(const int eid, const SYSSOCKET s);
    int epoll_wait(const int eid, std::set<UDTSOCKET>* readfds, std::set<UDTSOCKET>* writefds, int64_t msTimeOut, std::set<SYSSOCKET>* lrfds = NULL, std::set<SYSSOCKET>* lwfds = NULL);
+   int epoll_wait2(const int eid, UDT_EPOLL_EVENT* events, int max, int64_t msTimeOut);
    int epoll_release(const int eid);
+   int fanout_create();
+   int fanout_add(const int gid, const UDTSOCKET u);
+   int fanout_remove(const int gid, const UDTSOCKET u);
+   int fanout_sendframe(const int gid, const char* data, int len, uint16_t frame_id, int64_t deadline_us);
+   int fanout_release(const int gid);
+   int mpath_create();
+   int mpath_add(const int mid, const UDTSOCKET u);
+   int mpath_remove(const int mid, const UDTSOCKET u);
+   int mpath_sendframe(const int mid, const char* data, int len, uint16_t frame_id, int64_t deadline_us);
+   int mpath_recvframe(const int mid, char* data, int len, uint16_t& frame_id, bool& complete);
+   int mpath_release(const int mid);
 
       // Functionality:
       //    record the UDT exception.
@@ -203,14 +349,14 @@ private:
 //   void init();
 
 private:
-   std::map<UDTSOCKET, CUDTSocket*> m_Sockets;       // stores all the socket structures
+   CStripedMap<UDTSOCKET, CUDTSocket*> m_Sockets;    // stores all the socket structures
 
-   pthread_mutex_t m_ControlLock;                    // used to synchronize UDT API
+   pthread_mutex_t m_ControlLock;                    // used to synchronize UDT API and structural changes of the socket tables
 
    pthread_mutex_t m_IDLock;                         // used to synchronize ID generation
    UDTSOCKET m_SocketID;                             // seed to generate a new unique socket ID
 
-   std::map<int64_t, std::set<UDTSOCKET> > m_PeerRec;// record sockets from peers to avoid repeated connection request, int64_t = (socker_id << 30) + isn
+   CStripedMap<int64_t, std::set<UDTSOCKET> > m_PeerRec;// record sockets from peers to avoid repeated connection request, int64_t = (socker_id << 30) + isn
 
 private:
    pthread_key_t m_TLSError;                         // thread local error record (last error)
@@ -228,6 +374,10 @@ private:
    CUDTSocket* locate(const sockaddr* peer, const UDTSOCKET id, int32_t isn);
    void updateMux(CUDTSocket* s, const sockaddr* addr = NULL, const UDPSOCKET* = NULL);
    void updateMux(CUDTSocket* s, const CUDTSocket* ls);
+   void setWorker(CUDTSocket* s, const CMultiplexer& m, int worker);
+   void setWorker(CUDTSocket* s, int worker);
+   int getWorkers(const CUDTSocket* s);
+   void releaseMux(CMultiplexer& m);
 
 private:
    std::map<int, CMultiplexer> m_mMultiplexer;		// UDP multiplexer
@@ -235,6 +385,7 @@ private:
 
 private:
    CCache<CInfoBlock>* m_pCache;			// UDT network information cache
+   CSharedInfoCache* m_pSharedCache;			// network information shared with the other processes, NULL if not used
 
 private:
    volatile bool m_bClosing;
@@ -252,13 +403,15 @@ private:
       static DWORD WINAPI garbageCollect(LPVOID);
    #endif
 
-   std::map<UDTSOCKET, CUDTSocket*> m_ClosedSockets;   // temporarily store closed sockets
+   CStripedMap<UDTSOCKET, CUDTSocket*> m_ClosedSockets;// temporarily store closed sockets
 
    void checkBrokenSockets();
    void removeSocket(const UDTSOCKET u);
 
 private:
    CEPoll m_EPoll;                                     // handling epoll data structures and events
+   CFanout m_Fanout;                                   // fan-out groups
+   CMultipath m_Multipath;                             // multipath sessions
 
 private:
    CUDTUnited(const CUDTUnited&);
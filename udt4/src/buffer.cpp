@@ -38,13 +38,64 @@ written by
    Yunhong Gu, last updated 03/12/2011
 *****************************************************************************/
 
+#ifndef WIN32
+   #include <unistd.h>
+   #include <sys/mman.h>
+   #include <sys/stat.h>
+#endif
 #include <cstring>
 #include <cmath>
 #include "buffer.h"
 
 using namespace std;
 
-CSndBuffer::CSndBuffer(int size, int mss):
+const int CFrameFEC::m_iHdrSize = 4;
+
+int CFrameFEC::getGroups(int chunks, double loss)
+{
+   // a group of g chunks loses more than the one chunk its parity rebuilds with a probability of about (g * loss)^2 / 2
+   int groups = int(ceil(4.0 * chunks * loss));
+   if (groups < 1)
+      groups = 1;
+
+   // a group of a single chunk is a plain copy, and parity chunk IDs must still fit into 8 bits
+   if (groups > (chunks + 1) / 2)
+      groups = (chunks + 1) / 2;
+   if (groups > 256 - chunks)
+      groups = 256 - chunks;
+
+   return (groups > 0) ? groups : 0;
+}
+
+void CFrameFEC::writeHeader(char* parity, int group, int groups, int lenxor)
+{
+   parity[0] = char(group);
+   parity[1] = char(groups);
+   parity[2] = char(lenxor >> 8);
+   parity[3] = char(lenxor);
+}
+
+bool CFrameFEC::readHeader(const char* parity, int len, int& group, int& groups, int& lenxor)
+{
+   if (len <= m_iHdrSize)
+      return false;
+
+   group = (unsigned char)parity[0];
+   groups = (unsigned char)parity[1];
+   lenxor = ((unsigned char)parity[2] << 8) | (unsigned char)parity[3];
+
+   return group < groups;
+}
+
+void CFrameFEC::xorData(char* dst, const char* src, int len)
+{
+   for (int i = 0; i < len; ++ i)
+      dst[i] ^= src[i];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+CSndBuffer::CSndBuffer(int size, int mss, int32_t maxmsgno):
 m_BufLock(),
 m_pBlock(NULL),
 m_pFirstBlock(NULL),
@@ -52,9 +103,12 @@ m_pCurrBlock(NULL),
 m_pLastBlock(NULL),
 m_pBuffer(NULL),
 m_iNextMsgNo(1),
+m_iMaxMsgNo(maxmsgno),
 m_iSize(size),
 m_iMSS(mss),
-m_iCount(0)
+m_iCount(0),
+m_iAckRetrans(0),
+m_bAckDropped(false)
 {
    // initial physical buffer of "size"
    m_pBuffer = new Buffer;
@@ -68,12 +122,6 @@ m_iCount(0)
    for (int i = 1; i < m_iSize; ++ i)
    {
       pb->m_pNext = new Block;
-      pb->m_iMsgNo = 0;
-      // VR Frame Awareness: Initialize frame metadata
-      pb->m_iFrameID = 0;
-      pb->m_iChunkID = 0;
-      pb->m_iTotalChunks = 0;
-      pb->m_iFrameDeadline = 0;
       pb = pb->m_pNext;
    }
    pb->m_pNext = m_pBlock;
@@ -82,7 +130,15 @@ m_iCount(0)
    char* pc = m_pBuffer->m_pcData;
    for (int i = 0; i < m_iSize; ++ i)
    {
-      pb->m_pcData = pc;
+      pb->m_pcData = pb->m_pcStorage = pc;
+      pb->m_pZeroCopy = NULL;
+      pb->m_iMsgNo = 0;
+      // VR Frame Awareness: Initialize frame metadata
+      pb->m_iFrameID = 0;
+      pb->m_iChunkID = 0;
+      pb->m_iTotalChunks = 0;
+      pb->m_iFrameDeadline = 0;
+      pb->m_iRetrans = 0;
       pb = pb->m_pNext;
       pc += m_iMSS;
    }
@@ -98,7 +154,22 @@ m_iCount(0)
 
 CSndBuffer::~CSndBuffer()
 {
-   Block* pb = m_pBlock->m_pNext;
+   // frames still referenced are given back to the application
+   ZeroCopy* done = NULL;
+   Block* pb = m_pFirstBlock;
+   for (int i = 0; i < m_iCount; ++ i)
+   {
+      release(done, pb->m_pZeroCopy);
+      pb = pb->m_pNext;
+   }
+   for (ZeroCopy* zc = done; NULL != zc; zc = done)
+   {
+      done = zc->m_pNext;
+      zc->m_pCallback(zc->m_iSocket, zc->m_pcData, zc->m_iLength, zc->m_pContext);
+      delete zc;
+   }
+
+   pb = m_pBlock->m_pNext;
    while (pb != m_pBlock)
    {
       Block* temp = pb;
@@ -162,18 +233,178 @@ void CSndBuffer::addBuffer(const char* data, int len, int ttl, bool order,
       s->m_iChunkID = chunk_id;
       s->m_iTotalChunks = total_chunks;
       s->m_iFrameDeadline = frame_deadline;
+      s->m_iLayer = 0;
+      s->m_iRequired = total_chunks;
+      s->m_bLayerEnd = (chunk_id + 1 == total_chunks);
+      s->m_iRetrans = 0;
 
       s = s->m_pNext;
    }
+   CGuard::memoryBarrier();
    m_pLastBlock = s;
 
-   CGuard::enterCS(m_BufLock);
-   m_iCount += size;
-   CGuard::leaveCS(m_BufLock);
+   CGuard::atomicAdd(m_iCount, size);
+
+   m_iNextMsgNo ++;
+   if (m_iNextMsgNo == m_iMaxMsgNo)
+      m_iNextMsgNo = 1;
+}
+
+int CSndBuffer::addFrame(const char* data, int len, uint16_t frame_id, int64_t frame_deadline, int ttl, bool order, int parity)
+{
+   return insertFrame(data, len, frame_id, frame_deadline, ttl, order, NULL, parity);
+}
+
+int CSndBuffer::addFrameRef(const char* data, int len, uint16_t frame_id, int64_t frame_deadline, UDTSOCKET u, UDTFRAMEDONE callback, void* context, int parity)
+{
+   ZeroCopy* zc = new ZeroCopy;
+   zc->m_iSocket = u;
+   zc->m_pcData = data;
+   zc->m_iLength = len;
+   zc->m_pCallback = callback;
+   zc->m_pContext = context;
+   zc->m_iRefCount = 0;
+   zc->m_pNext = NULL;
+
+   try
+   {
+      return insertFrame(data, len, frame_id, frame_deadline, -1, true, zc, parity);
+   }
+   catch (...)
+   {
+      delete zc;
+      throw;
+   }
+}
+
+int CSndBuffer::addLayeredFrame(const char* data, const int* layers, int nlayers, int required, uint16_t frame_id, int64_t frame_deadline)
+{
+   int len = 0;
+   for (int i = 0; i < nlayers; ++ i)
+      len += layers[i];
+
+   return insertFrame(data, len, frame_id, frame_deadline, -1, true, NULL, 0, layers, nlayers, required);
+}
+
+int CSndBuffer::countLayerChunks(const int* layers, int nlayers, int chunk)
+{
+   int size = 0;
+   for (int i = 0; i < nlayers; ++ i)
+      size += (layers[i] + chunk - 1) / chunk;
+
+   return size;
+}
+
+int CSndBuffer::insertFrame(const char* data, int len, uint16_t frame_id, int64_t frame_deadline, int ttl, bool order, ZeroCopy* zc, int parity,
+                            const int* layers, int nlayers, int required)
+{
+   // with parity, data chunks leave room for the parity header in a block
+   int chunk = (parity > 0) ? m_iMSS - CFrameFEC::m_iHdrSize : m_iMSS;
+   int size = len / chunk;
+   if ((len % chunk) != 0)
+      size ++;
+
+   // with layers, each chunk stays within one layer, so that the frame can be cut at any layer boundary;
+   // without them, the whole frame is required
+   int reqchunks = size;
+   if (nlayers > 0)
+   {
+      size = countLayerChunks(layers, nlayers, chunk);
+      reqchunks = (required < nlayers) ? countLayerChunks(layers, required, chunk) : size;
+   }
+
+   // dynamically increase sender buffer
+   while (size + parity + m_iCount >= m_iSize)
+      increase();
+
+   uint64_t time = CTimer::getTime();
+   int32_t inorder = order;
+   inorder <<= 29;
+
+   if (NULL != zc)
+      zc->m_iRefCount = size;
+
+   int layer = 0;               // layer of the next chunk
+   int start = 0;               // offset of that layer in the frame
+   int pos = 0;                 // offset of the next chunk in the frame
+
+   Block* s = m_pLastBlock;
+   for (int i = 0; i < size + parity; ++ i)
+   {
+      s->m_iLayer = 0;
+      s->m_bLayerEnd = (i == size - 1);
+
+      if (i < size)
+      {
+         int pktlen = ((nlayers > 0) ? start + layers[layer] : len) - pos;
+         if (pktlen > chunk)
+            pktlen = chunk;
+
+         if (NULL == zc)
+            memcpy(s->m_pcData, data + pos, pktlen);
+         else
+         {
+            s->m_pcData = (char*)data + pos;
+            s->m_pZeroCopy = zc;
+         }
+         s->m_iLength = pktlen;
+
+         pos += pktlen;
+         if (nlayers > 0)
+         {
+            s->m_iLayer = layer;
+            s->m_bLayerEnd = (pos == start + layers[layer]);
+            if (s->m_bLayerEnd)
+               start += layers[layer ++];
+         }
+      }
+      else
+      {
+         // parity chunk of group g, in the block's own storage
+         int g = i - size;
+         int lenxor = 0;
+         s->m_iLength = CFrameFEC::m_iHdrSize;
+         memset(s->m_pcData + CFrameFEC::m_iHdrSize, 0, chunk);
+         for (int j = g; j < size; j += parity)
+         {
+            int pktlen = (j < size - 1) ? chunk : len - j * chunk;
+            CFrameFEC::xorData(s->m_pcData + CFrameFEC::m_iHdrSize, data + j * chunk, pktlen);
+            lenxor ^= pktlen;
+            if (CFrameFEC::m_iHdrSize + pktlen > s->m_iLength)
+               s->m_iLength = CFrameFEC::m_iHdrSize + pktlen;
+         }
+         CFrameFEC::writeHeader(s->m_pcData, g, parity, lenxor);
+      }
+
+      s->m_iMsgNo = m_iNextMsgNo | inorder;
+      if (i == 0)
+         s->m_iMsgNo |= 0x80000000;
+      if (i == size + parity - 1)
+         s->m_iMsgNo |= 0x40000000;
+
+      s->m_OriginTime = time;
+      s->m_iTTL = ttl;
+
+      // each block is one chunk of the frame, parity chunks follow the data chunks
+      s->m_iFrameID = frame_id;
+      s->m_iChunkID = i;
+      s->m_iTotalChunks = size;
+      s->m_iFrameDeadline = frame_deadline;
+      s->m_iRequired = reqchunks;
+      s->m_iRetrans = 0;
+
+      s = s->m_pNext;
+   }
+   CGuard::memoryBarrier();
+   m_pLastBlock = s;
+
+   CGuard::atomicAdd(m_iCount, size + parity);
 
    m_iNextMsgNo ++;
-   if (m_iNextMsgNo == CMsgNo::m_iMaxMsgNo)
+   if (m_iNextMsgNo == m_iMaxMsgNo)
       m_iNextMsgNo = 1;
+
+   return size;
 }
 
 int CSndBuffer::addBufferFromFile(fstream& ifs, int len)
@@ -210,29 +441,133 @@ int CSndBuffer::addBufferFromFile(fstream& ifs, int len)
 
       s->m_iLength = pktlen;
       s->m_iTTL = -1;
+
+      // VR Frame Awareness: file data is not part of any frame
+      s->m_iFrameID = 0;
+      s->m_iChunkID = 0;
+      s->m_iTotalChunks = 0;
+      s->m_iFrameDeadline = 0;
+      s->m_iRetrans = 0;
+
       s = s->m_pNext;
 
       total += pktlen;
    }
+   CGuard::memoryBarrier();
    m_pLastBlock = s;
 
-   CGuard::enterCS(m_BufLock);
-   m_iCount += size;
-   CGuard::leaveCS(m_BufLock);
+   CGuard::atomicAdd(m_iCount, size);
 
    m_iNextMsgNo ++;
-   if (m_iNextMsgNo == CMsgNo::m_iMaxMsgNo)
+   if (m_iNextMsgNo == m_iMaxMsgNo)
       m_iNextMsgNo = 1;
 
    return total;
 }
 
+#ifndef WIN32
+static void unmapFile(UDTSOCKET, const char* data, int len, void*)
+{
+   munmap((void*)data, len);
+}
+
+int CSndBuffer::addBufferFromFile(int fd, int64_t offset, int len)
+{
+   if (len <= 0)
+      return 0;
+
+   int size = len / m_iMSS;
+   if ((len % m_iMSS) != 0)
+      size ++;
+
+   // dynamically increase sender buffer
+   while (size + m_iCount >= m_iSize)
+      increase();
+
+   // the mapping starts at the page boundary below "offset"; it is released like a referenced frame.
+   // Pages past the end of the file fault (SIGBUS) when read, so only a regular file that holds the whole block now
+   // is mapped; a shorter one is read with pread, which reports the short file instead.
+   static const int64_t page = sysconf(_SC_PAGESIZE);
+   const int delta = int(offset % page);
+   char* map = (char*)MAP_FAILED;
+   struct stat st;
+   if ((0 == fstat(fd, &st)) && S_ISREG(st.st_mode) && (offset + len <= (int64_t)st.st_size))
+      map = (char*)mmap(NULL, len + delta, PROT_READ, MAP_SHARED, fd, offset - delta);
+
+   ZeroCopy* zc = NULL;
+   if (MAP_FAILED != map)
+   {
+      madvise(map, len + delta, MADV_SEQUENTIAL);
+
+      zc = new ZeroCopy;
+      zc->m_iSocket = 0;
+      zc->m_pcData = map;
+      zc->m_iLength = len + delta;
+      zc->m_pCallback = unmapFile;
+      zc->m_pContext = NULL;
+      zc->m_iRefCount = size;
+      zc->m_pNext = NULL;
+   }
+
+   Block* s = m_pLastBlock;
+   for (int i = 0; i < size; ++ i)
+   {
+      int pktlen = len - i * m_iMSS;
+      if (pktlen > m_iMSS)
+         pktlen = m_iMSS;
+
+      if (NULL != zc)
+      {
+         s->m_pcData = map + delta + i * m_iMSS;
+         s->m_pZeroCopy = zc;
+      }
+      else if (pread(fd, s->m_pcData, pktlen, offset + i * m_iMSS) != pktlen)
+      {
+         // nothing has been published yet
+         return -1;
+      }
+
+      // currently file transfer is only available in streaming mode, message is always in order, ttl = infinite
+      s->m_iMsgNo = m_iNextMsgNo | 0x20000000;
+      if (i == 0)
+         s->m_iMsgNo |= 0x80000000;
+      if (i == size - 1)
+         s->m_iMsgNo |= 0x40000000;
+
+      s->m_iLength = pktlen;
+      s->m_iTTL = -1;
+
+      // VR Frame Awareness: file data is not part of any frame
+      s->m_iFrameID = 0;
+      s->m_iChunkID = 0;
+      s->m_iTotalChunks = 0;
+      s->m_iFrameDeadline = 0;
+      s->m_iRetrans = 0;
+
+      s = s->m_pNext;
+   }
+   CGuard::memoryBarrier();
+   m_pLastBlock = s;
+
+   CGuard::atomicAdd(m_iCount, size);
+
+   m_iNextMsgNo ++;
+   if (m_iNextMsgNo == m_iMaxMsgNo)
+      m_iNextMsgNo = 1;
+
+   return len;
+}
+#endif
+
 int CSndBuffer::readData(char** data, int32_t& msgno)
 {
    // No data to read
    if (m_pCurrBlock == m_pLastBlock)
       return 0;
 
+   // the block is read only after m_pLastBlock has published it
+   CGuard::memoryBarrier();
+
    *data = m_pCurrBlock->m_pcData;
    int readlen = m_pCurrBlock->m_iLength;
    msgno = m_pCurrBlock->m_iMsgNo;
@@ -244,12 +579,16 @@ int CSndBuffer::readData(char** data, int32_t& msgno)
 
 int CSndBuffer::readData(char** data, int32_t& msgno,
                          uint16_t& frame_id, uint8_t& chunk_id,
-                         uint8_t& total_chunks, int64_t& frame_deadline)
+                         uint8_t& total_chunks, int64_t& frame_deadline,
+                         uint8_t& layer, uint8_t& required, bool& layerend)
 {
    // No data to read
    if (m_pCurrBlock == m_pLastBlock)
       return 0;
 
+   // the block is read only after m_pLastBlock has published it
+   CGuard::memoryBarrier();
+
    *data = m_pCurrBlock->m_pcData;
    int readlen = m_pCurrBlock->m_iLength;
    msgno = m_pCurrBlock->m_iMsgNo;
@@ -259,6 +598,9 @@ int CSndBuffer::readData(char** data, int32_t& msgno,
    chunk_id = m_pCurrBlock->m_iChunkID;
    total_chunks = m_pCurrBlock->m_iTotalChunks;
    frame_deadline = m_pCurrBlock->m_iFrameDeadline;
+   layer = m_pCurrBlock->m_iLayer;
+   required = m_pCurrBlock->m_iRequired;
+   layerend = m_pCurrBlock->m_bLayerEnd;
 
    m_pCurrBlock = m_pCurrBlock->m_pNext;
 
@@ -298,12 +640,17 @@ int CSndBuffer::readData(char** data, const int offset, int32_t& msgno, int& msg
    int readlen = p->m_iLength;
    msgno = p->m_iMsgNo;
 
+   // VR Frame Awareness: offsets are only read again for retransmission
+   if (p->m_iRetrans >= 0)
+      ++ p->m_iRetrans;
+
    return readlen;
 }
 
 int CSndBuffer::readData(char** data, const int offset, int32_t& msgno, int& msglen,
                          uint16_t& frame_id, uint8_t& chunk_id,
-                         uint8_t& total_chunks, int64_t& frame_deadline)
+                         uint8_t& total_chunks, int64_t& frame_deadline,
+                         uint8_t& layer, uint8_t& required, bool& layerend)
 {
    CGuard bufferguard(m_BufLock);
 
@@ -336,119 +683,351 @@ int CSndBuffer::readData(char** data, const int offset, int32_t& msgno, int& msg
    int readlen = p->m_iLength;
    msgno = p->m_iMsgNo;
 
+   // VR Frame Awareness: offsets are only read again for retransmission
+   if (p->m_iRetrans >= 0)
+      ++ p->m_iRetrans;
+
    // VR Frame Awareness: Retrieve metadata from block (for retransmissions too)
    frame_id = p->m_iFrameID;
    chunk_id = p->m_iChunkID;
    total_chunks = p->m_iTotalChunks;
    frame_deadline = p->m_iFrameDeadline;
+   layer = p->m_iLayer;
+   required = p->m_iRequired;
+   layerend = p->m_bLayerEnd;
 
    return readlen;
 }
 
-void CSndBuffer::ackData(int offset)
+int CSndBuffer::dropExpiredFrame(const int offset, const int64_t& now, int& first, int32_t& msgno, uint16_t& frame_id)
 {
-   CGuard bufferguard(m_BufLock);
-
-   for (int i = 0; i < offset; ++ i)
-      m_pFirstBlock = m_pFirstBlock->m_pNext;
-
-   m_iCount -= offset;
-
-   CTimer::triggerEvent();
+   return dropFrame(offset, &now, first, msgno, frame_id);
 }
 
-int CSndBuffer::getCurrBufSize() const
+int CSndBuffer::dropFrame(const int offset, int& first, int32_t& msgno, uint16_t& frame_id)
 {
-   return m_iCount;
+   return dropFrame(offset, NULL, first, msgno, frame_id);
 }
 
-void CSndBuffer::increase()
+int CSndBuffer::dropFrame(const int offset, const int64_t* now, int& first, int32_t& msgno, uint16_t& frame_id)
 {
-   int unitsize = m_pBuffer->m_iSize;
+   CGuard bufferguard(m_BufLock);
 
-   // new physical buffer
-   Buffer* nbuf = NULL;
-   try
-   {
-      nbuf  = new Buffer;
-      nbuf->m_pcData = new char [unitsize * m_iMSS];
-   }
-   catch (...)
+   if ((offset < 0) || (offset >= m_iCount))
+      return 0;
+
+   // locate the block, remembering where its frame starts among the unacknowledged blocks
+   Block* p = m_pFirstBlock;
+   Block* head = p;
+   first = 0;
+   bool move = (p == m_pCurrBlock);
+   for (int i = 1; i <= offset; ++ i)
    {
-      delete nbuf;
-      throw CUDTException(3, 2, 0);
+      p = p->m_pNext;
+      if ((p->m_iFrameID != head->m_iFrameID) || (p->m_iFrameDeadline != head->m_iFrameDeadline))
+      {
+         head = p;
+         first = i;
+      }
+      if (p == m_pCurrBlock)
+         move = true;
    }
-   nbuf->m_iSize = unitsize;
-   nbuf->m_pNext = NULL;
 
-   // insert the buffer at the end of the buffer list
-   Buffer* p = m_pBuffer;
-   while (NULL != p->m_pNext)
-      p = p->m_pNext;
-   p->m_pNext = nbuf;
+   // without a time, the frame is dropped unconditionally
+   if ((NULL != now) && ((p->m_iFrameDeadline <= 0) || (*now <= p->m_iFrameDeadline)))
+      return 0;
 
-   // new packet blocks
-   Block* nblk = NULL;
-   try
-   {
-      nblk = new Block;
-   }
-   catch (...)
-   {
-      delete nblk;
-      throw CUDTException(3, 2, 0);
-   }
-   Block* pb = nblk;
-   for (int i = 1; i < unitsize; ++ i)
+   msgno = head->m_iMsgNo & 0x1FFFFFFF;
+   frame_id = head->m_iFrameID;
+
+   // extend the drop to the last block of the frame that is already in the buffer
+   int last = offset;
+   while ((last + 1 < m_iCount) && (p->m_pNext->m_iFrameID == head->m_iFrameID) && (p->m_pNext->m_iFrameDeadline == head->m_iFrameDeadline))
    {
-      pb->m_pNext = new Block;
-      pb = pb->m_pNext;
+      p = p->m_pNext;
+      if (p == m_pCurrBlock)
+         move = true;
+      ++ last;
    }
 
-   // insert the new blocks onto the existing one
-   pb->m_pNext = m_pLastBlock->m_pNext;
-   m_pLastBlock->m_pNext = nblk;
-
-   pb = nblk;
-   char* pc = nbuf->m_pcData;
-   for (int i = 0; i < unitsize; ++ i)
+   // the frame is not counted as acknowledged when its blocks are released
+   for (Block* b = head; ; b = b->m_pNext)
    {
-      pb->m_pcData = pc;
-      pb = pb->m_pNext;
-      pc += m_iMSS;
+      b->m_iRetrans = -1;
+      if (b == p)
+         break;
    }
 
-   m_iSize += unitsize;
-}
-
-////////////////////////////////////////////////////////////////////////////////
+   // blocks that have not been sent yet are skipped
+   if (move)
+      m_pCurrBlock = p->m_pNext;
 
-CRcvBuffer::CRcvBuffer(CUnitQueue* queue, int bufsize):
-m_pUnit(NULL),
-m_iSize(bufsize),
-m_pUnitQueue(queue),
-m_iStartPos(0),
-m_iLastAckPos(0),
-m_iMaxPos(0),
-m_iNotch(0)
-{
-   m_pUnit = new CUnit* [m_iSize];
-   for (int i = 0; i < m_iSize; ++ i)
-      m_pUnit[i] = NULL;
+   return last - first + 1;
 }
 
-CRcvBuffer::~CRcvBuffer()
+bool CSndBuffer::getFrameDeadline(const int offset, int64_t& deadline)
 {
-   for (int i = 0; i < m_iSize; ++ i)
-   {
-      if (NULL != m_pUnit[i])
-      {
-         m_pUnit[i]->m_iFlag = 0;
-         -- m_pUnitQueue->m_iCount;
-      }
-   }
+   CGuard bufferguard(m_BufLock);
+
+   if ((offset < 0) || (offset >= m_iCount))
+      return false;
+
+   Block* p = m_pFirstBlock;
+   for (int i = 0; i < offset; ++ i)
+      p = p->m_pNext;
+
+   deadline = p->m_iFrameDeadline;
+
+   return true;
+}
+
+bool CSndBuffer::getLayerInfo(const int offset, int& chunk, int& total, int& required, int& layer, int64_t& deadline)
+{
+   CGuard bufferguard(m_BufLock);
+
+   if ((offset < 0) || (offset >= m_iCount))
+      return false;
+
+   Block* p = m_pFirstBlock;
+   for (int i = 0; i < offset; ++ i)
+      p = p->m_pNext;
+
+   chunk = p->m_iChunkID;
+   total = p->m_iTotalChunks;
+   required = p->m_iRequired;
+   layer = p->m_iLayer;
+   deadline = p->m_iFrameDeadline;
+
+   return true;
+}
+
+int CSndBuffer::shedLayers(const int offset, int32_t& msgno, uint16_t& frame_id)
+{
+   CGuard bufferguard(m_BufLock);
+
+   if ((offset < 0) || (offset >= m_iCount))
+      return 0;
+
+   Block* p = m_pFirstBlock;
+   for (int i = 0; i < offset; ++ i)
+      p = p->m_pNext;
+   bool move = (p == m_pCurrBlock);
+
+   // only the optional data chunks; those of a frame dropped at its deadline are gone already
+   if ((p->m_iChunkID < p->m_iRequired) || (p->m_iChunkID >= p->m_iTotalChunks) || (p->m_iRetrans < 0))
+      return 0;
+
+   msgno = p->m_iMsgNo & 0x1FFFFFFF;
+   frame_id = p->m_iFrameID;
+
+   // the optional layers are at the end of the frame, so are the chunks to shed
+   int last = offset;
+   while ((last + 1 < m_iCount) && (p->m_pNext->m_iFrameID == frame_id) && (p->m_pNext->m_iChunkID > p->m_iChunkID) &&
+          (p->m_pNext->m_iChunkID < p->m_iTotalChunks))
+   {
+      p = p->m_pNext;
+      if (p == m_pCurrBlock)
+         move = true;
+      ++ last;
+   }
+
+   // chunks that have not been sent yet are skipped
+   if (move)
+      m_pCurrBlock = p->m_pNext;
+
+   return last - offset + 1;
+}
+
+void CSndBuffer::ackData(int offset, CFrameStats* stats, pthread_mutex_t* statslock)
+{
+   ZeroCopy* done = NULL;
+   uint64_t now = (NULL != stats) ? CTimer::getTime() : 0;
+
+   CGuard::enterCS(m_BufLock);
+
+   for (int i = 0; i < offset; ++ i)
+   {
+      // VR Frame Awareness: a frame is counted when its last block, the last parity chunk if any, is released
+      Block* b = m_pFirstBlock;
+      if (b->m_iTotalChunks > 0)
+      {
+         if ((0 == b->m_iChunkID) && (0 != (b->m_iMsgNo & 0x80000000)))
+         {
+            m_iAckRetrans = 0;
+            m_bAckDropped = false;
+         }
+
+         if (b->m_iRetrans < 0)
+            m_bAckDropped = true;
+         else
+            m_iAckRetrans += b->m_iRetrans;
+
+         if ((0 != (b->m_iMsgNo & 0x40000000)) && (b->m_iChunkID + 1 >= b->m_iTotalChunks) && (NULL != stats))
+         {
+            // only the update is under the statistics lock, the zero-copy callbacks below run without it
+            if (NULL != statslock)
+               CGuard::enterCS(*statslock);
+            if (m_bAckDropped)
+               stats->miss();
+            else
+               stats->complete(int64_t(now - b->m_OriginTime), m_iAckRetrans);
+            if (NULL != statslock)
+               CGuard::leaveCS(*statslock);
+         }
+      }
+
+      // VR Frame Awareness: a block referencing an application frame gets its own storage back
+      if (NULL != m_pFirstBlock->m_pZeroCopy)
+      {
+         release(done, m_pFirstBlock->m_pZeroCopy);
+         m_pFirstBlock->m_pZeroCopy = NULL;
+         m_pFirstBlock->m_pcData = m_pFirstBlock->m_pcStorage;
+      }
+
+      m_pFirstBlock = m_pFirstBlock->m_pNext;
+   }
+
+   // the blocks are handed back to the application thread only after they have been released
+   CGuard::atomicAdd(m_iCount, -offset);
+
+   CGuard::leaveCS(m_BufLock);
+
+   // the callbacks run without the buffer lock, but on the receiving thread under the socket's ACK lock: they must not send
+   while (NULL != done)
+   {
+      ZeroCopy* zc = done;
+      done = zc->m_pNext;
+      zc->m_pCallback(zc->m_iSocket, zc->m_pcData, zc->m_iLength, zc->m_pContext);
+      delete zc;
+   }
+
+   CTimer::triggerEvent();
+}
+
+void CSndBuffer::release(ZeroCopy*& done, ZeroCopy* zc)
+{
+   if ((NULL == zc) || (-- zc->m_iRefCount > 0))
+      return;
+
+   // the frame is released with its last block, callbacks are called in release order
+   ZeroCopy** p = &done;
+   while (NULL != *p)
+      p = &(*p)->m_pNext;
+   *p = zc;
+}
+
+int CSndBuffer::getCurrBufSize() const
+{
+   return m_iCount;
+}
+
+void CSndBuffer::increase()
+{
+   int unitsize = m_pBuffer->m_iSize;
+
+   // new physical buffer
+   Buffer* nbuf = NULL;
+   try
+   {
+      nbuf  = new Buffer;
+      nbuf->m_pcData = new char [unitsize * m_iMSS];
+   }
+   catch (...)
+   {
+      delete nbuf;
+      throw CUDTException(3, 2, 0);
+   }
+   nbuf->m_iSize = unitsize;
+   nbuf->m_pNext = NULL;
+
+   // insert the buffer at the end of the buffer list
+   Buffer* p = m_pBuffer;
+   while (NULL != p->m_pNext)
+      p = p->m_pNext;
+   p->m_pNext = nbuf;
+
+   // new packet blocks
+   Block* nblk = NULL;
+   try
+   {
+      nblk = new Block;
+   }
+   catch (...)
+   {
+      delete nblk;
+      throw CUDTException(3, 2, 0);
+   }
+   Block* pb = nblk;
+   for (int i = 1; i < unitsize; ++ i)
+   {
+      pb->m_pNext = new Block;
+      pb = pb->m_pNext;
+   }
+
+   // insert the new blocks onto the existing one
+   pb->m_pNext = m_pLastBlock->m_pNext;
+   m_pLastBlock->m_pNext = nblk;
+
+   pb = nblk;
+   char* pc = nbuf->m_pcData;
+   for (int i = 0; i < unitsize; ++ i)
+   {
+      pb->m_pcData = pb->m_pcStorage = pc;
+      pb->m_pZeroCopy = NULL;
+      pb->m_iMsgNo = 0;
+      pb->m_iFrameID = 0;
+      pb->m_iChunkID = 0;
+      pb->m_iTotalChunks = 0;
+      pb->m_iFrameDeadline = 0;
+      pb->m_iRetrans = 0;
+      pb = pb->m_pNext;
+      pc += m_iMSS;
+   }
+
+   m_iSize += unitsize;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+CRcvBuffer::CRcvBuffer(CUnitQueue* queue, int bufsize):
+m_pUnit(NULL),
+m_iSize(bufsize),
+m_pUnitQueue(queue),
+m_iStartPos(0),
+m_iLastAckPos(0),
+m_iMaxPos(0),
+m_iNotch(0),
+m_iLentUnits(0),
+m_LendLock()
+{
+   m_pUnit = new CUnit* [m_iSize];
+   for (int i = 0; i < m_iSize; ++ i)
+      m_pUnit[i] = NULL;
+
+   #ifndef WIN32
+      pthread_mutex_init(&m_LendLock, NULL);
+   #else
+      m_LendLock = CreateMutex(NULL, false, NULL);
+   #endif
+}
+
+CRcvBuffer::~CRcvBuffer()
+{
+   for (int i = 0; i < m_iSize; ++ i)
+   {
+      if (NULL != m_pUnit[i])
+      {
+         m_pUnitQueue->makeUnitFree(m_pUnit[i]);
+      }
+   }
 
    delete [] m_pUnit;
+
+   #ifndef WIN32
+      pthread_mutex_destroy(&m_LendLock);
+   #else
+      CloseHandle(m_LendLock);
+   #endif
 }
 
 int CRcvBuffer::addData(CUnit* unit, int offset)
@@ -463,7 +1042,6 @@ int CRcvBuffer::addData(CUnit* unit, int offset)
    m_pUnit[pos] = unit;
 
    unit->m_iFlag = 1;
-   ++ m_pUnitQueue->m_iCount;
 
    return 0;
 }
@@ -476,6 +1054,15 @@ int CRcvBuffer::readBuffer(char* data, int len)
 
    while ((p != lastack) && (rs > 0))
    {
+      // skip packets that the sender has dropped (e.g., an expired VR frame)
+      if (NULL == m_pUnit[p])
+      {
+         if (++ p == m_iSize)
+            p = 0;
+         m_iNotch = 0;
+         continue;
+      }
+
       int unitsize = m_pUnit[p]->m_Packet.getLength() - m_iNotch;
       if (unitsize > rs)
          unitsize = rs;
@@ -487,8 +1074,7 @@ int CRcvBuffer::readBuffer(char* data, int len)
       {
          CUnit* tmp = m_pUnit[p];
          m_pUnit[p] = NULL;
-         tmp->m_iFlag = 0;
-         -- m_pUnitQueue->m_iCount;
+         m_pUnitQueue->makeUnitFree(tmp);
 
          if (++ p == m_iSize)
             p = 0;
@@ -513,6 +1099,15 @@ int CRcvBuffer::readBufferToFile(fstream& ofs, int len)
 
    while ((p != lastack) && (rs > 0))
    {
+      // skip packets that the sender has dropped (e.g., an expired VR frame)
+      if (NULL == m_pUnit[p])
+      {
+         if (++ p == m_iSize)
+            p = 0;
+         m_iNotch = 0;
+         continue;
+      }
+
       int unitsize = m_pUnit[p]->m_Packet.getLength() - m_iNotch;
       if (unitsize > rs)
          unitsize = rs;
@@ -525,8 +1120,7 @@ int CRcvBuffer::readBufferToFile(fstream& ofs, int len)
       {
          CUnit* tmp = m_pUnit[p];
          m_pUnit[p] = NULL;
-         tmp->m_iFlag = 0;
-         -- m_pUnitQueue->m_iCount;
+         m_pUnitQueue->makeUnitFree(tmp);
 
          if (++ p == m_iSize)
             p = 0;
@@ -544,6 +1138,93 @@ int CRcvBuffer::readBufferToFile(fstream& ofs, int len)
    return len - rs;
 }
 
+#ifndef WIN32
+int CRcvBuffer::readBufferToFile(int fd, int64_t offset, int len)
+{
+   const int maxvec = 64;
+   iovec vec[maxvec];
+   int n = 0;
+
+   int p = m_iStartPos;
+   int lastack = m_iLastAckPos;
+   int notch = m_iNotch;
+   int rs = len;
+
+   // gather the payloads in place, skipping packets that the sender has dropped
+   while ((p != lastack) && (rs > 0) && (n < maxvec))
+   {
+      if (NULL != m_pUnit[p])
+      {
+         int unitsize = m_pUnit[p]->m_Packet.getLength() - notch;
+         if (unitsize > rs)
+            unitsize = rs;
+
+         vec[n].iov_base = m_pUnit[p]->m_Packet.m_pcData + notch;
+         vec[n].iov_len = unitsize;
+         ++ n;
+
+         rs -= unitsize;
+      }
+
+      if (++ p == m_iSize)
+         p = 0;
+      notch = 0;
+   }
+
+   int written = 0;
+   #ifdef LINUX
+      if (n > 0)
+         written = pwritev(fd, vec, n, offset);
+   #else
+      for (int i = 0; i < n; ++ i)
+      {
+         int w = pwrite(fd, vec[i].iov_base, vec[i].iov_len, offset + written);
+         if (w < 0)
+         {
+            written = w;
+            break;
+         }
+         written += w;
+         if (w < (int)vec[i].iov_len)
+            break;
+      }
+   #endif
+
+   if (written < 0)
+      return -1;
+
+   // release the units that have been written completely, a short write leaves a notch
+   int ws = written;
+   p = m_iStartPos;
+   while (p != lastack)
+   {
+      if (NULL != m_pUnit[p])
+      {
+         int unitsize = m_pUnit[p]->m_Packet.getLength() - m_iNotch;
+         if (ws < unitsize)
+         {
+            m_iNotch += ws;
+            break;
+         }
+
+         ws -= unitsize;
+
+         CUnit* tmp = m_pUnit[p];
+         m_pUnit[p] = NULL;
+         m_pUnitQueue->makeUnitFree(tmp);
+      }
+
+      if (++ p == m_iSize)
+         p = 0;
+      m_iNotch = 0;
+   }
+
+   m_iStartPos = p;
+
+   return written;
+}
+#endif
+
 void CRcvBuffer::ackData(int len)
 {
    m_iLastAckPos = (m_iLastAckPos + len) % m_iSize;
@@ -557,7 +1238,8 @@ void CRcvBuffer::ackData(int len)
 int CRcvBuffer::getAvailBufSize() const
 {
    // One slot must be empty in order to tell the difference between "empty buffer" and "full buffer"
-   return m_iSize - getRcvDataSize() - 1;
+   // Units on loan to the application still take space until they are given back
+   return m_iSize - getRcvDataSize() - m_iLentUnits - 1;
 }
 
 int CRcvBuffer::getRcvDataSize() const
@@ -570,18 +1252,29 @@ int CRcvBuffer::getRcvDataSize() const
 
 void CRcvBuffer::dropMsg(int32_t msgno)
 {
+   CGuard lendguard(m_LendLock);
+
    for (int i = m_iStartPos, n = (m_iLastAckPos + m_iMaxPos) % m_iSize; i != n; i = (i + 1) % m_iSize)
-      if ((NULL != m_pUnit[i]) && (msgno == m_pUnit[i]->m_Packet.m_iMsgNo))
+      if ((NULL != m_pUnit[i]) && (4 != m_pUnit[i]->m_iFlag) && (msgno == m_pUnit[i]->m_Packet.getMsgSeq()))
          m_pUnit[i]->m_iFlag = 3;
 }
 
 int CRcvBuffer::readMsg(char* data, int len)
+{
+   uint16_t frame_id;
+   return readMsg(data, len, frame_id);
+}
+
+int CRcvBuffer::readMsg(char* data, int len, uint16_t& frame_id)
 {
    int p, q;
    bool passack;
    if (!scanMsg(p, q, passack))
       return 0;
 
+   // VR Frame Awareness: a frame sent by sendframe() is one message
+   frame_id = m_pUnit[p]->m_Packet.getFrameID();
+
    int rs = len;
    while (p != (q + 1) % m_iSize)
    {
@@ -600,8 +1293,7 @@ int CRcvBuffer::readMsg(char* data, int len)
       {
          CUnit* tmp = m_pUnit[p];
          m_pUnit[p] = NULL;
-         tmp->m_iFlag = 0;
-         -- m_pUnitQueue->m_iCount;
+         m_pUnitQueue->makeUnitFree(tmp);
       }
       else
          m_pUnit[p]->m_iFlag = 2;
@@ -616,23 +1308,262 @@ int CRcvBuffer::readMsg(char* data, int len)
    return len - rs;
 }
 
-int CRcvBuffer::getRcvMsgNum()
-{
-   int p, q;
-   bool passack;
-   return scanMsg(p, q, passack) ? 1 : 0;
-}
-
-bool CRcvBuffer::scanMsg(int& p, int& q, bool& passack)
+int CRcvBuffer::readFrame(char* data, int len, int pos, uint16_t frame_id, int chunks)
 {
-   // empty buffer
-   if ((m_iStartPos == m_iLastAckPos) && (m_iMaxPos <= 0))
-      return false;
+   if (!checkFrame(pos, frame_id, chunks))
+      return -1;
 
-   //skip all bad msgs at the beginning
-   while (m_iStartPos != m_iLastAckPos)
+   int rs = len;
+   int acked = getRcvDataSize();
+   for (int i = 0, p = pos; i < chunks; ++ i, p = (p + 1) % m_iSize)
    {
-      if (NULL == m_pUnit[m_iStartPos])
+      int unitsize = m_pUnit[p]->m_Packet.getLength();
+      if (unitsize > rs)
+         unitsize = rs;
+
+      if (unitsize > 0)
+      {
+         memcpy(data, m_pUnit[p]->m_Packet.m_pcData, unitsize);
+         data += unitsize;
+         rs -= unitsize;
+      }
+
+      // units beyond the ACK point are kept (as read) until they are acknowledged, to reject duplicates
+      if ((p - m_iStartPos + m_iSize) % m_iSize < acked)
+      {
+         CUnit* tmp = m_pUnit[p];
+         m_pUnit[p] = NULL;
+         m_pUnitQueue->makeUnitFree(tmp);
+      }
+      else
+         m_pUnit[p]->m_iFlag = 2;
+   }
+
+   // move the head over the units that have been read or dropped
+   while ((m_iStartPos != m_iLastAckPos) && ((NULL == m_pUnit[m_iStartPos]) || (1 != m_pUnit[m_iStartPos]->m_iFlag)))
+   {
+      if (NULL != m_pUnit[m_iStartPos])
+         freeUnit(m_iStartPos);
+
+      if (++ m_iStartPos == m_iSize)
+         m_iStartPos = 0;
+   }
+
+   return len - rs;
+}
+
+int CRcvBuffer::lendMsg(vector<CUnit*>& units, uint16_t& frame_id)
+{
+   int p, q;
+   bool passack;
+   if (!scanMsg(p, q, passack))
+      return 0;
+
+   frame_id = m_pUnit[p]->m_Packet.getFrameID();
+
+   units.clear();
+   int size = 0;
+
+   CGuard lendguard(m_LendLock);
+
+   while (p != (q + 1) % m_iSize)
+   {
+      CUnit* u = m_pUnit[p];
+      units.push_back(u);
+      size += u->m_Packet.getLength();
+
+      // units beyond the ACK point keep their place until they are acknowledged, to reject duplicates
+      if (!passack)
+      {
+         m_pUnit[p] = NULL;
+         u->m_iFlag = 5;
+         ++ m_iLentUnits;
+      }
+      else
+         u->m_iFlag = 4;
+
+      if (++ p == m_iSize)
+         p = 0;
+   }
+
+   if (!passack)
+      m_iStartPos = (q + 1) % m_iSize;
+
+   return size;
+}
+
+int CRcvBuffer::lendFrame(vector<CUnit*>& units, int pos, uint16_t frame_id, int chunks)
+{
+   if (!checkFrame(pos, frame_id, chunks))
+      return -1;
+
+   units.clear();
+   int size = 0;
+   int acked = getRcvDataSize();
+
+   CGuard::enterCS(m_LendLock);
+
+   for (int i = 0, p = pos; i < chunks; ++ i, p = (p + 1) % m_iSize)
+   {
+      CUnit* u = m_pUnit[p];
+      units.push_back(u);
+      size += u->m_Packet.getLength();
+
+      // the chunks behind the ACK point leave the buffer now, the head catches up with them below
+      if ((p - m_iStartPos + m_iSize) % m_iSize < acked)
+      {
+         m_pUnit[p] = NULL;
+         u->m_iFlag = 5;
+         ++ m_iLentUnits;
+      }
+      else
+         u->m_iFlag = 4;
+   }
+
+   CGuard::leaveCS(m_LendLock);
+
+   while ((m_iStartPos != m_iLastAckPos) && ((NULL == m_pUnit[m_iStartPos]) || (1 != m_pUnit[m_iStartPos]->m_iFlag)))
+   {
+      if (NULL != m_pUnit[m_iStartPos])
+         freeUnit(m_iStartPos);
+
+      if (++ m_iStartPos == m_iSize)
+         m_iStartPos = 0;
+   }
+
+   return size;
+}
+
+void CRcvBuffer::releaseUnits(const vector<CUnit*>& units)
+{
+   CGuard lendguard(m_LendLock);
+
+   for (vector<CUnit*>::const_iterator i = units.begin(); i != units.end(); ++ i)
+   {
+      if (5 == (*i)->m_iFlag)
+      {
+         m_pUnitQueue->makeUnitFree(*i);
+         -- m_iLentUnits;
+      }
+      else
+      {
+         // still in the buffer beyond the ACK point, freed when the head moves over it
+         (*i)->m_iFlag = 2;
+      }
+   }
+}
+
+void CRcvBuffer::freeUnit(int pos)
+{
+   CUnit* tmp = m_pUnit[pos];
+   m_pUnit[pos] = NULL;
+
+   CGuard lendguard(m_LendLock);
+
+   // a unit on loan is freed when the application gives it back
+   if (4 == tmp->m_iFlag)
+   {
+      tmp->m_iFlag = 5;
+      ++ m_iLentUnits;
+   }
+   else
+      m_pUnitQueue->makeUnitFree(tmp);
+}
+
+int CRcvBuffer::recoverChunk(CUnit* unit, int pos, int chunk, int chunks, int groups)
+{
+   int g = chunk % groups;
+   CUnit* parity = m_pUnit[(pos + chunks + g) % m_iSize];
+   if ((NULL == parity) || (1 != parity->m_iFlag))
+      return -1;
+
+   int group, num, lenxor;
+   int size = parity->m_Packet.getLength() - CFrameFEC::m_iHdrSize;
+   if (!CFrameFEC::readHeader(parity->m_Packet.m_pcData, parity->m_Packet.getLength(), group, num, lenxor) || (group != g) || (num != groups))
+      return -1;
+
+   if (size > unit->m_Packet.getLength())
+      return -1;
+   memcpy(unit->m_Packet.m_pcData, parity->m_Packet.m_pcData + CFrameFEC::m_iHdrSize, size);
+
+   // the XOR of the parity and the other chunks of the group is the lost chunk
+   for (int i = g; i < chunks; i += groups)
+   {
+      if (i == chunk)
+         continue;
+
+      CUnit* u = m_pUnit[(pos + i) % m_iSize];
+      if ((NULL == u) || (1 != u->m_iFlag) || (u->m_Packet.getLength() > size))
+         return -1;
+
+      CFrameFEC::xorData(unit->m_Packet.m_pcData, u->m_Packet.m_pcData, u->m_Packet.getLength());
+      lenxor ^= u->m_Packet.getLength();
+   }
+
+   if ((lenxor <= 0) || (lenxor > size))
+      return -1;
+
+   // the chunk is in the middle of the frame's message, unless it is the first one
+   CPacket& packet = unit->m_Packet;
+   packet.m_iSeqNo = CSeqNo::incseq(parity->m_Packet.m_iSeqNo, chunk - chunks - g);
+   packet.m_iMsgNo = parity->m_Packet.m_iMsgNo & 0x3FFFFFFF;
+   if (0 == chunk)
+      packet.m_iMsgNo |= 0x80000000;
+   packet.m_iTimeStamp = parity->m_Packet.m_iTimeStamp;
+   packet.m_iID = parity->m_Packet.m_iID;
+   packet.setFrameInfo(parity->m_Packet.getFrameID(), chunk, chunks);
+   packet.setLength(lenxor);
+
+   return 0;
+}
+
+bool CRcvBuffer::checkFrame(int pos, uint16_t frame_id, int chunks) const
+{
+   // every chunk must still be waiting to be read, and be the chunk of the frame that its position stands for
+   for (int i = 0, p = pos; i < chunks; ++ i, p = (p + 1) % m_iSize)
+   {
+      const CUnit* u = m_pUnit[p];
+      if ((NULL == u) || (1 != u->m_iFlag) || (u->m_Packet.getFrameID() != frame_id) || (u->m_Packet.getChunkID() != i))
+         return false;
+   }
+
+   return true;
+}
+
+void CRcvBuffer::dropUnits(int pos, int num)
+{
+   CGuard lendguard(m_LendLock);
+
+   for (int i = 0; i < num; ++ i)
+   {
+      CUnit* u = m_pUnit[(pos + i) % m_iSize];
+      if ((NULL != u) && (1 == u->m_iFlag))
+         u->m_iFlag = 3;
+   }
+}
+
+int CRcvBuffer::getPos(int offset) const
+{
+   return (m_iLastAckPos + offset) % m_iSize;
+}
+
+int CRcvBuffer::getRcvMsgNum()
+{
+   int p, q;
+   bool passack;
+   return scanMsg(p, q, passack) ? 1 : 0;
+}
+
+bool CRcvBuffer::scanMsg(int& p, int& q, bool& passack)
+{
+   // empty buffer
+   if ((m_iStartPos == m_iLastAckPos) && (m_iMaxPos <= 0))
+      return false;
+
+   //skip all bad msgs at the beginning
+   while (m_iStartPos != m_iLastAckPos)
+   {
+      if (NULL == m_pUnit[m_iStartPos])
       {
          if (++ m_iStartPos == m_iSize)
             m_iStartPos = 0;
@@ -663,10 +1594,7 @@ bool CRcvBuffer::scanMsg(int& p, int& q, bool& passack)
             break;
       }
 
-      CUnit* tmp = m_pUnit[m_iStartPos];
-      m_pUnit[m_iStartPos] = NULL;
-      tmp->m_iFlag = 0;
-      -- m_pUnitQueue->m_iCount;
+      freeUnit(m_iStartPos);
 
       if (++ m_iStartPos == m_iSize)
          m_iStartPos = 0;
@@ -730,3 +1658,418 @@ bool CRcvBuffer::scanMsg(int& p, int& q, bool& passack)
 
    return found;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+
+CRcvFrameBuffer::CRcvFrameBuffer(int size):
+m_pFrame(NULL),
+m_iSize(size),
+m_piReadyFrame(NULL),
+m_iReadyHead(0),
+m_iReadyTail(0),
+m_FrameLock(),
+m_iClockDelta(0),
+m_iClockWindowMin(0),
+m_llClockWindowEnd(0)
+{
+   m_pFrame = new Frame[m_iSize];
+   for (int i = 0; i < m_iSize; ++ i)
+      m_pFrame[i].m_iFrameID = -1;
+
+   // one extra slot to tell the difference between "empty" and "full"
+   m_piReadyFrame = new uint16_t[m_iSize + 1];
+
+   #ifndef WIN32
+      pthread_mutex_init(&m_FrameLock, NULL);
+   #else
+      m_FrameLock = CreateMutex(NULL, false, NULL);
+   #endif
+}
+
+CRcvFrameBuffer::~CRcvFrameBuffer()
+{
+   delete [] m_pFrame;
+   delete [] m_piReadyFrame;
+
+   #ifndef WIN32
+      pthread_mutex_destroy(&m_FrameLock);
+   #else
+      CloseHandle(m_FrameLock);
+   #endif
+}
+
+bool CRcvFrameBuffer::addChunk(uint16_t frame_id, uint8_t chunk_id, uint8_t total_chunks, int pos,
+                               int32_t seqno, int32_t msgno, int64_t deadline, int groups, int64_t timestamp,
+                               int required, bool layerend)
+{
+   if ((0 == total_chunks) || ((chunk_id >= total_chunks) && ((groups <= 0) || (chunk_id - total_chunks >= groups))))
+      return false;
+
+   CGuard frameguard(m_FrameLock);
+
+   Frame* f = m_pFrame + frame_id % m_iSize;
+
+   // a new frame takes over the slot; an older frame still in it is too far behind to be useful;
+   // a frame whose optional layers have been shed before any of its chunks arrived keeps what is known of the shedding
+   bool shed = (frame_id == f->m_iFrameID) && (0 == f->m_iTotalChunks) && (0 == f->m_iReceived);
+   if ((frame_id != f->m_iFrameID) || shed)
+   {
+      f->m_iFrameID = frame_id;
+      f->m_iTotalChunks = total_chunks;
+      f->m_iReceived = 0;
+      f->m_iRequired = ((required > 0) && (required < total_chunks)) ? required : total_chunks;
+      f->m_iLimit = (shed && (f->m_iLimit < total_chunks)) ? f->m_iLimit : total_chunks;
+      f->m_iReadable = 0;
+      memset(f->m_piBitmap, 0, sizeof(f->m_piBitmap));
+      memset(f->m_piLayerEnd, 0, sizeof(f->m_piLayerEnd));
+      f->m_iGroups = 0;
+      f->m_iPos = pos;
+      f->m_iSeqNo = seqno;
+      f->m_iMsgNo = msgno;
+      f->m_llDeadline = deadline;
+      f->m_llSentTime = -1;
+   }
+   else if ((f->m_iReceived < 0) || (f->m_iReadable > 0))
+      return false;
+
+   uint32_t bit = 1 << (chunk_id & 0x1F);
+   if (0 != (f->m_piBitmap[chunk_id >> 5] & bit))
+      return false;
+
+   f->m_piBitmap[chunk_id >> 5] |= bit;
+   if (layerend)
+      f->m_piLayerEnd[chunk_id >> 5] |= bit;
+
+   if ((timestamp >= 0) && ((f->m_llSentTime < 0) || (CTimeStamp::tscmp(timestamp, f->m_llSentTime) < 0)))
+      f->m_llSentTime = timestamp;
+
+   // a parity chunk only tells how the frame is protected
+   if (chunk_id >= f->m_iTotalChunks)
+   {
+      f->m_iGroups = groups;
+      return false;
+   }
+
+   // the last missing chunk has arrived, the frame is ready regardless of any earlier incomplete frame;
+   // after the sender has shed optional layers, the last chunk it still sends does the same
+   if (++ f->m_iReceived == f->m_iTotalChunks)
+      f->m_iReadable = f->m_iTotalChunks;
+   else if ((f->m_iLimit < f->m_iTotalChunks) && (chunk_id < f->m_iLimit))
+      f->m_iReadable = getReadable(f);
+
+   if (f->m_iReadable <= 0)
+      return false;
+
+   pushReady(frame_id);
+
+   return true;
+}
+
+bool CRcvFrameBuffer::shedChunks(uint16_t frame_id, int from, int& pos, int32_t& seqno, int& chunks, int64_t& deadline)
+{
+   CGuard frameguard(m_FrameLock);
+
+   Frame* f = m_pFrame + frame_id % m_iSize;
+   if (frame_id != f->m_iFrameID)
+   {
+      // no chunk of the frame has arrived (yet); the slot remembers how far the sender still sends it
+      f->m_iFrameID = frame_id;
+      f->m_iTotalChunks = 0;
+      f->m_iReceived = 0;
+      f->m_iLimit = from;
+      f->m_iReadable = 0;
+      f->m_iGroups = 0;
+      f->m_iSeqNo = -1;
+      f->m_llSentTime = -1;
+      return false;
+   }
+
+   if ((f->m_iReceived < 0) || (f->m_iReadable > 0))
+      return false;
+   if (from < f->m_iLimit)
+      f->m_iLimit = from;
+   if (0 == f->m_iTotalChunks)
+      return false;
+
+   if ((f->m_iReadable = getReadable(f)) <= 0)
+      return false;
+
+   pos = f->m_iPos;
+   seqno = f->m_iSeqNo;
+   chunks = f->m_iTotalChunks;
+   deadline = f->m_llDeadline;
+   pushReady(frame_id);
+
+   return true;
+}
+
+bool CRcvFrameBuffer::settleFrame(uint16_t frame_id, int& pos, int32_t& seqno, int& chunks, int& readable, int64_t& deadline)
+{
+   CGuard frameguard(m_FrameLock);
+
+   Frame* f = m_pFrame + frame_id % m_iSize;
+   if ((frame_id != f->m_iFrameID) || (f->m_iReceived < 0) || (f->m_iReadable > 0) || (0 == f->m_iTotalChunks))
+      return false;
+
+   // whatever has not arrived of the limit yet is given up
+   int limit = f->m_iLimit;
+   f->m_iLimit = f->m_iTotalChunks;
+   for (int i = 0; i < f->m_iTotalChunks; ++ i)
+   {
+      if (0 == (f->m_piBitmap[i >> 5] & (1 << (i & 0x1F))))
+      {
+         f->m_iLimit = i;
+         break;
+      }
+   }
+   if ((f->m_iReadable = getReadable(f)) <= 0)
+   {
+      f->m_iLimit = limit;
+      return false;
+   }
+
+   pos = f->m_iPos;
+   seqno = f->m_iSeqNo;
+   chunks = f->m_iTotalChunks;
+   readable = f->m_iReadable;
+   deadline = f->m_llDeadline;
+   pushReady(frame_id);
+
+   return true;
+}
+
+int CRcvFrameBuffer::getReadable(const Frame* f) const
+{
+   // all the chunks the sender still sends must have arrived
+   for (int i = 0; i < f->m_iLimit; ++ i)
+   {
+      if (0 == (f->m_piBitmap[i >> 5] & (1 << (i & 0x1F))))
+         return 0;
+   }
+
+   // a layer is of no use without all of its chunks, the frame is cut back to the end of the last complete one
+   int n = f->m_iLimit;
+   while ((n > 0) && (0 == (f->m_piLayerEnd[(n - 1) >> 5] & (1 << ((n - 1) & 0x1F)))))
+      -- n;
+
+   return (n >= f->m_iRequired) ? n : 0;
+}
+
+void CRcvFrameBuffer::pushReady(uint16_t frame_id)
+{
+   m_piReadyFrame[m_iReadyTail] = frame_id;
+   m_iReadyTail = (m_iReadyTail + 1) % (m_iSize + 1);
+   if (m_iReadyTail == m_iReadyHead)
+      m_iReadyHead = (m_iReadyHead + 1) % (m_iSize + 1);
+}
+
+bool CRcvFrameBuffer::getReadyFrame(uint16_t& frame_id, int& pos, int& chunks, int& total)
+{
+   CGuard frameguard(m_FrameLock);
+
+   while (m_iReadyHead != m_iReadyTail)
+   {
+      frame_id = m_piReadyFrame[m_iReadyHead];
+      m_iReadyHead = (m_iReadyHead + 1) % (m_iSize + 1);
+
+      // skip frames that have been dropped or replaced since they became ready
+      Frame* f = m_pFrame + frame_id % m_iSize;
+      if ((frame_id != f->m_iFrameID) || (f->m_iReceived < 0) || (f->m_iReadable <= 0))
+         continue;
+
+      pos = f->m_iPos;
+      chunks = f->m_iReadable;
+      total = f->m_iTotalChunks;
+
+      // the slot is kept, marked complete, so that duplicates do not start the frame again
+      return true;
+   }
+
+   return false;
+}
+
+bool CRcvFrameBuffer::dropFrame(uint16_t frame_id)
+{
+   CGuard frameguard(m_FrameLock);
+
+   Frame* f = m_pFrame + frame_id % m_iSize;
+   if (frame_id == f->m_iFrameID)
+   {
+      if ((f->m_iReceived < 0) || (f->m_iReadable > 0))
+         return false;
+   }
+   else
+   {
+      // no chunk of the frame has arrived (yet); the slot remembers the drop
+      f->m_iFrameID = frame_id;
+      f->m_iTotalChunks = 0;
+      f->m_iReadable = 0;
+   }
+
+   // late chunks of the frame are ignored from now on
+   f->m_iReceived = -1;
+
+   return true;
+}
+
+bool CRcvFrameBuffer::getExpiredFrame(int64_t now, int& slot, uint16_t& frame_id, int32_t& seqno, int& chunks, int32_t& msgno, int64_t& deadline)
+{
+   CGuard frameguard(m_FrameLock);
+
+   for (; slot < m_iSize; ++ slot)
+   {
+      Frame* f = m_pFrame + slot;
+
+      // only frames still waiting for chunks, whose place in the sequence space is known
+      if ((f->m_iFrameID < 0) || (f->m_iReceived < 0) || (f->m_iReadable > 0) || (f->m_iSeqNo < 0))
+         continue;
+      if ((f->m_llDeadline <= 0) || (CTimeStamp::tscmp(f->m_llDeadline, now) >= 0))
+         continue;
+
+      frame_id = uint16_t(f->m_iFrameID);
+      seqno = f->m_iSeqNo;
+      chunks = f->m_iTotalChunks;
+      msgno = f->m_iMsgNo;
+      deadline = f->m_llDeadline;
+
+      ++ slot;
+      return true;
+   }
+
+   return false;
+}
+
+bool CRcvFrameBuffer::isPending(uint16_t frame_id) const
+{
+   CGuard frameguard(m_FrameLock);
+
+   const Frame* f = m_pFrame + frame_id % m_iSize;
+   return (frame_id == f->m_iFrameID) && (f->m_iReceived >= 0) && (f->m_iReadable <= 0) && (f->m_iTotalChunks > 0);
+}
+
+bool CRcvFrameBuffer::isPartial(uint16_t frame_id) const
+{
+   CGuard frameguard(m_FrameLock);
+
+   const Frame* f = m_pFrame + frame_id % m_iSize;
+   return (frame_id == f->m_iFrameID) && (f->m_iReceived >= 0) && (f->m_iReadable > 0) && (f->m_iReadable < f->m_iTotalChunks);
+}
+
+int CRcvFrameBuffer::getGroups(uint16_t frame_id) const
+{
+   CGuard frameguard(m_FrameLock);
+
+   const Frame* f = m_pFrame + frame_id % m_iSize;
+   return (frame_id == f->m_iFrameID) ? f->m_iGroups : 0;
+}
+
+int64_t CRcvFrameBuffer::getSentTime(uint16_t frame_id) const
+{
+   CGuard frameguard(m_FrameLock);
+
+   const Frame* f = m_pFrame + frame_id % m_iSize;
+   return (frame_id == f->m_iFrameID) ? f->m_llSentTime : -1;
+}
+
+void CRcvFrameBuffer::updateClock(int64_t now, int32_t timestamp)
+{
+   // the deltas are compared in 32 bits, so a timestamp that wraps does not look like a jump of 2^32 microseconds
+   uint32_t delta = uint32_t(now) - uint32_t(timestamp);
+   if (now >= m_llClockWindowEnd)
+   {
+      m_iClockDelta = (0 == m_llClockWindowEnd) ? delta : m_iClockWindowMin;
+      m_iClockWindowMin = delta;
+      m_llClockWindowEnd = now + 10000000;
+   }
+   if (CTimeStamp::tscmp(delta, m_iClockWindowMin) < 0)
+      m_iClockWindowMin = delta;
+   if (CTimeStamp::tscmp(delta, m_iClockDelta) < 0)
+      m_iClockDelta = delta;
+}
+
+int64_t CRcvFrameBuffer::getSenderTime(int64_t now) const
+{
+   if (0 == m_llClockWindowEnd)
+      return -1;
+
+   return uint32_t(uint32_t(now) - m_iClockDelta);
+}
+
+bool CRcvFrameBuffer::getRecoverable(uint16_t frame_id, int& chunk, int& pos, int& chunks, int& groups, int32_t& seqno) const
+{
+   CGuard frameguard(m_FrameLock);
+
+   const Frame* f = m_pFrame + frame_id % m_iSize;
+   if ((frame_id != f->m_iFrameID) || (f->m_iReceived < 0) || (f->m_iReadable > 0) || (f->m_iGroups <= 0) || (f->m_iSeqNo < 0))
+      return false;
+
+   for (int g = 0; g < f->m_iGroups; ++ g)
+   {
+      int p = f->m_iTotalChunks + g;
+      if (0 == (f->m_piBitmap[p >> 5] & (1 << (p & 0x1F))))
+         continue;
+
+      int missing = 0;
+      for (int i = g; (i < f->m_iTotalChunks) && (missing < 2); i += f->m_iGroups)
+      {
+         if (0 == (f->m_piBitmap[i >> 5] & (1 << (i & 0x1F))))
+         {
+            chunk = i;
+            ++ missing;
+         }
+      }
+
+      if (1 == missing)
+      {
+         pos = f->m_iPos;
+         chunks = f->m_iTotalChunks;
+         groups = f->m_iGroups;
+         seqno = f->m_iSeqNo;
+         return true;
+      }
+   }
+
+   return false;
+}
+
+void CRcvFrameBuffer::getLossArray(uint16_t frame_id, int32_t last, int32_t* array, int& len, int limit) const
+{
+   CGuard frameguard(m_FrameLock);
+
+   len = 0;
+
+   const Frame* f = m_pFrame + frame_id % m_iSize;
+   if ((frame_id != f->m_iFrameID) || (f->m_iReceived < 0) || (f->m_iReadable > 0) || (f->m_iSeqNo < 0))
+      return;
+
+   // shed chunks are not asked for
+   int n = CSeqNo::seqlen(f->m_iSeqNo, last);
+   if ((n <= 0) || (n > f->m_iLimit))
+      n = (CSeqNo::seqcmp(last, f->m_iSeqNo) < 0) ? 0 : f->m_iLimit;
+
+   for (int i = 0; (i < n) && (len + 2 <= limit); ++ i)
+   {
+      if (0 != (f->m_piBitmap[i >> 5] & (1 << (i & 0x1F))))
+         continue;
+
+      // a run of missing chunks
+      int j = i;
+      while ((j + 1 < n) && (0 == (f->m_piBitmap[(j + 1) >> 5] & (1 << ((j + 1) & 0x1F)))))
+         ++ j;
+
+      if (j == i)
+         array[len ++] = CSeqNo::incseq(f->m_iSeqNo, i);
+      else
+      {
+         array[len ++] = CSeqNo::incseq(f->m_iSeqNo, i) | 0x80000000;
+         array[len ++] = CSeqNo::incseq(f->m_iSeqNo, j);
+      }
+
+      i = j;
+   }
+}
+
+int CRcvFrameBuffer::getReadyFrameNum() const
+{
+   return (m_iReadyTail - m_iReadyHead + m_iSize + 1) % (m_iSize + 1);
+}
@@ -46,11 +46,38 @@ written by
 #include "list.h"
 #include "queue.h"
 #include <fstream>
+#include <vector>
+
+// VR Frame Awareness: XOR parity chunks appended to a frame (UDT_FEC). Data chunk i belongs to group i % groups,
+// and parity chunk total_chunks + g carries the XOR of the chunks of group g behind a small header: the group,
+// the number of groups and the XOR of the chunk lengths. A group rebuilds any one of its chunks.
+
+class CFrameFEC
+{
+public:
+   static const int m_iHdrSize;         // size of the parity chunk header
+
+      // Functionality:
+      //    Choose the number of parity chunks of a frame, enough for about one loss per group.
+      // Parameters:
+      //    0) [in] chunks: number of data chunks in the frame.
+      //    1) [in] loss: measured packet loss rate.
+      // Returned value:
+      //    number of parity chunks, at least 1, 0 if the chunk IDs of the frame leave no room.
+
+   static int getGroups(int chunks, double loss);
+
+   static void writeHeader(char* parity, int group, int groups, int lenxor);
+   static bool readHeader(const char* parity, int len, int& group, int& groups, int& lenxor);
+   static void xorData(char* dst, const char* src, int len);
+};
+
+////////////////////////////////////////////////////////////////////////////////
 
 class CSndBuffer
 {
 public:
-   CSndBuffer(int size = 32, int mss = 1500);
+   CSndBuffer(int size = 32, int mss = 1500, int32_t maxmsgno = CMsgNo::m_iMaxMsgNo);
    ~CSndBuffer();
 
       // Functionality:
@@ -71,6 +98,64 @@ public:
                   uint16_t frame_id = 0, uint8_t chunk_id = 0,
                   uint8_t total_chunks = 0, int64_t frame_deadline = 0);
 
+      // Functionality:
+      //    VR Frame Awareness: insert a whole frame into the sending list as one message, one chunk per block.
+      // Parameters:
+      //    0) [in] data: pointer to the frame data.
+      //    1) [in] len: size of the frame.
+      //    2) [in] frame_id: VR frame ID (0-65535)
+      //    3) [in] frame_deadline: VR frame deadline in microseconds
+      //    4) [in] ttl: time to live in milliseconds
+      //    5) [in] order: if the frame should be delivered in order, for DGRAM only
+      //    6) [in] parity: number of XOR parity chunks appended to the frame, see CFrameFEC.
+      // Returned value:
+      //    Number of data chunks the frame has been split into.
+
+   int addFrame(const char* data, int len, uint16_t frame_id, int64_t frame_deadline, int ttl = -1, bool order = true, int parity = 0);
+
+      // Functionality:
+      //    VR Frame Awareness: insert a whole frame like addFrame, but let the blocks point into the frame data instead of copying it.
+      //    The callback is called once the last block of the frame is released, by ackData or when the buffer is destroyed.
+      // Parameters:
+      //    0) [in] data: pointer to the frame data, which must stay valid until the callback.
+      //    1) [in] len: size of the frame.
+      //    2) [in] frame_id: VR frame ID (0-65535)
+      //    3) [in] frame_deadline: VR frame deadline in microseconds
+      //    4) [in] u: socket ID passed to the callback.
+      //    5) [in] callback: completion callback.
+      //    6) [in] context: passed to the callback.
+      //    7) [in] parity: number of XOR parity chunks appended to the frame; they are copied.
+      // Returned value:
+      //    Number of data chunks the frame has been split into.
+
+   int addFrameRef(const char* data, int len, uint16_t frame_id, int64_t frame_deadline, UDTSOCKET u, UDTFRAMEDONE callback, void* context, int parity = 0);
+
+      // Functionality:
+      //    VR Frame Awareness: insert a frame coded in layers like addFrame. Each chunk stays within one layer, and every
+      //    chunk carries its layer and the number of chunks in the required layers, so that the optional ones can be shed.
+      // Parameters:
+      //    0) [in] data: pointer to the frame data, the layers one after another, base layer first.
+      //    1) [in] layers: size of each layer, none of them 0.
+      //    2) [in] nlayers: number of layers.
+      //    3) [in] required: number of leading layers that the frame cannot be used without.
+      //    4) [in] frame_id: VR frame ID (0-65535)
+      //    5) [in] frame_deadline: VR frame deadline in microseconds
+      // Returned value:
+      //    Number of chunks the frame has been split into.
+
+   int addLayeredFrame(const char* data, const int* layers, int nlayers, int required, uint16_t frame_id, int64_t frame_deadline);
+
+      // Functionality:
+      //    VR Frame Awareness: count the chunks a layered frame would be split into, see addLayeredFrame.
+      // Parameters:
+      //    0) [in] layers: size of each layer.
+      //    1) [in] nlayers: number of layers.
+      //    2) [in] chunk: payload size of a chunk.
+      // Returned value:
+      //    Number of chunks.
+
+   static int countLayerChunks(const int* layers, int nlayers, int chunk);
+
       // Functionality:
       //    Read a block of data from file and insert it into the sending list.
       // Parameters:
@@ -81,6 +166,21 @@ public:
 
    int addBufferFromFile(std::fstream& ifs, int len);
 
+#ifndef WIN32
+      // Functionality:
+      //    Map a block of a file and insert it into the sending list. The blocks point into the mapped pages,
+      //    which are unmapped once the last of them is acknowledged; files that cannot be mapped, or that end
+      //    before the block does, are read with pread. The file must not be truncated until then.
+      // Parameters:
+      //    0) [in] fd: file descriptor opened for reading.
+      //    1) [in] offset: position of the block in the file.
+      //    2) [in] len: size of the block, which must not go past the end of the file.
+      // Returned value:
+      //    actual size of data added from the file, -1 if the file cannot be read.
+
+   int addBufferFromFile(int fd, int64_t offset, int len);
+#endif
+
       // Functionality:
       //    Find data position to pack a DATA packet from the furthest reading point.
       // Parameters:
@@ -100,12 +200,16 @@ public:
       //    3) [out] chunk_id: VR chunk ID
       //    4) [out] total_chunks: VR total chunks
       //    5) [out] frame_deadline: VR frame deadline
+      //    6) [out] layer: VR layer of the chunk
+      //    7) [out] required: VR number of required chunks of the frame
+      //    8) [out] layerend: if the chunk is the last one of its layer
       // Returned value:
       //    Actual length of data read.
 
    int readData(char** data, int32_t& msgno,
                 uint16_t& frame_id, uint8_t& chunk_id,
-                uint8_t& total_chunks, int64_t& frame_deadline);
+                uint8_t& total_chunks, int64_t& frame_deadline,
+                uint8_t& layer, uint8_t& required, bool& layerend);
 
       // Functionality:
       //    Find data position to pack a DATA packet for a retransmission.
@@ -130,21 +234,88 @@ public:
       //    5) [out] chunk_id: VR chunk ID
       //    6) [out] total_chunks: VR total chunks
       //    7) [out] frame_deadline: VR frame deadline
+      //    8) [out] layer: VR layer of the chunk
+      //    9) [out] required: VR number of required chunks of the frame
+      //    10) [out] layerend: if the chunk is the last one of its layer
       // Returned value:
       //    Actual length of data read.
 
    int readData(char** data, const int offset, int32_t& msgno, int& msglen,
                 uint16_t& frame_id, uint8_t& chunk_id,
-                uint8_t& total_chunks, int64_t& frame_deadline);
+                uint8_t& total_chunks, int64_t& frame_deadline,
+                uint8_t& layer, uint8_t& required, bool& layerend);
+
+      // Functionality:
+      //    VR Frame Awareness: drop all remaining blocks of a frame whose deadline has passed.
+      // Parameters:
+      //    0) [in] offset: offset from the last ACK point of a block in the frame.
+      //    1) [in] now: current time, on the same base as the frame deadlines.
+      //    2) [out] first: offset from the last ACK point of the first dropped block.
+      //    3) [out] msgno: message number of the first dropped block.
+      //    4) [out] frame_id: VR frame ID of the dropped frame.
+      // Returned value:
+      //    Number of blocks dropped, or 0 if the frame has no expired deadline.
+
+   int dropExpiredFrame(const int offset, const int64_t& now, int& first, int32_t& msgno, uint16_t& frame_id);
+
+      // Functionality:
+      //    VR Frame Awareness: drop all remaining blocks of a frame regardless of its deadline, e.g., one abandoned by the receiver.
+      // Parameters:
+      //    0) [in] offset: offset from the last ACK point of a block in the frame.
+      //    1) [out] first: offset from the last ACK point of the first dropped block.
+      //    2) [out] msgno: message number of the first dropped block.
+      //    3) [out] frame_id: VR frame ID of the dropped frame.
+      // Returned value:
+      //    Number of blocks dropped, or 0 if there is no block at the offset.
+
+   int dropFrame(const int offset, int& first, int32_t& msgno, uint16_t& frame_id);
+
+      // Functionality:
+      //    VR Frame Awareness: read the frame deadline of a block without consuming it.
+      // Parameters:
+      //    0) [in] offset: offset from the last ACK point.
+      //    1) [out] deadline: frame deadline of the block, 0 if none.
+      // Returned value:
+      //    true if there is a block at the offset, otherwise false.
+
+   bool getFrameDeadline(const int offset, int64_t& deadline);
+
+      // Functionality:
+      //    VR Frame Awareness: read where a block stands in the layers of its frame, without consuming it.
+      // Parameters:
+      //    0) [in] offset: offset from the last ACK point.
+      //    1) [out] chunk: chunk ID of the block.
+      //    2) [out] total: number of data chunks in the frame.
+      //    3) [out] required: number of chunks in the required layers, total if the frame has no optional layer.
+      //    4) [out] layer: layer of the block.
+      //    5) [out] deadline: frame deadline of the block, 0 if none.
+      // Returned value:
+      //    true if there is a block at the offset, otherwise false.
+
+   bool getLayerInfo(const int offset, int& chunk, int& total, int& required, int& layer, int64_t& deadline);
+
+      // Functionality:
+      //    VR Frame Awareness: shed the data chunks of a frame from an optional chunk to the end of the frame.
+      //    They are neither sent nor resent any more; the rest of the frame is kept.
+      // Parameters:
+      //    0) [in] offset: offset from the last ACK point of the first chunk to shed.
+      //    1) [out] msgno: message number of the frame.
+      //    2) [out] frame_id: VR frame ID of the frame.
+      // Returned value:
+      //    Number of blocks shed, or 0 if the block at the offset is not an optional chunk.
+
+   int shedLayers(const int offset, int32_t& msgno, uint16_t& frame_id);
 
       // Functionality:
       //    Update the ACK point and may release/unmap/return the user data according to the flag.
       // Parameters:
       //    0) [in] offset: number of packets acknowledged.
+      //    1) [out] stats: VR Frame Awareness: counts the frames whose last block is acknowledged, if not NULL.
+      //    2) [in] statslock: lock of the stats, held only while they are updated, if not NULL.
       // Returned value:
       //    None.
 
-   void ackData(int offset);
+   void ackData(int offset, CFrameStats* stats = NULL, pthread_mutex_t* statslock = NULL);
 
       // Functionality:
       //    Read size of data still in the sending list.
@@ -158,12 +329,31 @@ public:
 private:
    void increase();
 
+   struct ZeroCopy;
+   int insertFrame(const char* data, int len, uint16_t frame_id, int64_t frame_deadline, int ttl, bool order, ZeroCopy* zc, int parity,
+                   const int* layers = NULL, int nlayers = 0, int required = 0);
+   void release(ZeroCopy*& done, ZeroCopy* zc);
+   int dropFrame(const int offset, const int64_t* now, int& first, int32_t& msgno, uint16_t& frame_id);
+
 private:
    pthread_mutex_t m_BufLock;           // used to synchronize buffer operation
 
+   struct ZeroCopy                      // VR Frame Awareness: application frame referenced by blocks
+   {
+      UDTSOCKET m_iSocket;              // socket ID for the callback
+      const char* m_pcData;             // the frame data
+      int m_iLength;                    // size of the frame
+      UDTFRAMEDONE m_pCallback;         // completion callback
+      void* m_pContext;                 // callback context
+      int m_iRefCount;                  // number of blocks still referencing the frame
+      ZeroCopy* m_pNext;                // next released frame waiting for its callback
+   };
+
    struct Block
    {
       char* m_pcData;                   // pointer to the data block
+      char* m_pcStorage;                // the block's own storage, m_pcData unless the block references a frame
+      ZeroCopy* m_pZeroCopy;            // VR Frame Awareness: frame referenced by the block, NULL if the data is copied
       int m_iLength;                    // length of the block
 
       int32_t m_iMsgNo;                 // message number
@@ -175,15 +365,24 @@ private:
       uint8_t m_iChunkID;               // Chunk ID (0-255)
       uint8_t m_iTotalChunks;           // Total chunks (0-255)
       int64_t m_iFrameDeadline;         // Frame deadline (microseconds)
+      uint8_t m_iLayer;                 // layer (priority class) of the chunk, 0 for the base layer
+      uint8_t m_iRequired;              // number of chunks in the required layers of the frame
+      bool m_bLayerEnd;                 // whether the chunk is the last one of its layer
+      int m_iRetrans;                   // number of retransmissions, -1 once the frame has been dropped
 
       Block* m_pNext;                   // next block
-   } *m_pBlock, *m_pFirstBlock, *m_pCurrBlock, *m_pLastBlock;
+   } *m_pBlock, *m_pFirstBlock, *m_pCurrBlock;
+   Block* volatile m_pLastBlock;
 
    // m_pBlock:         The head pointer
    // m_pFirstBlock:    The first block
    // m_pCurrBlock:	The current block
    // m_pLastBlock:     The last block (if first == last, buffer is empty)
 
+   // the application thread is the only writer of m_pLastBlock and the blocks after it, the send thread is the
+   // only reader of m_pCurrBlock in readData(), so new data is published without m_BufLock: blocks are written
+   // before m_pLastBlock moves, then m_iCount is updated atomically; m_BufLock only orders the walks from m_pFirstBlock
+
    struct Buffer
    {
       char* m_pcData;			// buffer
@@ -192,11 +391,15 @@ private:
    } *m_pBuffer;			// physical buffer
 
    int32_t m_iNextMsgNo;                // next message number
+   int32_t m_iMaxMsgNo;                 // message numbers wrap around before this one, smaller when the header carries frame deadlines
 
    int m_iSize;				// buffer size (number of packets)
    int m_iMSS;                          // maximum seqment/packet size
 
-   int m_iCount;			// number of used blocks
+   volatile int m_iCount;		// number of used blocks
+
+   int m_iAckRetrans;                   // VR Frame Awareness: retransmissions of the frame being acknowledged so far
+   bool m_bAckDropped;                  // whether any block of that frame has been dropped
 
 private:
    CSndBuffer(const CSndBuffer&);
@@ -241,6 +444,19 @@ public:
 
    int readBufferToFile(std::fstream& ofs, int len);
 
+#ifndef WIN32
+      // Functionality:
+      //    Write data directly from the receiver units into a file, gathering several units per system call.
+      // Parameters:
+      //    0) [in] fd: file descriptor opened for writing.
+      //    1) [in] offset: position in the file to write to.
+      //    2) [in] len: expected length of data to write into the file.
+      // Returned value:
+      //    size of data written, -1 if the file cannot be written.
+
+   int readBufferToFile(int fd, int64_t offset, int len);
+#endif
+
       // Functionality:
       //    Update the ACK point of the buffer.
       // Parameters:
@@ -287,6 +503,103 @@ public:
 
    int readMsg(char* data, int len);
 
+      // Functionality:
+      //    read a message and the VR frame ID it carries.
+      // Parameters:
+      //    0) [out] data: buffer to write the message into.
+      //    1) [in] len: size of the buffer.
+      //    2) [out] frame_id: VR frame ID of the message.
+      // Returned value:
+      //    actuall size of data read.
+
+   int readMsg(char* data, int len, uint16_t& frame_id);
+
+      // Functionality:
+      //    VR Frame Awareness: read a complete frame from its buffer position, even ahead of earlier incomplete frames.
+      // Parameters:
+      //    0) [out] data: buffer to write the frame into.
+      //    1) [in] len: size of the buffer.
+      //    2) [in] pos: buffer position of the first chunk of the frame.
+      //    3) [in] frame_id: Frame ID.
+      //    4) [in] chunks: number of chunks in the frame.
+      // Returned value:
+      //    actual size of data read, or -1 if the frame is no longer (completely) in the buffer, or if a unit in its
+      //    place is not the chunk of the frame that its position says; nothing is read then.
+
+   int readFrame(char* data, int len, int pos, uint16_t frame_id, int chunks);
+
+      // Functionality:
+      //    Lend the units of the first readable message to the application instead of copying the data out.
+      // Parameters:
+      //    0) [out] units: the units of the message, in order.
+      //    1) [out] frame_id: VR frame ID of the message.
+      // Returned value:
+      //    size of the message, 0 if there is none.
+
+   int lendMsg(std::vector<CUnit*>& units, uint16_t& frame_id);
+
+      // Functionality:
+      //    VR Frame Awareness: lend the units of a complete frame to the application instead of copying the data out.
+      // Parameters:
+      //    0) [out] units: the chunks of the frame, in order.
+      //    1) [in] pos: buffer position of the first chunk of the frame.
+      //    2) [in] frame_id: Frame ID.
+      //    3) [in] chunks: number of chunks in the frame.
+      // Returned value:
+      //    size of the frame, or -1 as with readFrame.
+
+   int lendFrame(std::vector<CUnit*>& units, int pos, uint16_t frame_id, int chunks);
+
+      // Functionality:
+      //    Take back units lent by lendMsg or lendFrame. A unit goes back to the unit queue once the buffer does not need it.
+      // Parameters:
+      //    0) [in] units: the lent units.
+      // Returned value:
+      //    None.
+
+   void releaseUnits(const std::vector<CUnit*>& units);
+
+      // Functionality:
+      //    VR Frame Awareness: rebuild a lost chunk of a frame from the parity chunk of its group and the other chunks of the group.
+      // Parameters:
+      //    0) [out] unit: unit to write the chunk into, with the header of the parity chunk.
+      //    1) [in] pos: buffer position of the first chunk of the frame.
+      //    2) [in] chunk: ID of the lost chunk.
+      //    3) [in] chunks: number of data chunks in the frame.
+      //    4) [in] groups: number of parity chunks (groups) of the frame.
+      // Returned value:
+      //    0 if the chunk is rebuilt, -1 if a chunk of the group is missing.
+
+   int recoverChunk(CUnit* unit, int pos, int chunk, int chunks, int groups);
+
+      // Functionality:
+      //    Mark the units in a range of buffer positions as not to be read, e.g., the parity chunks of a complete frame.
+      // Parameters:
+      //    0) [in] pos: first buffer position.
+      //    1) [in] num: number of positions.
+      // Returned value:
+      //    None.
+
+   void dropUnits(int pos, int num);
+
+      // Functionality:
+      //    Get the buffer position where a packet at "offset" from the last ACK point is stored.
+      // Parameters:
+      //    0) [in] offset: offset from the last ACK point.
+      // Returned value:
+      //    the buffer position.
+
+   int getPos(int offset) const;
+
+      // Functionality:
+      //    Query the number of units in the buffer.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    size of the buffer.
+
+   int getSize() const {return m_iSize;}
+
       // Functionality:
       //    Query how many messages are available now.
       // Parameters:
@@ -298,6 +611,8 @@ public:
 
 private:
    bool scanMsg(int& start, int& end, bool& passack);
+   bool checkFrame(int pos, uint16_t frame_id, int chunks) const;
+   void freeUnit(int pos);
 
 private:
    CUnit** m_pUnit;                     // pointer to the protocol buffer
@@ -311,11 +626,260 @@ private:
 
    int m_iNotch;			// the starting read point of the first unit
 
+   int m_iLentUnits;			// number of lent units that no longer hold a place in the buffer, still counted as used space
+   pthread_mutex_t m_LendLock;		// used to synchronize the release of lent units with the buffer
+
 private:
    CRcvBuffer();
    CRcvBuffer(const CRcvBuffer&);
    CRcvBuffer& operator=(const CRcvBuffer&);
 };
 
+////////////////////////////////////////////////////////////////////////////////
+
+// VR Frame Awareness: frame table next to CRcvBuffer. It tracks which chunks of each frame have arrived,
+// while the data itself stays in CRcvBuffer. A frame is ready as soon as its last chunk arrives. A layered frame
+// may also be made ready with its leading complete layers, as long as they include the required ones.
+
+class CRcvFrameBuffer
+{
+public:
+   CRcvFrameBuffer(int size = 256);
+   ~CRcvFrameBuffer();
+
+      // Functionality:
+      //    Record the arrival of a chunk.
+      // Parameters:
+      //    0) [in] frame_id: VR frame ID
+      //    1) [in] chunk_id: VR chunk ID
+      //    2) [in] total_chunks: VR total chunks in frame
+      //    3) [in] pos: receiver buffer position of the first chunk of the frame.
+      //    4) [in] seqno: sequence number of the first chunk of the frame.
+      //    5) [in] msgno: message number of the frame.
+      //    6) [in] deadline: frame deadline on the sender's time base, 0 if there is none.
+      //    7) [in] groups: for a parity chunk (chunk_id >= total_chunks), the number of parity chunks of the frame.
+      //    8) [in] timestamp: time the sender sent the chunk, on the sender's time base, -1 if it is unknown.
+      //    9) [in] required: number of chunks in the required layers of the frame, 0 if the frame has no layers.
+      //    10) [in] layerend: if the chunk is the last one of its layer.
+      // Returned value:
+      //    true if the chunk makes the frame ready, otherwise false.
+
+   bool addChunk(uint16_t frame_id, uint8_t chunk_id, uint8_t total_chunks, int pos,
+                 int32_t seqno = -1, int32_t msgno = 0, int64_t deadline = 0, int groups = 0, int64_t timestamp = -1,
+                 int required = 0, bool layerend = false);
+
+      // Functionality:
+      //    Record that the sender has shed the optional chunks of a frame from a chunk on. The frame is ready once
+      //    the chunks before have arrived, with its leading complete layers.
+      // Parameters:
+      //    0) [in] frame_id: VR frame ID
+      //    1) [in] from: ID of the first chunk shed.
+      //    2) [out] pos: receiver buffer position of the first chunk of the frame.
+      //    3) [out] seqno: sequence number of the first chunk of the frame.
+      //    4) [out] chunks: number of data chunks in the frame.
+      //    5) [out] deadline: frame deadline.
+      // Returned value:
+      //    true if the frame is ready now, otherwise false.
+
+   bool shedChunks(uint16_t frame_id, int from, int& pos, int32_t& seqno, int& chunks, int64_t& deadline);
+
+      // Functionality:
+      //    Make a frame that is still waiting for chunks ready with its leading complete layers, e.g., at its deadline.
+      // Parameters:
+      //    0) [in] frame_id: VR frame ID
+      //    1) [out] pos: receiver buffer position of the first chunk of the frame.
+      //    2) [out] seqno: sequence number of the first chunk of the frame.
+      //    3) [out] chunks: number of data chunks in the frame.
+      //    4) [out] readable: number of leading chunks the frame is read with.
+      //    5) [out] deadline: frame deadline.
+      // Returned value:
+      //    true if the frame is ready now, false if it is not waiting or misses a chunk of its required layers.
+
+   bool settleFrame(uint16_t frame_id, int& pos, int32_t& seqno, int& chunks, int& readable, int64_t& deadline);
+
+      // Functionality:
+      //    Query if a frame is still waiting for chunks, i.e., it is neither complete nor dropped.
+      // Parameters:
+      //    0) [in] frame_id: VR frame ID
+      // Returned value:
+      //    true if the frame is waiting for chunks, otherwise false.
+
+   bool isPending(uint16_t frame_id) const;
+
+      // Functionality:
+      //    Query if a frame is ready without some of its optional layers.
+      // Parameters:
+      //    0) [in] frame_id: VR frame ID
+      // Returned value:
+      //    true if the frame is ready and some of its chunks will not be read, otherwise false.
+
+   bool isPartial(uint16_t frame_id) const;
+
+      // Functionality:
+      //    Query the number of parity chunks of a frame, as far as the receiver knows.
+      // Parameters:
+      //    0) [in] frame_id: VR frame ID
+      // Returned value:
+      //    number of parity chunks, 0 if none of them has arrived.
+
+   int getGroups(uint16_t frame_id) const;
+
+      // Functionality:
+      //    Query when the sender started to send a frame, as far as the receiver knows.
+      // Parameters:
+      //    0) [in] frame_id: VR frame ID
+      // Returned value:
+      //    earliest sending time of the chunks received so far, on the sender's time base, -1 if it is unknown.
+
+   int64_t getSentTime(uint16_t frame_id) const;
+
+      // Functionality:
+      //    Find a lost chunk of a frame that its parity can rebuild: the only missing chunk of a group whose parity has arrived.
+      // Parameters:
+      //    0) [in] frame_id: VR frame ID
+      //    1) [out] chunk: ID of the chunk.
+      //    2) [out] pos: receiver buffer position of the first chunk of the frame.
+      //    3) [out] chunks: number of data chunks in the frame.
+      //    4) [out] groups: number of parity chunks of the frame.
+      //    5) [out] seqno: sequence number of the first chunk of the frame.
+      // Returned value:
+      //    true if such a chunk is found, otherwise false.
+
+   bool getRecoverable(uint16_t frame_id, int& chunk, int& pos, int& chunks, int& groups, int32_t& seqno) const;
+
+      // Functionality:
+      //    Get the chunks a frame is missing up to a sequence number, in the loss list format of a NAK.
+      // Parameters:
+      //    0) [in] frame_id: VR frame ID
+      //    1) [in] last: only chunks up to this sequence number are reported.
+      //    2) [out] array: the encoded loss list.
+      //    3) [out] len: physical length of the array.
+      //    4) [in] limit: maximum length of the array.
+      // Returned value:
+      //    None.
+
+   void getLossArray(uint16_t frame_id, int32_t last, int32_t* array, int& len, int limit) const;
+
+      // Functionality:
+      //    Take the next ready frame, in the order the frames became ready.
+      // Parameters:
+      //    0) [out] frame_id: VR frame ID
+      //    1) [out] pos: receiver buffer position of the first chunk of the frame.
+      //    2) [out] chunks: number of leading chunks to read, fewer than total if only some layers are there.
+      //    3) [out] total: number of data chunks in the frame.
+      // Returned value:
+      //    true if a ready frame is available, otherwise false.
+
+   bool getReadyFrame(uint16_t& frame_id, int& pos, int& chunks, int& total);
+
+      // Functionality:
+      //    Mark a frame as dropped by the sender, unless it has already arrived completely.
+      // Parameters:
+      //    0) [in] frame_id: VR frame ID
+      // Returned value:
+      //    true if the frame is dropped now, false if it is ready or has been dropped before.
+
+   bool dropFrame(uint16_t frame_id);
+
+      // Functionality:
+      //    Find the next incomplete frame whose deadline is before the given time.
+      // Parameters:
+      //    0) [in] now: time on the sender's time base.
+      //    1) [in, out] slot: where to continue the search, 0 to start from the beginning.
+      //    2) [out] frame_id: VR frame ID
+      //    3) [out] seqno: sequence number of the first chunk of the frame.
+      //    4) [out] chunks: number of chunks in the frame.
+      //    5) [out] msgno: message number of the frame.
+      //    6) [out] deadline: frame deadline.
+      // Returned value:
+      //    true if such a frame is found, otherwise false.
+
+   bool getExpiredFrame(int64_t now, int& slot, uint16_t& frame_id, int32_t& seqno, int& chunks, int32_t& msgno, int64_t& deadline);
+
+      // Functionality:
+      //    Query how many ready frames are waiting to be read.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    number of ready frames.
+
+   int getReadyFrameNum() const;
+
+      // Functionality:
+      //    Follow the sender's clock with a chunk just received. The lowest difference between the local time and the
+      //    timestamps, i.e., the clock offset plus the shortest one-way delay, maps frame deadlines and sending times to
+      //    the local clock; two 10-second windows follow clock drift. The differences wrap with the timestamps.
+      // Parameters:
+      //    0) [in] now: local time, in microseconds.
+      //    1) [in] timestamp: timestamp of the chunk.
+      // Returned value:
+      //    None.
+
+   void updateClock(int64_t now, int32_t timestamp);
+
+      // Functionality:
+      //    Read the sender's clock: at "now" it reads at least this, as no chunk can arrive sooner than the quickest did.
+      // Parameters:
+      //    0) [in] now: local time, in microseconds.
+      // Returned value:
+      //    time on the sender's time base, wrapped to 32 bits as the timestamps are; -1 before the first chunk.
+
+   int64_t getSenderTime(int64_t now) const;
+
+private:
+   struct Frame
+   {
+      int32_t m_iFrameID;               // frame ID, -1 if the slot is empty
+      int m_iTotalChunks;               // number of data chunks in the frame
+      int m_iReceived;                  // number of data chunks received, -1 if the frame has been dropped
+      int m_iRequired;                  // number of chunks in the required layers, m_iTotalChunks if the frame has no optional layer
+      int m_iLimit;                     // number of leading chunks the sender still sends, fewer once it sheds optional layers
+      int m_iReadable;                  // number of leading chunks the frame is read with, 0 until it is ready
+      uint32_t m_piBitmap[8];           // one bit per received chunk, parity chunks included
+      uint32_t m_piLayerEnd[8];         // one bit per received chunk that is the last one of its layer
+      int m_iGroups;                    // number of parity chunks, 0 if none has arrived
+      int m_iPos;                       // receiver buffer position of the first chunk
+      int32_t m_iSeqNo;                 // sequence number of the first chunk, -1 if unknown
+      int32_t m_iMsgNo;                 // message number of the frame
+      int64_t m_llDeadline;             // frame deadline on the sender's time base, 0 if there is none
+      int64_t m_llSentTime;             // earliest sending time of the chunks received, on the sender's time base, -1 if unknown
+   } *m_pFrame;                         // frame slots, indexed by frame ID modulo the size
+
+   int m_iSize;                         // number of frame slots (frames in flight)
+
+   uint16_t* m_piReadyFrame;            // circular queue of complete frames
+   int m_iReadyHead;                    // first complete frame
+   int m_iReadyTail;                    // one past the last complete frame
+
+   mutable pthread_mutex_t m_FrameLock; // used to synchronize the worker thread and recvframe
+
+   uint32_t m_iClockDelta;              // local time minus sender timestamp, lowest over the last two windows, used by the worker thread only
+   uint32_t m_iClockWindowMin;          // lowest difference in the current window
+   int64_t m_llClockWindowEnd;          // end of the current window, in local microseconds, 0 before the first chunk
+
+private:
+      // Functionality:
+      //    number of leading chunks a frame can be read with, cut back to the end of its last complete layer.
+      // Parameters:
+      //    0) [in] f: the frame.
+      // Returned value:
+      //    number of chunks, 0 if the chunks below the limit have not all arrived or do not cover the required layers.
+
+   int getReadable(const Frame* f) const;
+
+      // Functionality:
+      //    append a frame to the queue of ready frames, the oldest one is lost if the queue is full.
+      // Parameters:
+      //    0) [in] frame_id: VR frame ID
+      // Returned value:
+      //    None.
+
+   void pushReady(uint16_t frame_id);
+
+private:
+   CRcvFrameBuffer(const CRcvFrameBuffer&);
+   CRcvFrameBuffer& operator=(const CRcvFrameBuffer&);
+};
+
 
 #endif
@@ -44,6 +44,12 @@ written by
    #ifdef LEGACY_WIN32
       #include <wspiapi.h>
    #endif
+#else
+   #include <unistd.h>
+   #include <fcntl.h>
+   #include <sys/file.h>
+   #include <sys/mman.h>
+   #include <sys/stat.h>
 #endif
 
 #include <cstring>
@@ -52,9 +58,23 @@ written by
 
 using namespace std;
 
+CInfoBlock::CInfoBlock():
+m_iIPversion(0),
+m_ullTimeStamp(0),
+m_iRTT(0),
+m_iBandwidth(0),
+m_iLossRate(0),
+m_iReorderDistance(0),
+m_dInterval(0),
+m_dCWnd(0)
+{
+   for (int i = 0; i < 4; ++ i)
+      m_piIP[i] = 0;
+}
+
 CInfoBlock& CInfoBlock::operator=(const CInfoBlock& obj)
 {
-   std::copy(obj.m_piIP, obj.m_piIP + 3, m_piIP);
+   std::copy(obj.m_piIP, obj.m_piIP + 4, m_piIP);
    m_iIPversion = obj.m_iIPversion;
    m_ullTimeStamp = obj.m_ullTimeStamp;
    m_iRTT = obj.m_iRTT;
@@ -88,7 +108,7 @@ CInfoBlock* CInfoBlock::clone()
 {
    CInfoBlock* obj = new CInfoBlock;
 
-   std::copy(m_piIP, m_piIP + 3, obj->m_piIP);
+   std::copy(m_piIP, m_piIP + 4, obj->m_piIP);
    obj->m_iIPversion = m_iIPversion;
    obj->m_ullTimeStamp = m_ullTimeStamp;
    obj->m_iRTT = m_iRTT;
@@ -103,10 +123,11 @@ CInfoBlock* CInfoBlock::clone()
 
 int CInfoBlock::getKey()
 {
+   // the key must not be negative, or the address is never cached
    if (m_iIPversion == AF_INET)
-      return m_piIP[0];
+      return m_piIP[0] & 0x7FFFFFFF;
 
-   return m_piIP[0] + m_piIP[1] + m_piIP[2] + m_piIP[3];
+   return (m_piIP[0] + m_piIP[1] + m_piIP[2] + m_piIP[3]) & 0x7FFFFFFF;
 }
 
 void CInfoBlock::convert(const sockaddr* addr, int ver, uint32_t ip[])
@@ -121,3 +142,210 @@ void CInfoBlock::convert(const sockaddr* addr, int ver, uint32_t ip[])
       memcpy((char*)ip, (char*)((sockaddr_in6*)addr)->sin6_addr.s6_addr, 16);
    }
 }
+
+// the file starts with this header, the records follow
+struct CSharedInfoHeader
+{
+   uint32_t m_iMagic;
+   uint32_t m_iRecords;
+   uint32_t m_iRecordSize;
+   char m_pcPad[52];
+};
+
+static const uint32_t g_iInfoCacheMagic = 0x55445443;      // "UDTC"
+static const int32_t g_iMaxCachedRTT = 60000000;           // largest RTT taken from the file, microseconds
+static const double g_dMaxCachedInterval = 1000000.0;      // largest inter-packet time taken from the file, microseconds
+
+CSharedInfoCache::CSharedInfoCache():
+m_pcFile(NULL),
+m_pRecords(NULL),
+m_ullMaxAge(0)
+{
+}
+
+CSharedInfoCache::~CSharedInfoCache()
+{
+   #ifndef WIN32
+      if (NULL != m_pcFile)
+         munmap(m_pcFile, sizeof(CSharedInfoHeader) + m_iRecords * sizeof(CRecord));
+   #endif
+}
+
+#ifndef WIN32
+int CSharedInfoCache::open(const char* path, int maxage)
+{
+   if ((NULL != m_pcFile) || (maxage <= 0))
+      return -1;
+
+   // the records steer the sending rate of every process that reads them: only the user may write them
+   int fd = ::open(path, O_RDWR | O_CREAT, 0600);
+   if (fd < 0)
+      return -1;
+
+   // the first process sizes the file and writes the header, under the lock the others wait on;
+   // a file another user owns or may write, created before this process opened it, is not used
+   int size = sizeof(CSharedInfoHeader) + m_iRecords * sizeof(CRecord);
+   struct stat st;
+   void* p = MAP_FAILED;
+   flock(fd, LOCK_EX);
+   if ((fstat(fd, &st) == 0) && (st.st_uid == geteuid()) && (0 == (st.st_mode & (S_IWGRP | S_IWOTH))) &&
+      ((st.st_size == size) || ((0 == st.st_size) && (ftruncate(fd, size) == 0))))
+      p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+   if (MAP_FAILED == p)
+   {
+      flock(fd, LOCK_UN);
+      ::close(fd);
+      return -1;
+   }
+
+   CSharedInfoHeader* hdr = (CSharedInfoHeader*)p;
+   if (0 == hdr->m_iMagic)
+   {
+      hdr->m_iRecords = m_iRecords;
+      hdr->m_iRecordSize = sizeof(CRecord);
+      hdr->m_iMagic = g_iInfoCacheMagic;
+   }
+   flock(fd, LOCK_UN);
+   ::close(fd);
+
+   if ((hdr->m_iMagic != g_iInfoCacheMagic) || (hdr->m_iRecords != (uint32_t)m_iRecords) || (hdr->m_iRecordSize != sizeof(CRecord)))
+   {
+      munmap(p, size);
+      return -1;
+   }
+
+   m_pcFile = (char*)p;
+   m_pRecords = (CRecord*)(m_pcFile + sizeof(CSharedInfoHeader));
+   m_ullMaxAge = maxage * 1000000ULL;
+
+   return 0;
+}
+#else
+int CSharedInfoCache::open(const char*, int)
+{
+   return -1;
+}
+#endif
+
+int CSharedInfoCache::getSlot(const CInfoBlock* data) const
+{
+   uint32_t h = 2166136261U;
+   for (int i = 0; i < 4; ++ i)
+      h = (h ^ data->m_piIP[i]) * 16777619U;
+
+   return (h % (m_iRecords / m_iWays)) * m_iWays;
+}
+
+bool CSharedInfoCache::read(CRecord* rec, CRecord& copy) const
+{
+   // a writer holds a record for a few stores only, a few retries will do
+   for (int i = 0; i < 16; ++ i)
+   {
+      uint32_t seq = __atomic_load_n(&rec->m_iSeqNo, __ATOMIC_ACQUIRE);
+      if (0 != (seq & 1))
+         continue;
+
+      memcpy(&copy, rec, sizeof(CRecord));
+
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&rec->m_iSeqNo, __ATOMIC_RELAXED) == seq)
+         return true;
+   }
+
+   return false;
+}
+
+int CSharedInfoCache::lookup(CInfoBlock* data)
+{
+   if (NULL == m_pcFile)
+      return -1;
+
+   uint64_t currtime = CTimer::getTime();
+   int slot = getSlot(data);
+   CRecord found;
+   memset(&found, 0, sizeof(CRecord));
+
+   for (int i = slot; i < slot + m_iWays; ++ i)
+   {
+      CRecord rec;
+      if (!read(m_pRecords + i, rec) || (0 == rec.m_ullTimeStamp) || (rec.m_iIPversion != data->m_iIPversion)
+         || (0 != memcmp(rec.m_piIP, data->m_piIP, sizeof(rec.m_piIP))))
+         continue;
+
+      // two processes may have stored the same address at once, the latest wins
+      if (rec.m_ullTimeStamp > found.m_ullTimeStamp)
+         found = rec;
+   }
+
+   if ((0 == found.m_ullTimeStamp) || (found.m_ullTimeStamp + m_ullMaxAge < currtime))
+      return -1;
+
+   // a record no connection could have measured, from a broken or hostile writer, is not used
+   if ((found.m_iRTT <= 0) || (found.m_iRTT > g_iMaxCachedRTT) || (found.m_iBandwidth <= 0) ||
+      (found.m_iLossRate < 0) || (found.m_iReorderDistance < 0) ||
+      !(found.m_dInterval >= 0) || (found.m_dInterval > g_dMaxCachedInterval) || !(found.m_dCWnd >= 0))
+      return -1;
+
+   data->m_ullTimeStamp = found.m_ullTimeStamp;
+   data->m_iRTT = found.m_iRTT;
+   data->m_iBandwidth = found.m_iBandwidth;
+   data->m_iLossRate = found.m_iLossRate;
+   data->m_iReorderDistance = found.m_iReorderDistance;
+   data->m_dInterval = found.m_dInterval;
+   data->m_dCWnd = found.m_dCWnd;
+
+   return 0;
+}
+
+int CSharedInfoCache::update(CInfoBlock* data)
+{
+   if (NULL == m_pcFile)
+      return -1;
+
+   // the record of the address if it is there, otherwise the oldest of the slots
+   int slot = getSlot(data);
+   CRecord* target = NULL;
+   uint64_t oldest = 0;
+
+   for (int i = slot; i < slot + m_iWays; ++ i)
+   {
+      CRecord rec;
+      if (!read(m_pRecords + i, rec))
+         continue;
+
+      if ((0 != rec.m_ullTimeStamp) && (rec.m_iIPversion == data->m_iIPversion) && (0 == memcmp(rec.m_piIP, data->m_piIP, sizeof(rec.m_piIP))))
+      {
+         target = m_pRecords + i;
+         break;
+      }
+
+      if ((NULL == target) || (rec.m_ullTimeStamp < oldest))
+      {
+         target = m_pRecords + i;
+         oldest = rec.m_ullTimeStamp;
+      }
+   }
+
+   if (NULL == target)
+      return -1;
+
+   uint32_t seq = __atomic_load_n(&target->m_iSeqNo, __ATOMIC_RELAXED);
+   if ((0 != (seq & 1)) || !__atomic_compare_exchange_n(&target->m_iSeqNo, &seq, seq + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      return -1;
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+
+   target->m_iIPversion = data->m_iIPversion;
+   memcpy(target->m_piIP, data->m_piIP, sizeof(target->m_piIP));
+   target->m_ullTimeStamp = CTimer::getTime();
+   target->m_iRTT = data->m_iRTT;
+   target->m_iBandwidth = data->m_iBandwidth;
+   target->m_iLossRate = data->m_iLossRate;
+   target->m_iReorderDistance = data->m_iReorderDistance;
+   target->m_dInterval = data->m_dInterval;
+   target->m_dCWnd = data->m_dCWnd;
+
+   __atomic_store_n(&target->m_iSeqNo, seq + 2, __ATOMIC_RELEASE);
+
+   return 0;
+}
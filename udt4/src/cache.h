@@ -268,6 +268,7 @@ public:
    double m_dCWnd;		// congestion window size, congestion control
 
 public:
+   CInfoBlock();
    virtual ~CInfoBlock() {}
    virtual CInfoBlock& operator=(const CInfoBlock& obj);
    virtual bool operator==(const CInfoBlock& obj);
@@ -290,4 +291,78 @@ public:
 };
 
 
+// Path information (CInfoBlock) kept in a file that all the UDT processes of the host map, so that a new
+// process starts where the others have left. The records have a fixed place in a few slots picked by the
+// address. Each record carries a sequence number that is odd while it is written: readers retry on a
+// change, and a writer that finds the record taken gives its update up instead of waiting.
+class CSharedInfoCache
+{
+public:
+   CSharedInfoCache();
+   ~CSharedInfoCache();
+
+public:
+
+      // Functionality:
+      //    Map the cache file, and create it if it does not exist. The file must belong to the user and be
+      //    writable by no one else.
+      // Parameters:
+      //    0) [in] path: the file, the same for all the processes sharing it.
+      //    1) [in] maxage: records not updated for this long are not used, in seconds.
+      // Returned value:
+      //    0 if success, otherwise -1.
+
+   int open(const char* path, int maxage);
+
+      // Functionality:
+      //    find the latest record of an address.
+      // Parameters:
+      //    0) [in/out] data: storage for the retrieved item; initially it must carry the address
+      // Returned value:
+      //    0 if found a match, otherwise -1.
+
+   int lookup(CInfoBlock* data);
+
+      // Functionality:
+      //    Store the record of an address, over the oldest record of its slots if it is not there yet.
+      // Parameters:
+      //    0) [in] data: the new record.
+      // Returned value:
+      //    0 if success, -1 if another process was writing the same record.
+
+   int update(CInfoBlock* data);
+
+public:
+   static const int m_iRecords = 4096;          // number of records in the file
+   static const int m_iWays = 4;                // number of slots an address can take
+
+private:
+   struct CRecord
+   {
+      uint32_t m_iSeqNo;                        // odd while the record is written
+      int32_t m_iIPversion;
+      uint32_t m_piIP[4];
+      uint64_t m_ullTimeStamp;                  // last update, 0 if the record is free
+      int32_t m_iRTT;
+      int32_t m_iBandwidth;
+      int32_t m_iLossRate;
+      int32_t m_iReorderDistance;
+      double m_dInterval;
+      double m_dCWnd;
+   };
+
+   bool read(CRecord* rec, CRecord& copy) const;
+   int getSlot(const CInfoBlock* data) const;
+
+private:
+   char* m_pcFile;                              // the mapping, NULL if not open
+   CRecord* m_pRecords;                         // the records in it
+   uint64_t m_ullMaxAge;                        // age of the records that are not used, in microseconds
+
+private:
+   CSharedInfoCache(const CSharedInfoCache&);
+   CSharedInfoCache& operator=(const CSharedInfoCache&);
+};
+
+
 #endif
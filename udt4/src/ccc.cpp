@@ -54,6 +54,7 @@ m_iMSS(),
 m_iSndCurrSeqNo(),
 m_iRcvRate(),
 m_iRTT(),
+m_dPathSndPeriod(0),
 m_pcParam(NULL),
 m_iPSize(0),
 m_UDT(),
@@ -143,6 +144,11 @@ void CCC::setRTT(int rtt)
    m_iRTT = rtt;
 }
 
+void CCC::setPathSndPeriod(double period)
+{
+   m_dPathSndPeriod = period;
+}
+
 void CCC::setUserParam(const char* param, int size)
 {
    delete [] m_pcParam;
@@ -184,6 +190,21 @@ void CUDTCC::init()
 
    m_dCWndSize = 16;
    m_dPktSndPeriod = 1;
+
+   // a path that carried data recently resumes at half that rate, with the window it needs at that rate,
+   // instead of probing from scratch in slow start; never faster than the bandwidth estimate, and a period
+   // that cannot be a measure of the path (not finite, or slower than one packet per second) is not used
+   if ((m_dPathSndPeriod > 0) && (m_dPathSndPeriod <= 1000000.0))
+   {
+      m_bSlowStart = false;
+      m_dPktSndPeriod = m_dPathSndPeriod * 2;
+      if ((m_iBandwidth > 0) && (m_dPktSndPeriod < 1000000.0 / m_iBandwidth))
+         m_dPktSndPeriod = 1000000.0 / m_iBandwidth;
+      m_dLastDecPeriod = m_dPktSndPeriod;
+      m_dCWndSize = (m_iRTT + m_iRCInterval) / m_dPktSndPeriod + 16;
+      if (m_dCWndSize > m_dMaxCWndSize)
+         m_dCWndSize = m_dMaxCWndSize;
+   }
 }
 
 void CUDTCC::onACK(int32_t ack)
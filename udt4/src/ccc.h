@@ -109,7 +109,7 @@ public:
    virtual void onTimeout() {}
 
       // Functionality:
-      //    Callback function to be called when a data is sent.
+      //    Callback function to be called when a data is sent. A new m_dPktSndPeriod set here paces the next packet.
       // Parameters:
       //    0) [in] seqno: the data sequence number.
       //    1) [in] size: the payload size.
@@ -201,6 +201,7 @@ private:
    void setSndCurrSeqNo(int32_t seqno);
    void setRcvRate(int rcvrate);
    void setRTT(int rtt);
+   void setPathSndPeriod(double period);
 
 protected:
    const int32_t& m_iSYNInterval;	// UDT constant parameter, SYN
@@ -215,6 +216,7 @@ protected:
    int32_t m_iSndCurrSeqNo;		// current maximum seq no sent out
    int m_iRcvRate;			// packet arrive rate at receiver side, packets per second
    int m_iRTT;				// current estimated RTT, microsecond
+   double m_dPathSndPeriod;		// packet sending period the path carried in a recent connection, 0 if unknown
 
    char* m_pcParam;			// user defined parameter
    int m_iPSize;			// size of m_pcParam
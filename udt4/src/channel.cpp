@@ -46,6 +46,32 @@ written by
    #include <cstring>
    #include <cstdio>
    #include <cerrno>
+   #ifdef LINUX
+      #include <netinet/udp.h>
+      #include <linux/filter.h>
+      #ifndef SO_ATTACH_REUSEPORT_CBPF
+         #define SO_ATTACH_REUSEPORT_CBPF 51
+      #endif
+      // defined by Linux 4.18 (UDP_SEGMENT) and 5.0 (UDP_GRO), but not by older C libraries
+      #ifndef UDP_SEGMENT
+         #define UDP_SEGMENT 103
+      #endif
+      #ifndef UDP_GRO
+         #define UDP_GRO 104
+      #endif
+      // the io_uring backend needs the wait time-out of Linux 5.11 headers; older ones leave the channel on sendmmsg/recvmmsg
+      #if defined(__has_include)
+         #if __has_include(<linux/io_uring.h>)
+            #include <linux/io_uring.h>
+            #include <sys/mman.h>
+            #include <sys/syscall.h>
+            #include <csignal>
+            #ifdef IORING_FEAT_EXT_ARG
+               #define HAVE_URING
+            #endif
+         #endif
+      #endif
+   #endif
 #else
    #include <winsock2.h>
    #include <ws2tcpip.h>
@@ -56,6 +82,14 @@ written by
 #include "channel.h"
 #include "packet.h"
 
+#if defined(__SSSE3__)
+   #include <tmmintrin.h>
+#elif defined(__SSE2__)
+   #include <emmintrin.h>
+#elif defined(__ARM_NEON) && !defined(__ARM_BIG_ENDIAN)
+   #include <arm_neon.h>
+#endif
+
 #ifdef WIN32
    #define socklen_t int
 #endif
@@ -67,12 +101,224 @@ written by
 #endif
 
 
+#ifdef HAVE_URING
+// A minimal io_uring: a submission and a completion queue, mapped in one piece, used by a single thread.
+class CURing
+{
+public:
+   CURing():
+   m_iFD(-1),
+   m_pcRing(NULL),
+   m_iRingSize(0),
+   m_pSQEs(NULL),
+   m_iSQESize(0),
+   m_iLocalTail(0),
+   m_iToSubmit(0)
+   {
+   }
+
+   ~CURing()
+   {
+      if (NULL != m_pSQEs)
+         ::munmap(m_pSQEs, m_iSQESize);
+      if (NULL != m_pcRing)
+         ::munmap(m_pcRing, m_iRingSize);
+      if (m_iFD >= 0)
+         ::close(m_iFD);
+   }
+
+      // Functionality:
+      //    Set up the ring.
+      // Parameters:
+      //    0) [in] entries: size of the submission queue; the completion queue is twice as large.
+      // Returned value:
+      //    true if the kernel supports what the channel needs.
+
+   bool init(unsigned entries)
+   {
+      io_uring_params p;
+      memset(&p, 0, sizeof(io_uring_params));
+      m_iFD = ::syscall(__NR_io_uring_setup, entries, &p);
+      if (m_iFD < 0)
+         return false;
+
+      if ((0 == (p.features & IORING_FEAT_EXT_ARG)) || (0 == (p.features & IORING_FEAT_SINGLE_MMAP)))
+         return false;
+
+      m_iRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+      if (m_iRingSize < p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe))
+         m_iRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+
+      void* ring = ::mmap(NULL, m_iRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_iFD, IORING_OFF_SQ_RING);
+      if (MAP_FAILED == ring)
+         return false;
+      m_pcRing = (char*)ring;
+
+      m_iSQESize = p.sq_entries * sizeof(io_uring_sqe);
+      void* sqes = ::mmap(NULL, m_iSQESize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_iFD, IORING_OFF_SQES);
+      if (MAP_FAILED == sqes)
+         return false;
+      m_pSQEs = (io_uring_sqe*)sqes;
+
+      m_piSQHead = (unsigned*)(m_pcRing + p.sq_off.head);
+      m_piSQTail = (unsigned*)(m_pcRing + p.sq_off.tail);
+      m_piSQArray = (unsigned*)(m_pcRing + p.sq_off.array);
+      m_iSQMask = *(unsigned*)(m_pcRing + p.sq_off.ring_mask);
+      m_iSQEntries = p.sq_entries;
+      m_piCQHead = (unsigned*)(m_pcRing + p.cq_off.head);
+      m_piCQTail = (unsigned*)(m_pcRing + p.cq_off.tail);
+      m_iCQMask = *(unsigned*)(m_pcRing + p.cq_off.ring_mask);
+      m_pCQEs = (io_uring_cqe*)(m_pcRing + p.cq_off.cqes);
+
+      m_iLocalTail = *m_piSQTail;
+
+      return true;
+   }
+
+      // Functionality:
+      //    Take the next free submission queue entry, cleared.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    The entry, or NULL if the queue is full.
+
+   io_uring_sqe* getSQE()
+   {
+      if (m_iLocalTail - __atomic_load_n(m_piSQHead, __ATOMIC_ACQUIRE) >= m_iSQEntries)
+         return NULL;
+
+      unsigned i = m_iLocalTail & m_iSQMask;
+      m_piSQArray[i] = i;
+      ++ m_iLocalTail;
+      ++ m_iToSubmit;
+
+      memset(m_pSQEs + i, 0, sizeof(io_uring_sqe));
+      return m_pSQEs + i;
+   }
+
+      // Functionality:
+      //    Submit the entries taken, and wait for completions, all in one system call.
+      // Parameters:
+      //    0) [in] wait: number of completions to wait for.
+      //    1) [in] timeout: longest wait, in microseconds; negative for no limit.
+      // Returned value:
+      //    Number of entries submitted, -1 on error (ETIME if the time-out has passed).
+
+   int enter(int wait, int timeout)
+   {
+      __atomic_store_n(m_piSQTail, m_iLocalTail, __ATOMIC_RELEASE);
+
+      unsigned flags = (wait > 0) ? IORING_ENTER_GETEVENTS : 0;
+      io_uring_getevents_arg arg;
+      __kernel_timespec ts;
+      if ((wait > 0) && (timeout >= 0))
+      {
+         ts.tv_sec = timeout / 1000000;
+         ts.tv_nsec = (timeout % 1000000) * 1000;
+         memset(&arg, 0, sizeof(io_uring_getevents_arg));
+         arg.sigmask_sz = _NSIG / 8;
+         arg.ts = (uint64_t)(uintptr_t)&ts;
+         flags |= IORING_ENTER_EXT_ARG;
+      }
+
+      int res;
+      if (0 != (flags & IORING_ENTER_EXT_ARG))
+         res = ::syscall(__NR_io_uring_enter, m_iFD, m_iToSubmit, wait, flags, &arg, sizeof(io_uring_getevents_arg));
+      else
+         res = ::syscall(__NR_io_uring_enter, m_iFD, m_iToSubmit, wait, flags, NULL, 0);
+
+      if (res > 0)
+         m_iToSubmit -= res;
+
+      return res;
+   }
+
+      // Functionality:
+      //    Look at the oldest completion not yet seen.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    The completion, or NULL if there is none.
+
+   io_uring_cqe* peek() const
+   {
+      unsigned head = *m_piCQHead;
+      if (head == __atomic_load_n(m_piCQTail, __ATOMIC_ACQUIRE))
+         return NULL;
+
+      return m_pCQEs + (head & m_iCQMask);
+   }
+
+      // Functionality:
+      //    Hand the completion returned by peek back to the kernel.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    None.
+
+   void seen()
+   {
+      __atomic_store_n(m_piCQHead, *m_piCQHead + 1, __ATOMIC_RELEASE);
+   }
+
+private:
+   int m_iFD;                           // ring descriptor
+   char* m_pcRing;                      // both queues, mapped in one piece
+   size_t m_iRingSize;                  // size of the mapping
+   io_uring_sqe* m_pSQEs;               // submission queue entries
+   size_t m_iSQESize;                   // size of their mapping
+
+   unsigned* m_piSQHead;                // submission queue head, moved by the kernel
+   unsigned* m_piSQTail;                // submission queue tail, published on enter
+   unsigned* m_piSQArray;               // index of the entry in each slot of the submission queue
+   unsigned m_iSQMask;                  // submission queue index mask
+   unsigned m_iSQEntries;               // submission queue size
+   unsigned* m_piCQHead;                // completion queue head
+   unsigned* m_piCQTail;                // completion queue tail, moved by the kernel
+   unsigned m_iCQMask;                  // completion queue index mask
+   io_uring_cqe* m_pCQEs;               // completion queue entries
+
+   unsigned m_iLocalTail;               // submission queue tail, including entries not yet published
+   int m_iToSubmit;                     // number of entries taken but not yet submitted
+};
+
+// a receive posted into a packet, until the kernel completes it
+struct CRecvSlot
+{
+   msghdr m_Msg;                        // the message the kernel fills
+   sockaddr_in6 m_Addr;                 // source address, large enough for either IP version
+   CPacket* m_pPacket;                  // the packet being filled
+   void* m_pContext;                    // the caller's value, returned with the packet
+   bool m_bPosted;                      // if the slot is in use
+};
+#endif
+
+const int CChannel::m_iMaxBatchSize;
+const int CChannel::m_iMaxPosted;
+const uint32_t CChannel::m_iSteeringHash;
+
 CChannel::CChannel():
 m_iIPversion(AF_INET),
 m_iSockAddrSize(sizeof(sockaddr_in)),
 m_iSocket(),
 m_iSndBufSize(65536),
-m_iRcvBufSize(65536)
+m_iRcvBufSize(65536),
+m_bReusePort(false),
+m_bOffload(false),
+m_bGSO(false),
+m_bGRO(false),
+m_pcGROBuffer(NULL),
+m_pGROAddr(NULL),
+m_iGROSize(0),
+m_iGROSegSize(0),
+m_iGROPos(0),
+m_piCtrlStage(NULL),
+m_iCtrlStageSize(0),
+m_bURing(false),
+m_pSndRing(NULL),
+m_pRcvRing(NULL),
+m_pRecvSlot(NULL),
+m_iPosted(0)
 {
 }
 
@@ -80,13 +326,42 @@ CChannel::CChannel(int version):
 m_iIPversion(version),
 m_iSocket(),
 m_iSndBufSize(65536),
-m_iRcvBufSize(65536)
+m_iRcvBufSize(65536),
+m_bReusePort(false),
+m_bOffload(false),
+m_bGSO(false),
+m_bGRO(false),
+m_pcGROBuffer(NULL),
+m_pGROAddr(NULL),
+m_iGROSize(0),
+m_iGROSegSize(0),
+m_iGROPos(0),
+m_piCtrlStage(NULL),
+m_iCtrlStageSize(0),
+m_bURing(false),
+m_pSndRing(NULL),
+m_pRcvRing(NULL),
+m_pRecvSlot(NULL),
+m_iPosted(0)
 {
    m_iSockAddrSize = (AF_INET == m_iIPversion) ? sizeof(sockaddr_in) : sizeof(sockaddr_in6);
 }
 
 CChannel::~CChannel()
 {
+   delete [] m_pcGROBuffer;
+   delete [] m_piCtrlStage;
+
+   if (AF_INET == m_iIPversion)
+      delete (sockaddr_in*)m_pGROAddr;
+   else
+      delete (sockaddr_in6*)m_pGROAddr;
+
+   #ifdef HAVE_URING
+      delete m_pSndRing;
+      delete m_pRcvRing;
+      delete [] m_pRecvSlot;
+   #endif
 }
 
 void CChannel::open(const sockaddr* addr)
@@ -101,6 +376,15 @@ void CChannel::open(const sockaddr* addr)
    #endif
       throw CUDTException(1, 0, NET_ERROR);
 
+   #ifdef SO_REUSEPORT
+      if (m_bReusePort)
+      {
+         int reuse = 1;
+         if (0 != ::setsockopt(m_iSocket, SOL_SOCKET, SO_REUSEPORT, (char *)&reuse, sizeof(int)))
+            throw CUDTException(1, 3, NET_ERROR);
+      }
+   #endif
+
    if (NULL != addr)
    {
       socklen_t namelen = m_iSockAddrSize;
@@ -130,12 +414,37 @@ void CChannel::open(const sockaddr* addr)
    }
 
    setUDPSockOpt();
+   openURing();
 }
 
 void CChannel::open(UDPSOCKET udpsock)
 {
    m_iSocket = udpsock;
    setUDPSockOpt();
+   openURing();
+}
+
+void CChannel::openURing()
+{
+   #ifdef HAVE_URING
+      if (!m_bURing || (NULL != m_pSndRing))
+         return;
+
+      // without io_uring, or on a kernel older than 5.11, the channel stays on sendmmsg/recvmmsg
+      m_pSndRing = new CURing;
+      m_pRcvRing = new CURing;
+      if (!m_pSndRing->init(m_iMaxBatchSize) || !m_pRcvRing->init(m_iMaxPosted * 2))
+      {
+         delete m_pSndRing;
+         delete m_pRcvRing;
+         m_pSndRing = m_pRcvRing = NULL;
+         return;
+      }
+
+      m_pRecvSlot = new CRecvSlot[m_iMaxPosted];
+      for (int i = 0; i < m_iMaxPosted; ++ i)
+         m_pRecvSlot[i].m_bPosted = false;
+   #endif
 }
 
 void CChannel::setUDPSockOpt()
@@ -179,6 +488,23 @@ void CChannel::setUDPSockOpt()
       if (0 != ::setsockopt(m_iSocket, SOL_SOCKET, SO_RCVTIMEO, (char *)&tv, sizeof(timeval)))
          throw CUDTException(1, 3, NET_ERROR);
    #endif
+
+   #ifdef LINUX
+      if (m_bOffload)
+      {
+         // a kernel without the option rejects it, and the channel falls back to one datagram per packet
+         int gso = 0;
+         m_bGSO = (0 == ::setsockopt(m_iSocket, IPPROTO_UDP, UDP_SEGMENT, (char *)&gso, sizeof(int)));
+
+         int gro = 1;
+         m_bGRO = (0 == ::setsockopt(m_iSocket, IPPROTO_UDP, UDP_GRO, (char *)&gro, sizeof(int)));
+         if (m_bGRO && (NULL == m_pcGROBuffer))
+         {
+            m_pcGROBuffer = new char [65536];
+            m_pGROAddr = (AF_INET == m_iIPversion) ? (sockaddr*) new sockaddr_in : (sockaddr*) new sockaddr_in6;
+         }
+      }
+   #endif
 }
 
 void CChannel::close() const
@@ -214,6 +540,65 @@ void CChannel::setRcvBufSize(int size)
    m_iRcvBufSize = size;
 }
 
+void CChannel::setOffload(bool offload)
+{
+   m_bOffload = offload;
+}
+
+int CChannel::getSteering(int32_t id, int num)
+{
+   // consecutive socket IDs are spread over the channels
+   return (((uint32_t)id * m_iSteeringHash) >> 16) % num;
+}
+
+void CChannel::setReusePort(bool reuse)
+{
+   m_bReusePort = reuse;
+}
+
+void CChannel::setURing(bool uring)
+{
+   m_bURing = uring;
+}
+
+bool CChannel::isRecvPosted() const
+{
+   // a coalesced datagram would not fit into the packet posted for it
+   return (NULL != m_pRcvRing) && !m_bGRO;
+}
+
+bool CChannel::setSteering(int num)
+{
+   #ifdef LINUX
+      // the filter sees the UDP payload: word 3 of the UDT header is the destination socket ID; the same hash as getSteering
+      sock_filter code[] =
+      {
+         BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 12),
+         BPF_STMT(BPF_ALU | BPF_MUL | BPF_K, m_iSteeringHash),
+         BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 16),
+         BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, (uint32_t)num),
+         BPF_STMT(BPF_RET | BPF_A, 0)
+      };
+      sock_fprog prog;
+      prog.len = sizeof(code) / sizeof(sock_filter);
+      prog.filter = code;
+
+      if (0 != ::setsockopt(m_iSocket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, (char *)&prog, sizeof(prog)))
+         return false;
+
+      if (m_bGRO)
+      {
+         int gro = 0;
+         ::setsockopt(m_iSocket, IPPROTO_UDP, UDP_GRO, (char *)&gro, sizeof(int));
+         m_bGRO = false;
+      }
+
+      return true;
+   #else
+      return false;
+   #endif
+}
+
 void CChannel::getSockAddr(sockaddr* addr) const
 {
    socklen_t namelen = m_iSockAddrSize;
@@ -226,28 +611,81 @@ void CChannel::getPeerAddr(sockaddr* addr) const
    ::getpeername(m_iSocket, addr, &namelen);
 }
 
-int CChannel::sendto(const sockaddr* addr, CPacket& packet) const
+void CChannel::swapWords(uint32_t* dst, const uint32_t* src, int num)
+{
+   int i = 0;
+
+   // four words per 128-bit register; the scalar loop below does the rest, and all of it on other targets
+   #if defined(__SSSE3__)
+      const __m128i mask = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+      for (; i + 4 <= num; i += 4)
+      {
+         __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+         _mm_storeu_si128((__m128i*)(dst + i), _mm_shuffle_epi8(v, mask));
+      }
+   #elif defined(__SSE2__)
+      for (; i + 4 <= num; i += 4)
+      {
+         __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+         // swap the bytes of each 16-bit half, then the two halves of each word
+         v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+         v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+         _mm_storeu_si128((__m128i*)(dst + i), v);
+      }
+   #elif defined(__ARM_NEON) && !defined(__ARM_BIG_ENDIAN)
+      for (; i + 4 <= num; i += 4)
+         vst1q_u8((uint8_t*)(dst + i), vrev32q_u8(vld1q_u8((const uint8_t*)(src + i))));
+   #endif
+
+   for (; i < num; ++ i)
+      dst[i] = htonl(src[i]);
+}
+
+void CChannel::toNetworkOrder(const CPacket& packet, uint32_t* header, uint32_t* ctrl, iovec* vec)
 {
-   // convert control information into network order
+   swapWords(header, packet.m_nHeader, packet.getHeaderSize() / 4);
+   vec[0].iov_base = (char*)header;
+   vec[0].iov_len = packet.getHeaderSize();
+   vec[1] = packet.m_PacketVector[1];
+
+   // control information is converted into the staging area too
    if (packet.getFlag())
-      for (int i = 0, n = packet.getLength() / 4; i < n; ++ i)
-         *((uint32_t *)packet.m_pcData + i) = htonl(*((uint32_t *)packet.m_pcData + i));
-
-   // convert packet header into network order
-   //for (int j = 0; j < 4; ++ j)
-   //   packet.m_nHeader[j] = htonl(packet.m_nHeader[j]);
-   uint32_t* p = packet.m_nHeader;
-   for (int j = 0; j < 4; ++ j)
    {
-      *p = htonl(*p);
-      ++ p;
+      int len = packet.getLength();
+      swapWords(ctrl, (uint32_t*)packet.m_pcData, len / 4);
+      memcpy((char*)ctrl + len / 4 * 4, packet.m_pcData + len / 4 * 4, len % 4);
+      vec[1].iov_base = (char*)ctrl;
    }
+}
+
+void CChannel::toHostOrder(CPacket& packet)
+{
+   swapWords(packet.m_nHeader, packet.m_nHeader, CPacket::m_iPktHdrSize / 4);
+
+   // control packets have the classic header, a data packet too short for the largest header has at most the one it has room for;
+   // which header the other data packets have is up to the connection
+   if (packet.getFlag())
+      packet.trimHeader(CHeaderFormat<HDR_CLASSIC>::m_iSize);
+   else if (packet.getLength() < 0)
+      packet.trimHeader((CPacket::m_iPktHdrSize + packet.getLength() >= CHeaderFormat<HDR_FRAME>::m_iSize) ? CHeaderFormat<HDR_FRAME>::m_iSize : CHeaderFormat<HDR_CLASSIC>::m_iSize);
+
+   if (packet.getFlag())
+      swapWords((uint32_t*)packet.m_pcData, (uint32_t*)packet.m_pcData, packet.getLength() / 4);
+}
+
+int CChannel::sendto(const sockaddr* addr, CPacket& packet) const
+{
+   // any thread may send a control packet, so its information is staged in a buffer of its own size for this call only
+   uint32_t header[CHeaderFormat<HDR_LAYERED>::m_iSize / 4];
+   uint32_t* ctrl = packet.getFlag() ? new uint32_t[(packet.getLength() + 3) / 4] : NULL;
+   iovec vec[2];
+   toNetworkOrder(packet, header, ctrl, vec);
 
    #ifndef WIN32
       msghdr mh;
       mh.msg_name = (sockaddr*)addr;
       mh.msg_namelen = m_iSockAddrSize;
-      mh.msg_iov = (iovec*)packet.m_PacketVector;
+      mh.msg_iov = vec;
       mh.msg_iovlen = 2;
       mh.msg_control = NULL;
       mh.msg_controllen = 0;
@@ -255,33 +693,21 @@ int CChannel::sendto(const sockaddr* addr, CPacket& packet) const
 
       int res = ::sendmsg(m_iSocket, &mh, 0);
    #else
-      DWORD size = CPacket::m_iPktHdrSize + packet.getLength();
+      DWORD size = packet.getHeaderSize() + packet.getLength();
       int addrsize = m_iSockAddrSize;
-      int res = ::WSASendTo(m_iSocket, (LPWSABUF)packet.m_PacketVector, 2, &size, 0, addr, addrsize, NULL, NULL);
+      int res = ::WSASendTo(m_iSocket, (LPWSABUF)vec, 2, &size, 0, addr, addrsize, NULL, NULL);
       res = (0 == res) ? size : -1;
    #endif
 
-   // convert back into local host order
-   //for (int k = 0; k < 4; ++ k)
-   //   packet.m_nHeader[k] = ntohl(packet.m_nHeader[k]);
-   p = packet.m_nHeader;
-   for (int k = 0; k < 4; ++ k)
-   {
-      *p = ntohl(*p);
-       ++ p;
-   }
-
-   if (packet.getFlag())
-   {
-      for (int l = 0, n = packet.getLength() / 4; l < n; ++ l)
-         *((uint32_t *)packet.m_pcData + l) = ntohl(*((uint32_t *)packet.m_pcData + l));
-   }
+   delete [] ctrl;
 
    return res;
 }
 
 int CChannel::recvfrom(sockaddr* addr, CPacket& packet) const
 {
+   packet.m_PacketVector[0].iov_len = CPacket::m_iPktHdrSize;
+
    #ifndef WIN32
       msghdr mh;   
       mh.msg_name = addr;
@@ -312,7 +738,7 @@ int CChannel::recvfrom(sockaddr* addr, CPacket& packet) const
       res = (0 == res) ? size : -1;
    #endif
 
-   if (res <= 0)
+   if (res < CHeaderFormat<HDR_CLASSIC>::m_iSize)
    {
       packet.setLength(-1);
       return -1;
@@ -320,21 +746,448 @@ int CChannel::recvfrom(sockaddr* addr, CPacket& packet) const
 
    packet.setLength(res - CPacket::m_iPktHdrSize);
 
-   // convert back into local host order
-   //for (int i = 0; i < 4; ++ i)
-   //   packet.m_nHeader[i] = ntohl(packet.m_nHeader[i]);
-   uint32_t* p = packet.m_nHeader;
-   for (int i = 0; i < 4; ++ i)
-   {
-      *p = ntohl(*p);
-      ++ p;
-   }
-
-   if (packet.getFlag())
-   {
-      for (int j = 0, n = packet.getLength() / 4; j < n; ++ j)
-         *((uint32_t *)packet.m_pcData + j) = ntohl(*((uint32_t *)packet.m_pcData + j));
-   }
+   toHostOrder(packet);
 
    return packet.getLength();
 }
+
+int CChannel::sendto(sockaddr* const* addr, CPacket* const* packet, int num)
+{
+   if (num > m_iMaxBatchSize)
+      num = m_iMaxBatchSize;
+
+   #ifdef LINUX
+      mmsghdr mh[m_iMaxBatchSize];
+      iovec iov[m_iMaxBatchSize * 2];
+      uint32_t header[m_iMaxBatchSize][CHeaderFormat<HDR_LAYERED>::m_iSize / 4];
+
+      // the staging area grows to the control information of the batch; the sending worker mostly sends data, which needs none
+      int words = 0;
+      for (int i = 0; i < num; ++ i)
+      {
+         if (packet[i]->getFlag())
+            words += (packet[i]->getLength() + 3) / 4;
+      }
+      if (words > m_iCtrlStageSize)
+      {
+         delete [] m_piCtrlStage;
+         m_piCtrlStage = new uint32_t[words];
+         m_iCtrlStageSize = words;
+      }
+      uint32_t* ctrl = m_piCtrlStage;
+      char cmsg[m_iMaxBatchSize][CMSG_SPACE(sizeof(uint16_t))];
+      int segs[m_iMaxBatchSize];
+
+      int sent = 0;
+      while (sent < num)
+      {
+         int msgs = 0;
+         int ctrlpos = 0;
+         for (int i = sent; i < num; )
+         {
+            // with GSO the kernel cuts a run into datagrams of the size of its first packet; only the last one may be shorter
+            int size = packet[i]->getHeaderSize() + packet[i]->getLength();
+            int n = 1;
+            while (m_bGSO && (i + n < num) && (addr[i + n] == addr[i]) &&
+                   (packet[i + n - 1]->getHeaderSize() + packet[i + n - 1]->getLength() == size) &&
+                   (packet[i + n]->getHeaderSize() + packet[i + n]->getLength() <= size))
+               ++ n;
+
+            for (int k = i; k < i + n; ++ k)
+            {
+               toNetworkOrder(*packet[k], header[k], ctrl + ctrlpos, iov + k * 2);
+               if (packet[k]->getFlag())
+                  ctrlpos += (packet[k]->getLength() + 3) / 4;
+            }
+
+            mh[msgs].msg_hdr.msg_name = addr[i];
+            mh[msgs].msg_hdr.msg_namelen = m_iSockAddrSize;
+            mh[msgs].msg_hdr.msg_iov = iov + i * 2;
+            mh[msgs].msg_hdr.msg_iovlen = n * 2;
+            mh[msgs].msg_hdr.msg_control = NULL;
+            mh[msgs].msg_hdr.msg_controllen = 0;
+            mh[msgs].msg_hdr.msg_flags = 0;
+            mh[msgs].msg_len = 0;
+
+            if (n > 1)
+            {
+               mh[msgs].msg_hdr.msg_control = cmsg[msgs];
+               mh[msgs].msg_hdr.msg_controllen = sizeof(cmsg[msgs]);
+               cmsghdr* cm = CMSG_FIRSTHDR(&mh[msgs].msg_hdr);
+               cm->cmsg_level = IPPROTO_UDP;
+               cm->cmsg_type = UDP_SEGMENT;
+               cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+               *(uint16_t*)CMSG_DATA(cm) = size;
+            }
+
+            segs[msgs ++] = n;
+            i += n;
+         }
+
+         // a partial batch is resumed; on error the rest is dropped, as a lost UDP packet would be
+         int done = 0;
+         while (done < msgs)
+         {
+            int res = sendBatch(mh + done, msgs - done);
+            if (res <= 0)
+               break;
+
+            for (int k = done; k < done + res; ++ k)
+               sent += segs[k];
+            done += res;
+         }
+
+         if (done < msgs)
+         {
+            // the device cannot segment: fall back for good and stage the rest again without GSO
+            if (!m_bGSO || (EIO != errno))
+               break;
+            m_bGSO = false;
+         }
+      }
+
+      return sent;
+   #else
+      int sent = 0;
+      for (int i = 0; i < num; ++ i)
+      {
+         if (sendto(addr[i], *packet[i]) >= 0)
+            ++ sent;
+      }
+
+      return sent;
+   #endif
+}
+
+int CChannel::recvfrom(sockaddr* const* addr, CPacket* const* packet, int num)
+{
+   if (num > m_iMaxBatchSize)
+      num = m_iMaxBatchSize;
+
+   #ifdef LINUX
+      if (m_bGRO)
+         return recvCoalesced(addr, packet, num);
+
+      mmsghdr mh[m_iMaxBatchSize];
+      for (int i = 0; i < num; ++ i)
+      {
+         packet[i]->m_PacketVector[0].iov_len = CPacket::m_iPktHdrSize;
+         mh[i].msg_hdr.msg_name = addr[i];
+         mh[i].msg_hdr.msg_namelen = m_iSockAddrSize;
+         mh[i].msg_hdr.msg_iov = packet[i]->m_PacketVector;
+         mh[i].msg_hdr.msg_iovlen = 2;
+         mh[i].msg_hdr.msg_control = NULL;
+         mh[i].msg_hdr.msg_controllen = 0;
+         mh[i].msg_hdr.msg_flags = 0;
+         mh[i].msg_len = 0;
+      }
+
+      #ifdef UNIX
+         fd_set set;
+         timeval tv;
+         FD_ZERO(&set);
+         FD_SET(m_iSocket, &set);
+         tv.tv_sec = 0;
+         tv.tv_usec = 10000;
+         ::select(m_iSocket+1, &set, NULL, &set, &tv);
+      #endif
+
+      // block (up to the socket time-out) for the first packet only
+      int res = ::recvmmsg(m_iSocket, mh, num, MSG_WAITFORONE, NULL);
+      if (res <= 0)
+         return 0;
+
+      for (int i = 0; i < res; ++ i)
+      {
+         if (mh[i].msg_len < (unsigned int)CHeaderFormat<HDR_CLASSIC>::m_iSize)
+         {
+            packet[i]->setLength(-1);
+            continue;
+         }
+
+         packet[i]->setLength(mh[i].msg_len - CPacket::m_iPktHdrSize);
+         toHostOrder(*packet[i]);
+      }
+
+      return res;
+   #else
+      // without recvmmsg one packet is read per call, so that the time-out is not paid more than once
+      if (num <= 0)
+         return 0;
+
+      recvfrom(addr[0], *packet[0]);
+      return (packet[0]->getLength() < 0) ? 0 : 1;
+   #endif
+}
+
+int CChannel::recvCoalesced(sockaddr* const* addr, CPacket* const* packet, int num)
+{
+   #ifdef LINUX
+      if (m_iGROPos >= m_iGROSize)
+      {
+         iovec iov;
+         iov.iov_base = m_pcGROBuffer;
+         iov.iov_len = 65536;
+         char ctrl[CMSG_SPACE(sizeof(int))];
+
+         msghdr mh;
+         mh.msg_name = m_pGROAddr;
+         mh.msg_namelen = m_iSockAddrSize;
+         mh.msg_iov = &iov;
+         mh.msg_iovlen = 1;
+         mh.msg_control = ctrl;
+         mh.msg_controllen = sizeof(ctrl);
+         mh.msg_flags = 0;
+
+         #ifdef UNIX
+            fd_set set;
+            timeval tv;
+            FD_ZERO(&set);
+            FD_SET(m_iSocket, &set);
+            tv.tv_sec = 0;
+            tv.tv_usec = 10000;
+            ::select(m_iSocket+1, &set, NULL, &set, &tv);
+         #endif
+
+         int res = ::recvmsg(m_iSocket, &mh, 0);
+         if (res <= 0)
+            return 0;
+
+         // without the control message the datagram has not been coalesced
+         m_iGROSize = res;
+         m_iGROSegSize = res;
+         m_iGROPos = 0;
+         for (cmsghdr* cm = CMSG_FIRSTHDR(&mh); NULL != cm; cm = CMSG_NXTHDR(&mh, cm))
+         {
+            if ((IPPROTO_UDP == cm->cmsg_level) && (UDP_GRO == cm->cmsg_type))
+               m_iGROSegSize = *(int*)CMSG_DATA(cm);
+         }
+      }
+
+      int count = 0;
+      while ((count < num) && (m_iGROPos < m_iGROSize))
+      {
+         int size = m_iGROSize - m_iGROPos;
+         if (size > m_iGROSegSize)
+            size = m_iGROSegSize;
+
+         CPacket* p = packet[count];
+         memcpy(addr[count], m_pGROAddr, m_iSockAddrSize);
+
+         if ((size < CHeaderFormat<HDR_CLASSIC>::m_iSize) || (size - CPacket::m_iPktHdrSize > p->getLength()))
+            p->setLength(-1);
+         else
+         {
+            // as if the packet had been received on its own
+            p->m_PacketVector[0].iov_len = CPacket::m_iPktHdrSize;
+            memcpy(p->m_nHeader, m_pcGROBuffer + m_iGROPos, CPacket::m_iPktHdrSize);
+            memcpy(p->m_pcData, m_pcGROBuffer + m_iGROPos + CPacket::m_iPktHdrSize, size - CPacket::m_iPktHdrSize);
+            p->setLength(size - CPacket::m_iPktHdrSize);
+            toHostOrder(*p);
+         }
+
+         m_iGROPos += size;
+         ++ count;
+      }
+
+      return count;
+   #else
+      return 0;
+   #endif
+}
+
+#ifdef LINUX
+int CChannel::sendBatch(mmsghdr* mh, int num)
+{
+   #ifdef HAVE_URING
+      if (NULL != m_pSndRing)
+      {
+         // linked, so that the messages go out in order and those after a failed one are cancelled, as with sendmmsg
+         io_uring_sqe* last = NULL;
+         int queued = 0;
+         for (; queued < num; ++ queued)
+         {
+            io_uring_sqe* sqe = m_pSndRing->getSQE();
+            if (NULL == sqe)
+               break;
+
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->fd = m_iSocket;
+            sqe->addr = (uint64_t)(uintptr_t)&mh[queued].msg_hdr;
+            sqe->len = 1;
+            sqe->flags = IOSQE_IO_LINK;
+            sqe->user_data = queued;
+            last = sqe;
+         }
+
+         if (NULL != last)
+         {
+            last->flags = 0;
+
+            // the messages, headers and control information live on the caller's stack: wait until all are done
+            m_pSndRing->enter(queued, -1);
+
+            int sent = queued;
+            int err = 0;
+            for (int done = 0; done < queued; )
+            {
+               io_uring_cqe* cqe = m_pSndRing->peek();
+               if (NULL == cqe)
+               {
+                  m_pSndRing->enter(queued - done, -1);
+                  continue;
+               }
+
+               if ((cqe->res < 0) && ((int)cqe->user_data < sent))
+               {
+                  sent = cqe->user_data;
+                  err = -cqe->res;
+               }
+
+               m_pSndRing->seen();
+               ++ done;
+            }
+
+            if (0 == sent)
+            {
+               errno = err;
+               return -1;
+            }
+
+            return sent;
+         }
+      }
+   #endif
+
+   return ::sendmmsg(m_iSocket, mh, num, 0);
+}
+#endif
+
+bool CChannel::postRecv(CPacket* packet, void* context)
+{
+   #ifdef HAVE_URING
+      if ((NULL == m_pRcvRing) || (m_iPosted >= m_iMaxPosted))
+         return false;
+
+      int i = 0;
+      while (m_pRecvSlot[i].m_bPosted)
+         ++ i;
+
+      io_uring_sqe* sqe = m_pRcvRing->getSQE();
+      if (NULL == sqe)
+         return false;
+
+      CRecvSlot& slot = m_pRecvSlot[i];
+      slot.m_Msg.msg_name = &slot.m_Addr;
+      slot.m_Msg.msg_namelen = m_iSockAddrSize;
+      packet->m_PacketVector[0].iov_len = CPacket::m_iPktHdrSize;
+      slot.m_Msg.msg_iov = packet->m_PacketVector;
+      slot.m_Msg.msg_iovlen = 2;
+      slot.m_Msg.msg_control = NULL;
+      slot.m_Msg.msg_controllen = 0;
+      slot.m_Msg.msg_flags = 0;
+      slot.m_pPacket = packet;
+      slot.m_pContext = context;
+      slot.m_bPosted = true;
+      ++ m_iPosted;
+
+      // the kernel scatters the packet straight into the header and the payload buffer of the packet
+      sqe->opcode = IORING_OP_RECVMSG;
+      sqe->fd = m_iSocket;
+      sqe->addr = (uint64_t)(uintptr_t)&slot.m_Msg;
+      sqe->len = 1;
+      sqe->user_data = i;
+
+      return true;
+   #else
+      return false;
+   #endif
+}
+
+int CChannel::waitRecv(void** context, sockaddr* const* addr, int num, int timeout)
+{
+   #ifdef HAVE_URING
+      if (num > m_iMaxBatchSize)
+         num = m_iMaxBatchSize;
+
+      // one system call submits the new receives and waits, unless packets are there already
+      m_pRcvRing->enter((NULL == m_pRcvRing->peek()) ? 1 : 0, timeout);
+
+      int count = 0;
+      io_uring_cqe* cqe;
+      while ((count < num) && (NULL != (cqe = m_pRcvRing->peek())))
+      {
+         CRecvSlot& slot = m_pRecvSlot[cqe->user_data];
+         int res = cqe->res;
+         m_pRcvRing->seen();
+
+         slot.m_bPosted = false;
+         -- m_iPosted;
+
+         CPacket* p = slot.m_pPacket;
+         if (res < CHeaderFormat<HDR_CLASSIC>::m_iSize)
+            p->setLength(-1);
+         else
+         {
+            p->setLength(res - CPacket::m_iPktHdrSize);
+            toHostOrder(*p);
+         }
+
+         memcpy(addr[count], &slot.m_Addr, m_iSockAddrSize);
+         context[count ++] = slot.m_pContext;
+      }
+
+      return count;
+   #else
+      return 0;
+   #endif
+}
+
+bool CChannel::cancelRecv()
+{
+   #ifdef HAVE_URING
+      if (NULL == m_pRcvRing)
+         return true;
+
+      // every receive completes, cancelled or not; a cancel that finds its receive in flight is sent again later
+      for (int i = 0; (m_iPosted > 0) && (i < 1000); ++ i)
+      {
+         // cancel requests complete with user data m_iMaxPosted, which no receive has
+         for (int j = 0; (0 == i % 10) && (j < m_iMaxPosted); ++ j)
+         {
+            io_uring_sqe* sqe;
+            if (!m_pRecvSlot[j].m_bPosted || (NULL == (sqe = m_pRcvRing->getSQE())))
+               continue;
+
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = j;
+            sqe->user_data = m_iMaxPosted;
+         }
+
+         m_pRcvRing->enter(1, 10000);
+
+         io_uring_cqe* cqe;
+         while (NULL != (cqe = m_pRcvRing->peek()))
+         {
+            if ((cqe->user_data < (uint64_t)m_iMaxPosted) && m_pRecvSlot[cqe->user_data].m_bPosted)
+            {
+               m_pRecvSlot[cqe->user_data].m_bPosted = false;
+               -- m_iPosted;
+            }
+            m_pRcvRing->seen();
+         }
+      }
+
+      if (m_iPosted > 0)
+      {
+         // rather than hang a closing socket, the ring and the messages are left to the kernel that may still fill them
+         m_pRcvRing = NULL;
+         m_pRecvSlot = NULL;
+         m_iPosted = 0;
+         return false;
+      }
+   #endif
+
+   return true;
+}
@@ -46,6 +46,9 @@ written by
 #include "packet.h"
 
 
+class CURing;
+struct CRecvSlot;
+
 class CChannel
 {
 public:
@@ -116,6 +119,65 @@ public:
 
    void setRcvBufSize(int size);
 
+      // Functionality:
+      //    Request UDP segmentation offload (GSO for sending, GRO for receiving), before the channel is opened.
+      //    Each is used only if the kernel supports it.
+      // Parameters:
+      //    0) [in] offload: if offload is wanted.
+      // Returned value:
+      //    None.
+
+   void setOffload(bool offload);
+
+      // Functionality:
+      //    Let the channel share its port with other channels (SO_REUSEPORT), before it is opened.
+      // Parameters:
+      //    0) [in] reuse: if the port is shared.
+      // Returned value:
+      //    None.
+
+   void setReusePort(bool reuse);
+
+      // Functionality:
+      //    Request an io_uring backend, before the channel is opened: the batched calls then submit their packets to the
+      //    kernel through a ring, and receives are posted in advance into the packets that are to be filled.
+      //    It is used only if the kernel supports it.
+      // Parameters:
+      //    0) [in] uring: if io_uring is wanted.
+      // Returned value:
+      //    None.
+
+   void setURing(bool uring);
+
+      // Functionality:
+      //    Check if receives are posted in advance (postRecv/waitRecv), rather than read by recvfrom.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    true if receives are to be posted.
+
+   bool isRecvPosted() const;
+
+      // Functionality:
+      //    Steer each incoming packet to the channel, among those sharing the port, given by getSteering for its destination
+      //    socket ID, in the order the channels were opened. GRO is turned off, as it would merge packets of different sockets.
+      // Parameters:
+      //    0) [in] num: number of channels sharing the port.
+      // Returned value:
+      //    true if the kernel steers packets, false if it cannot (the packets are then spread by address).
+
+   bool setSteering(int num);
+
+      // Functionality:
+      //    Find the channel that packets to a socket are steered to.
+      // Parameters:
+      //    0) [in] id: socket ID.
+      //    1) [in] num: number of channels sharing the port.
+      // Returned value:
+      //    Index of the channel; 0 for socket ID 0 (connection requests).
+
+   static int getSteering(int32_t id, int num);
+
       // Functionality:
       //    Query the socket address that the channel is using.
       // Parameters:
@@ -154,9 +216,120 @@ public:
 
    int recvfrom(sockaddr* addr, CPacket& packet) const;
 
+      // Functionality:
+      //    Send a batch of packets, with one system call where sendmmsg is available.
+      //    With GSO, a run of equal size packets to the same destination goes to the kernel as one buffer.
+      // Parameters:
+      //    0) [in] addr: destination address of each packet.
+      //    1) [in] packet: the packets to be sent.
+      //    2) [in] num: number of packets, at most m_iMaxBatchSize.
+      // Returned value:
+      //    Number of packets sent.
+
+   int sendto(sockaddr* const* addr, CPacket* const* packet, int num);
+
+      // Functionality:
+      //    Receive a batch of packets, with one system call where recvmmsg is available.
+      //    The call waits for the first packet only, then takes what has already arrived.
+      //    With GRO, a coalesced datagram is split into the packets; what does not fit is kept for the next call.
+      // Parameters:
+      //    0) [in] addr: buffers for the source address of each packet.
+      //    1) [in] packet: the packets to be filled.
+      //    2) [in] num: number of packets, at most m_iMaxBatchSize.
+      // Returned value:
+      //    Number of packets received; a packet whose length is negative is invalid.
+
+   int recvfrom(sockaddr* const* addr, CPacket* const* packet, int num);
+
+      // Functionality:
+      //    Post a receive into a packet, for the kernel to fill as soon as a packet arrives, without a copy.
+      //    It is handed to the kernel by the next waitRecv.
+      // Parameters:
+      //    0) [in] packet: the packet to be filled; it must stay valid until it is returned by waitRecv, or cancelRecv.
+      //    1) [in] context: value returned by waitRecv with the packet.
+      // Returned value:
+      //    true if posted, false if m_iMaxPosted receives are posted already.
+
+   bool postRecv(CPacket* packet, void* context);
+
+      // Functionality:
+      //    Submit what has been posted, wait for the first receive to complete, then take those that have completed.
+      // Parameters:
+      //    0) [out] context: context of each packet received.
+      //    1) [in] addr: buffers for the source address of each packet.
+      //    2) [in] num: number of packets, at most m_iMaxBatchSize.
+      //    3) [in] timeout: how long to wait for the first packet, in microseconds.
+      // Returned value:
+      //    Number of packets received; a packet whose length is negative is invalid.
+
+   int waitRecv(void** context, sockaddr* const* addr, int num, int timeout);
+
+      // Functionality:
+      //    Cancel the posted receives and wait until the kernel no longer uses their packets.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    true if no packet is used any more, false if the wait has timed out: the packets must not be freed then.
+
+   bool cancelRecv();
+
+public:
+   static const int m_iMaxBatchSize = 16;       // maximum number of packets per batched system call
+   static const int m_iMaxPosted = 32;          // maximum number of receives posted to io_uring at a time
+   static const uint32_t m_iSteeringHash = 2654435761U;  // multiplier of the socket ID hash used to steer packets
+
 private:
    void setUDPSockOpt();
 
+      // Functionality:
+      //    Serialize a packet into network order, leaving the packet itself untouched.
+      //    The header goes into "header" and control information into "ctrl"; data is sent in place.
+      // Parameters:
+      //    0) [in] packet: the packet to be sent.
+      //    1) [out] header: staging area for the header, CPacket::m_iPktHdrSize bytes.
+      //    2) [out] ctrl: staging area for control information, at least the packet length rounded up to whole words.
+      //    3) [out] vec: the two buffers [header, data] that form the packet on the wire.
+      // Returned value:
+      //    None.
+
+   static void toNetworkOrder(const CPacket& packet, uint32_t* header, uint32_t* ctrl, iovec* vec);
+
+      // Functionality:
+      //    Convert a received packet, header and control information, into host order in place.
+      // Parameters:
+      //    0) [in, out] packet: the packet received.
+      // Returned value:
+      //    None.
+
+   static void toHostOrder(CPacket& packet);
+
+      // Functionality:
+      //    Byte swap 32-bit words between network and host order, with SIMD where available.
+      // Parameters:
+      //    0) [out] dst: converted words, may be the same as src.
+      //    1) [in] src: words to be converted, need not be aligned.
+      //    2) [in] num: number of words.
+      // Returned value:
+      //    None.
+
+   static void swapWords(uint32_t* dst, const uint32_t* src, int num);
+
+   int recvCoalesced(sockaddr* const* addr, CPacket* const* packet, int num);
+
+      // Functionality:
+      //    Send a batch of prepared messages, in order, through the send ring if there is one, else with sendmmsg.
+      // Parameters:
+      //    0) [in] mh: the messages.
+      //    1) [in] num: number of messages.
+      // Returned value:
+      //    Number of messages sent before the first one that failed, -1 (with errno set) if that is the first.
+
+#ifdef LINUX
+   int sendBatch(mmsghdr* mh, int num);
+#endif
+
+   void openURing();
+
 private:
    int m_iIPversion;                    // IP version
    int m_iSockAddrSize;                 // socket address structure size (pre-defined to avoid run-time test)
@@ -165,6 +338,26 @@ private:
 
    int m_iSndBufSize;                   // UDP sending buffer size
    int m_iRcvBufSize;                   // UDP receiving buffer size
+
+   bool m_bReusePort;                   // if the port is shared with other channels
+   bool m_bOffload;                     // if UDP segmentation offload is requested
+   bool m_bGSO;                         // if UDP_SEGMENT is used for sending
+   bool m_bGRO;                         // if UDP_GRO is used for receiving
+
+   char* m_pcGROBuffer;                 // last coalesced datagram received
+   sockaddr* m_pGROAddr;                // its source address
+   int m_iGROSize;                      // its size, in bytes
+   int m_iGROSegSize;                   // size of each packet in it
+   int m_iGROPos;                       // offset of the first packet not yet returned
+
+   uint32_t* m_piCtrlStage;             // control information of a batch in network order, used by the sending worker only
+   int m_iCtrlStageSize;                // its size, in words: as much as the largest batch has needed so far
+
+   bool m_bURing;                       // if io_uring is requested
+   CURing* m_pSndRing;                  // ring of the batched sends, used by the sending worker only
+   CURing* m_pRcvRing;                  // ring of the posted receives, used by the receiving worker only
+   CRecvSlot* m_pRecvSlot;              // the posted receives, m_iMaxPosted of them
+   int m_iPosted;                       // number of receives posted
 };
 
 
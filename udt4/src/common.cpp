@@ -55,6 +55,7 @@ written by
 #endif
 
 #include <cmath>
+#include <cstdio>
 #include "md5.h"
 #include "common.h"
 
@@ -70,12 +71,22 @@ uint64_t CTimer::s_ullCPUFrequency = CTimer::readCPUFrequency();
 
 CTimer::CTimer():
 m_ullSchedTime(),
+m_ullWakeLatency(0),
 m_TickCond(),
 m_TickLock()
 {
    #ifndef WIN32
       pthread_mutex_init(&m_TickLock, NULL);
-      pthread_cond_init(&m_TickCond, NULL);
+      #ifdef LINUX
+         // timed waits are measured against the monotonic clock, so that they are immune to clock adjustments
+         pthread_condattr_t attr;
+         pthread_condattr_init(&attr);
+         pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+         pthread_cond_init(&m_TickCond, &attr);
+         pthread_condattr_destroy(&attr);
+      #else
+         pthread_cond_init(&m_TickCond, NULL);
+      #endif
    #else
       m_TickLock = CreateMutex(NULL, false, NULL);
       m_TickCond = CreateEvent(NULL, false, false, NULL);
@@ -194,41 +205,70 @@ void CTimer::sleepto(uint64_t nexttime)
 
    while (t < m_ullSchedTime)
    {
-      #ifndef NO_BUSY_WAITING
-         #ifdef IA32
-            __asm__ volatile ("pause; rep; nop; nop; nop; nop; nop;");
-         #elif X86_64
-            __asm__ volatile ("nop 0; nop 0; nop 0; nop 0; nop 0;");
-         #elif AMD64
-            __asm__ volatile ("nop; nop; nop; nop; nop;");
-         #endif
-      #else
-         #ifndef WIN32
-            timeval now;
-            timespec timeout;
-            gettimeofday(&now, 0);
-            if (now.tv_usec < 990000)
-            {
-               timeout.tv_sec = now.tv_sec;
-               timeout.tv_nsec = (now.tv_usec + 10000) * 1000;
-            }
-            else
-            {
-               timeout.tv_sec = now.tv_sec + 1;
-               timeout.tv_nsec = (now.tv_usec + 10000 - 1000000) * 1000;
-            }
-            pthread_mutex_lock(&m_TickLock);
-            pthread_cond_timedwait(&m_TickCond, &m_TickLock, &timeout);
-            pthread_mutex_unlock(&m_TickLock);
-         #else
-            WaitForSingleObject(m_TickCond, 1);
-         #endif
+      // block as long as the scheduled time is further away than a wake-up would overshoot,
+      // so that only the final microseconds are spent spinning
+      if (m_ullSchedTime > t + m_ullWakeLatency + s_ullCPUFrequency)
+      {
+         uint64_t target = m_ullSchedTime - m_ullWakeLatency;
+         bool timeout = wait(t, (target - t) / s_ullCPUFrequency);
+
+         rdtsc(t);
+
+         // learn the wake-up latency from the waits that were not cut short, a preemption is not counted in full
+         if (timeout && (t >= target))
+         {
+            uint64_t late = t - target;
+            if (late > 100 * s_ullCPUFrequency)
+               late = 100 * s_ullCPUFrequency;
+            m_ullWakeLatency = (m_ullWakeLatency * 7 + late) >> 3;
+         }
+
+         continue;
+      }
+
+      #ifdef IA32
+         __asm__ volatile ("pause; rep; nop; nop; nop; nop; nop;");
+      #elif X86_64
+         __asm__ volatile ("nop 0; nop 0; nop 0; nop 0; nop 0;");
+      #elif AMD64
+         __asm__ volatile ("nop; nop; nop; nop; nop;");
       #endif
 
       rdtsc(t);
    }
 }
 
+bool CTimer::wait(uint64_t now, uint64_t interval)
+{
+   #ifndef WIN32
+      timespec timeout;
+      #ifdef LINUX
+         clock_gettime(CLOCK_MONOTONIC, &timeout);
+      #else
+         timeval tv;
+         gettimeofday(&tv, 0);
+         timeout.tv_sec = tv.tv_sec;
+         timeout.tv_nsec = tv.tv_usec * 1000;
+      #endif
+      uint64_t nsec = timeout.tv_nsec + interval * 1000;
+      timeout.tv_sec += nsec / 1000000000;
+      timeout.tv_nsec = nsec % 1000000000;
+
+      // an interrupt() that moved the scheduled time before the lock is taken must not be missed
+      int res = 0;
+      pthread_mutex_lock(&m_TickLock);
+      if (now < m_ullSchedTime)
+         res = pthread_cond_timedwait(&m_TickCond, &m_TickLock, &timeout);
+      pthread_mutex_unlock(&m_TickLock);
+
+      return ETIMEDOUT == res;
+   #else
+      if (now >= m_ullSchedTime)
+         return false;
+      return WAIT_TIMEOUT == WaitForSingleObject(m_TickCond, DWORD(interval / 1000));
+   #endif
+}
+
 void CTimer::interrupt()
 {
    // schedule the sleepto time to the current CCs, so that it will stop
@@ -239,7 +279,9 @@ void CTimer::interrupt()
 void CTimer::tick()
 {
    #ifndef WIN32
+      pthread_mutex_lock(&m_TickLock);
       pthread_cond_signal(&m_TickCond);
+      pthread_mutex_unlock(&m_TickLock);
    #else
       SetEvent(m_TickCond);
    #endif
@@ -399,6 +441,24 @@ void CGuard::releaseCond(pthread_cond_t& cond)
 
 }
 
+void CGuard::memoryBarrier()
+{
+   #ifndef WIN32
+      __sync_synchronize();
+   #else
+      MemoryBarrier();
+   #endif
+}
+
+int CGuard::atomicAdd(volatile int& value, int delta)
+{
+   #ifndef WIN32
+      return __sync_add_and_fetch(&value, delta);
+   #else
+      return InterlockedExchangeAdd((volatile LONG*)&value, delta) + delta;
+   #endif
+}
+
 //
 CUDTException::CUDTException(int major, int minor, int err):
 m_iMajor(major),
@@ -583,6 +643,22 @@ const char* CUDTException::getErrorMessage()
            m_strMsg += ": Invalid epoll ID";
            break;
 
+        case 14:
+           m_strMsg += ": Rendezvous connection setup is not supported on a port served by several workers";
+           break;
+
+        case 15:
+           m_strMsg += ": This operation is not supported over a shared memory link";
+           break;
+
+        case 16:
+           m_strMsg += ": Invalid fan-out group ID";
+           break;
+
+        case 17:
+           m_strMsg += ": Invalid multipath session ID";
+           break;
+
         default:
            break;
         }
@@ -684,6 +760,10 @@ const int CUDTException::EDGRAMILL = 5010;
 const int CUDTException::EDUPLISTEN = 5011;
 const int CUDTException::ELARGEMSG = 5012;
 const int CUDTException::EINVPOLLID = 5013;
+const int CUDTException::ERDVWORKERS = 5014;
+const int CUDTException::ESHMEMILL = 5015;
+const int CUDTException::EINVFANOUT = 5016;
+const int CUDTException::EINVMPATH = 5017;
 const int CUDTException::EASYNCFAIL = 6000;
 const int CUDTException::EASYNCSND = 6001;
 const int CUDTException::EASYNCRCV = 6002;
@@ -692,6 +772,183 @@ const int CUDTException::EPEERERR = 7000;
 const int CUDTException::EUNKNOWN = -1;
 
 
+CFrameTrace::CFrameTrace(int size):
+m_pEvent(NULL),
+m_iSize(size + 1),
+m_iHead(0),
+m_iTail(0),
+m_iOverflow(0),
+m_iLastOverflow(0)
+{
+   m_pEvent = new CFrameEvent[m_iSize];
+   CGuard::createMutex(m_DrainLock);
+}
+
+CFrameTrace::~CFrameTrace()
+{
+   delete [] m_pEvent;
+   CGuard::releaseMutex(m_DrainLock);
+}
+
+void CFrameTrace::record(const CFrameEvent& ev)
+{
+   int tail = m_iTail;
+   int next = (tail + 1) % m_iSize;
+
+   if (next == m_iHead)
+   {
+      ++ m_iOverflow;
+      return;
+   }
+
+   // VR Frame Awareness: the slot must be written before the index that publishes it, and read before the index that frees it
+   m_pEvent[tail] = ev;
+   CGuard::memoryBarrier();
+   m_iTail = next;
+}
+
+int CFrameTrace::drain(CFrameEvent* events, int num, int& overflow)
+{
+   CGuard drainguard(m_DrainLock);
+
+   int head = m_iHead;
+   int tail = m_iTail;
+   CGuard::memoryBarrier();
+
+   int count = 0;
+   while ((head != tail) && (count < num))
+   {
+      events[count ++] = m_pEvent[head];
+      head = (head + 1) % m_iSize;
+   }
+
+   CGuard::memoryBarrier();
+   m_iHead = head;
+
+   int total = m_iOverflow;
+   overflow = total - m_iLastOverflow;
+   m_iLastOverflow = total;
+
+   return count;
+}
+
+
+//
+CHistogram::CHistogram()
+{
+   clear();
+}
+
+void CHistogram::record(int64_t value)
+{
+   if (value < 0)
+      value = 0;
+
+   ++ m_piCount[getBucket(value)];
+   ++ m_llCount;
+   m_llSum += value;
+   if (value > m_llMax)
+      m_llMax = value;
+}
+
+int64_t CHistogram::getPercentile(double fraction) const
+{
+   if (0 == m_llCount)
+      return 0;
+
+   // the rank of the percentile, counting from 1
+   int64_t rank = int64_t(fraction * m_llCount + 0.5);
+   if (rank < 1)
+      rank = 1;
+
+   int64_t count = 0;
+   for (int i = 0; i < m_iBuckets; ++ i)
+   {
+      count += m_piCount[i];
+      if (count >= rank)
+      {
+         int64_t value = getBucketMax(i);
+         return (value < m_llMax) ? value : m_llMax;
+      }
+   }
+
+   return m_llMax;
+}
+
+double CHistogram::getMean() const
+{
+   return (m_llCount > 0) ? double(m_llSum) / m_llCount : 0;
+}
+
+void CHistogram::clear()
+{
+   memset(m_piCount, 0, sizeof(m_piCount));
+   m_llCount = m_llSum = m_llMax = 0;
+}
+
+int CHistogram::getBucket(int64_t value)
+{
+   if (value < (1 << m_iSubBits))
+      return int(value);
+
+   // position of the highest bit, at least m_iSubBits here
+   int top = 0;
+   for (int shift = 32; shift > 0; shift >>= 1)
+   {
+      if (value >> (top + shift))
+         top += shift;
+   }
+   if (top >= m_iMaxBits)
+      return m_iBuckets - 1;
+
+   // the highest bit selects the power of two, the next m_iSubBits bits the bucket within it
+   int shift = top - m_iSubBits;
+   return ((shift + 1) << m_iSubBits) + int((value >> shift) & ((1 << m_iSubBits) - 1));
+}
+
+int64_t CHistogram::getBucketMax(int bucket)
+{
+   if (bucket < (1 << m_iSubBits))
+      return bucket;
+
+   int shift = (bucket >> m_iSubBits) - 1;
+   int64_t base = int64_t((1 << m_iSubBits) + (bucket & ((1 << m_iSubBits) - 1))) << shift;
+   return base + (int64_t(1) << shift) - 1;
+}
+
+//
+CFrameStats::CFrameStats():
+m_llCompleteTotal(0),
+m_llMissTotal(0),
+m_iComplete(0),
+m_iMiss(0),
+m_Latency(),
+m_Retrans()
+{
+}
+
+void CFrameStats::complete(int64_t latency, int retrans)
+{
+   ++ m_llCompleteTotal;
+   ++ m_iComplete;
+   m_Latency.record(latency);
+   m_Retrans.record(retrans);
+}
+
+void CFrameStats::miss()
+{
+   ++ m_llMissTotal;
+   ++ m_iMiss;
+}
+
+void CFrameStats::clear()
+{
+   m_iComplete = m_iMiss = 0;
+   m_Latency.clear();
+   m_Retrans.clear();
+}
+
+
 //
 bool CIPAddress::ipcmp(const sockaddr* addr1, const sockaddr* addr2, int ver)
 {
@@ -767,3 +1024,81 @@ void CMD5::compute(const char* input, unsigned char result[16])
    md5_append(&state, (const md5_byte_t *)input, strlen(input));
    md5_finish(&state, result);
 }
+
+//
+void CCookie::genKey(uint64_t key[2])
+{
+   #ifndef WIN32
+      FILE* f = fopen("/dev/urandom", "rb");
+      if (NULL != f)
+      {
+         size_t n = fread(key, sizeof(uint64_t), 2, f);
+         fclose(f);
+         if (2 == n)
+            return;
+      }
+   #endif
+
+   // no system source of randomness, make do with the clock and rand()
+   uint64_t t;
+   CTimer::rdtsc(t);
+   key[0] = CTimer::getTime() ^ ((uint64_t)rand() << 32) ^ rand();
+   key[1] = t ^ ((uint64_t)rand() << 40) ^ ((uint64_t)rand() << 20) ^ rand();
+}
+
+#define SIPROUND \
+   do \
+   { \
+      v0 += v1; v1 = (v1 << 13) | (v1 >> 51); v1 ^= v0; v0 = (v0 << 32) | (v0 >> 32); \
+      v2 += v3; v3 = (v3 << 16) | (v3 >> 48); v3 ^= v2; \
+      v0 += v3; v3 = (v3 << 21) | (v3 >> 43); v3 ^= v0; \
+      v2 += v1; v1 = (v1 << 17) | (v1 >> 47); v1 ^= v2; v2 = (v2 << 32) | (v2 >> 32); \
+   } while (0)
+
+int32_t CCookie::compute(const uint64_t key[2], const sockaddr* addr, int ver, int64_t slot)
+{
+   // the message: the address, the port and the slot in three 64-bit words
+   uint64_t m[3];
+   if (AF_INET == ver)
+   {
+      const sockaddr_in* a = (const sockaddr_in*)addr;
+      m[0] = a->sin_addr.s_addr;
+      m[1] = a->sin_port;
+   }
+   else
+   {
+      const sockaddr_in6* a = (const sockaddr_in6*)addr;
+      memcpy(m, &a->sin6_addr, 16);
+      m[1] ^= (uint64_t)a->sin6_port << 48;
+   }
+   m[2] = (uint64_t)slot;
+
+   uint64_t v0 = key[0] ^ 0x736f6d6570736575ULL;
+   uint64_t v1 = key[1] ^ 0x646f72616e646f6dULL;
+   uint64_t v2 = key[0] ^ 0x6c7967656e657261ULL;
+   uint64_t v3 = key[1] ^ 0x7465646279746573ULL;
+
+   for (int i = 0; i < 3; ++ i)
+   {
+      v3 ^= m[i];
+      SIPROUND;
+      SIPROUND;
+      v0 ^= m[i];
+   }
+
+   // the final block holds the message length only
+   uint64_t b = (uint64_t)24 << 56;
+   v3 ^= b;
+   SIPROUND;
+   SIPROUND;
+   v0 ^= b;
+
+   v2 ^= 0xFF;
+   SIPROUND;
+   SIPROUND;
+   SIPROUND;
+   SIPROUND;
+
+   uint64_t h = v0 ^ v1 ^ v2 ^ v3;
+   return (int32_t)(h ^ (h >> 32));
+}
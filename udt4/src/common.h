@@ -82,7 +82,8 @@ public:
    void sleep(uint64_t interval);
 
       // Functionality:
-      //    Seelp until CC "nexttime".
+      //    Seelp until CC "nexttime". The thread blocks while the time is far off and
+      //    spins only for the final stretch that a wake-up from the blocking wait would overshoot.
       // Parameters:
       //    0) [in] nexttime: next time the caller is waken up.
       // Returned value:
@@ -100,7 +101,7 @@ public:
    void interrupt();
 
       // Functionality:
-      //    trigger the clock for a tick, for better granuality in no_busy_waiting timer.
+      //    trigger the clock for a tick, waking up a blocked sleep() or sleepto() to check the time again.
       // Parameters:
       //    None.
       // Returned value:
@@ -167,8 +168,19 @@ public:
 private:
    uint64_t getTimeInMicroSec();
 
+      // Functionality:
+      //    Block for at most "interval" microseconds, or until tick() or interrupt() is called.
+      // Parameters:
+      //    0) [in] now: current CC.
+      //    1) [in] interval: microseconds to block.
+      // Returned value:
+      //    true if the full interval has passed, false if the wait was cut short.
+
+   bool wait(uint64_t now, uint64_t interval);
+
 private:
    uint64_t m_ullSchedTime;             // next schedulled time
+   uint64_t m_ullWakeLatency;           // average delay of a wake-up from a timed wait, in CCs
 
    pthread_cond_t m_TickCond;
    pthread_mutex_t m_TickLock;
@@ -200,6 +212,25 @@ public:
    static void createCond(pthread_cond_t& cond);
    static void releaseCond(pthread_cond_t& cond);
 
+      // Functionality:
+      //    Full memory barrier for the lock-free rings: no load or store crosses it.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    None.
+
+   static void memoryBarrier();
+
+      // Functionality:
+      //    Atomically add to a counter shared by two threads, with a full barrier.
+      // Parameters:
+      //    0) [in/out] value: the counter.
+      //    1) [in] delta: value to be added, may be negative.
+      // Returned value:
+      //    The new value of the counter.
+
+   static int atomicAdd(volatile int& value, int delta);
+
 private:
    pthread_mutex_t& m_Mutex;            // Alias name of the mutex to be protected
    int m_iLocked;                       // Locking status
@@ -219,6 +250,7 @@ private:
 // incseq: increase the seq# by 1
 // decseq: decrease the seq# by 1
 // incseq: increase the seq# by a given offset
+// decseq: decrease the seq# by a given offset
 
 class CSeqNo
 {
@@ -249,6 +281,9 @@ public:
    inline static int32_t incseq(int32_t seq, int32_t inc)
    {return (m_iMaxSeqNo - seq >= inc) ? seq + inc : seq - m_iMaxSeqNo + inc - 1;}
 
+   inline static int32_t decseq(int32_t seq, int32_t dec)
+   {return (seq >= dec) ? seq - dec : seq - dec + m_iMaxSeqNo + 1;}
+
 public:
    static const int32_t m_iSeqNoTH;             // threshold for comparing seq. no.
    static const int32_t m_iMaxSeqNo;            // maximum sequence number used in UDT
@@ -271,6 +306,7 @@ public:
 ////////////////////////////////////////////////////////////////////////////////
 
 // UDT Message Number: 0 - (2^29 - 1)
+// VR Frame Awareness: 0 - (2^17 - 1) with the frame header, whose other 12 bits of the field carry the frame deadline, see CPacket
 
 class CMsgNo
 {
@@ -298,6 +334,177 @@ public:
 public:
    static const int32_t m_iMsgNoTH;             // threshold for comparing msg. no.
    static const int32_t m_iMaxMsgNo;            // maximum message number used in UDT
+   static const int32_t m_iMaxFrameMsgNo;       // maximum message number of a connection with the frame header
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// UDT Packet Timestamp: 0 - (2^32 - 1) microseconds, wraps every 71.6 minutes
+// VR Frame Awareness: frame deadlines and sending times on the sender's time base wrap with it
+
+// tscmp: compare two timestamps, considering the wrapping; they must be less than 2^31 microseconds apart
+
+class CTimeStamp
+{
+public:
+   inline static int32_t tscmp(int64_t ts1, int64_t ts2)
+   {return int32_t(uint32_t(ts1) - uint32_t(ts2));}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// VR Frame Awareness: fixed size ring of frame events with one producer (the thread that
+// processes incoming packets) and any number of consumers. The producer never blocks or
+// takes a lock; events are discarded and counted when the ring is full.
+
+class CFrameTrace
+{
+public:
+   CFrameTrace(int size);
+   ~CFrameTrace();
+
+      // Functionality:
+      //    Append an event to the trace, called by the producer thread only.
+      // Parameters:
+      //    0) [in] ev: the frame event.
+      // Returned value:
+      //    None.
+
+   void record(const CFrameEvent& ev);
+
+      // Functionality:
+      //    Move recorded events out of the trace.
+      // Parameters:
+      //    0) [out] events: buffer for the events.
+      //    1) [in] num: maximum number of events to read.
+      //    2) [out] overflow: number of events discarded since the previous call.
+      // Returned value:
+      //    Number of events read.
+
+   int drain(CFrameEvent* events, int num, int& overflow);
+
+private:
+   CFrameEvent* m_pEvent;               // event ring
+   int m_iSize;                         // number of slots; one slot is always kept free
+
+   volatile int m_iHead;                // first event to be read, written by the consumer only
+   volatile int m_iTail;                // next free slot, written by the producer only
+   volatile int m_iOverflow;            // events discarded so far, written by the producer only
+   int m_iLastOverflow;                 // m_iOverflow seen by the last drain
+
+   pthread_mutex_t m_DrainLock;         // used to serialize consumers
+
+private:
+   CFrameTrace(const CFrameTrace&);
+   CFrameTrace& operator=(const CFrameTrace&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// VR Frame Awareness: HDR-style histogram of non-negative values. Buckets are linear below 16 and
+// 16 per power of two above, so that a value is known within 1/16 of itself; recording is a few
+// shifts and an increment, and only the queries walk the buckets.
+
+class CHistogram
+{
+public:
+   CHistogram();
+
+      // Functionality:
+      //    Count a value, negative values count as 0.
+      // Parameters:
+      //    0) [in] value: the value.
+      // Returned value:
+      //    None.
+
+   void record(int64_t value);
+
+      // Functionality:
+      //    Find the value below which a fraction of the recorded values fall.
+      // Parameters:
+      //    0) [in] fraction: the fraction, e.g., 0.99 for the 99th percentile.
+      // Returned value:
+      //    Highest value of the bucket holding the percentile, 0 if nothing has been recorded.
+
+   int64_t getPercentile(double fraction) const;
+
+      // Functionality:
+      //    Query the average of the recorded values.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    The average, 0 if nothing has been recorded.
+
+   double getMean() const;
+
+   int64_t getCount() const {return m_llCount;}
+
+      // Functionality:
+      //    Forget all recorded values.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    None.
+
+   void clear();
+
+private:
+   static const int m_iSubBits = 4;                             // 2^4 buckets per power of two
+   static const int m_iMaxBits = 40;                            // larger values, 12 days in microseconds, share the last bucket
+   static const int m_iBuckets = (m_iMaxBits - m_iSubBits + 1) << m_iSubBits;
+
+   int m_piCount[m_iBuckets];           // number of values in each bucket
+   int64_t m_llCount;                   // number of values
+   int64_t m_llSum;                     // sum of the values
+   int64_t m_llMax;                     // largest value
+
+private:
+   static int getBucket(int64_t value);
+   static int64_t getBucketMax(int bucket);
+};
+
+// VR Frame Awareness: frame counters of one side of a connection, for UDT::perfmon
+
+class CFrameStats
+{
+public:
+   CFrameStats();
+
+      // Functionality:
+      //    Count a frame that has been delivered completely.
+      // Parameters:
+      //    0) [in] latency: time taken to deliver the frame, in microseconds.
+      //    1) [in] retrans: number of retransmitted packets of the frame.
+      // Returned value:
+      //    None.
+
+   void complete(int64_t latency, int retrans = 0);
+
+      // Functionality:
+      //    Count a frame that has missed its deadline, delivered late or not at all.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    None.
+
+   void miss();
+
+      // Functionality:
+      //    Start a new measurement interval, the totals are kept.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    None.
+
+   void clear();
+
+public:
+   int64_t m_llCompleteTotal;           // frames delivered completely
+   int64_t m_llMissTotal;               // frames that missed their deadlines
+   int m_iComplete;                     // frames delivered completely in this interval
+   int m_iMiss;                         // frames that missed their deadlines in this interval
+   CHistogram m_Latency;                // delivery latency of the complete frames in this interval, in microseconds
+   CHistogram m_Retrans;                // retransmissions per complete frame in this interval
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -316,5 +523,33 @@ struct CMD5
    static void compute(const char* input, unsigned char result[16]);
 };
 
+////////////////////////////////////////////////////////////////////////////////
+
+// SYN cookies of a listening socket: SipHash-2-4 under a secret key, over the binary peer address
+
+struct CCookie
+{
+      // Functionality:
+      //    Generate a random secret key.
+      // Parameters:
+      //    0) [out] key: the 128-bit key.
+      // Returned value:
+      //    None.
+
+   static void genKey(uint64_t key[2]);
+
+      // Functionality:
+      //    Compute the cookie of a peer in a time slot.
+      // Parameters:
+      //    0) [in] key: secret key of the listener.
+      //    1) [in] addr: peer address.
+      //    2) [in] ver: IP version.
+      //    3) [in] slot: time slot, the cookie changes with it.
+      // Returned value:
+      //    The cookie.
+
+   static int32_t compute(const uint64_t key[2], const sockaddr* addr, int ver, int64_t slot);
+};
+
 
 #endif
@@ -40,6 +40,7 @@ written by
 
 #ifndef WIN32
    #include <unistd.h>
+   #include <sys/stat.h>
    #include <netdb.h>
    #include <arpa/inet.h>
    #include <cerrno>
@@ -53,8 +54,6 @@ written by
    #endif
 #endif
 #include <cmath>
-#include <sstream>
-#include <iostream>
 #include "queue.h"
 #include "core.h"
 
@@ -74,16 +73,25 @@ const int32_t CSeqNo::m_iMaxSeqNo = 0x7FFFFFFF;
 const int32_t CAckNo::m_iMaxAckSeqNo = 0x7FFFFFFF;
 const int32_t CMsgNo::m_iMsgNoTH = 0xFFFFFFF;
 const int32_t CMsgNo::m_iMaxMsgNo = 0x1FFFFFFF;
+const int32_t CMsgNo::m_iMaxFrameMsgNo = 0x1FFFF;
 
 const int CUDT::m_iVersion = 4;
 const int CUDT::m_iSYNInterval = 10000;
 const int CUDT::m_iSelfClockInterval = 64;
+const int CUDT::m_iMinPathSample = 1000;
+const int CUDT::m_iMaxAbandoned = 256;
 
 
 CUDT::CUDT()
 {
    m_pSndBuffer = NULL;
    m_pRcvBuffer = NULL;
+   m_pRcvFrameBuffer = NULL;
+   m_pFrameTrace = NULL;
+   m_pShm = NULL;
+   m_iHSExtension = 0;
+   m_iHdrFormat = HDR_CLASSIC;
+   m_iNextLoan = 0;
    m_pSndLossList = NULL;
    m_pRcvLossList = NULL;
    m_pACKWindow = NULL;
@@ -117,10 +125,22 @@ CUDT::CUDT()
    m_iRcvTimeOut = -1;
    m_bReuseAddr = true;
    m_llMaxBW = -1;
+   m_bFrameDrop = false;
+   m_bFEC = false;
+   m_iSndSched = UDT_SCHED_LOSSFIRST;
+   m_iFrameTraceSize = 0;
+   m_bUDPOffload = false;
+   m_iWorkers = 1;
+   m_iPacingSlack = 20;
+   m_bURing = false;
+   m_bShmem = false;
+   m_bAdaptiveACK = false;
+   m_bFrameLayers = false;
 
    m_pCCFactory = new CCCFactory<CUDTCC>;
    m_pCC = NULL;
    m_pCache = NULL;
+   m_pSharedCache = NULL;
 
    // Initial status
    m_bOpened = false;
@@ -145,6 +165,12 @@ CUDT::CUDT(const CUDT& ancestor)
 {
    m_pSndBuffer = NULL;
    m_pRcvBuffer = NULL;
+   m_pRcvFrameBuffer = NULL;
+   m_pFrameTrace = NULL;
+   m_pShm = NULL;
+   m_iHSExtension = 0;
+   m_iHdrFormat = HDR_CLASSIC;
+   m_iNextLoan = 0;
    m_pSndLossList = NULL;
    m_pRcvLossList = NULL;
    m_pACKWindow = NULL;
@@ -177,10 +203,22 @@ CUDT::CUDT(const CUDT& ancestor)
    m_iRcvTimeOut = ancestor.m_iRcvTimeOut;
    m_bReuseAddr = true;	// this must be true, because all accepted sockets shared the same port with the listener
    m_llMaxBW = ancestor.m_llMaxBW;
+   m_bFrameDrop = ancestor.m_bFrameDrop;
+   m_bFEC = ancestor.m_bFEC;
+   m_iSndSched = ancestor.m_iSndSched;
+   m_iFrameTraceSize = ancestor.m_iFrameTraceSize;
+   m_bUDPOffload = ancestor.m_bUDPOffload;
+   m_iWorkers = ancestor.m_iWorkers;
+   m_iPacingSlack = ancestor.m_iPacingSlack;
+   m_bURing = ancestor.m_bURing;
+   m_bShmem = ancestor.m_bShmem;
+   m_bAdaptiveACK = ancestor.m_bAdaptiveACK;
+   m_bFrameLayers = ancestor.m_bFrameLayers;
 
    m_pCCFactory = ancestor.m_pCCFactory->clone();
    m_pCC = NULL;
    m_pCache = ancestor.m_pCache;
+   m_pSharedCache = ancestor.m_pSharedCache;
 
    // Initial status
    m_bOpened = false;
@@ -203,12 +241,18 @@ CUDT::CUDT(const CUDT& ancestor)
 
 CUDT::~CUDT()
 {
+   // the units lent to the application go back to the receiver buffer before it is deleted
+   releaseLoans();
+
    // release mutex/condtion variables
    destroySynch();
 
    // destroy the data structures
    delete m_pSndBuffer;
    delete m_pRcvBuffer;
+   delete m_pRcvFrameBuffer;
+   delete m_pFrameTrace;
+   delete m_pShm;
    delete m_pSndLossList;
    delete m_pRcvLossList;
    delete m_pACKWindow;
@@ -360,6 +404,82 @@ void CUDT::setOpt(UDTOpt optName, const void* optval, int)
    case UDT_MAXBW:
       m_llMaxBW = *(int64_t*)optval;
       break;
+
+   case UDT_FRAMEDROP:
+      m_bFrameDrop = *(bool*)optval;
+      break;
+
+   case UDT_SNDSCHED:
+      if ((*(int*)optval != UDT_SCHED_LOSSFIRST) && (*(int*)optval != UDT_SCHED_DEADLINE))
+         throw CUDTException(5, 3, 0);
+      m_iSndSched = *(int*)optval;
+      break;
+
+   case UDT_FRAMETRACE:
+      if (m_bOpened)
+         throw CUDTException(5, 1, 0);
+
+      if (*(int*)optval < 0)
+         throw CUDTException(5, 3, 0);
+
+      m_iFrameTraceSize = *(int*)optval;
+      break;
+
+   case UDP_OFFLOAD:
+      if (m_bOpened)
+         throw CUDTException(5, 1, 0);
+
+      m_bUDPOffload = *(bool*)optval;
+      break;
+
+   case UDT_WORKERS:
+      if (m_bOpened)
+         throw CUDTException(5, 1, 0);
+
+      if (*(int*)optval < 1)
+         throw CUDTException(5, 3, 0);
+
+      m_iWorkers = *(int*)optval;
+      break;
+
+   case UDT_PACINGSLACK:
+      if (m_bOpened)
+         throw CUDTException(5, 1, 0);
+
+      if (*(int*)optval < 0)
+         throw CUDTException(5, 3, 0);
+
+      m_iPacingSlack = *(int*)optval;
+      break;
+
+   case UDT_FEC:
+      m_bFEC = *(bool*)optval;
+      break;
+
+   case UDT_URING:
+      if (m_bOpened)
+         throw CUDTException(5, 1, 0);
+
+      m_bURing = *(bool*)optval;
+      break;
+
+   case UDT_SHMEM:
+      if (m_bConnecting || m_bConnected)
+         throw CUDTException(5, 1, 0);
+
+      m_bShmem = *(bool*)optval;
+      break;
+
+   case UDT_ADAPTIVEACK:
+      m_bAdaptiveACK = *(bool*)optval;
+      break;
+
+   case UDT_FRAMELAYERS:
+      if (m_bConnecting || m_bConnected)
+         throw CUDTException(5, 1, 0);
+
+      m_bFrameLayers = *(bool*)optval;
+      break;
     
    default:
       throw CUDTException(5, 0, 0);
@@ -491,6 +611,61 @@ void CUDT::getOpt(UDTOpt optName, void* optval, int& optlen)
       optlen = sizeof(int32_t);
       break;
 
+   case UDT_FRAMEDROP:
+      *(bool*)optval = m_bFrameDrop;
+      optlen = sizeof(bool);
+      break;
+
+   case UDT_SNDSCHED:
+      *(int*)optval = m_iSndSched;
+      optlen = sizeof(int);
+      break;
+
+   case UDT_FRAMETRACE:
+      *(int*)optval = m_iFrameTraceSize;
+      optlen = sizeof(int);
+      break;
+
+   case UDP_OFFLOAD:
+      *(bool*)optval = m_bUDPOffload;
+      optlen = sizeof(bool);
+      break;
+
+   case UDT_WORKERS:
+      *(int*)optval = m_iWorkers;
+      optlen = sizeof(int);
+      break;
+
+   case UDT_PACINGSLACK:
+      *(int*)optval = m_iPacingSlack;
+      optlen = sizeof(int);
+      break;
+
+   case UDT_FEC:
+      *(bool*)optval = m_bFEC;
+      optlen = sizeof(bool);
+      break;
+
+   case UDT_URING:
+      *(bool*)optval = m_bURing;
+      optlen = sizeof(bool);
+      break;
+
+   case UDT_SHMEM:
+      *(bool*)optval = m_bShmem;
+      optlen = sizeof(bool);
+      break;
+
+   case UDT_ADAPTIVEACK:
+      *(bool*)optval = m_bAdaptiveACK;
+      optlen = sizeof(bool);
+      break;
+
+   case UDT_FRAMELAYERS:
+      *(bool*)optval = m_bFrameLayers;
+      optlen = sizeof(bool);
+      break;
+
    default:
       throw CUDTException(5, 0, 0);
    }
@@ -501,8 +676,9 @@ void CUDT::open()
    CGuard cg(m_ConnectionLock);
 
    // Initial sequence number, loss, acknowledgement, etc.
+   // until the header is agreed, room for the payload of the smaller one; the receiver units are sized by it
    m_iPktSize = m_iMSS - 28;
-   m_iPayloadSize = m_iPktSize - CPacket::m_iPktHdrSize;
+   m_iPayloadSize = m_iPktSize - CHeaderFormat<HDR_CLASSIC>::m_iSize;
 
    m_iEXPCount = 1;
    m_iBandwidth = 1;
@@ -513,9 +689,25 @@ void CUDT::open()
    // trace information
    m_StartTime = CTimer::getTime();
    m_llSentTotal = m_llRecvTotal = m_iSndLossTotal = m_iRcvLossTotal = m_iRetransTotal = m_iSentACKTotal = m_iRecvACKTotal = m_iSentNAKTotal = m_iRecvNAKTotal = 0;
+   m_iRcvNoUnitTotal = m_iTraceRcvNoUnit = 0;
+   m_iRcvRecoveredTotal = m_iTraceRcvRecovered = 0;
+   m_iSndShedTotal = m_iTraceSndShed = 0;
+   m_llRcvPartialTotal = m_iTraceRcvPartial = 0;
+   m_iCtrlSavedTotal = m_iTraceCtrlSaved = 0;
+   m_iHSRecvTotal = m_iHSDropTotal = m_iHSRejectTotal = m_iAcceptTotal = 0;
+   m_iTraceHSRecv = m_iTraceHSDrop = m_iTraceHSReject = m_iTraceAccept = 0;
+   m_llTraceHSWait = m_llMaxHSWait = 0;
    m_LastSampleTime = CTimer::getTime();
    m_llTraceSent = m_llTraceRecv = m_iTraceSndLoss = m_iTraceRcvLoss = m_iTraceRetrans = m_iSentACK = m_iRecvACK = m_iSentNAK = m_iRecvNAK = 0;
    m_llSndDuration = m_llSndDurationTotal = 0;
+   m_llTracePacingError = m_llTracePacingCount = m_ullMaxPacingError = 0;
+   m_llFrameSentTotal = m_iTraceFrameSent = 0;
+   m_SndFrameStats = CFrameStats();
+   m_RcvFrameStats = CFrameStats();
+
+   // VR Frame Awareness: frame event trace, allocated once and kept until the socket is released
+   if ((m_iFrameTraceSize > 0) && (NULL == m_pFrameTrace))
+      m_pFrameTrace = new CFrameTrace(m_iFrameTraceSize);
 
    // structures for queue
    if (NULL == m_pSNode)
@@ -553,10 +745,28 @@ void CUDT::open()
 
    m_iPktCount = 0;
    m_iLightACKCount = 1;
+   m_iLightACKInterval = m_iSelfClockInterval;
+   m_ullFixedNextACKTime = m_ullNextACKTime;
+   m_iFixedPktCount = 0;
+   m_bRcvMidFrame = false;
 
    m_ullTargetTime = 0;
    m_ullTimeDiff = 0;
 
+   m_SndAbandoned.clear();
+   m_iSndAbandonAck = -1;
+   m_ullNextFrameCheckTime = currtime;
+
+   m_dFECLossRate = 0;
+   m_llFECSent = 0;
+   m_iFECLost = m_iPeerRecoveredTotal = 0;
+   m_dSndLossRate = 0;
+   m_llLossRateSent = 0;
+   m_iLossRateLost = 0;
+   m_bPeerFEC = false;
+   m_iFECPendingFrame = -1;
+   m_ullFECPendingTime = 0;
+
    // Now UDT is opened.
    m_bOpened = true;
 }
@@ -575,6 +785,10 @@ void CUDT::listen()
    if (m_bListening)
       return;
 
+   // the key must be in place before the first handshake can reach listen()
+   CCookie::genKey(m_pullCookieKey);
+   m_LastAcceptSampleTime = CTimer::getTime();
+
    // if there is already another socket listening on the same port
    if (m_pRcvQueue->setListener(this) < 0)
       throw CUDTException(5, 11, 0);
@@ -615,6 +829,9 @@ void CUDT::connect(const sockaddr* serv_addr)
    m_ConnReq.m_iFlightFlagSize = (m_iRcvBufSize < m_iFlightFlagSize)? m_iRcvBufSize : m_iFlightFlagSize;
    m_ConnReq.m_iReqType = (!m_bRendezvous) ? 1 : 0;
    m_ConnReq.m_iID = m_SocketID;
+   // a listener advertises its extensions in the cookie response first, a rendezvous peer has no such round
+   m_ConnReq.m_iExtension = (m_bRendezvous ? CHandShake::m_iExtAckNak : 0) | ((m_bRendezvous && (UDT_DGRAM == m_iSockType)) ? CHandShake::m_iExtFrameHeader : 0) |
+                            ((m_bRendezvous && m_bFrameLayers && (UDT_DGRAM == m_iSockType)) ? CHandShake::m_iExtFrameLayers : 0);
    CIPAddress::ntop(serv_addr, m_ConnReq.m_piPeerIP, m_iIPversion);
 
    // Random Initial Sequence Number
@@ -662,6 +879,7 @@ void CUDT::connect(const sockaddr* serv_addr)
       // avoid sending too many requests, at most 1 request per 250ms
       if (CTimer::getTime() - m_llLastReqTime > 250000)
       {
+         hs_size = m_iPayloadSize;
          m_ConnReq.serialize(reqdata, hs_size);
          request.setLength(hs_size);
          if (m_bRendezvous)
@@ -748,6 +966,29 @@ int CUDT::connect(const CPacket& response) throw ()
       {
          m_ConnReq.m_iReqType = -1;
          m_ConnReq.m_iCookie = m_ConnRes.m_iCookie;
+
+         // the listener advertises its extensions in the cookie response, take those both sides have
+         if (NULL == m_pShm)
+         {
+            m_ConnReq.m_iExtension = m_ConnRes.m_iExtension & ((m_bShmem ? CHandShake::m_iExtShmem : 0) | ((UDT_DGRAM == m_iSockType) ? CHandShake::m_iExtFrameHeader : 0) | CHandShake::m_iExtAckNak |
+                                                              ((m_bFrameLayers && (UDT_DGRAM == m_iSockType)) ? CHandShake::m_iExtFrameLayers : 0));
+            if (0 != (m_ConnReq.m_iExtension & CHandShake::m_iExtShmem))
+            {
+               // a listener on the same host will find the segment by the socket ID and ISN
+               m_pShm = new CShmLink;
+               int bufsize = (m_iSndBufSize > m_iRcvBufSize) ? m_iSndBufSize : m_iRcvBufSize;
+               int64_t ringsize = (int64_t)bufsize * (m_iMSS - 28 - CPacket::m_iPktHdrSize);
+               if (ringsize > CShmLink::m_iMaxRingSize)
+                  ringsize = CShmLink::m_iMaxRingSize;
+               if (m_pShm->create(m_SocketID, m_iISN, (int)ringsize, UDT_DGRAM == m_iSockType) < 0)
+               {
+                  delete m_pShm;
+                  m_pShm = NULL;
+                  m_ConnReq.m_iExtension &= ~CHandShake::m_iExtShmem;
+               }
+            }
+         }
+
          m_llLastReqTime = 0;
          return 1;
       }
@@ -761,19 +1002,35 @@ POST_CONNECT:
    m_iMSS = m_ConnRes.m_iMSS;
    m_iFlowWindowSize = m_ConnRes.m_iFlightFlagSize;
    m_iPktSize = m_iMSS - 28;
-   m_iPayloadSize = m_iPktSize - CPacket::m_iPktHdrSize;
    m_iPeerISN = m_ConnRes.m_iISN;
    m_iRcvLastAck = m_ConnRes.m_iISN;
    m_iRcvLastAckAck = m_ConnRes.m_iISN;
+   m_iFixedLastAck = m_ConnRes.m_iISN;
    m_iRcvCurrSeqNo = m_ConnRes.m_iISN - 1;
    m_PeerID = m_ConnRes.m_iID;
    memcpy(m_piSelfIP, m_ConnRes.m_piPeerIP, 16);
 
+   // the listener has attached to the shared memory if it agrees to use it; either way the name is not needed any more
+   m_iHSExtension = m_ConnRes.m_iExtension & m_ConnReq.m_iExtension;
+   m_iHdrFormat = (0 == (m_iHSExtension & CHandShake::m_iExtFrameHeader)) ? HDR_CLASSIC : (0 == (m_iHSExtension & CHandShake::m_iExtFrameLayers)) ? HDR_FRAME : HDR_LAYERED;
+   m_iPayloadSize = m_iPktSize - CPacket::getFormatSize(m_iHdrFormat);
+   if (NULL != m_pShm)
+   {
+      m_pShm->unlink();
+      if (0 == (m_iHSExtension & CHandShake::m_iExtShmem))
+      {
+         delete m_pShm;
+         m_pShm = NULL;
+      }
+   }
+
    // Prepare all data structures
    try
    {
-      m_pSndBuffer = new CSndBuffer(32, m_iPayloadSize);
+      m_pSndBuffer = new CSndBuffer(32, m_iPayloadSize, (HDR_CLASSIC == m_iHdrFormat) ? CMsgNo::m_iMaxMsgNo : CMsgNo::m_iMaxFrameMsgNo);
       m_pRcvBuffer = new CRcvBuffer(&(m_pRcvQueue->m_UnitQueue), m_iRcvBufSize);
+      if (UDT_DGRAM == m_iSockType)
+         m_pRcvFrameBuffer = new CRcvFrameBuffer();
       // after introducing lite ACK, the sndlosslist may not be cleared in time, so it requires twice space.
       m_pSndLossList = new CSndLossList(m_iFlowWindowSize * 2);
       m_pRcvLossList = new CRcvLossList(m_iFlightFlagSize);
@@ -789,7 +1046,7 @@ POST_CONNECT:
    CInfoBlock ib;
    ib.m_iIPversion = m_iIPversion;
    CInfoBlock::convert(m_pPeerAddr, m_iIPversion, ib.m_piIP);
-   if (m_pCache->lookup(&ib) >= 0)
+   if (lookupCache(&ib) >= 0)
    {
       m_iRTT = ib.m_iRTT;
       m_iBandwidth = ib.m_iBandwidth;
@@ -803,6 +1060,7 @@ POST_CONNECT:
    m_pCC->setRcvRate(m_iDeliveryRate);
    m_pCC->setRTT(m_iRTT);
    m_pCC->setBandwidth(m_iBandwidth);
+   m_pCC->setPathSndPeriod(ib.m_dInterval);
    m_pCC->init();
 
    m_ullInterval = (uint64_t)(m_pCC->m_dPktSndPeriod * m_ullCPUFrequency);
@@ -843,11 +1101,28 @@ void CUDT::connect(const sockaddr* peer, CHandShake* hs)
 
    m_iRcvLastAck = hs->m_iISN;
    m_iRcvLastAckAck = hs->m_iISN;
+   m_iFixedLastAck = hs->m_iISN;
    m_iRcvCurrSeqNo = hs->m_iISN - 1;
 
    m_PeerID = hs->m_iID;
    hs->m_iID = m_SocketID;
 
+   // the shared memory created by the peer can only be attached to on the same host
+   m_iHSExtension = hs->m_iExtension & ((m_bShmem ? CHandShake::m_iExtShmem : 0) | ((UDT_DGRAM == m_iSockType) ? CHandShake::m_iExtFrameHeader : 0) | CHandShake::m_iExtAckNak |
+                                        ((m_bFrameLayers && (UDT_DGRAM == m_iSockType)) ? CHandShake::m_iExtFrameLayers : 0));
+   if (0 != (m_iHSExtension & CHandShake::m_iExtShmem))
+   {
+      m_pShm = new CShmLink;
+      if (m_pShm->attach(m_PeerID, hs->m_iISN, UDT_DGRAM == m_iSockType) < 0)
+      {
+         delete m_pShm;
+         m_pShm = NULL;
+         m_iHSExtension &= ~CHandShake::m_iExtShmem;
+      }
+   }
+   hs->m_iExtension = m_iHSExtension;
+   m_iHdrFormat = (0 == (m_iHSExtension & CHandShake::m_iExtFrameHeader)) ? HDR_CLASSIC : (0 == (m_iHSExtension & CHandShake::m_iExtFrameLayers)) ? HDR_FRAME : HDR_LAYERED;
+
    // use peer's ISN and send it back for security check
    m_iISN = hs->m_iISN;
 
@@ -866,13 +1141,15 @@ void CUDT::connect(const sockaddr* peer, CHandShake* hs)
    CIPAddress::ntop(peer, hs->m_piPeerIP, m_iIPversion);
   
    m_iPktSize = m_iMSS - 28;
-   m_iPayloadSize = m_iPktSize - CPacket::m_iPktHdrSize;
+   m_iPayloadSize = m_iPktSize - CPacket::getFormatSize(m_iHdrFormat);
 
    // Prepare all structures
    try
    {
-      m_pSndBuffer = new CSndBuffer(32, m_iPayloadSize);
+      m_pSndBuffer = new CSndBuffer(32, m_iPayloadSize, (HDR_CLASSIC == m_iHdrFormat) ? CMsgNo::m_iMaxMsgNo : CMsgNo::m_iMaxFrameMsgNo);
       m_pRcvBuffer = new CRcvBuffer(&(m_pRcvQueue->m_UnitQueue), m_iRcvBufSize);
+      if (UDT_DGRAM == m_iSockType)
+         m_pRcvFrameBuffer = new CRcvFrameBuffer();
       m_pSndLossList = new CSndLossList(m_iFlowWindowSize * 2);
       m_pRcvLossList = new CRcvLossList(m_iFlightFlagSize);
       m_pACKWindow = new CACKWindow(1024);
@@ -887,7 +1164,7 @@ void CUDT::connect(const sockaddr* peer, CHandShake* hs)
    CInfoBlock ib;
    ib.m_iIPversion = m_iIPversion;
    CInfoBlock::convert(peer, m_iIPversion, ib.m_piIP);
-   if (m_pCache->lookup(&ib) >= 0)
+   if (lookupCache(&ib) >= 0)
    {
       m_iRTT = ib.m_iRTT;
       m_iBandwidth = ib.m_iBandwidth;
@@ -901,6 +1178,7 @@ void CUDT::connect(const sockaddr* peer, CHandShake* hs)
    m_pCC->setRcvRate(m_iDeliveryRate);
    m_pCC->setRTT(m_iRTT);
    m_pCC->setBandwidth(m_iBandwidth);
+   m_pCC->setPathSndPeriod(ib.m_dInterval);
    m_pCC->init();
 
    m_ullInterval = (uint64_t)(m_pCC->m_dPktSndPeriod * m_ullCPUFrequency);
@@ -918,7 +1196,7 @@ void CUDT::connect(const sockaddr* peer, CHandShake* hs)
 
    //send the response to the peer, see listen() for more discussions about this
    CPacket response;
-   int size = CHandShake::m_iContentSize;
+   int size = CHandShake::m_iExtContentSize;
    char* buffer = new char[size];
    hs->serialize(buffer, size);
    response.pack(0, NULL, buffer, size);
@@ -1001,18 +1279,37 @@ void CUDT::close()
 
    if (m_bConnected)
    {
+      if (NULL != m_pShm)
+         m_pShm->close();
+
       if (!m_bShutdown)
          sendCtrl(5);
 
       m_pCC->close();
 
-      // Store current connection information.
-      CInfoBlock ib;
-      ib.m_iIPversion = m_iIPversion;
-      CInfoBlock::convert(m_pPeerAddr, m_iIPversion, ib.m_piIP);
-      ib.m_iRTT = m_iRTT;
-      ib.m_iBandwidth = m_iBandwidth;
-      m_pCache->update(&ib);
+      // Store current connection information; nothing is measured over shared memory
+      if (NULL == m_pShm)
+      {
+         CInfoBlock ib;
+         ib.m_iIPversion = m_iIPversion;
+         CInfoBlock::convert(m_pPeerAddr, m_iIPversion, ib.m_piIP);
+         lookupCache(&ib);
+         ib.m_iRTT = m_iRTT;
+         ib.m_iBandwidth = m_iBandwidth;
+
+         // the rate the path carried while there was data to send, if enough was sent to tell;
+         // otherwise the rate of an earlier connection is kept
+         int64_t duration = m_llSndDurationTotal;
+         if (m_pSndBuffer->getCurrBufSize() > 0)
+            duration += CTimer::getTime() - m_llSndDurationCounter;
+         if ((m_llSentTotal >= m_iMinPathSample) && (duration > 0))
+         {
+            ib.m_dInterval = double(duration) / m_llSentTotal;
+            ib.m_dCWnd = m_dCongestionWindow;
+         }
+
+         updateCache(&ib);
+      }
 
       m_bConnected = false;
    }
@@ -1025,6 +1322,17 @@ void CUDT::close()
    m_bOpened = false;
 }
 
+void CUDT::stopListening()
+{
+   CGuard cg(m_ConnectionLock);
+
+   if (m_bListening)
+   {
+      m_bListening = false;
+      m_pRcvQueue->removeListener(this);
+   }
+}
+
 int CUDT::send(const char* data, int len)
 {
    if (UDT_DGRAM == m_iSockType)
@@ -1041,6 +1349,9 @@ int CUDT::send(const char* data, int len)
 
    CGuard sendguard(m_SendLock);
 
+   if (NULL != m_pShm)
+      return shmWrite(data, len, -1, 0, m_bSynSending, m_iSndTimeOut);
+
    if (m_pSndBuffer->getCurrBufSize() == 0)
    {
       // delay the EXP timer to avoid mis-fired timeout
@@ -1152,6 +1463,19 @@ int CUDT::recv(char* data, int len)
    if (UDT_DGRAM == m_iSockType)
       throw CUDTException(5, 10, 0);
 
+   // data left in the shared memory can still be read after the peer has closed
+   if (m_bConnected && (NULL != m_pShm))
+   {
+      if (len <= 0)
+         return 0;
+
+      CGuard recvguard(m_RecvLock);
+
+      int32_t frame_id;
+      int64_t deadline;
+      return shmRead(data, len, frame_id, deadline, m_bSynRecving, m_iRcvTimeOut);
+   }
+
    // throw an exception if not connected
    if (!m_bConnected)
       throw CUDTException(2, 2, 0);
@@ -1253,6 +1577,10 @@ int CUDT::sendmsg(const char* data, int len, int msttl, bool inorder)
 
    CGuard sendguard(m_SendLock);
 
+   // the ring delivers every message, in order
+   if (NULL != m_pShm)
+      return shmWrite(data, len, -1, 0, m_bSynSending, m_iSndTimeOut);
+
    if (m_pSndBuffer->getCurrBufSize() == 0)
    {
       // delay the EXP timer to avoid mis-fired timeout
@@ -1351,6 +1679,13 @@ int CUDT::recvmsg(char* data, int len)
 
    CGuard recvguard(m_RecvLock);
 
+   if (NULL != m_pShm)
+   {
+      int32_t frame_id;
+      int64_t deadline;
+      return shmRead(data, len, frame_id, deadline, m_bSynRecving, m_iRcvTimeOut);
+   }
+
    if (m_bBroken || m_bClosing)
    {
       int res = m_pRcvBuffer->readMsg(data, len);
@@ -1436,21 +1771,40 @@ int CUDT::recvmsg(char* data, int len)
    return res;
 }
 
-int64_t CUDT::sendfile(fstream& ifs, int64_t& offset, int64_t size, int block)
+int CUDT::sendframe(const char* data, int len, uint16_t frame_id, int64_t deadline_us, UDTFRAMEDONE callback, void* context, bool block,
+                    const int* layers, int nlayers, int required)
 {
-   if (UDT_DGRAM == m_iSockType)
-      throw CUDTException(5, 10, 0);
-
+   // throw an exception if not connected
    if (m_bBroken || m_bClosing)
       throw CUDTException(2, 1, 0);
    else if (!m_bConnected)
       throw CUDTException(2, 2, 0);
 
-   if (size <= 0)
+   if (len <= 0)
       return 0;
 
+   // the whole frame must fit into the sender buffer, and chunk IDs are 8 bits
+   if ((len > m_iSndBufSize * m_iPayloadSize) || (len > 255 * m_iPayloadSize))
+      throw CUDTException(5, 12, 0);
+   if ((nlayers > 0) && (CSndBuffer::countLayerChunks(layers, nlayers, m_iPayloadSize) > 255))
+      throw CUDTException(5, 12, 0);
+
    CGuard sendguard(m_SendLock);
 
+   if (NULL != m_pShm)
+   {
+      // the deadline goes as local time, the peer shares the clock; the frame is copied, so the buffer is done with at once
+      int res = shmWrite(data, len, frame_id, (deadline_us > 0) ? m_StartTime + deadline_us : 0, m_bSynSending && block, m_iSndTimeOut);
+      if (res > 0)
+      {
+         ++ m_llFrameSentTotal;
+         ++ m_iTraceFrameSent;
+         if (NULL != callback)
+            callback(m_SocketID, data, len, context);
+      }
+      return res;
+   }
+
    if (m_pSndBuffer->getCurrBufSize() == 0)
    {
       // delay the EXP timer to avoid mis-fired timeout
@@ -1459,109 +1813,891 @@ int64_t CUDT::sendfile(fstream& ifs, int64_t& offset, int64_t size, int block)
       m_ullLastRspTime = currtime;
    }
 
-   int64_t tosend = size;
-   int unitsize;
-
-   // positioning...
-   try
-   {
-      ifs.seekg((streamoff)offset);
-   }
-   catch (...)
-   {
-      throw CUDTException(4, 1);
-   }
-
-   // sending block by block
-   while (tosend > 0)
+   if ((m_iSndBufSize - m_pSndBuffer->getCurrBufSize()) * m_iPayloadSize < len)
    {
-      if (ifs.fail())
-         throw CUDTException(4, 4);
+      if (!m_bSynSending || !block)
+         throw CUDTException(6, 1, 0);
+      else
+      {
+         // wait here during a blocking sending
+         #ifndef WIN32
+            pthread_mutex_lock(&m_SendBlockLock);
+            if (m_iSndTimeOut < 0)
+            {
+               while (!m_bBroken && m_bConnected && !m_bClosing && ((m_iSndBufSize - m_pSndBuffer->getCurrBufSize()) * m_iPayloadSize < len))
+                  pthread_cond_wait(&m_SendBlockCond, &m_SendBlockLock);
+            }
+            else
+            {
+               uint64_t exptime = CTimer::getTime() + m_iSndTimeOut * 1000ULL;
+               timespec locktime;
 
-      if (ifs.eof())
-         break;
+               locktime.tv_sec = exptime / 1000000;
+               locktime.tv_nsec = (exptime % 1000000) * 1000;
 
-      unitsize = int((tosend >= block) ? block : tosend);
+               while (!m_bBroken && m_bConnected && !m_bClosing && ((m_iSndBufSize - m_pSndBuffer->getCurrBufSize()) * m_iPayloadSize < len) && (CTimer::getTime() < exptime))
+                  pthread_cond_timedwait(&m_SendBlockCond, &m_SendBlockLock, &locktime);
+            }
+            pthread_mutex_unlock(&m_SendBlockLock);
+         #else
+            if (m_iSndTimeOut < 0)
+            {
+               while (!m_bBroken && m_bConnected && !m_bClosing && ((m_iSndBufSize - m_pSndBuffer->getCurrBufSize()) * m_iPayloadSize < len))
+                  WaitForSingleObject(m_SendBlockCond, INFINITE);
+            }
+            else
+            {
+               uint64_t exptime = CTimer::getTime() + m_iSndTimeOut * 1000ULL;
 
-      #ifndef WIN32
-         pthread_mutex_lock(&m_SendBlockLock);
-         while (!m_bBroken && m_bConnected && !m_bClosing && (m_iSndBufSize <= m_pSndBuffer->getCurrBufSize()) && m_bPeerHealth)
-            pthread_cond_wait(&m_SendBlockCond, &m_SendBlockLock);
-         pthread_mutex_unlock(&m_SendBlockLock);
-      #else
-         while (!m_bBroken && m_bConnected && !m_bClosing && (m_iSndBufSize <= m_pSndBuffer->getCurrBufSize()) && m_bPeerHealth)
-            WaitForSingleObject(m_SendBlockCond, INFINITE);
-      #endif
+               while (!m_bBroken && m_bConnected && !m_bClosing && ((m_iSndBufSize - m_pSndBuffer->getCurrBufSize()) * m_iPayloadSize < len) && (CTimer::getTime() < exptime))
+                  WaitForSingleObject(m_SendBlockCond, DWORD((exptime - CTimer::getTime()) / 1000));
+            }
+         #endif
 
-      if (m_bBroken || m_bClosing)
-         throw CUDTException(2, 1, 0);
-      else if (!m_bConnected)
-         throw CUDTException(2, 2, 0);
-      else if (!m_bPeerHealth)
-      {
-         // reset peer health status, once this error returns, the app should handle the situation at the peer side
-         m_bPeerHealth = true;
-         throw CUDTException(7);
+         // check the connection status
+         if (m_bBroken || m_bClosing)
+            throw CUDTException(2, 1, 0);
+         else if (!m_bConnected)
+            throw CUDTException(2, 2, 0);
       }
+   }
 
-      // record total time used for sending
-      if (0 == m_pSndBuffer->getCurrBufSize())
-         m_llSndDurationCounter = CTimer::getTime();
+   if ((m_iSndBufSize - m_pSndBuffer->getCurrBufSize()) * m_iPayloadSize < len)
+   {
+      if (m_iSndTimeOut >= 0)
+         throw CUDTException(6, 3, 0);
 
-      int64_t sentsize = m_pSndBuffer->addBufferFromFile(ifs, unitsize);
+      return 0;
+   }
 
-      if (sentsize > 0)
+   // record total time used for sending
+   if (0 == m_pSndBuffer->getCurrBufSize())
+      m_llSndDurationCounter = CTimer::getTime();
+
+   // VR Frame Awareness: parity for about one loss per group, at the loss rate over the last few hundred packets;
+   // losses the receiver has rebuilt count as well, as they are never reported
+   int parity = 0;
+   if (m_bFEC && (nlayers <= 0))
+   {
+      int64_t sent = m_llSentTotal - m_llFECSent;
+      if (sent >= 256)
       {
-         tosend -= sentsize;
-         offset += sentsize;
+         int lost = m_iSndLossTotal + m_iPeerRecoveredTotal;
+         m_dFECLossRate = m_dFECLossRate * 0.75 + 0.25 * (lost - m_iFECLost) / sent;
+         m_llFECSent = m_llSentTotal;
+         m_iFECLost = lost;
       }
 
-      // insert this socket to snd list if it is not on the list yet
-      m_pSndQueue->m_pSndUList->update(this, false);
+      int chunk = m_iPayloadSize - CFrameFEC::m_iHdrSize;
+      parity = CFrameFEC::getGroups((len + chunk - 1) / chunk, m_dFECLossRate);
    }
 
+   // insert the whole frame into the sending list, frames are delivered in order;
+   // a layered frame is sent whole, all of it required, when the peer does not take the layered header
+   if (nlayers > 0)
+      m_pSndBuffer->addLayeredFrame(data, layers, nlayers, (HDR_LAYERED == m_iHdrFormat) ? required : nlayers, frame_id, deadline_us);
+   else if (NULL == callback)
+      m_pSndBuffer->addFrame(data, len, frame_id, deadline_us, -1, true, parity);
+   else
+      m_pSndBuffer->addFrameRef(data, len, frame_id, deadline_us, m_SocketID, callback, context, parity);
+   ++ m_llFrameSentTotal;
+   ++ m_iTraceFrameSent;
+
+   // insert this socket to the snd list if it is not on the list yet
+   m_pSndQueue->m_pSndUList->update(this, false);
+
    if (m_iSndBufSize <= m_pSndBuffer->getCurrBufSize())
    {
       // write is not available any more
       s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, UDT_EPOLL_OUT, false);
    }
 
-   return size - tosend;
+   return len;
 }
 
-int64_t CUDT::recvfile(fstream& ofs, int64_t& offset, int64_t size, int block)
+int CUDT::recvframe(char* data, int len, uint16_t& frame_id, bool& complete, bool block)
 {
-   if (UDT_DGRAM == m_iSockType)
-      throw CUDTException(5, 10, 0);
+   if (UDT_STREAM == m_iSockType)
+      throw CUDTException(5, 9, 0);
 
+   // throw an exception if not connected
    if (!m_bConnected)
       throw CUDTException(2, 2, 0);
-   else if ((m_bBroken || m_bClosing) && (0 == m_pRcvBuffer->getRcvDataSize()))
-      throw CUDTException(2, 1, 0);
 
-   if (size <= 0)
+   if (len <= 0)
       return 0;
 
    CGuard recvguard(m_RecvLock);
 
-   int64_t torecv = size;
-   int unitsize = block;
+   int res = 0;
+
+   if (NULL != m_pShm)
+   {
+      int32_t id;
+      int64_t deadline;
+      res = shmRead(data, len, id, deadline, m_bSynRecving, m_iRcvTimeOut);
+      frame_id = (uint16_t)id;
+
+      // a frame past its deadline is reported as dropped, as it would be over the network
+      complete = !m_bFrameDrop || (deadline <= 0) || ((int64_t)CTimer::getTime() <= deadline);
+      return complete ? res : 0;
+   }
+
+   if (m_bBroken || m_bClosing)
+   {
+      if (!readFrame(data, len, res, frame_id, complete))
+         throw CUDTException(2, 1, 0);
+      else
+         return res;
+   }
+
+   if (!m_bSynRecving || !block)
+   {
+      if (!readFrame(data, len, res, frame_id, complete))
+      {
+         // read is not available any more, unless a frame has come in meanwhile
+         s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, UDT_EPOLL_IN, false);
+         if (!readFrame(data, len, res, frame_id, complete))
+            throw CUDTException(6, 2, 0);
+         s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, UDT_EPOLL_IN, true);
+      }
+
+      return res;
+   }
+
+   bool found = false;
+   bool timeout = false;
+
+   do
+   {
+      #ifndef WIN32
+         pthread_mutex_lock(&m_RecvDataLock);
+
+         if (m_iRcvTimeOut < 0)
+         {
+            while (!m_bBroken && m_bConnected && !m_bClosing && !(found = readFrame(data, len, res, frame_id, complete)))
+               pthread_cond_wait(&m_RecvDataCond, &m_RecvDataLock);
+         }
+         else
+         {
+            uint64_t exptime = CTimer::getTime() + m_iRcvTimeOut * 1000ULL;
+            timespec locktime;
+
+            locktime.tv_sec = exptime / 1000000;
+            locktime.tv_nsec = (exptime % 1000000) * 1000;
+
+            if (!(found = readFrame(data, len, res, frame_id, complete)))
+            {
+               if (pthread_cond_timedwait(&m_RecvDataCond, &m_RecvDataLock, &locktime) == ETIMEDOUT)
+                  timeout = true;
+
+               found = readFrame(data, len, res, frame_id, complete);
+            }
+         }
+         pthread_mutex_unlock(&m_RecvDataLock);
+      #else
+         if (m_iRcvTimeOut < 0)
+         {
+            while (!m_bBroken && m_bConnected && !m_bClosing && !(found = readFrame(data, len, res, frame_id, complete)))
+               WaitForSingleObject(m_RecvDataCond, INFINITE);
+         }
+         else
+         {
+            if (!(found = readFrame(data, len, res, frame_id, complete)))
+            {
+               if (WaitForSingleObject(m_RecvDataCond, DWORD(m_iRcvTimeOut)) == WAIT_TIMEOUT)
+                  timeout = true;
+
+               found = readFrame(data, len, res, frame_id, complete);
+            }
+         }
+      #endif
+
+      if (found)
+         break;
+
+      if (m_bBroken || m_bClosing)
+         throw CUDTException(2, 1, 0);
+      else if (!m_bConnected)
+         throw CUDTException(2, 2, 0);
+   } while (!timeout);
+
+   if (m_pRcvFrameBuffer->getReadyFrameNum() <= 0)
+   {
+      CGuard dropguard(m_DroppedFramesLock);
+
+      // read is not available any more
+      if (m_DroppedFrames.empty())
+         s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, UDT_EPOLL_IN, false);
+   }
+
+   if (!found && (m_iRcvTimeOut >= 0))
+      throw CUDTException(6, 3, 0);
+
+   return res;
+}
+
+bool CUDT::readFrame(char* data, int len, int& size, uint16_t& frame_id, bool& complete)
+{
+   // frames abandoned by the sender are reported first
+   CGuard::enterCS(m_DroppedFramesLock);
+   if (!m_DroppedFrames.empty())
+   {
+      frame_id = m_DroppedFrames.front();
+      m_DroppedFrames.pop_front();
+      CGuard::leaveCS(m_DroppedFramesLock);
+
+      size = 0;
+      complete = false;
+      return true;
+   }
+   CGuard::leaveCS(m_DroppedFramesLock);
+
+   // complete frames are read in the order they became complete; a frame without its optional layers
+   // leaves the chunks that came of them behind
+   int pos;
+   int chunks;
+   int total;
+   while (m_pRcvFrameBuffer->getReadyFrame(frame_id, pos, chunks, total))
+   {
+      if (chunks < total)
+         m_pRcvBuffer->dropUnits((pos + chunks) % m_pRcvBuffer->getSize(), total - chunks);
+
+      if ((size = m_pRcvBuffer->readFrame(data, len, pos, frame_id, chunks)) < 0)
+         continue;
+
+      complete = (chunks == total);
+      return true;
+   }
+
+   return false;
+}
+
+int CUDT::recvzc(bool frame, const UDT_IOVEC*& iov, int& iovcnt, uint16_t& frame_id, bool& complete, int& handle)
+{
+   if (UDT_STREAM == m_iSockType)
+      throw CUDTException(5, 9, 0);
+
+   // throw an exception if not connected
+   if (!m_bConnected)
+      throw CUDTException(2, 2, 0);
+
+   // data arriving over shared memory is consumed from the ring, so it cannot be lent
+   if (NULL != m_pShm)
+      throw CUDTException(5, 15, 0);
+
+   CGuard recvguard(m_RecvLock);
+
+   int res = 0;
+   bool found = false;
+   bool timeout = false;
+
+   if (m_bBroken || m_bClosing)
+   {
+      if (!(found = lendData(frame, res, frame_id, complete, handle)))
+         throw CUDTException(2, 1, 0);
+   }
+   else if (!m_bSynRecving)
+   {
+      if (!(found = lendData(frame, res, frame_id, complete, handle)))
+         throw CUDTException(6, 2, 0);
+   }
+
+   while (!found && !timeout)
+   {
+      #ifndef WIN32
+         pthread_mutex_lock(&m_RecvDataLock);
+
+         if (m_iRcvTimeOut < 0)
+         {
+            while (!m_bBroken && m_bConnected && !m_bClosing && !(found = lendData(frame, res, frame_id, complete, handle)))
+               pthread_cond_wait(&m_RecvDataCond, &m_RecvDataLock);
+         }
+         else
+         {
+            uint64_t exptime = CTimer::getTime() + m_iRcvTimeOut * 1000ULL;
+            timespec locktime;
+
+            locktime.tv_sec = exptime / 1000000;
+            locktime.tv_nsec = (exptime % 1000000) * 1000;
+
+            if (!(found = lendData(frame, res, frame_id, complete, handle)))
+            {
+               if (pthread_cond_timedwait(&m_RecvDataCond, &m_RecvDataLock, &locktime) == ETIMEDOUT)
+                  timeout = true;
+
+               found = lendData(frame, res, frame_id, complete, handle);
+            }
+         }
+         pthread_mutex_unlock(&m_RecvDataLock);
+      #else
+         if (m_iRcvTimeOut < 0)
+         {
+            while (!m_bBroken && m_bConnected && !m_bClosing && !(found = lendData(frame, res, frame_id, complete, handle)))
+               WaitForSingleObject(m_RecvDataCond, INFINITE);
+         }
+         else
+         {
+            if (!(found = lendData(frame, res, frame_id, complete, handle)))
+            {
+               if (WaitForSingleObject(m_RecvDataCond, DWORD(m_iRcvTimeOut)) == WAIT_TIMEOUT)
+                  timeout = true;
+
+               found = lendData(frame, res, frame_id, complete, handle);
+            }
+         }
+      #endif
+
+      if (found)
+         break;
+
+      if (m_bBroken || m_bClosing)
+         throw CUDTException(2, 1, 0);
+      else if (!m_bConnected)
+         throw CUDTException(2, 2, 0);
+   }
+
+   if (frame)
+   {
+      if (m_pRcvFrameBuffer->getReadyFrameNum() <= 0)
+      {
+         CGuard dropguard(m_DroppedFramesLock);
+
+         // read is not available any more
+         if (m_DroppedFrames.empty())
+            s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, UDT_EPOLL_IN, false);
+      }
+   }
+   else if (m_pRcvBuffer->getRcvMsgNum() <= 0)
+   {
+      // read is not available any more
+      s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, UDT_EPOLL_IN, false);
+   }
+
+   if (!found)
+      throw CUDTException(6, 3, 0);
+
+   iov = NULL;
+   iovcnt = 0;
+   if (-1 != handle)
+   {
+      CGuard loanguard(m_LoanLock);
+      CLoan& loan = m_mLoans[handle];
+      iov = &loan.m_vIOV[0];
+      iovcnt = loan.m_vIOV.size();
+   }
+
+   return res;
+}
+
+bool CUDT::lendData(bool frame, int& size, uint16_t& frame_id, bool& complete, int& handle)
+{
+   vector<CUnit*> units;
+   handle = -1;
+   complete = true;
+
+   if (!frame)
+   {
+      if (0 == (size = m_pRcvBuffer->lendMsg(units, frame_id)))
+         return false;
+   }
+   else
+   {
+      // frames abandoned by the sender are reported first
+      CGuard::enterCS(m_DroppedFramesLock);
+      if (!m_DroppedFrames.empty())
+      {
+         frame_id = m_DroppedFrames.front();
+         m_DroppedFrames.pop_front();
+         CGuard::leaveCS(m_DroppedFramesLock);
+
+         size = 0;
+         complete = false;
+         return true;
+      }
+      CGuard::leaveCS(m_DroppedFramesLock);
+
+      int pos;
+      int chunks;
+      int total;
+      bool found = false;
+      while (!found && m_pRcvFrameBuffer->getReadyFrame(frame_id, pos, chunks, total))
+      {
+         if (chunks < total)
+            m_pRcvBuffer->dropUnits((pos + chunks) % m_pRcvBuffer->getSize(), total - chunks);
+
+         found = (size = m_pRcvBuffer->lendFrame(units, pos, frame_id, chunks)) >= 0;
+         complete = (chunks == total);
+      }
+
+      if (!found)
+         return false;
+   }
+
+   CGuard loanguard(m_LoanLock);
+
+   handle = m_iNextLoan;
+   m_iNextLoan = (m_iNextLoan + 1) & 0x7FFFFFFF;
+
+   CLoan& loan = m_mLoans[handle];
+   loan.m_vUnits.swap(units);
+   loan.m_vIOV.resize(loan.m_vUnits.size());
+   for (int i = 0, n = loan.m_vUnits.size(); i < n; ++ i)
+   {
+      loan.m_vIOV[i].iov_base = loan.m_vUnits[i]->m_Packet.m_pcData;
+      loan.m_vIOV[i].iov_len = loan.m_vUnits[i]->m_Packet.getLength();
+   }
+
+   return true;
+}
+
+void CUDT::release_zc(int handle)
+{
+   CGuard loanguard(m_LoanLock);
+
+   map<int, CLoan>::iterator i = m_mLoans.find(handle);
+   if (i == m_mLoans.end())
+      throw CUDTException(5, 3, 0);
+
+   m_pRcvBuffer->releaseUnits(i->second.m_vUnits);
+   m_mLoans.erase(i);
+}
+
+void CUDT::releaseLoans()
+{
+   CGuard loanguard(m_LoanLock);
+
+   for (map<int, CLoan>::iterator i = m_mLoans.begin(); i != m_mLoans.end(); ++ i)
+      m_pRcvBuffer->releaseUnits(i->second.m_vUnits);
+   m_mLoans.clear();
+}
+
+int64_t CUDT::estimateDelivery(int len)
+{
+   if (m_bBroken || m_bClosing || !m_bConnected)
+      return -1;
+
+   // over shared memory the data is with the peer as soon as it is written
+   if (NULL != m_pShm)
+      return 0;
+
+   // the data must fit into the free part of the sender buffer at once, as sendframe requires
+   int queued = m_pSndBuffer->getCurrBufSize();
+   if ((m_iSndBufSize - queued) * m_iPayloadSize < len)
+      return -1;
+
+   double loss;
+   double rate = getSndRate(loss);
+
+   // the data waits for what is queued before it and for the retransmissions of both; if any of its packets
+   // is lost, it is repaired about one RTT later
+   int packets = (len + m_iPayloadSize - 1) / m_iPayloadSize;
+   double queuing = (queued + packets) / (rate * (1 - loss)) * 1000000.0;
+   double repair = m_iRTT * (1 - pow(1 - loss, packets));
+
+   return int64_t(m_iRTT / 2 + queuing + repair);
+}
+
+double CUDT::getSndRate(double& loss)
+{
+   // loss rate over the last few hundred packets, as for the parity of frames
+   int64_t sent = m_llSentTotal - m_llLossRateSent;
+   if (sent >= 256)
+   {
+      m_dSndLossRate = m_dSndLossRate * 0.75 + 0.25 * (m_iSndLossTotal - m_iLossRateLost) / sent;
+      m_llLossRateSent = m_llSentTotal;
+      m_iLossRateLost = m_iSndLossTotal;
+   }
+   loss = (m_dSndLossRate < 0.5) ? m_dSndLossRate : 0.5;
+
+   // sending rate in packets per second: the pacing rate, or one window per RTT if that is lower
+   double rate = 1000000.0 * m_ullCPUFrequency / (m_ullInterval > 0 ? m_ullInterval : 1);
+   double window = (m_iFlowWindowSize < m_dCongestionWindow) ? m_iFlowWindowSize : m_dCongestionWindow;
+   if (window * 1000000.0 / m_iRTT < rate)
+      rate = window * 1000000.0 / m_iRTT;
+
+   return rate;
+}
+
+void CUDT::traceFrame(int type, uint16_t frame_id, uint8_t chunk_id, uint8_t total_chunks, int64_t deadline, int32_t seqno)
+{
+   CFrameEvent ev;
+   ev.usTimeStamp = CTimer::getTime() - m_StartTime;
+   ev.usDeadline = deadline;
+   ev.seqNo = seqno;
+   ev.type = type;
+   ev.frameID = frame_id;
+   ev.chunkID = chunk_id;
+   ev.totalChunks = total_chunks;
+
+   m_pFrameTrace->record(ev);
+}
+
+int64_t CUDT::sendfile(fstream& ifs, int64_t& offset, int64_t size, int block)
+{
+   if (UDT_DGRAM == m_iSockType)
+      throw CUDTException(5, 10, 0);
+
+   if (m_bBroken || m_bClosing)
+      throw CUDTException(2, 1, 0);
+   else if (!m_bConnected)
+      throw CUDTException(2, 2, 0);
+
+   if (size <= 0)
+      return 0;
+
+   CGuard sendguard(m_SendLock);
+
+   if (m_pSndBuffer->getCurrBufSize() == 0)
+   {
+      // delay the EXP timer to avoid mis-fired timeout
+      uint64_t currtime;
+      CTimer::rdtsc(currtime);
+      m_ullLastRspTime = currtime;
+   }
+
+   int64_t tosend = size;
+   int unitsize;
+
+   // positioning...
+   try
+   {
+      ifs.seekg((streamoff)offset);
+   }
+   catch (...)
+   {
+      throw CUDTException(4, 1);
+   }
+
+   if (NULL != m_pShm)
+   {
+      // the file is copied into the shared memory through a bounce buffer
+      vector<char> buf((block < CShmLink::m_iMinRingSize) ? block : CShmLink::m_iMinRingSize);
+
+      while ((tosend > 0) && !ifs.eof())
+      {
+         if (ifs.fail())
+            throw CUDTException(4, 4);
+
+         unitsize = int((tosend >= (int64_t)buf.size()) ? buf.size() : tosend);
+         ifs.read(&buf[0], unitsize);
+         int readsize = int(ifs.gcount());
+
+         for (int sent = 0; sent < readsize; )
+            sent += shmWrite(&buf[sent], readsize - sent, -1, 0, true, -1);
+
+         tosend -= readsize;
+         offset += readsize;
+      }
+
+      return size - tosend;
+   }
+
+   // sending block by block
+   while (tosend > 0)
+   {
+      if (ifs.fail())
+         throw CUDTException(4, 4);
+
+      if (ifs.eof())
+         break;
+
+      unitsize = int((tosend >= block) ? block : tosend);
+
+      waitFileSndBuf();
+
+      int64_t sentsize = m_pSndBuffer->addBufferFromFile(ifs, unitsize);
+
+      if (sentsize > 0)
+      {
+         tosend -= sentsize;
+         offset += sentsize;
+      }
+
+      // insert this socket to snd list if it is not on the list yet
+      m_pSndQueue->m_pSndUList->update(this, false);
+   }
+
+   if (m_iSndBufSize <= m_pSndBuffer->getCurrBufSize())
+   {
+      // write is not available any more
+      s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, UDT_EPOLL_OUT, false);
+   }
+
+   return size - tosend;
+}
+
+#ifndef WIN32
+int64_t CUDT::sendfile(int fd, int64_t& offset, int64_t size, int block)
+{
+   if (UDT_DGRAM == m_iSockType)
+      throw CUDTException(5, 10, 0);
+
+   if (m_bBroken || m_bClosing)
+      throw CUDTException(2, 1, 0);
+   else if (!m_bConnected)
+      throw CUDTException(2, 2, 0);
+
+   if (size <= 0)
+      return 0;
+
+   // the blocks map the file, so they must stop at its end; an offset past it is an error, a size past it sends what
+   // is there, and the caller learns how much from the returned value, as with a stream reaching its end
+   struct stat st;
+   if (fstat(fd, &st) < 0)
+      throw CUDTException(4, 1, errno);
+   if ((offset < 0) || (offset > (int64_t)st.st_size))
+      throw CUDTException(4, 1, 0);
+
+   CGuard sendguard(m_SendLock);
+
+   if (m_pSndBuffer->getCurrBufSize() == 0)
+   {
+      // delay the EXP timer to avoid mis-fired timeout
+      uint64_t currtime;
+      CTimer::rdtsc(currtime);
+      m_ullLastRspTime = currtime;
+   }
+
+   const int64_t avail = (offset + size > (int64_t)st.st_size) ? (int64_t)st.st_size - offset : size;
+   int64_t tosend = avail;
+   int unitsize;
+
+   if (NULL != m_pShm)
+   {
+      // the file is copied into the shared memory through a bounce buffer
+      vector<char> buf((block < CShmLink::m_iMinRingSize) ? block : CShmLink::m_iMinRingSize);
+
+      while (tosend > 0)
+      {
+         unitsize = int((tosend >= (int64_t)buf.size()) ? buf.size() : tosend);
+         int readsize = int(pread(fd, &buf[0], unitsize, offset));
+         if (readsize < 0)
+            throw CUDTException(4, 2);
+         else if (0 == readsize)
+            break;
+
+         for (int sent = 0; sent < readsize; )
+            sent += shmWrite(&buf[sent], readsize - sent, -1, 0, true, -1);
+
+         tosend -= readsize;
+         offset += readsize;
+      }
+
+      return avail - tosend;
+   }
+
+   // sending block by block, each block is one mapping of the file
+   while (tosend > 0)
+   {
+      unitsize = int((tosend >= block) ? block : tosend);
+
+      waitFileSndBuf();
+
+      if (m_pSndBuffer->addBufferFromFile(fd, offset, unitsize) < 0)
+         throw CUDTException(4, 2);
+
+      tosend -= unitsize;
+      offset += unitsize;
+
+      // insert this socket to snd list if it is not on the list yet
+      m_pSndQueue->m_pSndUList->update(this, false);
+   }
+
+   if (m_iSndBufSize <= m_pSndBuffer->getCurrBufSize())
+   {
+      // write is not available any more
+      s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, UDT_EPOLL_OUT, false);
+   }
+
+   return avail - tosend;
+}
+#endif
+
+void CUDT::waitFileSndBuf()
+{
+   #ifndef WIN32
+      pthread_mutex_lock(&m_SendBlockLock);
+      while (!m_bBroken && m_bConnected && !m_bClosing && (m_iSndBufSize <= m_pSndBuffer->getCurrBufSize()) && m_bPeerHealth)
+         pthread_cond_wait(&m_SendBlockCond, &m_SendBlockLock);
+      pthread_mutex_unlock(&m_SendBlockLock);
+   #else
+      while (!m_bBroken && m_bConnected && !m_bClosing && (m_iSndBufSize <= m_pSndBuffer->getCurrBufSize()) && m_bPeerHealth)
+         WaitForSingleObject(m_SendBlockCond, INFINITE);
+   #endif
+
+   if (m_bBroken || m_bClosing)
+      throw CUDTException(2, 1, 0);
+   else if (!m_bConnected)
+      throw CUDTException(2, 2, 0);
+   else if (!m_bPeerHealth)
+   {
+      // reset peer health status, once this error returns, the app should handle the situation at the peer side
+      m_bPeerHealth = true;
+      throw CUDTException(7);
+   }
+
+   // record total time used for sending
+   if (0 == m_pSndBuffer->getCurrBufSize())
+      m_llSndDurationCounter = CTimer::getTime();
+}
+
+int64_t CUDT::recvfile(fstream& ofs, int64_t& offset, int64_t size, int block)
+{
+   if (UDT_DGRAM == m_iSockType)
+      throw CUDTException(5, 10, 0);
+
+   if (!m_bConnected)
+      throw CUDTException(2, 2, 0);
+   else if ((m_bBroken || m_bClosing) && (0 == m_pRcvBuffer->getRcvDataSize()) && ((NULL == m_pShm) || !m_pShm->canRead()))
+      throw CUDTException(2, 1, 0);
+
+   if (size <= 0)
+      return 0;
+
+   CGuard recvguard(m_RecvLock);
+
+   int64_t torecv = size;
+   int unitsize = block;
+   int recvsize;
+
+   // positioning...
+   try
+   {
+      ofs.seekp((streamoff)offset);
+   }
+   catch (...)
+   {
+      throw CUDTException(4, 3);
+   }
+
+   if (NULL != m_pShm)
+   {
+      // the data is copied out of the shared memory through a bounce buffer
+      vector<char> buf((block < CShmLink::m_iMinRingSize) ? block : CShmLink::m_iMinRingSize);
+      int32_t frame_id;
+      int64_t deadline;
+
+      while (torecv > 0)
+      {
+         unitsize = int((torecv >= (int64_t)buf.size()) ? buf.size() : torecv);
+         recvsize = shmRead(&buf[0], unitsize, frame_id, deadline, true, -1);
+
+         ofs.write(&buf[0], recvsize);
+         if (ofs.fail())
+         {
+            // send the sender a signal so it will not be blocked forever
+            int32_t err_code = CUDTException::EFILE;
+            sendCtrl(8, &err_code);
+
+            throw CUDTException(4, 4);
+         }
+
+         torecv -= recvsize;
+         offset += recvsize;
+      }
+
+      return size - torecv;
+   }
+
+   // receiving... "recvfile" is always blocking
+   while (torecv > 0)
+   {
+      if (ofs.fail())
+      {
+         // send the sender a signal so it will not be blocked forever
+         int32_t err_code = CUDTException::EFILE;
+         sendCtrl(8, &err_code);
+
+         throw CUDTException(4, 4);
+      }
+
+      waitFileRcvData();
+
+      unitsize = int((torecv >= block) ? block : torecv);
+      recvsize = m_pRcvBuffer->readBufferToFile(ofs, unitsize);
+
+      if (recvsize > 0)
+      {
+         torecv -= recvsize;
+         offset += recvsize;
+      }
+   }
+
+   if (m_pRcvBuffer->getRcvDataSize() <= 0)
+   {
+      // read is not available any more
+      s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, UDT_EPOLL_IN, false);
+   }
+
+   return size - torecv;
+}
+
+#ifndef WIN32
+int64_t CUDT::recvfile(int fd, int64_t& offset, int64_t size, int block)
+{
+   if (UDT_DGRAM == m_iSockType)
+      throw CUDTException(5, 10, 0);
+
+   if (!m_bConnected)
+      throw CUDTException(2, 2, 0);
+   else if ((m_bBroken || m_bClosing) && (0 == m_pRcvBuffer->getRcvDataSize()) && ((NULL == m_pShm) || !m_pShm->canRead()))
+      throw CUDTException(2, 1, 0);
+
+   if (size <= 0)
+      return 0;
+
+   if (offset < 0)
+      throw CUDTException(4, 3);
+
+   CGuard recvguard(m_RecvLock);
+
+   int64_t torecv = size;
+   int unitsize;
    int recvsize;
 
-   // positioning...
-   try
-   {
-      ofs.seekp((streamoff)offset);
-   }
-   catch (...)
+   if (NULL != m_pShm)
    {
-      throw CUDTException(4, 3);
+      // the data is copied out of the shared memory through a bounce buffer
+      vector<char> buf((block < CShmLink::m_iMinRingSize) ? block : CShmLink::m_iMinRingSize);
+      int32_t frame_id;
+      int64_t deadline;
+
+      while (torecv > 0)
+      {
+         unitsize = int((torecv >= (int64_t)buf.size()) ? buf.size() : torecv);
+         recvsize = shmRead(&buf[0], unitsize, frame_id, deadline, true, -1);
+
+         for (int written = 0; written < recvsize; )
+         {
+            int res = int(pwrite(fd, &buf[written], recvsize - written, offset + written));
+            if (res < 0)
+            {
+               // send the sender a signal so it will not be blocked forever
+               int32_t err_code = CUDTException::EFILE;
+               sendCtrl(8, &err_code);
+
+               throw CUDTException(4, 4);
+            }
+            written += res;
+         }
+
+         torecv -= recvsize;
+         offset += recvsize;
+      }
+
+      return size - torecv;
    }
 
-   // receiving... "recvfile" is always blocking
+   // receiving... "recvfile" is always blocking, the units are written in place at the file position
    while (torecv > 0)
    {
-      if (ofs.fail())
+      waitFileRcvData();
+
+      unitsize = int((torecv >= block) ? block : torecv);
+      recvsize = m_pRcvBuffer->readBufferToFile(fd, offset, unitsize);
+
+      if (recvsize < 0)
       {
          // send the sender a signal so it will not be blocked forever
          int32_t err_code = CUDTException::EFILE;
@@ -1570,38 +2706,161 @@ int64_t CUDT::recvfile(fstream& ofs, int64_t& offset, int64_t size, int block)
          throw CUDTException(4, 4);
       }
 
-      #ifndef WIN32
-         pthread_mutex_lock(&m_RecvDataLock);
-         while (!m_bBroken && m_bConnected && !m_bClosing && (0 == m_pRcvBuffer->getRcvDataSize()))
-            pthread_cond_wait(&m_RecvDataCond, &m_RecvDataLock);
-         pthread_mutex_unlock(&m_RecvDataLock);
-      #else
-         while (!m_bBroken && m_bConnected && !m_bClosing && (0 == m_pRcvBuffer->getRcvDataSize()))
-            WaitForSingleObject(m_RecvDataCond, INFINITE);
-      #endif
+      torecv -= recvsize;
+      offset += recvsize;
+   }
 
-      if (!m_bConnected)
-         throw CUDTException(2, 2, 0);
-      else if ((m_bBroken || m_bClosing) && (0 == m_pRcvBuffer->getRcvDataSize()))
+   if (m_pRcvBuffer->getRcvDataSize() <= 0)
+   {
+      // read is not available any more
+      s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, UDT_EPOLL_IN, false);
+   }
+
+   return size - torecv;
+}
+#endif
+
+void CUDT::waitFileRcvData()
+{
+   #ifndef WIN32
+      pthread_mutex_lock(&m_RecvDataLock);
+      while (!m_bBroken && m_bConnected && !m_bClosing && (0 == m_pRcvBuffer->getRcvDataSize()))
+         pthread_cond_wait(&m_RecvDataCond, &m_RecvDataLock);
+      pthread_mutex_unlock(&m_RecvDataLock);
+   #else
+      while (!m_bBroken && m_bConnected && !m_bClosing && (0 == m_pRcvBuffer->getRcvDataSize()))
+         WaitForSingleObject(m_RecvDataCond, INFINITE);
+   #endif
+
+   if (!m_bConnected)
+      throw CUDTException(2, 2, 0);
+   else if ((m_bBroken || m_bClosing) && (0 == m_pRcvBuffer->getRcvDataSize()))
+      throw CUDTException(2, 1, 0);
+}
+
+int CUDT::shmWrite(const char* data, int len, int32_t frame_id, int64_t deadline, bool sync, int timeout)
+{
+   bool msg = (UDT_DGRAM == m_iSockType);
+   if (msg && (len > m_pShm->getMaxMsgSize()))
+      throw CUDTException(5, 12, 0);
+
+   uint64_t exptime = (timeout < 0) ? 0 : CTimer::getTime() + timeout * 1000ULL;
+
+   while (true)
+   {
+      if (m_bBroken || m_bClosing || m_pShm->isPeerClosed())
          throw CUDTException(2, 1, 0);
 
-      unitsize = int((torecv >= block) ? block : torecv);
-      recvsize = m_pRcvBuffer->readBufferToFile(ofs, unitsize);
+      int res = msg ? m_pShm->sendMsg(data, len, frame_id, deadline) : m_pShm->send(data, len);
+      if (res > 0)
+      {
+         // the peer waits in epoll rather than on the ring: ring its doorbell
+         if (m_pShm->takeNotify(false))
+            sendCtrl(1);
 
-      if (recvsize > 0)
+         if (!m_pShm->canWrite(msg ? m_iPayloadSize : 1))
+            updateShmEvents();
+
+         return res;
+      }
+
+      if (!sync)
+         throw CUDTException(6, 1, 0);
+
+      int wait = -1;
+      if (timeout >= 0)
       {
-         torecv -= recvsize;
-         offset += recvsize;
+         uint64_t now = CTimer::getTime();
+         if (now >= exptime)
+            throw CUDTException(6, 3, 0);
+         wait = int(exptime - now);
       }
+
+      m_pShm->waitWrite(len, wait);
    }
+}
 
-   if (m_pRcvBuffer->getRcvDataSize() <= 0)
+int CUDT::shmRead(char* data, int len, int32_t& frame_id, int64_t& deadline, bool sync, int timeout)
+{
+   bool msg = (UDT_DGRAM == m_iSockType);
+   uint64_t exptime = (timeout < 0) ? 0 : CTimer::getTime() + timeout * 1000ULL;
+
+   while (true)
    {
-      // read is not available any more
-      s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, UDT_EPOLL_IN, false);
+      int res = msg ? m_pShm->recvMsg(data, len, frame_id, deadline) : m_pShm->recv(data, len);
+      if (res > 0)
+      {
+         if (m_pShm->takeNotify(true))
+            sendCtrl(1);
+
+         if (!m_pShm->canRead())
+            updateShmEvents();
+
+         return res;
+      }
+
+      // the peer closes after its last write, so the ring is checked once more
+      if (m_bBroken || m_bClosing || m_pShm->isPeerClosed())
+      {
+         if (m_pShm->canRead())
+            continue;
+
+         throw CUDTException(2, 1, 0);
+      }
+
+      if (!sync)
+         throw CUDTException(6, 2, 0);
+
+      int wait = -1;
+      if (timeout >= 0)
+      {
+         uint64_t now = CTimer::getTime();
+         if (now >= exptime)
+            throw CUDTException(6, 3, 0);
+         wait = int(exptime - now);
+      }
+
+      m_pShm->waitRead(wait);
    }
+}
 
-   return size - torecv;
+void CUDT::updateShmEvents()
+{
+   // while nobody waits in epoll, there is no need for doorbells from the peer
+   bool polled = !m_sPollID.empty();
+   int room = (UDT_DGRAM == m_iSockType) ? m_iPayloadSize : 1;
+
+   bool readable = m_pShm->canRead() || m_pShm->isPeerClosed();
+   if (!readable && polled)
+   {
+      m_pShm->requestNotify(false);
+      readable = m_pShm->canRead();
+   }
+   s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, UDT_EPOLL_IN, readable);
+
+   bool writable = m_pShm->canWrite(room);
+   if (!writable && polled)
+   {
+      m_pShm->requestNotify(true);
+      writable = m_pShm->canWrite(room);
+   }
+   s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, UDT_EPOLL_OUT, writable);
+}
+
+int CUDT::lookupCache(CInfoBlock* ib)
+{
+   // what other processes have learned is as recent as what this one has
+   if ((NULL != m_pSharedCache) && (m_pSharedCache->lookup(ib) >= 0))
+      return 0;
+
+   return m_pCache->lookup(ib);
+}
+
+void CUDT::updateCache(CInfoBlock* ib)
+{
+   m_pCache->update(ib);
+   if (NULL != m_pSharedCache)
+      m_pSharedCache->update(ib);
 }
 
 void CUDT::sample(CPerfMon* perf, bool clear)
@@ -1623,8 +2882,46 @@ void CUDT::sample(CPerfMon* perf, bool clear)
    perf->pktRecvACK = m_iRecvACK;
    perf->pktSentNAK = m_iSentNAK;
    perf->pktRecvNAK = m_iRecvNAK;
+   perf->pktRcvNoUnit = m_iTraceRcvNoUnit;
+   perf->pktRcvRecovered = m_iTraceRcvRecovered;
+   perf->pktSndShed = m_iTraceSndShed;
+   perf->pktCtrlSaved = m_iTraceCtrlSaved;
+   perf->pktCtrlSavedPerPkt = (m_llTraceRecv > 0) ? m_iTraceCtrlSaved / double(m_llTraceRecv) : 0;
    perf->usSndDuration = m_llSndDuration;
 
+   // VR Frame Awareness: frame counters and percentiles of this interval
+   perf->frameSent = m_iTraceFrameSent;
+   perf->frameRcvPartial = m_iTraceRcvPartial;
+
+   // the sending worker records pacing and the receiving worker records frames concurrently, so they are read
+   // and cleared in one critical section
+   CGuard::enterCS(m_StatsLock);
+   perf->usPacingError = (m_llTracePacingCount > 0) ? m_llTracePacingError / double(m_llTracePacingCount) / m_ullCPUFrequency : 0;
+   perf->usPacingErrorMax = m_ullMaxPacingError / double(m_ullCPUFrequency);
+   perf->frameSndAcked = m_SndFrameStats.m_iComplete;
+   perf->frameSndMiss = m_SndFrameStats.m_iMiss;
+   perf->frameRcvComplete = m_RcvFrameStats.m_iComplete;
+   perf->frameRcvMiss = m_RcvFrameStats.m_iMiss;
+   perf->usFrameSndLatency50 = double(m_SndFrameStats.m_Latency.getPercentile(0.5));
+   perf->usFrameSndLatency99 = double(m_SndFrameStats.m_Latency.getPercentile(0.99));
+   perf->usFrameSndLatency999 = double(m_SndFrameStats.m_Latency.getPercentile(0.999));
+   perf->usFrameRcvLatency50 = double(m_RcvFrameStats.m_Latency.getPercentile(0.5));
+   perf->usFrameRcvLatency99 = double(m_RcvFrameStats.m_Latency.getPercentile(0.99));
+   perf->usFrameRcvLatency999 = double(m_RcvFrameStats.m_Latency.getPercentile(0.999));
+   perf->pktFrameRetransAvg = m_SndFrameStats.m_Retrans.getMean();
+   perf->pktFrameRetrans99 = int(m_SndFrameStats.m_Retrans.getPercentile(0.99));
+   perf->frameSndAckedTotal = m_SndFrameStats.m_llCompleteTotal;
+   perf->frameSndMissTotal = m_SndFrameStats.m_llMissTotal;
+   perf->frameRcvCompleteTotal = m_RcvFrameStats.m_llCompleteTotal;
+   perf->frameRcvMissTotal = m_RcvFrameStats.m_llMissTotal;
+   if (clear)
+   {
+      m_llTracePacingError = m_llTracePacingCount = m_ullMaxPacingError = 0;
+      m_SndFrameStats.clear();
+      m_RcvFrameStats.clear();
+   }
+   CGuard::leaveCS(m_StatsLock);
+
    perf->pktSentTotal = m_llSentTotal;
    perf->pktRecvTotal = m_llRecvTotal;
    perf->pktSndLossTotal = m_iSndLossTotal;
@@ -1634,7 +2931,13 @@ void CUDT::sample(CPerfMon* perf, bool clear)
    perf->pktRecvACKTotal = m_iRecvACKTotal;
    perf->pktSentNAKTotal = m_iSentNAKTotal;
    perf->pktRecvNAKTotal = m_iRecvNAKTotal;
+   perf->pktRcvNoUnitTotal = m_iRcvNoUnitTotal;
+   perf->pktRcvRecoveredTotal = m_iRcvRecoveredTotal;
+   perf->pktSndShedTotal = m_iSndShedTotal;
+   perf->pktCtrlSavedTotal = m_iCtrlSavedTotal;
    perf->usSndDurationTotal = m_llSndDurationTotal;
+   perf->frameSentTotal = m_llFrameSentTotal;
+   perf->frameRcvPartialTotal = m_llRcvPartialTotal;
 
    double interval = double(currtime - m_LastSampleTime);
 
@@ -1672,11 +2975,28 @@ void CUDT::sample(CPerfMon* perf, bool clear)
    if (clear)
    {
       m_llTraceSent = m_llTraceRecv = m_iTraceSndLoss = m_iTraceRcvLoss = m_iTraceRetrans = m_iSentACK = m_iRecvACK = m_iSentNAK = m_iRecvNAK = 0;
+      m_iTraceRcvNoUnit = 0;
+      m_iTraceRcvRecovered = 0;
+      m_iTraceSndShed = 0;
+      m_iTraceRcvPartial = 0;
+      m_iTraceCtrlSaved = 0;
+      m_iTraceFrameSent = 0;
       m_llSndDuration = 0;
       m_LastSampleTime = currtime;
    }
 }
 
+int CUDT::getFrameTrace(CFrameEvent* events, int num, int& overflow)
+{
+   if (NULL == m_pFrameTrace)
+      throw CUDTException(5, 0, 0);
+
+   if ((NULL == events) || (num < 0))
+      throw CUDTException(5, 3, 0);
+
+   return m_pFrameTrace->drain(events, num, overflow);
+}
+
 void CUDT::CCUpdate()
 {
    m_ullInterval = (uint64_t)(m_pCC->m_dPktSndPeriod * m_ullCPUFrequency);
@@ -1700,6 +3020,9 @@ void CUDT::initSynch()
       pthread_mutex_init(&m_RecvLock, NULL);
       pthread_mutex_init(&m_AckLock, NULL);
       pthread_mutex_init(&m_ConnectionLock, NULL);
+      pthread_mutex_init(&m_DroppedFramesLock, NULL);
+      pthread_mutex_init(&m_LoanLock, NULL);
+      pthread_mutex_init(&m_StatsLock, NULL);
    #else
       m_SendBlockLock = CreateMutex(NULL, false, NULL);
       m_SendBlockCond = CreateEvent(NULL, false, false, NULL);
@@ -1709,6 +3032,9 @@ void CUDT::initSynch()
       m_RecvLock = CreateMutex(NULL, false, NULL);
       m_AckLock = CreateMutex(NULL, false, NULL);
       m_ConnectionLock = CreateMutex(NULL, false, NULL);
+      m_DroppedFramesLock = CreateMutex(NULL, false, NULL);
+      m_LoanLock = CreateMutex(NULL, false, NULL);
+      m_StatsLock = CreateMutex(NULL, false, NULL);
    #endif
 }
 
@@ -1723,6 +3049,9 @@ void CUDT::destroySynch()
       pthread_mutex_destroy(&m_RecvLock);
       pthread_mutex_destroy(&m_AckLock);
       pthread_mutex_destroy(&m_ConnectionLock);
+      pthread_mutex_destroy(&m_DroppedFramesLock);
+      pthread_mutex_destroy(&m_LoanLock);
+      pthread_mutex_destroy(&m_StatsLock);
    #else
       CloseHandle(m_SendBlockLock);
       CloseHandle(m_SendBlockCond);
@@ -1732,11 +3061,17 @@ void CUDT::destroySynch()
       CloseHandle(m_RecvLock);
       CloseHandle(m_AckLock);
       CloseHandle(m_ConnectionLock);
+      CloseHandle(m_DroppedFramesLock);
+      CloseHandle(m_LoanLock);
+      CloseHandle(m_StatsLock);
    #endif
 }
 
 void CUDT::releaseSynch()
 {
+   if (NULL != m_pShm)
+      m_pShm->interrupt();
+
    #ifndef WIN32
       // wake up user calls
       pthread_mutex_lock(&m_SendBlockLock);
@@ -1830,7 +3165,7 @@ void CUDT::sendCtrl(int pkttype, void* lparam, void* rparam, int size)
       // Send out the ACK only if has not been received by the sender before
       if (CSeqNo::seqcmp(m_iRcvLastAck, m_iRcvLastAckAck) > 0)
       {
-         int32_t data[6];
+         int32_t data[9];
 
          m_iAckSeqNo = CAckNo::incack(m_iAckSeqNo);
          data[0] = m_iRcvLastAck;
@@ -1841,11 +3176,26 @@ void CUDT::sendCtrl(int pkttype, void* lparam, void* rparam, int size)
          if (data[3] < 2)
             data[3] = 2;
 
-         if (currtime - m_ullLastAckTime > m_ullSYNInt)
+         if ((currtime - m_ullLastAckTime > m_ullSYNInt) || (NULL != rparam))
          {
             data[4] = m_pRcvTimeWindow->getPktRcvSpeed();
             data[5] = m_pRcvTimeWindow->getBandwidth();
-            ctrlpkt.pack(pkttype, &m_iAckSeqNo, data, 24);
+            data[6] = m_iRcvRecoveredTotal;
+
+            // a loss report (at most two words, as packed for a NAK) rides after the full ACK (CHandShake::m_iExtAckNak)
+            if (NULL == rparam)
+               ctrlpkt.pack(pkttype, &m_iAckSeqNo, data, 28);
+            else
+            {
+               if (1 == size)
+                  data[7] = ((int32_t*)rparam)[1];
+               else
+                  memcpy(data + 7, rparam, 8);
+               ctrlpkt.pack(pkttype, &m_iAckSeqNo, data, 28 + size * 4);
+
+               ++ m_iSentNAK;
+               ++ m_iSentNAKTotal;
+            }
 
             CTimer::rdtsc(m_ullLastAckTime);
          }
@@ -1884,8 +3234,8 @@ void CUDT::sendCtrl(int pkttype, void* lparam, void* rparam, int size)
          }
          else
          {
-            // more than 1 loss packets
-            ctrlpkt.pack(pkttype, NULL, rparam, 8);
+            // more than 1 loss packets, or a list of them
+            ctrlpkt.pack(pkttype, NULL, rparam, size * 4);
          }
 
          ctrlpkt.m_iID = m_PeerID;
@@ -1944,7 +3294,7 @@ void CUDT::sendCtrl(int pkttype, void* lparam, void* rparam, int size)
       break;
 
    case 0: //000 - Handshake
-      ctrlpkt.pack(pkttype, NULL, rparam, sizeof(CHandShake));
+      ctrlpkt.pack(pkttype, NULL, rparam, size);
       ctrlpkt.m_iID = m_PeerID;
       m_pSndQueue->sendto(m_pPeerAddr, ctrlpkt);
 
@@ -1958,7 +3308,7 @@ void CUDT::sendCtrl(int pkttype, void* lparam, void* rparam, int size)
       break;
 
    case 7: //111 - Msg drop request
-      ctrlpkt.pack(pkttype, lparam, rparam, 8);
+      ctrlpkt.pack(pkttype, lparam, rparam, size);
       ctrlpkt.m_iID = m_PeerID;
       m_pSndQueue->sendto(m_pPeerAddr, ctrlpkt);
 
@@ -1971,6 +3321,13 @@ void CUDT::sendCtrl(int pkttype, void* lparam, void* rparam, int size)
 
       break;
 
+   case 9: //1001 - Frame abandoned by the receiver
+      ctrlpkt.pack(pkttype, lparam, rparam, size);
+      ctrlpkt.m_iID = m_PeerID;
+      m_pSndQueue->sendto(m_pPeerAddr, ctrlpkt);
+
+      break;
+
    case 32767: //0x7FFF - Resevered for future use
       break;
 
@@ -2025,10 +3382,24 @@ void CUDT::processCtrl(CPacket& ctrlpkt)
       // check the validation of the ack
       if (CSeqNo::seqcmp(ack, CSeqNo::incseq(m_iSndCurrSeqNo)) > 0)
       {
-         //this should not happen: attack or bug
-         m_bBroken = true;
-         m_iBrokenCounter = 0;
-         break;
+         // VR Frame Awareness: the receiver may move past an abandoned frame before the sending thread skips its unsent chunks;
+         // everything sent is acknowledged now, the rest once the chunks are skipped
+         CGuard::enterCS(m_AckLock);
+         bool abandoned = !m_SndAbandoned.empty() && (CSeqNo::seqcmp(ack, CSeqNo::incseq(m_SndAbandoned.back().second)) <= 0);
+         if (abandoned)
+         {
+            m_iSndAbandonAck = ack;
+            ack = CSeqNo::incseq(m_iSndCurrSeqNo);
+         }
+         CGuard::leaveCS(m_AckLock);
+
+         if (!abandoned)
+         {
+            //this should not happen: attack or bug
+            m_bBroken = true;
+            m_iBrokenCounter = 0;
+            break;
+         }
       }
 
       if (CSeqNo::seqcmp(ack, m_iSndLastAck) >= 0)
@@ -2038,6 +3409,13 @@ void CUDT::processCtrl(CPacket& ctrlpkt)
          m_iSndLastAck = ack;
       }
 
+      // a loss report after the full ACK (CHandShake::m_iExtAckNak) counts even if the ACK itself is a repeated one
+      if ((ctrlpkt.getLength() > 28) && (0 != (m_iHSExtension & CHandShake::m_iExtAckNak)))
+      {
+         if (!processLossReport((int32_t *)ctrlpkt.m_pcData + 7, (ctrlpkt.getLength() - 28) / 4))
+            break;
+      }
+
       // protect packet retransmission
       CGuard::enterCS(m_AckLock);
 
@@ -2050,7 +3428,7 @@ void CUDT::processCtrl(CPacket& ctrlpkt)
       }
 
       // acknowledge the sending buffer
-      m_pSndBuffer->ackData(offset);
+      m_pSndBuffer->ackData(offset, &m_SndFrameStats, &m_StatsLock);
 
       // record total time used for sending
       m_llSndDuration += currtime - m_llSndDurationCounter;
@@ -2101,6 +3479,10 @@ void CUDT::processCtrl(CPacket& ctrlpkt)
          m_pCC->setBandwidth(m_iBandwidth);
       }
 
+      // VR Frame Awareness: losses the receiver has rebuilt from parity, which it does not report
+      if ((ctrlpkt.getLength() > 24) && (*((int32_t *)ctrlpkt.m_pcData + 6) > m_iPeerRecoveredTotal))
+         m_iPeerRecoveredTotal = *((int32_t *)ctrlpkt.m_pcData + 6);
+
       m_pCC->onACK(ack);
       CCUpdate();
 
@@ -2137,69 +3519,8 @@ void CUDT::processCtrl(CPacket& ctrlpkt)
       }
 
    case 3: //011 - Loss Report
-      {
-      int32_t* losslist = (int32_t *)(ctrlpkt.m_pcData);
-
-      m_pCC->onLoss(losslist, ctrlpkt.getLength() / 4);
-      CCUpdate();
-
-      bool secure = true;
-
-      // decode loss list message and insert loss into the sender loss list
-      for (int i = 0, n = (int)(ctrlpkt.getLength() / 4); i < n; ++ i)
-      {
-         if (0 != (losslist[i] & 0x80000000))
-         {
-            if ((CSeqNo::seqcmp(losslist[i] & 0x7FFFFFFF, losslist[i + 1]) > 0) || (CSeqNo::seqcmp(losslist[i + 1], m_iSndCurrSeqNo) > 0))
-            {
-               // seq_a must not be greater than seq_b; seq_b must not be greater than the most recent sent seq
-               secure = false;
-               break;
-            }
-
-            int num = 0;
-            if (CSeqNo::seqcmp(losslist[i] & 0x7FFFFFFF, m_iSndLastAck) >= 0)
-               num = m_pSndLossList->insert(losslist[i] & 0x7FFFFFFF, losslist[i + 1]);
-            else if (CSeqNo::seqcmp(losslist[i + 1], m_iSndLastAck) >= 0)
-               num = m_pSndLossList->insert(m_iSndLastAck, losslist[i + 1]);
-
-            m_iTraceSndLoss += num;
-            m_iSndLossTotal += num;
-
-            ++ i;
-         }
-         else if (CSeqNo::seqcmp(losslist[i], m_iSndLastAck) >= 0)
-         {
-            if (CSeqNo::seqcmp(losslist[i], m_iSndCurrSeqNo) > 0)
-            {
-               //seq_a must not be greater than the most recent sent seq
-               secure = false;
-               break;
-            }
-
-            int num = m_pSndLossList->insert(losslist[i], losslist[i]);
-
-            m_iTraceSndLoss += num;
-            m_iSndLossTotal += num;
-         }
-      }
-
-      if (!secure)
-      {
-         //this should not happen: attack or bug
-         m_bBroken = true;
-         m_iBrokenCounter = 0;
-         break;
-      }
-
-      // the lost packet (retransmission) should be sent out immediately
-      m_pSndQueue->m_pSndUList->update(this);
-
-      ++ m_iRecvNAK;
-      ++ m_iRecvNAKTotal;
-
+      processLossReport((int32_t *)(ctrlpkt.m_pcData), ctrlpkt.getLength() / 4);
       break;
-      }
 
    case 4: //100 - Delay Warning
       // One way packet delay is increasing, so decrease the sending rate
@@ -2210,7 +3531,9 @@ void CUDT::processCtrl(CPacket& ctrlpkt)
 
    case 1: //001 - Keep-alive
       // The only purpose of keep-alive packet is to tell that the peer is still alive
-      // nothing needs to be done.
+      // nothing needs to be done, except over shared memory, where it also rings the doorbell
+      if (NULL != m_pShm)
+         updateShmEvents();
 
       break;
 
@@ -2229,6 +3552,7 @@ void CUDT::processCtrl(CPacket& ctrlpkt)
          initdata.m_iFlightFlagSize = m_iFlightFlagSize;
          initdata.m_iReqType = (!m_bRendezvous) ? -1 : -2;
          initdata.m_iID = m_SocketID;
+         initdata.m_iExtension = m_iHSExtension;
 
          char* hs = new char [m_iPayloadSize];
          int hs_size = m_iPayloadSize;
@@ -2249,43 +3573,169 @@ void CUDT::processCtrl(CPacket& ctrlpkt)
       // Signal the sender and recver if they are waiting for data.
       releaseSynch();
 
+      // app can call any UDT API to learn the connection_broken error
+      s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, UDT_EPOLL_IN | UDT_EPOLL_OUT | UDT_EPOLL_ERR, true);
+
       CTimer::triggerEvent();
 
       break;
 
    case 7: //111 - Msg drop request
-      m_pRcvBuffer->dropMsg(ctrlpkt.getMsgSeq());
-      m_pRcvLossList->remove(*(int32_t*)ctrlpkt.m_pcData, *(int32_t*)(ctrlpkt.m_pcData + 4));
+      {
+      // VR Frame Awareness: a frame drop carries the frame ID; a frame that has arrived completely is still delivered,
+      // and so is a layered frame with all its required layers, without the others
+      int frame_id = (ctrlpkt.getLength() >= 12) ? uint16_t(*(int32_t*)(ctrlpkt.m_pcData + 8)) : -1;
+      bool drop = true;
+      bool partial = false;
+      int pos, chunks, readable;
+      int32_t seqno;
+      int64_t deadline;
+      if ((frame_id >= 0) && (NULL != m_pRcvFrameBuffer))
+      {
+         // the sender has shed the optional layers from a chunk on, the frame goes without them
+         if (ctrlpkt.getLength() >= 16)
+         {
+            drop = false;
+            partial = m_pRcvFrameBuffer->shedChunks(uint16_t(frame_id), *(int32_t*)(ctrlpkt.m_pcData + 12), pos, seqno, chunks, deadline);
+         }
+         else if (m_pRcvFrameBuffer->settleFrame(uint16_t(frame_id), pos, seqno, chunks, readable, deadline))
+            drop = false, partial = true;
+         else
+            drop = m_pRcvFrameBuffer->dropFrame(uint16_t(frame_id));
+      }
+
+      dropRcvMsg(ctrlpkt.getMsgSeq(), *(int32_t*)ctrlpkt.m_pcData, *(int32_t*)(ctrlpkt.m_pcData + 4), frame_id, drop);
+
+      if (partial)
+         completeFrame(uint16_t(frame_id), uint8_t(chunks), pos, seqno, deadline, true);
+
+      break;
+      }
 
-      // move forward with current recv seq no.
-      if ((CSeqNo::seqcmp(*(int32_t*)ctrlpkt.m_pcData, CSeqNo::incseq(m_iRcvCurrSeqNo)) <= 0)
-         && (CSeqNo::seqcmp(*(int32_t*)(ctrlpkt.m_pcData + 4), m_iRcvCurrSeqNo) > 0))
+   case 9: //1001 - Frame abandoned by the receiver
       {
-         m_iRcvCurrSeqNo = *(int32_t*)(ctrlpkt.m_pcData + 4);
+      if (ctrlpkt.getLength() < 8)
+         break;
+
+      // VR Frame Awareness: the receiver no longer waits for the frame, stop resending it
+      int32_t first = *(int32_t*)ctrlpkt.m_pcData;
+      int32_t last = *(int32_t*)(ctrlpkt.m_pcData + 4);
+
+      CGuard ackguard(m_AckLock);
+
+      // the frame must overlap the packets sent and not acknowledged yet, and end within the data the sender holds;
+      // anything else is stale, or a peer trying to have the ACK check skipped
+      if ((first < 0) || (last < 0) || (CSeqNo::seqcmp(first, last) > 0) ||
+          (CSeqNo::seqcmp(last, m_iSndLastAck) < 0) || (CSeqNo::seqcmp(first, m_iSndCurrSeqNo) > 0) ||
+          (CSeqNo::seqoff(m_iSndLastDataAck, last) >= m_pSndBuffer->getCurrBufSize()))
+         break;
+
+      m_pSndLossList->remove(first, last);
+
+      // its unsent packets are skipped by the sending thread; frames abandoned before are kept in sequence order,
+      // and ranges that overlap (the same frame abandoned again) are merged
+      list<pair<int32_t, int32_t> >::iterator i = m_SndAbandoned.begin();
+      while ((i != m_SndAbandoned.end()) && (CSeqNo::seqcmp(i->second, first) < 0))
+         ++ i;
+      while ((i != m_SndAbandoned.end()) && (CSeqNo::seqcmp(i->first, last) <= 0))
+      {
+         if (CSeqNo::seqcmp(i->first, first) < 0)
+            first = i->first;
+         if (CSeqNo::seqcmp(i->second, last) > 0)
+            last = i->second;
+         i = m_SndAbandoned.erase(i);
       }
 
+      // beyond what the receiver can track, the frame is simply sent on; it is no longer resent either way
+      if (int(m_SndAbandoned.size()) < m_iMaxAbandoned)
+         m_SndAbandoned.insert(i, make_pair(first, last));
+
       break;
+      }
 
    case 8: // 1000 - An error has happened to the peer side
       //int err_type = packet.getAddInfo();
 
-      // currently only this error is signalled from the peer side
-      // if recvfile() failes (e.g., due to disk fail), blcoked sendfile/send should return immediately
-      // giving the app a chance to fix the issue
+      // currently only this error is signalled from the peer side
+      // if recvfile() failes (e.g., due to disk fail), blcoked sendfile/send should return immediately
+      // giving the app a chance to fix the issue
+
+      m_bPeerHealth = false;
+
+      break;
+
+   case 32767: //0x7FFF - reserved and user defined messages
+      m_pCC->processCustomMsg(&ctrlpkt);
+      CCUpdate();
+
+      break;
+
+   default:
+      break;
+   }
+}
+
+bool CUDT::processLossReport(const int32_t* losslist, int len)
+{
+   m_pCC->onLoss(losslist, len);
+   CCUpdate();
+
+   bool secure = true;
+
+   // decode loss list message and insert loss into the sender loss list
+   for (int i = 0; i < len; ++ i)
+   {
+      if (0 != (losslist[i] & 0x80000000))
+      {
+         if ((CSeqNo::seqcmp(losslist[i] & 0x7FFFFFFF, losslist[i + 1]) > 0) || (CSeqNo::seqcmp(losslist[i + 1], m_iSndCurrSeqNo) > 0))
+         {
+            // seq_a must not be greater than seq_b; seq_b must not be greater than the most recent sent seq
+            secure = false;
+            break;
+         }
+
+         int num = 0;
+         if (CSeqNo::seqcmp(losslist[i] & 0x7FFFFFFF, m_iSndLastAck) >= 0)
+            num = m_pSndLossList->insert(losslist[i] & 0x7FFFFFFF, losslist[i + 1]);
+         else if (CSeqNo::seqcmp(losslist[i + 1], m_iSndLastAck) >= 0)
+            num = m_pSndLossList->insert(m_iSndLastAck, losslist[i + 1]);
+
+         m_iTraceSndLoss += num;
+         m_iSndLossTotal += num;
+
+         ++ i;
+      }
+      else if (CSeqNo::seqcmp(losslist[i], m_iSndLastAck) >= 0)
+      {
+         if (CSeqNo::seqcmp(losslist[i], m_iSndCurrSeqNo) > 0)
+         {
+            //seq_a must not be greater than the most recent sent seq
+            secure = false;
+            break;
+         }
+
+         int num = m_pSndLossList->insert(losslist[i], losslist[i]);
 
-      m_bPeerHealth = false;
+         m_iTraceSndLoss += num;
+         m_iSndLossTotal += num;
+      }
+   }
 
-      break;
+   if (!secure)
+   {
+      //this should not happen: attack or bug
+      m_bBroken = true;
+      m_iBrokenCounter = 0;
+      return false;
+   }
 
-   case 32767: //0x7FFF - reserved and user defined messages
-      m_pCC->processCustomMsg(&ctrlpkt);
-      CCUpdate();
+   // the lost packet (retransmission) should be sent out immediately
+   m_pSndQueue->m_pSndUList->update(this);
 
-      break;
+   ++ m_iRecvNAK;
+   ++ m_iRecvNAKTotal;
 
-   default:
-      break;
-   }
+   return true;
 }
 
 int CUDT::packData(CPacket& packet, uint64_t& ts)
@@ -2293,6 +3743,13 @@ int CUDT::packData(CPacket& packet, uint64_t& ts)
    int payload = 0;
    bool probe = false;
 
+   // VR Frame Awareness: stamped after the send timestamp, which the deadline is encoded relative to
+   int64_t frame_deadline = 0;
+   uint16_t frame_id = 0;
+   uint8_t chunk_id = 0, total_chunks = 0;
+   uint8_t layer = 0, required = 0;
+   bool layerend = false;
+
    uint64_t entertime;
    CTimer::rdtsc(entertime);
 
@@ -2300,7 +3757,24 @@ int CUDT::packData(CPacket& packet, uint64_t& ts)
       m_ullTimeDiff += entertime - m_ullTargetTime;
 
    // Loss retransmission always has higher priority.
-   if ((packet.m_iSeqNo = m_pSndLossList->getLostSeq()) >= 0)
+   packet.m_iSeqNo = m_pSndLossList->getLostSeq();
+
+   // VR Frame Awareness: a lost packet of a frame that has missed its deadline is not worth resending
+   while ((packet.m_iSeqNo >= 0) && m_bFrameDrop && dropExpiredFrame(packet.m_iSeqNo))
+      packet.m_iSeqNo = m_pSndLossList->getLostSeq();
+
+   // VR Frame Awareness: nor is a lost chunk of an optional layer that would make its frame late
+   while ((packet.m_iSeqNo >= 0) && (HDR_LAYERED == m_iHdrFormat) && shedLayers(packet.m_iSeqNo))
+      packet.m_iSeqNo = m_pSndLossList->getLostSeq();
+
+   // VR Frame Awareness: under the deadline policy, or with layered frames, a retransmission may have to wait behind new data
+   if ((packet.m_iSeqNo >= 0) && ((UDT_SCHED_DEADLINE == m_iSndSched) || (HDR_LAYERED == m_iHdrFormat)) && deferRetransmission(packet.m_iSeqNo))
+   {
+      m_pSndLossList->insert(packet.m_iSeqNo, packet.m_iSeqNo);
+      packet.m_iSeqNo = -1;
+   }
+
+   if (packet.m_iSeqNo >= 0)
    {
       // protect m_iSndLastDataAck from updating by ACK processing
       CGuard ackguard(m_AckLock);
@@ -2310,13 +3784,9 @@ int CUDT::packData(CPacket& packet, uint64_t& ts)
          return 0;
 
       int msglen;
-      // VR Frame Awareness: Declare metadata variables for retransmissions
-      uint16_t frame_id;
-      uint8_t chunk_id, total_chunks;
-      int64_t frame_deadline;
 
       payload = m_pSndBuffer->readData(&(packet.m_pcData), offset, packet.m_iMsgNo, msglen,
-                                       frame_id, chunk_id, total_chunks, frame_deadline);
+                                       frame_id, chunk_id, total_chunks, frame_deadline, layer, required, layerend);
 
       if (-1 == payload)
       {
@@ -2337,12 +3807,6 @@ int CUDT::packData(CPacket& packet, uint64_t& ts)
       else if (0 == payload)
          return 0;
 
-      // VR Frame Awareness: Set metadata from buffer for retransmissions
-      packet.setFrameID(frame_id);
-      packet.setChunkID(chunk_id);
-      packet.setTotalChunks(total_chunks);
-      packet.setFrameDeadline(frame_deadline);
-
       ++ m_iTraceRetrans;
       ++ m_iRetransTotal;
    }
@@ -2350,29 +3814,26 @@ int CUDT::packData(CPacket& packet, uint64_t& ts)
    {
       // If no loss, pack a new packet.
 
+      // VR Frame Awareness: skip the unsent packets of a frame that the receiver has abandoned; this sends nothing
+      skipAbandonedFrame();
+
       // check congestion/flow window limit
       int cwnd = (m_iFlowWindowSize < (int)m_dCongestionWindow) ? m_iFlowWindowSize : (int)m_dCongestionWindow;
       if (cwnd >= CSeqNo::seqlen(m_iSndLastAck, CSeqNo::incseq(m_iSndCurrSeqNo)))
       {
-         // VR Frame Awareness: Declare metadata variables for new packets
-         uint16_t frame_id;
-         uint8_t chunk_id, total_chunks;
-         int64_t frame_deadline;
+         // VR Frame Awareness: skip the unsent packets of frames that have already missed their deadline,
+         // and the optional layers of a frame that would miss it
+         while ((m_bFrameDrop && dropExpiredFrame(CSeqNo::incseq(m_iSndCurrSeqNo))) ||
+                ((HDR_LAYERED == m_iHdrFormat) && shedLayers(CSeqNo::incseq(m_iSndCurrSeqNo)))) {}
 
          if (0 != (payload = m_pSndBuffer->readData(&(packet.m_pcData), packet.m_iMsgNo,
-                                                     frame_id, chunk_id, total_chunks, frame_deadline)))
+                                                     frame_id, chunk_id, total_chunks, frame_deadline, layer, required, layerend)))
          {
             m_iSndCurrSeqNo = CSeqNo::incseq(m_iSndCurrSeqNo);
             m_pCC->setSndCurrSeqNo(m_iSndCurrSeqNo);
 
             packet.m_iSeqNo = m_iSndCurrSeqNo;
 
-            // VR Frame Awareness: Set metadata from buffer
-            packet.setFrameID(frame_id);
-            packet.setChunkID(chunk_id);
-            packet.setTotalChunks(total_chunks);
-            packet.setFrameDeadline(frame_deadline);
-
             // every 16 (0xF) packets, a packet pair is sent
             if (0 == (packet.m_iSeqNo & 0xF))
                probe = true;
@@ -2395,10 +3856,21 @@ int CUDT::packData(CPacket& packet, uint64_t& ts)
    }
 
    packet.m_iTimeStamp = int(CTimer::getTime() - m_StartTime);
+   if (HDR_LAYERED == m_iHdrFormat)
+      packet.setHeaderFormat<HDR_LAYERED>(frame_id, chunk_id, total_chunks, frame_deadline, layer, required, layerend);
+   else if (HDR_FRAME == m_iHdrFormat)
+      packet.setHeaderFormat<HDR_FRAME>(frame_id, chunk_id, total_chunks, frame_deadline);
+   else
+      packet.setHeaderFormat<HDR_CLASSIC>(frame_id, chunk_id, total_chunks, frame_deadline);
    packet.m_iID = m_PeerID;
    packet.setLength(payload);
 
+   // a controller may change the sending period per packet, e.g. to finish a frame before its deadline;
+   // the new period paces the next packet already, rather than from the next ACK on
+   double period = m_pCC->m_dPktSndPeriod;
    m_pCC->onPktSent(&packet);
+   if (period != m_pCC->m_dPktSndPeriod)
+      CCUpdate();
    //m_pSndTimeWindow->onPktSent(packet.m_iTimeStamp);
 
    ++ m_llTraceSent;
@@ -2412,17 +3884,20 @@ int CUDT::packData(CPacket& packet, uint64_t& ts)
    }
    else
    {
+      // a packet sent ahead of its schedule, within the pacing slack, does not pull the following ones forward
+      uint64_t sendtime = (entertime < m_ullTargetTime) ? m_ullTargetTime : entertime;
+
       #ifndef NO_BUSY_WAITING
-         ts = entertime + m_ullInterval;
+         ts = sendtime + m_ullInterval;
       #else
          if (m_ullTimeDiff >= m_ullInterval)
          {
-            ts = entertime;
+            ts = sendtime;
             m_ullTimeDiff -= m_ullInterval;
          }
          else
          {
-            ts = entertime + m_ullInterval - m_ullTimeDiff;
+            ts = sendtime + m_ullInterval - m_ullTimeDiff;
             m_ullTimeDiff = 0;
          }
       #endif
@@ -2433,20 +3908,313 @@ int CUDT::packData(CPacket& packet, uint64_t& ts)
    return payload;
 }
 
+bool CUDT::dropExpiredFrame(int32_t seqno)
+{
+   // protect m_iSndLastDataAck from updating by ACK processing
+   CGuard ackguard(m_AckLock);
+
+   int offset = CSeqNo::seqoff(m_iSndLastDataAck, seqno);
+   if (offset < 0)
+      return false;
+
+   int first;
+   int32_t msgno;
+   uint16_t frame_id;
+   int len = m_pSndBuffer->dropExpiredFrame(offset, int64_t(CTimer::getTime() - m_StartTime), first, msgno, frame_id);
+   if (len <= 0)
+      return false;
+
+   // seq. no. range of the frame, followed by its frame ID so that the receiver can report it
+   int32_t dropinfo[3];
+   dropinfo[0] = CSeqNo::incseq(m_iSndLastDataAck, first);
+   dropinfo[1] = CSeqNo::incseq(dropinfo[0], len - 1);
+   dropinfo[2] = frame_id;
+
+   // one msg drop request covers the whole frame
+   sendCtrl(7, &msgno, dropinfo, 12);
+   m_pSndLossList->remove(dropinfo[0], dropinfo[1]);
+
+   // skip all dropped packets that have not been sent yet
+   if (CSeqNo::seqcmp(m_iSndCurrSeqNo, dropinfo[1]) < 0)
+   {
+      m_iSndCurrSeqNo = dropinfo[1];
+      m_pCC->setSndCurrSeqNo(m_iSndCurrSeqNo);
+   }
+
+   return true;
+}
+
+bool CUDT::shedLayers(int32_t seqno)
+{
+   // protect m_iSndLastDataAck from updating by ACK processing
+   CGuard ackguard(m_AckLock);
+
+   int offset = CSeqNo::seqoff(m_iSndLastDataAck, seqno);
+   int chunk, total, required, layer;
+   int64_t deadline;
+   if ((offset < 0) || !m_pSndBuffer->getLayerInfo(offset, chunk, total, required, layer, deadline))
+      return false;
+   if ((deadline <= 0) || (chunk < required) || (chunk >= total))
+      return false;
+
+   // what is left of the frame goes after the retransmissions queued before it, at the rate congestion control allows;
+   // a retransmitted chunk only adds itself to the chunks of the frame that have not been sent yet
+   int left = total - chunk;
+   if (CSeqNo::seqcmp(seqno, m_iSndCurrSeqNo) <= 0)
+   {
+      int sent = chunk + CSeqNo::seqoff(seqno, m_iSndCurrSeqNo);
+      left = 1 + ((sent < total - 1) ? total - 1 - sent : 0);
+   }
+   left += m_pSndLossList->getLossLength();
+
+   double loss;
+   double rate = getSndRate(loss);
+   int64_t arrival = int64_t(CTimer::getTime() - m_StartTime) + m_iRTT / 2 + int64_t(left / (rate * (1 - loss)) * 1000000.0);
+   if (arrival <= deadline)
+      return false;
+
+   int32_t msgno;
+   uint16_t frame_id;
+   int len = m_pSndBuffer->shedLayers(offset, msgno, frame_id);
+   if (len <= 0)
+      return false;
+
+   // seq. no. range of the chunks shed, the frame ID, and the first chunk shed; the receiver keeps the frame
+   int32_t dropinfo[4];
+   dropinfo[0] = seqno;
+   dropinfo[1] = CSeqNo::incseq(seqno, len - 1);
+   dropinfo[2] = frame_id;
+   dropinfo[3] = chunk;
+
+   sendCtrl(7, &msgno, dropinfo, 16);
+   m_pSndLossList->remove(dropinfo[0], dropinfo[1]);
+
+   // skip the chunks shed that have not been sent yet
+   if (CSeqNo::seqcmp(m_iSndCurrSeqNo, dropinfo[1]) < 0)
+   {
+      m_iSndCurrSeqNo = dropinfo[1];
+      m_pCC->setSndCurrSeqNo(m_iSndCurrSeqNo);
+   }
+
+   m_iSndShedTotal += len;
+   m_iTraceSndShed += len;
+
+   return true;
+}
+
+bool CUDT::skipAbandonedFrame()
+{
+   // protect m_iSndLastDataAck and the abandoned frames from updating by control processing
+   CGuard ackguard(m_AckLock);
+
+   bool skipped = false;
+   while (!m_SndAbandoned.empty())
+   {
+      int32_t next = CSeqNo::incseq(m_iSndCurrSeqNo);
+      int32_t abandoned = m_SndAbandoned.front().first;
+      int32_t last = m_SndAbandoned.front().second;
+      if (CSeqNo::seqcmp(next, abandoned) < 0)
+         break;
+      m_SndAbandoned.pop_front();
+
+      // a frame that has been sent completely has nothing left to skip
+      int offset = CSeqNo::seqoff(m_iSndLastDataAck, next);
+      if ((CSeqNo::seqcmp(next, last) > 0) || (offset < 0))
+         continue;
+
+      // a frame the receiver has taken without its optional layers only loses those
+      int first = offset;
+      int32_t msgno;
+      uint16_t frame_id;
+      int chunk, total, required, layer;
+      int64_t deadline;
+      int len = 0;
+      if (m_pSndBuffer->getLayerInfo(CSeqNo::seqoff(m_iSndLastDataAck, abandoned), chunk, total, required, layer, deadline) &&
+          (chunk >= required) && (chunk < total))
+         len = m_pSndBuffer->shedLayers(offset, msgno, frame_id);
+      if ((len <= 0) && ((len = m_pSndBuffer->dropFrame(offset, first, msgno, frame_id)) <= 0))
+         continue;
+
+      // the receiver has moved past the frame already, no drop request is needed
+      m_iSndCurrSeqNo = CSeqNo::incseq(m_iSndLastDataAck, first + len - 1);
+      m_pCC->setSndCurrSeqNo(m_iSndCurrSeqNo);
+      skipped = true;
+
+      // parity chunks that the receiver did not know of when it gave up on the frame are dropped explicitly, so that they do not look lost
+      if (CSeqNo::seqcmp(m_iSndCurrSeqNo, last) > 0)
+      {
+         int32_t dropinfo[3];
+         dropinfo[0] = CSeqNo::incseq(last);
+         dropinfo[1] = m_iSndCurrSeqNo;
+         dropinfo[2] = frame_id;
+         sendCtrl(7, &msgno, dropinfo, 12);
+      }
+   }
+
+   // an ACK that was ahead of the sender covers the skipped packets now, which frees the flow window for the next frame;
+   // it waits while it is still ahead of the sender and frames remain to be skipped
+   int32_t ack = m_iSndAbandonAck;
+   if ((-1 != ack) && (CSeqNo::seqcmp(ack, CSeqNo::incseq(m_iSndCurrSeqNo)) <= 0))
+   {
+      if (CSeqNo::seqcmp(ack, m_iSndLastAck) > 0)
+         m_iSndLastAck = ack;
+      m_iSndAbandonAck = -1;
+   }
+   else if (m_SndAbandoned.empty())
+      m_iSndAbandonAck = -1;
+
+   return skipped;
+}
+
+bool CUDT::deferRetransmission(int32_t seqno)
+{
+   // new data must be available and allowed by the congestion/flow window
+   int cwnd = (m_iFlowWindowSize < (int)m_dCongestionWindow) ? m_iFlowWindowSize : (int)m_dCongestionWindow;
+   if (cwnd < CSeqNo::seqlen(m_iSndLastAck, CSeqNo::incseq(m_iSndCurrSeqNo)))
+      return false;
+
+   // protect m_iSndLastDataAck from updating by ACK processing
+   CGuard ackguard(m_AckLock);
+
+   int64_t lost = 0;
+   int64_t fresh = 0;
+   int offset = CSeqNo::seqoff(m_iSndLastDataAck, seqno);
+   int next = CSeqNo::seqoff(m_iSndLastDataAck, CSeqNo::incseq(m_iSndCurrSeqNo));
+   if (offset < 0)
+      return false;
+
+   // a lost chunk of an optional layer waits behind new chunks of lower layers
+   if (HDR_LAYERED == m_iHdrFormat)
+   {
+      int chunk, total, required, layer;
+      int nchunk, ntotal, nrequired, nlayer;
+      if (m_pSndBuffer->getLayerInfo(offset, chunk, total, required, layer, lost) && (chunk >= required) && (chunk < total) &&
+          m_pSndBuffer->getLayerInfo(next, nchunk, ntotal, nrequired, nlayer, fresh) && (nchunk < ntotal) && (nlayer < layer))
+         return true;
+
+      if (UDT_SCHED_DEADLINE != m_iSndSched)
+         return false;
+   }
+
+   if (!m_pSndBuffer->getFrameDeadline(offset, lost))
+      return false;
+   if (!m_pSndBuffer->getFrameDeadline(next, fresh))
+      return false;
+
+   // packets without a deadline have the lowest priority
+   if (lost <= 0)
+      return fresh > 0;
+
+   // the retransmission needs about half an RTT to reach the receiver
+   if (int64_t(CTimer::getTime() - m_StartTime) + m_iRTT / 2 > lost)
+      return true;
+
+   return (fresh > 0) && (fresh < lost);
+}
+
+void CUDT::dropRcvMsg(int32_t msgno, int32_t seqno1, int32_t seqno2, int frame_id, bool drop)
+{
+   if (drop)
+      m_pRcvBuffer->dropMsg(msgno);
+   if (drop && (NULL != m_pFrameTrace) && (frame_id >= 0))
+      traceFrame(UDT_FRAME_DROPPED, uint16_t(frame_id), 0, 0, 0, -1);
+   m_pRcvLossList->remove(seqno1, seqno2);
+
+   // move forward with current recv seq no.
+   if ((CSeqNo::seqcmp(seqno1, CSeqNo::incseq(m_iRcvCurrSeqNo)) <= 0) && (CSeqNo::seqcmp(seqno2, m_iRcvCurrSeqNo) > 0))
+      m_iRcvCurrSeqNo = seqno2;
+
+   // let recvframe report the abandoned frame
+   if (drop && (frame_id >= 0) && (NULL != m_pRcvFrameBuffer))
+   {
+      CGuard::enterCS(m_StatsLock);
+      m_RcvFrameStats.miss();
+      CGuard::leaveCS(m_StatsLock);
+
+      CGuard::enterCS(m_DroppedFramesLock);
+      m_DroppedFrames.push_back(uint16_t(frame_id));
+      CGuard::leaveCS(m_DroppedFramesLock);
+
+      #ifndef WIN32
+         pthread_mutex_lock(&m_RecvDataLock);
+         if (m_bSynRecving)
+            pthread_cond_signal(&m_RecvDataCond);
+         pthread_mutex_unlock(&m_RecvDataLock);
+      #else
+         if (m_bSynRecving)
+            SetEvent(m_RecvDataCond);
+      #endif
+
+      s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, UDT_EPOLL_IN, true);
+   }
+}
+
+void CUDT::abandonExpiredFrames(int32_t seqno1, int32_t seqno2)
+{
+   // the sender's clock reads at least "now" at this moment, and it sends nothing of a frame after the deadline
+   int64_t now = m_pRcvFrameBuffer->getSenderTime(CTimer::getTime() - m_StartTime);
+
+   // no frame has been seen yet
+   if (now < 0)
+      return;
+
+   // a loss report for the new losses reaches the sender about half an RTT later, too late if the deadline has passed by then
+   int64_t reported = (seqno1 >= 0) ? now + m_iRTT / 2 : now;
+
+   int slot = 0;
+   uint16_t frame_id;
+   int32_t seqno, msgno;
+   int chunks;
+   int64_t deadline;
+   while (m_pRcvFrameBuffer->getExpiredFrame(reported, slot, frame_id, seqno, chunks, msgno, deadline))
+   {
+      // parity chunks of the frame, where known, are abandoned with it
+      int32_t range[3];
+      range[0] = seqno;
+      range[1] = CSeqNo::incseq(seqno, chunks + m_pRcvFrameBuffer->getGroups(frame_id) - 1);
+      range[2] = frame_id;
+
+      // other frames may still have chunks or retransmissions on their way until the deadline has passed
+      bool fresh = (seqno1 >= 0) && (CSeqNo::seqcmp(range[0], seqno2) <= 0) && (CSeqNo::seqcmp(range[1], seqno1) >= 0);
+      if (!fresh && (CTimeStamp::tscmp(deadline, now) >= 0))
+         continue;
+
+      // a layered frame with all its required layers goes without the rest
+      int pos, readable;
+      if (m_pRcvFrameBuffer->settleFrame(frame_id, pos, seqno, chunks, readable, deadline))
+      {
+         range[0] = CSeqNo::incseq(seqno, readable);
+         dropRcvMsg(msgno, range[0], range[1], frame_id, false);
+         sendCtrl(9, &msgno, range, 12);
+         completeFrame(frame_id, uint8_t(chunks), pos, seqno, deadline, true);
+         continue;
+      }
+
+      if (!m_pRcvFrameBuffer->dropFrame(frame_id))
+         continue;
+
+      dropRcvMsg(msgno, range[0], range[1], frame_id, true);
+
+      // the sender stops resending the frame and skips what it has not sent yet
+      sendCtrl(9, &msgno, range, 12);
+   }
+}
+
 int CUDT::processData(CUnit* unit)
 {
    CPacket& packet = unit->m_Packet;
 
-   // VR Frame Awareness: Read and print frame metadata
+   // the channel cannot tell which header a data packet has, the connection can
+   packet.trimHeader(CPacket::getFormatSize(m_iHdrFormat));
+
+   // VR Frame Awareness: Read frame metadata
    uint16_t frame_id = packet.getFrameID();
    uint8_t chunk_id = packet.getChunkID();
    uint8_t total_chunks = packet.getTotalChunks();
    int64_t deadline = packet.getFrameDeadline();
 
-   std::cout << "RCV: Seq=" << packet.m_iSeqNo
-             << " Frame=" << frame_id
-             << " Chunk=" << (int)chunk_id << "/" << (int)total_chunks
-             << " Deadline=" << deadline << "us" << std::endl;
+   if (NULL != m_pFrameTrace)
+      traceFrame(UDT_FRAME_CHUNK, frame_id, chunk_id, total_chunks, deadline, packet.m_iSeqNo);
 
    // Just heard from the peer, reset the expiration count.
    m_iEXPCount = 1;
@@ -2475,6 +4243,44 @@ int CUDT::processData(CUnit* unit)
    if (m_pRcvBuffer->addData(unit, offset) < 0)
       return -1;
 
+   // VR Frame Awareness: frame deadlines and sending times are mapped to the local clock through the timestamps
+   if ((NULL != m_pRcvFrameBuffer) && (total_chunks > 0))
+      m_pRcvFrameBuffer->updateClock(CTimer::getTime() - m_StartTime, packet.m_iTimeStamp);
+
+   // VR Frame Awareness: a frame can be read as soon as its last chunk arrives, even ahead of earlier frames
+   int groups = 0;
+   if ((NULL != m_pRcvFrameBuffer) && (total_chunks > 0))
+   {
+      // the losses of a frame waiting for its parity are reported once the next frame starts
+      if ((m_iFECPendingFrame >= 0) && (m_iFECPendingFrame != frame_id))
+         reportFrameLoss();
+
+      int pos = (m_pRcvBuffer->getPos(offset) - chunk_id + m_pRcvBuffer->getSize()) % m_pRcvBuffer->getSize();
+      int32_t seqno = CSeqNo::decseq(packet.m_iSeqNo, chunk_id);
+
+      if (chunk_id >= total_chunks)
+      {
+         // a parity chunk is of no use to a frame that is complete or dropped
+         int group, lenxor;
+         m_bPeerFEC = true;
+         if (CFrameFEC::readHeader(packet.m_pcData, packet.getLength(), group, groups, lenxor) && (total_chunks + group == chunk_id))
+            m_pRcvFrameBuffer->addChunk(frame_id, chunk_id, total_chunks, pos, seqno, packet.getMsgSeq(), deadline, groups, uint32_t(packet.m_iTimeStamp));
+         else
+            groups = 0;
+
+         if ((0 == groups) || !m_pRcvFrameBuffer->isPending(frame_id))
+            m_pRcvBuffer->dropUnits(m_pRcvBuffer->getPos(offset), 1);
+      }
+      else if (m_pRcvFrameBuffer->addChunk(frame_id, chunk_id, total_chunks, pos, seqno, packet.getMsgSeq(), deadline, 0, uint32_t(packet.m_iTimeStamp),
+                                           packet.getRequiredChunks(), packet.isLayerEnd()))
+         completeFrame(frame_id, total_chunks, pos, seqno, deadline, m_pRcvFrameBuffer->isPartial(frame_id));
+      else if (!m_pRcvFrameBuffer->isPending(frame_id))
+      {
+         // a chunk of a frame delivered without it, or dropped, is not read with the frame
+         m_pRcvBuffer->dropUnits(m_pRcvBuffer->getPos(offset), 1);
+      }
+   }
+
    // Loss detection.
    if (CSeqNo::seqcmp(packet.m_iSeqNo, CSeqNo::incseq(m_iRcvCurrSeqNo)) > 0)
    {
@@ -2485,20 +4291,63 @@ int CUDT::processData(CUnit* unit)
       int32_t lossdata[2];
       lossdata[0] = CSeqNo::incseq(m_iRcvCurrSeqNo) | 0x80000000;
       lossdata[1] = CSeqNo::decseq(packet.m_iSeqNo);
-
-      // Generate loss report immediately.
-      sendCtrl(3, NULL, lossdata, (CSeqNo::incseq(m_iRcvCurrSeqNo) == CSeqNo::decseq(packet.m_iSeqNo)) ? 1 : 2);
+      int losslen = (CSeqNo::incseq(m_iRcvCurrSeqNo) == CSeqNo::decseq(packet.m_iSeqNo)) ? 1 : 2;
 
       int loss = CSeqNo::seqlen(m_iRcvCurrSeqNo, packet.m_iSeqNo) - 2;
       m_iTraceRcvLoss += loss;
       m_iRcvLossTotal += loss;
+
+      // VR Frame Awareness: packets of frames that cannot make their deadlines are not asked for
+      if (m_bFrameDrop && (NULL != m_pRcvFrameBuffer))
+         abandonExpiredFrames(lossdata[0] & 0x7FFFFFFF, lossdata[1]);
+
+      // VR Frame Awareness: losses within a frame whose parity is on its way are reported when the parity cannot rebuild them
+      if (m_bPeerFEC && (total_chunks > 0) && (NULL != m_pRcvFrameBuffer) && m_pRcvFrameBuffer->isPending(frame_id) &&
+          (CSeqNo::seqcmp(lossdata[0] & 0x7FFFFFFF, CSeqNo::decseq(packet.m_iSeqNo, chunk_id)) >= 0))
+      {
+         m_iFECPendingFrame = frame_id;
+         m_ullFECPendingTime = currtime;
+      }
+      // Generate loss report immediately.
+      else if (m_pRcvLossList->find(lossdata[0] & 0x7FFFFFFF, lossdata[1]))
+      {
+         // with adaptive acknowledgement the report rides on a full ACK, which then stands for the next timer ACK too,
+         // as long as the ACK moves (a repeated ACK may not go out)
+         if (m_bAdaptiveACK && (0 != (m_iHSExtension & CHandShake::m_iExtAckNak)) && (CSeqNo::seqcmp(m_pRcvLossList->getFirstLostSeq(), m_iRcvLastAck) > 0))
+         {
+            sendACK(lossdata, losslen);
+            countCtrlSaved(1);
+         }
+         else
+            sendCtrl(3, NULL, lossdata, losslen);
+      }
+   }
+
+   if (m_bAdaptiveACK)
+   {
+      // the fixed schedule sends a light ACK per m_iSelfClockInterval packets, and an ACK right after the end of a message
+      if (0 == ++ m_iFixedPktCount % m_iSelfClockInterval)
+         countCtrlSaved(1);
+      if (packet.getLength() != m_iPayloadSize)
+         m_ullFixedNextACKTime = currtime;
    }
 
+   // VR Frame Awareness: adaptive acknowledgement acknowledges at the ends of frames instead of messages, ahead of the
+   // timer in the last quarter of the ACK period
+   if (m_bAdaptiveACK && (total_chunks > 0))
+   {
+      if ((chunk_id + 1 == total_chunks) && (currtime + m_ullACKInt / 4 > m_ullNextACKTime))
+         m_ullNextACKTime = currtime;
+   }
    // This is not a regular fixed size packet...   
    //an irregular sized packet usually indicates the end of a message, so send an ACK immediately   
-   if (packet.getLength() != m_iPayloadSize)   
+   else if (packet.getLength() != m_iPayloadSize)   
       CTimer::rdtsc(m_ullNextACKTime); 
 
+   // VR Frame Awareness: where the newest packet stands in its frame; parity chunks come after the frame's end
+   if (CSeqNo::seqcmp(packet.m_iSeqNo, m_iRcvCurrSeqNo) > 0)
+      m_bRcvMidFrame = (total_chunks > 0) && (chunk_id + 1 < total_chunks);
+
    // Update the current largest sequence number that has been received.
    // Or it is a retransmitted packet, remove it from receiver loss list.
    if (CSeqNo::seqcmp(packet.m_iSeqNo, m_iRcvCurrSeqNo) > 0)
@@ -2506,49 +4355,167 @@ int CUDT::processData(CUnit* unit)
    else
       m_pRcvLossList->remove(packet.m_iSeqNo);
 
+   // VR Frame Awareness: rebuild what the parity received so far can rebuild; after the last parity chunk, report the rest
+   if (m_bPeerFEC && (NULL != m_pRcvFrameBuffer) && (total_chunks > 0))
+   {
+      recoverFrame(frame_id);
+
+      if (m_iFECPendingFrame == frame_id)
+      {
+         m_ullFECPendingTime = currtime;
+         if ((groups > 0) && (chunk_id == total_chunks + groups - 1))
+            reportFrameLoss();
+      }
+   }
+
    return 0;
 }
 
+bool CUDT::recoverFrame(uint16_t frame_id)
+{
+   int chunk, pos, chunks, groups;
+   int32_t seqno;
+   bool complete = false;
+
+   while (!complete && m_pRcvFrameBuffer->getRecoverable(frame_id, chunk, pos, chunks, groups, seqno))
+   {
+      // only a chunk that has been found lost, so that its sequence number is not reported again
+      int32_t lost = CSeqNo::incseq(seqno, chunk);
+      int offset = CSeqNo::seqoff(m_iRcvLastAck, lost);
+      if ((CSeqNo::seqcmp(lost, m_iRcvCurrSeqNo) > 0) || (offset < 0) || (offset >= m_pRcvBuffer->getAvailBufSize()))
+         break;
+
+      CUnit* unit = m_pRcvQueue->m_UnitQueue.getNextAvailUnit();
+      if (NULL == unit)
+         break;
+
+      unit->m_Packet.setLength(m_iPayloadSize);
+      if ((m_pRcvBuffer->recoverChunk(unit, pos, chunk, chunks, groups) < 0) || (m_pRcvBuffer->addData(unit, offset) < 0))
+      {
+         m_pRcvQueue->m_UnitQueue.putBackUnits(&unit, 1);
+         break;
+      }
+
+      m_pRcvLossList->remove(lost);
+      ++ m_iTraceRcvRecovered;
+      ++ m_iRcvRecoveredTotal;
+
+      if (NULL != m_pFrameTrace)
+         traceFrame(UDT_FRAME_CHUNK, frame_id, uint8_t(chunk), uint8_t(chunks), unit->m_Packet.getFrameDeadline(), lost);
+
+      if ((complete = m_pRcvFrameBuffer->addChunk(frame_id, uint8_t(chunk), uint8_t(chunks), pos, seqno, unit->m_Packet.getMsgSeq(), unit->m_Packet.getFrameDeadline())))
+         completeFrame(frame_id, uint8_t(chunks), pos, seqno, unit->m_Packet.getFrameDeadline());
+   }
+
+   return complete;
+}
+
+void CUDT::completeFrame(uint16_t frame_id, uint8_t total_chunks, int pos, int32_t seqno, int64_t deadline, bool partial)
+{
+   if (NULL != m_pFrameTrace)
+      traceFrame(UDT_FRAME_COMPLETE, frame_id, 0, total_chunks, deadline, -1);
+
+   // the latency is measured on the sender's time base, so it leaves out the shortest one-way delay
+   int64_t now = m_pRcvFrameBuffer->getSenderTime(CTimer::getTime() - m_StartTime);
+   int64_t sent = m_pRcvFrameBuffer->getSentTime(frame_id);
+   if (partial)
+   {
+      ++ m_llRcvPartialTotal;
+      ++ m_iTraceRcvPartial;
+   }
+
+   CGuard::enterCS(m_StatsLock);
+   if (!partial && (sent >= 0) && (now >= 0))
+      m_RcvFrameStats.complete(CTimeStamp::tscmp(now, sent));
+   if ((deadline > 0) && (now >= 0) && (CTimeStamp::tscmp(now, deadline) > 0))
+      m_RcvFrameStats.miss();
+   CGuard::leaveCS(m_StatsLock);
+
+   // the parity chunks of the frame are not needed any more
+   int groups = m_pRcvFrameBuffer->getGroups(frame_id);
+   if (groups > 0)
+   {
+      m_pRcvBuffer->dropUnits((pos + total_chunks) % m_pRcvBuffer->getSize(), groups);
+      m_pRcvLossList->remove(CSeqNo::incseq(seqno, total_chunks), CSeqNo::incseq(seqno, total_chunks + groups - 1));
+   }
+   if (m_iFECPendingFrame == frame_id)
+      m_iFECPendingFrame = -1;
+
+   #ifndef WIN32
+      pthread_mutex_lock(&m_RecvDataLock);
+      if (m_bSynRecving)
+         pthread_cond_signal(&m_RecvDataCond);
+      pthread_mutex_unlock(&m_RecvDataLock);
+   #else
+      if (m_bSynRecving)
+         SetEvent(m_RecvDataCond);
+   #endif
+
+   s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, UDT_EPOLL_IN, true);
+}
+
+void CUDT::reportFrameLoss()
+{
+   if (m_iFECPendingFrame < 0)
+      return;
+
+   uint16_t frame_id = uint16_t(m_iFECPendingFrame);
+   m_iFECPendingFrame = -1;
+
+   // one NAK for what is still missing of the frame
+   int32_t lossdata[65];
+   int losslen;
+   m_pRcvFrameBuffer->getLossArray(frame_id, m_iRcvCurrSeqNo, lossdata, losslen, 64);
+   if (0 == losslen)
+      return;
+
+   if (1 == losslen)
+      lossdata[1] = lossdata[0];
+   sendCtrl(3, NULL, lossdata, losslen);
+}
+
 int CUDT::listen(sockaddr* addr, CPacket& packet)
 {
    if (m_bClosing)
       return 1002;
 
-   if (packet.getLength() != CHandShake::m_iContentSize)
+   ++ m_iTraceHSRecv;
+   ++ m_iHSRecvTotal;
+
+   if ((packet.getLength() != CHandShake::m_iContentSize) && (packet.getLength() != CHandShake::m_iExtContentSize))
+   {
+      ++ m_iTraceHSReject;
+      ++ m_iHSRejectTotal;
       return 1004;
+   }
 
    CHandShake hs;
    hs.deserialize(packet.m_pcData, packet.getLength());
 
    // SYN cookie
-   char clienthost[NI_MAXHOST];
-   char clientport[NI_MAXSERV];
-   getnameinfo(addr, (AF_INET == m_iVersion) ? sizeof(sockaddr_in) : sizeof(sockaddr_in6), clienthost, sizeof(clienthost), clientport, sizeof(clientport), NI_NUMERICHOST|NI_NUMERICSERV);
    int64_t timestamp = (CTimer::getTime() - m_StartTime) / 60000000; // secret changes every one minute
-   stringstream cookiestr;
-   cookiestr << clienthost << ":" << clientport << ":" << timestamp;
-   unsigned char cookie[16];
-   CMD5::compute(cookiestr.str().c_str(), cookie);
+   int32_t cookie = CCookie::compute(m_pullCookieKey, addr, m_iIPversion, timestamp);
 
    if (1 == hs.m_iReqType)
    {
-      hs.m_iCookie = *(int*)cookie;
+      hs.m_iCookie = cookie;
+      hs.m_iExtension = (m_bShmem ? CHandShake::m_iExtShmem : 0) | ((UDT_DGRAM == m_iSockType) ? CHandShake::m_iExtFrameHeader : 0) | CHandShake::m_iExtAckNak |
+                        ((m_bFrameLayers && (UDT_DGRAM == m_iSockType)) ? CHandShake::m_iExtFrameLayers : 0);
       packet.m_iID = hs.m_iID;
-      int size = packet.getLength();
+      int size = CHandShake::m_iExtContentSize;
       hs.serialize(packet.m_pcData, size);
+      packet.setLength(size);
       m_pSndQueue->sendto(addr, packet);
       return 0;
    }
    else
    {
-      if (hs.m_iCookie != *(int*)cookie)
+      // the cookie may have been given out in the previous minute
+      if ((hs.m_iCookie != cookie) && (hs.m_iCookie != CCookie::compute(m_pullCookieKey, addr, m_iIPversion, timestamp - 1)))
       {
-         timestamp --;
-         cookiestr << clienthost << ":" << clientport << ":" << timestamp;
-         CMD5::compute(cookiestr.str().c_str(), cookie);
-
-         if (hs.m_iCookie != *(int*)cookie)
-            return -1;
+         ++ m_iTraceHSReject;
+         ++ m_iHSRejectTotal;
+         return -1;
       }
    }
 
@@ -2560,9 +4527,13 @@ int CUDT::listen(sockaddr* addr, CPacket& packet)
       if ((hs.m_iVersion != m_iVersion) || (hs.m_iType != m_iSockType))
       {
          // mismatch, reject the request
+         ++ m_iTraceHSReject;
+         ++ m_iHSRejectTotal;
          hs.m_iReqType = 1002;
+         hs.m_iExtension = 0;
          int size = CHandShake::m_iContentSize;
          hs.serialize(packet.m_pcData, size);
+         packet.setLength(size);
          packet.m_iID = id;
          m_pSndQueue->sendto(addr, packet);
       }
@@ -2570,19 +4541,28 @@ int CUDT::listen(sockaddr* addr, CPacket& packet)
       {
          int result = s_UDTUnited.newConnection(m_SocketID, addr, &hs);
          if (result == -1)
+         {
+            ++ m_iTraceHSReject;
+            ++ m_iHSRejectTotal;
             hs.m_iReqType = 1002;
+            hs.m_iExtension = 0;
+         }
 
          // send back a response if connection failed or connection already existed
          // new connection response should be sent in connect()
          if (result != 1)
          {
-            int size = CHandShake::m_iContentSize;
+            int size = CHandShake::m_iExtContentSize;
             hs.serialize(packet.m_pcData, size);
+            packet.setLength(size);
             packet.m_iID = id;
             m_pSndQueue->sendto(addr, packet);
          }
          else
          {
+            ++ m_iTraceAccept;
+            ++ m_iAcceptTotal;
+
             // a new connection has been created, enable epoll for write 
             s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, UDT_EPOLL_OUT, true);
          }
@@ -2592,6 +4572,91 @@ int CUDT::listen(sockaddr* addr, CPacket& packet)
    return hs.m_iReqType;
 }
 
+void CUDT::sampleAccept(CAcceptStats* stats, bool clear)
+{
+   if (!m_bListening)
+      throw CUDTException(5, 6, 0);
+
+   uint64_t currtime = CTimer::getTime();
+   stats->msTimeStamp = (currtime - m_StartTime) / 1000;
+
+   stats->hsRecvTotal = m_iHSRecvTotal;
+   stats->hsDroppedTotal = m_iHSDropTotal;
+   stats->hsRejectedTotal = m_iHSRejectTotal;
+   stats->connAcceptedTotal = m_iAcceptTotal;
+
+   stats->hsRecv = m_iTraceHSRecv;
+   stats->hsDropped = m_iTraceHSDrop;
+   stats->hsRejected = m_iTraceHSReject;
+   stats->connAccepted = m_iTraceAccept;
+
+   double interval = double(currtime - m_LastAcceptSampleTime);
+   stats->hsRecvRate = (interval > 0) ? m_iTraceHSRecv * 1000000.0 / interval : 0;
+   stats->connAcceptRate = (interval > 0) ? m_iTraceAccept * 1000000.0 / interval : 0;
+   stats->usHSWaitAvg = (m_iTraceHSRecv > 0) ? m_llTraceHSWait / double(m_iTraceHSRecv) : 0;
+   stats->usHSWaitMax = double(m_llMaxHSWait);
+
+   stats->hsQueueLen = m_pRcvQueue->getHandshakeNum();
+
+   if (clear)
+   {
+      m_iTraceHSRecv = m_iTraceHSDrop = m_iTraceHSReject = m_iTraceAccept = 0;
+      m_llTraceHSWait = m_llMaxHSWait = 0;
+      m_LastAcceptSampleTime = currtime;
+   }
+}
+
+void CUDT::sendACK(int32_t* lossdata, int losslen)
+{
+   int sent = m_iSentACKTotal;
+   sendCtrl(2, NULL, lossdata, losslen);
+
+   // an ACK costs the ACK2 it draws, too
+   if (m_bAdaptiveACK && (m_iSentACKTotal != sent))
+      countCtrlSaved(-2);
+
+   uint64_t currtime;
+   CTimer::rdtsc(currtime);
+
+   if (m_bAdaptiveACK)
+   {
+      // about four full ACKs per RTT, one to ten SYN intervals apart
+      int period = m_iRTT / 4;
+      if (period < m_iSYNInterval)
+         period = m_iSYNInterval;
+      else if (period > 10 * m_iSYNInterval)
+         period = 10 * m_iSYNInterval;
+      m_ullACKInt = period * m_ullCPUFrequency;
+
+      // light ACKs as often as well, but no more often than the fixed interval and at least four per flow window
+      int interval = int(int64_t(m_pRcvTimeWindow->getPktRcvSpeed()) * m_iRTT / 4000000);
+      if (interval > m_iFlightFlagSize / 4)
+         interval = m_iFlightFlagSize / 4;
+      if (interval < m_iSelfClockInterval)
+         interval = m_iSelfClockInterval;
+      m_iLightACKInterval = interval;
+   }
+   else
+   {
+      m_ullACKInt = m_ullSYNInt;
+      m_iLightACKInterval = m_iSelfClockInterval;
+   }
+
+   if (m_pCC->m_iACKPeriod > 0)
+      m_ullNextACKTime = currtime + m_pCC->m_iACKPeriod * m_ullCPUFrequency;
+   else
+      m_ullNextACKTime = currtime + m_ullACKInt;
+
+   m_iPktCount = 0;
+   m_iLightACKCount = 1;
+}
+
+void CUDT::countCtrlSaved(int num)
+{
+   m_iCtrlSavedTotal += num;
+   m_iTraceCtrlSaved += num;
+}
+
 void CUDT::checkTimers()
 {
    // update CC parameters
@@ -2603,25 +4668,60 @@ void CUDT::checkTimers()
    uint64_t currtime;
    CTimer::rdtsc(currtime);
 
-   if ((currtime > m_ullNextACKTime) || ((m_pCC->m_iACKInterval > 0) && (m_pCC->m_iACKInterval <= m_iPktCount)))
+   // over shared memory there is nothing to acknowledge; the peer is still watched over UDP
+   if (NULL != m_pShm)
    {
-      // ACK timer expired or ACK interval is reached
+      updateShmEvents();
+      goto EXP_CHECK;
+   }
 
-      sendCtrl(2);
-      CTimer::rdtsc(currtime);
-      if (m_pCC->m_iACKPeriod > 0)
-         m_ullNextACKTime = currtime + m_pCC->m_iACKPeriod * m_ullCPUFrequency;
-      else
-         m_ullNextACKTime = currtime + m_ullACKInt;
+   // VR Frame Awareness: give up on frames that cannot make their deadlines, so that the next ACK moves past them
+   if (m_bFrameDrop && (NULL != m_pRcvFrameBuffer) && (currtime > m_ullNextFrameCheckTime))
+   {
+      abandonExpiredFrames();
+      m_ullNextFrameCheckTime = currtime + m_ullSYNInt / 10;
+   }
 
-      m_iPktCount = 0;
-      m_iLightACKCount = 1;
+   // VR Frame Awareness: the rest of a frame whose losses wait for its parity may have been lost, too
+   if ((m_iFECPendingFrame >= 0) && (currtime > m_ullFECPendingTime + m_ullSYNInt / 10))
+      reportFrameLoss();
+
+   // VR Frame Awareness: with adaptive acknowledgement an ACK that falls due within a frame waits for the frame's end,
+   // for up to half an ACK period, and a light ACK for up to one more interval
+   // the fixed schedule, which adaptive acknowledgement is measured against: an ACK per SYN interval if the ACK point moved
+   if (m_bAdaptiveACK && (currtime >= m_ullFixedNextACKTime))
+   {
+      int32_t ack = (0 == m_pRcvLossList->getLossLength()) ? CSeqNo::incseq(m_iRcvCurrSeqNo) : m_pRcvLossList->getFirstLostSeq();
+      if (CSeqNo::seqcmp(ack, m_iFixedLastAck) > 0)
+      {
+         countCtrlSaved(2);
+         m_iFixedLastAck = ack;
+      }
+      m_iFixedPktCount = 0;
+      m_ullFixedNextACKTime = currtime + m_ullSYNInt;
+   }
+
+   bool ack;
+   ack = currtime > m_ullNextACKTime;
+   if (ack && m_bAdaptiveACK && m_bRcvMidFrame && (currtime < m_ullNextACKTime + m_ullACKInt / 2))
+      ack = false;
+
+   if (ack || ((m_pCC->m_iACKInterval > 0) && (m_pCC->m_iACKInterval <= m_iPktCount)))
+   {
+      // ACK timer expired or ACK interval is reached
+      sendACK();
    }
-   else if (m_iSelfClockInterval * m_iLightACKCount <= m_iPktCount)
+   else if (m_iLightACKInterval * m_iLightACKCount <= m_iPktCount)
    {
-      //send a "light" ACK
-      sendCtrl(2, NULL, NULL, 4);
-      ++ m_iLightACKCount;
+      if (!m_bAdaptiveACK || !m_bRcvMidFrame || (m_iLightACKInterval * (m_iLightACKCount + 1) <= m_iPktCount))
+      {
+         //send a "light" ACK
+         sendCtrl(2, NULL, NULL, 4);
+         ++ m_iLightACKCount;
+
+         if (m_bAdaptiveACK)
+            countCtrlSaved(-1);
+      }
    }
 
    // we are not sending back repeated NAK anymore and rely on the sender's EXP for retransmission
@@ -2634,6 +4734,7 @@ void CUDT::checkTimers()
    //   m_ullNextNAKTime = currtime + m_ullNAKInt;
    //}
 
+EXP_CHECK:
    uint64_t next_exp_time;
    if (m_pCC->m_bUserDefinedRTO)
       next_exp_time = m_ullLastRspTime + m_pCC->m_iRTO * m_ullCPUFrequency;
@@ -2712,6 +4813,12 @@ void CUDT::addEPoll(const int eid)
    if (!m_bConnected || m_bBroken || m_bClosing)
       return;
 
+   if (NULL != m_pShm)
+   {
+      updateShmEvents();
+      return;
+   }
+
    if (((UDT_STREAM == m_iSockType) && (m_pRcvBuffer->getRcvDataSize() > 0)) ||
       ((UDT_DGRAM == m_iSockType) && (m_pRcvBuffer->getRcvMsgNum() > 0)))
    {
@@ -53,6 +53,7 @@ written by
 #include "ccc.h"
 #include "cache.h"
 #include "queue.h"
+#include "shmem.h"
 
 enum UDTSockType {UDT_STREAM = 1, UDT_DGRAM};
 
@@ -78,6 +79,7 @@ private: // constructor and desctructor
 public: //API
    static int startup();
    static int cleanup();
+   static int setcachefile(const char* path, int maxage);
    static UDTSOCKET socket(int af, int type = SOCK_STREAM, int protocol = 0);
    static int bind(UDTSOCKET u, const sockaddr* name, int namelen);
    static int bind(UDTSOCKET u, UDPSOCKET udpsock);
@@ -95,6 +97,8 @@ public: //API
    static int recvmsg(UDTSOCKET u, char* buf, int len);
    static int64_t sendfile(UDTSOCKET u, std::fstream& ifs, int64_t& offset, int64_t size, int block = 364000);
    static int64_t recvfile(UDTSOCKET u, std::fstream& ofs, int64_t& offset, int64_t size, int block = 7280000);
+   static int64_t sendfile2(UDTSOCKET u, const char* path, int64_t* offset, int64_t size, int block = 364000);
+   static int64_t recvfile2(UDTSOCKET u, const char* path, int64_t* offset, int64_t size, int block = 7280000);
    static int select(int nfds, ud_set* readfds, ud_set* writefds, ud_set* exceptfds, const timeval* timeout);
    static int selectEx(const std::vector<UDTSOCKET>& fds, std::vector<UDTSOCKET>* readfds, std::vector<UDTSOCKET>* writefds, std::vector<UDTSOCKET>* exceptfds, int64_t msTimeOut);
    static int epoll_create();
@@ -103,11 +107,31 @@ public: //API
    static int epoll_remove_usock(const int eid, const UDTSOCKET u);
    static int epoll_remove_ssock(const int eid, const SYSSOCKET s);
    static int epoll_wait(const int eid, std::set<UDTSOCKET>* readfds, std::set<UDTSOCKET>* writefds, int64_t msTimeOut, std::set<SYSSOCKET>* lrfds = NULL, std::set<SYSSOCKET>* wrfds = NULL);
+   static int epoll_wait2(const int eid, UDT_EPOLL_EVENT* events, int max, int64_t msTimeOut);
    static int epoll_release(const int eid);
    static CUDTException& getlasterror();
    static int perfmon(UDTSOCKET u, CPerfMon* perf, bool clear = true);
+   static int acceptstats(UDTSOCKET u, CAcceptStats* stats, bool clear = true);
    static UDTSTATUS getsockstate(UDTSOCKET u);
    static int set_next_frame_metadata(UDTSOCKET u, uint16_t frame_id, uint8_t chunk_id, uint8_t total_chunks, int64_t deadline_us);
+   static int sendframe(UDTSOCKET u, const char* buf, int len, uint16_t frame_id, int64_t deadline_us, UDTFRAMEDONE callback = NULL, void* context = NULL);
+   static int sendframe_layered(UDTSOCKET u, const char* buf, const int* layers, int nlayers, int required, uint16_t frame_id, int64_t deadline_us);
+   static int recvframe(UDTSOCKET u, char* buf, int len, uint16_t& frame_id, bool& complete);
+   static int recvmsg_zc(UDTSOCKET u, const UDT_IOVEC*& iov, int& iovcnt, int& handle);
+   static int recvframe_zc(UDTSOCKET u, const UDT_IOVEC*& iov, int& iovcnt, uint16_t& frame_id, bool& complete, int& handle);
+   static int release_zc(UDTSOCKET u, int handle);
+   static int fanout_create();
+   static int fanout_add(const int gid, UDTSOCKET u);
+   static int fanout_remove(const int gid, UDTSOCKET u);
+   static int fanout_sendframe(const int gid, const char* buf, int len, uint16_t frame_id, int64_t deadline_us);
+   static int fanout_release(const int gid);
+   static int mpath_create();
+   static int mpath_add(const int mid, UDTSOCKET u);
+   static int mpath_remove(const int mid, UDTSOCKET u);
+   static int mpath_sendframe(const int mid, const char* buf, int len, uint16_t frame_id, int64_t deadline_us);
+   static int mpath_recvframe(const int mid, char* buf, int len, uint16_t& frame_id, bool& complete);
+   static int mpath_release(const int mid);
+   static int getframetrace(UDTSOCKET u, CFrameEvent* events, int num, int* overflow = NULL);
 
 public: // internal API
    static CUDT* getUDTHandle(UDTSOCKET u);
@@ -118,7 +142,7 @@ public: // internal API
       //    0) [in] frame_id: Frame ID (0-65535)
       //    1) [in] chunk_id: Chunk ID within frame (0-255)
       //    2) [in] total_chunks: Total chunks in this frame (0-255)
-      //    3) [in] deadline_us: Frame deadline in microseconds
+      //    3) [in] deadline_us: Frame deadline in microseconds since the socket was opened, 0 if none
       // Returned value:
       //    None.
 
@@ -180,6 +204,16 @@ private:
 
    void close();
 
+      // Functionality:
+      //    Stop passing connection requests to a listening UDT entity, after the one being answered, if any.
+      //    Answering a request takes CUDTUnited::m_ControlLock, the caller must not hold it.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    None.
+
+   void stopListening();
+
       // Functionality:
       //    Request UDT to send out a data block "data" with size of "len".
       // Parameters:
@@ -222,6 +256,71 @@ private:
 
    int recvmsg(char* data, int len);
 
+      // Functionality:
+      //    VR Frame Awareness: send a whole frame; it is split into chunks stamped with chunk_id/total_chunks.
+      // Parameters:
+      //    0) [in] data: The address of the frame data.
+      //    1) [in] len: The size of the frame.
+      //    2) [in] frame_id: Frame ID (0-65535)
+      //    3) [in] deadline_us: Frame deadline in microseconds since the socket was opened, 0 if none
+      //    4) [in] callback: if not NULL, the frame is sent without copying and callback is called on release.
+      //    5) [in] context: passed to the callback.
+      //    6) [in] block: false to fail at once when the sender buffer is full, even on a blocking socket.
+      //    7) [in] layers: if not NULL, the frame is coded in layers of these sizes, base layer first, and is copied.
+      //    8) [in] nlayers: number of layers.
+      //    9) [in] required: number of leading layers the frame cannot be used without; the others may be shed.
+      // Returned value:
+      //    Actual size of data sent.
+
+   int sendframe(const char* data, int len, uint16_t frame_id, int64_t deadline_us, UDTFRAMEDONE callback = NULL, void* context = NULL, bool block = true,
+                 const int* layers = NULL, int nlayers = 0, int required = 0);
+
+      // Functionality:
+      //    VR Frame Awareness: receive the next frame, or learn that the sender has abandoned one.
+      // Parameters:
+      //    0) [out] data: frame received.
+      //    1) [in] len: size of the buffer.
+      //    2) [out] frame_id: Frame ID of the frame.
+      //    3) [out] complete: false if the frame missed its deadline; no data is returned for it, or only its leading
+      //       complete layers if it is layered and has all its required ones.
+      //    4) [in] block: false to fail at once when no frame is ready, even on a blocking socket.
+      // Returned value:
+      //    Actual size of data received.
+
+   int recvframe(char* data, int len, uint16_t& frame_id, bool& complete, bool block = true);
+
+      // Functionality:
+      //    Receive the next message, or frame, without copying it: the units holding it are lent to the application.
+      // Parameters:
+      //    0) [in] frame: true to receive a frame as recvframe does, false to receive a message.
+      //    1) [out] iov: pieces of the data, valid until the loan is released.
+      //    2) [out] iovcnt: number of pieces.
+      //    3) [out] frame_id: Frame ID of the message or frame.
+      //    4) [out] complete: false if the frame missed its deadline, as for recvframe.
+      //    5) [out] handle: loan to be released by release_zc, -1 if there is no data.
+      // Returned value:
+      //    Actual size of data received.
+
+   int recvzc(bool frame, const UDT_IOVEC*& iov, int& iovcnt, uint16_t& frame_id, bool& complete, int& handle);
+
+      // Functionality:
+      //    Give back the units of a message or frame lent by recvzc.
+      // Parameters:
+      //    0) [in] handle: the loan.
+      // Returned value:
+      //    None.
+
+   void release_zc(int handle);
+
+      // Functionality:
+      //    estimate when more data sent now would reach the peer, from the rate, RTT and loss of this connection.
+      // Parameters:
+      //    0) [in] len: size of the data.
+      // Returned value:
+      //    microseconds from now, or -1 if the connection is down or the sender buffer cannot take the data.
+
+   int64_t estimateDelivery(int len);
+
       // Functionality:
       //    Request UDT to send out a file described as "fd", starting from "offset", with size of "size".
       // Parameters:
@@ -246,6 +345,32 @@ private:
 
    int64_t recvfile(std::fstream& ofs, int64_t& offset, int64_t size, int block = 7320000);
 
+#ifndef WIN32
+      // Functionality:
+      //    Request UDT to send out a file descriptor without copying it through user space: see CSndBuffer::addBufferFromFile.
+      // Parameters:
+      //    0) [in] fd: The file, opened for reading.
+      //    1) [in, out] offset: From where to read and send data; output is the new offset when the call returns.
+      //    2) [in] size: How many data to be sent; the end of the file caps it.
+      //    3) [in] block: size of each mapping of the file
+      // Returned value:
+      //    Actual size of data sent, less than "size" if the file ends first. An offset past the end is an error.
+
+   int64_t sendfile(int fd, int64_t& offset, int64_t size, int block = 366000);
+
+      // Functionality:
+      //    Request UDT to receive data into a file descriptor, written straight from the receiver units.
+      // Parameters:
+      //    0) [in] fd: The file, opened for writing.
+      //    1) [in, out] offset: From where to write data; output is the new offset when the call returns.
+      //    2) [in] size: How many data to be received.
+      //    3) [in] block: maximum size of data written per call
+      // Returned value:
+      //    Actual size of data received.
+
+   int64_t recvfile(int fd, int64_t& offset, int64_t size, int block = 7320000);
+#endif
+
       // Functionality:
       //    Configure UDT options.
       // Parameters:
@@ -278,6 +403,27 @@ private:
 
    void sample(CPerfMon* perf, bool clear = true);
 
+      // Functionality:
+      //    read the handshake counters of a listening socket since the last sampleAccept() call.
+      // Parameters:
+      //    0) [out] stats: the counters.
+      //    1) [in] clear: flag to decide if the local counters should be cleared.
+      // Returned value:
+      //    None.
+
+   void sampleAccept(CAcceptStats* stats, bool clear = true);
+
+      // Functionality:
+      //    VR Frame Awareness: move recorded frame events out of the trace (UDT_FRAMETRACE).
+      // Parameters:
+      //    0) [out] events: buffer for the events.
+      //    1) [in] num: maximum number of events to read.
+      //    2) [out] overflow: number of events discarded because the trace was full since the last call.
+      // Returned value:
+      //    Number of events read.
+
+   int getFrameTrace(CFrameEvent* events, int num, int& overflow);
+
 private:
    static CUDTUnited s_UDTUnited;               // UDT global management base
 
@@ -294,6 +440,7 @@ private: // Identification
 private: // Packet sizes
    int m_iPktSize;                              // Maximum/regular packet size, in bytes
    int m_iPayloadSize;                          // Maximum/regular payload size, in bytes
+   int m_iHdrFormat;                            // layout of the data packet header agreed with the peer, HDR_CLASSIC or HDR_FRAME
 
 private: // Options
    int m_iMSS;                                  // Maximum Segment Size, in bytes
@@ -311,14 +458,27 @@ private: // Options
    int m_iRcvTimeOut;                           // receiving timeout in milliseconds
    bool m_bReuseAddr;				// reuse an exiting port or not, for UDP multiplexer
    int64_t m_llMaxBW;				// maximum data transfer rate (threshold)
+   bool m_bFrameDrop;                           // VR Frame Awareness: drop frames that have missed their deadline
+   bool m_bFEC;                                 // VR Frame Awareness: add parity chunks to the frames sent
+   int m_iSndSched;                             // VR Frame Awareness: sender scheduling policy (UDTSNDSCHED)
+   int m_iFrameTraceSize;                       // VR Frame Awareness: capacity of the frame event trace, 0 = off
+   bool m_bUDPOffload;                          // use UDP GSO/GRO on the channel if available
+   int m_iWorkers;                              // number of worker pairs of the multiplexer created for this socket
+   int m_iPacingSlack;                          // pacing slack of the multiplexer created for this socket, in microseconds
+   bool m_bURing;                               // use io_uring on the channel if available
+   bool m_bShmem;                               // use shared memory with a peer on the same host
+   volatile bool m_bAdaptiveACK;                // adapt the ACK frequency to the rate and RTT (UDT_ADAPTIVEACK)
+   bool m_bFrameLayers;                         // VR Frame Awareness: offer the layered frame header (UDT_FRAMELAYERS)
 
 private: // congestion control
    CCCVirtualFactory* m_pCCFactory;             // Factory class to create a specific CC instance
    CCC* m_pCC;                                  // congestion control class
    CCache<CInfoBlock>* m_pCache;		// network information cache
+   CSharedInfoCache* m_pSharedCache;            // network information shared with other processes, NULL if not used
 
 private: // Status
    volatile bool m_bListening;                  // If the UDT entit is listening to connection
+   uint64_t m_pullCookieKey[2];                 // secret key of the SYN cookies, drawn when listening starts
    volatile bool m_bConnecting;			// The short phase when connect() is called but not yet completed
    volatile bool m_bConnected;                  // Whether the connection is on or off
    volatile bool m_bClosing;                    // If the UDT entity is closing
@@ -367,10 +527,179 @@ private: // Sending related data
    int64_t m_iNextFrameDeadline;                // Frame deadline in microseconds
    bool m_bHasFrameMetadata;                    // True if metadata has been set for next packet
 
+   double m_dFECLossRate;                       // VR Frame Awareness: loss rate that sizes the parity of a frame
+   int64_t m_llFECSent;                         // packets sent when the loss rate was last updated
+   int m_iFECLost;                              // packets lost (reported or rebuilt by the peer) at that time
+
+   double m_dSndLossRate;                       // loss rate over the last few hundred packets sent, for estimateDelivery
+   int64_t m_llLossRateSent;                    // packets sent when that loss rate was last updated
+   int m_iLossRateLost;                         // packets lost at that time
+   int m_iPeerRecoveredTotal;                   // packets the peer has rebuilt from parity, as reported in ACKs
+
    void CCUpdate();
 
+      // Functionality:
+      //    VR Frame Awareness: drop all remaining packets of the frame that "seqno" belongs to, if its deadline has passed.
+      // Parameters:
+      //    0) [in] seqno: sequence number of a packet to be sent or retransmitted.
+      // Returned value:
+      //    true if the frame has been dropped, otherwise false.
+
+   bool dropExpiredFrame(int32_t seqno);
+
+      // Functionality:
+      //    VR Frame Awareness: decide if a retransmission should yield to new data under the deadline policy.
+      // Parameters:
+      //    0) [in] seqno: sequence number of the lost packet.
+      // Returned value:
+      //    true if new data can be sent and either has an earlier deadline or the lost packet cannot make its deadline,
+      //    or, with layered frames, if the lost packet is optional and the new data is of a lower layer.
+
+   bool deferRetransmission(int32_t seqno);
+
+      // Functionality:
+      //    VR Frame Awareness: shed the optional layers of a frame from the chunk "seqno" on, if the rest of the frame
+      //    would reach the receiver after the deadline at the current sending rate.
+      // Parameters:
+      //    0) [in] seqno: sequence number of a packet to be sent or retransmitted.
+      // Returned value:
+      //    true if chunks have been shed, otherwise false.
+
+   bool shedLayers(int32_t seqno);
+
+      // Functionality:
+      //    sending rate of this connection, from its pacing and windows, and the recent loss rate.
+      // Parameters:
+      //    0) [out] loss: loss rate over the last few hundred packets sent, at most 0.5.
+      // Returned value:
+      //    packets per second.
+
+   double getSndRate(double& loss);
+
+      // Functionality:
+      //    VR Frame Awareness: skip the unsent packets of the frames abandoned by the receiver.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    true if packets have been skipped, otherwise false.
+
+   bool skipAbandonedFrame();
+
+   std::list<std::pair<int32_t, int32_t> > m_SndAbandoned;      // VR Frame Awareness: first and last seq. no. of the frames abandoned by the receiver and not skipped yet, in order, not overlapping
+   static const int m_iMaxAbandoned;            // VR Frame Awareness: most abandoned frames kept, as many as the receiver's frame table tracks
+   int32_t m_iSndAbandonAck;                    // VR Frame Awareness: ACK past those frames that came before their unsent packets were skipped, -1 if none
+
+      // Functionality:
+      //    VR Frame Awareness: read the next frame or the next abandoned frame report.
+      // Parameters:
+      //    0) [out] data: frame received.
+      //    1) [in] len: size of the buffer.
+      //    2) [out] size: size of data read.
+      //    3) [out] frame_id: Frame ID of the frame.
+      //    4) [out] complete: false if the frame has been abandoned, or comes without some optional layers.
+      // Returned value:
+      //    true if a frame or a report has been read, otherwise false.
+
+   bool readFrame(char* data, int len, int& size, uint16_t& frame_id, bool& complete);
+
+      // Functionality:
+      //    Lend the next message, frame, or abandoned frame report to the application.
+      // Parameters:
+      //    0) [in] frame: true for a frame, false for a message.
+      //    1) [out] size: size of data lent.
+      //    2) [out] frame_id: Frame ID of the message or frame.
+      //    3) [out] complete: false if the frame has been abandoned by the sender.
+      //    4) [out] handle: the new loan, -1 if nothing is lent.
+      // Returned value:
+      //    true if a message, a frame or a report has been read, otherwise false.
+
+   bool lendData(bool frame, int& size, uint16_t& frame_id, bool& complete, int& handle);
+
+      // Functionality:
+      //    Give back all the units on loan, when the socket goes away.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    None.
+
+   void releaseLoans();
+
+      // Functionality:
+      //    VR Frame Awareness: record a frame event, called from the receiving thread only.
+      // Parameters:
+      //    0) [in] type: event type, see UDTFRAMEEVENT.
+      //    1) [in] frame_id: VR frame ID.
+      //    2) [in] chunk_id: chunk index within the frame.
+      //    3) [in] total_chunks: number of chunks in the frame.
+      //    4) [in] deadline: frame deadline, 0 if unknown.
+      //    5) [in] seqno: sequence number of the chunk, -1 if not applicable.
+      // Returned value:
+      //    None.
+
+   void traceFrame(int type, uint16_t frame_id, uint8_t chunk_id, uint8_t total_chunks, int64_t deadline, int32_t seqno);
+
+      // Functionality:
+      //    VR Frame Awareness: stop waiting for the packets of a message or frame.
+      // Parameters:
+      //    0) [in] msgno: message number.
+      //    1) [in] seqno1: first sequence number of the message.
+      //    2) [in] seqno2: last sequence number of the message.
+      //    3) [in] frame_id: VR frame ID, -1 if unknown.
+      //    4) [in] drop: drop the data received so far and report the frame to recvframe.
+      // Returned value:
+      //    None.
+
+   void dropRcvMsg(int32_t msgno, int32_t seqno1, int32_t seqno2, int frame_id, bool drop);
+
+      // Functionality:
+      //    VR Frame Awareness: abandon the incomplete frames that can no longer make their deadlines,
+      //    instead of asking for their lost packets, and tell the sender.
+      // Parameters:
+      //    0) [in] seqno1: first sequence number of new losses about to be reported, -1 if none.
+      //    1) [in] seqno2: last sequence number of the new losses.
+      // Returned value:
+      //    None.
+
+   void abandonExpiredFrames(int32_t seqno1 = -1, int32_t seqno2 = -1);
+
+      // Functionality:
+      //    VR Frame Awareness: rebuild the lost chunks of a frame that its parity chunks can rebuild.
+      // Parameters:
+      //    0) [in] frame_id: VR frame ID.
+      // Returned value:
+      //    true if the frame is complete now, otherwise false.
+
+   bool recoverFrame(uint16_t frame_id);
+
+      // Functionality:
+      //    VR Frame Awareness: let recvframe know that a frame is complete, and release its parity chunks.
+      // Parameters:
+      //    0) [in] frame_id: VR frame ID.
+      //    1) [in] total_chunks: number of data chunks in the frame.
+      //    2) [in] pos: receiver buffer position of the first chunk of the frame.
+      //    3) [in] seqno: sequence number of the first chunk of the frame.
+      //    4) [in] deadline: frame deadline, 0 if there is none.
+      //    5) [in] partial: the frame goes without some of its optional layers.
+      // Returned value:
+      //    None.
+
+   void completeFrame(uint16_t frame_id, uint8_t total_chunks, int pos, int32_t seqno, int64_t deadline, bool partial = false);
+
+      // Functionality:
+      //    VR Frame Awareness: report the losses of the frame whose loss report waits for its parity, if any.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    None.
+
+   void reportFrameLoss();
+
 private: // Receiving related data
    CRcvBuffer* m_pRcvBuffer;                    // Receiver buffer
+   CRcvFrameBuffer* m_pRcvFrameBuffer;          // VR Frame Awareness: per-frame chunk tracking for recvframe, SOCK_DGRAM only
+   CFrameTrace* m_pFrameTrace;                  // VR Frame Awareness: frame event trace, NULL if UDT_FRAMETRACE is off
+   CShmLink* m_pShm;                            // shared memory link carrying the data of both directions, NULL if not used
+   int32_t m_iHSExtension;                      // handshake extensions agreed with the peer (CHandShake::m_iExtension)
    CRcvLossList* m_pRcvLossList;                // Receiver loss list
    CACKWindow* m_pACKWindow;                    // ACK history window
    CPktTimeWindow* m_pRcvTimeWindow;            // Packet arrival time window
@@ -381,6 +710,10 @@ private: // Receiving related data
    int32_t m_iAckSeqNo;                         // Last ACK sequence number
    int32_t m_iRcvCurrSeqNo;                     // Largest received sequence number
 
+   bool m_bPeerFEC;                             // VR Frame Awareness: if parity chunks have been received from the peer
+   int32_t m_iFECPendingFrame;                  // frame whose losses are reported after its parity, -1 if none
+   uint64_t m_ullFECPendingTime;                // last arrival of a chunk of that frame
+
    uint64_t m_ullLastWarningTime;               // Last time that a warning message is sent
 
    int32_t m_iPeerISN;                          // Initial Sequence Number of the peer side
@@ -399,13 +732,36 @@ private: // synchronization: mutexes and conditions
    pthread_mutex_t m_SendLock;                  // used to synchronize "send" call
    pthread_mutex_t m_RecvLock;                  // used to synchronize "recv" call
 
+   std::list<uint16_t> m_DroppedFrames;         // VR Frame Awareness: frames abandoned by the sender, not yet reported to recvframe
+   pthread_mutex_t m_DroppedFramesLock;         // used to synchronize m_DroppedFrames
+
+   struct CLoan
+   {
+      std::vector<CUnit*> m_vUnits;             // receiver units lent to the application
+      std::vector<UDT_IOVEC> m_vIOV;            // the data of the units, as given to the application
+   };
+   std::map<int, CLoan> m_mLoans;               // messages and frames received by recvmsg_zc/recvframe_zc and not released yet
+   int m_iNextLoan;                             // handle of the next loan
+   pthread_mutex_t m_LoanLock;                  // used to synchronize m_mLoans
+   pthread_mutex_t m_StatsLock;                 // used to synchronize the pacing error counters, m_SndFrameStats and m_RcvFrameStats with sample()
+
    void initSynch();
    void destroySynch();
    void releaseSynch();
 
 private: // Generation and processing of packets
    void sendCtrl(int pkttype, void* lparam = NULL, void* rparam = NULL, int size = 0);
+   void sendACK(int32_t* lossdata = NULL, int losslen = 0);
+   void countCtrlSaved(int num);
+   void waitFileSndBuf();
+   void waitFileRcvData();
+   int shmWrite(const char* data, int len, int32_t frame_id, int64_t deadline, bool sync, int timeout);
+   int shmRead(char* data, int len, int32_t& frame_id, int64_t& deadline, bool sync, int timeout);
+   void updateShmEvents();
+   int lookupCache(CInfoBlock* ib);
+   void updateCache(CInfoBlock* ib);
    void processCtrl(CPacket& ctrlpkt);
+   bool processLossReport(const int32_t* losslist, int len);
    int packData(CPacket& packet, uint64_t& ts);
    int processData(CUnit* unit);
    int listen(sockaddr* addr, CPacket& packet);
@@ -421,6 +777,15 @@ private: // Trace
    int m_iRecvACKTotal;                         // total number of received ACK packets
    int m_iSentNAKTotal;                         // total number of sent NAK packets
    int m_iRecvNAKTotal;                         // total number of received NAK packets
+   int m_iRcvNoUnitTotal;                       // total number of packets discarded for lack of a receive unit
+   int m_iRcvRecoveredTotal;                    // total number of lost packets rebuilt from parity
+   int m_iSndShedTotal;                         // total number of chunks of optional layers shed
+   int64_t m_llRcvPartialTotal;                 // total number of frames delivered without some optional layers
+   int m_iCtrlSavedTotal;                       // total number of control packets saved by adaptive acknowledgement
+   int m_iHSRecvTotal;                          // total number of handshakes handled by the listener
+   int m_iHSDropTotal;                          // total number of handshakes dropped from the full accept queue
+   int m_iHSRejectTotal;                        // total number of handshakes rejected
+   int m_iAcceptTotal;                          // total number of connections accepted
    int64_t m_llSndDurationTotal;		// total real time for sending
 
    uint64_t m_LastSampleTime;                   // last performance sample time
@@ -433,17 +798,39 @@ private: // Trace
    int m_iRecvACK;                              // number of ACKs received in the last trace interval
    int m_iSentNAK;                              // number of NAKs sent in the last trace interval
    int m_iRecvNAK;                              // number of NAKs received in the last trace interval
+   int m_iTraceRcvNoUnit;                       // number of packets discarded for lack of a receive unit in the last trace interval
+   int m_iTraceRcvRecovered;                    // number of lost packets rebuilt from parity in the last trace interval
+   int m_iTraceSndShed;                         // number of chunks of optional layers shed in the last trace interval
+   int m_iTraceRcvPartial;                      // number of frames delivered without some optional layers in the last trace interval
+   int m_iTraceCtrlSaved;                       // number of control packets saved by adaptive acknowledgement in the last trace interval
+   int m_iTraceHSRecv;                          // handshakes handled since the last sampleAccept()
+   int m_iTraceHSDrop;                          // handshakes dropped from the full accept queue since the last sampleAccept()
+   int m_iTraceHSReject;                        // handshakes rejected since the last sampleAccept()
+   int m_iTraceAccept;                          // connections accepted since the last sampleAccept()
+   int64_t m_llTraceHSWait;                     // total time the handshakes waited in the accept queue, in microseconds
+   int64_t m_llMaxHSWait;                       // longest wait of a handshake in the accept queue, in microseconds
+   uint64_t m_LastAcceptSampleTime;             // last sampleAccept() time
    int64_t m_llSndDuration;			// real time for sending
+   uint64_t m_llTracePacingError;               // total deviation of paced packets from their schedule in the last trace interval, in CCs
+   int64_t m_llTracePacingCount;                // number of paced packets in the last trace interval
+   uint64_t m_ullMaxPacingError;                // largest deviation of a paced packet from its schedule in the last trace interval, in CCs
    int64_t m_llSndDurationCounter;		// timers to record the sending duration
 
+   int64_t m_llFrameSentTotal;                  // VR Frame Awareness: total number of frames passed to sendframe
+   int m_iTraceFrameSent;                       // number of frames passed to sendframe in the last trace interval
+   CFrameStats m_SndFrameStats;                 // sent frames, by the time from sendframe to the acknowledgement of the whole frame
+   CFrameStats m_RcvFrameStats;                 // received frames, by the time from their first transmission to their completion
+
 private: // Timers
    uint64_t m_ullCPUFrequency;                  // CPU clock frequency, used for Timer, ticks per microsecond
 
    static const int m_iSYNInterval;             // Periodical Rate Control Interval, 10000 microsecond
    static const int m_iSelfClockInterval;       // ACK interval for self-clocking
+   static const int m_iMinPathSample;           // number of packets a connection sends before its rate is cached
 
    uint64_t m_ullNextACKTime;			// Next ACK time, in CPU clock cycles, same below
    uint64_t m_ullNextNAKTime;			// Next NAK time
+   uint64_t m_ullNextFrameCheckTime;		// VR Frame Awareness: next check for frames that cannot make their deadlines
 
    volatile uint64_t m_ullSYNInt;		// SYN interval
    volatile uint64_t m_ullACKInt;		// ACK interval
@@ -455,6 +842,11 @@ private: // Timers
 
    int m_iPktCount;				// packet counter for ACK
    int m_iLightACKCount;			// light ACK counter
+   int m_iLightACKInterval;			// packets per light ACK, m_iSelfClockInterval unless adaptive
+   uint64_t m_ullFixedNextACKTime;		// next ACK time of the fixed schedule, which adaptive acknowledgement is measured against
+   int m_iFixedPktCount;			// packet counter for ACK of the fixed schedule
+   int32_t m_iFixedLastAck;			// last ACK of the fixed schedule
+   bool m_bRcvMidFrame;				// VR Frame Awareness: the newest packet received is not the last chunk of its frame
 
    uint64_t m_ullTargetTime;			// scheduled time of next packet sending
 
@@ -57,11 +57,13 @@ CEPoll::CEPoll():
 m_iIDSeed(0)
 {
    CGuard::createMutex(m_EPollLock);
+   CGuard::createCond(m_EPollCond);
 }
 
 CEPoll::~CEPoll()
 {
    CGuard::releaseMutex(m_EPollLock);
+   CGuard::releaseCond(m_EPollCond);
 }
 
 int CEPoll::create()
@@ -104,6 +106,11 @@ int CEPoll::add_usock(const int eid, const UDTSOCKET& u, const int* events)
    if (!events || (*events & UDT_EPOLL_OUT))
       p->second.m_sUDTSocksOut.insert(u);
 
+   CEPollWatch& w = p->second.m_mWatch[u];
+   w.m_iID = u;
+   w.m_iEvents |= events ? *events : (UDT_EPOLL_IN | UDT_EPOLL_OUT);
+   p->second.m_vReady.reserve(p->second.m_mWatch.size());
+
    return 0;
 }
 
@@ -154,6 +161,14 @@ int CEPoll::remove_usock(const int eid, const UDTSOCKET& u)
    p->second.m_sUDTSocksOut.erase(u);
    p->second.m_sUDTSocksEx.erase(u);
 
+   map<UDTSOCKET, CEPollWatch>::iterator w = p->second.m_mWatch.find(u);
+   if (w != p->second.m_mWatch.end())
+   {
+      if (0 != w->second.m_iPending)
+         p->second.m_vReady.erase(find(p->second.m_vReady.begin(), p->second.m_vReady.end(), &w->second));
+      p->second.m_mWatch.erase(w);
+   }
+
    return 0;
 }
 
@@ -300,6 +315,64 @@ int CEPoll::wait(const int eid, set<UDTSOCKET>* readfds, set<UDTSOCKET>* writefd
    return 0;
 }
 
+int CEPoll::wait2(const int eid, UDT_EPOLL_EVENT* events, int max, int64_t msTimeOut)
+{
+   if ((NULL == events) || (max <= 0))
+      throw CUDTException(5, 3, 0);
+
+   uint64_t exptime = CTimer::getTime() + msTimeOut * 1000ULL;
+
+   CGuard pg(m_EPollLock);
+
+   while (true)
+   {
+      map<int, CEPollDesc>::iterator p = m_mPolls.find(eid);
+      if (p == m_mPolls.end())
+         throw CUDTException(5, 13);
+
+      // no socket is being monitored, this may be a deadlock
+      if (p->second.m_mWatch.empty() && (msTimeOut < 0))
+         throw CUDTException(5, 3);
+
+      vector<CEPollWatch*>& ready = p->second.m_vReady;
+      if (!ready.empty())
+      {
+         int num = (max < int(ready.size())) ? max : int(ready.size());
+         for (int i = 0; i < num; ++ i)
+         {
+            events[i].fd = ready[i]->m_iID;
+            events[i].events = ready[i]->m_iPending;
+            ready[i]->m_iPending = 0;
+         }
+         ready.erase(ready.begin(), ready.begin() + num);
+
+         return num;
+      }
+
+      if ((msTimeOut >= 0) && (CTimer::getTime() >= exptime))
+         throw CUDTException(6, 3, 0);
+
+      // update_events signals under the same lock, so no event is missed between the check and the wait
+      #ifndef WIN32
+         if (msTimeOut < 0)
+            pthread_cond_wait(&m_EPollCond, &m_EPollLock);
+         else
+         {
+            timespec locktime;
+            locktime.tv_sec = exptime / 1000000;
+            locktime.tv_nsec = (exptime % 1000000) * 1000;
+            pthread_cond_timedwait(&m_EPollCond, &m_EPollLock, &locktime);
+         }
+      #else
+         CGuard::leaveCS(m_EPollLock);
+         WaitForSingleObject(m_EPollCond, (msTimeOut < 0) ? INFINITE : DWORD((exptime - CTimer::getTime()) / 1000 + 1));
+         CGuard::enterCS(m_EPollLock);
+      #endif
+   }
+
+   return 0;
+}
+
 int CEPoll::release(const int eid)
 {
    CGuard pg(m_EPollLock);
@@ -315,6 +388,13 @@ int CEPoll::release(const int eid)
 
    m_mPolls.erase(i);
 
+   // threads waiting on the epoll return an error
+   #ifndef WIN32
+      pthread_cond_broadcast(&m_EPollCond);
+   #else
+      SetEvent(m_EPollCond);
+   #endif
+
    return 0;
 }
 
@@ -357,6 +437,9 @@ int CEPoll::update_events(const UDTSOCKET& uid, std::set<int>& eids, int events,
             update_epoll_sets(uid, p->second.m_sUDTSocksOut, p->second.m_sUDTWrites, enable);
          if ((events & UDT_EPOLL_ERR) != 0)
             update_epoll_sets(uid, p->second.m_sUDTSocksEx, p->second.m_sUDTExcepts, enable);
+
+         if (enable)
+            signal_edge(uid, p->second, events);
       }
    }
 
@@ -365,3 +448,27 @@ int CEPoll::update_events(const UDTSOCKET& uid, std::set<int>& eids, int events,
 
    return 0;
 }
+
+void CEPoll::signal_edge(const UDTSOCKET& uid, CEPollDesc& desc, int events)
+{
+   map<UDTSOCKET, CEPollWatch>::iterator w = desc.m_mWatch.find(uid);
+   if (w == desc.m_mWatch.end())
+      return;
+
+   events &= w->second.m_iEvents | UDT_EPOLL_ERR;
+   if (0 == events)
+      return;
+
+   // a socket is queued once, later events are merged until wait2 reports it
+   if (0 == w->second.m_iPending)
+   {
+      desc.m_vReady.push_back(&w->second);
+
+      #ifndef WIN32
+         pthread_cond_broadcast(&m_EPollCond);
+      #else
+         SetEvent(m_EPollCond);
+      #endif
+   }
+   w->second.m_iPending |= events;
+}
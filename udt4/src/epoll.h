@@ -44,9 +44,17 @@ written by
 
 #include <map>
 #include <set>
+#include <vector>
 #include "udt.h"
 
 
+struct CEPollWatch
+{
+   UDTSOCKET m_iID;                          // UDT socket ID
+   int m_iEvents;                            // events to watch, exceptions are always reported
+   int m_iPending;                           // edge-triggered events not reported by wait2 yet
+};
+
 struct CEPollDesc
 {
    int m_iID;                                // epoll ID
@@ -60,6 +68,10 @@ struct CEPollDesc
    std::set<UDTSOCKET> m_sUDTWrites;         // UDT sockets ready for write
    std::set<UDTSOCKET> m_sUDTReads;          // UDT sockets ready for read
    std::set<UDTSOCKET> m_sUDTExcepts;        // UDT sockets with exceptions (connection broken, etc.)
+
+   std::map<UDTSOCKET, CEPollWatch> m_mWatch;   // UDT sockets watched by wait2
+   std::vector<CEPollWatch*> m_vReady;          // watched sockets with pending events, in the order of their first event;
+                                                // its capacity covers all watched sockets, so that events never allocate
 };
 
 class CEPoll
@@ -138,6 +150,19 @@ public: // for CUDTUnited API
 
    int wait(const int eid, std::set<UDTSOCKET>* readfds, std::set<UDTSOCKET>* writefds, int64_t msTimeOut, std::set<SYSSOCKET>* lrfds, std::set<SYSSOCKET>* lwfds);
 
+      // Functionality:
+      //    wait for edge-triggered events of UDT sockets, or timeout: a socket is reported once each time the
+      //    library signals an event for it, e.g., new data to read, and not again until the next signal.
+      // Parameters:
+      //    0) [in] eid: EPoll ID.
+      //    1) [out] events: array for the events, one entry per socket.
+      //    2) [in] max: length of the array; sockets that do not fit are reported by the next call.
+      //    3) [in] msTimeOut: timeout threshold, in milliseconds, -1 to wait forever.
+      // Returned value:
+      //    number of entries filled in the array.
+
+   int wait2(const int eid, UDT_EPOLL_EVENT* events, int max, int64_t msTimeOut);
+
       // Functionality:
       //    close and release an EPoll.
       // Parameters:
@@ -161,12 +186,25 @@ public: // for CUDT to acknowledge IO status
 
    int update_events(const UDTSOCKET& uid, std::set<int>& eids, int events, bool enable);
 
+private:
+      // Functionality:
+      //    Queue edge-triggered events of a UDT socket for wait2 and wake up its waiters, called with m_EPollLock held.
+      // Parameters:
+      //    0) [in] uid: UDT socket ID.
+      //    1) [in, out] desc: the epoll.
+      //    2) [in] events: Combination of events that have happened
+      // Returned value:
+      //    None.
+
+   void signal_edge(const UDTSOCKET& uid, CEPollDesc& desc, int events);
+
 private:
    int m_iIDSeed;                            // seed to generate a new ID
    pthread_mutex_t m_SeedLock;
 
    std::map<int, CEPollDesc> m_mPolls;       // all epolls
    pthread_mutex_t m_EPollLock;
+   pthread_cond_t m_EPollCond;               // signaled when wait2 has events to report, used with m_EPollLock
 };
 
 
@@ -0,0 +1,144 @@
+/*****************************************************************************
+Copyright (c) 2001 - 2011, The Board of Trustees of the University of Illinois.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+* Redistributions of source code must retain the above
+  copyright notice, this list of conditions and the
+  following disclaimer.
+
+* Redistributions in binary form must reproduce the
+  above copyright notice, this list of conditions
+  and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the University of Illinois
+  nor the names of its contributors may be used to
+  endorse or promote products derived from this
+  software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cstring>
+#include "common.h"
+#include "fanout.h"
+
+using namespace std;
+
+CFanout::CFanout():
+m_iIDSeed(0)
+{
+   CGuard::createMutex(m_GroupLock);
+}
+
+CFanout::~CFanout()
+{
+   CGuard::releaseMutex(m_GroupLock);
+}
+
+int CFanout::create()
+{
+   CGuard gg(m_GroupLock);
+
+   if (++ m_iIDSeed >= 0x7FFFFFFF)
+      m_iIDSeed = 0;
+
+   CFanoutGroup group;
+   group.m_iID = m_iIDSeed;
+   group.m_StartTime = CTimer::getTime();
+   m_mGroups[group.m_iID] = group;
+
+   return group.m_iID;
+}
+
+void CFanout::add(const int gid, const UDTSOCKET u)
+{
+   CGuard gg(m_GroupLock);
+
+   map<int, CFanoutGroup>::iterator i = m_mGroups.find(gid);
+   if (i == m_mGroups.end())
+      throw CUDTException(5, 16);
+
+   i->second.m_sSubscribers.insert(u);
+}
+
+void CFanout::remove(const int gid, const UDTSOCKET u)
+{
+   CGuard gg(m_GroupLock);
+
+   map<int, CFanoutGroup>::iterator i = m_mGroups.find(gid);
+   if (i == m_mGroups.end())
+      throw CUDTException(5, 16);
+
+   i->second.m_sSubscribers.erase(u);
+}
+
+void CFanout::getSubscribers(const int gid, vector<UDTSOCKET>& subscribers, uint64_t& start)
+{
+   CGuard gg(m_GroupLock);
+
+   map<int, CFanoutGroup>::iterator i = m_mGroups.find(gid);
+   if (i == m_mGroups.end())
+      throw CUDTException(5, 16);
+
+   subscribers.assign(i->second.m_sSubscribers.begin(), i->second.m_sSubscribers.end());
+   start = i->second.m_StartTime;
+}
+
+void CFanout::release(const int gid)
+{
+   CGuard gg(m_GroupLock);
+
+   if (0 == m_mGroups.erase(gid))
+      throw CUDTException(5, 16);
+}
+
+CSharedFrame* CFanout::newFrame(const char* data, int len)
+{
+   CSharedFrame* frame = NULL;
+   try
+   {
+      frame = new CSharedFrame;
+      frame->m_pcData = new char[len];
+   }
+   catch (...)
+   {
+      delete frame;
+      throw CUDTException(3, 2, 0);
+   }
+
+   memcpy(frame->m_pcData, data, len);
+   frame->m_iLength = len;
+   frame->m_iRefCount = 1;
+
+   return frame;
+}
+
+void CFanout::addRef(CSharedFrame* frame)
+{
+   CGuard::atomicAdd(frame->m_iRefCount, 1);
+}
+
+void CFanout::releaseFrame(UDTSOCKET, const char*, int, void* context)
+{
+   CSharedFrame* frame = (CSharedFrame*)context;
+   if (CGuard::atomicAdd(frame->m_iRefCount, -1) > 0)
+      return;
+
+   delete [] frame->m_pcData;
+   delete frame;
+}
@@ -0,0 +1,165 @@
+/*****************************************************************************
+Copyright (c) 2001 - 2011, The Board of Trustees of the University of Illinois.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+* Redistributions of source code must retain the above
+  copyright notice, this list of conditions and the
+  following disclaimer.
+
+* Redistributions in binary form must reproduce the
+  above copyright notice, this list of conditions
+  and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the University of Illinois
+  nor the names of its contributors may be used to
+  endorse or promote products derived from this
+  software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#ifndef __UDT_FANOUT_H__
+#define __UDT_FANOUT_H__
+
+
+#include <map>
+#include <set>
+#include <vector>
+#include "udt.h"
+
+
+// A frame sent to a fan-out group: a single copy of the data that the send buffers of all subscribers reference
+// (CSndBuffer::addFrameRef). It is freed once the last of them lets it go: when the subscriber's peer has
+// acknowledged it, including after a drop at the frame deadline, or when the subscriber is closed.
+struct CSharedFrame
+{
+   char* m_pcData;                      // the frame data
+   int m_iLength;                       // size of the frame
+   volatile int m_iRefCount;            // one per subscriber buffer holding the frame, and one for the sender while it is queued
+};
+
+struct CFanoutGroup
+{
+   int m_iID;                           // group ID
+   uint64_t m_StartTime;                // time base of the frame deadlines given to the group
+   std::set<UDTSOCKET> m_sSubscribers;  // subscriber sockets
+};
+
+class CFanout
+{
+public:
+   CFanout();
+   ~CFanout();
+
+public: // for CUDTUnited API
+
+      // Functionality:
+      //    create a new fan-out group.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    new group ID.
+
+   int create();
+
+      // Functionality:
+      //    add a subscriber to a group.
+      // Parameters:
+      //    0) [in] gid: group ID.
+      //    1) [in] u: UDT socket ID.
+      // Returned value:
+      //    None.
+
+   void add(const int gid, const UDTSOCKET u);
+
+      // Functionality:
+      //    remove a subscriber from a group; the frames its buffer holds are released as it sends them.
+      // Parameters:
+      //    0) [in] gid: group ID.
+      //    1) [in] u: UDT socket ID.
+      // Returned value:
+      //    None.
+
+   void remove(const int gid, const UDTSOCKET u);
+
+      // Functionality:
+      //    read the subscribers of a group and its time base.
+      // Parameters:
+      //    0) [in] gid: group ID.
+      //    1) [out] subscribers: the subscriber sockets.
+      //    2) [out] start: time base of the frame deadlines, in microseconds of CTimer::getTime().
+      // Returned value:
+      //    None.
+
+   void getSubscribers(const int gid, std::vector<UDTSOCKET>& subscribers, uint64_t& start);
+
+      // Functionality:
+      //    close a group. The sockets stay open, and so do the frames they are still sending.
+      // Parameters:
+      //    0) [in] gid: group ID.
+      // Returned value:
+      //    None.
+
+   void release(const int gid);
+
+public:
+
+      // Functionality:
+      //    copy a frame into a new shared frame, holding the sender's reference.
+      // Parameters:
+      //    0) [in] data: the frame data.
+      //    1) [in] len: size of the frame.
+      // Returned value:
+      //    the shared frame.
+
+   static CSharedFrame* newFrame(const char* data, int len);
+
+      // Functionality:
+      //    take one more reference to a shared frame.
+      // Parameters:
+      //    0) [in] frame: the shared frame.
+      // Returned value:
+      //    None.
+
+   static void addRef(CSharedFrame* frame);
+
+      // Functionality:
+      //    drop a reference to a shared frame, freeing it with the last one; a UDTFRAMEDONE callback.
+      // Parameters:
+      //    0) [in] u: the subscriber that lets the frame go, unused.
+      //    1) [in] data: the frame data, unused.
+      //    2) [in] len: size of the frame, unused.
+      //    3) [in] context: the shared frame.
+      // Returned value:
+      //    None.
+
+   static void releaseFrame(UDTSOCKET u, const char* data, int len, void* context);
+
+private:
+   int m_iIDSeed;                       // seed to generate a new unique group ID
+   pthread_mutex_t m_GroupLock;         // protects m_mGroups
+
+   std::map<int, CFanoutGroup> m_mGroups;
+
+private:
+   CFanout(const CFanout&);
+   CFanout& operator=(const CFanout&);
+};
+
+
+#endif
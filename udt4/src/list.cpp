@@ -38,21 +38,187 @@ written by
    Yunhong Gu, last updated 01/22/2011
 *****************************************************************************/
 
+#include <cstring>
 #include "list.h"
 
+#ifdef WIN32
+   #include <intrin.h>
+#endif
+
+// index of the highest and the lowest set bit of a non-zero word
+static inline int hibit(uint64_t x)
+{
+   #ifndef WIN32
+      return 63 - __builtin_clzll(x);
+   #else
+      unsigned long i;
+      if (_BitScanReverse(&i, (unsigned long)(x >> 32)))
+         return int(i) + 32;
+      _BitScanReverse(&i, (unsigned long)x);
+      return int(i);
+   #endif
+}
+
+static inline int lobit(uint64_t x)
+{
+   #ifndef WIN32
+      return __builtin_ctzll(x);
+   #else
+      unsigned long i;
+      if (_BitScanForward(&i, (unsigned long)x))
+         return int(i);
+      _BitScanForward(&i, (unsigned long)(x >> 32));
+      return int(i) + 32;
+   #endif
+}
+
+// bits [0, b] and [b, 63] of a word
+static inline uint64_t lowmask(int b)
+{
+   return (63 == b) ? ~0ULL : ((1ULL << (b + 1)) - 1);
+}
+
+static inline uint64_t highmask(int b)
+{
+   return ~0ULL << b;
+}
+
+CLossNodeMap::CLossNodeMap(int size):
+m_pWord(NULL),
+m_pSummary(NULL),
+m_iWords((size + 63) >> 6),
+m_iSummaries((((size + 63) >> 6) + 63) >> 6),
+m_iSize(size)
+{
+   m_pWord = new uint64_t [m_iWords];
+   m_pSummary = new uint64_t [m_iSummaries];
+
+   memset(m_pWord, 0, m_iWords * sizeof(uint64_t));
+   memset(m_pSummary, 0, m_iSummaries * sizeof(uint64_t));
+}
+
+CLossNodeMap::~CLossNodeMap()
+{
+   delete [] m_pWord;
+   delete [] m_pSummary;
+}
+
+void CLossNodeMap::set(int pos)
+{
+   int w = pos >> 6;
+   m_pWord[w] |= 1ULL << (pos & 63);
+   m_pSummary[w >> 6] |= 1ULL << (w & 63);
+}
+
+void CLossNodeMap::clear(int pos)
+{
+   int w = pos >> 6;
+   m_pWord[w] &= ~(1ULL << (pos & 63));
+   if (0 == m_pWord[w])
+      m_pSummary[w >> 6] &= ~(1ULL << (w & 63));
+}
+
+bool CLossNodeMap::test(int pos) const
+{
+   return 0 != (m_pWord[pos >> 6] & (1ULL << (pos & 63)));
+}
+
+int CLossNodeMap::prior(int loc, int head) const
+{
+   if (loc >= head)
+      return prev(loc, head);
+
+   // the list wraps around the end of the array
+   int pos = prev(loc, 0);
+   if (-1 == pos)
+      pos = prev(m_iSize - 1, head);
+
+   return pos;
+}
+
+int CLossNodeMap::after(int loc, int head) const
+{
+   if (loc < head)
+      return (loc + 1 < head) ? next(loc + 1, head - 1) : -1;
+
+   int pos = (loc + 1 < m_iSize) ? next(loc + 1, m_iSize - 1) : -1;
+   if ((-1 == pos) && (head > 0))
+      pos = next(0, head - 1);
+
+   return pos;
+}
+
+int CLossNodeMap::prev(int pos, int lo) const
+{
+   int w = pos >> 6;
+   uint64_t bits = m_pWord[w] & lowmask(pos & 63);
+
+   if (0 == bits)
+   {
+      // find the last non-empty word before w from the summary
+      if (0 == w)
+         return -1;
+
+      int s = (w - 1) >> 6;
+      uint64_t sbits = m_pSummary[s] & lowmask((w - 1) & 63);
+      while (0 == sbits)
+      {
+         if ((0 == s) || ((s << 12) <= lo))
+            return -1;
+         sbits = m_pSummary[-- s];
+      }
+
+      w = (s << 6) + hibit(sbits);
+      bits = m_pWord[w];
+   }
+
+   pos = (w << 6) + hibit(bits);
+
+   return (pos >= lo) ? pos : -1;
+}
+
+int CLossNodeMap::next(int pos, int hi) const
+{
+   int w = pos >> 6;
+   uint64_t bits = m_pWord[w] & highmask(pos & 63);
+
+   if (0 == bits)
+   {
+      // find the first non-empty word after w from the summary
+      if (w + 1 == m_iWords)
+         return -1;
+
+      int s = (w + 1) >> 6;
+      uint64_t sbits = m_pSummary[s] & highmask((w + 1) & 63);
+      while (0 == sbits)
+      {
+         if ((s + 1 == m_iSummaries) || (((s + 1) << 12) > hi))
+            return -1;
+         sbits = m_pSummary[++ s];
+      }
+
+      w = (s << 6) + lobit(sbits);
+      bits = m_pWord[w];
+   }
+
+   pos = (w << 6) + lobit(bits);
+
+   return (pos <= hi) ? pos : -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 CSndLossList::CSndLossList(int size):
 m_piData1(NULL),
 m_piData2(NULL),
-m_piNext(NULL),
+m_Nodes(size),
 m_iHead(-1),
 m_iLength(0),
 m_iSize(size),
-m_iLastInsertPos(-1),
 m_ListLock()
 {
    m_piData1 = new int32_t [m_iSize];
    m_piData2 = new int32_t [m_iSize];
-   m_piNext = new int [m_iSize];
 
    // -1 means there is no data in the node
    for (int i = 0; i < size; ++ i)
@@ -73,7 +239,6 @@ CSndLossList::~CSndLossList()
 {
    delete [] m_piData1;
    delete [] m_piData2;
-   delete [] m_piNext;
 
    #ifndef WIN32
       pthread_mutex_destroy(&m_ListLock);
@@ -82,6 +247,30 @@ CSndLossList::~CSndLossList()
    #endif
 }
 
+int CSndLossList::locate(int32_t seqno) const
+{
+   return (m_iHead + CSeqNo::seqoff(m_piData1[m_iHead], seqno) + m_iSize) % m_iSize;
+}
+
+int32_t CSndLossList::lastSeq(int loc) const
+{
+   return (-1 == m_piData2[loc]) ? m_piData1[loc] : m_piData2[loc];
+}
+
+void CSndLossList::setNode(int loc, int32_t seqno1, int32_t seqno2)
+{
+   m_piData1[loc] = seqno1;
+   m_piData2[loc] = (seqno2 == seqno1) ? -1 : seqno2;
+   m_Nodes.set(loc);
+}
+
+void CSndLossList::clearNode(int loc)
+{
+   m_piData1[loc] = -1;
+   m_piData2[loc] = -1;
+   m_Nodes.clear(loc);
+}
+
 int CSndLossList::insert(int32_t seqno1, int32_t seqno2)
 {
    CGuard listguard(m_ListLock);
@@ -89,16 +278,9 @@ int CSndLossList::insert(int32_t seqno1, int32_t seqno2)
    if (0 == m_iLength)
    {
       // insert data into an empty list
-
       m_iHead = 0;
-      m_piData1[m_iHead] = seqno1;
-      if (seqno2 != seqno1)
-         m_piData2[m_iHead] = seqno2;
-
-      m_piNext[m_iHead] = -1;
-      m_iLastInsertPos = m_iHead;
-
-      m_iLength += CSeqNo::seqlen(seqno1, seqno2);
+      setNode(m_iHead, seqno1, seqno2);
+      m_iLength = CSeqNo::seqlen(seqno1, seqno2);
 
       return m_iLength;
    }
@@ -110,147 +292,55 @@ int CSndLossList::insert(int32_t seqno1, int32_t seqno2)
 
    if (offset < 0)
    {
-      // Insert data prior to the head pointer
-
-      m_piData1[loc] = seqno1;
-      if (seqno2 != seqno1)
-         m_piData2[loc] = seqno2;
-
-      // new node becomes head
-      m_piNext[loc] = m_iHead;
+      // insert data prior to the head pointer, the new node becomes head
+      setNode(loc, seqno1, seqno2);
       m_iHead = loc;
-      m_iLastInsertPos = loc;
 
       m_iLength += CSeqNo::seqlen(seqno1, seqno2);
    }
-   else if (offset > 0)
+   else
    {
-      if (seqno1 == m_piData1[loc])
-      {
-         m_iLastInsertPos = loc;
+      int i = m_Nodes.prior(loc, m_iHead);
+      int32_t end = lastSeq(i);
 
-         // first seqno is equivlent, compare the second
-         if (-1 == m_piData2[loc])
-         {
-            if (seqno2 != seqno1)
-            {
-               m_iLength += CSeqNo::seqlen(seqno1, seqno2) - 1;
-               m_piData2[loc] = seqno2;
-            }
-         }
-         else if (CSeqNo::seqcmp(seqno2, m_piData2[loc]) > 0)
-         {
-            // new seq pair is longer than old pair, e.g., insert [3, 7] to [3, 5], becomes [3, 7]
-            m_iLength += CSeqNo::seqlen(m_piData2[loc], seqno2) - 1;
-            m_piData2[loc] = seqno2;
-         }
-         else
-            // Do nothing if it is already there
-            return 0;
-      }
-      else
+      if (CSeqNo::seqcmp(CSeqNo::incseq(end), seqno1) < 0)
       {
-         // searching the prior node
-         int i;
-         if ((-1 != m_iLastInsertPos) && (CSeqNo::seqcmp(m_piData1[m_iLastInsertPos], seqno1) < 0))
-            i = m_iLastInsertPos;
-         else
-            i = m_iHead;
-
-         while ((-1 != m_piNext[i]) && (CSeqNo::seqcmp(m_piData1[m_piNext[i]], seqno1) < 0))
-            i = m_piNext[i];
-
-         if ((-1 == m_piData2[i]) || (CSeqNo::seqcmp(m_piData2[i], seqno1) < 0))
-         {
-            m_iLastInsertPos = loc;
-
-            // no overlap, create new node
-            m_piData1[loc] = seqno1;
-            if (seqno2 != seqno1)
-               m_piData2[loc] = seqno2;
-
-            m_piNext[loc] = m_piNext[i];
-            m_piNext[i] = loc;
-
-            m_iLength += CSeqNo::seqlen(seqno1, seqno2);
-         }
-         else
-         {
-            m_iLastInsertPos = i;
-
-            // overlap, coalesce with prior node, insert(3, 7) to [2, 5], ... becomes [2, 7]
-            if (CSeqNo::seqcmp(m_piData2[i], seqno2) < 0)
-            {
-               m_iLength += CSeqNo::seqlen(m_piData2[i], seqno2) - 1;
-               m_piData2[i] = seqno2;
-
-               loc = i;
-            }
-            else
-               return 0;
-         }
+         // no overlap, create new node
+         setNode(loc, seqno1, seqno2);
+         m_iLength += CSeqNo::seqlen(seqno1, seqno2);
       }
-   }
-   else
-   {
-      m_iLastInsertPos = m_iHead;
-
-      // insert to head node
-      if (seqno2 != seqno1)
+      else if (CSeqNo::seqcmp(seqno2, end) > 0)
       {
-         if (-1 == m_piData2[loc])
-         {
-            m_iLength += CSeqNo::seqlen(seqno1, seqno2) - 1;
-            m_piData2[loc] = seqno2;
-         }
-         else if (CSeqNo::seqcmp(seqno2, m_piData2[loc]) > 0)
-         {
-            m_iLength += CSeqNo::seqlen(m_piData2[loc], seqno2) - 1;
-            m_piData2[loc] = seqno2;
-         }
-         else 
-            return 0;
+         // overlap or adjacent, extend the prior node, insert(3, 7) to [2, 5] becomes [2, 7]
+         m_iLength += CSeqNo::seqoff(end, seqno2);
+         setNode(i, m_piData1[i], seqno2);
+         loc = i;
       }
       else
+         // Do nothing if it is already there
          return 0;
    }
 
-   // coalesce with next node. E.g., [3, 7], ..., [6, 9] becomes [3, 9] 
-   while ((-1 != m_piNext[loc]) && (-1 != m_piData2[loc]))
+   // coalesce with next nodes. E.g., [3, 7], ..., [6, 9] becomes [3, 9]
+   int32_t end = lastSeq(loc);
+   int i;
+   while ((-1 != (i = m_Nodes.after(loc, m_iHead))) && (CSeqNo::seqcmp(m_piData1[i], CSeqNo::incseq(end)) <= 0))
    {
-      int i = m_piNext[loc];
-
-      if (CSeqNo::seqcmp(m_piData1[i], CSeqNo::incseq(m_piData2[loc])) <= 0)
+      int32_t next = lastSeq(i);
+      if (CSeqNo::seqcmp(next, end) > 0)
       {
-         // coalesce if there is overlap
-         if (-1 != m_piData2[i])
-         {
-            if (CSeqNo::seqcmp(m_piData2[i], m_piData2[loc]) > 0)
-            {
-               if (CSeqNo::seqcmp(m_piData2[loc], m_piData1[i]) >= 0)
-                  m_iLength -= CSeqNo::seqlen(m_piData1[i], m_piData2[loc]);
-
-               m_piData2[loc] = m_piData2[i];
-            }
-            else
-               m_iLength -= CSeqNo::seqlen(m_piData1[i], m_piData2[i]);
-         }
-         else
-         {
-            if (m_piData1[i] == CSeqNo::incseq(m_piData2[loc]))
-               m_piData2[loc] = m_piData1[i];
-            else
-               m_iLength --;
-         }
-
-         m_piData1[i] = -1;
-         m_piData2[i] = -1;
-         m_piNext[loc] = m_piNext[i];
+         if (CSeqNo::seqcmp(end, m_piData1[i]) >= 0)
+            m_iLength -= CSeqNo::seqlen(m_piData1[i], end);
+         end = next;
       }
       else
-         break;
+         m_iLength -= CSeqNo::seqlen(m_piData1[i], next);
+
+      clearNode(i);
    }
 
+   setNode(loc, m_piData1[loc], end);
+
    return m_iLength - origlen;
 }
 
@@ -263,107 +353,116 @@ void CSndLossList::remove(int32_t seqno)
 
    // Remove all from the head pointer to a node with a larger seq. no. or the list is empty
    int offset = CSeqNo::seqoff(m_piData1[m_iHead], seqno);
-   int loc = (m_iHead + offset + m_iSize) % m_iSize;
+   if (offset < 0)
+      return;
 
-   if (0 == offset)
+   int last = m_Nodes.prior((m_iHead - 1 + m_iSize) % m_iSize, m_iHead);
+   if ((offset >= m_iSize) || (CSeqNo::seqcmp(seqno, lastSeq(last)) >= 0))
    {
-      // It is the head. Remove the head and point to the next node
-      loc = (loc + 1) % m_iSize;
-
-      if (-1 == m_piData2[m_iHead])
-         loc = m_piNext[m_iHead];
-      else
+      // everything goes
+      for (int i = m_iHead; -1 != i; )
       {
-         m_piData1[loc] = CSeqNo::incseq(seqno);
-         if (CSeqNo::seqcmp(m_piData2[m_iHead], CSeqNo::incseq(seqno)) > 0)
-            m_piData2[loc] = m_piData2[m_iHead];
-
-         m_piData2[m_iHead] = -1;
-
-         m_piNext[loc] = m_piNext[m_iHead];
+         int next = m_Nodes.after(i, m_iHead);
+         clearNode(i);
+         i = next;
       }
 
-      m_piData1[m_iHead] = -1;
+      m_iHead = -1;
+      m_iLength = 0;
 
-      if (m_iLastInsertPos == m_iHead)
-         m_iLastInsertPos = -1;
+      return;
+   }
 
-      m_iHead = loc;
+   int loc = (m_iHead + offset) % m_iSize;
+   int target = m_Nodes.prior(loc, m_iHead);
 
-      m_iLength --;
+   // Remove all nodes prior to the one holding seqno
+   while (m_iHead != target)
+   {
+      int next = m_Nodes.after(m_iHead, m_iHead);
+      m_iLength -= CSeqNo::seqlen(m_piData1[m_iHead], lastSeq(m_iHead));
+      clearNode(m_iHead);
+      m_iHead = next;
    }
-   else if (offset > 0)
+
+   int32_t end = lastSeq(target);
+   if (CSeqNo::seqcmp(end, seqno) > 0)
    {
-      int h = m_iHead;
+      // remove part of the node, e.g., [3, 7] becomes [], [5, 7] after remove(4)
+      m_iLength -= CSeqNo::seqlen(m_piData1[target], seqno);
+      clearNode(target);
+      m_iHead = (loc + 1) % m_iSize;
+      setNode(m_iHead, CSeqNo::incseq(seqno), end);
+   }
+   else
+   {
+      int next = m_Nodes.after(target, m_iHead);
+      m_iLength -= CSeqNo::seqlen(m_piData1[target], end);
+      clearNode(target);
+      m_iHead = next;
+   }
+}
 
-      if (seqno == m_piData1[loc])
-      {
-         // target node is not empty, remove part/all of the seqno in the node.
-         int temp = loc;
-         loc = (loc + 1) % m_iSize;
+void CSndLossList::remove(int32_t seqno1, int32_t seqno2)
+{
+   {
+      CGuard listguard(m_ListLock);
 
-         if (-1 == m_piData2[temp])
-            m_iHead = m_piNext[temp];
-         else
-         {
-            // remove part, e.g., [3, 7] becomes [], [4, 7] after remove(3)
-            m_piData1[loc] = CSeqNo::incseq(seqno);
-            if (CSeqNo::seqcmp(m_piData2[temp], m_piData1[loc]) > 0)
-               m_piData2[loc] = m_piData2[temp];
-            m_iHead = loc;
-            m_piNext[loc] = m_piNext[temp];
-            m_piNext[temp] = loc;
-            m_piData2[temp] = -1;
-         }
-      }
-      else
+      if (0 == m_iLength)
+         return;
+
+      if (CSeqNo::seqcmp(seqno1, m_piData1[m_iHead]) > 0)
       {
-         // target node is empty, check prior node
-         int i = m_iHead;
-         while ((-1 != m_piNext[i]) && (CSeqNo::seqcmp(m_piData1[m_piNext[i]], seqno) < 0))
-            i = m_piNext[i];
+         // the head node is kept, so node positions relative to it remain valid
+         int last = m_Nodes.prior((m_iHead - 1 + m_iSize) % m_iSize, m_iHead);
+         if (CSeqNo::seqcmp(seqno1, lastSeq(last)) > 0)
+            return;
 
-         loc = (loc + 1) % m_iSize;
+         int i = m_Nodes.prior(locate(seqno1), m_iHead);
+         int32_t end = lastSeq(i);
 
-         if (-1 == m_piData2[i])
-            m_iHead = m_piNext[i];
-         else if (CSeqNo::seqcmp(m_piData2[i], seqno) > 0)
+         if ((m_piData1[i] != seqno1) && (CSeqNo::seqcmp(end, seqno1) >= 0))
          {
-            // remove part/all seqno in the prior node
-            m_piData1[loc] = CSeqNo::incseq(seqno);
-            if (CSeqNo::seqcmp(m_piData2[i], m_piData1[loc]) > 0)
-               m_piData2[loc] = m_piData2[i];
+            // remove the tail of the node, e.g., [3, 7] becomes [3, 4] after remove(5, 7)
+            setNode(i, m_piData1[i], CSeqNo::decseq(seqno1));
 
-            m_piData2[i] = seqno;
-
-            m_piNext[loc] = m_piNext[i];
-            m_piNext[i] = loc;
+            if (CSeqNo::seqcmp(end, seqno2) > 0)
+            {
+               // the part after seqno2 moves into a new node, e.g., remove(4, 5) from [3, 7] leaves [3, 3], [6, 7]
+               setNode(locate(CSeqNo::incseq(seqno2)), CSeqNo::incseq(seqno2), end);
+               m_iLength -= CSeqNo::seqlen(seqno1, seqno2);
+               return;
+            }
 
-            m_iHead = loc;
+            m_iLength -= CSeqNo::seqlen(seqno1, end);
          }
-         else
-            m_iHead = m_piNext[i];
-      }
 
-      // Remove all nodes prior to the new head
-      while (h != m_iHead)
-      {
-         if (m_piData2[h] != -1)
+         // remove the nodes starting within the range
+         i = (m_piData1[i] == seqno1) ? i : m_Nodes.after(i, m_iHead);
+         while ((-1 != i) && (CSeqNo::seqcmp(m_piData1[i], seqno2) <= 0))
          {
-            m_iLength -= CSeqNo::seqlen(m_piData1[h], m_piData2[h]);
-            m_piData2[h] = -1;
-         }
-         else
-            m_iLength --;
+            int next = m_Nodes.after(i, m_iHead);
+            end = lastSeq(i);
 
-         m_piData1[h] = -1;
+            if (CSeqNo::seqcmp(end, seqno2) > 0)
+            {
+               m_iLength -= CSeqNo::seqlen(m_piData1[i], seqno2);
+               clearNode(i);
+               setNode(locate(CSeqNo::incseq(seqno2)), CSeqNo::incseq(seqno2), end);
+               break;
+            }
 
-         if (m_iLastInsertPos == h)
-            m_iLastInsertPos = -1;
+            m_iLength -= CSeqNo::seqlen(m_piData1[i], end);
+            clearNode(i);
+            i = next;
+         }
 
-         h = m_piNext[h];
+         return;
       }
    }
+
+   // the range covers the head of the list, which is the same as removing everything up to seqno2
+   remove(seqno2);
 }
 
 int CSndLossList::getLossLength()
@@ -383,33 +482,23 @@ int32_t CSndLossList::getLostSeq()
    if (0 == m_iLength)
      return -1;
 
-   if (m_iLastInsertPos == m_iHead)
-      m_iLastInsertPos = -1;
-
    // return the first loss seq. no.
    int32_t seqno = m_piData1[m_iHead];
+   int32_t end = lastSeq(m_iHead);
 
-   // head moves to the next node
-   if (-1 == m_piData2[m_iHead])
+   if (end == seqno)
    {
       //[3, -1] becomes [], and head moves to next node in the list
-      m_piData1[m_iHead] = -1;
-      m_iHead = m_piNext[m_iHead];
+      int next = m_Nodes.after(m_iHead, m_iHead);
+      clearNode(m_iHead);
+      m_iHead = next;
    }
    else
    {
       // shift to next node, e.g., [3, 7] becomes [], [4, 7]
-      int loc = (m_iHead + 1) % m_iSize;
-
-      m_piData1[loc] = CSeqNo::incseq(seqno);
-      if (CSeqNo::seqcmp(m_piData2[m_iHead], m_piData1[loc]) > 0)
-         m_piData2[loc] = m_piData2[m_iHead];
-
-      m_piData1[m_iHead] = -1;
-      m_piData2[m_iHead] = -1;
-
-      m_piNext[loc] = m_piNext[m_iHead];
-      m_iHead = loc;
+      clearNode(m_iHead);
+      m_iHead = (m_iHead + 1) % m_iSize;
+      setNode(m_iHead, CSeqNo::incseq(seqno), end);
    }
 
    m_iLength --;
@@ -422,8 +511,7 @@ int32_t CSndLossList::getLostSeq()
 CRcvLossList::CRcvLossList(int size):
 m_piData1(NULL),
 m_piData2(NULL),
-m_piNext(NULL),
-m_piPrior(NULL),
+m_Nodes(size),
 m_iHead(-1),
 m_iTail(-1),
 m_iLength(0),
@@ -431,8 +519,6 @@ m_iSize(size)
 {
    m_piData1 = new int32_t [m_iSize];
    m_piData2 = new int32_t [m_iSize];
-   m_piNext = new int [m_iSize];
-   m_piPrior = new int [m_iSize];
 
    // -1 means there is no data in the node
    for (int i = 0; i < size; ++ i)
@@ -446,8 +532,30 @@ CRcvLossList::~CRcvLossList()
 {
    delete [] m_piData1;
    delete [] m_piData2;
-   delete [] m_piNext;
-   delete [] m_piPrior;
+}
+
+int CRcvLossList::locate(int32_t seqno) const
+{
+   return (m_iHead + CSeqNo::seqoff(m_piData1[m_iHead], seqno) + m_iSize) % m_iSize;
+}
+
+int32_t CRcvLossList::lastSeq(int loc) const
+{
+   return (-1 == m_piData2[loc]) ? m_piData1[loc] : m_piData2[loc];
+}
+
+void CRcvLossList::setNode(int loc, int32_t seqno1, int32_t seqno2)
+{
+   m_piData1[loc] = seqno1;
+   m_piData2[loc] = (seqno2 == seqno1) ? -1 : seqno2;
+   m_Nodes.set(loc);
+}
+
+void CRcvLossList::clearNode(int loc)
+{
+   m_piData1[loc] = -1;
+   m_piData2[loc] = -1;
+   m_Nodes.clear(loc);
 }
 
 void CRcvLossList::insert(int32_t seqno1, int32_t seqno2)
@@ -460,38 +568,22 @@ void CRcvLossList::insert(int32_t seqno1, int32_t seqno2)
       // insert data into an empty list
       m_iHead = 0;
       m_iTail = 0;
-      m_piData1[m_iHead] = seqno1;
-      if (seqno2 != seqno1)
-         m_piData2[m_iHead] = seqno2;
-
-      m_piNext[m_iHead] = -1;
-      m_piPrior[m_iHead] = -1;
-      m_iLength += CSeqNo::seqlen(seqno1, seqno2);
+      setNode(m_iHead, seqno1, seqno2);
+      m_iLength = CSeqNo::seqlen(seqno1, seqno2);
 
       return;
    }
 
-   // otherwise searching for the position where the node should be
-   int offset = CSeqNo::seqoff(m_piData1[m_iHead], seqno1);
-   int loc = (m_iHead + offset) % m_iSize;
-
-   if ((-1 != m_piData2[m_iTail]) && (CSeqNo::incseq(m_piData2[m_iTail]) == seqno1))
+   if (CSeqNo::incseq(lastSeq(m_iTail)) == seqno1)
    {
       // coalesce with prior node, e.g., [2, 5], [6, 7] becomes [2, 7]
-      loc = m_iTail;
-      m_piData2[loc] = seqno2;
+      setNode(m_iTail, m_piData1[m_iTail], seqno2);
    }
    else
    {
       // create new node
-      m_piData1[loc] = seqno1;
-
-      if (seqno2 != seqno1)
-         m_piData2[loc] = seqno2;
-
-      m_piNext[m_iTail] = loc;
-      m_piPrior[loc] = m_iTail;
-      m_piNext[loc] = -1;
+      int loc = locate(seqno1);
+      setNode(loc, seqno1, seqno2);
       m_iTail = loc;
    }
 
@@ -499,151 +591,90 @@ void CRcvLossList::insert(int32_t seqno1, int32_t seqno2)
 }
 
 bool CRcvLossList::remove(int32_t seqno)
+{
+   return remove(seqno, seqno);
+}
+
+bool CRcvLossList::remove(int32_t seqno1, int32_t seqno2)
 {
    if (0 == m_iLength)
-      return false; 
+      return false;
 
-   // locate the position of "seqno" in the list
-   int offset = CSeqNo::seqoff(m_piData1[m_iHead], seqno);
-   if (offset < 0)
+   // only the part of the range covered by the list matters
+   if (CSeqNo::seqcmp(seqno1, m_piData1[m_iHead]) < 0)
+      seqno1 = m_piData1[m_iHead];
+   if (CSeqNo::seqcmp(seqno2, lastSeq(m_iTail)) > 0)
+      seqno2 = lastSeq(m_iTail);
+   if (CSeqNo::seqcmp(seqno1, seqno2) > 0)
       return false;
 
-   int loc = (m_iHead + offset) % m_iSize;
+   bool removed = false;
 
-   if (seqno == m_piData1[loc])
-   {
-      // This is a seq. no. that starts the loss sequence
+   int i = m_Nodes.prior(locate(seqno1), m_iHead);
+   int32_t end = lastSeq(i);
 
-      if (-1 == m_piData2[loc])
-      {
-         // there is only 1 loss in the sequence, delete it from the node
-         if (m_iHead == loc)
-         {
-            m_iHead = m_piNext[m_iHead];
-            if (-1 != m_iHead)
-               m_piPrior[m_iHead] = -1;
-         }
-         else
-         {
-            m_piNext[m_piPrior[loc]] = m_piNext[loc];
-            if (-1 != m_piNext[loc])
-               m_piPrior[m_piNext[loc]] = m_piPrior[loc];
-            else
-               m_iTail = m_piPrior[loc];
-         }
+   if ((m_piData1[i] != seqno1) && (CSeqNo::seqcmp(end, seqno1) >= 0))
+   {
+      // remove the tail of the node, e.g., [3, 7] becomes [3, 4] after remove(5, 7)
+      setNode(i, m_piData1[i], CSeqNo::decseq(seqno1));
 
-         m_piData1[loc] = -1;
-      }
-      else
+      if (CSeqNo::seqcmp(end, seqno2) > 0)
       {
-         // there are more than 1 loss in the sequence
-         // move the node to the next and update the starter as the next loss inSeqNo(seqno)
-
-         // find next node
-         int i = (loc + 1) % m_iSize;
-
-         // remove the "seqno" and change the starter as next seq. no.
-         m_piData1[i] = CSeqNo::incseq(m_piData1[loc]);
-
-         // process the sequence end
-         if (CSeqNo::seqcmp(m_piData2[loc], CSeqNo::incseq(m_piData1[loc])) > 0)
-            m_piData2[i] = m_piData2[loc];
-
-         // remove the current node
-         m_piData1[loc] = -1;
-         m_piData2[loc] = -1;
- 
-         // update list pointer
-         m_piNext[i] = m_piNext[loc];
-         m_piPrior[i] = m_piPrior[loc];
-
-         if (m_iHead == loc)
-            m_iHead = i;
-         else
-            m_piNext[m_piPrior[i]] = i;
-
-         if (m_iTail == loc)
-            m_iTail = i;
-         else
-            m_piPrior[m_piNext[i]] = i;
+         // split the node, e.g., remove(4, 5) from [3, 7] leaves [3, 3], [6, 7]
+         int loc = locate(CSeqNo::incseq(seqno2));
+         setNode(loc, CSeqNo::incseq(seqno2), end);
+         if (m_iTail == i)
+            m_iTail = loc;
+
+         m_iLength -= CSeqNo::seqlen(seqno1, seqno2);
+         return true;
       }
 
-      m_iLength --;
-
-      return true;
+      m_iLength -= CSeqNo::seqlen(seqno1, end);
+      removed = true;
    }
 
-   // There is no loss sequence in the current position
-   // the "seqno" may be contained in a previous node
-
-   // searching previous node
-   int i = (loc - 1 + m_iSize) % m_iSize;
-   while (-1 == m_piData1[i])
-      i = (i - 1 + m_iSize) % m_iSize;
-
-   // not contained in this node, return
-   if ((-1 == m_piData2[i]) || (CSeqNo::seqcmp(seqno, m_piData2[i]) > 0))
-       return false;
-
-   if (seqno == m_piData2[i])
-   {
-      // it is the sequence end
-
-      if (seqno == CSeqNo::incseq(m_piData1[i]))
-         m_piData2[i] = -1;
-      else
-         m_piData2[i] = CSeqNo::decseq(seqno);
-   }
-   else
+   // remove the nodes starting within the range
+   i = (m_piData1[i] == seqno1) ? i : m_Nodes.after(i, m_iHead);
+   while ((-1 != i) && (CSeqNo::seqcmp(m_piData1[i], seqno2) <= 0))
    {
-      // split the sequence
+      int next = m_Nodes.after(i, m_iHead);
+      end = lastSeq(i);
+      removed = true;
 
-      // construct the second sequence from CSeqNo::incseq(seqno) to the original sequence end
-      // located at "loc + 1"
-      loc = (loc + 1) % m_iSize;
+      if (CSeqNo::seqcmp(end, seqno2) > 0)
+      {
+         // the rest of the node moves behind seqno2
+         int loc = locate(CSeqNo::incseq(seqno2));
+         m_iLength -= CSeqNo::seqlen(m_piData1[i], seqno2);
+         clearNode(i);
+         setNode(loc, CSeqNo::incseq(seqno2), end);
 
-      m_piData1[loc] = CSeqNo::incseq(seqno);
-      if (CSeqNo::seqcmp(m_piData2[i], m_piData1[loc]) > 0)      
-         m_piData2[loc] = m_piData2[i];
+         if (m_iHead == i)
+            m_iHead = loc;
+         if (m_iTail == i)
+            m_iTail = loc;
 
-      // the first (original) sequence is between the original sequence start to CSeqNo::decseq(seqno)
-      if (seqno == CSeqNo::incseq(m_piData1[i]))
-         m_piData2[i] = -1;
-      else
-         m_piData2[i] = CSeqNo::decseq(seqno);
+         return true;
+      }
 
-      // update the list pointer
-      m_piNext[loc] = m_piNext[i];
-      m_piNext[i] = loc;
-      m_piPrior[loc] = i;
+      m_iLength -= CSeqNo::seqlen(m_piData1[i], end);
+      clearNode(i);
 
-      if (m_iTail == i)
-         m_iTail = loc;
-      else
-         m_piPrior[m_piNext[loc]] = loc;
+      if (m_iHead == i)
+         m_iHead = next;
+      i = next;
    }
 
-   m_iLength --;
-
-   return true;
-}
-
-bool CRcvLossList::remove(int32_t seqno1, int32_t seqno2)
-{
-   if (seqno1 <= seqno2)
-   {
-      for (int32_t i = seqno1; i <= seqno2; ++ i)
-         remove(i);
-   }
-   else
+   if (0 == m_iLength)
    {
-      for (int32_t j = seqno1; j < CSeqNo::m_iMaxSeqNo; ++ j)
-         remove(j);
-      for (int32_t k = 0; k <= seqno2; ++ k)
-         remove(k);
+      m_iHead = -1;
+      m_iTail = -1;
    }
+   else if (!m_Nodes.test(m_iTail))
+      m_iTail = m_Nodes.prior((m_iHead - 1 + m_iSize) % m_iSize, m_iHead);
 
-   return true;
+   return removed;
 }
 
 bool CRcvLossList::find(int32_t seqno1, int32_t seqno2) const
@@ -651,19 +682,21 @@ bool CRcvLossList::find(int32_t seqno1, int32_t seqno2) const
    if (0 == m_iLength)
       return false;
 
-   int p = m_iHead;
+   if (CSeqNo::seqcmp(seqno1, m_piData1[m_iHead]) < 0)
+      seqno1 = m_piData1[m_iHead];
+   if (CSeqNo::seqcmp(seqno2, lastSeq(m_iTail)) > 0)
+      seqno2 = lastSeq(m_iTail);
+   if (CSeqNo::seqcmp(seqno1, seqno2) > 0)
+      return false;
 
-   while (-1 != p)
-   {
-      if ((CSeqNo::seqcmp(m_piData1[p], seqno1) == 0) ||
-          ((CSeqNo::seqcmp(m_piData1[p], seqno1) > 0) && (CSeqNo::seqcmp(m_piData1[p], seqno2) <= 0)) ||
-          ((CSeqNo::seqcmp(m_piData1[p], seqno1) < 0) && (m_piData2[p] != -1) && CSeqNo::seqcmp(m_piData2[p], seqno1) >= 0))
-          return true;
+   // either the node before seqno1 reaches into the range, or the next node starts within it
+   int i = m_Nodes.prior(locate(seqno1), m_iHead);
+   if (CSeqNo::seqcmp(lastSeq(i), seqno1) >= 0)
+      return true;
 
-      p = m_piNext[p];
-   }
+   i = m_Nodes.after(i, m_iHead);
 
-   return false;
+   return (-1 != i) && (CSeqNo::seqcmp(m_piData1[i], seqno2) <= 0);
 }
 
 int CRcvLossList::getLossLength() const
@@ -683,6 +716,9 @@ void CRcvLossList::getLossArray(int32_t* array, int& len, int limit)
 {
    len = 0;
 
+   if (0 == m_iLength)
+      return;
+
    int i = m_iHead;
 
    while ((len < limit - 1) && (-1 != i))
@@ -698,6 +734,6 @@ void CRcvLossList::getLossArray(int32_t* array, int& len, int limit)
 
       ++ len;
 
-      i = m_piNext[i];
+      i = m_Nodes.after(i, m_iHead);
    }
 }
@@ -46,6 +46,60 @@ written by
 #include "common.h"
 
 
+// The nodes of a loss list are stored at positions given by their first sequence number, relative
+// to the head of the list. CLossNodeMap records which positions hold a node, with a summary
+// bit for every 64 positions, so that the nearest node before or after a position is found
+// with a few bit scans instead of walking the list.
+
+class CLossNodeMap
+{
+public:
+   CLossNodeMap(int size);
+   ~CLossNodeMap();
+
+public:
+   void set(int pos);
+   void clear(int pos);
+   bool test(int pos) const;
+
+      // Functionality:
+      //    Find the last node at or before a position, walking back circularly to the list head.
+      // Parameters:
+      //    0) [in] loc: the position to start from.
+      //    1) [in] head: position of the list head.
+      // Returned value:
+      //    The node position, or -1 if there is no node between head and loc.
+
+   int prior(int loc, int head) const;
+
+      // Functionality:
+      //    Find the first node after a position, walking forward circularly up to the list head.
+      // Parameters:
+      //    0) [in] loc: the position to start from.
+      //    1) [in] head: position of the list head.
+      // Returned value:
+      //    The node position, or -1 if loc is the last node.
+
+   int after(int loc, int head) const;
+
+private:
+   int prev(int pos, int lo) const;     // last node in [lo, pos]
+   int next(int pos, int hi) const;     // first node in [pos, hi]
+
+private:
+   uint64_t* m_pWord;                   // one bit per position
+   uint64_t* m_pSummary;                // one bit per non-empty word of m_pWord
+   int m_iWords;                        // number of words in m_pWord
+   int m_iSummaries;                    // number of words in m_pSummary
+   int m_iSize;                         // number of positions
+
+private:
+   CLossNodeMap(const CLossNodeMap&);
+   CLossNodeMap& operator=(const CLossNodeMap&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 class CSndLossList
 {
 public:
@@ -71,6 +125,16 @@ public:
 
    void remove(int32_t seqno);
 
+      // Functionality:
+      //    Remove all the seq. no. between seqno1 and seqno2, leaving the rest of the list intact.
+      // Parameters:
+      //    0) [in] seqno1: start sequence number.
+      //    1) [in] seqno2: end sequence number.
+      // Returned value:
+      //    None.
+
+   void remove(int32_t seqno1, int32_t seqno2);
+
       // Functionality:
       //    Read the loss length.
       // Parameters:
@@ -89,15 +153,20 @@ public:
 
    int32_t getLostSeq();
 
+private:
+   int locate(int32_t seqno) const;     // position of a node starting with seqno
+   int32_t lastSeq(int loc) const;      // last seq. no. of the node at loc
+   void setNode(int loc, int32_t seqno1, int32_t seqno2);
+   void clearNode(int loc);
+
 private:
    int32_t* m_piData1;                  // sequence number starts
    int32_t* m_piData2;                  // seqnence number ends
-   int* m_piNext;                       // next node in the list
+   CLossNodeMap m_Nodes;                // positions holding a node
 
    int m_iHead;                         // first node
    int m_iLength;                       // loss length
    int m_iSize;                         // size of the static array
-   int m_iLastInsertPos;                // position of last insert node
 
    pthread_mutex_t m_ListLock;          // used to synchronize list operation
 
@@ -134,7 +203,7 @@ public:
    bool remove(int32_t seqno);
 
       // Functionality:
-      //    Remove all packets between seqno1 and seqno2.
+      //    Remove all packets between seqno1 and seqno2, e.g., all the chunks of a dropped frame.
       // Parameters:
       //    0) [in] seqno1: start sequence number.
       //    1) [in] seqno2: end sequence number.
@@ -182,11 +251,16 @@ public:
 
    void getLossArray(int32_t* array, int& len, int limit);
 
+private:
+   int locate(int32_t seqno) const;     // position of a node starting with seqno
+   int32_t lastSeq(int loc) const;      // last seq. no. of the node at loc
+   void setNode(int loc, int32_t seqno1, int32_t seqno2);
+   void clearNode(int loc);
+
 private:
    int32_t* m_piData1;                  // sequence number starts
    int32_t* m_piData2;                  // sequence number ends
-   int* m_piNext;                       // next node in the list
-   int* m_piPrior;                      // prior node in the list;
+   CLossNodeMap m_Nodes;                // positions holding a node
 
    int m_iHead;                         // first node in the list
    int m_iTail;                         // last node in the list;
@@ -0,0 +1,335 @@
+/*****************************************************************************
+Copyright (c) 2001 - 2011, The Board of Trustees of the University of Illinois.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+* Redistributions of source code must retain the above
+  copyright notice, this list of conditions and the
+  following disclaimer.
+
+* Redistributions in binary form must reproduce the
+  above copyright notice, this list of conditions
+  and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the University of Illinois
+  nor the names of its contributors may be used to
+  endorse or promote products derived from this
+  software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cstring>
+#include "common.h"
+#include "multipath.h"
+
+using namespace std;
+
+const int CMultipath::m_iSliceHdrSize = 10;
+const int CMultipath::m_iMaxSliceChunks = 255;
+const int CMultipath::m_iMaxMerging = 4096;
+const int CMultipath::m_iMaxDone = 1024;
+
+CMultipath::CMultipath():
+m_iIDSeed(0)
+{
+   CGuard::createMutex(m_SessionLock);
+}
+
+CMultipath::~CMultipath()
+{
+   for (map<int, CMultipathSession>::iterator i = m_mSessions.begin(); i != m_mSessions.end(); ++ i)
+   {
+      for (map<uint16_t, CMergeFrame>::iterator j = i->second.m_mMerging.begin(); j != i->second.m_mMerging.end(); ++ j)
+         delete [] j->second.m_pcData;
+      for (list<CMergeFrame>::iterator j = i->second.m_lReady.begin(); j != i->second.m_lReady.end(); ++ j)
+         delete [] j->m_pcData;
+   }
+
+   CGuard::releaseMutex(m_SessionLock);
+}
+
+int CMultipath::create(const int eid)
+{
+   CGuard sg(m_SessionLock);
+
+   if (++ m_iIDSeed >= 0x7FFFFFFF)
+      m_iIDSeed = 0;
+
+   CMultipathSession& session = m_mSessions[m_iIDSeed];
+   session.m_iID = m_iIDSeed;
+   session.m_iEID = eid;
+   session.m_StartTime = CTimer::getTime();
+
+   return session.m_iID;
+}
+
+void CMultipath::add(const int mid, const UDTSOCKET u)
+{
+   CGuard sg(m_SessionLock);
+
+   map<int, CMultipathSession>::iterator i = m_mSessions.find(mid);
+   if (i == m_mSessions.end())
+      throw CUDTException(5, 17);
+
+   i->second.m_sSubFlows.insert(u);
+}
+
+void CMultipath::remove(const int mid, const UDTSOCKET u)
+{
+   CGuard sg(m_SessionLock);
+
+   map<int, CMultipathSession>::iterator i = m_mSessions.find(mid);
+   if (i == m_mSessions.end())
+      throw CUDTException(5, 17);
+
+   i->second.m_sSubFlows.erase(u);
+}
+
+void CMultipath::getSubFlows(const int mid, vector<UDTSOCKET>& subflows, uint64_t& start, int& eid)
+{
+   CGuard sg(m_SessionLock);
+
+   map<int, CMultipathSession>::iterator i = m_mSessions.find(mid);
+   if (i == m_mSessions.end())
+      throw CUDTException(5, 17);
+
+   subflows.assign(i->second.m_sSubFlows.begin(), i->second.m_sSubFlows.end());
+   start = i->second.m_StartTime;
+   eid = i->second.m_iEID;
+}
+
+int CMultipath::release(const int mid)
+{
+   CGuard sg(m_SessionLock);
+
+   map<int, CMultipathSession>::iterator i = m_mSessions.find(mid);
+   if (i == m_mSessions.end())
+      throw CUDTException(5, 17);
+
+   for (map<uint16_t, CMergeFrame>::iterator j = i->second.m_mMerging.begin(); j != i->second.m_mMerging.end(); ++ j)
+      delete [] j->second.m_pcData;
+   for (list<CMergeFrame>::iterator j = i->second.m_lReady.begin(); j != i->second.m_lReady.end(); ++ j)
+      delete [] j->m_pcData;
+
+   int eid = i->second.m_iEID;
+   m_mSessions.erase(i);
+
+   return eid;
+}
+
+void CMultipath::merge(const int mid, uint16_t frame_id, const char* slice, int len)
+{
+   CGuard sg(m_SessionLock);
+
+   map<int, CMultipathSession>::iterator i = m_mSessions.find(mid);
+   if (i == m_mSessions.end())
+      throw CUDTException(5, 17);
+
+   CMultipathSession& session = i->second;
+   if (session.m_sDone.find(frame_id) != session.m_sDone.end())
+      return;
+
+   // a slice that does not hold together, e.g., one cut short by a receive buffer too small for it, gives the frame up
+   if (len < m_iSliceHdrSize)
+   {
+      finish(session, frame_id, false);
+      return;
+   }
+
+   int framelen = ntohl(*(uint32_t*)slice);
+   int chunksize = ntohs(*(uint16_t*)(slice + 4));
+   int total = ntohs(*(uint16_t*)(slice + 6));
+   int num = ntohs(*(uint16_t*)(slice + 8));
+
+   if ((framelen <= 0) || (chunksize <= 0) || (total != (framelen + chunksize - 1) / chunksize) || (len < m_iSliceHdrSize + num * 2))
+   {
+      finish(session, frame_id, false);
+      return;
+   }
+
+   map<uint16_t, CMergeFrame>::iterator f = session.m_mMerging.find(frame_id);
+   if (f == session.m_mMerging.end())
+   {
+      // frame IDs must not wrap around among the frames merging, and the memory they take is bounded
+      if ((int)session.m_mMerging.size() >= m_iMaxMerging)
+         finish(session, session.m_lMerging.front(), false);
+
+      CMergeFrame frame;
+      frame.m_iFrameID = frame_id;
+      frame.m_pcData = new char[framelen];
+      frame.m_iLength = framelen;
+      frame.m_iChunkSize = chunksize;
+      frame.m_iTotal = total;
+      frame.m_iReceived = 0;
+      frame.m_vbReceived.resize(total, false);
+
+      f = session.m_mMerging.insert(make_pair(frame_id, frame)).first;
+      session.m_lMerging.push_back(frame_id);
+   }
+   else if ((f->second.m_iLength != framelen) || (f->second.m_iChunkSize != chunksize))
+   {
+      finish(session, frame_id, false);
+      return;
+   }
+
+   CMergeFrame& frame = f->second;
+   const char* data = slice + m_iSliceHdrSize + num * 2;
+   const char* end = slice + len;
+   for (int c = 0; c < num; ++ c)
+   {
+      int chunk = ntohs(*(uint16_t*)(slice + m_iSliceHdrSize + c * 2));
+      int offset = chunk * chunksize;
+      int size = (framelen - offset < chunksize) ? framelen - offset : chunksize;
+      if ((chunk >= total) || (end - data < size))
+      {
+         finish(session, frame_id, false);
+         return;
+      }
+
+      if (!frame.m_vbReceived[chunk])
+      {
+         memcpy(frame.m_pcData + offset, data, size);
+         frame.m_vbReceived[chunk] = true;
+         ++ frame.m_iReceived;
+      }
+      data += size;
+   }
+
+   if (frame.m_iReceived == frame.m_iTotal)
+      finish(session, frame_id, true);
+}
+
+void CMultipath::abandon(const int mid, uint16_t frame_id)
+{
+   CGuard sg(m_SessionLock);
+
+   map<int, CMultipathSession>::iterator i = m_mSessions.find(mid);
+   if (i == m_mSessions.end())
+      throw CUDTException(5, 17);
+
+   // a frame is given up once, whichever sub-flows have abandoned slices of it
+   if (i->second.m_sDone.find(frame_id) == i->second.m_sDone.end())
+      finish(i->second, frame_id, false);
+}
+
+void CMultipath::giveUp(const int mid)
+{
+   CGuard sg(m_SessionLock);
+
+   map<int, CMultipathSession>::iterator i = m_mSessions.find(mid);
+   if (i == m_mSessions.end())
+      throw CUDTException(5, 17);
+
+   while (!i->second.m_lMerging.empty())
+      finish(i->second, i->second.m_lMerging.front(), false);
+}
+
+bool CMultipath::readFrame(const int mid, char* data, int len, int& size, uint16_t& frame_id, bool& complete)
+{
+   CGuard sg(m_SessionLock);
+
+   map<int, CMultipathSession>::iterator i = m_mSessions.find(mid);
+   if (i == m_mSessions.end())
+      throw CUDTException(5, 17);
+
+   if (i->second.m_lReady.empty())
+      return false;
+
+   CMergeFrame& frame = i->second.m_lReady.front();
+   frame_id = frame.m_iFrameID;
+   complete = (NULL != frame.m_pcData);
+   size = 0;
+   if (complete)
+   {
+      size = (frame.m_iLength < len) ? frame.m_iLength : len;
+      memcpy(data, frame.m_pcData, size);
+      delete [] frame.m_pcData;
+   }
+   i->second.m_lReady.pop_front();
+
+   return true;
+}
+
+int CMultipath::packSlice(char* slice, const char* frame, int len, int chunksize, const vector<uint16_t>& chunks)
+{
+   *(uint32_t*)slice = htonl(len);
+   *(uint16_t*)(slice + 4) = htons(chunksize);
+   *(uint16_t*)(slice + 6) = htons((len + chunksize - 1) / chunksize);
+   *(uint16_t*)(slice + 8) = htons(chunks.size());
+
+   char* p = slice + m_iSliceHdrSize;
+   for (vector<uint16_t>::const_iterator i = chunks.begin(); i != chunks.end(); ++ i, p += 2)
+      *(uint16_t*)p = htons(*i);
+
+   for (vector<uint16_t>::const_iterator i = chunks.begin(); i != chunks.end(); ++ i)
+   {
+      int offset = *i * chunksize;
+      int size = (len - offset < chunksize) ? len - offset : chunksize;
+      memcpy(p, frame + offset, size);
+      p += size;
+   }
+
+   return p - slice;
+}
+
+int CMultipath::getSliceSize(int len, int chunksize, const vector<uint16_t>& chunks)
+{
+   int size = m_iSliceHdrSize + chunks.size() * 2;
+   for (vector<uint16_t>::const_iterator i = chunks.begin(); i != chunks.end(); ++ i)
+   {
+      int offset = *i * chunksize;
+      size += (len - offset < chunksize) ? len - offset : chunksize;
+   }
+
+   return size;
+}
+
+void CMultipath::finish(CMultipathSession& session, uint16_t frame_id, bool complete)
+{
+   CMergeFrame frame;
+   map<uint16_t, CMergeFrame>::iterator f = session.m_mMerging.find(frame_id);
+   if (f != session.m_mMerging.end())
+   {
+      frame = f->second;
+      session.m_mMerging.erase(f);
+      session.m_lMerging.remove(frame_id);
+   }
+   else
+   {
+      // abandoned before any of its slices came in
+      frame.m_iFrameID = frame_id;
+      frame.m_pcData = NULL;
+      frame.m_iLength = frame.m_iChunkSize = frame.m_iTotal = frame.m_iReceived = 0;
+   }
+
+   if (!complete)
+   {
+      delete [] frame.m_pcData;
+      frame.m_pcData = NULL;
+   }
+   frame.m_vbReceived.clear();
+   session.m_lReady.push_back(frame);
+
+   session.m_sDone.insert(frame_id);
+   session.m_lDone.push_back(frame_id);
+   if ((int)session.m_lDone.size() > m_iMaxDone)
+   {
+      session.m_sDone.erase(session.m_lDone.front());
+      session.m_lDone.pop_front();
+   }
+}
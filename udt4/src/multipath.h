@@ -0,0 +1,259 @@
+/*****************************************************************************
+Copyright (c) 2001 - 2011, The Board of Trustees of the University of Illinois.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+* Redistributions of source code must retain the above
+  copyright notice, this list of conditions and the
+  following disclaimer.
+
+* Redistributions in binary form must reproduce the
+  above copyright notice, this list of conditions
+  and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the University of Illinois
+  nor the names of its contributors may be used to
+  endorse or promote products derived from this
+  software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#ifndef __UDT_MULTIPATH_H__
+#define __UDT_MULTIPATH_H__
+
+
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+#include "udt.h"
+
+
+// A multipath session sends one frame stream over several sub-flows, each an ordinary connected SOCK_DGRAM socket
+// with its own congestion control, RTT and loss estimates, usually bound to a different local interface. The sender
+// splits every frame into chunks and spreads them over the sub-flows; the chunks a sub-flow takes go out as one
+// frame of that sub-flow (a slice) under the same frame ID and deadline:
+//
+//    32 bits  size of the whole frame
+//    16 bits  size of a chunk; all chunks but the last one of the frame have it
+//    16 bits  number of chunks of the frame
+//    16 bits  number of chunks in this slice, n
+//    n x 16 bits  chunk numbers
+//    the data of the chunks, in the order of their numbers above
+//
+// The receiver merges the slices that arrive on all sub-flows back into frames.
+
+class CUDT;
+
+// the part of a frame that the scheduler gives to one sub-flow
+struct CSlicePlan
+{
+   UDTSOCKET m_iSocket;                 // sub-flow socket
+   CUDT* m_pUDT;                        // sub-flow connection
+   int64_t m_llDeadline;                // frame deadline in the time base of the sub-flow, 0 if none
+   int m_iBytes;                        // size of the slice so far
+   std::vector<uint16_t> m_vChunks;     // chunk numbers given to the sub-flow, in increasing order
+   bool m_bBlock;                       // if sending the slice may wait for room in the sender buffer
+};
+
+struct CMergeFrame
+{
+   uint16_t m_iFrameID;                 // frame ID
+   char* m_pcData;                      // the frame data, NULL once the frame has been given up
+   int m_iLength;                       // size of the frame
+   int m_iChunkSize;                    // size of a chunk
+   int m_iTotal;                        // number of chunks of the frame
+   int m_iReceived;                     // number of chunks received so far
+   std::vector<bool> m_vbReceived;      // chunks received so far
+};
+
+struct CMultipathSession
+{
+   int m_iID;                           // session ID
+   int m_iEID;                          // epoll ID watching the sub-flows for data
+   uint64_t m_StartTime;                // time base of the frame deadlines given to the session
+   std::set<UDTSOCKET> m_sSubFlows;     // sub-flow sockets
+
+   std::map<uint16_t, CMergeFrame> m_mMerging;  // frames with chunks still missing
+   std::list<uint16_t> m_lMerging;      // the same frames, oldest first
+   std::list<CMergeFrame> m_lReady;     // frames done with, complete or given up, in the order they were done with
+   std::set<uint16_t> m_sDone;          // recent frames done with, whose late slices are discarded
+   std::list<uint16_t> m_lDone;         // the same frames, oldest first
+};
+
+class CMultipath
+{
+public:
+   CMultipath();
+   ~CMultipath();
+
+public: // for CUDTUnited API
+
+      // Functionality:
+      //    create a new multipath session.
+      // Parameters:
+      //    0) [in] eid: epoll ID that the session uses to wait for its sub-flows.
+      // Returned value:
+      //    new session ID.
+
+   int create(const int eid);
+
+      // Functionality:
+      //    add a sub-flow to a session.
+      // Parameters:
+      //    0) [in] mid: session ID.
+      //    1) [in] u: UDT socket ID.
+      // Returned value:
+      //    None.
+
+   void add(const int mid, const UDTSOCKET u);
+
+      // Functionality:
+      //    remove a sub-flow from a session.
+      // Parameters:
+      //    0) [in] mid: session ID.
+      //    1) [in] u: UDT socket ID.
+      // Returned value:
+      //    None.
+
+   void remove(const int mid, const UDTSOCKET u);
+
+      // Functionality:
+      //    read the sub-flows of a session, its time base and its epoll ID.
+      // Parameters:
+      //    0) [in] mid: session ID.
+      //    1) [out] subflows: the sub-flow sockets.
+      //    2) [out] start: time base of the frame deadlines, in microseconds of CTimer::getTime().
+      //    3) [out] eid: epoll ID of the session.
+      // Returned value:
+      //    None.
+
+   void getSubFlows(const int mid, std::vector<UDTSOCKET>& subflows, uint64_t& start, int& eid);
+
+      // Functionality:
+      //    close a session. The sub-flows stay open.
+      // Parameters:
+      //    0) [in] mid: session ID.
+      // Returned value:
+      //    epoll ID of the session, for the caller to release.
+
+   int release(const int mid);
+
+      // Functionality:
+      //    merge a slice received on one of the sub-flows.
+      // Parameters:
+      //    0) [in] mid: session ID.
+      //    1) [in] frame_id: Frame ID of the slice.
+      //    2) [in] slice: the slice.
+      //    3) [in] len: size of the slice.
+      // Returned value:
+      //    None. A malformed slice gives its frame up.
+
+   void merge(const int mid, uint16_t frame_id, const char* slice, int len);
+
+      // Functionality:
+      //    give up a frame that a sub-flow has abandoned a slice of.
+      // Parameters:
+      //    0) [in] mid: session ID.
+      //    1) [in] frame_id: Frame ID.
+      // Returned value:
+      //    None.
+
+   void abandon(const int mid, uint16_t frame_id);
+
+      // Functionality:
+      //    give up the frames being merged, after the failure of a sub-flow that may have carried some of their chunks.
+      // Parameters:
+      //    0) [in] mid: session ID.
+      // Returned value:
+      //    None.
+
+   void giveUp(const int mid);
+
+      // Functionality:
+      //    read the next frame done with, complete or given up.
+      // Parameters:
+      //    0) [in] mid: session ID.
+      //    1) [out] data: buffer for the frame; a larger frame is truncated.
+      //    2) [in] len: size of the buffer.
+      //    3) [out] size: size of the data read, 0 for a frame given up.
+      //    4) [out] frame_id: Frame ID.
+      //    5) [out] complete: false if the frame has been given up.
+      // Returned value:
+      //    true if a frame has been read, false if none is ready.
+
+   bool readFrame(const int mid, char* data, int len, int& size, uint16_t& frame_id, bool& complete);
+
+public:
+
+      // Functionality:
+      //    build a slice.
+      // Parameters:
+      //    0) [out] slice: buffer for the slice, getSliceSize() bytes.
+      //    1) [in] frame: the whole frame.
+      //    2) [in] len: size of the frame.
+      //    3) [in] chunksize: size of a chunk.
+      //    4) [in] chunks: the chunk numbers that go into the slice, in increasing order.
+      // Returned value:
+      //    size of the slice.
+
+   static int packSlice(char* slice, const char* frame, int len, int chunksize, const std::vector<uint16_t>& chunks);
+
+      // Functionality:
+      //    size of a slice.
+      // Parameters:
+      //    0) [in] len: size of the frame.
+      //    1) [in] chunksize: size of a chunk.
+      //    2) [in] chunks: the chunk numbers that go into the slice.
+      // Returned value:
+      //    size of the slice.
+
+   static int getSliceSize(int len, int chunksize, const std::vector<uint16_t>& chunks);
+
+public:
+   static const int m_iSliceHdrSize;    // size of the slice header without the chunk numbers
+   static const int m_iMaxSliceChunks;  // chunks in a slice at most
+   static const int m_iMaxMerging;      // frames merged at the same time per session at most; beyond it the oldest is given up
+   static const int m_iMaxDone;         // recent frames remembered per session to discard their late slices
+
+private:
+
+      // Functionality:
+      //    move a frame to the ready list, and remember it as done with.
+      // Parameters:
+      //    0) [in] session: the session.
+      //    1) [in] frame_id: Frame ID.
+      //    2) [in] complete: false to give the frame up, dropping what has been received of it.
+      // Returned value:
+      //    None.
+
+   void finish(CMultipathSession& session, uint16_t frame_id, bool complete);
+
+private:
+   int m_iIDSeed;                       // seed to generate a new unique session ID
+   pthread_mutex_t m_SessionLock;       // protects m_mSessions
+
+   std::map<int, CMultipathSession> m_mSessions;
+
+private:
+   CMultipath(const CMultipath&);
+   CMultipath& operator=(const CMultipath&);
+};
+
+
+#endif
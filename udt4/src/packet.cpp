@@ -100,6 +100,7 @@ written by
 //                            available receiver buffer size (in bytes)
 //                            advertised flow window size (number of packets)
 //                            estimated bandwidth (number of packets per second)
+//                            number of lost packets rebuilt from frame parity (total)
 //      3: Negative Acknowledgement (NAK)
 //              Add. Info:    Undefined
 //              Control Info: Loss list (see loss list coding below)
@@ -116,9 +117,16 @@ written by
 //              Add. Info:    Message ID
 //              Control Info: first sequence number of the message
 //                            last seqeunce number of the message
+//              Optional:     frame ID (VR Frame Awareness)
+//                            chunk ID from which the optional layers of the frame are shed; the frame is kept
 //      8: Error Signal from the Peer Side
 //              Add. Info:    Error code
 //              Control Info: None
+//      9: Frame Abandoned by the Receiver (VR Frame Awareness)
+//              Add. Info:    Message ID
+//              Control Info: first sequence number of the frame
+//                            last sequence number of the frame
+//                            frame ID
 //      0x7FFF: Explained by bits 16 - 31
 //              
 //   bit 16 - 31:
@@ -144,26 +152,33 @@ written by
 
 
 #include <cstring>
+#include "common.h"
 #include "packet.h"
 
 
-const int CPacket::m_iPktHdrSize = 20;  // Extended from 16 to 20 bytes (added m_nHeader[4] for frame metadata)
+const int CPacket::m_iPktHdrSize = CHeaderFormat<HDR_LAYERED>::m_iSize;
+const int CPacket::m_iMaxDeadlineOffset = 511 << 14;  // largest value of the 12-bit deadline code
 const int CHandShake::m_iContentSize = 48;
+const int CHandShake::m_iExtContentSize = 52;
+const int32_t CHandShake::m_iExtShmem = 1;
+const int32_t CHandShake::m_iExtFrameHeader = 2;
+const int32_t CHandShake::m_iExtAckNak = 4;
+const int32_t CHandShake::m_iExtFrameLayers = 8;
 
 
 // Set up the aliases in the constructure
 CPacket::CPacket():
 m_iSeqNo((int32_t&)(m_nHeader[0])),
 m_iMsgNo((int32_t&)(m_nHeader[1])),
-m_iTimeStamp((int32_t&)(m_nHeader[2])),  // Repurposed for FRAME_DEADLINE
+m_iTimeStamp((int32_t&)(m_nHeader[2])),
 m_iID((int32_t&)(m_nHeader[3])),
 m_pcData((char*&)(m_PacketVector[1].iov_base)),
 __pad()
 {
-   for (int i = 0; i < 5; ++ i)  // Changed from 4 to 5
+   for (int i = 0; i < 6; ++ i)
       m_nHeader[i] = 0;
    m_PacketVector[0].iov_base = (char *)m_nHeader;
-   m_PacketVector[0].iov_len = CPacket::m_iPktHdrSize;  // Now 20 bytes
+   m_PacketVector[0].iov_len = CPacket::m_iPktHdrSize;
    m_PacketVector[1].iov_base = NULL;
    m_PacketVector[1].iov_len = 0;
 }
@@ -186,6 +201,7 @@ void CPacket::pack(int pkttype, void* lparam, void* rparam, int size)
 {
    // Set (bit-0 = 1) and (bit-1~15 = type)
    m_nHeader[0] = 0x80000000 | (pkttype << 16);
+   m_PacketVector[0].iov_len = CHeaderFormat<HDR_CLASSIC>::m_iSize;
 
    // Set additional information and control information field
    switch (pkttype)
@@ -272,6 +288,16 @@ void CPacket::pack(int pkttype, void* lparam, void* rparam, int size)
 
       break;
 
+   case 9: //1001 - Frame Abandoned by the Receiver
+      // msg id
+      m_nHeader[1] = *(int32_t *)lparam;
+
+      // first seq no, last seq no, frame id
+      m_PacketVector[1].iov_base = (char *)rparam;
+      m_PacketVector[1].iov_len = size;
+
+      break;
+
    case 32767: //0x7FFF - Reserved for user defined control packets
       // for extended control packet
       // "lparam" contains the extended type information for bit 16 - 31
@@ -296,6 +322,46 @@ void CPacket::pack(int pkttype, void* lparam, void* rparam, int size)
    }
 }
 
+int CPacket::getHeaderSize() const
+{
+   return m_PacketVector[0].iov_len;
+}
+
+int CPacket::getFormatSize(int format)
+{
+   switch (format)
+   {
+   case HDR_LAYERED:
+      return CHeaderFormat<HDR_LAYERED>::m_iSize;
+   case HDR_FRAME:
+      return CHeaderFormat<HDR_FRAME>::m_iSize;
+   default:
+      return CHeaderFormat<HDR_CLASSIC>::m_iSize;
+   }
+}
+
+void CPacket::trimHeader(int size)
+{
+   int extra = (int)m_PacketVector[0].iov_len - size;
+   if (extra <= 0)
+      return;
+
+   // the words have been converted with the header, they go back as they came off the wire;
+   // a packet shorter than the received header has a negative length here, and only part of the words are its own
+   int len = m_PacketVector[1].iov_len;
+   if (len > 0)
+      memmove(m_pcData + extra, m_pcData, len);
+   for (int i = 0; i < extra / 4; ++ i)
+   {
+      uint32_t word = htonl(m_nHeader[size / 4 + i]);
+      memcpy(m_pcData + i * 4, &word, 4);
+      m_nHeader[size / 4 + i] = 0;
+   }
+
+   m_PacketVector[0].iov_len = size;
+   m_PacketVector[1].iov_len = len + extra;
+}
+
 iovec* CPacket::getPacketVector()
 {
    return m_PacketVector;
@@ -339,8 +405,10 @@ bool CPacket::getMsgOrderFlag() const
 
 int32_t CPacket::getMsgSeq() const
 {
-   // read [1] bit 3~31
-   return m_nHeader[1] & 0x1FFFFFFF;
+   // read [1] bit 3~31, or bit 15~31 with the frame and layered headers
+   if (CHeaderFormat<HDR_FRAME>::m_iSize <= (int)m_PacketVector[0].iov_len)
+      return m_nHeader[1] & CHeaderFormat<HDR_FRAME>::m_iMsgNoMask;
+   return m_nHeader[1] & CHeaderFormat<HDR_CLASSIC>::m_iMsgNoMask;
 }
 
 int32_t CPacket::getFrameID() const
@@ -379,22 +447,93 @@ void CPacket::setTotalChunks(int32_t total_chunks)
    m_nHeader[4] = (m_nHeader[4] & 0x00FFFFFF) | ((total_chunks & 0xFF) << 24);
 }
 
+void CPacket::setFrameInfo(int32_t frame_id, int32_t chunk_id, int32_t total_chunks)
+{
+   // the whole of [4]: bits 0-15, 16-23 and 24-31
+   m_nHeader[4] = (uint32_t(frame_id) & 0xFFFF) | ((uint32_t(chunk_id) & 0xFF) << 16) | ((uint32_t(total_chunks) & 0xFF) << 24);
+   if (CHeaderFormat<HDR_FRAME>::m_iSize > (int)m_PacketVector[0].iov_len)
+      m_PacketVector[0].iov_len = CHeaderFormat<HDR_FRAME>::m_iSize;
+}
+
+int CPacket::getLayer() const
+{
+   // read [5] bits 0-7; the other headers have no layers, everything is base layer
+   if (CHeaderFormat<HDR_LAYERED>::m_iSize != (int)m_PacketVector[0].iov_len)
+      return 0;
+   return m_nHeader[5] & 0xFF;
+}
+
+int CPacket::getRequiredChunks() const
+{
+   // read [5] bits 8-15
+   if (CHeaderFormat<HDR_LAYERED>::m_iSize != (int)m_PacketVector[0].iov_len)
+      return 0;
+   return (m_nHeader[5] >> 8) & 0xFF;
+}
+
+bool CPacket::isLayerEnd() const
+{
+   // read [5] bit 16
+   if (CHeaderFormat<HDR_LAYERED>::m_iSize != (int)m_PacketVector[0].iov_len)
+      return false;
+   return 0 != ((m_nHeader[5] >> 16) & 1);
+}
+
+void CPacket::setLayerInfo(int32_t layer, int32_t required, bool layerend)
+{
+   // the whole of [5]: bits 0-7, 8-15 and 16, the rest is reserved
+   m_nHeader[5] = (uint32_t(layer) & 0xFF) | ((uint32_t(required) & 0xFF) << 8) | (layerend ? 0x10000 : 0);
+}
+
 int64_t CPacket::getFrameDeadline() const
 {
-   // Reuse m_iTimeStamp (alias to m_nHeader[2]) for frame deadline
-   return (int64_t)m_iTimeStamp;
+   // read [1] bit 3~14: offset from the timestamp, 4-bit exponent and 8-bit mantissa; the classic header has none
+   if (CHeaderFormat<HDR_FRAME>::m_iSize > (int)m_PacketVector[0].iov_len)
+      return 0;
+
+   int code = (m_nHeader[1] >> 17) & 0xFFF;
+   if (0 == code)
+      return 0;
+
+   int exp = code >> 8;
+   int64_t offset = (0 == exp) ? (code & 0xFF) : (int64_t(0x100 | (code & 0xFF)) << (exp - 1));
+
+   return int64_t(uint32_t(m_iTimeStamp)) + offset;
 }
 
 void CPacket::setFrameDeadline(int64_t deadline_us)
 {
-   // Store lower 32 bits of deadline in timestamp field
-   m_iTimeStamp = (int32_t)(deadline_us & 0xFFFFFFFF);
+   int code = 0;
+
+   if (0 != deadline_us)
+   {
+      // the timestamp wraps, the deadline on the sender's time base does not
+      int64_t offset = CTimeStamp::tscmp(deadline_us, m_iTimeStamp);
+      if (offset < 1)
+         offset = 1;
+      else if (offset > m_iMaxDeadlineOffset)
+         offset = m_iMaxDeadlineOffset;
+
+      if (offset < 0x100)
+         code = int(offset);
+      else
+      {
+         int exp = 1;
+         while ((offset >> exp) >= 0x100)
+            ++ exp;
+         code = (exp << 8) | int((offset >> (exp - 1)) & 0xFF);
+      }
+   }
+
+   // clear bits 3-14, then set the deadline code
+   m_nHeader[1] = (m_nHeader[1] & 0xE001FFFF) | (uint32_t(code) << 17);
 }
 
 CPacket* CPacket::clone() const
 {
    CPacket* pkt = new CPacket;
    memcpy(pkt->m_nHeader, m_nHeader, m_iPktHdrSize);
+   pkt->m_PacketVector[0].iov_len = m_PacketVector[0].iov_len;
    pkt->m_pcData = new char[m_PacketVector[1].iov_len];
    memcpy(pkt->m_pcData, m_pcData, m_PacketVector[1].iov_len);
    pkt->m_PacketVector[1].iov_len = m_PacketVector[1].iov_len;
@@ -410,7 +549,8 @@ m_iMSS(0),
 m_iFlightFlagSize(0),
 m_iReqType(0),
 m_iID(0),
-m_iCookie(0)
+m_iCookie(0),
+m_iExtension(0)
 {
    for (int i = 0; i < 4; ++ i)
       m_piPeerIP[i] = 0;
@@ -433,7 +573,14 @@ int CHandShake::serialize(char* buf, int& size)
    for (int i = 0; i < 4; ++ i)
       *p++ = m_piPeerIP[i];
 
-   size = m_iContentSize;
+   // the extension word is only sent when there is one, so that a stock peer sees the classic size
+   if ((0 != m_iExtension) && (size >= m_iExtContentSize))
+   {
+      *p++ = m_iExtension;
+      size = m_iExtContentSize;
+   }
+   else
+      size = m_iContentSize;
 
    return 0;
 }
@@ -454,6 +601,7 @@ int CHandShake::deserialize(const char* buf, int size)
    m_iCookie = *p++;
    for (int i = 0; i < 4; ++ i)
       m_piPeerIP[i] = *p++;
+   m_iExtension = (size >= m_iExtContentSize) ? *p : 0;
 
    return 0;
 }
@@ -54,6 +54,38 @@ written by
 
 class CChannel;
 
+   // Layouts of the data packet header. The classic one is the 16-byte header of UDT4; the frame one adds a word for
+   // the VR frame fields and takes bit 3~14 of the message number field for the frame deadline; the layered one adds
+   // another word for the layer of the chunk and the number of chunks the frame cannot be used without.
+   // Control packets always have the classic layout.
+enum UDTHeaderFormat {HDR_CLASSIC = 0, HDR_FRAME = 1, HDR_LAYERED = 2};
+
+template <int FORMAT> struct CHeaderFormat;
+
+template <> struct CHeaderFormat<HDR_CLASSIC>
+{
+   static const int m_iSize = 16;			// header size, in bytes
+   static const uint32_t m_iMsgNoMask = 0x1FFFFFFF;	// bits of header field [1] that carry the message number
+   static const bool m_bFrame = false;			// whether the frame fields and the deadline are carried
+   static const bool m_bLayered = false;		// whether the layer fields are carried
+};
+
+template <> struct CHeaderFormat<HDR_FRAME>
+{
+   static const int m_iSize = 20;
+   static const uint32_t m_iMsgNoMask = 0x0001FFFF;
+   static const bool m_bFrame = true;
+   static const bool m_bLayered = false;
+};
+
+template <> struct CHeaderFormat<HDR_LAYERED>
+{
+   static const int m_iSize = 24;
+   static const uint32_t m_iMsgNoMask = 0x0001FFFF;
+   static const bool m_bFrame = true;
+   static const bool m_bLayered = true;
+};
+
 class CPacket
 {
 friend class CChannel;
@@ -67,7 +99,8 @@ public:
    int32_t& m_iID;			// alias: socket ID
    char*& m_pcData;                     // alias: data/control information
 
-   static const int m_iPktHdrSize;	// packet header size
+   static const int m_iPktHdrSize;	// size of the largest packet header, which every packet is received into
+   static const int m_iMaxDeadlineOffset;	// VR Frame Awareness: largest deadline offset from the timestamp that the header can carry, in microseconds
 
 public:
    CPacket();
@@ -103,6 +136,35 @@ public:
 
    void pack(int pkttype, void* lparam = NULL, void* rparam = NULL, int size = 0);
 
+      // Functionality:
+      //    Read the size of the packet header.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    CHeaderFormat<>::m_iSize of the layout of the packet.
+
+   int getHeaderSize() const;
+
+      // Functionality:
+      //    Read the header size of a layout chosen at run time.
+      // Parameters:
+      //    0) [in] format: layout of the header, see UDTHeaderFormat.
+      // Returned value:
+      //    CHeaderFormat<format>::m_iSize.
+
+   static int getFormatSize(int format);
+
+      // Functionality:
+      //    Give the words read past a shorter header back to the payload or the control information.
+      //    Packets are received as if they had the largest header; this undoes it for those that do not.
+      //    The header must have been converted to host order already.
+      // Parameters:
+      //    0) [in] size: CHeaderFormat<>::m_iSize of the layout the packet actually has.
+      // Returned value:
+      //    None.
+
+   void trimHeader(int size);
+
       // Functionality:
       //    Read the packet vector.
       // Parameters:
@@ -171,7 +233,7 @@ public:
       // Parameters:
       //    None.
       // Returned value:
-      //    packet header field [1] (bit 3~31).
+      //    packet header field [1] (bit 3~31, or bit 15~31 with the frame and layered headers).
 
    int32_t getMsgSeq() const;
 
@@ -229,26 +291,107 @@ public:
 
    void setTotalChunks(int32_t total_chunks);
 
+      // Functionality:
+      //    Set the frame ID, the chunk ID and the total number of chunks in one store (for VR streaming).
+      //    The packet has the frame header afterwards.
+      // Parameters:
+      //    0) [in] frame_id: Frame ID to set (0-65535).
+      //    1) [in] chunk_id: Chunk ID to set (0-255).
+      //    2) [in] total_chunks: Total chunks to set (0-255).
+      // Returned value:
+      //    None.
+
+   void setFrameInfo(int32_t frame_id, int32_t chunk_id, int32_t total_chunks);
+
       // Functionality:
       //    Read the frame deadline timestamp (for VR streaming).
-      //    This reuses the timestamp field (m_nHeader[2]) which UDT doesn't actually use.
+      //    The deadline is carried as an offset from the packet timestamp (m_nHeader[2]),
+      //    in the 12 bits of m_nHeader[1] above the message number.
       // Parameters:
       //    None.
       // Returned value:
-      //    Frame deadline in microseconds (32 bits).
+      //    Frame deadline in microseconds, on the time base of the timestamp, or 0 if there is none.
 
    int64_t getFrameDeadline() const;
 
       // Functionality:
       //    Set the frame deadline timestamp (for VR streaming).
-      //    This reuses the timestamp field (m_nHeader[2]).
+      //    Must be called after the timestamp is set. The offset from the timestamp is stored with
+      //    a relative precision of 1/256, rounded down; a deadline that has passed is stored as 1us
+      //    after the timestamp, and one beyond m_iMaxDeadlineOffset is capped.
       // Parameters:
-      //    0) [in] deadline_us: Deadline timestamp in microseconds.
+      //    0) [in] deadline_us: Deadline timestamp in microseconds, 0 for none.
       // Returned value:
       //    None.
 
    void setFrameDeadline(int64_t deadline_us);
 
+      // Functionality:
+      //    Read the layer of the chunk (for layered VR frames).
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    Layer (priority class) of the chunk, 0 for the base layer and for packets without the layered header.
+
+   int getLayer() const;
+
+      // Functionality:
+      //    Read the number of leading chunks that the frame of the chunk cannot be used without (for layered VR frames).
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    Number of required chunks, 0 if the packet does not have the layered header.
+
+   int getRequiredChunks() const;
+
+      // Functionality:
+      //    Query if the chunk is the last one of its layer (for layered VR frames).
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    true if a layer ends with the chunk, otherwise false.
+
+   bool isLayerEnd() const;
+
+      // Functionality:
+      //    Set the layer fields (for layered VR frames).
+      // Parameters:
+      //    0) [in] layer: layer (priority class) of the chunk (0-255), 0 for the base layer.
+      //    1) [in] required: number of leading chunks that the frame cannot be used without (0-255).
+      //    2) [in] layerend: if the chunk is the last one of its layer.
+      // Returned value:
+      //    None.
+
+   void setLayerInfo(int32_t layer, int32_t required, bool layerend);
+
+      // Functionality:
+      //    Lay out the header of a data packet in the given format, with the frame and layer fields if it has them.
+      //    Must be called after the timestamp is set.
+      // Parameters:
+      //    0) [in] frame_id: Frame ID.
+      //    1) [in] chunk_id: Chunk ID.
+      //    2) [in] total_chunks: Total chunks.
+      //    3) [in] deadline_us: Deadline timestamp in microseconds, 0 for none.
+      //    4) [in] layer: layer of the chunk.
+      //    5) [in] required: number of required chunks of the frame.
+      //    6) [in] layerend: if the chunk is the last one of its layer.
+      // Returned value:
+      //    None.
+
+   template <int FORMAT>
+   void setHeaderFormat(int32_t frame_id, int32_t chunk_id, int32_t total_chunks, int64_t deadline_us,
+                        int32_t layer = 0, int32_t required = 0, bool layerend = false)
+   {
+      if (CHeaderFormat<FORMAT>::m_bFrame)
+      {
+         setFrameInfo(frame_id, chunk_id, total_chunks);
+         setFrameDeadline(deadline_us);
+      }
+      if (CHeaderFormat<FORMAT>::m_bLayered)
+         setLayerInfo(layer, required, layerend);
+      m_PacketVector[0].iov_len = CHeaderFormat<FORMAT>::m_iSize;
+   }
+
       // Functionality:
       //    Clone this packet.
       // Parameters:
@@ -259,7 +402,7 @@ public:
    CPacket* clone() const;
 
 protected:
-   uint32_t m_nHeader[5];               // The 160-bit header field (extended for VR frame metadata)
+   uint32_t m_nHeader[6];               // The 192-bit header field (extended for VR frame and layer metadata)
    iovec m_PacketVector[2];             // The 2-demension vector of UDT packet [header, data]
 
    int32_t __pad;
@@ -280,6 +423,12 @@ public:
 
 public:
    static const int m_iContentSize;	// Size of hand shake data
+   static const int m_iExtContentSize;	// Size with the extension word, which older peers neither send nor read
+
+   static const int32_t m_iExtShmem;	// extension bit: the peers talk over shared memory
+   static const int32_t m_iExtFrameHeader;	// extension bit: data packets have the frame header (HDR_FRAME)
+   static const int32_t m_iExtAckNak;	// extension bit: a full ACK may carry a loss list after its 28 bytes
+   static const int32_t m_iExtFrameLayers;	// extension bit: data packets have the layered frame header (HDR_LAYERED)
 
 public:
    int32_t m_iVersion;          // UDT version
@@ -291,6 +440,7 @@ public:
    int32_t m_iID;		// socket ID
    int32_t m_iCookie;		// cookie
    uint32_t m_piPeerIP[4];	// The IP address that the peer's UDP port is bound to
+   int32_t m_iExtension;	// extensions offered in a request, or agreed in a response; 0 if none
 };
 
 
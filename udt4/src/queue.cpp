@@ -45,6 +45,9 @@ written by
       #include <wspiapi.h>
    #endif
 #endif
+#ifdef LINUX
+   #include <sys/prctl.h>
+#endif
 #include <cstring>
 
 #include "common.h"
@@ -55,13 +58,23 @@ using namespace std;
 
 CUnitQueue::CUnitQueue():
 m_pQEntry(NULL),
-m_pCurrQueue(NULL),
 m_pLastQueue(NULL),
+m_pFreeUnit(NULL),
+m_iFreeUnits(0),
+m_pReleasedUnit(NULL),
+m_iReleasedUnits(0),
+m_UnitLock(),
 m_iSize(0),
-m_iCount(0),
+m_iBlockSize(0),
+m_ullLastShrink(0),
 m_iMSS(),
 m_iIPversion()
 {
+   #ifndef WIN32
+      pthread_mutex_init(&m_UnitLock, NULL);
+   #else
+      m_UnitLock = CreateMutex(NULL, false, NULL);
+   #endif
 }
 
 CUnitQueue::~CUnitQueue()
@@ -80,19 +93,28 @@ CUnitQueue::~CUnitQueue()
          p = p->m_pNext;
       delete q;
    }
+
+   #ifndef WIN32
+      pthread_mutex_destroy(&m_UnitLock);
+   #else
+      CloseHandle(m_UnitLock);
+   #endif
 }
 
-int CUnitQueue::init(int size, int mss, int version)
+CUnitQueue::CQEntry* CUnitQueue::allocBlock(int size)
 {
    CQEntry* tempq = NULL;
    CUnit* tempu = NULL;
    char* tempb = NULL;
 
+   // each packet buffer starts on its own cache line
+   int stride = (m_iMSS + 63) & ~63;
+
    try
    {
       tempq = new CQEntry;
       tempu = new CUnit [size];
-      tempb = new char [size * mss];
+      tempb = new char [size * stride + 63];
    }
    catch (...)
    {
@@ -100,128 +122,201 @@ int CUnitQueue::init(int size, int mss, int version)
       delete [] tempu;
       delete [] tempb;
 
-      return -1;
+      return NULL;
    }
 
+   char* data = (char*)(((uintptr_t)tempb + 63) & ~(uintptr_t)63);
    for (int i = 0; i < size; ++ i)
    {
       tempu[i].m_iFlag = 0;
-      tempu[i].m_Packet.m_pcData = tempb + i * mss;
+      tempu[i].m_Packet.m_pcData = data + i * stride;
+      tempu[i].m_pNext = (i + 1 < size) ? tempu + i + 1 : m_pFreeUnit;
    }
    tempq->m_pUnit = tempu;
    tempq->m_pBuffer = tempb;
    tempq->m_iSize = size;
 
-   m_pQEntry = m_pCurrQueue = m_pLastQueue = tempq;
-   m_pQEntry->m_pNext = m_pQEntry;
+   // the new units are all free
+   m_pFreeUnit = tempu;
+   m_iFreeUnits += size;
 
-   m_pAvailUnit = m_pCurrQueue->m_pUnit;
+   return tempq;
+}
 
-   m_iSize = size;
+int CUnitQueue::init(int size, int mss, int version)
+{
    m_iMSS = mss;
    m_iIPversion = version;
 
+   CQEntry* tempq = allocBlock(size);
+   if (NULL == tempq)
+      return -1;
+
+   m_pQEntry = m_pLastQueue = tempq;
+   m_pQEntry->m_pNext = m_pQEntry;
+
+   m_iSize = m_iBlockSize = size;
+   CTimer::rdtsc(m_ullLastShrink);
+
    return 0;
 }
 
 int CUnitQueue::increase()
 {
-   // adjust/correct m_iCount
-   int real_count = 0;
-   CQEntry* p = m_pQEntry;
-   while (p != NULL)
+   CQEntry* tempq = allocBlock(m_iBlockSize);
+   if (NULL == tempq)
+      return -1;
+
+   m_pLastQueue->m_pNext = tempq;
+   m_pLastQueue = tempq;
+   m_pLastQueue->m_pNext = m_pQEntry;
+
+   m_iSize += m_iBlockSize;
+
+   return 0;
+}
+
+int CUnitQueue::shrink()
+{
+   uint64_t currtime;
+   CTimer::rdtsc(currtime);
+   if ((m_iSize == m_iBlockSize) || (currtime - m_ullLastShrink < 1000000 * CTimer::getCPUFrequency()))
+      return 0;
+   m_ullLastShrink = currtime;
+
+   CGuard unitguard(m_UnitLock);
+
+   // no unit can become free while the lock is held, so every free unit is on one of the two lists now
+   if ((m_iFreeUnits + m_iReleasedUnits) * 2 < m_iSize + m_iBlockSize)
+      return 0;
+
+   int released = 0;
+
+   CQEntry* prev = m_pQEntry;
+   CQEntry* p = m_pQEntry->m_pNext;
+   while ((p != m_pQEntry) && ((m_iFreeUnits + m_iReleasedUnits - p->m_iSize) * 2 >= m_iSize - p->m_iSize))
    {
       CUnit* u = p->m_pUnit;
-      for (CUnit* end = u + p->m_iSize; u != end; ++ u)
-         if (u->m_iFlag != 0)
-            ++ real_count;
+      CUnit* end = u + p->m_iSize;
+      while ((u != end) && (0 == u->m_iFlag))
+         ++ u;
 
-      if (p == m_pLastQueue)
-         p = NULL;
-      else
+      if (u != end)
+      {
+         prev = p;
          p = p->m_pNext;
-   }
-   m_iCount = real_count;
-   if (double(m_iCount) / m_iSize < 0.9)
-      return -1;
+         continue;
+      }
 
-   CQEntry* tempq = NULL;
-   CUnit* tempu = NULL;
-   char* tempb = NULL;
+      // mark the units of the block, so that they can be taken off the free lists in one pass
+      for (u = p->m_pUnit; u != end; ++ u)
+         u->m_iFlag = -1;
 
-   // all queues have the same size
-   int size = m_pQEntry->m_iSize;
+      CUnit** lists[2] = {&m_pFreeUnit, &m_pReleasedUnit};
+      int* counts[2] = {&m_iFreeUnits, &m_iReleasedUnits};
+      for (int i = 0; i < 2; ++ i)
+      {
+         for (CUnit** q = lists[i]; NULL != *q;)
+         {
+            if (-1 == (*q)->m_iFlag)
+            {
+               *q = (*q)->m_pNext;
+               -- *counts[i];
+            }
+            else
+               q = &((*q)->m_pNext);
+         }
+      }
 
-   try
-   {
-      tempq = new CQEntry;
-      tempu = new CUnit [size];
-      tempb = new char [size * m_iMSS];
-   }
-   catch (...)
-   {
-      delete tempq;
-      delete [] tempu;
-      delete [] tempb;
+      prev->m_pNext = p->m_pNext;
+      if (p == m_pLastQueue)
+         m_pLastQueue = prev;
 
-      return -1;
+      m_iSize -= p->m_iSize;
+      released += p->m_iSize;
+
+      delete [] p->m_pUnit;
+      delete [] p->m_pBuffer;
+      delete p;
+
+      p = prev->m_pNext;
    }
 
-   for (int i = 0; i < size; ++ i)
+   return released;
+}
+
+CUnit* CUnitQueue::getNextAvailUnit()
+{
+   if (NULL == m_pFreeUnit)
    {
-      tempu[i].m_iFlag = 0;
-      tempu[i].m_Packet.m_pcData = tempb + i * m_iMSS;
+      // take over everything the receiver buffers have freed since the last time
+      CGuard::enterCS(m_UnitLock);
+      m_pFreeUnit = m_pReleasedUnit;
+      m_iFreeUnits = m_iReleasedUnits;
+      m_pReleasedUnit = NULL;
+      m_iReleasedUnits = 0;
+      CGuard::leaveCS(m_UnitLock);
+
+      if ((NULL == m_pFreeUnit) && (increase() < 0))
+         return NULL;
    }
-   tempq->m_pUnit = tempu;
-   tempq->m_pBuffer = tempb;
-   tempq->m_iSize = size;
 
-   m_pLastQueue->m_pNext = tempq;
-   m_pLastQueue = tempq;
-   m_pLastQueue->m_pNext = m_pQEntry;
+   CUnit* unit = m_pFreeUnit;
+   m_pFreeUnit = unit->m_pNext;
+   -- m_iFreeUnits;
 
-   m_iSize += size;
+   // a receiver buffer that takes the unit marks it occupied, so this tells putBackUnits() if it is still unused
+   unit->m_iFlag = -1;
 
-   return 0;
+   return unit;
 }
 
-int CUnitQueue::shrink()
+int CUnitQueue::getAvailUnits(CUnit** units, int num)
 {
-   // currently queue cannot be shrunk.
-   return -1;
-}
+   int count = 0;
 
-CUnit* CUnitQueue::getNextAvailUnit()
-{
-   if (m_iCount * 10 > m_iSize * 9)
-      increase();
+   while (count < num)
+   {
+      CUnit* unit = getNextAvailUnit();
+      if (NULL == unit)
+         break;
 
-   if (m_iCount >= m_iSize)
-      return NULL;
+      units[count ++] = unit;
+   }
 
-   CQEntry* entrance = m_pCurrQueue;
+   return count;
+}
 
-   do
+void CUnitQueue::putBackUnits(CUnit** units, int num)
+{
+   for (int i = num - 1; i >= 0; -- i)
    {
-      for (CUnit* sentinel = m_pCurrQueue->m_pUnit + m_pCurrQueue->m_iSize - 1; m_pAvailUnit != sentinel; ++ m_pAvailUnit)
-         if (m_pAvailUnit->m_iFlag == 0)
-            return m_pAvailUnit;
-
-      if (m_pCurrQueue->m_pUnit->m_iFlag == 0)
-      {
-         m_pAvailUnit = m_pCurrQueue->m_pUnit;
-         return m_pAvailUnit;
-      }
-
-      m_pCurrQueue = m_pCurrQueue->m_pNext;
-      m_pAvailUnit = m_pCurrQueue->m_pUnit;
-   } while (m_pCurrQueue != entrance);
+      // a unit taken by a receiver buffer may even have been read and freed already
+      if (-1 != units[i]->m_iFlag)
+         continue;
+
+      units[i]->m_iFlag = 0;
+      units[i]->m_pNext = m_pFreeUnit;
+      m_pFreeUnit = units[i];
+      ++ m_iFreeUnits;
+   }
+}
 
-   increase();
+void CUnitQueue::makeUnitFree(CUnit* unit)
+{
+   CGuard unitguard(m_UnitLock);
 
-   return NULL;
+   unit->m_iFlag = 0;
+   unit->m_pNext = m_pReleasedUnit;
+   m_pReleasedUnit = unit;
+   ++ m_iReleasedUnits;
 }
 
+void CUnitQueue::leak()
+{
+   // the destructor walks the blocks from here
+   m_pQEntry = NULL;
+}
 
 CSndUList::CSndUList():
 m_pHeap(NULL),
@@ -230,7 +325,8 @@ m_iLastEntry(-1),
 m_ListLock(),
 m_pWindowLock(NULL),
 m_pWindowCond(NULL),
-m_pTimer(NULL)
+m_pTimer(NULL),
+m_ullPacingSlack(0)
 {
    m_pHeap = new CSNode*[m_iArrayLength];
 
@@ -310,22 +406,36 @@ int CSndUList::pop(sockaddr*& addr, CPacket& pkt)
    if (-1 == m_iLastEntry)
       return -1;
 
-   // no pop until the next schedulled time
-   uint64_t ts;
-   CTimer::rdtsc(ts);
-   if (ts < m_pHeap[0]->m_llTimeStamp)
+   // no pop until the next schedulled time, less the pacing slack
+   uint64_t currtime;
+   CTimer::rdtsc(currtime);
+   if (currtime + m_ullPacingSlack < m_pHeap[0]->m_llTimeStamp)
       return -1;
 
    CUDT* u = m_pHeap[0]->m_pUDT;
+   uint64_t sched = m_pHeap[0]->m_llTimeStamp;
    remove_(u);
 
    if (!u->m_bConnected || u->m_bBroken)
       return -1;
 
    // pack a packet from the socket
+   uint64_t ts;
    if (u->packData(pkt, ts) <= 0)
       return -1;
 
+   // pacing error, early or late, of a packet that had a scheduled time (1 asks for immediate sending)
+   if (sched > 1)
+   {
+      uint64_t error = (currtime > sched) ? currtime - sched : sched - currtime;
+      CGuard::enterCS(u->m_StatsLock);
+      u->m_llTracePacingError += error;
+      ++ u->m_llTracePacingCount;
+      if (error > u->m_ullMaxPacingError)
+         u->m_ullMaxPacingError = error;
+      CGuard::leaveCS(u->m_StatsLock);
+   }
+
    addr = u->m_pPeerAddr;
 
    // insert a new entry, ts is the next processing time
@@ -444,6 +554,8 @@ void CSndUList::remove_(const CUDT* u)
 //
 CSndQueue::CSndQueue():
 m_WorkerThread(),
+m_iBatchSize(0),
+m_iBatchSent(0),
 m_pSndUList(NULL),
 m_pChannel(NULL),
 m_pTimer(NULL),
@@ -452,6 +564,9 @@ m_WindowCond(),
 m_bClosing(false),
 m_ExitCond()
 {
+   for (int i = 0; i < CChannel::m_iMaxBatchSize; ++ i)
+      m_pBatchPkt[i] = m_BatchPkt + i;
+
    #ifndef WIN32
       pthread_cond_init(&m_WindowCond, NULL);
       pthread_mutex_init(&m_WindowLock, NULL);
@@ -487,7 +602,7 @@ CSndQueue::~CSndQueue()
    delete m_pSndUList;
 }
 
-void CSndQueue::init(CChannel* c, CTimer* t)
+void CSndQueue::init(CChannel* c, CTimer* t, int slack)
 {
    m_pChannel = c;
    m_pTimer = t;
@@ -495,6 +610,7 @@ void CSndQueue::init(CChannel* c, CTimer* t)
    m_pSndUList->m_pWindowLock = &m_WindowLock;
    m_pSndUList->m_pWindowCond = &m_WindowCond;
    m_pSndUList->m_pTimer = m_pTimer;
+   m_pSndUList->m_ullPacingSlack = slack * CTimer::getCPUFrequency();
 
    #ifndef WIN32
       if (0 != pthread_create(&m_WorkerThread, NULL, CSndQueue::worker, this))
@@ -503,8 +619,7 @@ void CSndQueue::init(CChannel* c, CTimer* t)
          throw CUDTException(3, 1);
       }
    #else
-      DWORD threadID;
-      m_WorkerThread = CreateThread(NULL, 0, CSndQueue::worker, this, 0, &threadID);
+      m_WorkerThread = CreateThread(NULL, 0, CSndQueue::worker, this, 0, &m_WorkerThreadID);
       if (NULL == m_WorkerThread)
          throw CUDTException(3, 1);
    #endif
@@ -518,25 +633,37 @@ void CSndQueue::init(CChannel* c, CTimer* t)
 {
    CSndQueue* self = (CSndQueue*)param;
 
+   #ifdef LINUX
+      // the pacing timer sleeps until shortly before a deadline, the default 50us timer slack would overshoot it
+      prctl(PR_SET_TIMERSLACK, 1000, 0, 0, 0);
+   #endif
+
+   const uint64_t slack = self->m_pSndUList->m_ullPacingSlack;
+
    while (!self->m_bClosing)
    {
       uint64_t ts = self->m_pSndUList->getNextProcTime();
 
       if (ts > 0)
       {
-         // wait until next processing time of the first socket on the list
+         // wait until next processing time of the first socket on the list, less the pacing slack
          uint64_t currtime;
          CTimer::rdtsc(currtime);
-         if (currtime < ts)
-            self->m_pTimer->sleepto(ts);
+         if (currtime + slack < ts)
+            self->m_pTimer->sleepto(ts - slack);
 
-         // it is time to send the next pkt
-         sockaddr* addr;
-         CPacket pkt;
-         if (self->m_pSndUList->pop(addr, pkt) < 0)
-            continue;
+         // it is time to send the next pkt, together with any others, of any socket, that are due within the slack
+         do
+         {
+            if (self->m_pSndUList->pop(self->m_pBatchAddr[self->m_iBatchSize], self->m_BatchPkt[self->m_iBatchSize]) >= 0)
+               ++ self->m_iBatchSize;
+
+            ts = self->m_pSndUList->getNextProcTime();
+            CTimer::rdtsc(currtime);
+         } while ((self->m_iBatchSize < CChannel::m_iMaxBatchSize) && (ts > 0) && (ts <= currtime + slack));
 
-         self->m_pChannel->sendto(addr, pkt);
+         self->flushBatch();
+         self->m_iBatchSize = self->m_iBatchSent = 0;
       }
       else
       {
@@ -562,11 +689,31 @@ void CSndQueue::init(CChannel* c, CTimer* t)
 
 int CSndQueue::sendto(const sockaddr* addr, CPacket& packet)
 {
+   // a control packet generated by the worker itself (e.g., a drop request) must not overtake the packets it has packed before
+   #ifndef WIN32
+      if ((m_iBatchSize > m_iBatchSent) && pthread_equal(pthread_self(), m_WorkerThread))
+   #else
+      if ((m_iBatchSize > m_iBatchSent) && (GetCurrentThreadId() == m_WorkerThreadID))
+   #endif
+      flushBatch();
+
    // send out the packet immediately (high priority), this is a control packet
    m_pChannel->sendto(addr, packet);
    return packet.getLength();
 }
 
+void CSndQueue::flushBatch()
+{
+   // packets are never moved within the batch, as one may be being packed while a control packet flushes the rest
+   int num = m_iBatchSize - m_iBatchSent;
+   if (1 == num)
+      m_pChannel->sendto(m_pBatchAddr[m_iBatchSent], m_BatchPkt[m_iBatchSent]);
+   else if (num > 1)
+      m_pChannel->sendto(m_pBatchAddr + m_iBatchSent, m_pBatchPkt + m_iBatchSent, num);
+
+   m_iBatchSent = m_iBatchSize;
+}
+
 
 //
 CRcvUList::CRcvUList():
@@ -873,28 +1020,43 @@ m_pHash(NULL),
 m_pChannel(NULL),
 m_pTimer(NULL),
 m_iPayloadSize(),
+m_pcDiscard(NULL),
 m_bClosing(false),
 m_ExitCond(),
+m_pHSQueue(NULL),
+m_pcHSData(NULL),
+m_iHSHead(0),
+m_iHSCount(0),
+m_iHSDropped(0),
+m_HSLock(),
+m_HSCond(),
 m_LSLock(),
 m_pListener(NULL),
 m_pRendezvousQueue(NULL),
 m_vNewEntry(),
 m_IDLock(),
 m_mBuffer(),
+m_vPktPool(),
 m_PassLock(),
 m_PassCond()
 {
    #ifndef WIN32
       pthread_mutex_init(&m_PassLock, NULL);
       pthread_cond_init(&m_PassCond, NULL);
+      pthread_mutex_init(&m_HSLock, NULL);
+      pthread_cond_init(&m_HSCond, NULL);
       pthread_mutex_init(&m_LSLock, NULL);
       pthread_mutex_init(&m_IDLock, NULL);
+      m_AcceptThread = 0;
    #else
       m_PassLock = CreateMutex(NULL, false, NULL);
       m_PassCond = CreateEvent(NULL, false, false, NULL);
+      m_HSLock = CreateMutex(NULL, false, NULL);
+      m_HSCond = CreateEvent(NULL, false, false, NULL);
       m_LSLock = CreateMutex(NULL, false, NULL);
       m_IDLock = CreateMutex(NULL, false, NULL);
       m_ExitCond = CreateEvent(NULL, false, false, NULL);
+      m_AcceptThread = NULL;
    #endif
 }
 
@@ -905,21 +1067,41 @@ CRcvQueue::~CRcvQueue()
    #ifndef WIN32
       if (0 != m_WorkerThread)
          pthread_join(m_WorkerThread, NULL);
+      if (0 != m_AcceptThread)
+      {
+         pthread_mutex_lock(&m_HSLock);
+         pthread_cond_signal(&m_HSCond);
+         pthread_mutex_unlock(&m_HSLock);
+         pthread_join(m_AcceptThread, NULL);
+      }
       pthread_mutex_destroy(&m_PassLock);
       pthread_cond_destroy(&m_PassCond);
+      pthread_mutex_destroy(&m_HSLock);
+      pthread_cond_destroy(&m_HSCond);
       pthread_mutex_destroy(&m_LSLock);
       pthread_mutex_destroy(&m_IDLock);
    #else
       if (NULL != m_WorkerThread)
          WaitForSingleObject(m_ExitCond, INFINITE);
       CloseHandle(m_WorkerThread);
+      if (NULL != m_AcceptThread)
+      {
+         SetEvent(m_HSCond);
+         WaitForSingleObject(m_AcceptThread, INFINITE);
+         CloseHandle(m_AcceptThread);
+      }
       CloseHandle(m_PassLock);
       CloseHandle(m_PassCond);
+      CloseHandle(m_HSLock);
+      CloseHandle(m_HSCond);
       CloseHandle(m_LSLock);
       CloseHandle(m_IDLock);
       CloseHandle(m_ExitCond);
    #endif
 
+   delete [] m_pHSQueue;
+   delete [] m_pcHSData;
+
    delete m_pRcvUList;
    delete m_pHash;
    delete m_pRendezvousQueue;
@@ -935,11 +1117,20 @@ CRcvQueue::~CRcvQueue()
          i->second.pop();
       }
    }
+
+   for (vector<CPacket*>::iterator i = m_vPktPool.begin(); i != m_vPktPool.end(); ++ i)
+   {
+      delete [] (*i)->m_pcData;
+      delete *i;
+   }
+
+   delete [] m_pcDiscard;
 }
 
 void CRcvQueue::init(int qsize, int payload, int version, int hsize, CChannel* cc, CTimer* t)
 {
    m_iPayloadSize = payload;
+   m_pcDiscard = new char[payload];
 
    m_UnitQueue.init(qsize, payload, version);
 
@@ -974,16 +1165,22 @@ void CRcvQueue::init(int qsize, int payload, int version, int hsize, CChannel* c
 {
    CRcvQueue* self = (CRcvQueue*)param;
 
-   sockaddr* addr = (AF_INET == self->m_UnitQueue.m_iIPversion) ? (sockaddr*) new sockaddr_in : (sockaddr*) new sockaddr_in6;
+   // source addresses and units of a batch of incoming packets
+   sockaddr* addrs[CChannel::m_iMaxBatchSize];
+   for (int i = 0; i < CChannel::m_iMaxBatchSize; ++ i)
+      addrs[i] = (AF_INET == self->m_UnitQueue.m_iIPversion) ? (sockaddr*) new sockaddr_in : (sockaddr*) new sockaddr_in6;
+   CUnit* units[CChannel::m_iMaxBatchSize];
+   CPacket* packets[CChannel::m_iMaxBatchSize];
+   int num;
+
+   sockaddr* addr = addrs[0];
+   CUnit* unit = NULL;
    CUDT* u = NULL;
    int32_t id;
+   int posted = 0;
 
    while (!self->m_bClosing)
    {
-      #ifdef NO_BUSY_WAITING
-         self->m_pTimer->tick();
-      #endif
-
       // check waiting list, if new socket, insert it to the list
       while (self->ifNewEntry())
       {
@@ -995,70 +1192,132 @@ void CRcvQueue::init(int qsize, int payload, int version, int hsize, CChannel* c
          }
       }
 
-      // find next available slot for incoming packet
-      CUnit* unit = self->m_UnitQueue.getNextAvailUnit();
-      if (NULL == unit)
+      int avail;
+      if (self->m_pChannel->isRecvPosted())
       {
-         // no space, skip this packet
+         // keep receives posted into free units, for the kernel to fill them without a copy
+         CUnit* next;
+         while ((posted < CChannel::m_iMaxPosted) && (NULL != (next = self->m_UnitQueue.getNextAvailUnit())))
+         {
+            next->m_Packet.setLength(self->m_iPayloadSize);
+            if (!self->m_pChannel->postRecv(&(next->m_Packet), next))
+            {
+               self->m_UnitQueue.putBackUnits(&next, 1);
+               break;
+            }
+            ++ posted;
+         }
+
+         // with no unit to post into, a packet is read and dropped as below
+         if (posted > 0)
+         {
+            // the wait ends with the first packet, or when the first socket on the list is due for its timer check
+            uint64_t currtime;
+            CTimer::rdtsc(currtime);
+            int timeout = 10000;
+            CRNode* first = self->m_pRcvUList->m_pUList;
+            if (NULL != first)
+            {
+               uint64_t due = first->m_llTimeStamp + 100000 * CTimer::getCPUFrequency();
+               if (due <= currtime)
+                  timeout = 0;
+               else if ((due - currtime) / CTimer::getCPUFrequency() < 10000)
+                  timeout = (due - currtime) / CTimer::getCPUFrequency();
+            }
+
+            avail = num = self->m_pChannel->waitRecv((void**)units, addrs, CChannel::m_iMaxBatchSize, timeout);
+            posted -= num;
+            goto DISPATCH;
+         }
+      }
+
+      // find next available slots for incoming packets, enough for a whole batch
+      avail = self->m_UnitQueue.getAvailUnits(units, CChannel::m_iMaxBatchSize);
+      num = avail;
+      if (0 == num)
+      {
+         // no space, skip this packet, and count it against the socket it was meant for
          CPacket temp;
-         temp.m_pcData = new char[self->m_iPayloadSize];
+         temp.m_pcData = self->m_pcDiscard;
          temp.setLength(self->m_iPayloadSize);
-         self->m_pChannel->recvfrom(addr, temp);
-         delete [] temp.m_pcData;
+         if ((self->m_pChannel->recvfrom(addrs[0], temp) >= 0) && (temp.m_iID > 0) && (NULL != (u = self->m_pHash->lookup(temp.m_iID))))
+         {
+            ++ u->m_iTraceRcvNoUnit;
+            ++ u->m_iRcvNoUnitTotal;
+         }
          goto TIMER_CHECK;
       }
 
-      unit->m_Packet.setLength(self->m_iPayloadSize);
-
-      // reading next incoming packet, recvfrom returns -1 is nothing has been received
-      if (self->m_pChannel->recvfrom(addr, unit->m_Packet) < 0)
-         goto TIMER_CHECK;
+      for (int i = 0; i < num; ++ i)
+      {
+         units[i]->m_Packet.setLength(self->m_iPayloadSize);
+         packets[i] = &(units[i]->m_Packet);
+      }
 
-      id = unit->m_Packet.m_iID;
+      // reading the incoming packets that have arrived, waiting for the first one only
+      num = self->m_pChannel->recvfrom(addrs, packets, num);
 
-      // ID 0 is for connection request, which should be passed to the listening socket or rendezvous sockets
-      if (0 == id)
+DISPATCH:
+      for (int i = 0; i < num; ++ i)
       {
-         if (NULL != self->m_pListener)
-            self->m_pListener->listen(addr, unit->m_Packet);
-         else if (NULL != (u = self->m_pRendezvousQueue->retrieve(addr, id)))
+         addr = addrs[i];
+         unit = units[i];
+         if (unit->m_Packet.getLength() < 0)
+            continue;
+
+         id = unit->m_Packet.m_iID;
+
+         // ID 0 is for connection request, which should be passed to the listening socket or rendezvous sockets;
+         // the listener's are handled by the accept thread, so that a burst of them does not hold up the data
+         if (0 == id)
          {
-            // asynchronous connect: call connect here
-            // otherwise wait for the UDT socket to retrieve this packet
-            if (!u->m_bSynRecving)
-               u->connect(unit->m_Packet);
-            else
-               self->storePkt(id, unit->m_Packet.clone());
+            if (NULL != self->m_pListener)
+               self->pushHandshake(addr, unit->m_Packet);
+            else if (NULL != (u = self->m_pRendezvousQueue->retrieve(addr, id)))
+            {
+               // asynchronous connect: call connect here
+               // otherwise wait for the UDT socket to retrieve this packet
+               if (!u->m_bSynRecving)
+                  u->connect(unit->m_Packet);
+               else
+                  self->storePkt(id, unit->m_Packet);
+            }
          }
-      }
-      else if (id > 0)
-      {
-         if (NULL != (u = self->m_pHash->lookup(id)))
+         else if (id > 0)
          {
-            if (CIPAddress::ipcmp(addr, u->m_pPeerAddr, u->m_iIPversion))
+            if (NULL != (u = self->m_pHash->lookup(id)))
             {
-               if (u->m_bConnected && !u->m_bBroken && !u->m_bClosing)
+               if (CIPAddress::ipcmp(addr, u->m_pPeerAddr, u->m_iIPversion))
                {
-                  if (0 == unit->m_Packet.getFlag())
-                     u->processData(unit);
-                  else
-                     u->processCtrl(unit->m_Packet);
-
-                  u->checkTimers();
-                  self->m_pRcvUList->update(u);
+                  if (u->m_bConnected && !u->m_bBroken && !u->m_bClosing)
+                  {
+                     if (0 == unit->m_Packet.getFlag())
+                        u->processData(unit);
+                     else
+                        u->processCtrl(unit->m_Packet);
+
+                     u->checkTimers();
+                     self->m_pRcvUList->update(u);
+                  }
                }
             }
-         }
-         else if (NULL != (u = self->m_pRendezvousQueue->retrieve(addr, id)))
-         {
-            if (!u->m_bSynRecving)
-               u->connect(unit->m_Packet);
-            else
-               self->storePkt(id, unit->m_Packet.clone());
+            else if (NULL != (u = self->m_pRendezvousQueue->retrieve(addr, id)))
+            {
+               if (!u->m_bSynRecving)
+                  u->connect(unit->m_Packet);
+               else
+                  self->storePkt(id, unit->m_Packet);
+            }
          }
       }
 
+      // the units that no receiver buffer has taken can be used for the next packets
+      self->m_UnitQueue.putBackUnits(units, avail);
+
 TIMER_CHECK:
+      // release the memory of a past burst once the units of a block are all free again
+      self->m_UnitQueue.shrink();
+
       // take care of the timing event for all UDT sockets
 
       uint64_t currtime;
@@ -1090,10 +1349,17 @@ TIMER_CHECK:
       self->m_pRendezvousQueue->updateConnStatus();
    }
 
-   if (AF_INET == self->m_UnitQueue.m_iIPversion)
-      delete (sockaddr_in*)addr;
-   else
-      delete (sockaddr_in6*)addr;
+   // the units are freed with the queue, the kernel must not fill them any more; if it still may, they are never freed
+   if (!self->m_pChannel->cancelRecv())
+      self->m_UnitQueue.leak();
+
+   for (int i = 0; i < CChannel::m_iMaxBatchSize; ++ i)
+   {
+      if (AF_INET == self->m_UnitQueue.m_iIPversion)
+         delete (sockaddr_in*)addrs[i];
+      else
+         delete (sockaddr_in6*)addrs[i];
+   }
 
    #ifndef WIN32
       return NULL;
@@ -1103,6 +1369,107 @@ TIMER_CHECK:
    #endif
 }
 
+#ifndef WIN32
+   void* CRcvQueue::acceptor(void* param)
+#else
+   DWORD WINAPI CRcvQueue::acceptor(LPVOID param)
+#endif
+{
+   CRcvQueue* self = (CRcvQueue*)param;
+
+   while (!self->m_bClosing)
+   {
+      #ifndef WIN32
+         pthread_mutex_lock(&self->m_HSLock);
+         while (!self->m_bClosing && (0 == self->m_iHSCount))
+            pthread_cond_wait(&self->m_HSCond, &self->m_HSLock);
+         pthread_mutex_unlock(&self->m_HSLock);
+      #else
+         while (!self->m_bClosing && (0 == self->getHandshakeNum()))
+            WaitForSingleObject(self->m_HSCond, INFINITE);
+      #endif
+
+      if (self->m_bClosing)
+         break;
+
+      // the head slot is the accept thread's until it is released below, the worker only fills the slots after the queued ones
+      CHandshakeReq* req = self->m_pHSQueue + self->m_iHSHead;
+
+      // the listener may have been closed since the handshake was queued; it is not removed, nor freed, while it answers
+      CGuard::enterCS(self->m_LSLock);
+      CUDT* ls = self->m_pListener;
+      if (NULL != ls)
+      {
+         int64_t wait = CTimer::getTime() - req->m_ullArrival;
+         ls->m_llTraceHSWait += wait;
+         if (wait > ls->m_llMaxHSWait)
+            ls->m_llMaxHSWait = wait;
+
+         ls->listen((sockaddr*)&req->m_Addr, req->m_Packet);
+      }
+
+      CGuard::enterCS(self->m_HSLock);
+      self->m_iHSHead = (self->m_iHSHead + 1) % m_iMaxHSQueue;
+      -- self->m_iHSCount;
+      int dropped = self->m_iHSDropped;
+      self->m_iHSDropped = 0;
+      CGuard::leaveCS(self->m_HSLock);
+
+      // the worker does not wait for the listener to count the handshakes it could not queue
+      if (NULL != ls)
+      {
+         ls->m_iTraceHSDrop += dropped;
+         ls->m_iHSDropTotal += dropped;
+      }
+      CGuard::leaveCS(self->m_LSLock);
+   }
+
+   #ifndef WIN32
+      return NULL;
+   #else
+      return 0;
+   #endif
+}
+
+void CRcvQueue::pushHandshake(const sockaddr* addr, const CPacket& pkt)
+{
+   // anything longer is no handshake
+   int len = pkt.getLength();
+   if (len > m_iMaxHSSize)
+      return;
+
+   CGuard hslock(m_HSLock);
+
+   if (m_iHSCount == m_iMaxHSQueue)
+   {
+      ++ m_iHSDropped;
+      return;
+   }
+
+   CHandshakeReq* req = m_pHSQueue + (m_iHSHead + m_iHSCount) % m_iMaxHSQueue;
+   memcpy(req->m_Packet.m_nHeader, pkt.m_nHeader, CPacket::m_iPktHdrSize);
+   req->m_Packet.m_PacketVector[0].iov_len = pkt.m_PacketVector[0].iov_len;
+   memcpy(req->m_Packet.m_pcData, pkt.m_pcData, len);
+   req->m_Packet.setLength(len);
+   memcpy(&req->m_Addr, addr, (AF_INET == m_UnitQueue.m_iIPversion) ? sizeof(sockaddr_in) : sizeof(sockaddr_in6));
+   req->m_ullArrival = CTimer::getTime();
+
+   if (0 == m_iHSCount ++)
+   {
+      #ifndef WIN32
+         pthread_cond_signal(&m_HSCond);
+      #else
+         SetEvent(m_HSCond);
+      #endif
+   }
+}
+
+int CRcvQueue::getHandshakeNum()
+{
+   CGuard hslock(m_HSLock);
+   return m_iHSCount;
+}
+
 int CRcvQueue::recvfrom(int32_t id, CPacket& packet)
 {
    CGuard bufferlock(m_PassLock);
@@ -1144,11 +1511,11 @@ int CRcvQueue::recvfrom(int32_t id, CPacket& packet)
 
    // copy packet content
    memcpy(packet.m_nHeader, newpkt->m_nHeader, CPacket::m_iPktHdrSize);
+   packet.m_PacketVector[0].iov_len = newpkt->m_PacketVector[0].iov_len;
    memcpy(packet.m_pcData, newpkt->m_pcData, newpkt->getLength());
    packet.setLength(newpkt->getLength());
 
-   delete [] newpkt->m_pcData;
-   delete newpkt;
+   releasePkt(newpkt);
 
    // remove this message from queue, 
    // if no more messages left for this socket, release its data structure
@@ -1166,6 +1533,32 @@ int CRcvQueue::setListener(CUDT* u)
    if (NULL != m_pListener)
       return -1;
 
+   // the accept thread is started with the first listener and serves the queue until it is destroyed
+   #ifndef WIN32
+      if (0 == m_AcceptThread)
+   #else
+      if (NULL == m_AcceptThread)
+   #endif
+   {
+      m_pHSQueue = new CHandshakeReq[m_iMaxHSQueue];
+      m_pcHSData = new char[m_iMaxHSQueue * m_iMaxHSSize];
+      for (int i = 0; i < m_iMaxHSQueue; ++ i)
+         m_pHSQueue[i].m_Packet.m_pcData = m_pcHSData + i * m_iMaxHSSize;
+
+      #ifndef WIN32
+         if (0 != pthread_create(&m_AcceptThread, NULL, CRcvQueue::acceptor, this))
+         {
+            m_AcceptThread = 0;
+            return -1;
+         }
+      #else
+         DWORD threadID;
+         m_AcceptThread = CreateThread(NULL, 0, CRcvQueue::acceptor, this, 0, &threadID);
+         if (NULL == m_AcceptThread)
+            return -1;
+      #endif
+   }
+
    m_pListener = u;
    return 0;
 }
@@ -1194,8 +1587,7 @@ void CRcvQueue::removeConnector(const UDTSOCKET& id)
    {
       while (!i->second.empty())
       {
-         delete [] i->second.front()->m_pcData;
-         delete i->second.front();
+         releasePkt(i->second.front());
          i->second.pop();
       }
       m_mBuffer.erase(i);
@@ -1226,15 +1618,40 @@ CUDT* CRcvQueue::getNewEntry()
    return u;
 }
 
-void CRcvQueue::storePkt(int32_t id, CPacket* pkt)
+void CRcvQueue::storePkt(int32_t id, const CPacket& pkt)
 {
    CGuard bufferlock(m_PassLock);   
 
    map<int32_t, std::queue<CPacket*> >::iterator i = m_mBuffer.find(id);
 
+   //avoid storing too many packets, in case of malfunction or attack
+   if ((i != m_mBuffer.end()) && (i->second.size() > 16))
+      return;
+
+   // copy the packet into a spare one, so that it costs no allocation in the common case
+   CPacket* copy;
+   if (!m_vPktPool.empty())
+   {
+      copy = m_vPktPool.back();
+      m_vPktPool.pop_back();
+   }
+   else
+   {
+      copy = new CPacket;
+      copy->m_pcData = new char[m_iPayloadSize];
+   }
+
+   int len = pkt.getLength();
+   if (len > m_iPayloadSize)
+      len = m_iPayloadSize;
+   memcpy(copy->m_nHeader, pkt.m_nHeader, CPacket::m_iPktHdrSize);
+   copy->m_PacketVector[0].iov_len = pkt.m_PacketVector[0].iov_len;
+   memcpy(copy->m_pcData, pkt.m_pcData, len);
+   copy->setLength(len);
+
    if (i == m_mBuffer.end())
    {
-      m_mBuffer[id].push(pkt);
+      m_mBuffer[id].push(copy);
 
       #ifndef WIN32
          pthread_cond_signal(&m_PassCond);
@@ -1243,11 +1660,17 @@ void CRcvQueue::storePkt(int32_t id, CPacket* pkt)
       #endif
    }
    else
-   {
-      //avoid storing too many packets, in case of malfunction or attack
-      if (i->second.size() > 16)
-         return;
+      i->second.push(copy);
+}
 
-      i->second.push(pkt);
+void CRcvQueue::releasePkt(CPacket* pkt)
+{
+   if (m_vPktPool.size() < size_t(m_iMaxPktPool))
+   {
+      m_vPktPool.push_back(pkt);
+      return;
    }
+
+   delete [] pkt->m_pcData;
+   delete pkt;
 }
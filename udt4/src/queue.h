@@ -55,7 +55,8 @@ class CUDT;
 struct CUnit
 {
    CPacket m_Packet;		// packet
-   int m_iFlag;			// 0: free, 1: occupied, 2: msg read but not freed (out-of-order), 3: msg dropped
+   int m_iFlag;			// 0: free, 1: occupied, 2: msg read but not freed (out-of-order), 3: msg dropped, 4: lent to the application, 5: lent and out of the buffer, -1: off the free list but not used
+   CUnit* m_pNext;		// next unit on the free list
 };
 
 class CUnitQueue
@@ -72,7 +73,7 @@ public:
       // Functionality:
       //    Initialize the unit queue.
       // Parameters:
-      //    1) [in] size: queue size
+      //    1) [in] size: queue size, which is also the size it shrinks back to
       //    2) [in] mss: maximum segament size
       //    3) [in] version: IP version
       // Returned value:
@@ -81,7 +82,7 @@ public:
    int init(int size, int mss, int version);
 
       // Functionality:
-      //    Increase (double) the unit queue size.
+      //    Increase the unit queue size by another block of the initial size.
       // Parameters:
       //    None.
       // Returned value:
@@ -90,16 +91,18 @@ public:
    int increase();
 
       // Functionality:
-      //    Decrease (halve) the unit queue size.
+      //    Release the blocks added by increase() whose units are all free again, as long as
+      //    at least half of the queue stays free and it does not go below the initial size.
+      //    Called by the receiving worker, at most once a second.
       // Parameters:
       //    None.
       // Returned value:
-      //    0: success, -1: failure.
+      //    Number of units released.
 
    int shrink();
 
       // Functionality:
-      //    find an available unit for incoming packet.
+      //    Take an available unit for incoming packet off the free list.
       // Parameters:
       //    None.
       // Returned value:
@@ -107,6 +110,44 @@ public:
 
    CUnit* getNextAvailUnit();
 
+      // Functionality:
+      //    Take several available units for a batch of incoming packets off the free list.
+      // Parameters:
+      //    0) [out] units: the available units.
+      //    1) [in] num: maximum number of units.
+      // Returned value:
+      //    Number of units found.
+
+   int getAvailUnits(CUnit** units, int num);
+
+      // Functionality:
+      //    Put the units of a batch that were not filled with a packet kept by a receiver buffer back on the free list.
+      // Parameters:
+      //    0) [in] units: the units taken by getAvailUnits.
+      //    1) [in] num: number of units.
+      // Returned value:
+      //    None.
+
+   void putBackUnits(CUnit** units, int num);
+
+      // Functionality:
+      //    Return a unit that is no longer used by a receiver buffer, from any thread.
+      // Parameters:
+      //    0) [in] unit: the unit.
+      // Returned value:
+      //    None.
+
+   void makeUnitFree(CUnit* unit);
+
+      // Functionality:
+      //    Give up the units without freeing them, when the kernel may still write into them after the queue is gone.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    None.
+
+   void leak();
+
 private:
    struct CQEntry
    {
@@ -117,13 +158,19 @@ private:
       CQEntry* m_pNext;
    }
    *m_pQEntry,			// pointer to the first unit queue
-   *m_pCurrQueue,		// pointer to the current available queue
    *m_pLastQueue;		// pointer to the last unit queue
 
-   CUnit* m_pAvailUnit;         // recent available unit
+   CQEntry* allocBlock(int size);
+
+   CUnit* m_pFreeUnit;		// free list of the receiving worker, no locking
+   int m_iFreeUnits;		// number of units on m_pFreeUnit
+   CUnit* m_pReleasedUnit;	// units freed by the receiver buffers, moved to m_pFreeUnit as a whole when it runs out
+   int m_iReleasedUnits;	// number of units on m_pReleasedUnit
+   pthread_mutex_t m_UnitLock;	// protects m_pReleasedUnit and the free flag of the units
 
    int m_iSize;			// total size of the unit queue, in number of packets
-   int m_iCount;		// total number of valid packets in the queue
+   int m_iBlockSize;		// size of each block, also the low-water mark the queue shrinks back to
+   uint64_t m_ullLastShrink;	// last time shrink() has looked for free blocks
 
    int m_iMSS;			// unit buffer size
    int m_iIPversion;		// IP version
@@ -173,6 +220,7 @@ public:
 
       // Functionality:
       //    Retrieve the next packet and peer address from the first entry, and reschedule it in the queue.
+      //    The first entry is due once its scheduled time is no more than the pacing slack ahead.
       // Parameters:
       //    0) [out] addr: destination address of the next packet
       //    1) [out] pkt: the next packet to be sent
@@ -215,6 +263,8 @@ private:
 
    CTimer* m_pTimer;
 
+   uint64_t m_ullPacingSlack;           // how early (in CCs) a packet may be sent to go out with the ones due before it
+
 private:
    CSndUList(const CSndUList&);
    CSndUList& operator=(const CSndUList&);
@@ -381,10 +431,11 @@ public:
       // Parameters:
       //    1) [in] c: UDP channel to be associated to the queue
       //    2) [in] t: Timer
+      //    3) [in] slack: pacing slack in microseconds, packets due within it are sent in one batch
       // Returned value:
       //    None.
 
-   void init(CChannel* c, CTimer* t);
+   void init(CChannel* c, CTimer* t, int slack = 0);
 
       // Functionality:
       //    Send out a packet to a given address.
@@ -404,6 +455,25 @@ private:
 #endif
 
    pthread_t m_WorkerThread;
+#ifdef WIN32
+   DWORD m_WorkerThreadID;
+#endif
+
+private:
+      // Functionality:
+      //    Send out the data packets that the worker has packed and not sent yet.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    None.
+
+   void flushBatch();
+
+   sockaddr* m_pBatchAddr[CChannel::m_iMaxBatchSize];   // destinations of the packed data packets
+   CPacket m_BatchPkt[CChannel::m_iMaxBatchSize];       // data packets packed by the worker, not yet sent
+   CPacket* m_pBatchPkt[CChannel::m_iMaxBatchSize];     // pointers to m_BatchPkt, as passed to the channel
+   int m_iBatchSize;                                    // number of packets in the batch
+   int m_iBatchSent;                                    // number of packets in the batch that have been sent already
 
 private:
    CSndUList* m_pSndUList;		// List of UDT instances for data sending
@@ -459,11 +529,14 @@ public:
 private:
 #ifndef WIN32
    static void* worker(void* param);
+   static void* acceptor(void* param);
 #else
    static DWORD WINAPI worker(LPVOID param);
+   static DWORD WINAPI acceptor(LPVOID param);
 #endif
 
    pthread_t m_WorkerThread;
+   pthread_t m_AcceptThread;            // handles the handshakes of the listener, started with the first one
 
 private:
    CUnitQueue m_UnitQueue;		// The received packet queue
@@ -474,6 +547,7 @@ private:
    CTimer* m_pTimer;			// shared timer with the snd queue
 
    int m_iPayloadSize;                  // packet payload size
+   char* m_pcDiscard;                   // buffer a packet is read into and dropped when there is no free unit for it
 
    volatile bool m_bClosing;            // closing the workder
    pthread_cond_t m_ExitCond;
@@ -489,7 +563,62 @@ private:
    bool ifNewEntry();
    CUDT* getNewEntry();
 
-   void storePkt(int32_t id, CPacket* pkt);
+      // Functionality:
+      //    Keep a copy of a packet for the socket that will read it by recvfrom(), in a packet from the pool.
+      // Parameters:
+      //    0) [in] id: socket ID.
+      //    1) [in] pkt: the packet.
+      // Returned value:
+      //    None.
+
+   void storePkt(int32_t id, const CPacket& pkt);
+
+      // Functionality:
+      //    Return a stored packet to the pool, or free it if the pool is full. m_PassLock must be held.
+      // Parameters:
+      //    0) [in] pkt: the packet.
+      // Returned value:
+      //    None.
+
+   void releasePkt(CPacket* pkt);
+
+      // Functionality:
+      //    Queue a handshake for the listener, to be handled by the accept thread off the data path.
+      //    The handshake is dropped if the queue is full; the peer repeats it.
+      // Parameters:
+      //    0) [in] addr: peer address.
+      //    1) [in] pkt: the handshake packet.
+      // Returned value:
+      //    None.
+
+   void pushHandshake(const sockaddr* addr, const CPacket& pkt);
+
+      // Functionality:
+      //    Query the number of handshakes waiting for the accept thread.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    Number of handshakes queued.
+
+   int getHandshakeNum();
+
+private:
+   struct CHandshakeReq
+   {
+      CPacket m_Packet;                 // copy of the handshake, with a payload buffer of m_iMaxHSSize bytes
+      sockaddr_in6 m_Addr;              // peer address, a sockaddr_in for IPv4
+      uint64_t m_ullArrival;            // arrival time, in microseconds
+   };
+
+   CHandshakeReq* m_pHSQueue;           // ring of queued handshakes, allocated with the accept thread
+   char* m_pcHSData;                    // payload buffers of the ring
+   int m_iHSHead;                       // first queued handshake; it stays in place until the accept thread is done with it
+   int m_iHSCount;                      // number of queued handshakes
+   int m_iHSDropped;                    // handshakes dropped on a full queue, not yet counted for the listener
+   static const int m_iMaxHSQueue = 256;        // capacity of the ring
+   static const int m_iMaxHSSize = 64;          // largest handshake queued, room for the response written in place
+   pthread_mutex_t m_HSLock;
+   pthread_cond_t m_HSCond;
 
 private:
    pthread_mutex_t m_LSLock;
@@ -500,6 +629,8 @@ private:
    pthread_mutex_t m_IDLock;
 
    std::map<int32_t, std::queue<CPacket*> > m_mBuffer;	// temporary buffer for rendezvous connection request
+   std::vector<CPacket*> m_vPktPool;                    // spare packets for m_mBuffer, with payload buffers of m_iPayloadSize
+   static const int m_iMaxPktPool = 64;                 // maximum number of spare packets kept
    pthread_mutex_t m_PassLock;
    pthread_cond_t m_PassCond;
 
@@ -510,10 +641,11 @@ private:
 
 struct CMultiplexer
 {
-   CSndQueue* m_pSndQueue;	// The sending queue
-   CRcvQueue* m_pRcvQueue;	// The receiving queue
-   CChannel* m_pChannel;	// The UDP channel for sending and receiving
-   CTimer* m_pTimer;		// The timer
+   CSndQueue** m_pSndQueue;	// The sending queue of each worker
+   CRcvQueue** m_pRcvQueue;	// The receiving queue of each worker
+   CChannel** m_pChannel;	// The UDP channel of each worker, all bound to the same port
+   CTimer** m_pTimer;		// The timer of each worker
+   int m_iWorkers;		// number of send/receive worker pairs; a socket is served by the one its packets are steered to
 
    int m_iPort;			// The UDP port number of this multiplexer
    int m_iIPversion;		// IP version
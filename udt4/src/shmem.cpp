@@ -0,0 +1,428 @@
+/*****************************************************************************
+Copyright (c) 2001 - 2011, The Board of Trustees of the University of Illinois.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+* Redistributions of source code must retain the above
+  copyright notice, this list of conditions and the
+  following disclaimer.
+
+* Redistributions in binary form must reproduce the
+  above copyright notice, this list of conditions
+  and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the University of Illinois
+  nor the names of its contributors may be used to
+  endorse or promote products derived from this
+  software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#ifndef WIN32
+   #include <unistd.h>
+   #include <fcntl.h>
+   #include <sys/mman.h>
+   #include <sys/stat.h>
+   #include <time.h>
+   #ifdef LINUX
+      #include <linux/futex.h>
+      #include <sys/syscall.h>
+   #endif
+#endif
+#include <cstdio>
+#include <cstring>
+#include "shmem.h"
+
+// The header at the start of the segment; the two rings come next, then their data.
+struct CShmHeader
+{
+   uint32_t m_iMagic;
+   int32_t m_iID;
+   int32_t m_iISN;
+   int32_t m_iSize;
+   int32_t m_iMsg;
+   uint32_t m_iReady;                   // set by the creator once the segment is initialized
+   char m_pcPad[40];
+};
+
+static const uint32_t g_iShmMagic = 0x55445453;      // "UDTS"
+
+CShmLink::CShmLink():
+m_bCreator(false),
+m_pcSegment(NULL),
+m_iSegmentSize(0),
+m_pTx(NULL),
+m_pRx(NULL),
+m_pcTxData(NULL),
+m_pcRxData(NULL),
+m_iSize(0),
+m_bMsg(false),
+m_bInterrupted(false)
+{
+   m_pcName[0] = '\0';
+}
+
+CShmLink::~CShmLink()
+{
+   unlink();
+
+   #ifndef WIN32
+      if (NULL != m_pcSegment)
+         munmap(m_pcSegment, m_iSegmentSize);
+   #endif
+}
+
+#ifndef WIN32
+int CShmLink::create(int32_t id, int32_t isn, int size, bool msg)
+{
+   m_iSize = m_iMinRingSize;
+   while ((m_iSize < size) && (m_iSize < m_iMaxRingSize))
+      m_iSize <<= 1;
+
+   snprintf(m_pcName, sizeof(m_pcName), "/udt-%x-%x", id, isn);
+   int fd = shm_open(m_pcName, O_RDWR | O_CREAT | O_EXCL, 0600);
+   if (fd < 0)
+   {
+      m_pcName[0] = '\0';
+      return -1;
+   }
+
+   int segsize = sizeof(CShmHeader) + 2 * sizeof(CShmRing) + 2 * m_iSize;
+   if ((ftruncate(fd, segsize) < 0) || (map(fd, segsize) < 0))
+   {
+      ::close(fd);
+      unlink();
+      return -1;
+   }
+   ::close(fd);
+
+   // a new segment is zero filled: the rings are empty
+   CShmHeader* hdr = (CShmHeader*)m_pcSegment;
+   hdr->m_iMagic = g_iShmMagic;
+   hdr->m_iID = id;
+   hdr->m_iISN = isn;
+   hdr->m_iSize = m_iSize;
+   hdr->m_iMsg = msg ? 1 : 0;
+   __atomic_store_n(&hdr->m_iReady, 1, __ATOMIC_RELEASE);
+
+   m_bCreator = true;
+   m_bMsg = msg;
+   m_pTx = (CShmRing*)(m_pcSegment + sizeof(CShmHeader));
+   m_pRx = m_pTx + 1;
+   m_pcTxData = (char*)(m_pRx + 1);
+   m_pcRxData = m_pcTxData + m_iSize;
+
+   return 0;
+}
+
+int CShmLink::attach(int32_t id, int32_t isn, bool msg)
+{
+   char name[64];
+   snprintf(name, sizeof(name), "/udt-%x-%x", id, isn);
+   int fd = shm_open(name, O_RDWR, 0600);
+   if (fd < 0)
+      return -1;
+
+   struct stat st;
+   if ((fstat(fd, &st) < 0) || (st.st_size < (off_t)(sizeof(CShmHeader) + 2 * sizeof(CShmRing))) || (map(fd, st.st_size) < 0))
+   {
+      ::close(fd);
+      return -1;
+   }
+   ::close(fd);
+
+   CShmHeader* hdr = (CShmHeader*)m_pcSegment;
+   if ((__atomic_load_n(&hdr->m_iReady, __ATOMIC_ACQUIRE) != 1) || (hdr->m_iMagic != g_iShmMagic) || (hdr->m_iID != id) || (hdr->m_iISN != isn)
+      || (hdr->m_iMsg != (msg ? 1 : 0)) || (hdr->m_iSize < m_iMinRingSize) || (hdr->m_iSize > m_iMaxRingSize) || (0 != (hdr->m_iSize & (hdr->m_iSize - 1)))
+      || ((off_t)(sizeof(CShmHeader) + 2 * sizeof(CShmRing) + 2 * (int64_t)hdr->m_iSize) > st.st_size))
+   {
+      munmap(m_pcSegment, m_iSegmentSize);
+      m_pcSegment = NULL;
+      return -1;
+   }
+
+   // the rings are crossed: the creator's sending ring is received here
+   m_iSize = hdr->m_iSize;
+   m_bMsg = msg;
+   m_pRx = (CShmRing*)(m_pcSegment + sizeof(CShmHeader));
+   m_pTx = m_pRx + 1;
+   m_pcRxData = (char*)(m_pTx + 1);
+   m_pcTxData = m_pcRxData + m_iSize;
+
+   return 0;
+}
+
+void CShmLink::unlink()
+{
+   if ('\0' != m_pcName[0])
+   {
+      shm_unlink(m_pcName);
+      m_pcName[0] = '\0';
+   }
+}
+
+int CShmLink::map(int fd, int size)
+{
+   void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (MAP_FAILED == p)
+      return -1;
+
+   m_pcSegment = (char*)p;
+   m_iSegmentSize = size;
+   return 0;
+}
+#else
+int CShmLink::create(int32_t, int32_t, int, bool)
+{
+   return -1;
+}
+
+int CShmLink::attach(int32_t, int32_t, bool)
+{
+   return -1;
+}
+
+void CShmLink::unlink()
+{
+}
+
+int CShmLink::map(int, int)
+{
+   return -1;
+}
+#endif
+
+void CShmLink::copyIn(uint32_t pos, const void* src, int len)
+{
+   int offset = pos & (m_iSize - 1);
+   int first = (len < m_iSize - offset) ? len : m_iSize - offset;
+   memcpy(m_pcTxData + offset, src, first);
+   if (len > first)
+      memcpy(m_pcTxData, (const char*)src + first, len - first);
+}
+
+void CShmLink::copyOut(uint32_t pos, void* dst, int len) const
+{
+   int offset = pos & (m_iSize - 1);
+   int first = (len < m_iSize - offset) ? len : m_iSize - offset;
+   memcpy(dst, m_pcRxData + offset, first);
+   if (len > first)
+      memcpy((char*)dst + first, m_pcRxData, len - first);
+}
+
+int CShmLink::send(const char* data, int len)
+{
+   uint32_t tail = m_pTx->m_iTail;
+   uint32_t head = __atomic_load_n(&m_pTx->m_iHead, __ATOMIC_ACQUIRE);
+   int room = m_iSize - (int)(tail - head);
+   if (len > room)
+      len = room;
+   if (len <= 0)
+      return 0;
+
+   copyIn(tail, data, len);
+   __atomic_store_n(&m_pTx->m_iTail, tail + len, __ATOMIC_RELEASE);
+
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   if (__atomic_load_n(&m_pTx->m_iReaderWaiting, __ATOMIC_RELAXED))
+      wake(&m_pTx->m_iTail);
+
+   return len;
+}
+
+int CShmLink::recv(char* data, int len)
+{
+   uint32_t head = m_pRx->m_iHead;
+   uint32_t tail = __atomic_load_n(&m_pRx->m_iTail, __ATOMIC_ACQUIRE);
+   int size = (int)(tail - head);
+   if (len > size)
+      len = size;
+   if (len <= 0)
+      return 0;
+
+   copyOut(head, data, len);
+   __atomic_store_n(&m_pRx->m_iHead, head + len, __ATOMIC_RELEASE);
+
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   if (__atomic_load_n(&m_pRx->m_iWriterWaiting, __ATOMIC_RELAXED))
+      wake(&m_pRx->m_iHead);
+
+   return len;
+}
+
+int CShmLink::sendMsg(const char* data, int len, int32_t frame_id, int64_t deadline)
+{
+   if (!canWrite(len))
+      return 0;
+
+   int32_t hdr[4];
+   hdr[0] = len;
+   hdr[1] = frame_id;
+   memcpy(hdr + 2, &deadline, sizeof(int64_t));
+
+   uint32_t tail = m_pTx->m_iTail;
+   copyIn(tail, hdr, m_iRecordHdrSize);
+   copyIn(tail + m_iRecordHdrSize, data, len);
+   __atomic_store_n(&m_pTx->m_iTail, tail + m_iRecordHdrSize + len, __ATOMIC_RELEASE);
+
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   if (__atomic_load_n(&m_pTx->m_iReaderWaiting, __ATOMIC_RELAXED))
+      wake(&m_pTx->m_iTail);
+
+   return len;
+}
+
+int CShmLink::recvMsg(char* data, int len, int32_t& frame_id, int64_t& deadline)
+{
+   uint32_t head = m_pRx->m_iHead;
+   uint32_t tail = __atomic_load_n(&m_pRx->m_iTail, __ATOMIC_ACQUIRE);
+   if ((int)(tail - head) < m_iRecordHdrSize)
+      return 0;
+
+   int32_t hdr[4];
+   copyOut(head, hdr, m_iRecordHdrSize);
+   int size = hdr[0];
+   if ((size < 0) || (size > (int)(tail - head) - m_iRecordHdrSize))
+      return 0;
+
+   frame_id = hdr[1];
+   memcpy(&deadline, hdr + 2, sizeof(int64_t));
+   if (len > size)
+      len = size;
+   copyOut(head + m_iRecordHdrSize, data, len);
+   __atomic_store_n(&m_pRx->m_iHead, head + m_iRecordHdrSize + size, __ATOMIC_RELEASE);
+
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   if (__atomic_load_n(&m_pRx->m_iWriterWaiting, __ATOMIC_RELAXED))
+      wake(&m_pRx->m_iHead);
+
+   return len;
+}
+
+int CShmLink::getMaxMsgSize() const
+{
+   return m_iSize / 2 - m_iRecordHdrSize;
+}
+
+bool CShmLink::canRead() const
+{
+   uint32_t tail = __atomic_load_n(&m_pRx->m_iTail, __ATOMIC_ACQUIRE);
+   return tail != m_pRx->m_iHead;
+}
+
+bool CShmLink::canWrite(int len) const
+{
+   uint32_t head = __atomic_load_n(&m_pTx->m_iHead, __ATOMIC_ACQUIRE);
+   int room = m_iSize - (int)(m_pTx->m_iTail - head);
+   return m_bMsg ? (room >= m_iRecordHdrSize + len) : (room > 0);
+}
+
+bool CShmLink::isPeerClosed() const
+{
+   return 0 != __atomic_load_n(&m_pRx->m_iClosed, __ATOMIC_ACQUIRE);
+}
+
+void CShmLink::waitRead(int timeout)
+{
+   uint32_t head = m_pRx->m_iHead;
+   __atomic_store_n(&m_pRx->m_iReaderWaiting, 1, __ATOMIC_SEQ_CST);
+   if (!m_bInterrupted && !isPeerClosed() && (__atomic_load_n(&m_pRx->m_iTail, __ATOMIC_SEQ_CST) == head))
+      wait(&m_pRx->m_iTail, head, timeout);
+   __atomic_store_n(&m_pRx->m_iReaderWaiting, 0, __ATOMIC_RELAXED);
+}
+
+void CShmLink::waitWrite(int len, int timeout)
+{
+   uint32_t head = __atomic_load_n(&m_pTx->m_iHead, __ATOMIC_SEQ_CST);
+   __atomic_store_n(&m_pTx->m_iWriterWaiting, 1, __ATOMIC_SEQ_CST);
+   if (!m_bInterrupted && !isPeerClosed() && !canWrite(len))
+      wait(&m_pTx->m_iHead, head, timeout);
+   __atomic_store_n(&m_pTx->m_iWriterWaiting, 0, __ATOMIC_RELAXED);
+}
+
+void CShmLink::requestNotify(bool write)
+{
+   if (write)
+      __atomic_store_n(&m_pTx->m_iWriteNotify, 1, __ATOMIC_SEQ_CST);
+   else
+      __atomic_store_n(&m_pRx->m_iReadNotify, 1, __ATOMIC_SEQ_CST);
+}
+
+bool CShmLink::takeNotify(bool write)
+{
+   uint32_t* flag = write ? &m_pRx->m_iWriteNotify : &m_pTx->m_iReadNotify;
+   if (0 == __atomic_load_n(flag, __ATOMIC_RELAXED))
+      return false;
+   return 0 != __atomic_exchange_n(flag, 0, __ATOMIC_ACQ_REL);
+}
+
+void CShmLink::close()
+{
+   if (NULL == m_pTx)
+      return;
+
+   __atomic_store_n(&m_pTx->m_iClosed, 1, __ATOMIC_SEQ_CST);
+   wake(&m_pTx->m_iTail);
+   wake(&m_pRx->m_iHead);
+}
+
+void CShmLink::interrupt()
+{
+   m_bInterrupted = true;
+
+   if (NULL == m_pTx)
+      return;
+
+   wake(&m_pRx->m_iTail);
+   wake(&m_pTx->m_iHead);
+}
+
+void CShmLink::wait(uint32_t* addr, uint32_t val, int timeout)
+{
+   // a wake-up can be missed when interrupt() races with the check before the wait: keep each wait short
+   if ((timeout < 0) || (timeout > 100000))
+      timeout = 100000;
+
+   #ifdef LINUX
+      timespec ts;
+      ts.tv_sec = timeout / 1000000;
+      ts.tv_nsec = (timeout % 1000000) * 1000;
+      syscall(SYS_futex, addr, FUTEX_WAIT, val, &ts, NULL, 0);
+   #elif defined(WIN32)
+      Sleep(1);
+   #else
+      // no shared futex: poll
+      timespec ts;
+      ts.tv_sec = 0;
+      ts.tv_nsec = 50000;
+      while ((timeout > 0) && (__atomic_load_n(addr, __ATOMIC_ACQUIRE) == val))
+      {
+         nanosleep(&ts, NULL);
+         timeout -= 50;
+      }
+   #endif
+}
+
+void CShmLink::wake(uint32_t* addr)
+{
+   #ifdef LINUX
+      syscall(SYS_futex, addr, FUTEX_WAKE, 0x7FFFFFFF, NULL, NULL, 0);
+   #else
+      (void)addr;
+   #endif
+}
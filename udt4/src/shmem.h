@@ -0,0 +1,235 @@
+/*****************************************************************************
+Copyright (c) 2001 - 2011, The Board of Trustees of the University of Illinois.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+* Redistributions of source code must retain the above
+  copyright notice, this list of conditions and the
+  following disclaimer.
+
+* Redistributions in binary form must reproduce the
+  above copyright notice, this list of conditions
+  and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the University of Illinois
+  nor the names of its contributors may be used to
+  endorse or promote products derived from this
+  software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#ifndef __UDT_SHMEM_H__
+#define __UDT_SHMEM_H__
+
+
+#include "udt.h"
+
+
+// One direction of a shared-memory connection: a single-producer, single-consumer byte ring.
+// Positions are free running byte counters; each side moves only its own.
+struct CShmRing
+{
+   uint32_t m_iHead;                    // bytes read, moved by the reader
+   uint32_t m_iWriterWaiting;           // the writer sleeps on m_iHead
+   uint32_t m_iWriteNotify;             // the writer wants a doorbell when room is made
+   char m_pcPad1[52];
+
+   uint32_t m_iTail;                    // bytes written, moved by the writer
+   uint32_t m_iReaderWaiting;           // the reader sleeps on m_iTail
+   uint32_t m_iReadNotify;              // the reader wants a doorbell when data comes
+   uint32_t m_iClosed;                  // the writer has closed the connection
+   char m_pcPad2[48];
+};
+
+// A connection between two UDT sockets on the same host, over a shared memory segment of two rings.
+// The connecting side creates the segment, the listening side attaches to it during the handshake.
+// A SOCK_STREAM connection carries bytes; a SOCK_DGRAM one carries messages and frames as records.
+class CShmLink
+{
+public:
+   CShmLink();
+   ~CShmLink();
+
+      // Functionality:
+      //    Create the segment, for the connecting side.
+      // Parameters:
+      //    0) [in] id: socket ID of the connecting side.
+      //    1) [in] isn: its initial sequence number; the two name the segment.
+      //    2) [in] size: size of each ring, rounded up to a power of two.
+      //    3) [in] msg: if records are carried (SOCK_DGRAM).
+      // Returned value:
+      //    0 on success, -1 if shared memory is not available.
+
+   int create(int32_t id, int32_t isn, int size, bool msg);
+
+      // Functionality:
+      //    Attach to the segment created by the peer, for the listening side.
+      // Parameters:
+      //    0) [in] id: socket ID of the connecting side.
+      //    1) [in] isn: its initial sequence number.
+      //    2) [in] msg: if records are carried (SOCK_DGRAM).
+      // Returned value:
+      //    0 on success, -1 if there is no such segment: the peer is on another host.
+
+   int attach(int32_t id, int32_t isn, bool msg);
+
+      // Functionality:
+      //    Remove the name of the segment, once both sides have it mapped.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    None.
+
+   void unlink();
+
+      // Functionality:
+      //    Write bytes into the ring, as many as there is room for.
+      // Parameters:
+      //    0) [in] data: data to be sent.
+      //    1) [in] len: size of the data.
+      // Returned value:
+      //    Number of bytes written, 0 if the ring is full.
+
+   int send(const char* data, int len);
+
+      // Functionality:
+      //    Read bytes from the ring, as many as are there.
+      // Parameters:
+      //    0) [out] data: buffer for the data.
+      //    1) [in] len: size of the buffer.
+      // Returned value:
+      //    Number of bytes read, 0 if the ring is empty.
+
+   int recv(char* data, int len);
+
+      // Functionality:
+      //    Write a message or a frame into the ring as one record, if there is room for all of it.
+      // Parameters:
+      //    0) [in] data: the message.
+      //    1) [in] len: its size, at most getMaxMsgSize().
+      //    2) [in] frame_id: Frame ID, -1 for a message.
+      //    3) [in] deadline: frame deadline, in microseconds.
+      // Returned value:
+      //    len if written, 0 if there is no room yet.
+
+   int sendMsg(const char* data, int len, int32_t frame_id, int64_t deadline);
+
+      // Functionality:
+      //    Read the next record; what does not fit into the buffer is discarded.
+      // Parameters:
+      //    0) [out] data: buffer for the message.
+      //    1) [in] len: size of the buffer.
+      //    2) [out] frame_id: Frame ID, -1 for a message.
+      //    3) [out] deadline: frame deadline, in microseconds.
+      // Returned value:
+      //    Size of data read, 0 if the ring is empty.
+
+   int recvMsg(char* data, int len, int32_t& frame_id, int64_t& deadline);
+
+   int getMaxMsgSize() const;
+   bool canRead() const;
+   bool canWrite(int len) const;
+   bool isPeerClosed() const;
+
+      // Functionality:
+      //    Wait until there is something to read, the peer has closed, or interrupt() is called.
+      // Parameters:
+      //    0) [in] timeout: longest wait, in microseconds; negative for no limit.
+      // Returned value:
+      //    None.
+
+   void waitRead(int timeout);
+
+      // Functionality:
+      //    Wait until there is room for len bytes (a record of len bytes in message mode), the peer has closed,
+      //    or interrupt() is called.
+      // Parameters:
+      //    0) [in] len: room needed.
+      //    1) [in] timeout: longest wait, in microseconds; negative for no limit.
+      // Returned value:
+      //    None.
+
+   void waitWrite(int len, int timeout);
+
+      // Functionality:
+      //    Ask the peer for a doorbell when there is something to read (write false) or room to write (write true).
+      //    The caller checks again afterwards, in case the state changed before the request was seen.
+      // Parameters:
+      //    0) [in] write: which direction.
+      // Returned value:
+      //    None.
+
+   void requestNotify(bool write);
+
+      // Functionality:
+      //    Check, and clear, the peer's request for a doorbell after data has been written (write false) or read (write true).
+      // Parameters:
+      //    0) [in] write: which direction.
+      // Returned value:
+      //    true if the peer wants to be told.
+
+   bool takeNotify(bool write);
+
+      // Functionality:
+      //    Tell the peer that no more data will come, and wake it up.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    None.
+
+   void close();
+
+      // Functionality:
+      //    Wake up the local calls waiting on the rings, for good.
+      // Parameters:
+      //    None.
+      // Returned value:
+      //    None.
+
+   void interrupt();
+
+public:
+   static const int m_iRecordHdrSize = 16;      // record header in message mode: size, Frame ID and deadline
+   static const int m_iMinRingSize = 1 << 20;   // bounds of the ring size
+   static const int m_iMaxRingSize = 1 << 26;
+
+private:
+   int map(int fd, int size);
+   void copyIn(uint32_t pos, const void* src, int len);
+   void copyOut(uint32_t pos, void* dst, int len) const;
+   static void wait(uint32_t* addr, uint32_t val, int timeout);
+   static void wake(uint32_t* addr);
+
+private:
+   char m_pcName[64];                   // name of the segment, empty once it has been removed
+   bool m_bCreator;                     // if this side has created the segment
+   char* m_pcSegment;                   // the mapping
+   int m_iSegmentSize;                  // its size
+
+   CShmRing* m_pTx;                     // ring written by this side
+   CShmRing* m_pRx;                     // ring read by this side
+   char* m_pcTxData;                    // their data
+   char* m_pcRxData;
+   int m_iSize;                         // size of each ring, a power of two
+   bool m_bMsg;                         // if records are carried
+
+   volatile bool m_bInterrupted;        // if the local waits are to return at once
+};
+
+
+#endif
@@ -125,8 +125,20 @@ enum EPOLLOpt
    UDT_EPOLL_ERR = 0x8
 };
 
+// event reported by the event array form of UDT::epoll_wait2
+struct UDT_EPOLL_EVENT
+{
+   UDTSOCKET fd;                        // UDT socket
+   int events;                          // events that have happened since the socket was last reported, see EPOLLOpt
+};
+
 enum UDTSTATUS {INIT = 1, OPENED, LISTENING, CONNECTING, CONNECTED, BROKEN, CLOSING, CLOSED, NONEXIST};
 
+// VR Frame Awareness: how the sender chooses between loss retransmissions and new data, see UDT_SNDSCHED
+// LOSSFIRST: retransmissions always go first (original UDT behavior)
+// DEADLINE: the packet with the earliest frame deadline goes first; retransmissions that cannot make their deadline yield to new data
+enum UDTSNDSCHED {UDT_SCHED_LOSSFIRST = 0, UDT_SCHED_DEADLINE};
+
 ////////////////////////////////////////////////////////////////////////////////
 
 enum UDTOpt
@@ -151,7 +163,18 @@ enum UDTOpt
    UDT_STATE,		// current socket state, see UDTSTATUS, read only
    UDT_EVENT,		// current avalable events associated with the socket
    UDT_SNDDATA,		// size of data in the sending buffer
-   UDT_RCVDATA		// size of data available for recv
+   UDT_RCVDATA,		// size of data available for recv
+   UDT_FRAMEDROP,	// VR Frame Awareness: drop whole frames once their deadline has passed, on the receiver: stop asking for them
+   UDT_SNDSCHED,	// VR Frame Awareness: packet scheduling policy of the sender, see UDTSNDSCHED
+   UDT_FRAMETRACE,	// VR Frame Awareness: capacity of the receiver frame event trace, in events (0 = off)
+   UDP_OFFLOAD,		// UDP segmentation offload (GSO/GRO) on the channel, where the kernel supports it
+   UDT_WORKERS,		// number of send/receive worker pairs of a new multiplexer, each on its own UDP socket (SO_REUSEPORT)
+   UDT_PACINGSLACK,	// how early (in microseconds) the sender of a new multiplexer may send a packet, to batch it with others
+   UDT_FEC,		// VR Frame Awareness: add XOR parity chunks to each frame sent, as many as the measured loss rate calls for
+   UDT_URING,		// drive the channel of a new multiplexer with io_uring, where the kernel supports it (Linux 5.11)
+   UDT_SHMEM,		// carry the data over shared memory when the peer is on the same host and enables it too
+   UDT_ADAPTIVEACK,	// scale the ACK frequency with the rate and RTT, acknowledge at frame ends and carry loss reports on ACKs
+   UDT_FRAMELAYERS	// VR Frame Awareness: carry the layer of each chunk, see UDT::sendframe_layered; both sides must enable it
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -194,6 +217,109 @@ struct CPerfMon
    double mbpsBandwidth;                // estimated bandwidth, in Mb/s
    int byteAvailSndBuf;                 // available UDT sender buffer size
    int byteAvailRcvBuf;                 // available UDT receiver buffer size
+
+   // measurements added later go after the ones above, in the order they were added, so that the layout
+   // stays compatible with code built against an older header
+
+   // pacing
+   double usPacingError;                // average deviation of the sending time of paced packets from their schedule, in microseconds
+   double usPacingErrorMax;             // largest deviation of a paced packet from its schedule, in microseconds
+
+   // packets dropped for lack of a receive unit
+   int pktRcvNoUnitTotal;               // total number of received packets discarded for lack of a free receive unit
+   int pktRcvNoUnit;                    // number of received packets discarded for lack of a free receive unit
+
+   // frame parity
+   int pktRcvRecoveredTotal;            // total number of lost packets rebuilt from frame parity (receiver side)
+   int pktRcvRecovered;                 // number of lost packets rebuilt from frame parity (receiver side)
+
+   // frames
+   int64_t frameSentTotal;              // total number of frames passed to UDT::sendframe
+   int64_t frameSndAckedTotal;          // total number of sent frames acknowledged completely
+   int64_t frameSndMissTotal;           // total number of sent frames dropped at their deadlines, by either side
+   int64_t frameRcvCompleteTotal;       // total number of frames received completely
+   int64_t frameRcvMissTotal;           // total number of frames completed after their deadlines or abandoned (receiver side)
+   int frameSent;                       // number of frames passed to UDT::sendframe
+   int frameSndAcked;                   // number of sent frames acknowledged completely
+   int frameSndMiss;                    // number of sent frames dropped at their deadlines, by either side
+   int frameRcvComplete;                // number of frames received completely
+   int frameRcvMiss;                    // number of frames completed after their deadlines or abandoned (receiver side)
+   double usFrameSndLatency50;          // median time from UDT::sendframe to the acknowledgement of the whole frame, in microseconds
+   double usFrameSndLatency99;          // 99th percentile of the same
+   double usFrameSndLatency999;         // 99.9th percentile of the same
+   double usFrameRcvLatency50;          // median time from the first transmission of a frame to its completion at the receiver, in microseconds
+   double usFrameRcvLatency99;          // 99th percentile of the same
+   double usFrameRcvLatency999;         // 99.9th percentile of the same
+   double pktFrameRetransAvg;           // average number of retransmitted packets per acknowledged frame
+   int pktFrameRetrans99;               // 99th percentile of the retransmitted packets per acknowledged frame
+
+   // adaptive acknowledgement
+   int pktCtrlSavedTotal;               // total number of control packets UDT_ADAPTIVEACK saved, estimated against the fixed schedule
+   int pktCtrlSaved;                    // number of control packets UDT_ADAPTIVEACK saved (receiver side)
+   double pktCtrlSavedPerPkt;           // control packets saved per data packet received
+
+   // layered frames
+   int pktSndShedTotal;                 // total number of chunks of optional frame layers shed to meet frame deadlines (sender side)
+   int64_t frameRcvPartialTotal;        // total number of layered frames delivered without some optional layers
+   int pktSndShed;                      // number of chunks of optional frame layers shed (sender side)
+   int frameRcvPartial;                 // number of layered frames delivered without some optional layers
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// handshakes handled by a listening socket, see UDT::acceptstats
+
+struct CAcceptStats
+{
+   // global measurements
+   int64_t msTimeStamp;                 // time since the UDT entity is started, in milliseconds
+   int hsRecvTotal;                     // total number of connection handshakes handled, including cookie requests
+   int hsDroppedTotal;                  // total number of handshakes dropped because the accept queue was full
+   int hsRejectedTotal;                 // total number of handshakes rejected: malformed, bad cookie, mismatch or no resources
+   int connAcceptedTotal;               // total number of new connections set up
+
+   // local measurements
+   int hsRecv;                          // number of handshakes handled
+   int hsDropped;                       // number of handshakes dropped because the accept queue was full
+   int hsRejected;                      // number of handshakes rejected
+   int connAccepted;                    // number of new connections set up
+   double hsRecvRate;                   // handshakes handled per second
+   double connAcceptRate;               // new connections per second
+   double usHSWaitAvg;                  // average time a handshake waited in the accept queue, in microseconds
+   double usHSWaitMax;                  // longest wait of a handshake in the accept queue, in microseconds
+
+   // instant measurements
+   int hsQueueLen;                      // number of handshakes waiting in the accept queue
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// VR Frame Awareness: receiver frame events recorded when UDT_FRAMETRACE is on, see UDT::getframetrace
+enum UDTFRAMEEVENT {UDT_FRAME_CHUNK = 1, UDT_FRAME_COMPLETE, UDT_FRAME_DROPPED};
+
+struct CFrameEvent
+{
+   int64_t usTimeStamp;                 // time since the socket was opened, in microseconds
+   int64_t usDeadline;                  // frame deadline, in microseconds since the socket was opened (0 = no deadline)
+   int32_t seqNo;                       // sequence number of the chunk (UDT_FRAME_CHUNK only)
+   int type;                            // event type, see UDTFRAMEEVENT
+   uint16_t frameID;                    // VR frame ID
+   uint8_t chunkID;                     // chunk index within the frame (UDT_FRAME_CHUNK only)
+   uint8_t totalChunks;                 // number of chunks in the frame
+};
+
+// VR Frame Awareness: called when the library stops referencing a frame passed to UDT::sendframe without copying:
+// all its chunks have been acknowledged or dropped, or the socket has been closed. It runs on a library thread,
+// with internal locks held, and must return quickly without blocking. It must not send on any UDT socket (or close
+// one): no further ACK can be processed until it returns, so that a send waiting for buffer space would never end.
+// To send the next frame when one is done, wake up an application thread from the callback.
+typedef void (*UDTFRAMEDONE)(UDTSOCKET u, const char* buf, int len, void* context);
+
+// a piece of a message or frame received without copying, see UDT::recvmsg_zc; on POSIX systems it has the layout of struct iovec
+struct UDT_IOVEC
+{
+   void* iov_base;                      // start of the data, inside the UDT receiver buffer
+   size_t iov_len;                      // size of the data
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -282,6 +408,10 @@ public: // Error Code
    static const int EDUPLISTEN;
    static const int ELARGEMSG;
    static const int EINVPOLLID;
+   static const int ERDVWORKERS;
+   static const int ESHMEMILL;
+   static const int EINVFANOUT;
+   static const int EINVMPATH;
    static const int EASYNCFAIL;
    static const int EASYNCSND;
    static const int EASYNCRCV;
@@ -303,6 +433,9 @@ namespace UDT
 typedef CUDTException ERRORINFO;
 typedef UDTOpt SOCKOPT;
 typedef CPerfMon TRACEINFO;
+typedef CAcceptStats ACCEPTINFO;
+typedef CFrameEvent FRAMEEVENT;
+typedef UDTFRAMEDONE FRAMEDONE;
 typedef ud_set UDSET;
 
 UDT_API extern const UDTSOCKET INVALID_SOCK;
@@ -311,6 +444,12 @@ UDT_API extern const int ERROR;
 
 UDT_API int startup();
 UDT_API int cleanup();
+
+// Keep what is learned about the network paths (RTT, bandwidth, sending rate) in a file shared by all
+// the processes that use it, so that new connections to a known peer start near the path capacity.
+// Only sockets created afterwards use the file; it can be set once per process. The file is created readable and
+// writable by the user only, and one that another user owns or may write is refused.
+UDT_API int setcachefile(const char* path, int maxage = 3600);
 UDT_API UDTSOCKET socket(int af, int type, int protocol);
 UDT_API int bind(UDTSOCKET u, const struct sockaddr* name, int namelen);
 UDT_API int bind2(UDTSOCKET u, UDPSOCKET udpsock);
@@ -328,6 +467,9 @@ UDT_API int sendmsg(UDTSOCKET u, const char* buf, int len, int ttl = -1, bool in
 UDT_API int recvmsg(UDTSOCKET u, char* buf, int len);
 UDT_API int64_t sendfile(UDTSOCKET u, std::fstream& ifs, int64_t& offset, int64_t size, int block = 364000);
 UDT_API int64_t recvfile(UDTSOCKET u, std::fstream& ofs, int64_t& offset, int64_t size, int block = 7280000);
+// sendfile2 sends from a mapping of the file on systems with mmap, and the mapped pages are read again to retransmit
+// until they are acknowledged: the file must not be truncated before the socket is closed, or the process may receive
+// SIGBUS. A file that is already shorter when a block is mapped is read instead, and the call fails if it is short.
 UDT_API int64_t sendfile2(UDTSOCKET u, const char* path, int64_t* offset, int64_t size, int block = 364000);
 UDT_API int64_t recvfile2(UDTSOCKET u, const char* path, int64_t* offset, int64_t size, int block = 7280000);
 
@@ -345,17 +487,86 @@ UDT_API int epoll_wait(int eid, std::set<UDTSOCKET>* readfds, std::set<UDTSOCKET
                        std::set<SYSSOCKET>* lrfds = NULL, std::set<SYSSOCKET>* wrfds = NULL);
 UDT_API int epoll_wait2(int eid, UDTSOCKET* readfds, int* rnum, UDTSOCKET* writefds, int* wnum, int64_t msTimeOut,
                         SYSSOCKET* lrfds = NULL, int* lrnum = NULL, SYSSOCKET* lwfds = NULL, int* lwnum = NULL);
+UDT_API int epoll_wait2(int eid, UDT_EPOLL_EVENT* events, int max, int64_t msTimeOut);
 UDT_API int epoll_release(int eid);
 UDT_API ERRORINFO& getlasterror();
 UDT_API int getlasterror_code();
 UDT_API const char* getlasterror_desc();
 UDT_API int perfmon(UDTSOCKET u, TRACEINFO* perf, bool clear = true);
+
+// handshake counters and accept rate of a listening socket since the last call
+UDT_API int acceptstats(UDTSOCKET u, ACCEPTINFO* stats, bool clear = true);
 UDT_API UDTSTATUS getsockstate(UDTSOCKET u);
 
 // VR Frame Awareness: Set frame metadata for next packet
+// deadline_us is measured in microseconds since the socket was opened (0 = no deadline)
 UDT_API int set_next_frame_metadata(UDTSOCKET u, uint16_t frame_id, uint8_t chunk_id,
                                      uint8_t total_chunks, int64_t deadline_us);
 
+// VR Frame Awareness: send a whole frame in one call; the library splits it into chunks
+// (at most 255) and stamps chunk_id/total_chunks. In SOCK_DGRAM mode the frame is one message.
+// With a callback the frame is not copied: buf must stay valid and unchanged until the callback
+// is called for it. The callback is not called if the frame is not accepted (the call fails or returns 0).
+UDT_API int sendframe(UDTSOCKET u, const char* buf, int len, uint16_t frame_id, int64_t deadline_us,
+                      FRAMEDONE callback = NULL, void* context = NULL);
+
+// VR Frame Awareness: send a frame coded in layers, nlayers of them with the given sizes one after another in buf,
+// base layer first. The first required layers are needed to use the frame; when the frame would miss its deadline
+// at the current sending rate, the sender stops sending the others and the receiver gets the frame without them.
+// Needs UDT_FRAMELAYERS on both sides, otherwise the whole frame is required. The frame is copied.
+UDT_API int sendframe_layered(UDTSOCKET u, const char* buf, const int* layers, int nlayers, int required,
+                              uint16_t frame_id, int64_t deadline_us = 0);
+
+// VR Frame Awareness: receive the next whole frame (SOCK_DGRAM only). If the sender drops a frame
+// because its deadline has passed, the frame is reported with complete = false and no data.
+// A layered frame that has lost optional layers is returned up to its last complete layer, with complete = false.
+UDT_API int recvframe(UDTSOCKET u, char* buf, int len, uint16_t& frame_id, bool& complete);
+
+// Zero-copy receive (SOCK_DGRAM only): the next message is lent to the application instead of being copied.
+// iov receives iovcnt pieces that point into the UDT receiver buffer; they stay valid until release_zc is called
+// with the returned handle, or until the socket is closed. The space they take is not offered to the peer again
+// (flow window) before they are released. Returns the size of the message. Not supported over UDT_SHMEM links.
+UDT_API int recvmsg_zc(UDTSOCKET u, const UDT_IOVEC*& iov, int& iovcnt, int& handle);
+
+// VR Frame Awareness: zero-copy form of recvframe, one piece per chunk. An abandoned frame has no data and handle -1,
+// a frame without its optional layers has complete = false and the pieces of the layers it has.
+UDT_API int recvframe_zc(UDTSOCKET u, const UDT_IOVEC*& iov, int& iovcnt, uint16_t& frame_id, bool& complete, int& handle);
+
+// give back a message or frame lent by recvmsg_zc or recvframe_zc.
+UDT_API int release_zc(UDTSOCKET u, int handle);
+
+// VR Frame Awareness: fan-out groups send the same frames to many connected sockets. A frame is copied once and
+// shared by the send buffers of all subscribers, each of which keeps its own sequence numbers, losses and congestion
+// control; it is freed when the last subscriber has had it acknowledged or dropped it at its deadline, or has been
+// closed. deadline_us is measured in microseconds since the group was created (0 = no deadline).
+// fanout_sendframe never blocks: a subscriber whose send buffer cannot take the frame misses it, and a broken or
+// closed one leaves the group. It returns the number of subscribers that took the frame.
+UDT_API int fanout_create();
+UDT_API int fanout_add(int gid, UDTSOCKET u);
+UDT_API int fanout_remove(int gid, UDTSOCKET u);
+UDT_API int fanout_sendframe(int gid, const char* buf, int len, uint16_t frame_id, int64_t deadline_us);
+UDT_API int fanout_release(int gid);
+
+// VR Frame Awareness: a multipath session carries one frame stream over several connected SOCK_DGRAM sockets
+// (sub-flows), typically bound to different interfaces; each keeps its own congestion control, RTT and loss
+// estimates. mpath_sendframe splits a frame into chunks and gives each chunk to the sub-flow expected to deliver it
+// first, preferring those that would still make the deadline after a retransmission. deadline_us is measured in
+// microseconds since the session was created (0 = no deadline). The peer adds its own sockets of the same sub-flows
+// to a session of its own and calls mpath_recvframe, which merges the sub-flows back into frames and returns them in
+// the order they become complete; a frame abandoned on any sub-flow is reported with complete = false and no data.
+// A broken or closed sub-flow leaves the session.
+UDT_API int mpath_create();
+UDT_API int mpath_add(int mid, UDTSOCKET u);
+UDT_API int mpath_remove(int mid, UDTSOCKET u);
+UDT_API int mpath_sendframe(int mid, const char* buf, int len, uint16_t frame_id, int64_t deadline_us);
+UDT_API int mpath_recvframe(int mid, char* buf, int len, uint16_t& frame_id, bool& complete);
+UDT_API int mpath_release(int mid);
+
+// VR Frame Awareness: move up to num recorded frame events out of the socket's trace (UDT_FRAMETRACE).
+// Returns the number of events copied; overflow, if given, receives the number of events lost
+// because the trace was full since the previous call.
+UDT_API int getframetrace(UDTSOCKET u, FRAMEEVENT* events, int num, int* overflow = NULL);
+
 }  // namespace UDT
 
 #endif
@@ -147,9 +147,13 @@ int CACKWindow::acknowledge(int32_t seq, int32_t& ack)
 CPktTimeWindow::CPktTimeWindow(int asize, int psize):
 m_iAWSize(asize),
 m_piPktWindow(NULL),
+m_piPktSorted(NULL),
+m_llPktSum(0),
 m_iPktWindowPtr(0),
 m_iPWSize(psize),
 m_piProbeWindow(NULL),
+m_piProbeSorted(NULL),
+m_llProbeSum(0),
 m_iProbeWindowPtr(0),
 m_iLastSentTime(0),
 m_iMinPktSndInt(1000000),
@@ -158,25 +162,27 @@ m_CurrArrTime(),
 m_ProbeTime()
 {
    m_piPktWindow = new int[m_iAWSize];
-   m_piPktReplica = new int[m_iAWSize];
+   m_piPktSorted = new int[m_iAWSize];
    m_piProbeWindow = new int[m_iPWSize];
-   m_piProbeReplica = new int[m_iPWSize];
+   m_piProbeSorted = new int[m_iPWSize];
 
    m_LastArrTime = CTimer::getTime();
 
    for (int i = 0; i < m_iAWSize; ++ i)
-      m_piPktWindow[i] = 1000000;
+      m_piPktWindow[i] = m_piPktSorted[i] = 1000000;
+   m_llPktSum = 1000000LL * m_iAWSize;
 
    for (int k = 0; k < m_iPWSize; ++ k)
-      m_piProbeWindow[k] = 1000;
+      m_piProbeWindow[k] = m_piProbeSorted[k] = 1000;
+   m_llProbeSum = 1000LL * m_iPWSize;
 }
 
 CPktTimeWindow::~CPktTimeWindow()
 {
    delete [] m_piPktWindow;
-   delete [] m_piPktReplica;
+   delete [] m_piPktSorted;
    delete [] m_piProbeWindow;
-   delete [] m_piProbeReplica;
+   delete [] m_piProbeSorted;
 }
 
 int CPktTimeWindow::getMinPktSndInt() const
@@ -186,60 +192,61 @@ int CPktTimeWindow::getMinPktSndInt() const
 
 int CPktTimeWindow::getPktRcvSpeed() const
 {
-   // get median value, but cannot change the original value order in the window
-   std::copy(m_piPktWindow, m_piPktWindow + m_iAWSize - 1, m_piPktReplica);
-   std::nth_element(m_piPktReplica, m_piPktReplica + (m_iAWSize / 2), m_piPktReplica + m_iAWSize - 1);
-   int median = m_piPktReplica[m_iAWSize / 2];
-
-   int count = 0;
-   int sum = 0;
-   int upper = median << 3;
-   int lower = median >> 3;
-
-   // median filtering
-   int* p = m_piPktWindow;
-   for (int i = 0, n = m_iAWSize; i < n; ++ i)
-   {
-      if ((*p < upper) && (*p > lower))
-      {
-         ++ count;
-         sum += *p;
-      }
-      ++ p;
-   }
+   int count;
+   int64_t sum = filterSorted(m_piPktSorted, m_iAWSize, m_llPktSum, count);
 
    // claculate speed, or return 0 if not enough valid value
    if (count > (m_iAWSize >> 1))
-      return (int)ceil(1000000.0 / (sum / count));
+      return (int)ceil(1000000.0 / int(sum / count));
    else
       return 0;
 }
 
 int CPktTimeWindow::getBandwidth() const
 {
-   // get median value, but cannot change the original value order in the window
-   std::copy(m_piProbeWindow, m_piProbeWindow + m_iPWSize - 1, m_piProbeReplica);
-   std::nth_element(m_piProbeReplica, m_piProbeReplica + (m_iPWSize / 2), m_piProbeReplica + m_iPWSize - 1);
-   int median = m_piProbeReplica[m_iPWSize / 2];
+   // the median is counted twice
+   int count;
+   int64_t sum = filterSorted(m_piProbeSorted, m_iPWSize, m_llProbeSum, count) + m_piProbeSorted[m_iPWSize / 2];
+   ++ count;
 
-   int count = 1;
-   int sum = median;
-   int upper = median << 3;
-   int lower = median >> 3;
+   return (int)ceil(1000000.0 / (double(sum) / double(count)));
+}
+
+void CPktTimeWindow::replaceSorted(int* sorted, int size, int oldval, int newval)
+{
+   int pos = int(lower_bound(sorted, sorted + size, oldval) - sorted);
 
-   // median filtering
-   int* p = m_piProbeWindow;
-   for (int i = 0, n = m_iPWSize; i < n; ++ i)
+   // move the values between the old and the new one by one place, usually only a few
+   if (newval > oldval)
    {
-      if ((*p < upper) && (*p > lower))
-      {
-         ++ count;
-         sum += *p;
-      }
-      ++ p;
+      for (; (pos + 1 < size) && (sorted[pos + 1] < newval); ++ pos)
+         sorted[pos] = sorted[pos + 1];
+   }
+   else
+   {
+      for (; (pos > 0) && (sorted[pos - 1] > newval); -- pos)
+         sorted[pos] = sorted[pos - 1];
    }
 
-   return (int)ceil(1000000.0 / (double(sum) / double(count)));
+   sorted[pos] = newval;
+}
+
+int64_t CPktTimeWindow::filterSorted(const int* sorted, int size, int64_t sum, int& count)
+{
+   int median = sorted[size / 2];
+   int upper = median << 3;
+   int lower = median >> 3;
+
+   // median filtering: the values out of range are at both ends, and there are few of them
+   int i = 0;
+   int j = size - 1;
+   for (; (i <= j) && (sorted[i] <= lower); ++ i)
+      sum -= sorted[i];
+   for (; (j >= i) && (sorted[j] >= upper); -- j)
+      sum -= sorted[j];
+
+   count = j - i + 1;
+   return sum;
 }
 
 void CPktTimeWindow::onPktSent(int currtime)
@@ -257,7 +264,10 @@ void CPktTimeWindow::onPktArrival()
    m_CurrArrTime = CTimer::getTime();
 
    // record the packet interval between the current and the last one
-   *(m_piPktWindow + m_iPktWindowPtr) = int(m_CurrArrTime - m_LastArrTime);
+   int interval = int(m_CurrArrTime - m_LastArrTime);
+   replaceSorted(m_piPktSorted, m_iAWSize, m_piPktWindow[m_iPktWindowPtr], interval);
+   m_llPktSum += interval - m_piPktWindow[m_iPktWindowPtr];
+   m_piPktWindow[m_iPktWindowPtr] = interval;
 
    // the window is logically circular
    ++ m_iPktWindowPtr;
@@ -278,7 +288,11 @@ void CPktTimeWindow::probe2Arrival()
    m_CurrArrTime = CTimer::getTime();
 
    // record the probing packets interval
-   *(m_piProbeWindow + m_iProbeWindowPtr) = int(m_CurrArrTime - m_ProbeTime);
+   int interval = int(m_CurrArrTime - m_ProbeTime);
+   replaceSorted(m_piProbeSorted, m_iPWSize, m_piProbeWindow[m_iProbeWindowPtr], interval);
+   m_llProbeSum += interval - m_piProbeWindow[m_iProbeWindowPtr];
+   m_piProbeWindow[m_iProbeWindowPtr] = interval;
+
    // the window is logically circular
    ++ m_iProbeWindowPtr;
    if (m_iProbeWindowPtr == m_iPWSize)
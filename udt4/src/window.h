@@ -160,15 +160,42 @@ public:
 
    void probe2Arrival();
 
+public: // helpers of the sorted windows, with no state of their own
+      // Functionality:
+      //    Keep a sorted copy of a window in order when one of its values is replaced.
+      // Parameters:
+      //    0) [in, out] sorted: values of the window in increasing order.
+      //    1) [in] size: size of the window.
+      //    2) [in] oldval: the value leaving the window.
+      //    3) [in] newval: the value entering the window.
+      // Returned value:
+      //    None.
+
+   static void replaceSorted(int* sorted, int size, int oldval, int newval);
+
+      // Functionality:
+      //    Average the values of a window that are within a factor of 8 of its median.
+      // Parameters:
+      //    0) [in] sorted: values of the window in increasing order.
+      //    1) [in] size: size of the window.
+      //    2) [in] sum: sum of the values of the window.
+      //    3) [out] count: number of values averaged.
+      // Returned value:
+      //    the sum of the values averaged.
+
+   static int64_t filterSorted(const int* sorted, int size, int64_t sum, int& count);
+
 private:
    int m_iAWSize;               // size of the packet arrival history window
    int* m_piPktWindow;          // packet information window
-   int* m_piPktReplica;
+   int* m_piPktSorted;          // the packet info. window in increasing order, updated on each arrival
+   int64_t m_llPktSum;          // sum of the packet info. window
    int m_iPktWindowPtr;         // position pointer of the packet info. window.
 
    int m_iPWSize;               // size of probe history window size
    int* m_piProbeWindow;        // record inter-packet time for probing packet pairs
-   int* m_piProbeReplica;
+   int* m_piProbeSorted;        // the probing window in increasing order, updated on each probe
+   int64_t m_llProbeSum;        // sum of the probing window
    int m_iProbeWindowPtr;       // position pointer to the probing window
 
    int m_iLastSentTime;         // last packet sending time
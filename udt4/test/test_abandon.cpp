@@ -0,0 +1,304 @@
+/*
+ * Test program for abandoned frame reports
+ * This program tests that the sender ignores reports of abandoned frames (control type 9) that do not fit
+ * what it has sent and still holds, forged on the wire by a relay, and that a flood of them does not
+ * hold up the transfer
+ */
+
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <arpa/inet.h>
+#include "../src/udt.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+static const int DATA_SIZE = 4000000;
+
+// a UDP relay between a client and a server, sending forged abandoned frame reports to the client
+struct Relay {
+    int front;              // socket the client connects to
+    int back;               // socket the server sees the client at
+    sockaddr_in entry;      // address of the front socket
+    sockaddr_in server;
+    sockaddr_in client;
+    bool known;             // if the client has been heard from
+    UDTSOCKET target;       // socket ID of the client, 0 until it is connected
+    int every;              // forge reports after every n-th data packet
+    int flood;              // forge this many reports after each data packet
+    volatile bool stop;
+    int data;               // data packets from the client
+    int forged;             // reports sent to the client
+};
+
+static int bind_loopback(sockaddr_in& addr) {
+    int s = ::socket(AF_INET, SOCK_DGRAM, 0);
+    int size = 4 * 1024 * 1024;
+    setsockopt(s, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(s, (sockaddr*)&addr, sizeof(addr));
+    socklen_t namelen = sizeof(addr);
+    getsockname(s, (sockaddr*)&addr, &namelen);
+    return s;
+}
+
+static int32_t seq_add(int32_t seq, int n) {
+    return (int32_t)(((uint32_t)seq + (uint32_t)n) & 0x7FFFFFFF);
+}
+
+// a report of frame 0 abandoned, from "first" to "last", as the server would send it
+static void forge(Relay* r, int32_t first, int32_t last) {
+    uint32_t pkt[7];
+    pkt[0] = htonl(0x80000000 | (9 << 16));
+    pkt[1] = 0;
+    pkt[2] = 0;
+    pkt[3] = htonl(r->target);
+    pkt[4] = htonl(first);
+    pkt[5] = htonl(last);
+    pkt[6] = 0;
+    sendto(r->front, pkt, sizeof(pkt), 0, (sockaddr*)&r->client, sizeof(r->client));
+    ++ r->forged;
+}
+
+static void* relay_loop(void* param) {
+    Relay* r = (Relay*)param;
+    char buf[65536];
+    pollfd fds[2] = {{r->front, POLLIN, 0}, {r->back, POLLIN, 0}};
+    while (!r->stop) {
+        if (poll(fds, 2, 100) <= 0)
+            continue;
+
+        if (fds[0].revents & POLLIN) {
+            sockaddr_in from;
+            socklen_t fromlen = sizeof(from);
+            int len = recvfrom(r->front, buf, sizeof(buf), 0, (sockaddr*)&from, &fromlen);
+            r->client = from;
+            r->known = true;
+            if (len > 0)
+                sendto(r->back, buf, len, 0, (sockaddr*)&r->server, sizeof(r->server));
+
+            uint32_t word = ntohl(*(uint32_t*)buf);
+            if ((len >= 16) && (0 == (word & 0x80000000)) && (0 != r->target)) {
+                int32_t seq = (int32_t)word;
+                ++ r->data;
+                if ((r->every > 0) && (0 == r->data % r->every)) {
+                    // inverted, acknowledged long ago, not sent yet, and reaching far past the data the sender holds
+                    forge(r, seq, seq_add(seq, -20));
+                    forge(r, seq_add(seq, -5000), seq_add(seq, -4000));
+                    forge(r, seq_add(seq, 100000), seq_add(seq, 100010));
+                    forge(r, seq_add(seq, -2), seq_add(seq, 1000000));
+                }
+                // none of them is ever sent, and each one is after all the others
+                for (int i = 0; i < r->flood; ++i)
+                    forge(r, seq_add(seq, 100000 + r->forged * 4), seq_add(seq, 100002 + r->forged * 4));
+            }
+        }
+
+        if (fds[1].revents & POLLIN) {
+            int len = recv(r->back, buf, sizeof(buf), 0);
+            if ((len > 0) && r->known)
+                sendto(r->front, buf, len, 0, (sockaddr*)&r->client, sizeof(r->client));
+        }
+    }
+    return NULL;
+}
+
+struct Pair {
+    UDTSOCKET serv;
+    UDTSOCKET server;
+    UDTSOCKET client;
+};
+
+static void* accept_one(void* param) {
+    Pair* p = (Pair*)param;
+    p->server = UDT::accept(p->serv, NULL, NULL);
+    return NULL;
+}
+
+// connect two SOCK_STREAM sockets over loopback through the relay; the receiving side is accepted
+static bool connect_pair(Pair& p, Relay& relay) {
+    p.serv = UDT::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    UDT::bind(p.serv, (sockaddr*)&addr, sizeof(addr));
+    int namelen = sizeof(addr);
+    UDT::getsockname(p.serv, (sockaddr*)&addr, &namelen);
+    UDT::listen(p.serv, 1);
+    relay.server = addr;
+
+    pthread_t t;
+    pthread_create(&t, NULL, accept_one, &p);
+
+    p.client = UDT::socket(AF_INET, SOCK_STREAM, 0);
+    int res = UDT::connect(p.client, (sockaddr*)&relay.entry, sizeof(relay.entry));
+
+    pthread_join(t, NULL);
+    relay.target = p.client;
+    return (UDT::ERROR != res) && (UDT::INVALID_SOCK != p.server);
+}
+
+static void close_pair(Pair& p) {
+    UDT::close(p.client);
+    UDT::close(p.server);
+    UDT::close(p.serv);
+}
+
+static void fill(vector<char>& data) {
+    for (int i = 0; i < (int)data.size(); ++i)
+        data[i] = (char)(i % 251);
+}
+
+static void* send_data(void* param) {
+    Pair* p = (Pair*)param;
+    vector<char> data(DATA_SIZE);
+    fill(data);
+    int sent = 0;
+    while (sent < DATA_SIZE) {
+        int res = UDT::send(p->client, &data[sent], DATA_SIZE - sent, 0);
+        if (res <= 0)
+            break;
+        sent += res;
+    }
+    return NULL;
+}
+
+// send a stream from the client through the relay, returning the number of bytes received intact, in order
+static int transfer(Relay& r, double& seconds) {
+    sockaddr_in addr;
+    r.front = bind_loopback(r.entry);
+    r.back = bind_loopback(addr);
+    pthread_t relay;
+    pthread_create(&relay, NULL, relay_loop, &r);
+
+    Pair p;
+    int intact = 0;
+    timeval start, end;
+    gettimeofday(&start, NULL);
+    if (connect_pair(p, r)) {
+        int timeout = 10000;
+        UDT::setsockopt(p.server, 0, UDT_RCVTIMEO, &timeout, sizeof(int));
+
+        pthread_t t;
+        pthread_create(&t, NULL, send_data, &p);
+
+        vector<char> data(DATA_SIZE), buf(DATA_SIZE);
+        fill(data);
+        int received = 0;
+        while (received < DATA_SIZE) {
+            int res = UDT::recv(p.server, &buf[received], DATA_SIZE - received, 0);
+            if (res <= 0)
+                break;
+            received += res;
+        }
+        while ((intact < received) && (buf[intact] == data[intact]))
+            ++ intact;
+
+        pthread_join(t, NULL);
+    }
+    gettimeofday(&end, NULL);
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+
+    close_pair(p);
+    r.stop = true;
+    pthread_join(relay, NULL);
+    close(r.front);
+    close(r.back);
+
+    return intact;
+}
+
+bool test_unfit_reports() {
+    cout << "\n[TEST 1] Reports That Do Not Fit The Sender Are Ignored\n";
+    cout << "=======================================================\n";
+
+    UDT::startup();
+
+    Relay r;
+    memset(&r, 0, sizeof(r));
+    r.every = 100;
+    double seconds = 0;
+    int intact = transfer(r, seconds);
+
+    UDT::cleanup();
+
+    cout << "Forged reports: " << r.forged << ", bytes received intact: " << intact << "/" << DATA_SIZE << endl;
+
+    bool passed = (r.forged > 0) && (DATA_SIZE == intact);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_report_flood() {
+    cout << "\n[TEST 2] A Flood Of Reports Does Not Hold Up The Transfer\n";
+    cout << "=========================================================\n";
+
+    UDT::startup();
+
+    Relay r;
+    memset(&r, 0, sizeof(r));
+    r.flood = 150;
+    double seconds = 0;
+    int intact = transfer(r, seconds);
+
+    UDT::cleanup();
+
+    cout << "Forged reports: " << r.forged << ", bytes received intact: " << intact << "/" << DATA_SIZE
+         << " in " << seconds << " s" << endl;
+
+    bool passed = (r.forged >= r.flood * DATA_SIZE / 1500) && (DATA_SIZE == intact) && (seconds < 4);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Abandoned Frame Report Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 2;
+
+    if (test_unfit_reports()) passed++;
+    if (test_report_flood()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
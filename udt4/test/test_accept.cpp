@@ -0,0 +1,342 @@
+/*
+ * Test program for the accept path
+ * This program tests the SYN cookies of a listening socket, a cookie given out on the wire and
+ * handed back, the handshakes dropped on a full handshake queue as UDT::acceptstats reports them,
+ * and a listener closed while handshakes are still coming in
+ */
+
+#include <iostream>
+#include <cstring>
+#include <pthread.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include "../src/udt.h"
+#include "../src/channel.h"
+#include "../src/common.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+// open a channel on an ephemeral loopback port and return its address
+static void open_loopback(CChannel& channel, sockaddr_in& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    channel.open((sockaddr*)&addr);
+    channel.getSockAddr((sockaddr*)&addr);
+}
+
+// start a stream listener on an ephemeral loopback port and return its address
+static UDTSOCKET open_listener(sockaddr_in& addr) {
+    UDTSOCKET serv = UDT::socket(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    UDT::bind(serv, (sockaddr*)&addr, sizeof(addr));
+    int namelen = sizeof(addr);
+    UDT::getsockname(serv, (sockaddr*)&addr, &namelen);
+    UDT::listen(serv, 10);
+    return serv;
+}
+
+// send a connection request as a connecting UDT socket does, with the given request type and cookie
+static void send_request(CChannel& channel, sockaddr_in& to, int reqtype, int32_t cookie, int32_t id) {
+    CHandShake hs;
+    hs.m_iVersion = 4;                  // CUDT::m_iVersion
+    hs.m_iType = 1;                     // UDT_STREAM
+    hs.m_iISN = 1000;
+    hs.m_iMSS = 1500;
+    hs.m_iFlightFlagSize = 8192;
+    hs.m_iReqType = reqtype;
+    hs.m_iID = id;
+    hs.m_iCookie = cookie;
+    hs.m_iExtension = 0;
+    memset(hs.m_piPeerIP, 0, sizeof(hs.m_piPeerIP));
+
+    char buf[CHandShake::m_iExtContentSize];
+    int size = CHandShake::m_iExtContentSize;
+    hs.serialize(buf, size);
+
+    CPacket packet;
+    packet.pack(0, NULL, buf, size);
+    packet.m_iID = 0;
+    packet.m_iTimeStamp = 0;
+    channel.sendto((sockaddr*)&to, packet);
+}
+
+// wait up to a second for the listener's answer
+static bool recv_response(CChannel& channel, CHandShake& hs) {
+    char buf[64];
+    CPacket packet;
+    sockaddr_in from;
+    for (int i = 0; i < 100; ++i) {
+        packet.m_pcData = buf;
+        packet.setLength(sizeof(buf));
+        if ((channel.recvfrom((sockaddr*)&from, packet) > 0) && (1 == packet.getFlag()) && (0 == packet.getType())) {
+            hs.deserialize(buf, packet.getLength());
+            packet.m_pcData = NULL;
+            return true;
+        }
+    }
+    packet.m_pcData = NULL;
+    return false;
+}
+
+bool test_cookie_compute() {
+    cout << "\n[TEST 1] SYN Cookie Computation\n";
+    cout << "================================\n";
+
+    uint64_t key[2], other[2];
+    CCookie::genKey(key);
+    CCookie::genKey(other);
+
+    sockaddr_in a, b;
+    memset(&a, 0, sizeof(a));
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(0x0A000001);
+    a.sin_port = htons(9000);
+    b = a;
+    b.sin_port = htons(9001);
+
+    sockaddr_in6 a6;
+    memset(&a6, 0, sizeof(a6));
+    a6.sin6_family = AF_INET6;
+    a6.sin6_addr.s6_addr[15] = 1;
+    a6.sin6_port = htons(9000);
+
+    int32_t cookie = CCookie::compute(key, (sockaddr*)&a, AF_INET, 42);
+
+    // the same peer in the same slot gets the same cookie back; anything else gets another one
+    bool same = (cookie == CCookie::compute(key, (sockaddr*)&a, AF_INET, 42)) &&
+                (CCookie::compute(key, (sockaddr*)&a6, AF_INET6, 42) == CCookie::compute(key, (sockaddr*)&a6, AF_INET6, 42));
+    bool slot = (cookie != CCookie::compute(key, (sockaddr*)&a, AF_INET, 43));
+    bool port = (cookie != CCookie::compute(key, (sockaddr*)&b, AF_INET, 42));
+    bool secret = (cookie != CCookie::compute(other, (sockaddr*)&a, AF_INET, 42)) && ((key[0] != other[0]) || (key[1] != other[1]));
+
+    cout << "Stable: " << (same ? "yes" : "no") << ", differs by slot: " << (slot ? "yes" : "no")
+         << ", by port: " << (port ? "yes" : "no") << ", by key: " << (secret ? "yes" : "no") << endl;
+
+    bool passed = same && slot && port && secret;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_cookie_round_trip() {
+    cout << "\n[TEST 2] SYN Cookie Round Trip\n";
+    cout << "===============================\n";
+
+    UDT::startup();
+
+    sockaddr_in servaddr;
+    UDTSOCKET serv = open_listener(servaddr);
+
+    CChannel peer(AF_INET);
+    sockaddr_in peeraddr;
+    open_loopback(peer, peeraddr);
+
+    // ask for a cookie
+    CHandShake res;
+    send_request(peer, servaddr, 1, 0, 1234);
+    bool answered = recv_response(peer, res) && (1 == res.m_iReqType) && (1234 == res.m_iID);
+    int32_t cookie = res.m_iCookie;
+
+    // a wrong cookie is turned down, the one given out lets the connection in
+    send_request(peer, servaddr, -1, cookie + 1, 1234);
+    send_request(peer, servaddr, -1, cookie, 1234);
+
+    UDT::ACCEPTINFO stats;
+    memset(&stats, 0, sizeof(stats));
+    for (int i = 0; (i < 100) && (0 == stats.connAcceptedTotal); ++i) {
+        usleep(10000);
+        UDT::acceptstats(serv, &stats, false);
+    }
+
+    bool counted = (3 == stats.hsRecvTotal) && (1 == stats.hsRejectedTotal) && (1 == stats.connAcceptedTotal) && (0 == stats.hsDroppedTotal);
+
+    // the interval counters are cleared, the totals are not
+    UDT::acceptstats(serv, &stats, true);
+    UDT::acceptstats(serv, &stats, false);
+    bool cleared = (0 == stats.hsRecv) && (0 == stats.connAccepted) && (3 == stats.hsRecvTotal) && (1 == stats.connAcceptedTotal);
+
+    sockaddr_in clientaddr;
+    int addrlen = sizeof(clientaddr);
+    UDTSOCKET conn = UDT::accept(serv, (sockaddr*)&clientaddr, &addrlen);
+    bool accepted = (UDT::INVALID_SOCK != conn) && (clientaddr.sin_port == peeraddr.sin_port);
+
+    UDT::close(conn);
+    UDT::close(serv);
+    peer.close();
+    UDT::cleanup();
+
+    cout << "Cookie given out: " << (answered ? "yes" : "no") << ", received " << stats.hsRecvTotal
+         << ", rejected " << stats.hsRejectedTotal << ", accepted " << stats.connAcceptedTotal
+         << ", counters cleared: " << (cleared ? "yes" : "no") << endl;
+
+    bool passed = answered && counted && cleared && accepted;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+struct Flood {
+    sockaddr_in to;
+    int rounds;
+    volatile bool stop;
+    int sent;
+};
+
+// send cookie requests in bursts, much faster than the accept thread can answer them
+static void* flood(void* param) {
+    Flood* f = (Flood*)param;
+    CChannel peer(AF_INET);
+    sockaddr_in peeraddr;
+    open_loopback(peer, peeraddr);
+
+    for (int r = 0; (r < f->rounds) && !f->stop; ++r) {
+        for (int i = 0; i < 1024; ++i)
+            send_request(peer, f->to, 1, 0, i + 1);
+        f->sent += 1024;
+        usleep(1000);
+    }
+
+    peer.close();
+    return NULL;
+}
+
+bool test_full_queue_drop() {
+    cout << "\n[TEST 3] Handshakes Dropped On A Full Queue\n";
+    cout << "============================================\n";
+
+    UDT::startup();
+
+    sockaddr_in servaddr;
+    UDTSOCKET serv = open_listener(servaddr);
+
+    UDT::ACCEPTINFO stats;
+    memset(&stats, 0, sizeof(stats));
+
+    // the queue holds 256 requests; a burst usually overruns it at once, give it a few more if not
+    Flood f;
+    f.to = servaddr;
+    f.rounds = 1;
+    f.stop = false;
+    f.sent = 0;
+    for (int i = 0; (i < 20) && (0 == stats.hsDroppedTotal); ++i) {
+        flood(&f);
+        UDT::acceptstats(serv, &stats, false);
+    }
+
+    // the requests are either answered or dropped, none is lost on the way
+    for (int i = 0; (i < 100) && (stats.hsQueueLen > 0); ++i) {
+        usleep(10000);
+        UDT::acceptstats(serv, &stats, false);
+    }
+    bool dropped = (stats.hsDroppedTotal > 0) && (stats.hsDropped == stats.hsDroppedTotal);
+    bool bounded = (stats.hsRecvTotal + stats.hsDroppedTotal <= f.sent) && (stats.hsRecvTotal > 0);
+    bool drained = (0 == stats.hsQueueLen);
+
+    UDT::close(serv);
+    UDT::cleanup();
+
+    cout << "Sent " << f.sent << " requests: " << stats.hsRecvTotal << " answered, " << stats.hsDroppedTotal << " dropped, "
+         << stats.hsQueueLen << " left queued" << endl;
+
+    bool passed = dropped && bounded && drained;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_close_while_answering() {
+    cout << "\n[TEST 4] Listener Closed During A Flood\n";
+    cout << "========================================\n";
+
+    UDT::startup();
+
+    // the accept thread keeps answering queued requests while the listeners go away under it
+    int closed = 0;
+    const int listeners = 10;
+    for (int i = 0; i < listeners; ++i) {
+        sockaddr_in servaddr;
+        UDTSOCKET serv = open_listener(servaddr);
+
+        Flood f;
+        f.to = servaddr;
+        f.rounds = 1000;
+        f.stop = false;
+        f.sent = 0;
+        pthread_t t;
+        pthread_create(&t, NULL, flood, &f);
+
+        usleep(5000 + i * 1000);
+        if (0 == UDT::close(serv))
+            ++ closed;
+
+        f.stop = true;
+        pthread_join(t, NULL);
+    }
+
+    UDT::cleanup();
+
+    cout << "Listeners closed under load: " << closed << "/" << listeners << endl;
+
+    bool passed = (closed == listeners);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 4 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 4 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Accept Path Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 4;
+
+    if (test_cookie_compute()) passed++;
+    if (test_cookie_round_trip()) passed++;
+    if (test_full_queue_drop()) passed++;
+    if (test_close_while_answering()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
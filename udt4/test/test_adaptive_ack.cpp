@@ -0,0 +1,350 @@
+/*
+ * Test program for adaptive acknowledgement
+ * This program tests the UDT_ADAPTIVEACK option and its inheritance by accepted sockets, the ACKs it saves
+ * against the fixed schedule on the same frame stream, and loss reports riding on full ACKs instead of
+ * going out as NAKs, seen on the wire through a relay that drops data packets
+ */
+
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <set>
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include "../src/udt.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+static const int FRAMES = 500;
+static const int FRAME_SIZE = 3000;
+
+// a UDP relay between a client and a server, dropping some of the data packets from the client
+struct Relay {
+    int front;              // socket the client connects to
+    int back;               // socket the server sees the client at
+    sockaddr_in entry;      // address of the front socket
+    sockaddr_in server;
+    sockaddr_in client;
+    bool known;             // if the client has been heard from
+    int dropEvery;          // drop every n-th data packet, 0 for none
+    volatile bool stop;
+    int data;               // data packets from the client
+    int dropped;
+    int naks;               // NAKs from the server
+    int acknaks;            // full ACKs with a loss report after them
+};
+
+static int bind_loopback(sockaddr_in& addr) {
+    int s = ::socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(s, (sockaddr*)&addr, sizeof(addr));
+    socklen_t namelen = sizeof(addr);
+    getsockname(s, (sockaddr*)&addr, &namelen);
+    return s;
+}
+
+static void* relay_loop(void* param) {
+    Relay* r = (Relay*)param;
+    char buf[65536];
+    pollfd fds[2] = {{r->front, POLLIN, 0}, {r->back, POLLIN, 0}};
+    while (!r->stop) {
+        if (poll(fds, 2, 100) <= 0)
+            continue;
+
+        if (fds[0].revents & POLLIN) {
+            sockaddr_in from;
+            socklen_t fromlen = sizeof(from);
+            int len = recvfrom(r->front, buf, sizeof(buf), 0, (sockaddr*)&from, &fromlen);
+            r->client = from;
+            r->known = true;
+            bool data = (len >= 16) && (0 == (ntohl(*(uint32_t*)buf) & 0x80000000));
+            if (data)
+                ++ r->data;
+            if (data && (r->dropEvery > 0) && (0 == r->data % r->dropEvery))
+                ++ r->dropped;
+            else if (len > 0)
+                sendto(r->back, buf, len, 0, (sockaddr*)&r->server, sizeof(r->server));
+        }
+
+        if (fds[1].revents & POLLIN) {
+            int len = recv(r->back, buf, sizeof(buf), 0);
+            if (len >= 16) {
+                // control packets have the classic 16-byte header; a full ACK carries 28 bytes
+                uint32_t word = ntohl(*(uint32_t*)buf);
+                int type = (word >> 16) & 0x7FFF;
+                if ((word & 0x80000000) && (3 == type))
+                    ++ r->naks;
+                else if ((word & 0x80000000) && (2 == type) && (len > 16 + 28))
+                    ++ r->acknaks;
+            }
+            if ((len > 0) && r->known)
+                sendto(r->front, buf, len, 0, (sockaddr*)&r->client, sizeof(r->client));
+        }
+    }
+    return NULL;
+}
+
+struct Pair {
+    bool adaptive;
+    UDTSOCKET serv;
+    UDTSOCKET server;
+    UDTSOCKET client;
+};
+
+static void* accept_one(void* param) {
+    Pair* p = (Pair*)param;
+    p->server = UDT::accept(p->serv, NULL, NULL);
+    return NULL;
+}
+
+// connect two SOCK_DGRAM sockets over loopback, through the relay if there is one; the receiving side is accepted
+static bool connect_pair(Pair& p, Relay* relay) {
+    p.serv = UDT::socket(AF_INET, SOCK_DGRAM, 0);
+    UDT::setsockopt(p.serv, 0, UDT_ADAPTIVEACK, &p.adaptive, sizeof(bool));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    UDT::bind(p.serv, (sockaddr*)&addr, sizeof(addr));
+    int namelen = sizeof(addr);
+    UDT::getsockname(p.serv, (sockaddr*)&addr, &namelen);
+    UDT::listen(p.serv, 1);
+
+    if (NULL != relay) {
+        relay->server = addr;
+        addr = relay->entry;
+    }
+
+    pthread_t t;
+    pthread_create(&t, NULL, accept_one, &p);
+
+    p.client = UDT::socket(AF_INET, SOCK_DGRAM, 0);
+    int res = UDT::connect(p.client, (sockaddr*)&addr, sizeof(addr));
+
+    pthread_join(t, NULL);
+    return (UDT::ERROR != res) && (UDT::INVALID_SOCK != p.server);
+}
+
+static void close_pair(Pair& p) {
+    UDT::close(p.client);
+    UDT::close(p.server);
+    UDT::close(p.serv);
+}
+
+static void fill_frame(vector<char>& frame, int f) {
+    for (int i = 0; i < (int)frame.size(); ++i)
+        frame[i] = (char)(f * 11 + i % 227);
+}
+
+// small frames, about a thousand per second; the fixed schedule acknowledges the end of every one of them
+static void* send_frames(void* param) {
+    Pair* p = (Pair*)param;
+    vector<char> frame(FRAME_SIZE);
+    for (int f = 0; f < FRAMES; ++f) {
+        fill_frame(frame, f);
+        UDT::sendframe(p->client, &frame[0], frame.size(), f, 0);
+        usleep(1000);
+    }
+    return NULL;
+}
+
+// send the frame stream from the client to the server, returning the number of frames received whole
+static int stream_frames(Pair& p) {
+    pthread_t t;
+    pthread_create(&t, NULL, send_frames, &p);
+
+    // a frame is returned once it is complete, one that needed a retransmission may come after the next ones
+    set<int> seen;
+    vector<char> frame(FRAME_SIZE), buf(FRAME_SIZE + 1000);
+    int whole = 0;
+    for (int f = 0; f < FRAMES; ++f) {
+        uint16_t frame_id = 0;
+        bool complete = false;
+        int res = UDT::recvframe(p.server, &buf[0], buf.size(), frame_id, complete);
+        if (res < 0)
+            break;
+        fill_frame(frame, frame_id);
+        if ((FRAME_SIZE == res) && complete && seen.insert(frame_id).second && (0 == memcmp(&buf[0], &frame[0], res)))
+            ++ whole;
+    }
+
+    pthread_join(t, NULL);
+    return whole;
+}
+
+bool test_option() {
+    cout << "\n[TEST 1] The Option Is Off By Default And Inherited\n";
+    cout << "====================================================\n";
+
+    UDT::startup();
+
+    UDTSOCKET u = UDT::socket(AF_INET, SOCK_DGRAM, 0);
+    bool val = true;
+    int len = sizeof(bool);
+    UDT::getsockopt(u, 0, UDT_ADAPTIVEACK, &val, &len);
+    bool off = !val && (sizeof(bool) == len);
+
+    val = true;
+    UDT::setsockopt(u, 0, UDT_ADAPTIVEACK, &val, sizeof(bool));
+    val = false;
+    UDT::getsockopt(u, 0, UDT_ADAPTIVEACK, &val, &len);
+    bool on = val;
+    UDT::close(u);
+
+    // set on the listener, the accepted socket has it, the connecting one does not
+    Pair p = {true};
+    bool connected = connect_pair(p, NULL);
+    bool accepted = false, client = true;
+    UDT::getsockopt(p.server, 0, UDT_ADAPTIVEACK, &accepted, &len);
+    UDT::getsockopt(p.client, 0, UDT_ADAPTIVEACK, &client, &len);
+    close_pair(p);
+
+    UDT::cleanup();
+
+    cout << "Default: " << (off ? "off" : "on") << ", after set: " << (on ? "on" : "off") << ", accepted socket: "
+         << (accepted ? "on" : "off") << ", connecting socket: " << (client ? "on" : "off") << endl;
+
+    bool passed = off && on && connected && accepted && !client;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_fewer_acks() {
+    cout << "\n[TEST 2] Fewer ACKs For The Same Frame Stream\n";
+    cout << "==============================================\n";
+
+    UDT::startup();
+
+    int whole[2], acks[2], saved[2], ack2[2];
+    bool connected = true;
+    for (int a = 0; a < 2; ++a) {
+        Pair p = {(1 == a)};
+        connected = connect_pair(p, NULL) && connected;
+        whole[a] = stream_frames(p);
+
+        UDT::TRACEINFO rcv, snd;
+        UDT::perfmon(p.server, &rcv, false);
+        UDT::perfmon(p.client, &snd, false);
+        acks[a] = rcv.pktSentACKTotal;
+        saved[a] = rcv.pktCtrlSavedTotal;
+        ack2[a] = snd.pktRecvACKTotal;
+        close_pair(p);
+    }
+
+    UDT::cleanup();
+
+    cout << "Frames received whole: " << whole[0] << " and " << whole[1] << "; ACKs sent: " << acks[0]
+         << " fixed, " << acks[1] << " adaptive; control packets reported saved: " << saved[0] << " and " << saved[1] << endl;
+
+    bool passed = connected && (FRAMES == whole[0]) && (FRAMES == whole[1]) && (acks[0] >= FRAMES) && (acks[1] < acks[0]) && (0 == saved[0]) &&
+                  (saved[1] > 0) && (ack2[0] > 0) && (ack2[1] > 0);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_loss_on_ack() {
+    cout << "\n[TEST 3] Loss Reports Ride On Full ACKs\n";
+    cout << "========================================\n";
+
+    UDT::startup();
+
+    int whole[2], naks[2], acknaks[2], retrans[2], reported[2], dropped[2];
+    bool connected = true;
+    for (int a = 0; a < 2; ++a) {
+        Relay r;
+        memset(&r, 0, sizeof(r));
+        r.dropEvery = 25;
+        sockaddr_in addr;
+        r.front = bind_loopback(r.entry);
+        r.back = bind_loopback(addr);
+        pthread_t t;
+        pthread_create(&t, NULL, relay_loop, &r);
+
+        Pair p = {(1 == a)};
+        connected = connect_pair(p, &r) && connected;
+        whole[a] = stream_frames(p);
+
+        UDT::TRACEINFO snd;
+        UDT::perfmon(p.client, &snd, false);
+        retrans[a] = snd.pktRetransTotal;
+        reported[a] = snd.pktRecvNAKTotal;
+        close_pair(p);
+
+        r.stop = true;
+        pthread_join(t, NULL);
+        close(r.front);
+        close(r.back);
+        naks[a] = r.naks;
+        acknaks[a] = r.acknaks;
+        dropped[a] = r.dropped;
+    }
+
+    UDT::cleanup();
+
+    cout << "Data packets dropped: " << dropped[0] << " and " << dropped[1] << "; fixed: " << naks[0] << " NAKs, "
+         << acknaks[0] << " ACKs with a loss report; adaptive: " << naks[1] << " NAKs, " << acknaks[1]
+         << " ACKs with a loss report; reports read by the sender: " << reported[0] << " and " << reported[1] << endl;
+
+    // a loss found on arrival rides on an ACK; losses found later by the timer still go out as NAKs
+    bool passed = connected && (FRAMES == whole[0]) && (FRAMES == whole[1]) && (dropped[0] > 0) && (dropped[1] > 0) &&
+                  (0 == acknaks[0]) && (naks[0] > 0) && (acknaks[1] > 0) && (naks[1] < naks[0]) &&
+                  (retrans[0] > 0) && (retrans[1] > 0) && (reported[1] >= acknaks[1]);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Adaptive Acknowledgement Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 3;
+
+    if (test_option()) passed++;
+    if (test_fewer_acks()) passed++;
+    if (test_loss_on_ack()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,229 @@
+/*
+ * Test program for the batched UDP channel
+ * This program tests the reservation of free receive units for a batch in CUnitQueue
+ * and the receiving of several datagrams with one call of CChannel::recvfrom, and the sending of control
+ * packets without converting their information in place
+ */
+
+#include <iostream>
+#include <cstring>
+#include <arpa/inet.h>
+#include "../src/channel.h"
+#include "../src/queue.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+static const int PAYLOAD = 1000;
+
+// open a channel on an ephemeral loopback port and return its address
+static void open_loopback(CChannel& channel, sockaddr_in& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    channel.open((sockaddr*)&addr);
+    channel.getSockAddr((sockaddr*)&addr);
+}
+
+bool test_batch_units() {
+    cout << "\n[TEST 1] A Whole Batch Of Free Units Is Reserved\n";
+    cout << "================================================\n";
+
+    CUnitQueue queue;
+    queue.init(32, PAYLOAD, AF_INET);
+
+    CUnit* units[CChannel::m_iMaxBatchSize];
+    int num = queue.getAvailUnits(units, CChannel::m_iMaxBatchSize);
+
+    bool distinct = true;
+    for (int i = 0; i < num; ++i)
+        for (int j = i + 1; j < num; ++j)
+            distinct = distinct && (units[i] != units[j]);
+
+    // a unit that a receiver buffer has taken is not given back
+    units[0]->m_iFlag = 1;
+    queue.putBackUnits(units, num);
+    CUnit* again[CChannel::m_iMaxBatchSize];
+    int num2 = queue.getAvailUnits(again, CChannel::m_iMaxBatchSize);
+    bool kept = true;
+    for (int i = 0; i < num2; ++i)
+        kept = kept && (again[i] != units[0]);
+
+    cout << "Reserved " << num << " units, distinct: " << (distinct ? "yes" : "no")
+         << ", taken unit kept out: " << (kept ? "yes" : "no") << endl;
+
+    bool passed = (num == CChannel::m_iMaxBatchSize) && distinct && (num2 == CChannel::m_iMaxBatchSize) && kept;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_batch_receive() {
+    cout << "\n[TEST 2] Several Datagrams Per Receive Call\n";
+    cout << "===========================================\n";
+
+    CChannel snd(AF_INET), rcv(AF_INET);
+    sockaddr_in sndaddr, rcvaddr;
+    open_loopback(snd, sndaddr);
+    open_loopback(rcv, rcvaddr);
+
+    const int count = 8;
+    char payload[PAYLOAD];
+    for (int i = 0; i < count; ++i) {
+        CPacket packet;
+        memset(payload, i, PAYLOAD);
+        packet.m_pcData = payload;
+        packet.setLength(PAYLOAD);
+        packet.m_iSeqNo = 100 + i;
+        packet.m_iMsgNo = 0xC0000000 | (1 + i);
+        packet.m_iTimeStamp = 0;
+        packet.m_iID = 7;
+        packet.setHeaderFormat<HDR_CLASSIC>(0, 0, 0, 0);
+        snd.sendto((sockaddr*)&rcvaddr, packet);
+        packet.m_pcData = NULL;
+    }
+
+    CUnitQueue queue;
+    queue.init(32, PAYLOAD, AF_INET);
+
+    CUnit* units[CChannel::m_iMaxBatchSize];
+    CPacket* packets[CChannel::m_iMaxBatchSize];
+    sockaddr_in from[CChannel::m_iMaxBatchSize];
+    sockaddr* addrs[CChannel::m_iMaxBatchSize];
+    int num = queue.getAvailUnits(units, CChannel::m_iMaxBatchSize);
+    for (int i = 0; i < num; ++i) {
+        units[i]->m_Packet.setLength(PAYLOAD);
+        packets[i] = &(units[i]->m_Packet);
+        addrs[i] = (sockaddr*)(from + i);
+    }
+
+    // everything has been queued on the loopback already, so one call takes all of it
+    int calls = 0, received = 0;
+    bool order = true;
+    while (received < count) {
+        int res = rcv.recvfrom(addrs, packets + received, num - received);
+        ++calls;
+        if (res <= 0)
+            break;
+        for (int i = received; i < received + res; ++i) {
+            // the channel reads every datagram into the largest header, the connection gives the rest back
+            packets[i]->trimHeader(CPacket::getFormatSize(HDR_CLASSIC));
+            order = order && (packets[i]->m_iSeqNo == 100 + i) && (packets[i]->getLength() == PAYLOAD) &&
+                    (packets[i]->m_pcData[0] == char(i)) && (from[i - received].sin_port == sndaddr.sin_port);
+        }
+        received += res;
+    }
+
+    queue.putBackUnits(units, num);
+    snd.close();
+    rcv.close();
+
+    cout << "Received " << received << " datagrams in " << calls << " calls, in order: " << (order ? "yes" : "no") << endl;
+
+    bool passed = (received == count) && (calls < count) && order;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_control_untouched() {
+    cout << "\n[TEST 3] Control Information Is Not Converted In Place\n";
+    cout << "======================================================\n";
+
+    CChannel snd(AF_INET), rcv(AF_INET);
+    sockaddr_in sndaddr, rcvaddr;
+    open_loopback(snd, sndaddr);
+    open_loopback(rcv, rcvaddr);
+
+    // an ACK whose information does not end on a whole word
+    const int len = 22;
+    int32_t info[6] = {0x01020304, 0x05060708, 0x090A0B0C, 0x0D0E0F10, 0x11121314, 0x15161718};
+    int32_t orig[6];
+    memcpy(orig, info, sizeof(info));
+    int32_t ack = 11;
+
+    CPacket packet;
+    packet.pack(2, &ack, info, len);
+    packet.m_iTimeStamp = 0;
+    packet.m_iID = 7;
+
+    // from the single packet call, and from a batch
+    int res = snd.sendto((sockaddr*)&rcvaddr, packet);
+    bool untouched = (0 == memcmp(info, orig, sizeof(info)));
+    sockaddr* to = (sockaddr*)&rcvaddr;
+    CPacket* batch = &packet;
+    int sent = snd.sendto(&to, &batch, 1);
+    untouched = untouched && (0 == memcmp(info, orig, sizeof(info)));
+
+    CUnitQueue queue;
+    queue.init(32, PAYLOAD, AF_INET);
+    bool received = true;
+    for (int i = 0; i < 2; ++i) {
+        CUnit* unit = queue.getNextAvailUnit();
+        unit->m_Packet.setLength(PAYLOAD);
+        sockaddr_in from;
+        int got = rcv.recvfrom((sockaddr*)&from, unit->m_Packet);
+        received = received && (len == got) && unit->m_Packet.getFlag() && (2 == unit->m_Packet.getType()) &&
+                   (0 == memcmp(unit->m_Packet.m_pcData, orig, len / 4 * 4)) &&
+                   (0 == memcmp(unit->m_Packet.m_pcData + len / 4 * 4, (char*)orig + len / 4 * 4, len % 4));
+    }
+
+    snd.close();
+    rcv.close();
+
+    cout << "Sent " << res << " bytes and " << sent << " batched packet, information untouched: " << (untouched ? "yes" : "no")
+         << ", received intact: " << (received ? "yes" : "no") << endl;
+
+    bool passed = (res > 0) && (1 == sent) && untouched && received;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Channel Batching Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 3;
+
+    if (test_batch_units()) passed++;
+    if (test_batch_receive()) passed++;
+    if (test_control_untouched()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,298 @@
+/*
+ * Test program for fan-out groups
+ * This program tests the reference count of a frame shared by the send buffers of a group, the errors
+ * of the group API, frames sent once to a group arriving whole at every subscriber, and subscribers
+ * leaving the group when removed or closed
+ */
+
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <set>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include "../src/udt.h"
+#include "../src/fanout.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+static const int SUBSCRIBERS = 3;
+
+bool test_shared_frame_refs() {
+    cout << "\n[TEST 1] A Shared Frame Lives Until Its Last Reference Goes\n";
+    cout << "============================================================\n";
+
+    char data[1000];
+    for (int i = 0; i < 1000; ++i)
+        data[i] = (char)i;
+
+    // the sender holds the first reference while it hands the frame to the subscribers
+    CSharedFrame* frame = CFanout::newFrame(data, sizeof(data));
+    bool copied = (frame->m_pcData != data) && (1000 == frame->m_iLength) && (0 == memcmp(frame->m_pcData, data, 1000));
+    int first = frame->m_iRefCount;
+
+    for (int i = 0; i < SUBSCRIBERS; ++i)
+        CFanout::addRef(frame);
+    int held = frame->m_iRefCount;
+
+    // the sender lets go first, the subscribers as their peers acknowledge the frame
+    CFanout::releaseFrame(UDT::INVALID_SOCK, frame->m_pcData, 1000, frame);
+    for (int i = 0; i < SUBSCRIBERS - 1; ++i)
+        CFanout::releaseFrame(i, frame->m_pcData, 1000, frame);
+    int last = frame->m_iRefCount;
+    bool intact = (0 == memcmp(frame->m_pcData, data, 1000));
+    CFanout::releaseFrame(SUBSCRIBERS - 1, frame->m_pcData, 1000, frame);
+
+    cout << "References: " << first << " when created, " << held << " with " << SUBSCRIBERS << " subscribers, "
+         << last << " before the last release" << endl;
+
+    bool passed = copied && (1 == first) && (1 + SUBSCRIBERS == held) && (1 == last) && intact;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_group_errors() {
+    cout << "\n[TEST 2] Group API Errors\n";
+    cout << "==========================\n";
+
+    UDT::startup();
+
+    int gid = UDT::fanout_create();
+    UDTSOCKET u = UDT::socket(AF_INET, SOCK_DGRAM, 0);
+
+    // only connected sockets subscribe
+    bool unconnected = (UDT::ERROR == UDT::fanout_add(gid, u)) && (CUDTException::ENOCONN == UDT::getlasterror().getErrorCode());
+    bool nosock = (UDT::ERROR == UDT::fanout_add(gid, u + 12345)) && (CUDTException::EINVSOCK == UDT::getlasterror().getErrorCode());
+
+    // a group with no subscribers takes nothing
+    char data[100] = {0};
+    bool empty = (0 == UDT::fanout_sendframe(gid, data, sizeof(data), 1, 0));
+
+    bool released = (0 == UDT::fanout_release(gid));
+    bool gone = (UDT::ERROR == UDT::fanout_sendframe(gid, data, sizeof(data), 1, 0)) &&
+                (CUDTException::EINVFANOUT == UDT::getlasterror().getErrorCode()) &&
+                (UDT::ERROR == UDT::fanout_release(gid));
+    bool unknown = (UDT::ERROR == UDT::fanout_remove(gid + 1000, u)) && (CUDTException::EINVFANOUT == UDT::getlasterror().getErrorCode());
+
+    UDT::close(u);
+    UDT::cleanup();
+
+    cout << "Unconnected socket refused: " << (unconnected ? "yes" : "no") << ", unknown socket: " << (nosock ? "yes" : "no")
+         << ", empty group sends to none: " << (empty ? "yes" : "no") << ", released group refused: " << (gone ? "yes" : "no") << endl;
+
+    bool passed = unconnected && nosock && empty && released && gone && unknown;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+struct Relay {
+    UDTSOCKET serv;
+    UDTSOCKET subscribers[SUBSCRIBERS];
+    UDTSOCKET viewers[SUBSCRIBERS];
+};
+
+static void* accept_all(void* param) {
+    Relay* r = (Relay*)param;
+    for (int i = 0; i < SUBSCRIBERS; ++i)
+        r->subscribers[i] = UDT::accept(r->serv, NULL, NULL);
+    return NULL;
+}
+
+// the relay accepts one connection per viewer, its ends of them are the subscribers
+static bool connect_viewers(Relay& r) {
+    r.serv = UDT::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    UDT::bind(r.serv, (sockaddr*)&addr, sizeof(addr));
+    int namelen = sizeof(addr);
+    UDT::getsockname(r.serv, (sockaddr*)&addr, &namelen);
+    UDT::listen(r.serv, SUBSCRIBERS);
+
+    pthread_t t;
+    pthread_create(&t, NULL, accept_all, &r);
+
+    bool ok = true;
+    for (int i = 0; i < SUBSCRIBERS; ++i) {
+        r.viewers[i] = UDT::socket(AF_INET, SOCK_DGRAM, 0);
+        ok = ok && (UDT::ERROR != UDT::connect(r.viewers[i], (sockaddr*)&addr, sizeof(addr)));
+    }
+
+    pthread_join(t, NULL);
+    for (int i = 0; i < SUBSCRIBERS; ++i)
+        ok = ok && (UDT::INVALID_SOCK != r.subscribers[i]);
+    return ok;
+}
+
+static void fill_frame(vector<char>& frame, int f) {
+    for (int i = 0; i < (int)frame.size(); ++i)
+        frame[i] = (char)(f * 7 + i % 233);
+}
+
+bool test_frames_to_all() {
+    cout << "\n[TEST 3] Every Subscriber Gets Every Frame\n";
+    cout << "===========================================\n";
+
+    UDT::startup();
+
+    Relay r;
+    bool connected = connect_viewers(r);
+
+    int gid = UDT::fanout_create();
+    for (int i = 0; i < SUBSCRIBERS; ++i)
+        UDT::fanout_add(gid, r.subscribers[i]);
+
+    // frames of several chunks, with deadlines far enough ahead
+    const int frames = 10;
+    int taken = 0;
+    vector<char> frame(30000);
+    for (int f = 0; f < frames; ++f) {
+        fill_frame(frame, f);
+        taken += UDT::fanout_sendframe(gid, &frame[0], frame.size(), 100 + f, 5000000);
+    }
+
+    // a frame is returned once it is complete, one that needed a retransmission may come after the next ones
+    int whole = 0;
+    vector<char> buf(40000);
+    for (int v = 0; v < SUBSCRIBERS; ++v) {
+        set<int> seen;
+        for (int f = 0; f < frames; ++f) {
+            uint16_t frame_id = 0;
+            bool complete = false;
+            int res = UDT::recvframe(r.viewers[v], &buf[0], buf.size(), frame_id, complete);
+            fill_frame(frame, frame_id - 100);
+            if ((30000 == res) && complete && seen.insert(frame_id).second && (0 == memcmp(&buf[0], &frame[0], res)))
+                ++ whole;
+        }
+    }
+
+    UDT::fanout_release(gid);
+    for (int i = 0; i < SUBSCRIBERS; ++i) {
+        UDT::close(r.viewers[i]);
+        UDT::close(r.subscribers[i]);
+    }
+    UDT::close(r.serv);
+    UDT::cleanup();
+
+    cout << "Frames taken by subscribers: " << taken << "/" << frames * SUBSCRIBERS << ", received whole: " << whole << endl;
+
+    bool passed = connected && (frames * SUBSCRIBERS == taken) && (frames * SUBSCRIBERS == whole);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_subscribers_leave() {
+    cout << "\n[TEST 4] Removed And Closed Subscribers Leave The Group\n";
+    cout << "========================================================\n";
+
+    UDT::startup();
+
+    Relay r;
+    bool connected = connect_viewers(r);
+
+    int gid = UDT::fanout_create();
+    for (int i = 0; i < SUBSCRIBERS; ++i)
+        UDT::fanout_add(gid, r.subscribers[i]);
+
+    vector<char> frame(5000, 'R');
+    int all = UDT::fanout_sendframe(gid, &frame[0], frame.size(), 1, 0);
+
+    UDT::fanout_remove(gid, r.subscribers[0]);
+    int removed = UDT::fanout_sendframe(gid, &frame[0], frame.size(), 2, 0);
+
+    UDT::close(r.subscribers[1]);
+    int closed = UDT::fanout_sendframe(gid, &frame[0], frame.size(), 3, 0);
+    int after = UDT::fanout_sendframe(gid, &frame[0], frame.size(), 4, 0);
+
+    // the remaining viewer gets all four frames, the removed one only the first
+    vector<char> buf(6000);
+    uint16_t frame_id = 0;
+    bool complete = false;
+    set<int> seen;
+    for (int f = 0; f < 4; ++f)
+        if (5000 == UDT::recvframe(r.viewers[2], &buf[0], buf.size(), frame_id, complete))
+            seen.insert(frame_id);
+    int last = seen.empty() ? 0 : *seen.rbegin();
+    int first = 0;
+    if (5000 == UDT::recvframe(r.viewers[0], &buf[0], buf.size(), frame_id, complete))
+        first = frame_id;
+    int timeout = 200;
+    UDT::setsockopt(r.viewers[0], 0, UDT_RCVTIMEO, &timeout, sizeof(int));
+    bool nomore = (UDT::ERROR == UDT::recvframe(r.viewers[0], &buf[0], buf.size(), frame_id, complete));
+
+    UDT::fanout_release(gid);
+    for (int i = 0; i < SUBSCRIBERS; ++i) {
+        UDT::close(r.viewers[i]);
+        UDT::close(r.subscribers[i]);
+    }
+    UDT::close(r.serv);
+    UDT::cleanup();
+
+    cout << "Subscribers taking a frame: " << all << ", after a removal " << removed << ", after a close " << closed
+         << ", then " << after << "; last frame of the remaining viewer " << last << ", of the removed one " << first << endl;
+
+    bool passed = connected && (SUBSCRIBERS == all) && (SUBSCRIBERS - 1 == removed) && (SUBSCRIBERS - 2 == closed) &&
+                  (SUBSCRIBERS - 2 == after) && (4 == seen.size()) && (4 == last) && (1 == first) && nomore;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 4 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 4 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Fan-Out Group Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 4;
+
+    if (test_shared_frame_refs()) passed++;
+    if (test_group_errors()) passed++;
+    if (test_frames_to_all()) passed++;
+    if (test_subscribers_leave()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,614 @@
+/*
+ * Test program for deadline-based frame dropping
+ * This program tests CSndBuffer::dropExpiredFrame, the range removal in the loss lists,
+ * the receiver frame table CRcvFrameBuffer with its deadline tracking, zero-copy frames in CSndBuffer
+ * the XOR parity chunks of a frame, the lock-free hand-off between the application and the send thread,
+ * the frame counters reported by perfmon, frames read from CRcvBuffer only from their own chunks,
+ * and frame deadlines and the sender's clock across the wrap of the 32-bit timestamp
+ */
+
+#include <iostream>
+#include <cstring>
+#include <pthread.h>
+#include "../src/buffer.h"
+#include "../src/list.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+static const int CHUNK_SIZE = 100;
+
+// add "chunks" one-packet messages of the same frame to the buffer
+static void add_frame(CSndBuffer& buf, uint16_t frame_id, int chunks, int64_t deadline) {
+    char data[CHUNK_SIZE];
+    memset(data, frame_id, CHUNK_SIZE);
+    for (int i = 0; i < chunks; ++i)
+        buf.addBuffer(data, CHUNK_SIZE, -1, false, frame_id, i, chunks, deadline);
+}
+
+bool test_live_frame_kept() {
+    cout << "\n[TEST 1] Frame Before Its Deadline Is Kept\n";
+    cout << "===========================================\n";
+
+    CSndBuffer buf(32, CHUNK_SIZE);
+    add_frame(buf, 1, 4, 1000);
+
+    int first = -1;
+    int32_t msgno = 0;
+    uint16_t frame_id = 0;
+    int dropped = buf.dropExpiredFrame(2, 999, first, msgno, frame_id);
+    int dropped_nodeadline = 0;
+
+    CSndBuffer buf2(32, CHUNK_SIZE);
+    add_frame(buf2, 1, 4, 0);
+    dropped_nodeadline = buf2.dropExpiredFrame(2, 1000000, first, msgno, frame_id);
+
+    cout << "Dropped before deadline: " << dropped
+         << ", dropped without deadline: " << dropped_nodeadline << endl;
+
+    bool passed = (dropped == 0) && (dropped_nodeadline == 0) && (buf.getCurrBufSize() == 4);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_whole_frame_dropped() {
+    cout << "\n[TEST 2] Expired Frame Is Dropped As A Whole\n";
+    cout << "=============================================\n";
+
+    CSndBuffer buf(32, CHUNK_SIZE);
+    add_frame(buf, 1, 3, 1000);
+    add_frame(buf, 2, 4, 2000);
+    add_frame(buf, 3, 3, 3000);
+
+    // send the first frame and half of the second one
+    char* data;
+    int32_t msgno;
+    for (int i = 0; i < 5; ++i)
+        buf.readData(&data, msgno);
+
+    // a retransmission request for chunk 1 of frame 2 after its deadline
+    int first = -1;
+    int32_t dropmsg = 0;
+    uint16_t frame_id = 0;
+    int dropped = buf.dropExpiredFrame(4, 2500, first, dropmsg, frame_id);
+
+    cout << "Dropped " << dropped << " blocks starting at offset " << first
+         << ", msgno " << dropmsg << endl;
+
+    // the next fresh packet must be the first chunk of frame 3
+    int len = buf.readData(&data, msgno);
+
+    cout << "Next packet: length " << len << ", first byte " << int(data[0])
+         << ", msgno " << (msgno & 0x1FFFFFFF) << endl;
+
+    bool passed = (dropped == 4) && (first == 3) && (dropmsg == 4) && (frame_id == 2) &&
+                  (len == CHUNK_SIZE) && (data[0] == 3) && ((msgno & 0x1FFFFFFF) == 8);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_loss_list_range_remove() {
+    cout << "\n[TEST 3] Loss List Range Removal\n";
+    cout << "=================================\n";
+
+    CSndLossList list(1024);
+    list.insert(10, 12);
+    list.insert(20, 30);
+    list.insert(40, 40);
+
+    // drop the frame covering [22, 25] and an unrelated empty range
+    list.remove(22, 25);
+    list.remove(35, 38);
+
+    cout << "Loss length after range removal: " << list.getLossLength() << endl;
+
+    int32_t expected[] = {10, 11, 12, 20, 21, 26, 27, 28, 29, 30, 40};
+    int n = sizeof(expected) / sizeof(int32_t);
+    bool passed = (list.getLossLength() == n);
+
+    for (int i = 0; i < n; ++i) {
+        int32_t seq = list.getLostSeq();
+        if (seq != expected[i]) {
+            cout << "Expected " << expected[i] << ", got " << seq << endl;
+            passed = false;
+        }
+    }
+    passed = passed && (list.getLostSeq() == -1);
+
+    // a range covering the head behaves like remove(seqno)
+    list.insert(50, 55);
+    list.insert(60, 61);
+    list.remove(49, 52);
+    passed = passed && (list.getLossLength() == 5) && (list.getLostSeq() == 53);
+
+    // a range covering whole nodes in the middle
+    CSndLossList list2(1024);
+    list2.insert(1, 1);
+    list2.insert(5, 6);
+    list2.insert(8, 8);
+    list2.insert(12, 13);
+    list2.remove(4, 9);
+    passed = passed && (list2.getLossLength() == 3) && (list2.getLostSeq() == 1) &&
+             (list2.getLostSeq() == 12) && (list2.getLostSeq() == 13);
+
+    // the receiver clears a dropped frame [105, 112] in one call
+    CRcvLossList rlist(1024);
+    rlist.insert(100, 106);
+    rlist.insert(110, 111);
+    rlist.insert(115, 120);
+    bool found = rlist.find(107, 109);
+    bool removed = rlist.remove(105, 112);
+    bool again = rlist.remove(105, 112);
+    int32_t losses[8];
+    int losslen = 0;
+    rlist.getLossArray(losses, losslen, 8);
+
+    cout << "Receiver loss length after frame removal: " << rlist.getLossLength() << endl;
+
+    passed = passed && !found && removed && !again && (rlist.getLossLength() == 11) && (losslen == 4) &&
+             (losses[0] == int32_t(100 | 0x80000000)) && (losses[1] == 104) &&
+             (losses[2] == int32_t(115 | 0x80000000)) && (losses[3] == 120);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_rcv_frame_table() {
+    cout << "\n[TEST 4] Receiver Frame Table\n";
+    cout << "==============================\n";
+
+    CRcvFrameBuffer frames(256);
+
+    // frame 1 misses its middle chunk, frame 2 arrives completely afterwards
+    frames.addChunk(1, 0, 3, 10);
+    frames.addChunk(1, 2, 3, 10);
+    bool done2 = frames.addChunk(2, 1, 2, 13) | frames.addChunk(2, 0, 2, 13);
+    bool dup = frames.addChunk(2, 0, 2, 13);
+
+    uint16_t frame_id = 0;
+    int pos = -1, chunks = 0, total_chunks = 0;
+    bool ready = frames.getReadyFrame(frame_id, pos, chunks, total_chunks);
+    cout << "Ready frame " << frame_id << " at " << pos << " with " << chunks << " chunks" << endl;
+    ready = ready && (frame_id == 2) && (pos == 13) && (chunks == 2) && (total_chunks == 2);
+
+    // a complete frame cannot be dropped any more, an incomplete one only once
+    bool drop2 = frames.dropFrame(2);
+    bool drop1 = frames.dropFrame(1);
+    bool drop1again = frames.dropFrame(1);
+    bool late = frames.addChunk(1, 1, 3, 10);
+
+    // only an incomplete frame with a deadline before the given time is reported as expired
+    frames.addChunk(5, 1, 2, 20, 1000, 7, 500);
+    frames.addChunk(6, 0, 2, 22, 1002, 8, 0);
+    int slot = 0;
+    int32_t seqno = -1, msgno = -1;
+    int64_t deadline = 0;
+    bool expired = frames.getExpiredFrame(600, slot, frame_id, seqno, chunks, msgno, deadline);
+    bool more = frames.getExpiredFrame(600, slot, frame_id, seqno, chunks, msgno, deadline);
+    slot = 0;
+    bool early = frames.getExpiredFrame(500, slot, frame_id, seqno, chunks, msgno, deadline);
+
+    bool passed = done2 && !dup && ready && !drop2 && drop1 && !drop1again && !late && (frames.getReadyFrameNum() == 0) &&
+                  expired && !more && !early && (frame_id == 5) && (seqno == 1000) && (chunks == 2) && (msgno == 7) && (deadline == 500);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 4 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 4 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+static int done_calls = 0;
+static const char* done_buf = NULL;
+
+static void frame_done(UDTSOCKET, const char* buf, int, void* context) {
+    ++done_calls;
+    done_buf = buf;
+    *(int*)context += 1;
+}
+
+bool test_zero_copy_frame() {
+    cout << "\n[TEST 5] Zero-Copy Frame Completion\n";
+    cout << "====================================\n";
+
+    char frame[CHUNK_SIZE * 3];
+    memset(frame, 7, sizeof(frame));
+    int context = 0;
+
+    CSndBuffer buf(32, CHUNK_SIZE);
+    int chunks = buf.addFrameRef(frame, sizeof(frame), 1, 0, 0, frame_done, &context);
+    add_frame(buf, 2, 1, 0);
+
+    // blocks point into the application frame
+    char* data;
+    int32_t msgno;
+    bool referenced = true;
+    for (int i = 0; i < chunks; ++i) {
+        buf.readData(&data, msgno);
+        referenced = referenced && (data == frame + i * CHUNK_SIZE);
+    }
+
+    buf.ackData(2);
+    int after_partial = done_calls;
+    buf.ackData(1);
+    int after_full = done_calls;
+
+    // a frame the buffer still holds is released with it
+    {
+        CSndBuffer buf2(32, CHUNK_SIZE);
+        buf2.addFrameRef(frame, sizeof(frame), 3, 0, 0, frame_done, &context);
+    }
+
+    cout << "Chunks " << chunks << ", callbacks after partial ACK " << after_partial
+         << ", after full ACK " << after_full << ", after close " << done_calls << endl;
+
+    bool passed = (chunks == 3) && referenced && (after_partial == 0) && (after_full == 1) &&
+                  (done_calls == 2) && (context == 2) && (done_buf == frame) && (buf.getCurrBufSize() == 1);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 5 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 5 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_frame_parity() {
+    cout << "\n[TEST 6] Frame Parity\n";
+    cout << "======================\n";
+
+    // 5 data chunks of 96 bytes (the last one of 16) in 2 interleaved groups
+    char frame[400];
+    for (int i = 0; i < int(sizeof(frame)); ++i)
+        frame[i] = char(i * 7);
+
+    CSndBuffer buf(32, CHUNK_SIZE);
+    int chunks = buf.addFrame(frame, sizeof(frame), 1, 0, -1, true, 2);
+
+    char* data;
+    int32_t msgno;
+    uint16_t frame_id;
+    uint8_t chunk_id, total, layer, required;
+    bool layerend;
+    int64_t deadline;
+    char block[7][CHUNK_SIZE];
+    int len[7];
+    bool layout = (buf.getCurrBufSize() == 7);
+    for (int i = 0; i < 7; ++i) {
+        len[i] = buf.readData(&data, msgno, frame_id, chunk_id, total, deadline, layer, required, layerend);
+        memcpy(block[i], data, len[i]);
+        layout = layout && (chunk_id == i) && (total == 5) &&
+                 (((msgno & 0x40000000) != 0) == (i == 6));
+    }
+
+    // the parity of group 1 covers chunks 1 and 3, so either of them can be rebuilt from it; their lengths cancel out
+    int group = -1, groups = 0, lenxor = 0;
+    bool header = CFrameFEC::readHeader(block[6], len[6], group, groups, lenxor);
+    char rebuilt[CHUNK_SIZE];
+    memcpy(rebuilt, block[6] + CFrameFEC::m_iHdrSize, len[6] - CFrameFEC::m_iHdrSize);
+    CFrameFEC::xorData(rebuilt, block[1], len[1]);
+    bool match = (memcmp(rebuilt, block[3], len[3]) == 0) && (memcmp(block[3], frame + 3 * 96, 96) == 0);
+
+    cout << "Data chunks " << chunks << ", parity group " << group << "/" << groups
+         << ", lengths " << len[4] << " and " << len[5] << endl;
+
+    // the receiver misses chunks 1 and 2: only the group whose parity has arrived can be rebuilt
+    CRcvFrameBuffer frames(256);
+    frames.addChunk(1, 0, 5, 10, 100);
+    frames.addChunk(1, 3, 5, 10, 100);
+    frames.addChunk(1, 4, 5, 10, 100);
+    bool parity = frames.addChunk(1, 6, 5, 10, 100, 0, 0, 2);
+    bool extra = frames.addChunk(1, 7, 5, 10, 100, 0, 0, 2);
+
+    int chunk = -1, pos = -1, n = 0, g = 0;
+    int32_t seqno = -1;
+    bool recoverable = frames.getRecoverable(1, chunk, pos, n, g, seqno);
+
+    int32_t losses[8];
+    int losslen = 0;
+    frames.getLossArray(1, 106, losses, losslen, 8);
+
+    frames.addChunk(1, 1, 5, 10, 100);
+    bool stuck = frames.getRecoverable(1, chunk, pos, n, g, seqno);
+
+    bool passed = (chunks == 5) && layout && (len[4] == 16) && (len[5] == CHUNK_SIZE) && (len[6] == CHUNK_SIZE) &&
+                  header && (group == 1) && (groups == 2) && (lenxor == 0) && match &&
+                  !parity && !extra && (frames.getGroups(1) == 2) && frames.isPending(1) &&
+                  recoverable && (chunk == 1) && (pos == 10) && (n == 5) && (g == 2) && (seqno == 100) &&
+                  (losslen == 2) && (losses[0] == int32_t(101 | 0x80000000)) && (losses[1] == 102) && !stuck;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 6 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 6 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+static const int RING_MESSAGES = 20000;
+static bool ring_ordered = true;
+
+// the send thread side: read each packet as soon as it is published, then acknowledge it
+static void* ring_consumer(void* arg) {
+    CSndBuffer* buf = (CSndBuffer*)arg;
+    char* data;
+    int32_t msgno;
+    int expected = 0;
+    while (expected < RING_MESSAGES) {
+        if (buf->readData(&data, msgno) == 0)
+            continue;
+        int value;
+        memcpy(&value, data, sizeof(int));
+        if (value != expected)
+            ring_ordered = false;
+        ++expected;
+        buf->ackData(1);
+    }
+    return NULL;
+}
+
+bool test_lock_free_ring() {
+    cout << "\n[TEST 7] Lock-Free Send Ring\n";
+    cout << "==============================\n";
+
+    // the buffer starts small, so it grows while the send thread is reading from it
+    CSndBuffer buf(32, CHUNK_SIZE);
+    pthread_t consumer;
+    pthread_create(&consumer, NULL, ring_consumer, &buf);
+
+    int grown = 0;
+    char data[CHUNK_SIZE];
+    memset(data, 0, CHUNK_SIZE);
+    for (int i = 0; i < RING_MESSAGES; ++i) {
+        while (buf.getCurrBufSize() >= 1000)
+            ;
+        if (buf.getCurrBufSize() > grown)
+            grown = buf.getCurrBufSize();
+        memcpy(data, &i, sizeof(int));
+        buf.addBuffer(data, CHUNK_SIZE, -1, false);
+    }
+    pthread_join(consumer, NULL);
+
+    cout << "Messages " << RING_MESSAGES << ", most in flight " << grown << endl;
+
+    bool passed = ring_ordered && (buf.getCurrBufSize() == 0);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 7 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 7 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_frame_stats() {
+    cout << "\n[TEST 8] Frame Statistics\n";
+    cout << "==========================\n";
+
+    // values are kept within 1/16: 1000 falls in [992, 1023], 100000 in [98304, 102399]
+    CHistogram hist;
+    for (int i = 0; i < 990; ++i)
+        hist.record(1000);
+    for (int i = 0; i < 10; ++i)
+        hist.record(100000);
+    int64_t p50 = hist.getPercentile(0.5);
+    int64_t p99 = hist.getPercentile(0.99);
+    int64_t p999 = hist.getPercentile(0.999);
+    bool histogram = (p50 == 1023) && (p99 == 1023) && (p999 == 100000) && (hist.getCount() == 1000);
+
+    cout << "p50 " << p50 << ", p99 " << p99 << ", p99.9 " << p999 << endl;
+
+    // frame 1 has a chunk retransmitted twice, frame 2 is dropped, frame 3 is acknowledged in two parts
+    char frame[250];
+    memset(frame, 1, sizeof(frame));
+    CSndBuffer buf(32, CHUNK_SIZE);
+    buf.addFrame(frame, sizeof(frame), 1, 0, -1, true, 0);
+    buf.addFrame(frame, sizeof(frame), 2, 0, -1, true, 0);
+    buf.addFrame(frame, sizeof(frame), 3, 0, -1, true, 0);
+
+    char* data;
+    int32_t msgno;
+    int msglen;
+    uint16_t frame_id;
+    uint8_t chunk_id, total;
+    int64_t deadline;
+    uint8_t layer, required;
+    bool layerend;
+    buf.readData(&data, 1, msgno, msglen, frame_id, chunk_id, total, deadline, layer, required, layerend);
+    buf.readData(&data, 1, msgno, msglen, frame_id, chunk_id, total, deadline, layer, required, layerend);
+
+    int first;
+    int dropped = buf.dropFrame(4, first, msgno, frame_id);
+
+    CFrameStats stats;
+    buf.ackData(7, &stats);
+    bool partial = (stats.m_iComplete == 1) && (stats.m_iMiss == 1);
+    buf.ackData(2, &stats);
+
+    cout << "Complete " << stats.m_llCompleteTotal << ", missed " << stats.m_llMissTotal
+         << ", retransmissions per frame " << stats.m_Retrans.getMean() << endl;
+
+    stats.clear();
+    bool cleared = (stats.m_iComplete == 0) && (stats.m_Latency.getCount() == 0) && (stats.m_llCompleteTotal == 2);
+
+    bool passed = histogram && (dropped == 3) && partial && (stats.m_llMissTotal == 1) && cleared;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 8 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 8 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+// put a chunk of a frame at "offset" in the receiver buffer, its data filled with the frame and chunk IDs
+static void put_chunk(CRcvBuffer& buf, CUnitQueue& queue, int offset, uint16_t frame_id, int chunk_id, int chunks) {
+    CUnit* unit = queue.getNextAvailUnit();
+    memset(unit->m_Packet.m_pcData, frame_id * 16 + chunk_id, CHUNK_SIZE);
+    unit->m_Packet.setLength(CHUNK_SIZE);
+    unit->m_Packet.setFrameInfo(frame_id, chunk_id, chunks);
+    buf.addData(unit, offset);
+}
+
+bool test_frame_chunks_checked() {
+    cout << "\n[TEST 9] Frames Are Read Only From Their Own Chunks\n";
+    cout << "====================================================\n";
+
+    CUnitQueue queue;
+    queue.init(32, CHUNK_SIZE, AF_INET);
+    CRcvBuffer buf(&queue, 32);
+
+    // frame 5 has two chunks, then comes frame 6; frame 7 has its chunks the wrong way round
+    put_chunk(buf, queue, 0, 5, 0, 2);
+    put_chunk(buf, queue, 1, 5, 1, 2);
+    put_chunk(buf, queue, 2, 6, 0, 1);
+    put_chunk(buf, queue, 3, 7, 1, 2);
+    put_chunk(buf, queue, 4, 7, 0, 2);
+
+    // a frame that runs into the next one, another frame ID, or chunks out of place are refused, and nothing is taken
+    char data[4 * CHUNK_SIZE];
+    vector<CUnit*> units;
+    bool overrun = (-1 == buf.readFrame(data, sizeof(data), 0, 5, 3));
+    bool otherid = (-1 == buf.readFrame(data, sizeof(data), 2, 5, 1)) && (-1 == buf.lendFrame(units, 0, 6, 2));
+    bool swapped = (-1 == buf.readFrame(data, sizeof(data), 3, 7, 2)) && (-1 == buf.lendFrame(units, 3, 7, 2)) && units.empty();
+
+    // the frames that are in place are still read whole
+    memset(data, 0, sizeof(data));
+    int size5 = buf.readFrame(data, sizeof(data), 0, 5, 2);
+    bool data5 = (data[0] == 5 * 16) && (data[CHUNK_SIZE] == 5 * 16 + 1);
+    int size6 = buf.lendFrame(units, 2, 6, 1);
+    bool data6 = (1 == units.size()) && (units[0]->m_Packet.m_pcData[0] == 6 * 16);
+    buf.releaseUnits(units);
+
+    cout << "Refused: overrun " << (overrun ? "yes" : "no") << ", other frame " << (otherid ? "yes" : "no")
+         << ", chunks out of place " << (swapped ? "yes" : "no") << "; read after: " << size5 << " and " << size6 << " bytes" << endl;
+
+    bool passed = overrun && otherid && swapped && (2 * CHUNK_SIZE == size5) && data5 && (CHUNK_SIZE == size6) && data6;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 9 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 9 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_timestamp_wrap() {
+    cout << "\n[TEST 10] Frame Deadlines Across The Timestamp Wrap\n";
+    cout << "===================================================\n";
+
+    CRcvFrameBuffer frames(256);
+
+    // the sender's timestamp wraps 8 ms after the first chunk, the one-way delay stays the same
+    const int64_t local = 5000000;
+    frames.updateClock(local, int32_t(0xFFFFF000U));
+    frames.updateClock(local + 0x2000, int32_t(0x00001000));
+    // a chunk delayed by another 4 ms does not move the clock
+    frames.updateClock(local + 0x3000, int32_t(0x00001000));
+    int64_t now = frames.getSenderTime(local + 0x3000);
+    bool clock = (0x2000 == now);
+
+    // the deadline of a frame sent after the wrap is an offset from the wrapped timestamp, 50 ms on
+    CPacket packet;
+    char chunk[CHUNK_SIZE];
+    packet.m_pcData = chunk;
+    packet.m_iTimeStamp = 0x00001000;
+    packet.setHeaderFormat<HDR_FRAME>(1, 0, 2, 0x100001000LL + 50000);
+    int64_t deadline1 = packet.getFrameDeadline();
+    bool encoded = (deadline1 > 0x1000 + 49000) && (deadline1 <= 0x1000 + 50000);
+    packet.m_pcData = NULL;
+
+    // frame 1 is due after the wrap, frame 2 was due just before it; frame 3 was sent on both sides of the wrap
+    frames.addChunk(1, 0, 2, 0, 100, 1, deadline1, 0, 0x1000);
+    frames.addChunk(2, 0, 2, 2, 102, 2, 0xFFFFF800LL, 0, 0xFFFFF000LL);
+    frames.addChunk(3, 1, 2, 4, 105, 3, 0, 0, 0x100);
+    frames.addChunk(3, 0, 2, 4, 104, 3, 0, 0, 0xFFFFFF00LL);
+    bool sent = (0xFFFFFF00LL == frames.getSentTime(3));
+
+    int slot = 0, chunks = 0;
+    uint16_t frame_id = 0;
+    int32_t seqno = -1, msgno = -1;
+    int64_t deadline = 0;
+    bool expired2 = frames.getExpiredFrame(now, slot, frame_id, seqno, chunks, msgno, deadline) && (2 == frame_id);
+    bool kept1 = !frames.getExpiredFrame(now, slot, frame_id, seqno, chunks, msgno, deadline);
+    slot = 0;
+    frames.getExpiredFrame(now + 60000, slot, frame_id, seqno, chunks, msgno, deadline);
+    bool expired1 = (1 == frame_id) && (deadline == deadline1);
+
+    cout << "Sender clock after the wrap: 0x" << hex << now << ", deadline 0x" << deadline1 << dec
+         << ", frame before the wrap expired: " << (expired2 ? "yes" : "no") << ", frame after it kept: " << (kept1 ? "yes" : "no") << endl;
+
+    bool passed = clock && encoded && sent && expired2 && kept1 && expired1;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 10 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 10 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Frame Drop Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 10;
+
+    if (test_live_frame_kept()) passed++;
+    if (test_whole_frame_dropped()) passed++;
+    if (test_loss_list_range_remove()) passed++;
+    if (test_rcv_frame_table()) passed++;
+    if (test_zero_copy_frame()) passed++;
+    if (test_frame_parity()) passed++;
+    if (test_lock_free_ring()) passed++;
+    if (test_frame_stats()) passed++;
+    if (test_frame_chunks_checked()) passed++;
+    if (test_timestamp_wrap()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
@@ -1,10 +1,12 @@
 /*
  * Test program for frame metadata functionality in CPacket
- * This program tests the frame_id, chunk_id, and total_chunks methods
+ * This program tests the frame_id, chunk_id, total_chunks and frame deadline methods,
+ * and the classic and frame layouts of the data packet header
  */
 
 #include <iostream>
 #include <cstring>
+#include <arpa/inet.h>
 #include "../src/packet.h"
 
 using namespace std;
@@ -25,7 +27,8 @@ bool test_basic_set_get() {
     int32_t frame_id = 12345;
     int32_t chunk_id = 123;
     int32_t total_chunks = 200;
-    int64_t frame_deadline = 1234567890;
+    int32_t timestamp = 1000000;
+    int64_t frame_deadline = 1016000;  // 16ms after the timestamp
 
     cout << "Setting: frame_id=" << frame_id
          << ", chunk_id=" << chunk_id
@@ -35,6 +38,7 @@ bool test_basic_set_get() {
     pkt.setFrameID(frame_id);
     pkt.setChunkID(chunk_id);
     pkt.setTotalChunks(total_chunks);
+    pkt.m_iTimeStamp = timestamp;
     pkt.setFrameDeadline(frame_deadline);
 
     // Get values back
@@ -52,7 +56,8 @@ bool test_basic_set_get() {
     bool passed = (got_frame_id == frame_id) &&
                   (got_chunk_id == chunk_id) &&
                   (got_total_chunks == total_chunks) &&
-                  (got_frame_deadline == frame_deadline);
+                  (got_frame_deadline == frame_deadline) &&
+                  (pkt.m_iTimeStamp == timestamp);
 
     if (passed) {
         cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
@@ -165,6 +170,38 @@ bool test_boundary_values() {
         }
     }
 
+    // Test frame deadline encoding (offset from the timestamp, 1/256 precision)
+    {
+        CPacket pkt;
+        pkt.m_iTimeStamp = 5000000;
+
+        cout << "Testing frame deadline encoding...\n";
+
+        int64_t offsets[] = {1, 255, 1000, 33333, 999999};
+        for (int i = 0; i < 5; ++i) {
+            int64_t deadline = 5000000 + offsets[i];
+            pkt.setFrameDeadline(deadline);
+            int64_t got = pkt.getFrameDeadline();
+            if ((got > deadline) || ((deadline - got) * 256 > offsets[i])) {
+                cout << RED << "  ✗ deadline offset " << offsets[i] << " failed, got " << got - 5000000 << RESET << endl;
+                all_passed = false;
+            } else {
+                cout << GREEN << "  ✓ deadline offset " << offsets[i] << " passed (" << got - 5000000 << ")" << RESET << endl;
+            }
+        }
+
+        pkt.setFrameDeadline(0);
+        bool none = (pkt.getFrameDeadline() == 0);
+        pkt.setFrameDeadline(4000000);
+        bool passed = (pkt.getFrameDeadline() == 5000001);
+        if (!none || !passed) {
+            cout << RED << "  ✗ no deadline / passed deadline failed" << RESET << endl;
+            all_passed = false;
+        } else {
+            cout << GREEN << "  ✓ no deadline (0) and passed deadline (timestamp+1) passed" << RESET << endl;
+        }
+    }
+
     if (all_passed) {
         cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
     } else {
@@ -180,20 +217,27 @@ bool test_no_bit_overlap() {
 
     CPacket pkt;
 
-    // Set all frame metadata to max values
+    // Set all frame metadata and the message number to max values
+    pkt.m_iMsgNo = 0xE001FFFF; // boundary, order flag and message number all set
+    pkt.m_iTimeStamp = 0x7FFFFFFF;
     pkt.setFrameID(65535);     // 0xFFFF
     pkt.setChunkID(255);       // 0xFF
     pkt.setTotalChunks(255);   // 0xFF
-    pkt.setFrameDeadline(0xFFFFFFFF);
+    pkt.setFrameDeadline(0x7FFFFFFFLL + CPacket::m_iMaxDeadlineOffset);
+
+    int64_t max_deadline = 0x7FFFFFFFLL + CPacket::m_iMaxDeadlineOffset;
 
     cout << "Set all to max values:\n";
-    cout << "  frame_id=65535, chunk_id=255, total_chunks=255, deadline=4294967295\n";
+    cout << "  frame_id=65535, chunk_id=255, total_chunks=255, deadline=" << max_deadline << "\n";
 
     // Verify all values
     bool passed = (pkt.getFrameID() == 65535) &&
                   (pkt.getChunkID() == 255) &&
                   (pkt.getTotalChunks() == 255) &&
-                  ((uint32_t)pkt.getFrameDeadline() == 0xFFFFFFFF);
+                  (pkt.getFrameDeadline() == max_deadline) &&
+                  (pkt.getMsgSeq() == 0x1FFFF) &&
+                  (pkt.getMsgBoundary() == 3) && pkt.getMsgOrderFlag() &&
+                  (pkt.m_iTimeStamp == 0x7FFFFFFF);
 
     cout << "Retrieved:\n";
     cout << "  frame_id=" << pkt.getFrameID()
@@ -207,7 +251,8 @@ bool test_no_bit_overlap() {
     bool no_overlap = (pkt.getFrameID() == 12345) &&
                       (pkt.getChunkID() == 255) &&  // Should remain unchanged
                       (pkt.getTotalChunks() == 255) &&  // Should remain unchanged
-                      ((uint32_t)pkt.getFrameDeadline() == 0xFFFFFFFF);  // Should remain unchanged
+                      (pkt.getFrameDeadline() == max_deadline) &&  // Should remain unchanged
+                      (pkt.getMsgSeq() == 0x1FFFF);  // Should remain unchanged
 
     cout << "Changed frame_id to 12345:\n";
     cout << "  frame_id=" << pkt.getFrameID()
@@ -216,7 +261,7 @@ bool test_no_bit_overlap() {
          << ", total_chunks=" << pkt.getTotalChunks()
          << " (should still be 255)"
          << ", deadline=" << pkt.getFrameDeadline()
-         << " (should still be 4294967295)" << endl;
+         << " (should still be " << max_deadline << ")" << endl;
 
     if (passed && no_overlap) {
         cout << GREEN << "✓ TEST 3 PASSED (no bit overlap detected)" << RESET << endl;
@@ -263,6 +308,58 @@ bool test_preserve_udt_fields() {
     return frame_ok;
 }
 
+bool test_header_formats() {
+    cout << "\n[TEST 5] Classic and Frame Header Layouts\n";
+    cout << "======================================\n";
+
+    CPacket pkt;
+    pkt.m_iTimeStamp = 1000000;
+
+    // a stock peer numbers messages with 29 bits, and the classic header has no room for a deadline
+    pkt.m_iMsgNo = 0x80000000 | 0x1ABCDEF;
+    pkt.setHeaderFormat<HDR_CLASSIC>(7, 3, 9, 1016000);
+    bool classic_ok = (pkt.getHeaderSize() == 16) &&
+                      (pkt.getMsgSeq() == 0x1ABCDEF) &&
+                      (pkt.getFrameDeadline() == 0);
+
+    pkt.m_iMsgNo = 0x80000000 | 0x1BCDE;
+    pkt.setHeaderFormat<HDR_FRAME>(7, 3, 9, 1016000);
+    bool frame_ok = (pkt.getHeaderSize() == 20) &&
+                    (pkt.getMsgSeq() == 0x1BCDE) &&
+                    (pkt.getFrameID() == 7) && (pkt.getChunkID() == 3) && (pkt.getTotalChunks() == 9) &&
+                    (pkt.getFrameDeadline() == 1016000) &&
+                    (pkt.getMsgBoundary() == 2);
+
+    cout << "  classic: " << (classic_ok ? "ok" : "wrong") << ", frame: " << (frame_ok ? "ok" : "wrong") << endl;
+
+    // a classic packet received into the frame header: its first 4 payload bytes sit in the frame word
+    char data[16] = "efgh";
+    uint32_t word;
+    memcpy(&word, "abcd", 4);
+    word = ntohl(word);
+    pkt.setFrameInfo(word & 0xFFFF, (word >> 16) & 0xFF, word >> 24);
+    pkt.m_pcData = data;
+    pkt.setLength(4);
+    pkt.trimHeader(CPacket::getFormatSize(HDR_CLASSIC));
+
+    bool restored = (pkt.getHeaderSize() == 16) &&
+                    (pkt.getLength() == 8) &&
+                    (memcmp(data, "abcdefgh", 8) == 0) &&
+                    (pkt.getFrameID() == 0);
+
+    cout << "  payload given back: " << string(data, pkt.getLength()) << endl;
+    pkt.m_pcData = NULL;
+
+    bool passed = classic_ok && frame_ok && restored;
+    if (passed) {
+        cout << GREEN << "✓ TEST 5 PASSED (both layouts read back)" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 5 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
 int main() {
     cout << "\n";
     cout << "========================================\n";
@@ -270,12 +367,13 @@ int main() {
     cout << "========================================\n";
 
     int passed = 0;
-    int total = 4;
+    int total = 5;
 
     if (test_basic_set_get()) passed++;
     if (test_boundary_values()) passed++;
     if (test_no_bit_overlap()) passed++;
     if (test_preserve_udt_fields()) passed++;
+    if (test_header_formats()) passed++;
 
     cout << "\n";
     cout << "========================================\n";
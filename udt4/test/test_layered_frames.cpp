@@ -0,0 +1,325 @@
+/*
+ * Test program for layered frames
+ * This program tests the layered packet header on the wire, the optional chunks CSndBuffer::shedLayers
+ * gives up, the partial frames CRcvFrameBuffer makes ready without their optional layers,
+ * and UDT::sendframe_layered end to end with and without UDT_FRAMELAYERS negotiated
+ */
+
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include "../src/udt.h"
+#include "../src/channel.h"
+#include "../src/buffer.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+static const int CHUNK_SIZE = 100;
+
+// open a channel on an ephemeral loopback port and return its address
+static void open_loopback(CChannel& channel, sockaddr_in& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    channel.open((sockaddr*)&addr);
+    channel.getSockAddr((sockaddr*)&addr);
+}
+
+// send one data packet with the given header layout, the payload filled with "fill"
+template <int FORMAT>
+static void send_chunk(CChannel& channel, sockaddr_in& to, int32_t seqno, char fill, int layer, int required, bool layerend) {
+    char payload[CHUNK_SIZE];
+    memset(payload, fill, CHUNK_SIZE);
+    CPacket packet;
+    packet.m_pcData = payload;
+    packet.setLength(CHUNK_SIZE);
+    packet.m_iSeqNo = seqno;
+    packet.m_iMsgNo = 0xC0000000 | 1;
+    packet.m_iTimeStamp = 0;
+    packet.m_iID = 7;
+    packet.setHeaderFormat<FORMAT>(9, 3, 5, 0, layer, required, layerend);
+    channel.sendto((sockaddr*)&to, packet);
+    packet.m_pcData = NULL;
+}
+
+bool test_layered_header_wire() {
+    cout << "\n[TEST 1] Layered Header Round Trip\n";
+    cout << "===================================\n";
+
+    CChannel snd(AF_INET), rcv(AF_INET);
+    sockaddr_in sndaddr, rcvaddr;
+    open_loopback(snd, sndaddr);
+    open_loopback(rcv, rcvaddr);
+
+    send_chunk<HDR_LAYERED>(snd, rcvaddr, 100, 'L', 2, 3, true);
+    send_chunk<HDR_FRAME>(snd, rcvaddr, 101, 'F', 2, 3, true);
+
+    char buf[2][CHUNK_SIZE + 8];
+    CPacket packet[2];
+    int res[2];
+    sockaddr_in from;
+    for (int i = 0; i < 2; ++i) {
+        packet[i].m_pcData = buf[i];
+        packet[i].setLength(CHUNK_SIZE + 8);
+        res[i] = rcv.recvfrom((sockaddr*)&from, packet[i]);
+    }
+
+    // every packet comes in with the 24-byte header: the layered one as it is
+    bool layered = (res[0] > 0) && (packet[0].getHeaderSize() == 24) && (packet[0].getLength() == CHUNK_SIZE) &&
+                   (packet[0].getFrameID() == 9) && (packet[0].getChunkID() == 3) && (packet[0].getTotalChunks() == 5) &&
+                   (packet[0].getLayer() == 2) && (packet[0].getRequiredChunks() == 3) && packet[0].isLayerEnd() &&
+                   (buf[0][0] == 'L') && (buf[0][CHUNK_SIZE - 1] == 'L');
+
+    // the 20-byte one gets its first payload word back, and has no layer fields
+    packet[1].trimHeader(CPacket::getFormatSize(HDR_FRAME));
+    bool trimmed = (res[1] > 0) && (packet[1].getHeaderSize() == 20) && (packet[1].getLength() == CHUNK_SIZE) &&
+                   (packet[1].getFrameID() == 9) && (packet[1].getLayer() == 0) && (packet[1].getRequiredChunks() == 0) &&
+                   !packet[1].isLayerEnd() && (buf[1][0] == 'F') && (buf[1][CHUNK_SIZE - 1] == 'F');
+
+    for (int i = 0; i < 2; ++i)
+        packet[i].m_pcData = NULL;
+    snd.close();
+    rcv.close();
+
+    cout << "Layered header read back: " << (layered ? "yes" : "no")
+         << ", frame header trimmed: " << (trimmed ? "yes" : "no") << endl;
+
+    bool passed = layered && trimmed;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_shed_optional_layers() {
+    cout << "\n[TEST 2] Only Optional Layers Are Shed\n";
+    cout << "=======================================\n";
+
+    // base layer of 2 chunks, two optional layers of 1 and 2 chunks, each chunk within its layer
+    char frame[CHUNK_SIZE * 5];
+    memset(frame, 3, sizeof(frame));
+    int layers[3] = {CHUNK_SIZE * 2 - 10, CHUNK_SIZE, CHUNK_SIZE + 10};
+
+    CSndBuffer buf(32, CHUNK_SIZE);
+    int chunks = buf.addLayeredFrame(frame, layers, 3, 1, 4, 5000);
+
+    int chunk, total, required, layer;
+    int64_t deadline;
+    bool info = true;
+    int expected_layer[5] = {0, 0, 1, 2, 2};
+    for (int i = 0; i < chunks; ++i) {
+        info = info && buf.getLayerInfo(i, chunk, total, required, layer, deadline) && (chunk == i) && (total == 5) &&
+               (required == 2) && (layer == expected_layer[i]) && (deadline == 5000);
+    }
+
+    // a chunk of the base layer is never shed; from an optional one on, the rest of the frame goes
+    int32_t msgno = 0;
+    uint16_t frame_id = 0;
+    int shed_base = buf.shedLayers(1, msgno, frame_id);
+    int shed_optional = buf.shedLayers(3, msgno, frame_id);
+
+    // a frame without optional layers has nothing to shed
+    CSndBuffer buf2(32, CHUNK_SIZE);
+    buf2.addLayeredFrame(frame, layers, 3, 3, 5, 5000);
+    int shed_required = buf2.shedLayers(3, msgno, frame_id);
+
+    cout << "Chunks " << chunks << ", shed from the base layer " << shed_base << ", from layer 2 " << shed_optional
+         << ", with every layer required " << shed_required << endl;
+
+    bool passed = (chunks == 5) && info && (shed_base == 0) && (shed_optional == 2) && (frame_id == 4) &&
+                  (shed_required == 0) && (buf.getCurrBufSize() == 5);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_partial_frame_delivery() {
+    cout << "\n[TEST 3] Partial Frames Keep Their Complete Layers\n";
+    cout << "===================================================\n";
+
+    // frame 1: chunks 0-1 required, layer ends after 1, 2 and 4; the sender sheds from chunk 3 on
+    CRcvFrameBuffer frames(16);
+    frames.addChunk(1, 0, 5, 10, 100, 1, 0, 0, -1, 2, false);
+    frames.addChunk(1, 1, 5, 10, 100, 1, 0, 0, -1, 2, true);
+    bool waiting = !frames.addChunk(1, 2, 5, 10, 100, 1, 0, 0, -1, 2, true) && frames.isPending(1);
+
+    int pos = 0, chunks = 0, total = 0, readable = 0;
+    int32_t seqno = 0;
+    int64_t deadline = 0;
+    bool shed = frames.shedChunks(1, 3, pos, seqno, chunks, deadline);
+    bool partial = frames.isPartial(1);
+
+    uint16_t frame_id = 0;
+    bool ready = frames.getReadyFrame(frame_id, pos, chunks, total);
+    bool shed_read = ready && (frame_id == 1) && (pos == 10) && (chunks == 3) && (total == 5);
+    int shed_chunks = chunks;
+
+    // frame 2: at its deadline, the chunks after the first gap are given up, an incomplete layer with them
+    frames.addChunk(2, 0, 5, 20, 105, 2, 0, 0, -1, 2, false);
+    frames.addChunk(2, 1, 5, 20, 105, 2, 0, 0, -1, 2, true);
+    frames.addChunk(2, 2, 5, 20, 105, 2, 0, 0, -1, 2, false);
+    frames.addChunk(2, 4, 5, 20, 105, 2, 0, 0, -1, 2, true);
+    bool settled = frames.settleFrame(2, pos, seqno, chunks, readable, deadline) && (readable == 2) && frames.isPartial(2);
+
+    // frame 3: a frame without its required layers is not made ready
+    frames.addChunk(3, 0, 5, 30, 110, 3, 0, 0, -1, 2, false);
+    frames.addChunk(3, 2, 5, 30, 110, 3, 0, 0, -1, 2, true);
+    bool unusable = !frames.settleFrame(3, pos, seqno, chunks, readable, deadline) && frames.isPending(3);
+
+    cout << "Shed frame ready: " << (shed ? "yes" : "no") << ", read with " << shed_chunks << " of " << total
+         << " chunks, settled frame readable " << readable << endl;
+
+    bool passed = waiting && shed && partial && shed_read && settled && unusable;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+// the server side of an end-to-end run: accepts one connection and receives one frame
+struct Receiver {
+    UDTSOCKET serv;
+    vector<char> frame;
+    int len;
+    bool complete;
+};
+
+static void* receive_frame(void* param) {
+    Receiver* r = (Receiver*)param;
+    r->len = -1;
+
+    sockaddr_in addr;
+    int addrlen = sizeof(addr);
+    UDTSOCKET u = UDT::accept(r->serv, (sockaddr*)&addr, &addrlen);
+    if (UDT::INVALID_SOCK == u)
+        return NULL;
+
+    int timeout = 5000;
+    UDT::setsockopt(u, 0, UDT_RCVTIMEO, &timeout, sizeof(int));
+    uint16_t frame_id;
+    r->len = UDT::recvframe(u, &r->frame[0], r->frame.size(), frame_id, r->complete);
+
+    UDT::close(u);
+    return NULL;
+}
+
+// send one layered frame that cannot make its deadline at the initial sending rate
+static void run_layered_frame(bool sndlayers, bool rcvlayers, Receiver& r, const int* layers) {
+    r.serv = UDT::socket(AF_INET, SOCK_DGRAM, 0);
+    UDT::setsockopt(r.serv, 0, UDT_FRAMELAYERS, &rcvlayers, sizeof(bool));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    UDT::bind(r.serv, (sockaddr*)&addr, sizeof(addr));
+    int addrlen = sizeof(addr);
+    UDT::getsockname(r.serv, (sockaddr*)&addr, &addrlen);
+    UDT::listen(r.serv, 1);
+
+    pthread_t t;
+    pthread_create(&t, NULL, receive_frame, &r);
+
+    UDTSOCKET client = UDT::socket(AF_INET, SOCK_DGRAM, 0);
+    UDT::setsockopt(client, 0, UDT_FRAMELAYERS, &sndlayers, sizeof(bool));
+    if (UDT::ERROR != UDT::connect(client, (sockaddr*)&addr, sizeof(addr))) {
+        vector<char> frame(layers[0] + layers[1]);
+        memset(&frame[0], 'B', layers[0]);
+        memset(&frame[layers[0]], 'E', layers[1]);
+
+        // the deadline is on the time base of the connection
+        UDT::TRACEINFO perf;
+        UDT::perfmon(client, &perf, false);
+        UDT::sendframe_layered(client, &frame[0], layers, 2, 1, 1, (perf.msTimeStamp + 20) * 1000);
+    }
+
+    pthread_join(t, NULL);
+    UDT::close(client);
+    UDT::close(r.serv);
+}
+
+bool test_layered_frame_end_to_end() {
+    cout << "\n[TEST 4] Layered Frames End To End\n";
+    cout << "===================================\n";
+
+    UDT::startup();
+
+    // a small base layer and an enhancement layer of about a hundred packets
+    int layers[2] = {1000, 100000};
+
+    Receiver both;
+    both.frame.resize(layers[0] + layers[1]);
+    run_layered_frame(true, true, both, layers);
+    bool partial = (both.len == layers[0]) && !both.complete && (both.frame[0] == 'B') && (both.frame[layers[0] - 1] == 'B');
+
+    // without the layered header on both sides the whole frame is required
+    Receiver one;
+    one.frame.resize(layers[0] + layers[1]);
+    run_layered_frame(true, false, one, layers);
+    bool whole = (one.len == layers[0] + layers[1]) && one.complete && (one.frame[layers[0]] == 'E');
+
+    UDT::cleanup();
+
+    cout << "Negotiated: received " << both.len << " bytes, complete " << (both.complete ? "yes" : "no")
+         << "; one side only: received " << one.len << " bytes, complete " << (one.complete ? "yes" : "no") << endl;
+
+    bool passed = partial && whole;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 4 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 4 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Layered Frames Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 4;
+
+    if (test_layered_header_wire()) passed++;
+    if (test_shed_optional_layers()) passed++;
+    if (test_partial_frame_delivery()) passed++;
+    if (test_layered_frame_end_to_end()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
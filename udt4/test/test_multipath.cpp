@@ -0,0 +1,374 @@
+/*
+ * Test program for multipath sessions
+ * This program tests slices packed from a frame and merged back in any order, frames given up when a slice is
+ * abandoned, malformed or its sub-flow fails, frames returned in the order they complete, and a frame stream
+ * sent end to end over two loopback sub-flows, one of which goes away
+ */
+
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <set>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include "../src/udt.h"
+#include "../src/multipath.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+static const int CHUNK_SIZE = 100;
+
+static void fill_frame(vector<char>& frame, int f) {
+    for (int i = 0; i < (int)frame.size(); ++i)
+        frame[i] = (char)(f * 13 + i % 239);
+}
+
+// the slice of a frame holding the given chunks
+static vector<char> make_slice(const vector<char>& frame, const vector<uint16_t>& chunks) {
+    vector<char> slice(CMultipath::getSliceSize(frame.size(), CHUNK_SIZE, chunks));
+    int size = CMultipath::packSlice(&slice[0], &frame[0], frame.size(), CHUNK_SIZE, chunks);
+    slice.resize(size);
+    return slice;
+}
+
+// odd or even chunks of a frame, as two sub-flows would take them
+static vector<uint16_t> every_other(int len, int first) {
+    vector<uint16_t> chunks;
+    for (int c = first; c < (len + CHUNK_SIZE - 1) / CHUNK_SIZE; c += 2)
+        chunks.push_back(c);
+    return chunks;
+}
+
+bool test_merge_slices() {
+    cout << "\n[TEST 1] Slices Merge Back Into The Frame In Any Order\n";
+    cout << "=======================================================\n";
+
+    CMultipath mp;
+    int mid = mp.create(1);
+
+    // eleven chunks, the last one short and in the even slice
+    vector<char> frame(1050);
+    fill_frame(frame, 1);
+    vector<char> even = make_slice(frame, every_other(frame.size(), 0));
+    vector<char> odd = make_slice(frame, every_other(frame.size(), 1));
+    bool sized = ((int)even.size() == CMultipath::m_iSliceHdrSize + 6 * 2 + 550) &&
+                 ((int)odd.size() == CMultipath::m_iSliceHdrSize + 5 * 2 + 500);
+
+    vector<char> buf(2000);
+    int size;
+    uint16_t frame_id;
+    bool complete;
+
+    // nothing is ready until the last chunk is in
+    mp.merge(mid, 7, &odd[0], odd.size());
+    bool waiting = !mp.readFrame(mid, &buf[0], buf.size(), size, frame_id, complete);
+    mp.merge(mid, 7, &even[0], even.size());
+    bool merged = mp.readFrame(mid, &buf[0], buf.size(), size, frame_id, complete) && (7 == frame_id) && complete &&
+                  (1050 == size) && (0 == memcmp(&buf[0], &frame[0], size));
+
+    // a slice arriving again after its frame is done is discarded
+    mp.merge(mid, 7, &even[0], even.size());
+    bool late = !mp.readFrame(mid, &buf[0], buf.size(), size, frame_id, complete);
+
+    // a whole frame in one slice, read into a buffer too small for it
+    vector<uint16_t> all;
+    for (int c = 0; c < 11; ++c)
+        all.push_back(c);
+    vector<char> whole = make_slice(frame, all);
+    mp.merge(mid, 8, &whole[0], whole.size());
+    bool truncated = mp.readFrame(mid, &buf[0], 500, size, frame_id, complete) && (8 == frame_id) && complete && (500 == size);
+
+    mp.release(mid);
+
+    cout << "Slice sizes: " << even.size() << " and " << odd.size() << ", merged: " << (merged ? "yes" : "no")
+         << ", late slice discarded: " << (late ? "yes" : "no") << ", truncated read: " << (truncated ? "yes" : "no") << endl;
+
+    bool passed = sized && waiting && merged && late && truncated;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_give_up() {
+    cout << "\n[TEST 2] Abandoned, Malformed And Failed Frames Are Given Up\n";
+    cout << "==============================================================\n";
+
+    CMultipath mp;
+    int mid = mp.create(1);
+
+    vector<char> frame(1000);
+    fill_frame(frame, 2);
+    vector<char> even = make_slice(frame, every_other(frame.size(), 0));
+    vector<char> odd = make_slice(frame, every_other(frame.size(), 1));
+
+    vector<char> buf(2000);
+    int size;
+    uint16_t frame_id;
+    bool complete;
+
+    // a sub-flow abandons its slice at the deadline: the frame is reported once, without data
+    mp.merge(mid, 1, &even[0], even.size());
+    mp.abandon(mid, 1);
+    mp.abandon(mid, 1);
+    mp.merge(mid, 1, &odd[0], odd.size());
+    bool abandoned = mp.readFrame(mid, &buf[0], buf.size(), size, frame_id, complete) && (1 == frame_id) && !complete && (0 == size) &&
+                     !mp.readFrame(mid, &buf[0], buf.size(), size, frame_id, complete);
+
+    // a slice cut short, and one that disagrees with the frame size
+    mp.merge(mid, 2, &even[0], even.size() - 1);
+    vector<char> bad(odd);
+    bad[3] ^= 1;
+    mp.merge(mid, 3, &even[0], even.size());
+    mp.merge(mid, 3, &bad[0], bad.size());
+    int malformed = 0;
+    while (mp.readFrame(mid, &buf[0], buf.size(), size, frame_id, complete))
+        if (!complete && (0 == size))
+            ++ malformed;
+
+    // a sub-flow fails: the frames still merging are given up, later ones merge as usual
+    mp.merge(mid, 4, &even[0], even.size());
+    mp.merge(mid, 5, &odd[0], odd.size());
+    mp.giveUp(mid);
+    int failed = 0;
+    while (mp.readFrame(mid, &buf[0], buf.size(), size, frame_id, complete))
+        if (!complete && ((4 == frame_id) || (5 == frame_id)))
+            ++ failed;
+    mp.merge(mid, 6, &even[0], even.size());
+    mp.merge(mid, 6, &odd[0], odd.size());
+    bool after = mp.readFrame(mid, &buf[0], buf.size(), size, frame_id, complete) && (6 == frame_id) && complete;
+
+    mp.release(mid);
+
+    // a released or unknown session is refused
+    bool refused = false;
+    try {
+        mp.merge(mid, 7, &even[0], even.size());
+    } catch (CUDTException& e) {
+        refused = (CUDTException::EINVMPATH == e.getErrorCode());
+    }
+
+    cout << "Abandoned: " << (abandoned ? "yes" : "no") << ", malformed given up: " << malformed
+         << ", given up on failure: " << failed << ", merged after: " << (after ? "yes" : "no") << endl;
+
+    bool passed = abandoned && (2 == malformed) && (2 == failed) && after && refused;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_completion_order() {
+    cout << "\n[TEST 3] Frames Are Returned As They Complete\n";
+    cout << "==============================================\n";
+
+    CMultipath mp;
+    int mid = mp.create(1);
+
+    vector<char> frame(800);
+    fill_frame(frame, 3);
+    vector<char> even = make_slice(frame, every_other(frame.size(), 0));
+    vector<char> odd = make_slice(frame, every_other(frame.size(), 1));
+
+    // frame 10 waits on a slow sub-flow, frame 11 is complete first
+    mp.merge(mid, 10, &even[0], even.size());
+    mp.merge(mid, 11, &even[0], even.size());
+    mp.merge(mid, 11, &odd[0], odd.size());
+    mp.merge(mid, 10, &odd[0], odd.size());
+
+    vector<char> buf(1000);
+    int size;
+    uint16_t first = 0, second = 0;
+    bool complete1 = false, complete2 = false;
+    mp.readFrame(mid, &buf[0], buf.size(), size, first, complete1);
+    mp.readFrame(mid, &buf[0], buf.size(), size, second, complete2);
+
+    // too many frames merging at once: the oldest is given up for the newest
+    for (int f = 0; f <= CMultipath::m_iMaxMerging; ++f)
+        mp.merge(mid, 20 + f, &even[0], even.size());
+    uint16_t frame_id = 0;
+    bool complete = true;
+    bool bounded = mp.readFrame(mid, &buf[0], buf.size(), size, frame_id, complete) && (20 == frame_id) && !complete;
+
+    mp.release(mid);
+
+    cout << "Order of completion: " << first << ", " << second << "; oldest of " << CMultipath::m_iMaxMerging + 1
+         << " merging given up: " << (bounded ? "yes" : "no") << endl;
+
+    bool passed = (11 == first) && (10 == second) && complete1 && complete2 && bounded;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+struct Flow {
+    UDTSOCKET serv;
+    UDTSOCKET accepted;
+};
+
+static void* accept_one(void* param) {
+    Flow* f = (Flow*)param;
+    f->accepted = UDT::accept(f->serv, NULL, NULL);
+    return NULL;
+}
+
+// one sub-flow: a SOCK_DGRAM connection over loopback, between its own pair of ports
+static bool connect_flow(UDTSOCKET& snd, UDTSOCKET& rcv, UDTSOCKET& serv) {
+    Flow f;
+    f.serv = serv = UDT::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    UDT::bind(serv, (sockaddr*)&addr, sizeof(addr));
+    int namelen = sizeof(addr);
+    UDT::getsockname(serv, (sockaddr*)&addr, &namelen);
+    UDT::listen(serv, 1);
+
+    pthread_t t;
+    pthread_create(&t, NULL, accept_one, &f);
+    snd = UDT::socket(AF_INET, SOCK_DGRAM, 0);
+    int res = UDT::connect(snd, (sockaddr*)&addr, sizeof(addr));
+    pthread_join(t, NULL);
+
+    rcv = f.accepted;
+    return (UDT::ERROR != res) && (UDT::INVALID_SOCK != rcv);
+}
+
+bool test_two_subflows() {
+    cout << "\n[TEST 4] A Frame Stream Over Two Sub-Flows\n";
+    cout << "===========================================\n";
+
+    UDT::startup();
+
+    UDTSOCKET snd[2], rcv[2], serv[2];
+    bool connected = connect_flow(snd[0], rcv[0], serv[0]) && connect_flow(snd[1], rcv[1], serv[1]);
+
+    int smid = UDT::mpath_create();
+    int rmid = UDT::mpath_create();
+    for (int i = 0; i < 2; ++i) {
+        UDT::mpath_add(smid, snd[i]);
+        UDT::mpath_add(rmid, rcv[i]);
+    }
+
+    // a stream socket is no sub-flow
+    UDTSOCKET stream = UDT::socket(AF_INET, SOCK_STREAM, 0);
+    bool refused = (UDT::ERROR == UDT::mpath_add(smid, stream));
+    UDT::close(stream);
+
+    const int frames = 20;
+    vector<char> frame(60000), buf(70000);
+    int sent = 0;
+    for (int f = 0; f < frames; ++f) {
+        fill_frame(frame, f);
+        if (UDT::mpath_sendframe(smid, &frame[0], frame.size(), f, 0) > 0)
+            ++ sent;
+    }
+
+    set<int> seen;
+    int whole = 0;
+    for (int f = 0; f < frames; ++f) {
+        uint16_t frame_id = 0;
+        bool complete = false;
+        int res = UDT::mpath_recvframe(rmid, &buf[0], buf.size(), frame_id, complete);
+        fill_frame(frame, frame_id);
+        if ((60000 == res) && complete && seen.insert(frame_id).second && (0 == memcmp(&buf[0], &frame[0], res)))
+            ++ whole;
+    }
+
+    UDT::TRACEINFO perf[2];
+    UDT::perfmon(snd[0], &perf[0], false);
+    UDT::perfmon(snd[1], &perf[1], false);
+
+    // one sub-flow goes away, the session carries on over the other
+    UDT::close(snd[1]);
+    int later = 0;
+    for (int f = frames; f < frames + 5; ++f) {
+        fill_frame(frame, f);
+        if (UDT::mpath_sendframe(smid, &frame[0], frame.size(), f, 0) > 0)
+            ++ later;
+    }
+    int recovered = 0;
+    for (int f = 0; f < 10; ++f) {
+        uint16_t frame_id = 0;
+        bool complete = false;
+        int res = UDT::mpath_recvframe(rmid, &buf[0], buf.size(), frame_id, complete);
+        if (res < 0)
+            break;
+        fill_frame(frame, frame_id);
+        if ((frame_id >= frames) && (60000 == res) && complete && (0 == memcmp(&buf[0], &frame[0], res)))
+            ++ recovered;
+        if (recovered == later)
+            break;
+    }
+
+    UDT::mpath_release(smid);
+    UDT::mpath_release(rmid);
+    for (int i = 0; i < 2; ++i) {
+        UDT::close(snd[i]);
+        UDT::close(rcv[i]);
+        UDT::close(serv[i]);
+    }
+    UDT::cleanup();
+
+    cout << "Frames sent: " << sent << ", received whole: " << whole << " (packets per sub-flow " << perf[0].pktSentTotal
+         << " and " << perf[1].pktSentTotal << "); with one sub-flow left: sent " << later << ", received " << recovered << endl;
+
+    bool passed = connected && refused && (frames == sent) && (frames == whole) && (later > 0) && (later == recovered);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 4 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 4 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Multipath Session Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 4;
+
+    if (test_merge_slices()) passed++;
+    if (test_give_up()) passed++;
+    if (test_completion_order()) passed++;
+    if (test_two_subflows()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,275 @@
+/*
+ * Test program for send pacing
+ * This program tests that CTimer::sleepto wakes up close to its deadline, that UDT_PACINGSLACK is checked and
+ * kept, and that a connection paced at a fixed period sends at that rate and reports its pacing error
+ */
+
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <arpa/inet.h>
+#include "../src/udt.h"
+#include "../src/ccc.h"
+#include "../src/common.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+static const double PERIOD = 50.0;          // microseconds per packet of the paced connection
+static const int PACKETS = 10000;
+
+// sends one packet every PERIOD microseconds whatever happens
+class CFixedRateCC: public CCC
+{
+public:
+   void init()
+   {
+      m_dPktSndPeriod = PERIOD;
+      m_dCWndSize = 100000.0;
+   }
+};
+
+struct Pair {
+    UDTSOCKET serv;
+    UDTSOCKET server;
+    UDTSOCKET client;
+};
+
+static void* accept_one(void* param) {
+    Pair* p = (Pair*)param;
+    p->server = UDT::accept(p->serv, NULL, NULL);
+    return NULL;
+}
+
+// connect two SOCK_STREAM sockets over loopback; the sending one is paced by CFixedRateCC
+static bool connect_pair(Pair& p) {
+    p.serv = UDT::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    UDT::bind(p.serv, (sockaddr*)&addr, sizeof(addr));
+    int namelen = sizeof(addr);
+    UDT::getsockname(p.serv, (sockaddr*)&addr, &namelen);
+    UDT::listen(p.serv, 1);
+
+    pthread_t t;
+    pthread_create(&t, NULL, accept_one, &p);
+
+    p.client = UDT::socket(AF_INET, SOCK_STREAM, 0);
+    UDT::setsockopt(p.client, 0, UDT_CC, new CCCFactory<CFixedRateCC>, sizeof(CCCFactory<CFixedRateCC>));
+    int res = UDT::connect(p.client, (sockaddr*)&addr, sizeof(addr));
+
+    pthread_join(t, NULL);
+    return (UDT::ERROR != res) && (UDT::INVALID_SOCK != p.server);
+}
+
+static void close_pair(Pair& p) {
+    UDT::close(p.client);
+    UDT::close(p.server);
+    UDT::close(p.serv);
+}
+
+struct Sender {
+    UDTSOCKET sock;
+    int size;
+};
+
+static void* send_data(void* param) {
+    Sender* s = (Sender*)param;
+    vector<char> data(s->size, 'p');
+    int sent = 0;
+    while (sent < s->size) {
+        int res = UDT::send(s->sock, &data[sent], s->size - sent, 0);
+        if (res <= 0)
+            break;
+        sent += res;
+    }
+    return NULL;
+}
+
+bool test_sleepto() {
+    cout << "\n[TEST 1] sleepto Wakes Up Close To Its Deadline\n";
+    cout << "===============================================\n";
+
+    CTimer timer;
+    const uint64_t freq = CTimer::getCPUFrequency();
+    const int rounds = 200;
+    uint64_t total = 0, worst = 0;
+    int early = 0;
+
+    for (int i = 0; i < rounds; ++i) {
+        uint64_t now, woke;
+        CTimer::rdtsc(now);
+        // alternate short waits, which only spin, and longer ones, which block first
+        uint64_t deadline = now + ((i % 2) ? 50 : 2000) * freq;
+        timer.sleepto(deadline);
+        CTimer::rdtsc(woke);
+
+        if (woke < deadline) {
+            ++ early;
+            continue;
+        }
+        total += woke - deadline;
+        if (woke - deadline > worst)
+            worst = woke - deadline;
+    }
+
+    double avg = total / double(rounds) / freq;
+    cout << "Average lateness: " << avg << " us, worst " << worst / double(freq) << " us, early wake-ups: " << early << endl;
+
+    bool passed = (0 == early) && (avg < 100);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_slack_option() {
+    cout << "\n[TEST 2] UDT_PACINGSLACK Is Checked And Kept\n";
+    cout << "============================================\n";
+
+    UDT::startup();
+
+    UDTSOCKET u = UDT::socket(AF_INET, SOCK_STREAM, 0);
+    int slack = -1, len = sizeof(int);
+    UDT::getsockopt(u, 0, UDT_PACINGSLACK, &slack, &len);
+    int def = slack;
+
+    int negative = -5;
+    int rejected = UDT::setsockopt(u, 0, UDT_PACINGSLACK, &negative, sizeof(int));
+
+    int value = 100;
+    int accepted = UDT::setsockopt(u, 0, UDT_PACINGSLACK, &value, sizeof(int));
+    UDT::getsockopt(u, 0, UDT_PACINGSLACK, &slack, &len);
+    int kept = slack;
+
+    // the multiplexer exists once the socket is bound, and its slack is fixed
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    UDT::bind(u, (sockaddr*)&addr, sizeof(addr));
+    int late = UDT::setsockopt(u, 0, UDT_PACINGSLACK, &value, sizeof(int));
+
+    UDT::close(u);
+    UDT::cleanup();
+
+    cout << "Default: " << def << " us; negative: " << rejected << "; 100 us: " << accepted << ", read back " << kept
+         << "; after bind: " << late << endl;
+
+    bool passed = (20 == def) && (UDT::ERROR == rejected) && (0 == accepted) && (100 == kept) && (UDT::ERROR == late);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_paced_rate() {
+    cout << "\n[TEST 3] A Paced Connection Keeps Its Rate And Reports Its Error\n";
+    cout << "================================================================\n";
+
+    UDT::startup();
+
+    Pair p;
+    bool connected = connect_pair(p);
+
+    int mss = 0, len = sizeof(int);
+    UDT::getsockopt(p.client, 0, UDT_MSS, &mss, &len);
+    int payload = mss - 28 - 16;
+    Sender s = {p.client, 0};
+    s.size = payload * PACKETS;
+
+    UDT::TRACEINFO perf;
+    UDT::perfmon(p.client, &perf, true);
+
+    timeval start, end;
+    gettimeofday(&start, NULL);
+    pthread_t t;
+    pthread_create(&t, NULL, send_data, &s);
+
+    // sample the counters while the sender is updating them
+    vector<char> buf(s.size);
+    int received = 0, samples = 0;
+    double maxerror = 0;
+    while (received < s.size) {
+        int res = UDT::recv(p.server, &buf[received], s.size - received, 0);
+        if (res <= 0)
+            break;
+        received += res;
+
+        UDT::TRACEINFO part;
+        if ((0 == (++ samples % 16)) && (UDT::ERROR != UDT::perfmon(p.client, &part, false)) &&
+            (part.usPacingErrorMax > maxerror))
+            maxerror = part.usPacingErrorMax;
+    }
+    gettimeofday(&end, NULL);
+    pthread_join(t, NULL);
+
+    UDT::perfmon(p.client, &perf, true);
+    close_pair(p);
+    UDT::cleanup();
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+    double period = seconds * 1000000.0 / PACKETS;
+
+    cout << "Received " << received << "/" << s.size << " bytes in " << seconds << " s: " << period << " us per packet (paced at "
+         << PERIOD << "); packets sent " << perf.pktSent << ", pacing error " << perf.usPacingError << " us, max "
+         << perf.usPacingErrorMax << " us" << endl;
+
+    bool passed = connected && (s.size == received) && (period > PERIOD * 0.9) && (period < PERIOD * 1.4) &&
+                  (perf.pktSent >= PACKETS) && (perf.usPacingError > 0) && (perf.usPacingError < PERIOD) &&
+                  (perf.usPacingErrorMax >= perf.usPacingError) && (maxerror > 0);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Send Pacing Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 3;
+
+    if (test_sleepto()) passed++;
+    if (test_slack_option()) passed++;
+    if (test_paced_rate()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,213 @@
+/*
+ * Test program for the shared path information cache
+ * This program tests that the cache file is private to its user, that records out of the range a connection
+ * can measure are not used, and that CUDTCC resumes a cached path only at a rate it can trust
+ */
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+#include "../src/udt.h"
+#include "../src/cache.h"
+#include "../src/ccc.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+static void temp_path(char* path) {
+    strcpy(path, "/tmp/udt_cache_XXXXXX");
+    close(mkstemp(path));
+    unlink(path);
+}
+
+// a record of a measured path to 10.0.0.<host>
+static void make_block(CInfoBlock& ib, int host) {
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(0x0A000000 | host);
+    ib.m_iIPversion = AF_INET;
+    CInfoBlock::convert((sockaddr*)&addr, AF_INET, ib.m_piIP);
+    ib.m_iRTT = 20000;
+    ib.m_iBandwidth = 50000;
+    ib.m_iLossRate = 0;
+    ib.m_iReorderDistance = 0;
+    ib.m_dInterval = 40.0;
+    ib.m_dCWnd = 600.0;
+}
+
+// CUDTCC with the path state UDT would feed it made settable
+class CTestUDTCC: public CUDTCC
+{
+public:
+    double resume(double pathperiod, int bandwidth) {
+        m_iRTT = 20000;
+        m_iBandwidth = bandwidth;
+        m_dMaxCWndSize = 25600;
+        m_dPathSndPeriod = pathperiod;
+        init();
+        return m_dPktSndPeriod;
+    }
+};
+
+bool test_file_mode() {
+    cout << "\n[TEST 1] The Cache File Is Private To Its User\n";
+    cout << "==============================================\n";
+
+    char path[64];
+    temp_path(path);
+
+    // a permissive umask must not open the file up
+    mode_t mask = umask(0);
+    CSharedInfoCache cache;
+    int res = cache.open(path, 3600);
+    umask(mask);
+
+    struct stat st;
+    bool found = (0 == stat(path, &st));
+    int mode = found ? int(st.st_mode & 0777) : -1;
+
+    // a file others may write is refused
+    chmod(path, 0666);
+    CSharedInfoCache other;
+    int shared = other.open(path, 3600);
+    unlink(path);
+
+    cout << "Open: " << res << ", mode " << oct << mode << dec << "; with mode 0666: " << shared << endl;
+
+    bool passed = (0 == res) && (0600 == mode) && (-1 == shared);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_out_of_range_records() {
+    cout << "\n[TEST 2] Records Out Of Range Are Not Used\n";
+    cout << "==========================================\n";
+
+    char path[64];
+    temp_path(path);
+
+    CSharedInfoCache writer, reader;
+    bool opened = (0 == writer.open(path, 3600)) && (0 == reader.open(path, 3600));
+
+    CInfoBlock good;
+    make_block(good, 1);
+    writer.update(&good);
+
+    CInfoBlock found;
+    make_block(found, 1);
+    found.m_iRTT = 0;
+    found.m_dInterval = 0;
+    bool kept = (0 == reader.lookup(&found)) && (found.m_iRTT == good.m_iRTT) && (found.m_dInterval == good.m_dInterval);
+
+    // each record is written by another process with one field broken
+    const int cases = 7;
+    int used = 0;
+    for (int i = 0; i < cases; ++i) {
+        CInfoBlock bad;
+        make_block(bad, 10 + i);
+        switch (i) {
+            case 0: bad.m_iRTT = -1; break;
+            case 1: bad.m_iRTT = 1000000000; break;
+            case 2: bad.m_iBandwidth = 0; break;
+            case 3: bad.m_dInterval = -5.0; break;
+            case 4: bad.m_dInterval = numeric_limits<double>::quiet_NaN(); break;
+            case 5: bad.m_dInterval = 1e300; break;
+            case 6: bad.m_dCWnd = -1.0; break;
+        }
+        writer.update(&bad);
+
+        CInfoBlock probe;
+        make_block(probe, 10 + i);
+        if (0 == reader.lookup(&probe))
+            ++ used;
+    }
+    unlink(path);
+
+    cout << "Valid record read back: " << (kept ? "yes" : "no") << ", broken records used: " << used << "/" << cases << endl;
+
+    bool passed = opened && kept && (0 == used);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_resume_rate() {
+    cout << "\n[TEST 3] Congestion Control Resumes Only A Rate It Can Trust\n";
+    cout << "============================================================\n";
+
+    CTestUDTCC cc;
+
+    // half the rate the path carried
+    double resumed = cc.resume(10.0, 1000000);
+    // never faster than the bandwidth estimate
+    double capped = cc.resume(10.0, 1000);
+    // no path, or a period no path has: slow start at the initial period
+    double unknown = cc.resume(0, 1000000);
+    double nan = cc.resume(numeric_limits<double>::quiet_NaN(), 1000000);
+    double slow = cc.resume(1e300, 1000000);
+    double negative = cc.resume(-10.0, 1000000);
+
+    cout << "Period resumed: " << resumed << ", capped " << capped << ", unknown " << unknown << ", NaN " << nan
+         << ", huge " << slow << ", negative " << negative << endl;
+
+    bool passed = (20.0 == resumed) && (1000.0 == capped) && (1.0 == unknown) && (1.0 == nan) && (1.0 == slow) &&
+                  (1.0 == negative);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Path Information Cache Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 3;
+
+    if (test_file_mode()) passed++;
+    if (test_out_of_range_records()) passed++;
+    if (test_resume_rate()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
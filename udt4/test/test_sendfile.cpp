@@ -0,0 +1,299 @@
+/*
+ * Test program for sending files by path
+ * This program tests UDT::sendfile2 on a file that cannot be opened, on offsets at and past the end of
+ * the file, and on a size reaching past the end, which sends what the file holds and says how much; and that
+ * the send buffer reads, rather than maps, a block the file no longer holds
+ */
+
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include "../src/udt.h"
+#include "../src/buffer.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+static const int FILE_SIZE = 100000;
+
+struct Pair {
+    UDTSOCKET serv;
+    UDTSOCKET server;
+    UDTSOCKET client;
+};
+
+static void* accept_one(void* param) {
+    Pair* p = (Pair*)param;
+    p->server = UDT::accept(p->serv, NULL, NULL);
+    return NULL;
+}
+
+// connect two SOCK_STREAM sockets over loopback
+static bool connect_pair(Pair& p) {
+    p.serv = UDT::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    UDT::bind(p.serv, (sockaddr*)&addr, sizeof(addr));
+    int namelen = sizeof(addr);
+    UDT::getsockname(p.serv, (sockaddr*)&addr, &namelen);
+    UDT::listen(p.serv, 1);
+
+    pthread_t t;
+    pthread_create(&t, NULL, accept_one, &p);
+
+    p.client = UDT::socket(AF_INET, SOCK_STREAM, 0);
+    int res = UDT::connect(p.client, (sockaddr*)&addr, sizeof(addr));
+
+    pthread_join(t, NULL);
+    return (UDT::ERROR != res) && (UDT::INVALID_SOCK != p.server);
+}
+
+static void close_pair(Pair& p) {
+    UDT::close(p.client);
+    UDT::close(p.server);
+    UDT::close(p.serv);
+}
+
+// a temporary file of FILE_SIZE bytes with a pattern of its own
+static bool make_file(char* path, vector<char>& content) {
+    strcpy(path, "/tmp/udt_sendfile_XXXXXX");
+    int fd = mkstemp(path);
+    if (fd < 0)
+        return false;
+    content.resize(FILE_SIZE);
+    for (int i = 0; i < FILE_SIZE; ++i)
+        content[i] = (char)(i % 251);
+    bool ok = (FILE_SIZE == write(fd, &content[0], FILE_SIZE));
+    close(fd);
+    return ok;
+}
+
+static int recv_all(UDTSOCKET u, char* buf, int len) {
+    int received = 0;
+    while (received < len) {
+        int res = UDT::recv(u, buf + received, len - received, 0);
+        if (res <= 0)
+            break;
+        received += res;
+    }
+    return received;
+}
+
+bool test_unopened_file() {
+    cout << "\n[TEST 1] A File That Cannot Be Opened Is An Error\n";
+    cout << "==================================================\n";
+
+    UDT::startup();
+
+    Pair p;
+    bool connected = connect_pair(p);
+
+    int64_t offset = 0;
+    int64_t res = UDT::sendfile2(p.client, "/nonexistent/udt_sendfile", &offset, FILE_SIZE);
+    int code = UDT::getlasterror().getErrorCode();
+
+    // the socket is still good for data
+    bool usable = (4 == UDT::send(p.client, "next", 4, 0));
+    char buf[4];
+    usable = usable && (4 == recv_all(p.server, buf, 4)) && (0 == memcmp(buf, "next", 4));
+
+    close_pair(p);
+    UDT::cleanup();
+
+    cout << "Result: " << res << ", error " << code << ", offset " << offset << ", socket still usable: " << (usable ? "yes" : "no") << endl;
+
+    bool passed = connected && (UDT::ERROR == res) && (CUDTException::ERDPERM == code) && (0 == offset) && usable;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_offset_past_end() {
+    cout << "\n[TEST 2] Offsets At And Past The End Of The File\n";
+    cout << "=================================================\n";
+
+    UDT::startup();
+
+    char path[64];
+    vector<char> content;
+    bool made = make_file(path, content);
+
+    Pair p;
+    bool connected = connect_pair(p);
+
+    // at the end there is nothing to send
+    int64_t offset = FILE_SIZE;
+    int64_t atend = UDT::sendfile2(p.client, path, &offset, 1000);
+    bool unmoved = (FILE_SIZE == offset);
+
+    offset = FILE_SIZE + 1;
+    int64_t past = UDT::sendfile2(p.client, path, &offset, 1000);
+    int code = UDT::getlasterror().getErrorCode();
+    unmoved = unmoved && (FILE_SIZE + 1 == offset);
+
+    close_pair(p);
+    UDT::cleanup();
+    unlink(path);
+
+    cout << "At the end: " << atend << " bytes sent; past the end: " << past << ", error " << code << endl;
+
+    bool passed = made && connected && (0 == atend) && (UDT::ERROR == past) && (CUDTException::EINVRDOFF == code) && unmoved;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_size_past_end() {
+    cout << "\n[TEST 3] A Size Past The End Sends What The File Holds\n";
+    cout << "=======================================================\n";
+
+    UDT::startup();
+
+    char path[64];
+    vector<char> content;
+    bool made = make_file(path, content);
+
+    Pair p;
+    bool connected = connect_pair(p);
+
+    const int64_t start = 40000;
+    int64_t offset = start;
+    int64_t sent = UDT::sendfile2(p.client, path, &offset, FILE_SIZE);
+
+    vector<char> buf(FILE_SIZE);
+    int received = recv_all(p.server, &buf[0], FILE_SIZE - start);
+    bool intact = (0 == memcmp(&buf[0], &content[start], received));
+
+    // the whole file, received into another one
+    char copy[64];
+    strcpy(copy, "/tmp/udt_recvfile_XXXXXX");
+    close(mkstemp(copy));
+    int64_t soff = 0, roff = 0;
+    int64_t whole = UDT::sendfile2(p.client, path, &soff, FILE_SIZE);
+    int64_t written = UDT::recvfile2(p.server, copy, &roff, FILE_SIZE);
+    FILE* f = fopen(copy, "rb");
+    size_t copied = (NULL != f) ? fread(&buf[0], 1, FILE_SIZE, f) : 0;
+    if (NULL != f)
+        fclose(f);
+    bool same = (FILE_SIZE == copied) && (buf == content);
+
+    close_pair(p);
+    UDT::cleanup();
+    unlink(path);
+    unlink(copy);
+
+    cout << "Asked for " << FILE_SIZE << " bytes from offset " << start << ": sent " << sent << ", new offset " << offset
+         << ", received " << received << "; whole file sent " << whole << ", written " << written << endl;
+
+    bool passed = made && connected && (FILE_SIZE - start == sent) && (FILE_SIZE == offset) && (FILE_SIZE - start == received) &&
+                  intact && (FILE_SIZE == whole) && (FILE_SIZE == written) && (FILE_SIZE == roff) && same;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_truncated_file() {
+    cout << "\n[TEST 4] A Block The File No Longer Holds Is Not Mapped\n";
+    cout << "========================================================\n";
+
+    char path[64];
+    vector<char> content;
+    bool made = make_file(path, content);
+
+    // the file is cut short after the sender has learned its size
+    const int cut = 50000;
+    bool cutshort = (0 == truncate(path, cut));
+    int fd = open(path, O_RDONLY);
+
+    const int mss = 1456;
+    CSndBuffer buffer(32, mss);
+
+    // a mapping would fault on the first read past the end; the block is read, found short, and refused
+    int past = buffer.addBufferFromFile(fd, 40000, 20000);
+    int refused = buffer.getCurrBufSize();
+
+    // a block the file still holds is mapped and reads back intact
+    int held = buffer.addBufferFromFile(fd, 40000, cut - 40000);
+    int blocks = buffer.getCurrBufSize();
+    vector<char> data;
+    char* block;
+    int32_t msgno;
+    for (int len; (len = buffer.readData(&block, msgno)) > 0; )
+        data.insert(data.end(), block, block + len);
+    bool intact = (cut - 40000 == (int)data.size()) && (0 == memcmp(&data[0], &content[40000], data.size()));
+
+    buffer.ackData(blocks);
+    close(fd);
+    unlink(path);
+
+    cout << "Block past the end: " << past << ", blocks queued " << refused << "; block in the file: " << held
+         << ", blocks queued " << blocks << ", read back " << data.size() << " bytes" << endl;
+
+    bool passed = made && cutshort && (fd >= 0) && (-1 == past) && (0 == refused) && (cut - 40000 == held) &&
+                  ((cut - 40000 + mss - 1) / mss == blocks) && intact;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 4 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 4 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  File Sending Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 4;
+
+    if (test_unopened_file()) passed++;
+    if (test_offset_past_end()) passed++;
+    if (test_size_past_end()) passed++;
+    if (test_truncated_file()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,384 @@
+/*
+ * Test program for shared-memory connections
+ * This program tests the two rings of CShmLink in byte and record mode, the end of a link seen by the peer,
+ * and UDT_SHMEM end to end: stream data and frames that go through the rings instead of UDP,
+ * and the UDP path kept when only one side asks for shared memory
+ */
+
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include "../src/udt.h"
+#include "../src/common.h"
+#include "../src/shmem.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+static const int RING_SIZE = 1 << 20;
+
+// a segment of both rings, created by one side and attached by the other as during a handshake
+static bool open_link(CShmLink& a, CShmLink& b, int32_t id, bool msg) {
+    if ((a.create(id, getpid(), RING_SIZE, msg) < 0) || (b.attach(id, getpid(), msg) < 0))
+        return false;
+    a.unlink();
+    return true;
+}
+
+bool test_byte_ring() {
+    cout << "\n[TEST 1] Byte Ring Wraps Around In Order\n";
+    cout << "=========================================\n";
+
+    CShmLink a, b;
+    if (!open_link(a, b, 1001, false)) {
+        cout << RED << "✗ TEST 1 FAILED (no shared memory)" << RESET << endl;
+        return false;
+    }
+
+    // three rings' worth of bytes in odd-sized pieces, so that the positions wrap around mid-piece
+    const int total = 3 * RING_SIZE;
+    vector<char> out(65537), in(65537);
+    int sent = 0, rcvd = 0;
+    bool ordered = true;
+    bool filled = false;
+    while (rcvd < total) {
+        while (sent < total) {
+            int len = min((int)out.size(), total - sent);
+            for (int i = 0; i < len; ++i)
+                out[i] = (char)((sent + i) % 251);
+            int res = a.send(&out[0], len);
+            sent += res;
+            if (res < len) {
+                filled = filled || !a.canWrite(1);
+                break;
+            }
+        }
+
+        int res = b.recv(&in[0], 10007);
+        for (int i = 0; i < res; ++i)
+            ordered = ordered && (in[i] == (char)((rcvd + i) % 251));
+        rcvd += res;
+    }
+
+    bool empty = !b.canRead() && (0 == b.recv(&in[0], 1));
+
+    // the other direction is a ring of its own
+    bool reverse = (3 == b.send("abc", 3)) && a.canRead() && (3 == a.recv(&in[0], 10)) && (0 == memcmp(&in[0], "abc", 3));
+
+    cout << "Bytes through the ring: " << rcvd << ", in order: " << (ordered ? "yes" : "no") << ", ring filled up: "
+         << (filled ? "yes" : "no") << ", reverse ring: " << (reverse ? "yes" : "no") << endl;
+
+    bool passed = ordered && filled && empty && reverse && (rcvd == total);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_record_ring() {
+    cout << "\n[TEST 2] Records Keep Their Bounds, Frame ID And Deadline\n";
+    cout << "==========================================================\n";
+
+    CShmLink a, b;
+    if (!open_link(a, b, 1002, true)) {
+        cout << RED << "✗ TEST 2 FAILED (no shared memory)" << RESET << endl;
+        return false;
+    }
+
+    char buf[256];
+    memset(buf, 'M', sizeof(buf));
+    a.sendMsg(buf, 100, -1, 0);
+    memset(buf, 'F', sizeof(buf));
+    a.sendMsg(buf, 200, 17, 123456);
+    a.sendMsg(buf, 50, 18, 654321);
+
+    int32_t frame_id;
+    int64_t deadline;
+    char in[256];
+    int r1 = b.recvMsg(in, sizeof(in), frame_id, deadline);
+    bool msg = (100 == r1) && (-1 == frame_id) && (in[0] == 'M') && (in[99] == 'M');
+
+    // a buffer too small for the record takes what fits, the rest is discarded and the next record is intact
+    int r2 = b.recvMsg(in, 64, frame_id, deadline);
+    bool cut = (64 == r2) && (17 == frame_id) && (123456 == deadline) && (in[63] == 'F');
+    int r3 = b.recvMsg(in, sizeof(in), frame_id, deadline);
+    bool next = (50 == r3) && (18 == frame_id) && (654321 == deadline);
+    bool empty = (0 == b.recvMsg(in, sizeof(in), frame_id, deadline));
+
+    // a record is written whole or not at all
+    vector<char> big(a.getMaxMsgSize());
+    int written = 0;
+    while (a.sendMsg(&big[0], big.size(), 1, 0) > 0)
+        ++ written;
+    bool whole = (written > 0) && !a.canWrite(big.size()) && (0 == a.sendMsg(&big[0], big.size(), 1, 0));
+
+    cout << "Message: " << r1 << " bytes, cut frame: " << r2 << " bytes, next frame: " << r3 << " bytes, "
+         << written << " records of " << big.size() << " bytes before the ring is full" << endl;
+
+    bool passed = msg && cut && next && empty && whole;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_peer_close() {
+    cout << "\n[TEST 3] Data Left In The Ring Outlives The Writer\n";
+    cout << "===================================================\n";
+
+    CShmLink a, b;
+    if (!open_link(a, b, 1003, false)) {
+        cout << RED << "✗ TEST 3 FAILED (no shared memory)" << RESET << endl;
+        return false;
+    }
+
+    a.send("tail", 4);
+    bool open = !b.isPeerClosed();
+    a.close();
+
+    // the reader is not kept waiting once the writer is gone
+    uint64_t start = CTimer::getTime();
+    b.waitRead(1000000);
+    char in[8];
+    bool data = b.canRead() && (4 == b.recv(in, sizeof(in))) && (0 == memcmp(in, "tail", 4));
+    b.waitRead(1000000);
+    bool quick = (CTimer::getTime() - start < 500000);
+    bool closed = b.isPeerClosed() && !b.canRead();
+
+    cout << "Open before close: " << (open ? "yes" : "no") << ", data read after close: " << (data ? "yes" : "no")
+         << ", peer closed: " << (closed ? "yes" : "no") << endl;
+
+    bool passed = open && data && quick && closed;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+struct Pair {
+    int type;
+    bool srvshm;
+    bool clishm;
+    UDTSOCKET serv;
+    UDTSOCKET server;
+    UDTSOCKET client;
+};
+
+static void* accept_one(void* param) {
+    Pair* p = (Pair*)param;
+    p->server = UDT::accept(p->serv, NULL, NULL);
+    return NULL;
+}
+
+// connect two sockets over loopback, each asking for shared memory or not
+static bool connect_pair(Pair& p) {
+    p.serv = UDT::socket(AF_INET, p.type, 0);
+    UDT::setsockopt(p.serv, 0, UDT_SHMEM, &p.srvshm, sizeof(bool));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    UDT::bind(p.serv, (sockaddr*)&addr, sizeof(addr));
+    int namelen = sizeof(addr);
+    UDT::getsockname(p.serv, (sockaddr*)&addr, &namelen);
+    UDT::listen(p.serv, 1);
+
+    pthread_t t;
+    pthread_create(&t, NULL, accept_one, &p);
+
+    p.client = UDT::socket(AF_INET, p.type, 0);
+    UDT::setsockopt(p.client, 0, UDT_SHMEM, &p.clishm, sizeof(bool));
+    int res = UDT::connect(p.client, (sockaddr*)&addr, sizeof(addr));
+
+    pthread_join(t, NULL);
+    return (UDT::ERROR != res) && (UDT::INVALID_SOCK != p.server);
+}
+
+static void close_pair(Pair& p) {
+    UDT::close(p.client);
+    UDT::close(p.server);
+    UDT::close(p.serv);
+}
+
+struct Stream {
+    UDTSOCKET u;
+    int size;
+    bool ordered;
+};
+
+static void* recv_stream(void* param) {
+    Stream* s = (Stream*)param;
+    vector<char> buf(100000);
+    int rcvd = 0;
+    s->ordered = true;
+    while (rcvd < s->size) {
+        int res = UDT::recv(s->u, &buf[0], buf.size(), 0);
+        if (res <= 0)
+            break;
+        for (int i = 0; i < res; ++i)
+            s->ordered = s->ordered && (buf[i] == (char)((rcvd + i) % 251));
+        rcvd += res;
+    }
+    s->size = rcvd;
+    return NULL;
+}
+
+// send size bytes of a known pattern over a connected stream pair and read them back on another thread
+static bool transfer(Pair& p, int size, int& rcvd) {
+    Stream s;
+    s.u = p.server;
+    s.size = size;
+    pthread_t t;
+    pthread_create(&t, NULL, recv_stream, &s);
+
+    vector<char> buf(size);
+    for (int i = 0; i < size; ++i)
+        buf[i] = (char)(i % 251);
+    int sent = 0;
+    while (sent < size) {
+        int res = UDT::send(p.client, &buf[sent], size - sent, 0);
+        if (res <= 0)
+            break;
+        sent += res;
+    }
+
+    pthread_join(t, NULL);
+    rcvd = s.size;
+    return s.ordered && (rcvd == size);
+}
+
+bool test_stream_over_shmem() {
+    cout << "\n[TEST 4] Stream Data Bypasses UDP With UDT_SHMEM On Both Sides\n";
+    cout << "================================================================\n";
+
+    UDT::startup();
+
+    const int size = 4000000;
+
+    // both sides: the data takes the rings, no data packet is sent
+    Pair both = {SOCK_STREAM, true, true};
+    int rcvd = 0;
+    bool ok = connect_pair(both) && transfer(both, size, rcvd);
+    UDT::TRACEINFO perf;
+    UDT::perfmon(both.client, &perf, false);
+    int64_t shmpkts = perf.pktSentTotal;
+    close_pair(both);
+
+    // one side only: the connection falls back to UDP
+    Pair one = {SOCK_STREAM, false, true};
+    int rcvd2 = 0;
+    bool ok2 = connect_pair(one) && transfer(one, size / 10, rcvd2);
+    UDT::perfmon(one.client, &perf, false);
+    int64_t udppkts = perf.pktSentTotal;
+    close_pair(one);
+
+    UDT::cleanup();
+
+    cout << "Shared memory: " << rcvd << " bytes, " << shmpkts << " data packets; one side only: " << rcvd2
+         << " bytes, " << udppkts << " data packets" << endl;
+
+    bool passed = ok && ok2 && (0 == shmpkts) && (udppkts >= (size / 10) / 1500);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 4 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 4 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_frames_over_shmem() {
+    cout << "\n[TEST 5] Frames And Messages Over Shared Memory\n";
+    cout << "================================================\n";
+
+    UDT::startup();
+
+    Pair p = {SOCK_DGRAM, true, true};
+    bool connected = connect_pair(p);
+
+    // a frame, then a message, in order and with their bounds
+    vector<char> frame(50000, 'V');
+    UDT::TRACEINFO perf;
+    UDT::perfmon(p.client, &perf, false);
+    int fsent = UDT::sendframe(p.client, &frame[0], frame.size(), 42, (perf.msTimeStamp + 1000) * 1000);
+    int msent = UDT::sendmsg(p.client, "hello", 5);
+
+    vector<char> buf(60000);
+    uint16_t frame_id = 0;
+    bool complete = false;
+    int frcvd = UDT::recvframe(p.server, &buf[0], buf.size(), frame_id, complete);
+    bool gotframe = (50000 == frcvd) && (42 == frame_id) && complete && (buf[0] == 'V') && (buf[49999] == 'V');
+    int mrcvd = UDT::recvmsg(p.server, &buf[0], buf.size());
+    bool gotmsg = (5 == mrcvd) && (0 == memcmp(&buf[0], "hello", 5));
+
+    UDT::perfmon(p.client, &perf, false);
+    bool bypassed = (0 == perf.pktSentTotal);
+
+    close_pair(p);
+    UDT::cleanup();
+
+    cout << "Frame: sent " << fsent << ", received " << frcvd << " (ID " << frame_id << ", complete "
+         << (complete ? "yes" : "no") << "); message: sent " << msent << ", received " << mrcvd
+         << "; data packets " << perf.pktSentTotal << endl;
+
+    bool passed = connected && gotframe && gotmsg && bypassed;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 5 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 5 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Shared Memory Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 5;
+
+    if (test_byte_ring()) passed++;
+    if (test_record_ring()) passed++;
+    if (test_peer_close()) passed++;
+    if (test_stream_over_shmem()) passed++;
+    if (test_frames_over_shmem()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
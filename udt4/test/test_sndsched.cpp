@@ -0,0 +1,319 @@
+/*
+ * Test program for the retransmission scheduling policy
+ * This program tests the values UDT_SNDSCHED takes, and, through a relay that loses one packet of a frame that
+ * has missed its deadline, that the loss is resent at once with UDT_SCHED_LOSSFIRST and only after the new data
+ * of later frames with UDT_SCHED_DEADLINE
+ */
+
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <set>
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include "../src/udt.h"
+#include "../src/ccc.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+static const int FRAMES = 40;
+static const int CHUNKS = 10;               // packets per frame
+static const int LOST = 2;                  // the packet of the first frame that the relay loses
+
+// one packet every 100 us, with no window limit, so that the order of the packets depends on the policy only
+class CFixedRateCC: public CCC
+{
+public:
+   void init()
+   {
+      m_dPktSndPeriod = 100.0;
+      m_dCWndSize = 100000.0;
+   }
+};
+
+// a UDP relay between a client and a server that loses the first transmission of one data packet
+struct Relay {
+    int front;              // socket the client connects to
+    int back;               // socket the server sees the client at
+    sockaddr_in entry;      // address of the front socket
+    sockaddr_in server;
+    sockaddr_in client;
+    bool known;             // if the client has been heard from
+    volatile bool stop;
+    bool data;              // if a data packet has been seen
+    int32_t first;          // sequence number of the first data packet
+    bool dropped;
+    vector<int32_t> seen;   // sequence numbers of the data packets forwarded, in order
+};
+
+static int bind_loopback(sockaddr_in& addr) {
+    int s = ::socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(s, (sockaddr*)&addr, sizeof(addr));
+    socklen_t namelen = sizeof(addr);
+    getsockname(s, (sockaddr*)&addr, &namelen);
+    return s;
+}
+
+static void* relay_loop(void* param) {
+    Relay* r = (Relay*)param;
+    char buf[65536];
+    pollfd fds[2] = {{r->front, POLLIN, 0}, {r->back, POLLIN, 0}};
+    while (!r->stop) {
+        if (poll(fds, 2, 100) <= 0)
+            continue;
+
+        if (fds[0].revents & POLLIN) {
+            sockaddr_in from;
+            socklen_t fromlen = sizeof(from);
+            int len = recvfrom(r->front, buf, sizeof(buf), 0, (sockaddr*)&from, &fromlen);
+            r->client = from;
+            r->known = true;
+
+            uint32_t word = ntohl(*(uint32_t*)buf);
+            bool forward = (len > 0);
+            if ((len >= 16) && (0 == (word & 0x80000000))) {
+                int32_t seq = (int32_t)word;
+                if (!r->data) {
+                    r->data = true;
+                    r->first = seq;
+                }
+                if (!r->dropped && (LOST == ((seq - r->first) & 0x7FFFFFFF))) {
+                    r->dropped = true;
+                    forward = false;
+                } else {
+                    r->seen.push_back(seq);
+                }
+            }
+            if (forward)
+                sendto(r->back, buf, len, 0, (sockaddr*)&r->server, sizeof(r->server));
+        }
+
+        if (fds[1].revents & POLLIN) {
+            int len = recv(r->back, buf, sizeof(buf), 0);
+            if ((len > 0) && r->known)
+                sendto(r->front, buf, len, 0, (sockaddr*)&r->client, sizeof(r->client));
+        }
+    }
+    return NULL;
+}
+
+struct Pair {
+    UDTSOCKET serv;
+    UDTSOCKET server;
+    UDTSOCKET client;
+};
+
+static void* accept_one(void* param) {
+    Pair* p = (Pair*)param;
+    p->server = UDT::accept(p->serv, NULL, NULL);
+    return NULL;
+}
+
+// connect two SOCK_DGRAM sockets over loopback through the relay; the sending one uses the given policy
+static bool connect_pair(Pair& p, Relay& relay, int sched) {
+    p.serv = UDT::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    UDT::bind(p.serv, (sockaddr*)&addr, sizeof(addr));
+    int namelen = sizeof(addr);
+    UDT::getsockname(p.serv, (sockaddr*)&addr, &namelen);
+    UDT::listen(p.serv, 1);
+    relay.server = addr;
+
+    pthread_t t;
+    pthread_create(&t, NULL, accept_one, &p);
+
+    p.client = UDT::socket(AF_INET, SOCK_DGRAM, 0);
+    UDT::setsockopt(p.client, 0, UDT_CC, new CCCFactory<CFixedRateCC>, sizeof(CCCFactory<CFixedRateCC>));
+    UDT::setsockopt(p.client, 0, UDT_SNDSCHED, &sched, sizeof(int));
+    int res = UDT::connect(p.client, (sockaddr*)&relay.entry, sizeof(relay.entry));
+
+    pthread_join(t, NULL);
+    return (UDT::ERROR != res) && (UDT::INVALID_SOCK != p.server);
+}
+
+// send a late frame followed by frames due much later, and return how many new packets the relay forwarded
+// between the loss and its retransmission, -1 if it was not resent
+static int run(int sched, int& fresh) {
+    UDT::startup();
+
+    Relay r;
+    r.known = r.stop = r.data = r.dropped = false;
+    r.first = 0;
+    sockaddr_in addr;
+    r.front = bind_loopback(r.entry);
+    r.back = bind_loopback(addr);
+    pthread_t relay;
+    pthread_create(&relay, NULL, relay_loop, &r);
+
+    Pair p;
+    int gap = -1;
+    fresh = 0;
+    if (connect_pair(p, r, sched)) {
+        int mss = 0, len = sizeof(int);
+        UDT::getsockopt(p.client, 0, UDT_MSS, &mss, &len);
+        vector<char> frame((mss - 28 - 20) * CHUNKS, 'f');
+
+        // the receiving thread takes up a new connection when it next wakes up; a report that reaches it before
+        // finds no socket and is lost
+        usleep(100000);
+
+        // the first frame is due right after the connection starts, the others in a minute
+        UDT::sendframe(p.client, &frame[0], frame.size(), 0, 1);
+        for (int f = 1; f < FRAMES; ++f)
+            UDT::sendframe(p.client, &frame[0], frame.size(), f, 60000000);
+
+        // everything goes out in 40 ms; wait until the loss has been resent too
+        UDT::TRACEINFO perf;
+        for (int i = 0; i < 100; ++i) {
+            usleep(20000);
+            if ((UDT::ERROR != UDT::perfmon(p.client, &perf, false)) && (perf.pktSentTotal >= FRAMES * CHUNKS) &&
+                (perf.pktRetransTotal > 0))
+                break;
+        }
+    }
+
+    // the relay carries the last ACKs the closing sender waits for
+    UDT::close(p.client);
+    UDT::close(p.server);
+    UDT::close(p.serv);
+    r.stop = true;
+    pthread_join(relay, NULL);
+    close(r.front);
+    close(r.back);
+    UDT::cleanup();
+
+    // the packets first sent after the lost one and before it was resent
+    set<int32_t> sent;
+    for (size_t i = 0; i < r.seen.size(); ++i) {
+        // offset from the first data packet, the sequence numbers wrap at 2^31
+        int32_t off = (r.seen[i] - r.first) & 0x7FFFFFFF;
+        if (LOST == off) {
+            gap = fresh;
+            break;
+        }
+        if ((off > LOST) && sent.insert(off).second)
+            ++ fresh;
+    }
+
+    return gap;
+}
+
+bool test_option() {
+    cout << "\n[TEST 1] UDT_SNDSCHED Takes The Two Policies Only\n";
+    cout << "=================================================\n";
+
+    UDT::startup();
+
+    UDTSOCKET u = UDT::socket(AF_INET, SOCK_DGRAM, 0);
+    int sched = -1, len = sizeof(int);
+    UDT::getsockopt(u, 0, UDT_SNDSCHED, &sched, &len);
+    int def = sched;
+
+    int deadline = UDT_SCHED_DEADLINE;
+    int accepted = UDT::setsockopt(u, 0, UDT_SNDSCHED, &deadline, sizeof(int));
+    UDT::getsockopt(u, 0, UDT_SNDSCHED, &sched, &len);
+    int kept = sched;
+
+    int bad = 7;
+    int rejected = UDT::setsockopt(u, 0, UDT_SNDSCHED, &bad, sizeof(int));
+    UDT::getsockopt(u, 0, UDT_SNDSCHED, &sched, &len);
+
+    UDT::close(u);
+    UDT::cleanup();
+
+    cout << "Default: " << def << ", set to deadline: " << accepted << ", read back " << kept << "; 7: " << rejected
+         << ", still " << sched << endl;
+
+    bool passed = (UDT_SCHED_LOSSFIRST == def) && (0 == accepted) && (UDT_SCHED_DEADLINE == kept) &&
+                  (UDT::ERROR == rejected) && (UDT_SCHED_DEADLINE == sched);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_loss_first() {
+    cout << "\n[TEST 2] Loss First Resends A Late Frame's Packet At Once\n";
+    cout << "=========================================================\n";
+
+    int fresh = 0;
+    int gap = run(UDT_SCHED_LOSSFIRST, fresh);
+
+    cout << "New packets between the loss and its retransmission: " << gap << " of " << fresh << endl;
+
+    bool passed = (gap >= 0) && (gap < FRAMES * CHUNKS / 4);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_deadline() {
+    cout << "\n[TEST 3] Deadline Policy Resends It After The Frames That Can Still Make It\n";
+    cout << "===========================================================================\n";
+
+    int fresh = 0;
+    int gap = run(UDT_SCHED_DEADLINE, fresh);
+
+    cout << "New packets between the loss and its retransmission: " << gap << " of " << fresh << endl;
+
+    bool passed = (gap >= 0) && (gap == fresh) && (gap >= FRAMES * CHUNKS - LOST - 1 - CHUNKS);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Retransmission Scheduling Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 3;
+
+    if (test_option()) passed++;
+    if (test_loss_first()) passed++;
+    if (test_deadline()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
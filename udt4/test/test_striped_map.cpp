@@ -0,0 +1,289 @@
+/*
+ * Test program for the lock-striped socket tables
+ * This program tests CStripedMap on its own: lookups, overwrites and removals, how consecutive socket IDs
+ * spread over the stripes, and lookups running while another thread changes the map; then the socket
+ * tables of the library, which never report a socket being closed as nonexistent
+ */
+
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <set>
+#include <pthread.h>
+#include "../src/api.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+bool test_map_basics() {
+    cout << "\n[TEST 1] Find, Set And Erase\n";
+    cout << "=============================\n";
+
+    CStripedMap<int, int> m;
+    bool empty = m.empty();
+
+    for (int i = 0; i < 1000; ++i)
+        m.set(i * 7, i);
+
+    int val = -1;
+    bool found = true;
+    for (int i = 0; i < 1000; ++i)
+        found = found && m.find(i * 7, val) && (val == i);
+    bool missing = !m.find(3, val) && !m.find(7000, val);
+
+    // an overwrite keeps one entry, an erase removes only its key
+    m.set(14, 99);
+    m.erase(21);
+    bool overwritten = m.find(14, val) && (99 == val);
+    bool erased = !m.find(21, val) && m.find(28, val) && (4 == val);
+
+    size_t entries = 0;
+    for (int s = 0; s < CStripedMap<int, int>::stripes(); ++s)
+        entries += m.bucket(s).size();
+
+    // every key lives in the bucket of its stripe
+    bool placed = true;
+    for (int s = 0; s < CStripedMap<int, int>::stripes(); ++s)
+        for (CStripedMap<int, int>::Bucket::iterator i = m.bucket(s).begin(); i != m.bucket(s).end(); ++i)
+            placed = placed && (CStripedMap<int, int>::stripe(i->first) == s);
+
+    m.clear();
+    bool cleared = m.empty() && !m.find(14, val);
+
+    cout << "Entries: " << entries << ", found all: " << (found ? "yes" : "no") << ", overwritten: "
+         << (overwritten ? "yes" : "no") << ", erased: " << (erased ? "yes" : "no") << endl;
+
+    bool passed = empty && found && missing && overwritten && erased && (999 == entries) && placed && cleared;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_stripe_spread() {
+    cout << "\n[TEST 2] Consecutive Socket IDs Spread Over The Stripes\n";
+    cout << "========================================================\n";
+
+    const int stripes = CStripedMap<UDTSOCKET, int>::stripes();
+
+    // socket IDs are handed out one after another, downwards from a random start
+    bool inrange = true;
+    set<int> used;
+    vector<int> load(stripes, 0);
+    const UDTSOCKET start = 1 << 29;
+    for (int i = 0; i < stripes; ++i) {
+        int s = CStripedMap<UDTSOCKET, int>::stripe(start - i);
+        inrange = inrange && (s >= 0) && (s < stripes);
+        used.insert(s);
+    }
+    for (int i = 0; i < stripes * 100; ++i)
+        ++ load[CStripedMap<UDTSOCKET, int>::stripe(start - i)];
+    int most = 0;
+    for (int s = 0; s < stripes; ++s)
+        most = max(most, load[s]);
+
+    // the peer table is keyed by 64-bit values
+    bool wide = true;
+    for (int64_t k = -5; k < 5; ++k) {
+        int s = CStripedMap<int64_t, int>::stripe((k << 30) + 12345);
+        wide = wide && (s >= 0) && (s < stripes);
+    }
+
+    cout << stripes << " consecutive IDs use " << used.size() << " stripes; the fullest of " << stripes
+         << " stripes holds " << most << " of " << stripes * 100 << " IDs" << endl;
+
+    bool passed = inrange && wide && ((int)used.size() >= stripes / 2) && (most <= 200);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+struct Shared {
+    CStripedMap<int, int> map;
+    volatile bool stop;
+    int errors;
+    long lookups;
+};
+
+// the keys below 1000 are never changed, their values must always be found
+static void* lookup(void* param) {
+    Shared* sh = (Shared*)param;
+    int errors = 0;
+    long lookups = 0;
+    while (!sh->stop) {
+        for (int i = 0; i < 1000; ++i) {
+            int val;
+            if (!sh->map.find(i, val) || (val != i * 3))
+                ++ errors;
+
+            // the changing keys are either absent or hold their own value
+            if (sh->map.find(1000 + i, val) && (val != -i))
+                ++ errors;
+        }
+        lookups += 2000;
+    }
+    __sync_fetch_and_add(&sh->errors, errors);
+    __sync_fetch_and_add(&sh->lookups, lookups);
+    return NULL;
+}
+
+bool test_concurrent_lookup() {
+    cout << "\n[TEST 3] Lookups While The Map Changes\n";
+    cout << "=======================================\n";
+
+    Shared sh;
+    sh.stop = false;
+    sh.errors = 0;
+    sh.lookups = 0;
+    for (int i = 0; i < 1000; ++i)
+        sh.map.set(i, i * 3);
+
+    const int readers = 4;
+    pthread_t t[readers];
+    for (int i = 0; i < readers; ++i)
+        pthread_create(&t[i], NULL, lookup, &sh);
+
+    // a single writer, as under the control lock of CUDTUnited
+    for (int r = 0; r < 200; ++r) {
+        for (int i = 0; i < 1000; ++i)
+            sh.map.set(1000 + i, -i);
+        for (int i = 0; i < 1000; ++i)
+            sh.map.erase(1000 + i);
+    }
+
+    sh.stop = true;
+    for (int i = 0; i < readers; ++i)
+        pthread_join(t[i], NULL);
+
+    size_t entries = 0;
+    for (int s = 0; s < CStripedMap<int, int>::stripes(); ++s)
+        entries += sh.map.bucket(s).size();
+
+    cout << "Lookups: " << sh.lookups << ", wrong results: " << sh.errors << ", entries left: " << entries << endl;
+
+    bool passed = (0 == sh.errors) && (sh.lookups > 0) && (1000 == entries);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+struct Watch {
+    vector<UDTSOCKET> socks;
+    volatile bool stop;
+    int missing;
+    int wrong;
+};
+
+// a socket is open or closed, never gone, while it moves from one table to the other
+static void* watch_states(void* param) {
+    Watch* w = (Watch*)param;
+    int missing = 0, wrong = 0;
+    while (!w->stop) {
+        for (size_t i = 0; i < w->socks.size(); ++i) {
+            UDTSTATUS st = UDT::getsockstate(w->socks[i]);
+            if (NONEXIST == st)
+                ++ missing;
+            else if ((INIT != st) && (CLOSED != st))
+                ++ wrong;
+        }
+    }
+    __sync_fetch_and_add(&w->missing, missing);
+    __sync_fetch_and_add(&w->wrong, wrong);
+    return NULL;
+}
+
+bool test_socket_tables() {
+    cout << "\n[TEST 4] A Closing Socket Is Never Missing From Both Tables\n";
+    cout << "============================================================\n";
+
+    UDT::startup();
+
+    Watch w;
+    w.stop = false;
+    w.missing = 0;
+    w.wrong = 0;
+    for (int i = 0; i < 500; ++i)
+        w.socks.push_back(UDT::socket(AF_INET, SOCK_STREAM, 0));
+
+    const int watchers = 4;
+    pthread_t t[watchers];
+    for (int i = 0; i < watchers; ++i)
+        pthread_create(&t[i], NULL, watch_states, &w);
+
+    // closed sockets stay in the closed table for a second, long after this loop is done
+    int closed = 0;
+    for (size_t i = 0; i < w.socks.size(); ++i)
+        if (0 == UDT::close(w.socks[i]))
+            ++ closed;
+
+    w.stop = true;
+    for (int i = 0; i < watchers; ++i)
+        pthread_join(t[i], NULL);
+
+    bool allclosed = true;
+    for (size_t i = 0; i < w.socks.size(); ++i)
+        allclosed = allclosed && (CLOSED == UDT::getsockstate(w.socks[i]));
+
+    UDT::cleanup();
+
+    cout << "Closed " << closed << " sockets; seen missing: " << w.missing << ", in another state: " << w.wrong
+         << ", all reported closed: " << (allclosed ? "yes" : "no") << endl;
+
+    bool passed = (500 == closed) && (0 == w.missing) && (0 == w.wrong) && allclosed;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 4 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 4 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Striped Socket Table Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 4;
+
+    if (test_map_basics()) passed++;
+    if (test_stripe_spread()) passed++;
+    if (test_concurrent_lookup()) passed++;
+    if (test_socket_tables()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
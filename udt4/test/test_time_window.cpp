@@ -0,0 +1,215 @@
+/*
+ * Test program for the sorted packet time window
+ * This program tests that CPktTimeWindow keeps its sorted twin in order as values are replaced, that the
+ * median filter read from it matches a filter over a copy of the window as UDT used to compute it,
+ * and the receiving speed and bandwidth estimated from packets and probe pairs spaced in time
+ */
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include "../src/common.h"
+#include "../src/window.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+// the filter as it was computed on every ACK: copy the window, find the median, average the values within 8 times of it
+static int64_t reference_filter(const vector<int>& window, int& count) {
+    vector<int> replica(window);
+    nth_element(replica.begin(), replica.begin() + replica.size() / 2, replica.end());
+    int median = replica[replica.size() / 2];
+    int upper = median << 3;
+    int lower = median >> 3;
+
+    int64_t sum = 0;
+    count = 0;
+    for (size_t i = 0; i < window.size(); ++i) {
+        if ((window[i] < upper) && (window[i] > lower)) {
+            ++ count;
+            sum += window[i];
+        }
+    }
+    return sum;
+}
+
+// a packet interval: mostly steady with jitter, sometimes a burst or a gap far off the median
+static int next_interval(int base) {
+    int r = rand() % 100;
+    if (r < 5)
+        return 1 + rand() % (base / 10 + 1);
+    if (r < 10)
+        return base * (9 + rand() % 50);
+    if (r < 15)
+        return base;
+    return base - base / 4 + rand() % (base / 2 + 1);
+}
+
+bool test_sorted_twin() {
+    cout << "\n[TEST 1] The Sorted Twin Stays In Order\n";
+    cout << "========================================\n";
+
+    srand(1);
+    const int sizes[5] = {1, 2, 16, 17, 64};
+    bool ordered = true;
+    int replaced = 0;
+    for (int k = 0; k < 5; ++k) {
+        int size = sizes[k];
+        vector<int> window(size, 1000000), sorted(size, 1000000);
+        int base = 100 + rand() % 10000;
+        for (int n = 0; n < 5000; ++n) {
+            int pos = n % size;
+            int val = next_interval(base);
+
+            // a rate change now and then moves every value across the window
+            if (0 == n % 1000)
+                base = 100 + rand() % 10000;
+
+            CPktTimeWindow::replaceSorted(&sorted[0], size, window[pos], val);
+            window[pos] = val;
+            ++ replaced;
+
+            vector<int> expected(window);
+            sort(expected.begin(), expected.end());
+            ordered = ordered && (expected == sorted);
+        }
+    }
+
+    // equal values, and a value replaced by itself
+    vector<int> same(8, 5);
+    CPktTimeWindow::replaceSorted(&same[0], 8, 5, 5);
+    CPktTimeWindow::replaceSorted(&same[0], 8, 5, 3);
+    CPktTimeWindow::replaceSorted(&same[0], 8, 5, 9);
+    bool equal = (3 == same[0]) && (5 == same[1]) && (5 == same[6]) && (9 == same[7]);
+
+    cout << "Values replaced: " << replaced << ", sorted twin matches a full sort: " << (ordered ? "yes" : "no")
+         << ", equal values: " << (equal ? "ok" : "wrong") << endl;
+
+    bool passed = ordered && equal;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_filter_matches_copy() {
+    cout << "\n[TEST 2] The Filter Matches One Over A Copy Of The Window\n";
+    cout << "==========================================================\n";
+
+    srand(2);
+    const int size = 16;
+    vector<int> window(size, 1000000), sorted(size, 1000000);
+    int64_t sum = 1000000LL * size;
+    int checked = 0, mismatches = 0, filtered = 0;
+    int base = 1000;
+    for (int n = 0; n < 20000; ++n) {
+        if (0 == n % 2000)
+            base = 10 + rand() % 100000;
+
+        int pos = n % size;
+        int val = next_interval(base);
+        CPktTimeWindow::replaceSorted(&sorted[0], size, window[pos], val);
+        sum += val - window[pos];
+        window[pos] = val;
+
+        int count, refcount;
+        int64_t got = CPktTimeWindow::filterSorted(&sorted[0], size, sum, count);
+        int64_t expected = reference_filter(window, refcount);
+        if ((got != expected) || (count != refcount))
+            ++ mismatches;
+        if (count < size)
+            ++ filtered;
+        ++ checked;
+    }
+
+    cout << "Windows checked: " << checked << ", with outliers filtered: " << filtered << ", mismatches: " << mismatches << endl;
+
+    bool passed = (0 == mismatches) && (filtered > 0);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_speed_and_bandwidth() {
+    cout << "\n[TEST 3] Speed And Bandwidth From Spaced Arrivals\n";
+    cout << "==================================================\n";
+
+    CPktTimeWindow w;
+
+    // with no history the window holds one-second intervals
+    int initial = w.getPktRcvSpeed();
+
+    // packets about 2 ms apart, with one long gap that the filter leaves out
+    for (int i = 0; i < 40; ++i) {
+        usleep((20 == i) ? 100000 : 2000);
+        w.onPktArrival();
+    }
+    int speed = w.getPktRcvSpeed();
+
+    // probe pairs about 1 ms apart
+    for (int i = 0; i < 16; ++i) {
+        w.probe1Arrival();
+        usleep(1000);
+        w.probe2Arrival();
+    }
+    int bandwidth = w.getBandwidth();
+
+    cout << "Initial speed: " << initial << " packets/s, after 2 ms spacing: " << speed
+         << " packets/s, bandwidth from 1 ms pairs: " << bandwidth << " packets/s" << endl;
+
+    // sleeps only ever run long, so the estimates stay below the nominal rates
+    bool passed = (1 == initial) && (speed > 100) && (speed <= 500) && (bandwidth > 200) && (bandwidth <= 1000);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Packet Time Window Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 3;
+
+    if (test_sorted_twin()) passed++;
+    if (test_filter_matches_copy()) passed++;
+    if (test_speed_and_bandwidth()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,248 @@
+/*
+ * Test program for the receive unit free list
+ * This program tests that CUnitQueue hands out the units the receiver buffers have released before it grows,
+ * that units released from another thread while the worker takes units are never handed out twice, and that
+ * shrink() releases only grown blocks that are entirely free, while half of the queue stays free
+ */
+
+#include <iostream>
+#include <set>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+#include "../src/queue.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+static const int BLOCK = 16;
+static const int MSS = 1500;
+
+bool test_reuse() {
+    cout << "\n[TEST 1] Released Units Are Handed Out Before The Queue Grows\n";
+    cout << "=============================================================\n";
+
+    CUnitQueue queue;
+    queue.init(BLOCK, MSS, AF_INET);
+
+    // two blocks: the second one is added when the first runs out
+    vector<CUnit*> held;
+    for (int i = 0; i < BLOCK * 2; ++i)
+        held.push_back(queue.getNextAvailUnit());
+    set<CUnit*> all(held.begin(), held.end());
+
+    // a receiver buffer releases a few of them
+    set<CUnit*> released;
+    for (int i = 3; i < BLOCK * 2; i += 3) {
+        held[i]->m_iFlag = 1;
+        queue.makeUnitFree(held[i]);
+        released.insert(held[i]);
+    }
+
+    set<CUnit*> reused;
+    for (size_t i = 0; i < released.size(); ++i)
+        reused.insert(queue.getNextAvailUnit());
+
+    // the next one comes from a new block
+    CUnit* grown = queue.getNextAvailUnit();
+
+    cout << "Units: " << all.size() << " distinct, " << released.size() << " released, reused "
+         << ((reused == released) ? "all of them" : "others") << ", then a new unit: "
+         << ((0 == all.count(grown)) ? "yes" : "no") << endl;
+
+    bool passed = (BLOCK * 2 == (int)all.size()) && (0 == all.count(NULL)) && (reused == released) &&
+                  (NULL != grown) && (0 == all.count(grown));
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+// units taken by the worker, released by a receiver buffer on another thread
+struct Handoff {
+    CUnitQueue* queue;
+    pthread_mutex_t lock;
+    vector<CUnit*> pending;
+    set<CUnit*> held;
+    volatile bool stop;
+    int released;
+};
+
+static void* release_loop(void* param) {
+    Handoff* h = (Handoff*)param;
+    while (true) {
+        vector<CUnit*> units;
+        pthread_mutex_lock(&h->lock);
+        units.swap(h->pending);
+        bool stop = h->stop;
+        pthread_mutex_unlock(&h->lock);
+
+        if (units.empty()) {
+            if (stop)
+                break;
+            usleep(10);
+            continue;
+        }
+
+        for (size_t i = 0; i < units.size(); ++i) {
+            pthread_mutex_lock(&h->lock);
+            h->held.erase(units[i]);
+            pthread_mutex_unlock(&h->lock);
+            h->queue->makeUnitFree(units[i]);
+            ++ h->released;
+        }
+    }
+    return NULL;
+}
+
+bool test_concurrent_release() {
+    cout << "\n[TEST 2] Units Released From Another Thread Are Never Handed Out Twice\n";
+    cout << "======================================================================\n";
+
+    CUnitQueue queue;
+    queue.init(BLOCK * 4, MSS, AF_INET);
+
+    Handoff h;
+    h.queue = &queue;
+    pthread_mutex_init(&h.lock, NULL);
+    h.stop = false;
+    h.released = 0;
+
+    pthread_t t;
+    pthread_create(&t, NULL, release_loop, &h);
+
+    const int rounds = 200000;
+    int twice = 0, missing = 0, unused = 0;
+    for (int i = 0; i < rounds; ++i) {
+        CUnit* unit = queue.getNextAvailUnit();
+        if (NULL == unit) {
+            ++ missing;
+            continue;
+        }
+        if (-1 != unit->m_iFlag)
+            ++ unused;
+
+        // the receiver buffer keeps it for a while, then releases it
+        unit->m_iFlag = 1;
+        pthread_mutex_lock(&h.lock);
+        if (!h.held.insert(unit).second)
+            ++ twice;
+        h.pending.push_back(unit);
+        pthread_mutex_unlock(&h.lock);
+    }
+
+    pthread_mutex_lock(&h.lock);
+    h.stop = true;
+    pthread_mutex_unlock(&h.lock);
+    pthread_join(t, NULL);
+    pthread_mutex_destroy(&h.lock);
+
+    cout << "Taken " << rounds - missing << ", released " << h.released << ", handed out while held: " << twice
+         << ", not marked taken: " << unused << endl;
+
+    bool passed = (0 == missing) && (rounds == h.released) && (0 == twice) && (0 == unused) && h.held.empty();
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+static void release(CUnitQueue& queue, vector<CUnit*>& units, int first, int last) {
+    for (int i = first; i < last; ++i) {
+        units[i]->m_iFlag = 1;
+        queue.makeUnitFree(units[i]);
+    }
+}
+
+bool test_shrink() {
+    cout << "\n[TEST 3] Shrink Releases Free Grown Blocks While Half The Queue Stays Free\n";
+    cout << "==========================================================================\n";
+
+    CUnitQueue queue;
+    queue.init(BLOCK, MSS, AF_INET);
+
+    // four blocks, all in use: units [0, 16) are the initial block, each next 16 a grown one
+    vector<CUnit*> units;
+    for (int i = 0; i < BLOCK * 4; ++i)
+        units.push_back(queue.getNextAvailUnit());
+    set<CUnit*> first(units.begin(), units.begin() + BLOCK);
+
+    // shrink looks at most once a second
+    int early = queue.shrink();
+    usleep(1050000);
+
+    // the last block and half of the third are free: 3/8 of the queue, less than half
+    release(queue, units, BLOCK * 2 + BLOCK / 2, BLOCK * 4);
+    int busy = queue.shrink();
+    usleep(1050000);
+
+    // the second block is free too, but the third is still partly in use
+    release(queue, units, BLOCK, BLOCK * 2);
+    int second = queue.shrink();
+    usleep(1050000);
+
+    // everything is free: the queue goes back to the initial block, and no further
+    release(queue, units, 0, BLOCK);
+    release(queue, units, BLOCK * 2, BLOCK * 2 + BLOCK / 2);
+    int rest = queue.shrink();
+    int floor = queue.shrink();
+
+    // the units left are those of the initial block
+    bool initial = true;
+    for (int i = 0; i < BLOCK; ++i)
+        initial = initial && (first.count(queue.getNextAvailUnit()) > 0);
+
+    cout << "Released: at once " << early << ", with 3/8 free " << busy << ", with a block free " << second
+         << ", with all free " << rest << ", again " << floor << "; initial block kept: " << (initial ? "yes" : "no") << endl;
+
+    bool passed = (0 == early) && (0 == busy) && (BLOCK == second) && (BLOCK * 2 == rest) && (0 == floor) && initial;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Receive Unit Queue Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 3;
+
+    if (test_reuse()) passed++;
+    if (test_concurrent_release()) passed++;
+    if (test_shrink()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,375 @@
+/*
+ * Test program for the io_uring channel backend
+ * This program tests UDT_URING, the receives posted into packets in advance and their cancelling, and a
+ * transfer between two UDT sockets that use it; where the kernel has no io_uring, it tests that the channel
+ * falls back to recvmmsg
+ */
+
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include "../src/udt.h"
+#include "../src/channel.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+static const int PAYLOAD = 1000;
+
+// open a channel on an ephemeral loopback port and return its address
+static void open_loopback(CChannel& channel, sockaddr_in& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    channel.open((sockaddr*)&addr);
+    channel.getSockAddr((sockaddr*)&addr);
+}
+
+static void send_packets(CChannel& snd, sockaddr_in& to, int count) {
+    char payload[PAYLOAD];
+    for (int i = 0; i < count; ++i) {
+        CPacket packet;
+        memset(payload, i, PAYLOAD);
+        packet.m_pcData = payload;
+        packet.setLength(PAYLOAD);
+        packet.m_iSeqNo = 100 + i;
+        packet.m_iMsgNo = 0xC0000000 | (1 + i);
+        packet.m_iTimeStamp = 0;
+        packet.m_iID = 7;
+        packet.setHeaderFormat<HDR_CLASSIC>(0, 0, 0, 0);
+        snd.sendto((sockaddr*)&to, packet);
+        packet.m_pcData = NULL;
+    }
+}
+
+bool test_option() {
+    cout << "\n[TEST 1] UDT_URING Is Set Before The Socket Is Bound\n";
+    cout << "====================================================\n";
+
+    UDT::startup();
+
+    UDTSOCKET u = UDT::socket(AF_INET, SOCK_STREAM, 0);
+    bool uring = true;
+    int len = sizeof(bool);
+    UDT::getsockopt(u, 0, UDT_URING, &uring, &len);
+    bool def = uring;
+
+    bool on = true;
+    int accepted = UDT::setsockopt(u, 0, UDT_URING, &on, sizeof(bool));
+    UDT::getsockopt(u, 0, UDT_URING, &uring, &len);
+    bool kept = uring;
+
+    // the channel is set up when the socket is bound
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    UDT::bind(u, (sockaddr*)&addr, sizeof(addr));
+    int late = UDT::setsockopt(u, 0, UDT_URING, &on, sizeof(bool));
+    int code = UDT::getlasterror().getErrorCode();
+
+    UDT::close(u);
+    UDT::cleanup();
+
+    cout << "Default: " << def << ", set: " << accepted << ", read back " << kept << "; after bind: " << late
+         << " (" << code << ")" << endl;
+
+    bool passed = !def && (0 == accepted) && kept && (UDT::ERROR == late) && (CUDTException::EBOUNDSOCK == code);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_posted_receive() {
+    cout << "\n[TEST 2] Posted Receives Are Filled In Place, Or Read By recvmmsg Without io_uring\n";
+    cout << "=================================================================================\n";
+
+    CChannel snd(AF_INET), rcv(AF_INET);
+    rcv.setURing(true);
+    sockaddr_in sndaddr, rcvaddr;
+    open_loopback(snd, sndaddr);
+    open_loopback(rcv, rcvaddr);
+    bool posted = rcv.isRecvPosted();
+
+    const int count = 8;
+    vector<char> buf(PAYLOAD * CChannel::m_iMaxPosted);
+    CPacket packets[CChannel::m_iMaxPosted];
+    CPacket* batch[CChannel::m_iMaxBatchSize];
+    sockaddr_in from[CChannel::m_iMaxBatchSize];
+    sockaddr* addrs[CChannel::m_iMaxBatchSize];
+    for (int i = 0; i < CChannel::m_iMaxBatchSize; ++i)
+        addrs[i] = (sockaddr*)(from + i);
+
+    int num = 0;
+    for (int i = 0; i < CChannel::m_iMaxPosted; ++i) {
+        packets[i].m_pcData = &buf[PAYLOAD * i];
+        packets[i].setLength(PAYLOAD);
+        if (rcv.postRecv(packets + i, packets + i))
+            ++ num;
+    }
+    // one more than m_iMaxPosted
+    CPacket extra;
+    bool over = rcv.postRecv(&extra, &extra);
+
+    send_packets(snd, rcvaddr, count);
+
+    int received = 0, calls = 0;
+    bool order = true;
+    while ((received < count) && (calls < 100)) {
+        int res;
+        ++ calls;
+        if (posted) {
+            void* context[CChannel::m_iMaxBatchSize];
+            res = rcv.waitRecv(context, addrs, CChannel::m_iMaxBatchSize, 100000);
+            for (int i = 0; i < res; ++i)
+                batch[i] = (CPacket*)context[i];
+        } else {
+            for (int i = 0; i < CChannel::m_iMaxBatchSize; ++i) {
+                packets[i].setLength(PAYLOAD);
+                batch[i] = packets + i;
+            }
+            res = rcv.recvfrom(addrs, batch, count - received);
+        }
+        if (res < 0)
+            break;
+
+        for (int i = 0; i < res; ++i) {
+            // the packet is read into the largest header, the connection gives the rest back
+            batch[i]->trimHeader(CPacket::getFormatSize(HDR_CLASSIC));
+            int k = received + i;
+            // posted receives are filled in the order they were posted
+            order = order && (!posted || (batch[i] == packets + k)) && (batch[i]->m_iSeqNo == 100 + k) &&
+                    (batch[i]->getLength() == PAYLOAD) && (batch[i]->m_pcData[PAYLOAD - 1] == char(k)) &&
+                    (from[i].sin_port == sndaddr.sin_port);
+        }
+        received += res;
+    }
+
+    bool cancelled = rcv.cancelRecv();
+    for (int i = 0; i < CChannel::m_iMaxPosted; ++i)
+        packets[i].m_pcData = NULL;
+    snd.close();
+    rcv.close();
+
+    cout << (posted ? "io_uring" : YELLOW "no io_uring, recvmmsg" RESET) << ": posted " << num
+         << (over ? ", and one more" : "") << "; received " << received << " in " << calls << " calls, in order: "
+         << (order ? "yes" : "no") << "; cancelled: " << (cancelled ? "yes" : "no") << endl;
+
+    bool passed = (posted ? (CChannel::m_iMaxPosted == num) : (0 == num)) && !over && (received == count) && order &&
+                  cancelled;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_cancel() {
+    cout << "\n[TEST 3] Cancelled Receives Free Their Packets For New Ones\n";
+    cout << "===========================================================\n";
+
+    CChannel snd(AF_INET), rcv(AF_INET);
+    rcv.setURing(true);
+    sockaddr_in sndaddr, rcvaddr;
+    open_loopback(snd, sndaddr);
+    open_loopback(rcv, rcvaddr);
+    bool posted = rcv.isRecvPosted();
+
+    vector<char> buf(PAYLOAD * CChannel::m_iMaxPosted);
+    CPacket packets[CChannel::m_iMaxPosted];
+    for (int i = 0; i < CChannel::m_iMaxPosted; ++i) {
+        packets[i].m_pcData = &buf[PAYLOAD * i];
+        packets[i].setLength(PAYLOAD);
+    }
+
+    // several rounds of receives submitted to the kernel, no packet arriving, then cancelled
+    int rounds = 0, reposted = 0, waited = 0;
+    bool cancelled = true;
+    for (; rounds < 5; ++rounds) {
+        for (int i = 0; i < CChannel::m_iMaxPosted; ++i)
+            if (rcv.postRecv(packets + i, packets + i))
+                ++ reposted;
+
+        void* context[CChannel::m_iMaxBatchSize];
+        sockaddr_in from[CChannel::m_iMaxBatchSize];
+        sockaddr* addrs[CChannel::m_iMaxBatchSize];
+        for (int i = 0; i < CChannel::m_iMaxBatchSize; ++i)
+            addrs[i] = (sockaddr*)(from + i);
+        if (posted)
+            waited += rcv.waitRecv(context, addrs, CChannel::m_iMaxBatchSize, 1000);
+
+        cancelled = rcv.cancelRecv() && cancelled;
+    }
+
+    // a packet sent now is not written into a cancelled receive
+    memset(&buf[0], 'x', buf.size());
+    send_packets(snd, rcvaddr, 1);
+    usleep(20000);
+    bool untouched = true;
+    for (size_t i = 0; i < buf.size(); ++i)
+        untouched = untouched && ('x' == buf[i]);
+
+    for (int i = 0; i < CChannel::m_iMaxPosted; ++i)
+        packets[i].m_pcData = NULL;
+    snd.close();
+    rcv.close();
+
+    cout << (posted ? "io_uring" : YELLOW "no io_uring" RESET) << ": " << rounds << " rounds, posted " << reposted
+         << ", received " << waited << "; cancelled: " << (cancelled ? "yes" : "no") << ", buffers untouched after: "
+         << (untouched ? "yes" : "no") << endl;
+
+    bool passed = (reposted == (posted ? rounds * CChannel::m_iMaxPosted : 0)) && (0 == waited) && cancelled && untouched;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+struct Pair {
+    UDTSOCKET serv;
+    UDTSOCKET server;
+    UDTSOCKET client;
+};
+
+static void* accept_one(void* param) {
+    Pair* p = (Pair*)param;
+    p->server = UDT::accept(p->serv, NULL, NULL);
+    return NULL;
+}
+
+struct Sender {
+    UDTSOCKET sock;
+    vector<char>* data;
+};
+
+static void* send_data(void* param) {
+    Sender* s = (Sender*)param;
+    int size = s->data->size();
+    int sent = 0;
+    while (sent < size) {
+        int res = UDT::send(s->sock, &(*s->data)[sent], size - sent, 0);
+        if (res <= 0)
+            break;
+        sent += res;
+    }
+    return NULL;
+}
+
+bool test_transfer() {
+    cout << "\n[TEST 4] A Transfer Between Two Sockets With UDT_URING Arrives Intact\n";
+    cout << "=====================================================================\n";
+
+    UDT::startup();
+
+    // both ends on io_uring, each with a multiplexer of its own
+    bool on = true;
+    Pair p;
+    p.serv = UDT::socket(AF_INET, SOCK_STREAM, 0);
+    UDT::setsockopt(p.serv, 0, UDT_URING, &on, sizeof(bool));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    UDT::bind(p.serv, (sockaddr*)&addr, sizeof(addr));
+    int namelen = sizeof(addr);
+    UDT::getsockname(p.serv, (sockaddr*)&addr, &namelen);
+    UDT::listen(p.serv, 1);
+
+    pthread_t t;
+    pthread_create(&t, NULL, accept_one, &p);
+
+    p.client = UDT::socket(AF_INET, SOCK_STREAM, 0);
+    UDT::setsockopt(p.client, 0, UDT_URING, &on, sizeof(bool));
+    int res = UDT::connect(p.client, (sockaddr*)&addr, sizeof(addr));
+    pthread_join(t, NULL);
+    bool connected = (UDT::ERROR != res) && (UDT::INVALID_SOCK != p.server);
+
+    const int size = 20000000;
+    vector<char> data(size);
+    for (int i = 0; i < size; ++i)
+        data[i] = char(i * 7 + i / 1000);
+    Sender s = {p.client, &data};
+    pthread_create(&t, NULL, send_data, &s);
+
+    vector<char> buf(size);
+    int received = 0;
+    while (connected && (received < size)) {
+        res = UDT::recv(p.server, &buf[received], size - received, 0);
+        if (res <= 0)
+            break;
+        received += res;
+    }
+    pthread_join(t, NULL);
+
+    UDT::TRACEINFO perf;
+    UDT::perfmon(p.server, &perf, false);
+
+    UDT::close(p.client);
+    UDT::close(p.server);
+    UDT::close(p.serv);
+    UDT::cleanup();
+
+    bool intact = (received == size) && (0 == memcmp(&data[0], &buf[0], size));
+
+    cout << "Received " << received << "/" << size << " bytes, intact: " << (intact ? "yes" : "no") << ", packets "
+         << perf.pktRecvTotal << endl;
+
+    bool passed = connected && intact;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 4 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 4 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  io_uring Channel Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 4;
+
+    if (test_option()) passed++;
+    if (test_posted_receive()) passed++;
+    if (test_cancel()) passed++;
+    if (test_transfer()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,296 @@
+/*
+ * Test program for the frame-aware congestion control
+ * This program drives CVRFrameCC (app/cc.h) with ACK, loss, timeout and packet sent events and checks how its
+ * sending period and congestion window respond to queueing delay, loss and frame deadlines
+ */
+
+#include <iostream>
+#include <cmath>
+#include "../src/udt.h"
+#include "../src/ccc.h"
+#include "../app/cc.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+static const int BASE_RTT = 10000;
+static const int RCV_RATE = 10000;      // 100 us per packet once slow start ends
+
+// CVRFrameCC with the path state UDT would feed it made settable
+class CTestVRCC: public CVRFrameCC
+{
+public:
+   void setPath(int rtt, int rcvrate, int bandwidth)
+   {
+      m_iRTT = rtt;
+      m_iRcvRate = rcvrate;
+      m_iBandwidth = bandwidth;
+   }
+
+   void setSent(int32_t seqno)
+   {
+      m_iSndCurrSeqNo = seqno;
+   }
+
+   void start()
+   {
+      m_iMSS = 1500;
+      m_dMaxCWndSize = 1000;
+      m_iSndCurrSeqNo = 0;
+      setPath(BASE_RTT, RCV_RATE, 0);
+      init();
+   }
+
+   double period() const {return m_dPktSndPeriod;}
+   double window() const {return m_dCWndSize;}
+};
+
+static bool near(double a, double b) {
+   return fabs(a - b) < 1e-6 * (fabs(b) + 1);
+}
+
+// leave slow start through the delay signal, at the receive rate, then report the queue drained
+static void leave_slow_start(CTestVRCC& cc) {
+   cc.setSent(200);
+   cc.setPath(BASE_RTT + 6000, RCV_RATE, 0);
+   cc.onACK(100);
+   cc.setPath(BASE_RTT, RCV_RATE, 0);
+   cc.onACK(100);
+}
+
+static void send_chunk(CTestVRCC& cc, int32_t frame, int32_t chunk, int32_t total, int32_t offset) {
+   CPacket pkt;
+   pkt.m_iTimeStamp = 1000000;
+   pkt.setHeaderFormat<HDR_FRAME>(frame, chunk, total, 1000000 + offset);
+   cc.onPktSent(&pkt);
+}
+
+bool test_slow_start() {
+    cout << "\n[TEST 1] Slow Start Ends When The Queue Grows\n";
+    cout << "=============================================\n";
+
+    CTestVRCC cc;
+    cc.start();
+
+    // no queueing: the window grows by the packets acknowledged, the period is untouched
+    cc.setSent(200);
+    cc.onACK(100);
+    double grown = cc.window();
+    double fast = cc.period();
+    cout << "Window after ACK of 101 packets: " << grown << ", period: " << fast << endl;
+
+    // 6 ms above the base RTT is over the 5 ms target
+    cc.setPath(BASE_RTT + 6000, RCV_RATE, 0);
+    cc.onACK(150);
+    cout << "After a delayed ACK: period " << cc.period() << " us, window " << cc.window() << endl;
+
+    bool passed = near(grown, 16 + 101) && near(fast, 1.0) &&
+                  near(cc.period(), 1000000.0 / RCV_RATE) &&
+                  near(cc.window(), (BASE_RTT + 6000 + 10000) / (1000000.0 / RCV_RATE) + 16);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_delay_backoff() {
+    cout << "\n[TEST 2] Delay Backoff Once Per RTT, Probe Without Queueing\n";
+    cout << "===========================================================\n";
+
+    CTestVRCC cc;
+    cc.start();
+    leave_slow_start(cc);
+    double base = cc.period();
+
+    // queueing above the target: back off by 1/8 for an ACK past the last decrease
+    cc.setSent(400);
+    cc.setPath(BASE_RTT + 6000, RCV_RATE, 0);
+    cc.onACK(300);
+    double backoff = cc.period();
+
+    // not past the packets sent at that decrease: no second backoff in the same RTT
+    cc.onACK(350);
+    double held = cc.period();
+
+    // queue drained: probe by 5% of the period
+    cc.setPath(BASE_RTT, RCV_RATE, 0);
+    cc.onACK(420);
+    double probe = cc.period();
+
+    cout << "Period: " << base << " -> backoff " << backoff << " -> same RTT " << held << " -> probe " << probe << endl;
+
+    bool passed = near(backoff, base / 0.875) && near(held, backoff) && near(probe, backoff / 1.05) &&
+                  near(cc.window(), (BASE_RTT + 10000) / probe + 16);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_loss() {
+    cout << "\n[TEST 3] Loss Cuts Hard Only When The Path Is Queueing\n";
+    cout << "======================================================\n";
+
+    CTestVRCC cc;
+    cc.start();
+
+    // loss in slow start ends it at the receive rate
+    cc.setSent(50);
+    int32_t loss = 20;
+    cc.onLoss(&loss, 1);
+    double base = cc.period();
+
+    // loss without queueing: 3% decrease
+    cc.setSent(100);
+    loss = 60;
+    cc.onLoss(&loss, 1);
+    double random = cc.period();
+
+    // loss before the last decrease is the same congestion event
+    loss = 80;
+    cc.onLoss(&loss, 1);
+    double same = cc.period();
+
+    // loss while the queue is over half the target delay: 1/8 decrease
+    cc.setSent(200);
+    cc.setPath(BASE_RTT + 3000, RCV_RATE, 0);
+    loss = 150 | 0x80000000;
+    cc.onLoss(&loss, 1);
+    double congested = cc.period();
+
+    cout << "Period: " << base << " -> random loss " << random << " -> same event " << same
+         << " -> congested loss " << congested << endl;
+
+    bool passed = near(base, 1000000.0 / RCV_RATE) && near(random, base * 1.03) && near(same, random) &&
+                  near(congested, random * 1.125);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_timeout() {
+    cout << "\n[TEST 4] Timeout Halves The Rate\n";
+    cout << "================================\n";
+
+    CTestVRCC cc;
+    cc.start();
+    leave_slow_start(cc);
+    double base = cc.period();
+
+    cc.onTimeout();
+    double once = cc.period();
+    cc.onTimeout();
+    double twice = cc.period();
+
+    cout << "Period: " << base << " -> " << once << " -> " << twice << endl;
+
+    bool passed = near(base, 1000000.0 / RCV_RATE / 1.05) && near(once, base * 2) && near(twice, base * 4);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 4 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 4 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_deadline_boost() {
+    cout << "\n[TEST 5] Frames Behind Their Deadline Get The Rate They Need\n";
+    cout << "============================================================\n";
+
+    CTestVRCC cc;
+    cc.start();
+    leave_slow_start(cc);
+    double base = cc.period();
+
+    // 10 chunks left and 1000 us to the deadline: (1000 - RTT/2) * 0.8 / 10 = 40 us per chunk
+    cc.setPath(1000, RCV_RATE, 0);
+    send_chunk(cc, 1, 0, 11, 1000);
+    double boost = cc.period();
+
+    // never faster than the bandwidth estimate
+    cc.setPath(1000, RCV_RATE, 20000);
+    send_chunk(cc, 1, 1, 11, 1000);
+    double capped = cc.period();
+
+    // the last chunk of the frame ends the boost
+    send_chunk(cc, 1, 10, 11, 1000);
+    double last = cc.period();
+
+    // a frame that fits in the congestion rate gets no boost
+    cc.setPath(1000, RCV_RATE, 0);
+    send_chunk(cc, 2, 0, 3, 100000);
+    double loose = cc.period();
+
+    // no boost while the path is queueing
+    cc.setPath(BASE_RTT + 3000, RCV_RATE, 0);
+    cc.setSent(200);
+    cc.onACK(200);
+    double queued = cc.period();
+    cc.setPath(1000, RCV_RATE, 0);
+    send_chunk(cc, 3, 0, 11, 1000);
+    double held = cc.period();
+
+    cout << "Period: congestion " << base << ", boosted " << boost << ", capped " << capped << ", last chunk "
+         << last << ", loose frame " << loose << ", queueing " << held << " (congestion " << queued << ")" << endl;
+
+    bool passed = near(boost, (1000 - 500) * 0.8 / 10) && near(capped, 1000000.0 / 20000) && near(last, base) &&
+                  near(loose, base) && near(held, queued);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 5 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 5 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Frame-Aware Congestion Control Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 5;
+
+    if (test_slow_start()) passed++;
+    if (test_delay_backoff()) passed++;
+    if (test_loss()) passed++;
+    if (test_timeout()) passed++;
+    if (test_deadline_boost()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,288 @@
+/*
+ * Test program for the zero-copy receive API
+ * This program tests messages and frames lent by UDT::recvmsg_zc and UDT::recvframe_zc, the receiver
+ * buffer space they hold until UDT::release_zc, and the errors for a handle given back twice
+ * and for a shared-memory connection
+ */
+
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include "../src/udt.h"
+
+using namespace std;
+
+// ANSI color codes for output
+#define GREEN "\033[32m"
+#define RED "\033[31m"
+#define RESET "\033[0m"
+#define YELLOW "\033[33m"
+
+struct Pair {
+    bool shmem;
+    UDTSOCKET serv;
+    UDTSOCKET server;
+    UDTSOCKET client;
+};
+
+static void* accept_one(void* param) {
+    Pair* p = (Pair*)param;
+    p->server = UDT::accept(p->serv, NULL, NULL);
+    return NULL;
+}
+
+// connect two SOCK_DGRAM sockets over loopback
+static bool connect_pair(Pair& p) {
+    p.serv = UDT::socket(AF_INET, SOCK_DGRAM, 0);
+    UDT::setsockopt(p.serv, 0, UDT_SHMEM, &p.shmem, sizeof(bool));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    UDT::bind(p.serv, (sockaddr*)&addr, sizeof(addr));
+    int namelen = sizeof(addr);
+    UDT::getsockname(p.serv, (sockaddr*)&addr, &namelen);
+    UDT::listen(p.serv, 1);
+
+    pthread_t t;
+    pthread_create(&t, NULL, accept_one, &p);
+
+    p.client = UDT::socket(AF_INET, SOCK_DGRAM, 0);
+    UDT::setsockopt(p.client, 0, UDT_SHMEM, &p.shmem, sizeof(bool));
+    int res = UDT::connect(p.client, (sockaddr*)&addr, sizeof(addr));
+
+    pthread_join(t, NULL);
+    return (UDT::ERROR != res) && (UDT::INVALID_SOCK != p.server);
+}
+
+static void close_pair(Pair& p) {
+    UDT::close(p.client);
+    UDT::close(p.server);
+    UDT::close(p.serv);
+}
+
+// join the pieces of a lent message, checking that none is empty
+static bool gather(const UDT_IOVEC* iov, int iovcnt, vector<char>& data) {
+    data.clear();
+    for (int i = 0; i < iovcnt; ++i) {
+        if ((NULL == iov[i].iov_base) || (0 == iov[i].iov_len))
+            return false;
+        data.insert(data.end(), (char*)iov[i].iov_base, (char*)iov[i].iov_base + iov[i].iov_len);
+    }
+    return true;
+}
+
+static int avail_rcv_buf(UDTSOCKET u) {
+    UDT::TRACEINFO perf;
+    UDT::perfmon(u, &perf, false);
+    return perf.byteAvailRcvBuf;
+}
+
+bool test_lent_messages() {
+    cout << "\n[TEST 1] Messages Are Lent In Place\n";
+    cout << "====================================\n";
+
+    UDT::startup();
+
+    Pair p = {false};
+    bool connected = connect_pair(p);
+
+    // messages of several packets each, with a pattern of their own; in order, a short one may be ready first otherwise
+    const int sizes[3] = {5000, 1, 20000};
+    for (int m = 0; m < 3; ++m) {
+        vector<char> msg(sizes[m]);
+        for (int i = 0; i < sizes[m]; ++i)
+            msg[i] = (char)(m * 31 + i % 199);
+        UDT::sendmsg(p.client, &msg[0], msg.size(), -1, true);
+    }
+
+    bool intact = true;
+    int pieces[3] = {0, 0, 0};
+    for (int m = 0; m < 3; ++m) {
+        const UDT_IOVEC* iov;
+        int iovcnt, handle;
+        int res = UDT::recvmsg_zc(p.server, iov, iovcnt, handle);
+        vector<char> data;
+        bool ok = (res == sizes[m]) && gather(iov, iovcnt, data) && ((int)data.size() == res);
+        for (int i = 0; ok && (i < res); ++i)
+            ok = (data[i] == (char)(m * 31 + i % 199));
+        intact = intact && ok && (UDT::ERROR != UDT::release_zc(p.server, handle));
+        pieces[m] = iovcnt;
+    }
+
+    close_pair(p);
+    UDT::cleanup();
+
+    cout << "Pieces per message: " << pieces[0] << ", " << pieces[1] << ", " << pieces[2] << "; data intact: "
+         << (intact ? "yes" : "no") << endl;
+
+    bool passed = connected && intact && (pieces[0] > 1) && (1 == pieces[1]) && (pieces[2] > pieces[0]);
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 1 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 1 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_loan_holds_buffer() {
+    cout << "\n[TEST 2] A Loan Holds Receiver Buffer Space Until Released\n";
+    cout << "===========================================================\n";
+
+    UDT::startup();
+
+    Pair p = {false};
+    bool connected = connect_pair(p);
+
+    int before = avail_rcv_buf(p.server);
+
+    vector<char> msg(50000, 'L');
+    UDT::sendmsg(p.client, &msg[0], msg.size());
+    const UDT_IOVEC* iov;
+    int iovcnt, handle;
+    int res = UDT::recvmsg_zc(p.server, iov, iovcnt, handle);
+    int lent = avail_rcv_buf(p.server);
+
+    // other messages are still read the usual way, the loan stays valid meanwhile
+    UDT::sendmsg(p.client, "next", 4);
+    char buf[16];
+    bool next = (4 == UDT::recvmsg(p.server, buf, sizeof(buf))) && (0 == memcmp(buf, "next", 4));
+    vector<char> data;
+    bool valid = gather(iov, iovcnt, data) && ((int)data.size() == res) && (data[0] == 'L') && (data[res - 1] == 'L');
+
+    bool released = (UDT::ERROR != UDT::release_zc(p.server, handle));
+    int after = avail_rcv_buf(p.server);
+
+    // a handle is given back once
+    bool twice = (UDT::ERROR == UDT::release_zc(p.server, handle)) && (UDT::getlasterror().getErrorCode() == CUDTException::EINVPARAM);
+
+    close_pair(p);
+    UDT::cleanup();
+
+    cout << "Available receiver buffer: " << before << " bytes before, " << lent << " with " << iovcnt
+         << " units lent, " << after << " after release" << endl;
+
+    bool passed = connected && (res == 50000) && (before - lent >= res) && (after == before) && next && valid && released && twice;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 2 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 2 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_lent_frames() {
+    cout << "\n[TEST 3] Frames Are Lent One Piece Per Chunk\n";
+    cout << "=============================================\n";
+
+    UDT::startup();
+
+    Pair p = {false};
+    bool connected = connect_pair(p);
+
+    vector<char> frame(10000);
+    for (int i = 0; i < (int)frame.size(); ++i)
+        frame[i] = (char)(i % 241);
+    UDT::TRACEINFO perf;
+    UDT::perfmon(p.client, &perf, false);
+    UDT::sendframe(p.client, &frame[0], frame.size(), 77, (perf.msTimeStamp + 5000) * 1000);
+
+    const UDT_IOVEC* iov;
+    int iovcnt, handle;
+    uint16_t frame_id = 0;
+    bool complete = false;
+    int res = UDT::recvframe_zc(p.server, iov, iovcnt, frame_id, complete, handle);
+    vector<char> data;
+    bool intact = gather(iov, iovcnt, data) && (data == frame);
+    bool released = (UDT::ERROR != UDT::release_zc(p.server, handle));
+
+    // a frame still on loan when the socket goes away is given back with it
+    UDT::sendframe(p.client, &frame[0], frame.size(), 78, (perf.msTimeStamp + 5000) * 1000);
+    bool held = (UDT::ERROR != UDT::recvframe_zc(p.server, iov, iovcnt, frame_id, complete, handle)) && (78 == frame_id);
+
+    close_pair(p);
+    UDT::cleanup();
+
+    cout << "Frame 77: " << res << " bytes in " << iovcnt << " pieces, complete "
+         << (complete ? "yes" : "no") << ", data intact: " << (intact ? "yes" : "no") << endl;
+
+    bool passed = connected && (res == 10000) && (iovcnt > 1) && complete && intact && released && held;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 3 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 3 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+bool test_no_loan_over_shmem() {
+    cout << "\n[TEST 4] Nothing To Lend Over Shared Memory\n";
+    cout << "============================================\n";
+
+    UDT::startup();
+
+    Pair p = {true};
+    bool connected = connect_pair(p);
+
+    UDT::sendmsg(p.client, "ring", 4);
+    const UDT_IOVEC* iov;
+    int iovcnt, handle;
+    bool refused = (UDT::ERROR == UDT::recvmsg_zc(p.server, iov, iovcnt, handle)) &&
+                   (UDT::getlasterror().getErrorCode() == CUDTException::ESHMEMILL);
+
+    // the message is still there for recvmsg
+    char buf[8];
+    bool kept = (4 == UDT::recvmsg(p.server, buf, sizeof(buf))) && (0 == memcmp(buf, "ring", 4));
+
+    close_pair(p);
+    UDT::cleanup();
+
+    cout << "recvmsg_zc refused: " << (refused ? "yes" : "no") << ", message kept: " << (kept ? "yes" : "no") << endl;
+
+    bool passed = connected && refused && kept;
+
+    if (passed) {
+        cout << GREEN << "✓ TEST 4 PASSED" << RESET << endl;
+    } else {
+        cout << RED << "✗ TEST 4 FAILED" << RESET << endl;
+    }
+
+    return passed;
+}
+
+int main() {
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Zero-Copy Receive Test Suite\n";
+    cout << "========================================\n";
+
+    int passed = 0;
+    int total = 4;
+
+    if (test_lent_messages()) passed++;
+    if (test_loan_holds_buffer()) passed++;
+    if (test_lent_frames()) passed++;
+    if (test_no_loan_over_shmem()) passed++;
+
+    cout << "\n";
+    cout << "========================================\n";
+    cout << "  Test Summary\n";
+    cout << "========================================\n";
+    cout << "Tests passed: " << passed << "/" << total << endl;
+
+    if (passed == total) {
+        cout << GREEN << "✓ ALL TESTS PASSED!" << RESET << endl;
+        return 0;
+    } else {
+        cout << RED << "✗ SOME TESTS FAILED" << RESET << endl;
+        return 1;
+    }
+}